@@ -2,14 +2,132 @@
 #include "Core/Error.h"
 #include "Core/API/RenderContext.h"
 #include "Utils/Timing/Profiler.h"
+#include <algorithm>
 
 namespace
 {
     const char kShaderFile[] = "Rendering/Lights/LightBVHRefit.cs.slang";
+
+    // When uploading dirty nodes, runs of dirty nodes separated by fewer clean nodes than this are uploaded together.
+    const uint32_t kMaxUploadGap = 64;
 }
 
 namespace Falcor
 {
+    namespace
+    {
+        // CPU versions of the refit kernels in LightBVHRefit.cs.slang.
+
+        float sinFromCos(float cosAngle)
+        {
+            return std::sqrt(std::max(0.0f, 1.0f - cosAngle * cosAngle));
+        }
+
+        void refitLeafNode(PackedNode& packedNode, const std::vector<ILightCollection::MeshLightTriangle>& triangles, const std::vector<uint32_t>& triangleIndices)
+        {
+            LeafNode node = packedNode.getLeafNode();
+
+            // Update the node bounding box.
+            float3 aabbMin = float3(FLT_MAX);
+            float3 aabbMax = float3(-FLT_MAX);
+            float3 normalsSum = float3(0.0f);
+
+            for (uint32_t i = 0; i < node.triangleCount; i++)
+            {
+                const auto& tri = triangles[triangleIndices[node.triangleOffset + i]];
+                for (uint32_t vertexIndex = 0; vertexIndex < 3; ++vertexIndex)
+                {
+                    aabbMin = min(aabbMin, tri.vtx[vertexIndex].pos);
+                    aabbMax = max(aabbMax, tri.vtx[vertexIndex].pos);
+                }
+                normalsSum += tri.normal;
+            }
+
+            node.attribs.setAABB(aabbMin, aabbMax);
+
+            // Update the normal bounding cone.
+            const float coneDirectionLength = length(normalsSum);
+            const float3 coneDirection = normalsSum / coneDirectionLength;
+            float cosConeAngle = kInvalidCosConeAngle;
+
+            if (coneDirectionLength >= FLT_MIN)
+            {
+                cosConeAngle = 1.0f;
+                for (uint32_t i = 0; i < node.triangleCount; i++)
+                {
+                    const float3 normal = triangles[triangleIndices[node.triangleOffset + i]].normal;
+                    cosConeAngle = std::min(cosConeAngle, dot(coneDirection, normal));
+                }
+                cosConeAngle = std::max(cosConeAngle, -1.f); // Guard against numerical errors
+            }
+
+            node.attribs.cosConeAngle = cosConeAngle;
+            node.attribs.coneDirection = coneDirection;
+            packedNode.setLeafNode(node);
+        }
+
+        void refitInternalNode(std::vector<PackedNode>& nodes, uint32_t nodeIndex)
+        {
+            InternalNode node = nodes[nodeIndex].getInternalNode();
+
+            // Update the node bounding box.
+            float3 aabbMin = float3(FLT_MAX);
+            float3 aabbMax = float3(-FLT_MAX);
+            float3 coneDirectionSum = float3(0.0f);
+            bool validCones = true;
+
+            for (uint32_t i = 0; i < node.childCount; i++)
+            {
+                SharedNodeAttributes childNode = nodes[node.firstChildIdx + i].getNodeAttributes();
+
+                float3 childAabbMin, childAabbMax;
+                childNode.getAABB(childAabbMin, childAabbMax);
+                aabbMin = min(aabbMin, childAabbMin);
+                aabbMax = max(aabbMax, childAabbMax);
+
+                coneDirectionSum += childNode.coneDirection;
+                validCones = validCones && childNode.cosConeAngle != kInvalidCosConeAngle;
+            }
+
+            node.attribs.setAABB(aabbMin, aabbMax);
+
+            // Update the normal bounding cone.
+            const float coneDirectionLength = length(coneDirectionSum);
+            const float3 coneDirection = coneDirectionSum / coneDirectionLength;
+            float cosConeAngle = kInvalidCosConeAngle;
+
+            if (coneDirectionLength >= FLT_MIN && validCones)
+            {
+                // This code rotates (cosDiffAngle, sinDiffAngle) counterclockwise by each child's cone spread angle.
+                cosConeAngle = 1.0f;
+                for (uint32_t i = 0; i < node.childCount; i++)
+                {
+                    const SharedNodeAttributes childNode = nodes[node.firstChildIdx + i].getNodeAttributes();
+
+                    const float cosDiffAngle = dot(coneDirection, childNode.coneDirection);
+                    const float sinDiffAngle = sinFromCos(cosDiffAngle);
+                    const float sinChildConeAngle = sinFromCos(childNode.cosConeAngle);
+                    const float sinTotalAngle = sinChildConeAngle * cosDiffAngle + sinDiffAngle * childNode.cosConeAngle;
+
+                    // If the sum of angles is greater than pi, deactivate the orientation cone as useless since it would represent the whole sphere.
+                    if (sinTotalAngle <= 0.0f)
+                    {
+                        cosConeAngle = kInvalidCosConeAngle;
+                        break;
+                    }
+
+                    const float cosTotalAngle = childNode.cosConeAngle * cosDiffAngle - sinChildConeAngle * sinDiffAngle;
+                    cosConeAngle = std::min(cosConeAngle, cosTotalAngle);
+                }
+                if (cosConeAngle != kInvalidCosConeAngle) cosConeAngle = std::max(cosConeAngle, -1.f); // Guard against numerical errors
+            }
+
+            node.attribs.cosConeAngle = cosConeAngle;
+            node.attribs.coneDirection = coneDirection;
+            nodes[nodeIndex].setInternalNode(node);
+        }
+    }
+
     LightBVH::LightBVH(ref<Device> pDevice, const ref<const ILightCollection>& pLightCollection)
         : mpDevice(pDevice)
         , mpLightCollection(pLightCollection)
@@ -18,48 +136,206 @@ namespace Falcor
         mInternalUpdater = ComputePass::create(mpDevice, kShaderFile, "updateInternalNodes");
     }
 
-    // TODO: Only update the ones that moved.
     void LightBVH::refit(RenderContext* pRenderContext)
     {
         FALCOR_PROFILE(pRenderContext, "LightBVH::refit()");
 
         FALCOR_ASSERT(mIsValid);
 
-        // Update all leaf nodes.
+        dispatchRefit(pRenderContext, mpNodeIndicesBuffer, mPerDepthRefitEntryInfo);
+
+        // All nodes have been refit, so there is nothing left to do for the dirty nodes.
+        for (uint32_t leafIndex : mDirtyLeaves) mIsNodeDirty[leafIndex] = false;
+        mDirtyLeaves.clear();
+
+        mIsCpuDataValid = false;
+        mIsTreeCostValid = false;
+    }
+
+    void LightBVH::markTrianglesDirty(uint32_t triangleOffset, uint32_t triangleCount)
+    {
+        if (!mIsValid) return;
+
+        FALCOR_ASSERT(triangleOffset + triangleCount <= mTriangleLeafIndices.size());
+        for (uint32_t triangleIdx = triangleOffset; triangleIdx < triangleOffset + triangleCount; ++triangleIdx)
+        {
+            // Culled triangles are not in the BVH.
+            const uint32_t leafIndex = mTriangleLeafIndices[triangleIdx];
+            if (leafIndex == kInvalidIndex || mIsNodeDirty[leafIndex]) continue;
+
+            mIsNodeDirty[leafIndex] = true;
+            mDirtyLeaves.push_back(leafIndex);
+        }
+    }
+
+    void LightBVH::refitDirty(RenderContext* pRenderContext, bool refitOnCPU)
+    {
+        FALCOR_PROFILE(pRenderContext, "LightBVH::refitDirty()");
+
+        FALCOR_ASSERT(mIsValid);
+        if (mDirtyLeaves.empty()) return;
+
+        // Mark the ancestors of the dirty leaves as dirty. The walk up stops at the first node that is already dirty,
+        // so each node is visited at most once.
+        std::vector<uint32_t> dirtyInternalNodes;
+        for (uint32_t leafIndex : mDirtyLeaves)
+        {
+            for (uint32_t nodeIndex = mNodeParents[leafIndex]; nodeIndex != kInvalidIndex && !mIsNodeDirty[nodeIndex]; nodeIndex = mNodeParents[nodeIndex])
+            {
+                mIsNodeDirty[nodeIndex] = true;
+                dirtyInternalNodes.push_back(nodeIndex);
+            }
+        }
+
+        // Sort the dirty nodes by depth, with the same layout as 'mNodeIndices':
+        // <-- Dirty internal nodes at level 0 --> | ... | <-- Dirty internal nodes at level (treeHeight - 1) --> | <-- Dirty leaf nodes -->
+        mDirtyRefitEntryInfo.assign(mPerDepthRefitEntryInfo.size(), RefitEntryInfo());
+        for (uint32_t nodeIndex : dirtyInternalNodes) mDirtyRefitEntryInfo[mNodeDepths[nodeIndex]].count++;
+        mDirtyRefitEntryInfo.back().count = (uint32_t)mDirtyLeaves.size();
+
+        std::vector<uint32_t> perDepthOffset(mDirtyRefitEntryInfo.size(), 0);
+        for (size_t i = 1; i < mDirtyRefitEntryInfo.size(); ++i)
+        {
+            perDepthOffset[i] = mDirtyRefitEntryInfo[i].offset = mDirtyRefitEntryInfo[i - 1].offset + mDirtyRefitEntryInfo[i - 1].count;
+        }
+
+        mDirtyNodeIndices.resize(dirtyInternalNodes.size() + mDirtyLeaves.size());
+        for (uint32_t nodeIndex : dirtyInternalNodes) mDirtyNodeIndices[perDepthOffset[mNodeDepths[nodeIndex]]++] = nodeIndex;
+        for (uint32_t nodeIndex : mDirtyLeaves) mDirtyNodeIndices[perDepthOffset.back()++] = nodeIndex;
+
+        if (refitOnCPU)
+        {
+            refitNodesOnCPU(pRenderContext);
+        }
+        else
+        {
+            // Allocate the buffer for all nodes, so that it is only created once per build.
+            if (!mpDirtyNodeIndicesBuffer || mpDirtyNodeIndicesBuffer->getElementCount() < mDirtyNodeIndices.size())
+            {
+                mpDirtyNodeIndicesBuffer = mpDevice->createStructuredBuffer(sizeof(uint32_t), (uint32_t)mNodeIndices.size(), ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, nullptr, false);
+                mpDirtyNodeIndicesBuffer->setName("LightBVH::mpDirtyNodeIndicesBuffer");
+            }
+            mpDirtyNodeIndicesBuffer->setBlob(mDirtyNodeIndices.data(), 0, mDirtyNodeIndices.size() * sizeof(uint32_t));
+
+            dispatchRefit(pRenderContext, mpDirtyNodeIndicesBuffer, mDirtyRefitEntryInfo);
+            mIsCpuDataValid = false;
+
+            // Defer updating the cost of the refit nodes until it is queried, as it needs the nodes to be read back.
+            // Once more nodes are pending than the tree holds, recomputing the whole cost is cheaper.
+            if (mIsTreeCostValid && mPendingCostNodeIndices.size() + mDirtyNodeIndices.size() <= mNodes.size())
+            {
+                mPendingCostNodeIndices.insert(mPendingCostNodeIndices.end(), mDirtyNodeIndices.begin(), mDirtyNodeIndices.end());
+            }
+            else
+            {
+                mPendingCostNodeIndices.clear();
+                mIsTreeCostValid = false;
+            }
+        }
+
+        // Clear the dirty state.
+        for (uint32_t nodeIndex : mDirtyNodeIndices) mIsNodeDirty[nodeIndex] = false;
+        mDirtyLeaves.clear();
+    }
+
+    float LightBVH::getRelativeTreeCost()
+    {
+        updateTreeCost();
+        if (!mIsTreeCostValid || mBuiltRelativeTreeCost <= 0.f || mNodeCosts[0] <= 0.f) return 1.f;
+        return (float)(mTreeCost / mNodeCosts[0]) / mBuiltRelativeTreeCost;
+    }
+
+    void LightBVH::dispatchRefit(RenderContext* pRenderContext, const ref<Buffer>& pNodeIndicesBuffer, const std::vector<RefitEntryInfo>& perDepthRefitEntryInfo)
+    {
+        // Update the leaf nodes.
         {
             auto var = mLeafUpdater->getRootVar()["CB"];
             mpLightCollection->bindShaderData(var["gLights"]);
             bindShaderData(var["gLightBVH"]);
-            var["gNodeIndices"] = mpNodeIndicesBuffer;
+            var["gNodeIndices"] = pNodeIndicesBuffer;
 
-            const uint32_t nodeCount = mPerDepthRefitEntryInfo.back().count;
+            const uint32_t nodeCount = perDepthRefitEntryInfo.back().count;
             FALCOR_ASSERT(nodeCount > 0);
-            var["gFirstNodeOffset"] = mPerDepthRefitEntryInfo.back().offset;
+            var["gFirstNodeOffset"] = perDepthRefitEntryInfo.back().offset;
             var["gNodeCount"] = nodeCount;
 
             mLeafUpdater->execute(pRenderContext, nodeCount, 1, 1);
         }
 
-        // Update all internal nodes.
+        // Update the internal nodes, one level at a time from the bottom up.
         {
             auto var = mInternalUpdater->getRootVar()["CB"];
             mpLightCollection->bindShaderData(var["gLights"]);
             bindShaderData(var["gLightBVH"]);
-            var["gNodeIndices"] = mpNodeIndicesBuffer;
+            var["gNodeIndices"] = pNodeIndicesBuffer;
 
             // Note that mBVHStats.treeHeight may be 0, in which case there is a single leaf and no internal nodes.
+            // When refitting the dirty nodes only, the deepest levels may not have any.
             for (int depth = (int)mBVHStats.treeHeight - 1; depth >= 0; --depth)
             {
-                const uint32_t nodeCount = mPerDepthRefitEntryInfo[depth].count;
-                FALCOR_ASSERT(nodeCount > 0);
-                var["gFirstNodeOffset"] = mPerDepthRefitEntryInfo[depth].offset;
+                const uint32_t nodeCount = perDepthRefitEntryInfo[depth].count;
+                if (nodeCount == 0) continue;
+                var["gFirstNodeOffset"] = perDepthRefitEntryInfo[depth].offset;
                 var["gNodeCount"] = nodeCount;
 
                 mInternalUpdater->execute(pRenderContext, nodeCount, 1, 1);
             }
         }
+    }
 
-        mIsCpuDataValid = false;
+    void LightBVH::refitNodesOnCPU(RenderContext* pRenderContext)
+    {
+        // The node data may have been modified on the GPU by an earlier refit.
+        syncDataToCPU();
+        updateTreeCost();
+
+        // Note this stalls unless the light collection has been asked to prepare its CPU data ahead of time.
+        const auto& triangles = mpLightCollection->getMeshLightTriangles(pRenderContext);
+
+        // Update the leaf nodes, then the internal nodes from the bottom up.
+        const RefitEntryInfo& leafInfo = mDirtyRefitEntryInfo.back();
+        for (uint32_t i = leafInfo.offset; i < leafInfo.offset + leafInfo.count; ++i)
+        {
+            refitLeafNode(mNodes[mDirtyNodeIndices[i]], triangles, mTriangleIndices);
+        }
+        for (int depth = (int)mBVHStats.treeHeight - 1; depth >= 0; --depth)
+        {
+            const RefitEntryInfo& info = mDirtyRefitEntryInfo[depth];
+            for (uint32_t i = info.offset; i < info.offset + info.count; ++i)
+            {
+                refitInternalNode(mNodes, mDirtyNodeIndices[i]);
+            }
+        }
+
+        // Update the tree cost incrementally.
+        if (mIsTreeCostValid)
+        {
+            for (uint32_t nodeIndex : mDirtyNodeIndices)
+            {
+                const float nodeCost = mNodeCostFunction(mNodes[nodeIndex]);
+                mTreeCost += (double)nodeCost - mNodeCosts[nodeIndex];
+                mNodeCosts[nodeIndex] = nodeCost;
+            }
+        }
+        uploadDirtyNodes();
+    }
+
+    void LightBVH::uploadDirtyNodes()
+    {
+        // Upload the dirty nodes in runs of nearby nodes, to avoid both uploading the whole tree and issuing a copy per node.
+        std::vector<uint32_t> sortedNodeIndices = mDirtyNodeIndices;
+        std::sort(sortedNodeIndices.begin(), sortedNodeIndices.end());
+
+        size_t runStart = 0;
+        for (size_t i = 1; i <= sortedNodeIndices.size(); ++i)
+        {
+            if (i < sortedNodeIndices.size() && sortedNodeIndices[i] - sortedNodeIndices[i - 1] <= kMaxUploadGap) continue;
+
+            const uint32_t firstNode = sortedNodeIndices[runStart];
+            const uint32_t nodeCount = sortedNodeIndices[i - 1] - firstNode + 1;
+            mpBVHNodesBuffer->setBlob(&mNodes[firstNode], firstNode * sizeof(PackedNode), nodeCount * sizeof(PackedNode));
+            runStart = i;
+        }
     }
 
     void LightBVH::renderUI(Gui::Widgets& widget)
@@ -108,6 +384,17 @@ namespace Falcor
         mNodes.clear();
         mNodeIndices.clear();
         mPerDepthRefitEntryInfo.clear();
+        mTriangleIndices.clear();
+        mTriangleLeafIndices.clear();
+        mNodeParents.clear();
+        mNodeDepths.clear();
+        mDirtyLeaves.clear();
+        mIsNodeDirty.clear();
+        mNodeCosts.clear();
+        mPendingCostNodeIndices.clear();
+        mTreeCost = 0.0;
+        mBuiltRelativeTreeCost = 0.f;
+        mIsTreeCostValid = false;
         mMaxTriangleCountPerLeaf = 0;
         mBVHStats = BVHStats();
         mIsValid = false;
@@ -132,8 +419,10 @@ namespace Falcor
 
                 // Push the children nodes onto the stack.
                 auto node = mNodes[location.nodeIndex].getInternalNode();
-                stack.push(NodeLocation{ location.nodeIndex + 1, location.depth + 1 });
-                stack.push(NodeLocation{ node.rightChildIdx, location.depth + 1 });
+                for (uint32_t i = 0; i < node.childCount; ++i)
+                {
+                    stack.push(NodeLocation{ node.firstChildIdx + i, location.depth + 1 });
+                }
             }
         }
     }
@@ -143,6 +432,86 @@ namespace Falcor
         // This function is called after BVH build has finished.
         computeStats();
         updateNodeIndices();
+        updateNodeParents();
+        updateTriangleLeafIndices();
+
+        resetTreeCost();
+        mBuiltRelativeTreeCost = mIsTreeCostValid && mNodeCosts[0] > 0.f ? (float)(mTreeCost / mNodeCosts[0]) : 0.f;
+    }
+
+    void LightBVH::updateNodeParents()
+    {
+        // The children of a node are always stored after it, so the depth of the parent is known when visiting its children.
+        mNodeParents.assign(mNodes.size(), kInvalidIndex);
+        mNodeDepths.assign(mNodes.size(), 0);
+        for (uint32_t nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex)
+        {
+            if (mNodes[nodeIndex].isLeaf()) continue;
+
+            const InternalNode node = mNodes[nodeIndex].getInternalNode();
+            for (uint32_t i = 0; i < node.childCount; ++i)
+            {
+                FALCOR_ASSERT(node.firstChildIdx + i > nodeIndex);
+                mNodeParents[node.firstChildIdx + i] = nodeIndex;
+                mNodeDepths[node.firstChildIdx + i] = mNodeDepths[nodeIndex] + 1;
+            }
+        }
+
+        mIsNodeDirty.assign(mNodes.size(), false);
+    }
+
+    void LightBVH::updateTriangleLeafIndices()
+    {
+        mTriangleLeafIndices.assign(mpLightCollection->getTotalLightCount(), kInvalidIndex);
+        for (uint32_t nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex)
+        {
+            if (!mNodes[nodeIndex].isLeaf()) continue;
+
+            const LeafNode node = mNodes[nodeIndex].getLeafNode();
+            for (uint32_t i = 0; i < node.triangleCount; ++i)
+            {
+                mTriangleLeafIndices[mTriangleIndices[node.triangleOffset + i]] = nodeIndex;
+            }
+        }
+    }
+
+    void LightBVH::updateTreeCost()
+    {
+        if (!mIsValid || !mNodeCostFunction || (mIsTreeCostValid && mPendingCostNodeIndices.empty())) return;
+
+        // The nodes have been refit on the GPU.
+        syncDataToCPU();
+        if (mIsTreeCostValid)
+        {
+            for (uint32_t nodeIndex : mPendingCostNodeIndices)
+            {
+                const float nodeCost = mNodeCostFunction(mNodes[nodeIndex]);
+                mTreeCost += (double)nodeCost - mNodeCosts[nodeIndex];
+                mNodeCosts[nodeIndex] = nodeCost;
+            }
+        }
+        else
+        {
+            resetTreeCost();
+        }
+        mPendingCostNodeIndices.clear();
+    }
+
+    void LightBVH::resetTreeCost()
+    {
+        mPendingCostNodeIndices.clear();
+        mNodeCosts.clear();
+        mTreeCost = 0.0;
+        mIsTreeCostValid = false;
+        if (!mNodeCostFunction) return;
+
+        mNodeCosts.resize(mNodes.size());
+        for (size_t nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex)
+        {
+            mNodeCosts[nodeIndex] = mNodeCostFunction(mNodes[nodeIndex]);
+            mTreeCost += mNodeCosts[nodeIndex];
+        }
+        mIsTreeCostValid = true;
     }
 
     void LightBVH::computeStats()
@@ -191,7 +560,7 @@ namespace Falcor
 
     void LightBVH::updateNodeIndices()
     {
-        // The nodes of the BVH are stored in depth-first order. To simplify the work of the refit kernels,
+        // The nodes of the BVH are not sorted by depth. To simplify the work of the refit kernels,
         // they are first run on all leaf nodes, and then on all internal nodes on a per level basis.
         // In order to do that, we need to compute how many internal nodes are stored at each level.
         FALCOR_ASSERT(isValid());
@@ -273,6 +642,9 @@ namespace Falcor
         FALCOR_ASSERT(mpTriangleBitmasksBuffer->getSize() >= triangleBitmasks.size() * sizeof(triangleBitmasks[0]));
         mpTriangleBitmasksBuffer->setBlob(triangleBitmasks.data(), 0, triangleBitmasks.size() * sizeof(triangleBitmasks[0]));
 
+        // Keep the triangle indices for refitting on the CPU.
+        mTriangleIndices = triangleIndices;
+
         mIsCpuDataValid = true;
     }
 
@@ -7,6 +7,7 @@
 #include "Utils/Math/Vector.h"
 #include "Utils/UI/Gui.h"
 #include <functional>
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -16,8 +17,10 @@ namespace Falcor
 
     /** Utility class representing a light sampling BVH.
 
-        This is binary BVH over all emissive triangles as described by Moreau and Clarberg,
+        This is binary or wide BVH over all emissive triangles as described by Moreau and Clarberg,
         "Importance Sampling of Many Lights on the GPU", Ray Tracing Gems, Ch. 18, 2019.
+        The children of each internal node are stored contiguously, so a node with up to
+        kMaxLightBVHChildCount children only needs to store its first child index and child count.
 
         Before being used, the BVH needs to have been built using LightBVHBuilder::build().
         The data can be both used on the CPU (using traverseBVH() or on the GPU by:
@@ -30,6 +33,8 @@ namespace Falcor
     class FALCOR_API LightBVH
     {
     public:
+        static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
         struct NodeLocation
         {
             uint32_t nodeIndex;
@@ -45,6 +50,10 @@ namespace Falcor
         */
         using NodeFunction = std::function<bool(const NodeLocation& location)>;
 
+        /** Function evaluating the cost of a node, used for tracking the tree quality across refits.
+        */
+        using NodeCostFunction = std::function<float(const PackedNode& node)>;
+
         /** Constructor.
             \param[in] pDevice GPU device.
             \param[in] pLightCollection The light collection around which the BVH will be built.
@@ -61,6 +70,32 @@ namespace Falcor
         */
         void refit(RenderContext* pRenderContext);
 
+        /** Mark the leaf nodes holding a range of emissive triangles as dirty.
+            The dirty leaves and their ancestors are updated on the next call to refitDirty().
+            \param[in] triangleOffset Index of the first emissive triangle in the light collection.
+            \param[in] triangleCount Number of emissive triangles.
+        */
+        void markTrianglesDirty(uint32_t triangleOffset, uint32_t triangleCount);
+
+        /** Returns true if some nodes have been marked as dirty since the last refit.
+        */
+        bool hasDirtyNodes() const { return !mDirtyLeaves.empty(); }
+
+        /** Refit the dirty leaf nodes and the internal nodes on their paths to the root, without changing the hierarchy.
+            Nodes that do not depend on moving lights are not touched, which makes refitting cheap when only a few lights move.
+            \param[in] pRenderContext The render context.
+            \param[in] refitOnCPU Refit the nodes on the CPU and upload them, rather than dispatching the refit kernels.
+                Refitting on the CPU reads back the emissive triangles, but keeps the CPU copy of the nodes and the tree cost up to date.
+        */
+        void refitDirty(RenderContext* pRenderContext, bool refitOnCPU);
+
+        /** Returns the current cost of the tree relative to its cost when it was built.
+            This is tracked incrementally over the nodes updated by refitDirty(), and can be used to decide when to rebuild.
+            Nodes refit on the GPU since the last call are read back first, which stalls on the GPU.
+            \return The relative cost, or 1 if the cost is not known.
+        */
+        float getRelativeTreeCost();
+
         /** Perform a depth-first traversal of the BVH and run a function on each node.
             \param[in] evalInternal Function called on each internal node.
             \param[in] evalLeaf Function called on each leaf node.
@@ -103,6 +138,10 @@ namespace Falcor
         void finalize();
         void computeStats();
         void updateNodeIndices();
+        void updateNodeParents();
+        void updateTriangleLeafIndices();
+        void resetTreeCost();
+        void updateTreeCost();
         void renderStats(Gui::Widgets& widget, const BVHStats& stats) const;
 
         void uploadCPUBuffers(const std::vector<uint32_t>& triangleIndices, const std::vector<uint64_t>& triangleBitmasks);
@@ -118,6 +157,10 @@ namespace Falcor
             uint32_t count = 0;     ///< The number of nodes at each level.
         };
 
+        void dispatchRefit(RenderContext* pRenderContext, const ref<Buffer>& pNodeIndicesBuffer, const std::vector<RefitEntryInfo>& perDepthRefitEntryInfo);
+        void refitNodesOnCPU(RenderContext* pRenderContext);
+        void uploadDirtyNodes();
+
         // Internal state
         ref<Device>                           mpDevice;
         ref<const ILightCollection>           mpLightCollection;
@@ -127,9 +170,27 @@ namespace Falcor
 
         // CPU resources
         mutable std::vector<PackedNode>       mNodes;                   ///< CPU-side copy of packed BVH nodes.
+        std::vector<uint32_t>                 mTriangleIndices;         ///< CPU-side copy of the triangle indices sorted by leaf node.
+        std::vector<uint32_t>                 mTriangleLeafIndices;     ///< Index of the leaf node holding each emissive triangle, or kInvalidIndex for triangles not in the BVH.
+        std::vector<uint32_t>                 mNodeParents;             ///< Index of the parent of each node, or kInvalidIndex for the root.
+        std::vector<uint32_t>                 mNodeDepths;              ///< Depth of each node in the tree.
         std::vector<uint32_t>                 mNodeIndices;             ///< Array of all node indices sorted by tree depth.
         std::vector<RefitEntryInfo>           mPerDepthRefitEntryInfo;  ///< Array containing for each level the number of internal nodes as well as the corresponding offset into 'mpNodeIndicesBuffer'; the very last entry contains the same data, but for all leaf nodes instead.
         uint32_t                              mMaxTriangleCountPerLeaf = 0; ///< After the BVH is built, this contains the maximum light count per leaf node.
+
+        // Incremental refit
+        std::vector<uint32_t>                 mDirtyLeaves;             ///< Leaf nodes marked as dirty since the last refit.
+        std::vector<bool>                     mIsNodeDirty;             ///< Per-node flag set for the dirty leaves and their ancestors.
+        std::vector<uint32_t>                 mDirtyNodeIndices;        ///< Indices of the dirty nodes, sorted by tree depth with the leaves last, in the same layout as 'mNodeIndices'.
+        std::vector<RefitEntryInfo>           mDirtyRefitEntryInfo;     ///< Per depth offset and count into 'mDirtyNodeIndices', same layout as 'mPerDepthRefitEntryInfo'.
+
+        // Tree quality tracking
+        NodeCostFunction                      mNodeCostFunction;        ///< Function evaluating the cost of a node. Set by the builder.
+        std::vector<float>                    mNodeCosts;               ///< Cost of each node.
+        double                                mTreeCost = 0.0;          ///< Sum of the node costs.
+        float                                 mBuiltRelativeTreeCost = 0.f; ///< Relative tree cost (sum of node costs divided by the root cost) when the tree was built.
+        bool                                  mIsTreeCostValid = false; ///< True if 'mNodeCosts' matches the current nodes, except for the nodes in 'mPendingCostNodeIndices'.
+        std::vector<uint32_t>                 mPendingCostNodeIndices;  ///< Nodes refit on the GPU whose cost has not been updated yet.
         BVHStats                              mBVHStats;
         bool                                  mIsValid = false;         ///< True when the BVH has been built.
         mutable bool                          mIsCpuDataValid = false;  ///< Indicates whether the CPU-side data matches the GPU buffers.
@@ -137,8 +198,9 @@ namespace Falcor
         // GPU resources
         ref<Buffer>                           mpBVHNodesBuffer;         ///< Buffer holding all BVH nodes.
         ref<Buffer>                           mpTriangleIndicesBuffer;  ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
-        ref<Buffer>                           mpTriangleBitmasksBuffer; ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child.
+        ref<Buffer>                           mpTriangleBitmasksBuffer; ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle. Each level stores the index of the child to traverse, see LightBVHBuilder::getBitmaskBitsPerLevel().
         ref<Buffer>                           mpNodeIndicesBuffer;      ///< Buffer holding all node indices sorted by tree depth. This is used for BVH refit.
+        ref<Buffer>                           mpDirtyNodeIndicesBuffer; ///< Buffer holding the dirty node indices sorted by tree depth. This is used for incremental BVH refit.
 
         friend LightBVHBuilder;
     };
@@ -1,9 +1,14 @@
 #include "LightBVHBuilder.h"
 #include "Core/Error.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
 #include "Utils/Timing/Profiler.h"
+#include "Utils/Math/Common.h"
 #include "Utils/Math/MathConstants.slangh"
 #include <algorithm>
+#include <execution>
+#include <exception>
+#include <numeric>
 
 namespace
 {
@@ -17,6 +22,49 @@ namespace
     const uint32_t kMaxLeafTriangleCount = 1 << PackedNode::kTriangleCountBits;
     const uint32_t kMaxLeafTriangleOffset = 1 << PackedNode::kTriangleOffsetBits;
 
+    // Define the maximum supported node count, limited by the number of bits for the first child index of internal nodes.
+    const uint32_t kMaxNodeCount = 1 << PackedNode::kChildIndexBits;
+
+    const Gui::DropdownList kBranchingFactorList =
+    {
+        { 2, "2" },
+        { 4, "4" },
+        { 8, "8" },
+    };
+
+    // Parallel build settings.
+    // Subtrees over at least kParallelSubtreeMinTriangleCount triangles are built in parallel, up to a depth of kMaxParallelSubtreeDepth.
+    // Nodes with at least kParallelNodeMinTriangleCount triangles are reduced, binned and partitioned in chunks of kParallelChunkSize triangles.
+    // The chunking only depends on the node size and not on the thread count, which keeps the build deterministic.
+    const uint32_t kParallelSubtreeMinTriangleCount = 1 << 14;
+    const uint32_t kMaxParallelSubtreeDepth = 10;
+    const uint32_t kParallelNodeMinTriangleCount = 1 << 16;
+    const uint32_t kParallelChunkSize = 1 << 14;
+
+    // Number of triangles for which bin ids are computed at once when binning.
+    const uint32_t kBinBlockSize = 256;
+
+    uint32_t getChunkCount(uint32_t begin, uint32_t end)
+    {
+        return div_round_up(end - begin, kParallelChunkSize);
+    }
+
+    /** Calls func(chunkIndex, chunkBegin, chunkEnd) for each chunk of kParallelChunkSize elements in [begin, end).
+        \param[in] parallel Process the chunks on multiple threads.
+    */
+    template<typename Func>
+    void forEachChunk(bool parallel, uint32_t begin, uint32_t end, const Func& func)
+    {
+        auto processChunk = [&](uint32_t chunkIndex)
+        {
+            const uint32_t chunkBegin = begin + chunkIndex * kParallelChunkSize;
+            func(chunkIndex, chunkBegin, std::min(chunkBegin + kParallelChunkSize, end));
+        };
+        auto range = NumericRange<uint32_t>(0, getChunkCount(begin, end));
+        if (parallel) std::for_each(std::execution::par, range.begin(), range.end(), processChunk);
+        else std::for_each(range.begin(), range.end(), processChunk);
+    }
+
     inline float safeACos(float v)
     {
         return std::acos(std::clamp(v, -1.0f, 1.0f));
@@ -194,6 +242,49 @@ namespace Falcor
 {
     static_assert(sizeof(PackedNode) % 16 == 0, "PackedNode size should be a multiple of 16");
 
+    void LightBVHBuilder::TriangleSortData::resize(size_t count)
+    {
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            boundsMin[k].resize(count);
+            boundsMax[k].resize(count);
+            center[k].resize(count);
+            coneDirection[k].resize(count);
+        }
+        cosConeAngle.resize(count);
+        flux.resize(count);
+        triangleIndex.resize(count);
+    }
+
+    void LightBVHBuilder::Bins::reset(uint32_t binCount)
+    {
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            boundsMin[k].assign(binCount, std::numeric_limits<float>::infinity());
+            boundsMax[k].assign(binCount, -std::numeric_limits<float>::infinity());
+            coneDirection[k].assign(binCount, 0.f);
+        }
+        cosConeAngle.assign(binCount, 1.f);
+        flux.assign(binCount, 0.f);
+        triangleCount.assign(binCount, 0);
+    }
+
+    void LightBVHBuilder::Bins::include(const Bins& other)
+    {
+        FALCOR_ASSERT(triangleCount.size() == other.triangleCount.size());
+        for (size_t b = 0; b < triangleCount.size(); ++b)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                boundsMin[k][b] = std::min(boundsMin[k][b], other.boundsMin[k][b]);
+                boundsMax[k][b] = std::max(boundsMax[k][b], other.boundsMax[k][b]);
+                coneDirection[k][b] += other.coneDirection[k][b];
+            }
+            flux[b] += other.flux[b];
+            triangleCount[b] += other.triangleCount[b];
+        }
+    }
+
     LightBVHBuilder::LightBVHBuilder(const Options& options) : mOptions(options)
     {
     }
@@ -208,77 +299,132 @@ namespace Falcor
         // Get global list of emissive triangles.
         FALCOR_ASSERT(bvh.mpLightCollection);
         const auto& triangles = bvh.mpLightCollection->getMeshLightTriangles(pRenderContext);
-        if (triangles.empty()) return;
 
-        // Create list of triangles that should be included in BVH.
-        // For each triangle, precompute data we need for the build.
-        BuildingData data(bvh.mNodes);
-        data.trianglesData.reserve(triangles.size());
+        // Build the tree. If there are no non-culled triangles, we're done.
+        std::vector<uint32_t> triangleIndices;
+        std::vector<uint64_t> triangleBitmasks;
+        if (!buildNodes(triangles, bvh.mNodes, triangleIndices, triangleBitmasks)) return;
+
+        // The BVH is ready, mark it as valid and upload the data.
+        bvh.mIsValid = true;
+        bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
+        bvh.uploadCPUBuffers(triangleIndices, triangleBitmasks);
 
+        // Computate metadata.
+        const Options options = mOptions;
+        bvh.mNodeCostFunction = [options](const PackedNode& node) { return evalNodeCost(node, options); };
+        bvh.finalize();
+    }
+
+    bool LightBVHBuilder::buildNodes(const std::vector<ILightCollection::MeshLightTriangle>& triangles, std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks)
+    {
+        nodes.clear();
+        triangleIndices.clear();
+        triangleBitmasks.clear();
+        if (triangles.empty()) return false;
+
+        // Create list of triangles that should be included in BVH.
+        std::vector<uint32_t> includedTriangles;
+        includedTriangles.reserve(triangles.size());
         for (size_t i = 0; i < triangles.size(); i++)
         {
-            if (!mOptions.usePreintegration || triangles[i].flux > 0.f)
-            {
-                LightBVHBuilder::TriangleSortData tri;
-                for (uint32_t j = 0; j < 3; j++)
-                {
-                    tri.bounds |= triangles[i].vtx[j].pos;
-                }
-                tri.center = triangles[i].getCenter();
-                tri.coneDirection = triangles[i].normal;
-                tri.cosConeAngle = 1.f; // Single flat emitter => normal bounding cone angle is zero.
-                tri.flux = triangles[i].flux;
-                tri.triangleIndex = static_cast<uint32_t>(i);
-
-                data.trianglesData.push_back(tri);
-            }
+            if (!mOptions.usePreintegration || triangles[i].flux > 0.f) includedTriangles.push_back(static_cast<uint32_t>(i));
         }
 
         // If there are no non-culled triangles, we're done.
-        if (data.trianglesData.empty()) return;
+        if (includedTriangles.empty()) return false;
 
         // Validate options.
         if (mOptions.maxTriangleCountPerLeaf > kMaxLeafTriangleCount)
         {
             FALCOR_THROW("Max triangle count per leaf exceeds the maximum supported ({})", kMaxLeafTriangleCount);
         }
-        if (data.trianglesData.size() > kMaxLeafTriangleOffset + kMaxLeafTriangleCount)
+        if (includedTriangles.size() > kMaxLeafTriangleOffset + kMaxLeafTriangleCount)
         {
             FALCOR_THROW("Emissive triangle count exceeds the maximum supported ({})", kMaxLeafTriangleOffset + kMaxLeafTriangleCount);
         }
+        if (mOptions.branchingFactor != 2 && mOptions.branchingFactor != 4 && mOptions.branchingFactor != 8)
+        {
+            FALCOR_THROW("Unsupported branching factor ({}). Supported values are 2, 4 and 8.", mOptions.branchingFactor);
+        }
+
+        // For each triangle, precompute data we need for the build.
+        BuildingData data(nodes);
+        const uint32_t triangleCount = static_cast<uint32_t>(includedTriangles.size());
+        TriangleSortData& td = data.trianglesData;
+        td.resize(triangleCount);
+        forEachChunk(mOptions.useParallelBuild, 0, triangleCount, [&](uint32_t, uint32_t chunkBegin, uint32_t chunkEnd)
+        {
+            for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                const auto& triangle = triangles[includedTriangles[i]];
+                AABB bounds;
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    bounds |= triangle.vtx[j].pos;
+                }
+                const float3 center = bounds.center();
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    td.boundsMin[k][i] = bounds.minPoint[k];
+                    td.boundsMax[k][i] = bounds.maxPoint[k];
+                    td.center[k][i] = center[k];
+                    td.coneDirection[k][i] = triangle.normal[k];
+                }
+                td.cosConeAngle[i] = 1.f; // Single flat emitter => normal bounding cone angle is zero.
+                td.flux[i] = triangle.flux;
+                td.triangleIndex[i] = includedTriangles[i];
+            }
+        });
 
         // Allocate temporary memory for the BVH build.
         // To be grossly conservative, assume each triangle requires two nodes.
         // This is only system RAM and shouldn't be that much, so it's not worth being more careful about it.
         // TODO: Better estimate of how many nodes we will need.
-        data.nodes.clear();
-        data.nodes.reserve(2 * data.trianglesData.size());
-        data.triangleIndices.reserve(data.trianglesData.size());
+        nodes.reserve(2 * triangleCount);
+        data.triangleIndices.resize(triangleCount);
+        data.floatScratch.resize(triangleCount);
+        data.indexScratch.resize(triangleCount);
+        data.destinationScratch.resize(triangleCount);
 
-        const uint64_t invalidBitmask = std::numeric_limits<uint64_t>::max();
-        data.triangleBitmasks.resize(triangles.size(), invalidBitmask); // This is sized based on input triangle count, as it's indexed by global triangle index.
-
-        // Build the tree.
+        // Build the binary tree.
         SplitHeuristicFunction splitFunc = getSplitFunction(mOptions.splitHeuristicSelection);
-        buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data);
-        FALCOR_ASSERT(!data.nodes.empty());
-
-        size_t numValid = 0;
-        for (auto mask : data.triangleBitmasks)
-            if (mask != invalidBitmask) numValid++;
-        FALCOR_ASSERT(numValid == data.trianglesData.size());
+        SplitScratch scratch;
+        nodes.push_back({});
+        buildInternal(mOptions, splitFunc, 0, Range(0, triangleCount), data, scratch, 0, nodes);
+        FALCOR_ASSERT(!nodes.empty());
 
         // Compute per-node light bounding cones.
         float cosConeAngle;
         computeLightingConesInternal(0, data, cosConeAngle);
 
-        // The BVH is ready, mark it as valid and upload the data.
-        bvh.mIsValid = true;
-        bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
-        bvh.uploadCPUBuffers(data.triangleIndices, data.triangleBitmasks);
+        // Collapse the binary tree into a wide tree.
+        if (mOptions.branchingFactor > 2)
+        {
+            std::vector<PackedNode> binaryNodes = std::move(nodes);
+            collapseNodes(binaryNodes, mOptions.branchingFactor, nodes);
+        }
 
-        // Computate metadata.
-        bvh.finalize();
+        // Compute the traversal path to each triangle.
+        const uint64_t invalidBitmask = std::numeric_limits<uint64_t>::max();
+        triangleBitmasks.resize(triangles.size(), invalidBitmask); // This is sized based on input triangle count, as it's indexed by global triangle index.
+        computeTriangleBitmasks(nodes, mOptions.branchingFactor, data.triangleIndices, triangleBitmasks);
+
+        size_t numValid = 0;
+        for (auto mask : triangleBitmasks)
+            if (mask != invalidBitmask) numValid++;
+        FALCOR_ASSERT(numValid == triangleCount);
+
+        triangleIndices = std::move(data.triangleIndices);
+        return true;
+    }
+
+    uint32_t LightBVHBuilder::getBitmaskBitsPerLevel(uint32_t branchingFactor)
+    {
+        FALCOR_ASSERT(branchingFactor >= 2 && branchingFactor <= kMaxLightBVHChildCount && isPowerOf2(branchingFactor));
+        uint32_t bitsPerLevel = 0;
+        while ((1u << bitsPerLevel) < branchingFactor) bitsPerLevel++;
+        return bitsPerLevel;
     }
 
     bool LightBVHBuilder::renderUI(Gui::Widgets& widget)
@@ -292,8 +438,21 @@ namespace Falcor
         bool optionsChanged = false;
 
         optionsChanged |= widget.checkbox("Allow refitting", options.allowRefitting);
+        if (options.allowRefitting)
+        {
+            optionsChanged |= widget.checkbox("Refit on CPU", options.refitOnCPU);
+            widget.tooltip("Refit the nodes affected by moving lights on the CPU and upload them, rather than refitting them on the GPU. This allows tracking the tree quality.");
+            if (options.refitOnCPU)
+            {
+                optionsChanged |= widget.var("Rebuild cost threshold", options.rebuildCostThreshold, 0.f, 10.f, 0.05f);
+                widget.tooltip("Rebuild the BVH when refitting has increased its relative SAOH cost by more than this fraction since the last build. Only used when refitting on the CPU. Set to zero to disable.");
+            }
+        }
         optionsChanged |= widget.var("Max triangle count per leaf", options.maxTriangleCountPerLeaf, 1u, kMaxLeafTriangleCount);
         optionsChanged |= widget.dropdown("Split heuristic", options.splitHeuristicSelection);
+        optionsChanged |= widget.checkbox("Use parallel build", options.useParallelBuild);
+        optionsChanged |= widget.dropdown("Branching factor", kBranchingFactorList, options.branchingFactor);
+        widget.tooltip("Maximum number of children per internal node. Wide trees are created by collapsing the binary tree.");
 
         if (auto splitGroup = widget.group("Split Options", true))
         {
@@ -322,24 +481,18 @@ namespace Falcor
         return optionsChanged;
     }
 
-    uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data)
+    void LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint32_t depth, const Range& triangleRange, BuildingData& data, SplitScratch& scratch, uint32_t nodeIndex, std::vector<PackedNode>& nodes)
     {
         FALCOR_ASSERT(triangleRange.begin < triangleRange.end);
 
         // Compute the AABB and total flux of the node.
         float nodeFlux = 0.f;
         AABB nodeBounds;
-        for (uint32_t dataIndex = triangleRange.begin; dataIndex < triangleRange.end; ++dataIndex)
-        {
-            nodeBounds |= data.trianglesData[dataIndex].bounds;
-            nodeFlux += data.trianglesData[dataIndex].flux;
-        }
+        computeBoundsAndFlux(triangleRange, data, options.useParallelBuild, nodeBounds, nodeFlux);
         FALCOR_ASSERT(nodeBounds.valid());
 
-        data.currentNodeFlux = nodeFlux;
-
         bool trySplitting = triangleRange.length() > (options.createLeavesASAP ? options.maxTriangleCountPerLeaf : 1);
-        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options) : SplitResult();
+        const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options, scratch) : SplitResult();
 
         // If we should split, then create an internal node and split.
         if (splitResult.isValid())
@@ -347,18 +500,7 @@ namespace Falcor
             FALCOR_ASSERT(triangleRange.begin < splitResult.triangleIndex && splitResult.triangleIndex < triangleRange.end);
 
             // Sort the centroids and update the lists accordingly.
-            auto comp = [dim = splitResult.axis](const TriangleSortData& d1, const TriangleSortData& d2) { return d1.bounds.center()[dim] < d2.bounds.center()[dim]; };
-            std::nth_element(std::begin(data.trianglesData) + triangleRange.begin, std::begin(data.trianglesData) + splitResult.triangleIndex, std::begin(data.trianglesData) + triangleRange.end, comp);
-
-            // Allocate internal node.
-            FALCOR_ASSERT(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
-
-            InternalNode node = {};
-            node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
-            node.attribs.flux = nodeFlux;
-            // The lighting normal bounding cone will be computed later when all leaf nodes have been created.
+            partitionTriangles(splitResult, triangleRange, data, options.useParallelBuild);
 
             if (depth >= kMaxBVHDepth)
             {
@@ -367,24 +509,72 @@ namespace Falcor
                 FALCOR_THROW("BVH depth of {} reached. Maximum of {} allowed.", depth + 1, kMaxBVHDepth);
             }
 
-            uint32_t leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data);
-            uint32_t rightIndex = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data);
+            // Allocate the two child nodes next to each other.
+            if (nodes.size() + 2 >= kMaxNodeCount) FALCOR_THROW("BVH node count exceeds the maximum supported ({})", kMaxNodeCount);
+            const uint32_t leftIndex = (uint32_t)nodes.size();
+            const uint32_t rightIndex = leftIndex + 1;
+            nodes.resize(nodes.size() + 2);
+
+            InternalNode node = {};
+            node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
+            node.attribs.flux = nodeFlux;
+            node.firstChildIdx = leftIndex;
+            node.childCount = 2;
+            // The lighting normal bounding cone will be computed later when all leaf nodes have been created.
 
-            FALCOR_ASSERT(leftIndex == nodeIndex + 1); // The left node should always be placed immediately after the current node.
-            node.rightChildIdx = rightIndex;
+            const Range leftRange(triangleRange.begin, splitResult.triangleIndex);
+            const Range rightRange(splitResult.triangleIndex, triangleRange.end);
 
-            data.nodes[nodeIndex].setInternalNode(node);
-            return nodeIndex;
+            if (options.useParallelBuild && depth < kMaxParallelSubtreeDepth && triangleRange.length() >= kParallelSubtreeMinTriangleCount)
+            {
+                // Build the two subtrees in parallel, the right one into its own node list.
+                // The two subtrees touch disjoint triangle ranges, and leaf nodes store their triangles at the offset of their range,
+                // so the subtrees don't share any state. Exceptions can't leave a parallel algorithm, so they are rethrown afterwards.
+                std::vector<PackedNode> rightNodes(1);
+                rightNodes.reserve(2 * rightRange.length());
+                SplitScratch rightScratch;
+                std::exception_ptr exceptions[2];
+                auto subtreeRange = NumericRange<uint32_t>(0, 2);
+                std::for_each(std::execution::par, subtreeRange.begin(), subtreeRange.end(), [&](uint32_t subtree)
+                {
+                    try
+                    {
+                        if (subtree == 0) buildInternal(options, splitHeuristic, depth + 1, leftRange, data, scratch, leftIndex, nodes);
+                        else buildInternal(options, splitHeuristic, depth + 1, rightRange, data, rightScratch, 0, rightNodes);
+                    }
+                    catch (...)
+                    {
+                        exceptions[subtree] = std::current_exception();
+                    }
+                });
+                for (const auto& exception : exceptions)
+                {
+                    if (exception) std::rethrow_exception(exception);
+                }
+
+                // Move the right subtree root into its slot and append the rest of the subtree after the left one, relocating the child indices.
+                // Internal nodes store the first child index in the low bits of the first dword, so it is patched in place to avoid repacking the node attributes.
+                if (nodes.size() + rightNodes.size() >= kMaxNodeCount) FALCOR_THROW("BVH node count exceeds the maximum supported ({})", kMaxNodeCount);
+                const uint32_t offset = (uint32_t)nodes.size() - 1;
+                for (PackedNode& rightNode : rightNodes)
+                {
+                    if (!rightNode.isLeaf()) rightNode.data[0].x += offset;
+                }
+                nodes[rightIndex] = rightNodes[0];
+                nodes.insert(nodes.end(), rightNodes.begin() + 1, rightNodes.end());
+            }
+            else
+            {
+                buildInternal(options, splitHeuristic, depth + 1, leftRange, data, scratch, leftIndex, nodes);
+                buildInternal(options, splitHeuristic, depth + 1, rightRange, data, scratch, rightIndex, nodes);
+            }
+
+            nodes[nodeIndex].setInternalNode(node);
         }
         else // No split => create leaf node
         {
             FALCOR_ASSERT(triangleRange.length() <= options.maxTriangleCountPerLeaf);
 
-            // Allocate leaf node.
-            FALCOR_ASSERT(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-            const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-            data.nodes.push_back({});
-
             LeafNode node = {};
             node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
             node.attribs.flux = nodeFlux;
@@ -392,32 +582,255 @@ namespace Falcor
             node.attribs.coneDirection = computeLightingCone(triangleRange, data, cosTheta);
             node.attribs.cosConeAngle = cosTheta;
 
+            // The leaves are created in depth-first order, so the triangle indices of a leaf are stored at the same offset as its triangle range.
             node.triangleCount = triangleRange.length();
-            node.triangleOffset = (uint32_t)data.triangleIndices.size();
+            node.triangleOffset = triangleRange.begin;
             FALCOR_ASSERT(node.triangleCount < kMaxLeafTriangleCount);
             FALCOR_ASSERT(node.triangleOffset < kMaxLeafTriangleOffset);
 
-            for (uint32_t triangleIdx = triangleRange.begin, index = 0; triangleIdx < triangleRange.end; ++triangleIdx, ++index)
+            for (uint32_t triangleIdx = triangleRange.begin; triangleIdx < triangleRange.end; ++triangleIdx)
             {
-                uint32_t globalTriangleIndex = data.trianglesData[triangleIdx].triangleIndex;
-                data.triangleIndices.push_back(globalTriangleIndex);
-                data.triangleBitmasks[globalTriangleIndex] = bitmask;
+                data.triangleIndices[triangleIdx] = data.trianglesData.triangleIndex[triangleIdx];
             }
-            FALCOR_ASSERT(data.triangleIndices.size() == node.triangleOffset + node.triangleCount);
 
-            data.nodes[nodeIndex].setLeafNode(node);
-            return nodeIndex;
+            nodes[nodeIndex].setLeafNode(node);
         }
     }
 
+    void LightBVHBuilder::collapseNodes(const std::vector<PackedNode>& binaryNodes, uint32_t branchingFactor, std::vector<PackedNode>& nodes)
+    {
+        FALCOR_ASSERT(!binaryNodes.empty());
+        FALCOR_ASSERT(branchingFactor > 2 && branchingFactor <= kMaxLightBVHChildCount);
+
+        nodes.clear();
+        nodes.reserve(binaryNodes.size());
+        nodes.push_back(binaryNodes[0]);
+
+        struct Child
+        {
+            uint32_t binaryIndex;
+            uint32_t depth;
+        };
+
+        // Collapse the nodes in depth-first order, so that the nodes of a subtree are stored close to each other.
+        std::function<void(uint32_t, uint32_t)> collapse = [&](uint32_t binaryIndex, uint32_t nodeIndex)
+        {
+            // Gather the children, replacing the shallowest internal child by its two children until the node is full.
+            // Expanding the shallowest child first keeps the wide tree balanced, so that each level consumes at least as many binary levels as bits in the triangle bitmasks.
+            // The children are kept in left-to-right order.
+            const InternalNode binaryNode = binaryNodes[binaryIndex].getInternalNode();
+            FALCOR_ASSERT(binaryNode.childCount == 2);
+            Child children[kMaxLightBVHChildCount];
+            uint32_t childCount = 2;
+            children[0] = { binaryNode.firstChildIdx, 1 };
+            children[1] = { binaryNode.firstChildIdx + 1, 1 };
+            while (childCount < branchingFactor)
+            {
+                uint32_t expandIndex = childCount;
+                for (uint32_t i = 0; i < childCount; ++i)
+                {
+                    if (binaryNodes[children[i].binaryIndex].isLeaf()) continue;
+                    if (expandIndex == childCount || children[i].depth < children[expandIndex].depth) expandIndex = i;
+                }
+                if (expandIndex == childCount) break;
+
+                const Child expanded = children[expandIndex];
+                const uint32_t firstChildIdx = binaryNodes[expanded.binaryIndex].getInternalNode().firstChildIdx;
+                for (uint32_t i = childCount; i > expandIndex + 1; --i) children[i] = children[i - 1];
+                children[expandIndex] = { firstChildIdx, expanded.depth + 1 };
+                children[expandIndex + 1] = { firstChildIdx + 1, expanded.depth + 1 };
+                childCount++;
+            }
+
+            // Allocate the children next to each other and copy their attributes.
+            if (nodes.size() + childCount >= kMaxNodeCount) FALCOR_THROW("BVH node count exceeds the maximum supported ({})", kMaxNodeCount);
+            const uint32_t firstChildIdx = (uint32_t)nodes.size();
+            for (uint32_t i = 0; i < childCount; ++i) nodes.push_back(binaryNodes[children[i].binaryIndex]);
+
+            // Update the child references, keeping the node attributes as is.
+            PackedNode& node = nodes[nodeIndex];
+            node.data[0].x = ((childCount - 1) << PackedNode::kChildIndexBits) | firstChildIdx;
+
+            for (uint32_t i = 0; i < childCount; ++i)
+            {
+                if (!binaryNodes[children[i].binaryIndex].isLeaf()) collapse(children[i].binaryIndex, firstChildIdx + i);
+            }
+        };
+
+        if (!binaryNodes[0].isLeaf()) collapse(0, 0);
+    }
+
+    void LightBVHBuilder::computeTriangleBitmasks(const std::vector<PackedNode>& nodes, uint32_t branchingFactor, const std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks)
+    {
+        const uint32_t bitsPerLevel = getBitmaskBitsPerLevel(branchingFactor);
+
+        // Traverse the tree, tracking the child index taken at each level.
+        std::function<void(uint32_t, uint64_t, uint32_t)> traverse = [&](uint32_t nodeIndex, uint64_t bitmask, uint32_t bitCount)
+        {
+            if (nodes[nodeIndex].isLeaf())
+            {
+                const LeafNode node = nodes[nodeIndex].getLeafNode();
+                for (uint32_t i = 0; i < node.triangleCount; ++i)
+                {
+                    triangleBitmasks[triangleIndices[node.triangleOffset + i]] = bitmask;
+                }
+                return;
+            }
+
+            if (bitCount + bitsPerLevel > kMaxBVHDepth)
+            {
+                // The traversal path to each leaf node is stored in a 64-bit mask, which is necessary for pdf computation with MIS.
+                FALCOR_THROW("BVH traversal path of {} bits reached. Maximum of {} allowed.", bitCount + bitsPerLevel, kMaxBVHDepth);
+            }
+
+            const InternalNode node = nodes[nodeIndex].getInternalNode();
+            FALCOR_ASSERT(node.childCount <= branchingFactor);
+            for (uint32_t i = 0; i < node.childCount; ++i)
+            {
+                traverse(node.firstChildIdx + i, bitmask | ((uint64_t)i << bitCount), bitCount + bitsPerLevel);
+            }
+        };
+        traverse(0, 0ull, 0);
+    }
+
+    void LightBVHBuilder::computeBoundsAndFlux(const Range& triangleRange, const BuildingData& data, bool parallel, AABB& bounds, float& flux)
+    {
+        const TriangleSortData& td = data.trianglesData;
+
+        // Helper to reduce a range of triangles, one array at a time.
+        auto reduce = [&td](uint32_t begin, uint32_t end, AABB& rangeBounds, float& rangeFlux)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const float* boundsMin = td.boundsMin[k].data();
+                const float* boundsMax = td.boundsMax[k].data();
+                float minValue = std::numeric_limits<float>::infinity();
+                float maxValue = -std::numeric_limits<float>::infinity();
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    minValue = std::min(minValue, boundsMin[i]);
+                    maxValue = std::max(maxValue, boundsMax[i]);
+                }
+                rangeBounds.minPoint[k] = minValue;
+                rangeBounds.maxPoint[k] = maxValue;
+            }
+            rangeFlux = 0.f;
+            for (uint32_t i = begin; i < end; ++i) rangeFlux += td.flux[i];
+        };
+
+        if (triangleRange.length() < kParallelNodeMinTriangleCount)
+        {
+            reduce(triangleRange.begin, triangleRange.end, bounds, flux);
+            return;
+        }
+
+        // Reduce each chunk separately and merge the partial results in chunk order.
+        const uint32_t chunkCount = getChunkCount(triangleRange.begin, triangleRange.end);
+        std::vector<AABB> chunkBounds(chunkCount);
+        std::vector<float> chunkFlux(chunkCount, 0.f);
+        forEachChunk(parallel, triangleRange.begin, triangleRange.end, [&](uint32_t chunkIndex, uint32_t chunkBegin, uint32_t chunkEnd)
+        {
+            reduce(chunkBegin, chunkEnd, chunkBounds[chunkIndex], chunkFlux[chunkIndex]);
+        });
+        bounds = AABB();
+        flux = 0.f;
+        for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+        {
+            bounds |= chunkBounds[chunkIndex];
+            flux += chunkFlux[chunkIndex];
+        }
+    }
+
+    void LightBVHBuilder::partitionTriangles(const SplitResult& splitResult, const Range& triangleRange, BuildingData& data, bool parallel)
+    {
+        TriangleSortData& td = data.trianglesData;
+        const uint32_t begin = triangleRange.begin, end = triangleRange.end;
+        const uint32_t leftCount = splitResult.triangleIndex - begin;
+        parallel = parallel && triangleRange.length() >= kParallelNodeMinTriangleCount;
+
+        // Find the centroid value at the split index.
+        // Triangles below it go to the left, and triangles equal to it are assigned to the left side in order until it holds the requested number of triangles.
+        const std::vector<float>& keys = td.center[splitResult.axis];
+        std::copy(keys.begin() + begin, keys.begin() + end, data.floatScratch.begin() + begin);
+        auto first = data.floatScratch.begin() + begin, nth = data.floatScratch.begin() + splitResult.triangleIndex, last = data.floatScratch.begin() + end;
+        if (parallel) std::nth_element(std::execution::par, first, nth, last);
+        else std::nth_element(first, nth, last);
+        const float pivot = *nth;
+
+        // Count the triangles below and at the pivot in each chunk.
+        const uint32_t chunkCount = getChunkCount(begin, end);
+        std::vector<uint32_t> lessCount(chunkCount, 0), equalCount(chunkCount, 0);
+        forEachChunk(parallel, begin, end, [&](uint32_t chunkIndex, uint32_t chunkBegin, uint32_t chunkEnd)
+        {
+            for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                lessCount[chunkIndex] += keys[i] < pivot ? 1 : 0;
+                equalCount[chunkIndex] += keys[i] == pivot ? 1 : 0;
+            }
+        });
+
+        // Compute the per-chunk output offsets on either side.
+        const uint32_t totalLessCount = std::accumulate(lessCount.begin(), lessCount.end(), 0u);
+        FALCOR_ASSERT(totalLessCount <= leftCount);
+        const uint32_t equalLeftCount = leftCount - totalLessCount;
+        std::vector<uint32_t> leftOffset(chunkCount), rightOffset(chunkCount), equalOffset(chunkCount);
+        for (uint32_t chunkIndex = 0, left = begin, right = splitResult.triangleIndex, equal = 0; chunkIndex < chunkCount; ++chunkIndex)
+        {
+            const uint32_t chunkSize = std::min(kParallelChunkSize, triangleRange.length() - chunkIndex * kParallelChunkSize);
+            const uint32_t equalLeft = std::min(equalCount[chunkIndex], equalLeftCount - std::min(equal, equalLeftCount));
+            leftOffset[chunkIndex] = left;
+            rightOffset[chunkIndex] = right;
+            equalOffset[chunkIndex] = equal;
+            left += lessCount[chunkIndex] + equalLeft;
+            right += chunkSize - lessCount[chunkIndex] - equalLeft;
+            equal += equalCount[chunkIndex];
+        }
+
+        // Compute the destination of each triangle.
+        std::vector<uint32_t>& destination = data.destinationScratch;
+        forEachChunk(parallel, begin, end, [&](uint32_t chunkIndex, uint32_t chunkBegin, uint32_t chunkEnd)
+        {
+            uint32_t left = leftOffset[chunkIndex], right = rightOffset[chunkIndex], equal = equalOffset[chunkIndex];
+            for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                bool isLeft = keys[i] < pivot || (keys[i] == pivot && equal++ < equalLeftCount);
+                destination[i] = isLeft ? left++ : right++;
+            }
+        });
+
+        // Move the triangle data to its destination, one array at a time.
+        auto permute = [&](auto& values, auto& scratchValues)
+        {
+            forEachChunk(parallel, begin, end, [&](uint32_t, uint32_t chunkBegin, uint32_t chunkEnd)
+            {
+                for (uint32_t i = chunkBegin; i < chunkEnd; ++i) scratchValues[destination[i]] = values[i];
+            });
+            forEachChunk(parallel, begin, end, [&](uint32_t, uint32_t chunkBegin, uint32_t chunkEnd)
+            {
+                std::copy(scratchValues.begin() + chunkBegin, scratchValues.begin() + chunkEnd, values.begin() + chunkBegin);
+            });
+        };
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            permute(td.boundsMin[k], data.floatScratch);
+            permute(td.boundsMax[k], data.floatScratch);
+            permute(td.center[k], data.floatScratch);
+            permute(td.coneDirection[k], data.floatScratch);
+        }
+        permute(td.cosConeAngle, data.floatScratch);
+        permute(td.flux, data.floatScratch);
+        permute(td.triangleIndex, data.indexScratch);
+    }
+
     float3 LightBVHBuilder::computeLightingConesInternal(const uint32_t nodeIndex, BuildingData& data, float& cosConeAngle)
     {
         if (!data.nodes[nodeIndex].isLeaf())
         {
             auto node = data.nodes[nodeIndex].getInternalNode();
+            FALCOR_ASSERT(node.childCount == 2);
 
-            uint32_t leftIndex = nodeIndex + 1;
-            uint32_t rightIndex = node.rightChildIdx;
+            uint32_t leftIndex = node.firstChildIdx;
+            uint32_t rightIndex = node.firstChildIdx + 1;
 
             float leftNodeCosConeAngle = kInvalidCosConeAngle;
             float3 leftNodeConeDirection = computeLightingConesInternal(leftIndex, data, leftNodeCosConeAngle);
@@ -447,6 +860,7 @@ namespace Falcor
 
     float3 LightBVHBuilder::computeLightingCone(const Range& triangleRange, const BuildingData& data, float& cosTheta)
     {
+        const TriangleSortData& td = data.trianglesData;
         float3 coneDirection = float3(0.0f);
         cosTheta = kInvalidCosConeAngle;
 
@@ -455,7 +869,7 @@ namespace Falcor
         float3 coneDirectionSum = float3(0.0f);
         for (uint32_t triangleIdx = triangleRange.begin; triangleIdx < triangleRange.end; ++triangleIdx)
         {
-            coneDirectionSum += data.trianglesData[triangleIdx].coneDirection;
+            coneDirectionSum += td.getConeDirection(triangleIdx);
         }
         if (length(coneDirectionSum) >= FLT_MIN)
         {
@@ -463,14 +877,143 @@ namespace Falcor
             cosTheta = 1.f;
             for (uint32_t triangleIdx = triangleRange.begin; triangleIdx < triangleRange.end; ++triangleIdx)
             {
-                const TriangleSortData& td = data.trianglesData[triangleIdx];
-                cosTheta = computeCosConeAngle(coneDirection, cosTheta, td.coneDirection, td.cosConeAngle);
+                cosTheta = computeCosConeAngle(coneDirection, cosTheta, td.getConeDirection(triangleIdx), td.cosConeAngle[triangleIdx]);
             }
         }
         return coneDirection;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/)
+    void LightBVHBuilder::binTriangles(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, uint32_t dimension, const Options& parameters, bool computeCones, Bins& bins, std::vector<Bins>& chunkBins)
+    {
+        const TriangleSortData& td = data.trianglesData;
+        const uint32_t binCount = parameters.binCount;
+        const bool isLargeNode = triangleRange.length() >= kParallelNodeMinTriangleCount;
+
+        // Compute the mapping from centroid position to bin id.
+        const float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
+        const float w = bmax - bmin;
+        FALCOR_ASSERT(w >= 0.f); // The node bounds can be zero if all primitives are axis-aligned and coplanar
+        const float scale = w > FLT_MIN ? (float)binCount / w : 0.f;
+
+        // Helper to compute the bin ids for a block of triangles.
+        // The loop is branch-free over a contiguous array so that the compiler can vectorize it.
+        auto computeBinIds = [&](uint32_t blockBegin, uint32_t blockEnd, int32_t* binIds)
+        {
+            const float* centers = td.center[dimension].data();
+            const int32_t maxBinId = (int32_t)binCount - 1;
+            for (uint32_t i = blockBegin; i < blockEnd; ++i)
+            {
+                FALCOR_ASSERT(bmin <= centers[i] && centers[i] <= bmax);
+                binIds[i - blockBegin] = std::min((int32_t)((centers[i] - bmin) * scale), maxBinId);
+            }
+        };
+
+        // Helper to accumulate the triangles in [begin, end) into a set of bins, one array at a time.
+        auto accumulate = [&](uint32_t begin, uint32_t end, Bins& target)
+        {
+            int32_t binIds[kBinBlockSize];
+            for (uint32_t blockBegin = begin; blockBegin < end; blockBegin += kBinBlockSize)
+            {
+                const uint32_t blockEnd = std::min(blockBegin + kBinBlockSize, end);
+                computeBinIds(blockBegin, blockEnd, binIds);
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const float* boundsMin = td.boundsMin[k].data();
+                    const float* boundsMax = td.boundsMax[k].data();
+                    float* binMin = target.boundsMin[k].data();
+                    float* binMax = target.boundsMax[k].data();
+                    for (uint32_t i = blockBegin; i < blockEnd; ++i)
+                    {
+                        const int32_t b = binIds[i - blockBegin];
+                        binMin[b] = std::min(binMin[b], boundsMin[i]);
+                        binMax[b] = std::max(binMax[b], boundsMax[i]);
+                    }
+                }
+                for (uint32_t i = blockBegin; i < blockEnd; ++i) target.triangleCount[binIds[i - blockBegin]]++;
+
+                if (computeCones)
+                {
+                    for (uint32_t i = blockBegin; i < blockEnd; ++i) target.flux[binIds[i - blockBegin]] += td.flux[i];
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        const float* coneDirection = td.coneDirection[k].data();
+                        float* binConeDirection = target.coneDirection[k].data();
+                        for (uint32_t i = blockBegin; i < blockEnd; ++i) binConeDirection[binIds[i - blockBegin]] += coneDirection[i];
+                    }
+                }
+            }
+        };
+
+        // Helper to grow the bounding cones of the bins to include the triangles in [begin, end).
+        auto growCones = [&](uint32_t begin, uint32_t end, std::vector<float>& cosConeAngle)
+        {
+            int32_t binIds[kBinBlockSize];
+            for (uint32_t blockBegin = begin; blockBegin < end; blockBegin += kBinBlockSize)
+            {
+                const uint32_t blockEnd = std::min(blockBegin + kBinBlockSize, end);
+                computeBinIds(blockBegin, blockEnd, binIds);
+                for (uint32_t i = blockBegin; i < blockEnd; ++i)
+                {
+                    const int32_t b = binIds[i - blockBegin];
+                    cosConeAngle[b] = computeCosConeAngle(bins.getConeDirection(b), cosConeAngle[b], td.getConeDirection(i), td.cosConeAngle[i]);
+                }
+            }
+        };
+
+        // Fill the bins with all triangles.
+        // Large nodes are binned in chunks, which are then merged in order.
+        bins.reset(binCount);
+        const uint32_t chunkCount = isLargeNode ? getChunkCount(triangleRange.begin, triangleRange.end) : 0;
+        if (isLargeNode)
+        {
+            chunkBins.resize(chunkCount);
+            forEachChunk(parameters.useParallelBuild, triangleRange.begin, triangleRange.end, [&](uint32_t chunkIndex, uint32_t chunkBegin, uint32_t chunkEnd)
+            {
+                chunkBins[chunkIndex].reset(binCount);
+                accumulate(chunkBegin, chunkEnd, chunkBins[chunkIndex]);
+            });
+            for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) bins.include(chunkBins[chunkIndex]);
+        }
+        else
+        {
+            accumulate(triangleRange.begin, triangleRange.end, bins);
+        }
+
+        if (!computeCones) return;
+
+        // Compute the lighting cones for each bin.
+        // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
+        // If the vector is zero length (no lights or if all directions cancelled out), the cone is marked as invalid.
+        // TODO: Switch to a more sophisticated algorithm to get narrower cones.
+        for (uint32_t b = 0; b < binCount; ++b)
+        {
+            const float3 coneDirection = bins.getConeDirection(b);
+            bins.cosConeAngle[b] = length(coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
+            const float3 normalizedDirection = normalize(coneDirection);
+            for (uint32_t k = 0; k < 3; ++k) bins.coneDirection[k][b] = normalizedDirection[k];
+        }
+        if (isLargeNode)
+        {
+            // Growing the cone only ever takes the minimum cosine, so the per-chunk angles can be merged in any order.
+            forEachChunk(parameters.useParallelBuild, triangleRange.begin, triangleRange.end, [&](uint32_t chunkIndex, uint32_t chunkBegin, uint32_t chunkEnd)
+            {
+                std::vector<float>& chunkCosConeAngle = chunkBins[chunkIndex].cosConeAngle;
+                std::fill(chunkCosConeAngle.begin(), chunkCosConeAngle.end(), 1.f);
+                growCones(chunkBegin, chunkEnd, chunkCosConeAngle);
+            });
+            for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+            {
+                for (uint32_t b = 0; b < binCount; ++b) bins.cosConeAngle[b] = std::min(bins.cosConeAngle[b], chunkBins[chunkIndex].cosConeAngle[b]);
+            }
+        }
+        else
+        {
+            growCones(triangleRange.begin, triangleRange.end, bins.cosConeAngle);
+        }
+    }
+
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/, SplitScratch& /*scratch*/)
     {
         // Find the largest dimension.
         float3 dimensions = nodeBounds.extent();
@@ -497,79 +1040,54 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters, SplitScratch& scratch)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         FALCOR_ASSERT(!overallBestSplit.second.isValid());
 
-        struct Bin
-        {
-            AABB bounds;
-            uint32_t triangleCount = 0;
-
-            Bin() = default;
-            Bin(const TriangleSortData& tri) : bounds(tri.bounds), triangleCount(1) {}
-            Bin& operator|= (const Bin& rhs)
-            {
-                bounds |= rhs.bounds;
-                triangleCount += rhs.triangleCount;
-                return *this;
-            }
-        };
-
         FALCOR_ASSERT(parameters.binCount > 1);
-        std::vector<Bin> bins(parameters.binCount);
-        std::vector<float> costs(parameters.binCount - 1);
+        const bool isLargeNode = triangleRange.length() >= kParallelNodeMinTriangleCount;
 
         /** Helper function that computes the best split along the given dimension using the SAH metric.
             The triangles are binned to n bins, storing only the aggregate parameters (triangle count and bounds).
             Then the cost metric is evaluated for each of the n-1 potential splits.
+            Returns an infinite cost if no valid split was found along the dimension.
         */
-        const auto binAlongDimension = [&bins, &costs, &triangleRange, &data, &parameters, &overallBestSplit, &nodeBounds](uint32_t dimension)
+        const auto binAlongDimension = [&triangleRange, &data, &parameters, &nodeBounds, &scratch](uint32_t dimension)
         {
-            // Helper to compute the bin id for a given triangle.
-            auto getBinId = [&](const TriangleSortData& td)
-            {
-                float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
-                FALCOR_ASSERT(bmin < bmax);
-                float scale = (float)parameters.binCount / (bmax - bmin);
-                float p = td.bounds.center()[dimension];
-                FALCOR_ASSERT(bmin <= p && p <= bmax);
-                return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
-            };
-
-            // Reset the bins.
-            for (Bin& bin : bins) bin = Bin();
+            Bins& bins = scratch.bins[dimension];
+            std::vector<float>& costs = scratch.costs[dimension];
+            costs.resize(parameters.binCount - 1);
 
             // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-            {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
-            }
+            binTriangles(data, triangleRange, nodeBounds, dimension, parameters, false, bins, scratch.chunkBins[dimension]);
 
             // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
             // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
-            Bin total = Bin();
+            AABB totalBounds;
+            uint32_t totalCount = 0;
             for (std::size_t i = 0; i < costs.size(); ++i)
             {
-                total |= bins[i];
-                costs[i] = evalSAH(total.bounds, total.triangleCount, parameters);
+                totalBounds |= bins.getBounds(i);
+                totalCount += bins.triangleCount[i];
+                costs[i] = evalSAH(totalBounds, totalCount, parameters);
             }
 
             // Then, compute A_j(R) * N_j(R) by sweeping over the bins from right to left.
-            total = Bin();
+            totalBounds = AABB();
+            totalCount = 0;
             for (std::size_t i = costs.size(); i > 0; --i)
             {
-                total |= bins[i];
-                costs[i - 1] += evalSAH(total.bounds, total.triangleCount, parameters);
+                totalBounds |= bins.getBounds(i);
+                totalCount += bins.triangleCount[i];
+                costs[i - 1] += evalSAH(totalBounds, totalCount, parameters);
             }
 
             // Compute the cheapest split along the current dimension.
             std::pair<float, SplitResult> axisBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult{ dimension, 0 });
             for (uint32_t i = 0, triIdx = triangleRange.begin; i < costs.size(); ++i)
             {
-                triIdx += bins[i].triangleCount;
+                triIdx += bins.triangleCount[i];
                 if (costs[i] < axisBestSplit.first)
                 {
                     axisBestSplit = std::make_pair(costs[i], SplitResult{ dimension, triIdx });
@@ -579,15 +1097,14 @@ namespace Falcor
 
             // Early out if all lights fall on either side of the split.
             if (axisBestSplit.second.triangleIndex == triangleRange.begin ||
-                axisBestSplit.second.triangleIndex == triangleRange.end) return;
+                axisBestSplit.second.triangleIndex == triangleRange.end) return std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
 
-            if (axisBestSplit.first < overallBestSplit.first)
-            {
-                overallBestSplit = axisBestSplit;
-                FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
-            }
+            return axisBestSplit;
         };
 
+        std::pair<float, SplitResult> axisBestSplits[3];
+        for (auto& split : axisBestSplits) split = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
+
         if (parameters.splitAlongLargest)
         {
             // Find the largest dimension.
@@ -595,13 +1112,28 @@ namespace Falcor
             uint32_t largestDimension = dimensions[2] >= dimensions[0] && dimensions[2] >= dimensions[1] ?
                 2 : (dimensions[1] >= dimensions[0] && dimensions[1] >= dimensions[2] ? 1 : 0);
 
-            binAlongDimension(largestDimension);
+            axisBestSplits[largestDimension] = binAlongDimension(largestDimension);
+        }
+        else if (isLargeNode && parameters.useParallelBuild)
+        {
+            auto dimensionRange = NumericRange<uint32_t>(0, 3);
+            std::for_each(std::execution::par, dimensionRange.begin(), dimensionRange.end(), [&](uint32_t dimension) { axisBestSplits[dimension] = binAlongDimension(dimension); });
         }
         else
         {
             for (uint32_t dimension = 0; dimension < 3; ++dimension)
             {
-                binAlongDimension(dimension);
+                axisBestSplits[dimension] = binAlongDimension(dimension);
+            }
+        }
+
+        // Pick the cheapest split, visiting the dimensions in order so that ties are resolved the same way however they were evaluated.
+        for (const auto& axisBestSplit : axisBestSplits)
+        {
+            if (axisBestSplit.first < overallBestSplit.first)
+            {
+                overallBestSplit = axisBestSplit;
+                FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
             }
         }
 
@@ -610,7 +1142,7 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters, scratch);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
@@ -652,7 +1184,7 @@ namespace Falcor
         return cost;
     }
 
-    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)
+    LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters, SplitScratch& scratch)
     {
         std::pair<float, SplitResult> overallBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
         FALCOR_ASSERT(!overallBestSplit.second.isValid());
@@ -662,30 +1194,8 @@ namespace Falcor
         uint32_t largestDimension = dimensions[2] >= dimensions[0] && dimensions[2] >= dimensions[1] ?
             2 : (dimensions[1] >= dimensions[0] && dimensions[1] >= dimensions[2] ? 1 : 0);
 
-        struct Bin
-        {
-            AABB bounds;
-            uint32_t triangleCount = 0;
-            float flux = 0.0f;
-            float3 coneDirection = float3(0.0f);
-            float cosConeAngle = 1.0f;
-
-            Bin() = default;
-            Bin(const TriangleSortData& tri) : bounds(tri.bounds), triangleCount(1), flux(tri.flux), coneDirection(tri.coneDirection), cosConeAngle(tri.cosConeAngle) {}
-            Bin& operator|= (const Bin& rhs)
-            {
-                bounds |= rhs.bounds;
-                triangleCount += rhs.triangleCount;
-                flux += rhs.flux;
-                coneDirection += rhs.coneDirection;
-                // Note: cosConeAngle should be computed separately after the final cone direction is known
-                return *this;
-            }
-        };
-
         FALCOR_ASSERT(parameters.binCount > 1);
-        std::vector<Bin> bins(parameters.binCount);
-        std::vector<float> costs(parameters.binCount - 1);
+        const bool isLargeNode = triangleRange.length() >= kParallelNodeMinTriangleCount;
 
         /** Helper function that computes the best split along the given dimension using the SAOH metric.
             The triangles are binned to n bins, storing only the aggregate parameters (triangle count, bounds, flux, and cone direction).
@@ -693,95 +1203,63 @@ namespace Falcor
             Note that while the bounds and flux are accurately represented by the aggregated parameters,
             the bounding cones are approximates based on the bins' bounding cones. This is less expensive,
             but also less precise than computing them directly from the triangles.
+            Returns an infinite cost if no valid split was found along the dimension.
         */
-        const auto binAlongDimension = [&bins, &costs, &triangleRange, &data, &parameters, &overallBestSplit, &nodeBounds, largestDimension, dimensions](uint32_t dimension)
-        {
-            // Helper to compute the bin id for a given triangle.
-            auto getBinId = [&](const TriangleSortData& td)
-            {
-                float bmin = nodeBounds.minPoint[dimension], bmax = nodeBounds.maxPoint[dimension];
-                float w = bmax - bmin;
-                FALCOR_ASSERT(w >= 0.f); // The node bounds can be zero if all primitives are axis-aligned and coplanar
-                float scale = w > FLT_MIN ? (float)parameters.binCount / w : 0.f;
-                float p = td.bounds.center()[dimension];
-                FALCOR_ASSERT(bmin <= p && p <= bmax);
-                return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
-            };
-
-            // Reset the bins.
-            for (Bin& bin : bins) bin = Bin();
-
-            // Fill the bins with all triangles.
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-            {
-                const auto& td = data.trianglesData[i];
-                bins[getBinId(td)] |= td;
-            }
+        const auto binAlongDimension = [&triangleRange, &data, &parameters, &nodeBounds, &scratch, largestDimension, dimensions](uint32_t dimension)
+        {
+            Bins& bins = scratch.bins[dimension];
+            std::vector<float>& costs = scratch.costs[dimension];
+            costs.resize(parameters.binCount - 1);
 
-            // Compute the lighting cones for each bin.
-            // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
-            // If the vector is zero length (no lights or if all directions cancelled out), the cone is marked as invalid.
-            // TODO: Switch to a more sophisticated algorithm to get narrower cones.
-            for (Bin& bin : bins)
-            {
-                bin.cosConeAngle = length(bin.coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
-                bin.coneDirection = normalize(bin.coneDirection);
-            }
-            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-            {
-                const auto& td = data.trianglesData[i];
-                Bin& bin = bins[getBinId(td)];
-                bin.cosConeAngle = computeCosConeAngle(bin.coneDirection, bin.cosConeAngle, td.coneDirection, td.cosConeAngle);
-            }
+            // Fill the bins with all triangles and compute their lighting cones.
+            binTriangles(data, triangleRange, nodeBounds, dimension, parameters, true, bins, scratch.chunkBins[dimension]);
 
-            // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
-            // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
-            Bin total = Bin();
-            for (std::size_t i = 0; i < costs.size(); ++i)
+            // Helper to compute the bounding cone angle for the union of bins [firstBin, lastBin].
+            auto computeCosTheta = [&bins](const float3& coneDirectionSum, std::size_t firstBin, std::size_t lastBin)
             {
-                total |= bins[i];
-
-                // Compute the bounding cone angle for the union of bins 0..i.
                 float cosTheta = kInvalidCosConeAngle;
-                if (length(total.coneDirection) >= FLT_MIN)
+                if (length(coneDirectionSum) >= FLT_MIN)
                 {
                     cosTheta = 1.f;
-                    float3 coneDir = normalize(total.coneDirection);
-                    for (std::size_t j = 0; j <= i; ++j)
+                    float3 coneDir = normalize(coneDirectionSum);
+                    for (std::size_t j = firstBin; j <= lastBin; ++j)
                     {
-                        cosTheta = computeCosConeAngle(coneDir, cosTheta, bins[j].coneDirection, bins[j].cosConeAngle);
+                        cosTheta = computeCosConeAngle(coneDir, cosTheta, bins.getConeDirection(j), bins.cosConeAngle[j]);
                     }
                 }
+                return cosTheta;
+            };
 
-                costs[i] = evalSAOH(total.bounds, total.flux, cosTheta, parameters);
+            // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
+            // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
+            AABB totalBounds;
+            float totalFlux = 0.f;
+            float3 totalConeDirection = float3(0.f);
+            for (std::size_t i = 0; i < costs.size(); ++i)
+            {
+                totalBounds |= bins.getBounds(i);
+                totalFlux += bins.flux[i];
+                totalConeDirection += bins.getConeDirection(i);
+                costs[i] = evalSAOH(totalBounds, totalFlux, computeCosTheta(totalConeDirection, 0, i), parameters);
             }
 
             // Then, compute A_j(R) * N_j(R) by sweeping over the bins from right to left.
-            total = Bin();
+            totalBounds = AABB();
+            totalFlux = 0.f;
+            totalConeDirection = float3(0.f);
             for (std::size_t i = costs.size(); i > 0; --i)
             {
-                total |= bins[i];
-
-                // Compute the bounding cone angle for the union of bins i..n-1.
-                float cosTheta = kInvalidCosConeAngle;
-                if (length(total.coneDirection) >= FLT_MIN)
-                {
-                    cosTheta = 1.f;
-                    float3 coneDir = normalize(total.coneDirection);
-                    for (std::size_t j = i; j <= costs.size(); ++j)
-                    {
-                        cosTheta = computeCosConeAngle(coneDir, cosTheta, bins[j].coneDirection, bins[j].cosConeAngle);
-                    }
-                }
-
-                costs[i - 1] += evalSAOH(total.bounds, total.flux, cosTheta, parameters);
+                totalBounds |= bins.getBounds(i);
+                totalFlux += bins.flux[i];
+                totalConeDirection += bins.getConeDirection(i);
+                costs[i - 1] += evalSAOH(totalBounds, totalFlux, computeCosTheta(totalConeDirection, i, costs.size()), parameters);
             }
 
             // Compute the cheapest split along the current dimension.
             std::pair<float, SplitResult> axisBestSplit = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult{ dimension, 0 });
             for (uint32_t i = 0, triIdx = triangleRange.begin; i < costs.size(); ++i)
             {
-                triIdx += bins[i].triangleCount;
+                triIdx += bins.triangleCount[i];
                 if (costs[i] < axisBestSplit.first)
                 {
                     axisBestSplit = std::make_pair(costs[i], SplitResult{ dimension, triIdx });
@@ -794,25 +1272,39 @@ namespace Falcor
 
             // Early out if all lights fall on either side of the split.
             if (axisBestSplit.second.triangleIndex == triangleRange.begin ||
-                axisBestSplit.second.triangleIndex == triangleRange.end) return;
+                axisBestSplit.second.triangleIndex == triangleRange.end) return std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
 
-            if (axisBestSplit.first < overallBestSplit.first)
-            {
-                overallBestSplit = axisBestSplit;
-                FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
-            }
+            return axisBestSplit;
         };
 
         // Compute the best split.
+        std::pair<float, SplitResult> axisBestSplits[3];
+        for (auto& split : axisBestSplits) split = std::make_pair(std::numeric_limits<float>::infinity(), SplitResult());
+
         if (parameters.splitAlongLargest)
         {
-            binAlongDimension(largestDimension);
+            axisBestSplits[largestDimension] = binAlongDimension(largestDimension);
+        }
+        else if (isLargeNode && parameters.useParallelBuild)
+        {
+            auto dimensionRange = NumericRange<uint32_t>(0, 3);
+            std::for_each(std::execution::par, dimensionRange.begin(), dimensionRange.end(), [&](uint32_t dimension) { axisBestSplits[dimension] = binAlongDimension(dimension); });
         }
         else
         {
             for (uint32_t dimension = 0; dimension < 3; ++dimension)
             {
-                binAlongDimension(dimension);
+                axisBestSplits[dimension] = binAlongDimension(dimension);
+            }
+        }
+
+        // Pick the cheapest split, visiting the dimensions in order so that ties are resolved the same way however they were evaluated.
+        for (const auto& axisBestSplit : axisBestSplits)
+        {
+            if (axisBestSplit.first < overallBestSplit.first)
+            {
+                overallBestSplit = axisBestSplit;
+                FALCOR_ASSERT(triangleRange.begin < overallBestSplit.second.triangleIndex && overallBestSplit.second.triangleIndex < triangleRange.end);
             }
         }
 
@@ -821,23 +1313,45 @@ namespace Falcor
         {
             if (triangleRange.length() <= parameters.maxTriangleCountPerLeaf) return SplitResult();
             logWarning("LightBVHBuilder::computeSplitWithBinnedSAOH() was not able to compute a proper split: reverting to LightBVHBuilder::computeSplitWithEqual()");
-            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters);
+            return computeSplitWithEqual(data, triangleRange, nodeBounds, parameters, scratch);
         }
 
         // If the best split we found is more expensive than the cost of a leaf node (and we can create one), then create a leaf node.
         FALCOR_ASSERT(overallBestSplit.second.isValid());
         if (parameters.useLeafCreationCost && triangleRange.length() <= parameters.maxTriangleCountPerLeaf)
         {
-            // Evaluate the cost metric for the node. This requires us to first compute the cone angle.
+            // Evaluate the cost metric for the node. This requires us to first compute the cone angle and flux.
             float cosTheta = kInvalidCosConeAngle;
             computeLightingCone(triangleRange, data, cosTheta);
-            float leafCost = evalSAOH(nodeBounds, data.currentNodeFlux, cosTheta, parameters);
+            float nodeFlux = 0.f;
+            for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i) nodeFlux += data.trianglesData.flux[i];
+            float leafCost = evalSAOH(nodeBounds, nodeFlux, cosTheta, parameters);
             if (leafCost <= overallBestSplit.first) return SplitResult();
         }
 
         return overallBestSplit.second;
     }
 
+    float LightBVHBuilder::evalTreeCost(const std::vector<PackedNode>& nodes, const Options& options)
+    {
+        if (nodes.empty()) return 0.f;
+
+        const float rootCost = evalNodeCost(nodes[0], options);
+        if (rootCost <= 0.f) return 0.f;
+
+        double totalCost = 0.0;
+        for (const PackedNode& node : nodes) totalCost += evalNodeCost(node, options);
+        return (float)(totalCost / rootCost);
+    }
+
+    float LightBVHBuilder::evalNodeCost(const PackedNode& node, const Options& options)
+    {
+        SharedNodeAttributes attribs = node.getNodeAttributes();
+        float3 aabbMin, aabbMax;
+        attribs.getAABB(aabbMin, aabbMax);
+        return evalSAOH(AABB(aabbMin, aabbMax), attribs.flux, attribs.cosConeAngle, options);
+    }
+
     LightBVHBuilder::SplitHeuristicFunction LightBVHBuilder::getSplitFunction(SplitHeuristic heuristic)
     {
         switch (heuristic)
@@ -12,7 +12,10 @@
 
 namespace Falcor
 {
-    /** Utility class for building 2-way light BVH on the CPU.
+    /** Utility class for building 2-way, 4-way or 8-way light BVH on the CPU.
+
+        The tree is first built as a binary BVH. Wider trees are then created by collapsing
+        the binary tree, so that each internal node references up to 'branchingFactor' children.
 
         The building process can be customized via the |Options|,
         which are also available in the GUI via the |renderUI()| function.
@@ -51,6 +54,10 @@ namespace Falcor
             bool           allowRefitting = true;                                ///< Rather than always rebuilding the BVH from scratch, keep the hierarchy but update the bounds and lighting cones.
             bool           usePreintegration = true;                             ///< Use pre-integration for culling out emissive triangles and use their flux when computing the splits. Only valid when using the BinnedSAOH split heuristic.
             bool           useLightingCones = true;                              ///< Use lighting cones when computing the splits. Only valid when using the BinnedSAOH split heuristic.
+            bool           useParallelBuild = true;                              ///< Build large subtrees and evaluate splits of large nodes on multiple threads. The resulting BVH does not depend on this setting or on the number of threads.
+            uint32_t       branchingFactor = 2;                                  ///< Maximum number of children per internal node (2, 4 or 8). Wider trees need fewer traversal steps per sample.
+            bool           refitOnCPU = false;                                   ///< Refit the nodes affected by moving lights on the CPU and upload them, rather than dispatching the refit kernels. This reads back the emissive triangles, but avoids reading back the refit nodes to track the tree quality.
+            float          rebuildCostThreshold = 0.5f;                          ///< Rebuild the BVH when refitting has increased its relative SAOH cost by more than this fraction since the last build. Set to zero to disable. Only used when refitting on the CPU.
 
             template<typename Archive>
             void serialize(Archive& ar)
@@ -66,6 +73,10 @@ namespace Falcor
                 ar("allowRefitting", allowRefitting);
                 ar("usePreintegration", usePreintegration);
                 ar("useLightingCones", useLightingCones);
+                ar("useParallelBuild", useParallelBuild);
+                ar("branchingFactor", branchingFactor);
+                ar("refitOnCPU", refitOnCPU);
+                ar("rebuildCostThreshold", rebuildCostThreshold);
             }
         };
 
@@ -79,6 +90,37 @@ namespace Falcor
         */
         void build(RenderContext* pRenderContext, LightBVH& bvh);
 
+        /** Build the BVH nodes for a list of emissive triangles on the CPU, without creating any GPU resources.
+            This is the CPU part of build(), exposed for benchmarking and validating the builder.
+            \param[in] triangles Emissive triangles in world space.
+            \param[out] nodes BVH nodes, with the root node at index 0. The children of each internal node are stored contiguously. The lighting cones of internal nodes are computed.
+            \param[out] triangleIndices Triangle indices sorted by leaf node.
+            \param[out] triangleBitmasks Per triangle bit pattern retracing the tree traversal to reach the triangle. Indexed by global triangle index. See getTriangleBitmask().
+            \return False if no triangle was included in the BVH, true otherwise.
+        */
+        bool buildNodes(const std::vector<ILightCollection::MeshLightTriangle>& triangles, std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks);
+
+        /** Evaluates the SAOH cost of a built BVH, as a measure of the tree quality.
+            The cost is the sum of the SAOH cost of all nodes, relative to the cost of the root node. Lower is better.
+            \param[in] nodes BVH nodes, with the root node at index 0.
+            \param[in] options The options used to evaluate the SAOH cost (volume vs. area, pre-integration and lighting cones).
+            \return The relative tree cost, or zero if the tree is empty.
+        */
+        static float evalTreeCost(const std::vector<PackedNode>& nodes, const Options& options);
+
+        /** Evaluates the SAOH cost of a single node. evalTreeCost() is the sum of this over all nodes, divided by the cost of the root.
+            \param[in] node The node.
+            \param[in] options The options used to evaluate the SAOH cost.
+            \return The unnormalized node cost.
+        */
+        static float evalNodeCost(const PackedNode& node, const Options& options);
+
+        /** Returns the number of bits used per tree level in the triangle bitmasks.
+            At each level, the bitmask stores the index of the child to traverse, starting with the least significant bits.
+            \param[in] branchingFactor The branching factor of the tree.
+        */
+        static uint32_t getBitmaskBitsPerLevel(uint32_t branchingFactor);
+
         bool renderUI(Gui::Widgets& widget);
 
         const Options& getOptions() const { return mOptions; }
@@ -106,23 +148,66 @@ namespace Falcor
             }
         };
 
+        /** Per-triangle data used during the build, stored as structure of arrays.
+            The arrays are indexed by the position of the triangle in the build order and are permuted when the triangles are partitioned.
+        */
         struct TriangleSortData
         {
-            AABB bounds;                                    ///< World-space bounding box for the light source(s).
-            float3 center = {};                             ///< Center point.
-            float3 coneDirection = {};                      ///< Light emission normal direction.
-            float cosConeAngle = 1.f;                       ///< Cosine normal bounding cone (half) angle.
-            float flux = 0.f;                               ///< Precomputed triangle flux (note, this takes doublesidedness into account).
-            uint32_t triangleIndex = MeshLightData::kInvalidIndex; ///< Index into global triangle list.
+            std::vector<float> boundsMin[3];                ///< World-space bounding box minimum for the light source(s), per axis.
+            std::vector<float> boundsMax[3];                ///< World-space bounding box maximum for the light source(s), per axis.
+            std::vector<float> center[3];                   ///< Bounding box center per axis. This is the key used for binning and partitioning.
+            std::vector<float> coneDirection[3];            ///< Light emission normal direction, per axis.
+            std::vector<float> cosConeAngle;                ///< Cosine normal bounding cone (half) angle.
+            std::vector<float> flux;                        ///< Precomputed triangle flux (note, this takes doublesidedness into account).
+            std::vector<uint32_t> triangleIndex;            ///< Index into global triangle list.
+
+            size_t size() const { return triangleIndex.size(); }
+            void resize(size_t count);
+            AABB getBounds(size_t i) const { return AABB(float3(boundsMin[0][i], boundsMin[1][i], boundsMin[2][i]), float3(boundsMax[0][i], boundsMax[1][i], boundsMax[2][i])); }
+            float3 getConeDirection(size_t i) const { return float3(coneDirection[0][i], coneDirection[1][i], coneDirection[2][i]); }
+        };
+
+        /** Aggregated triangle data for the bins used by the binned split heuristics, stored as structure of arrays.
+        */
+        struct Bins
+        {
+            std::vector<float> boundsMin[3];                ///< Bounding box minimum per axis.
+            std::vector<float> boundsMax[3];                ///< Bounding box maximum per axis.
+            std::vector<float> coneDirection[3];            ///< Sum of the light emission normals, or the normalized cone direction once the bounding cones are computed.
+            std::vector<float> cosConeAngle;                ///< Cosine of the bounding cone (half) angle.
+            std::vector<float> flux;                        ///< Total flux.
+            std::vector<uint32_t> triangleCount;            ///< Number of triangles.
+
+            /** Resize to the given number of bins and reset all bins to empty.
+            */
+            void reset(uint32_t binCount);
+
+            /** Merge another set of bins into this one. The bounding cones are not merged.
+            */
+            void include(const Bins& other);
+
+            AABB getBounds(size_t i) const { return AABB(float3(boundsMin[0][i], boundsMin[1][i], boundsMin[2][i]), float3(boundsMax[0][i], boundsMax[1][i], boundsMax[2][i])); }
+            float3 getConeDirection(size_t i) const { return float3(coneDirection[0][i], coneDirection[1][i], coneDirection[2][i]); }
+        };
+
+        /** Scratch memory for evaluating splits.
+            Each subtree built in parallel owns one instance, which is reused for all nodes it splits to avoid allocations.
+        */
+        struct SplitScratch
+        {
+            Bins bins[3];                                   ///< Bins per axis.
+            std::vector<float> costs[3];                    ///< Split costs per axis. The i:th element represents the split between bin i and i+1.
+            std::vector<Bins> chunkBins[3];                 ///< Per-chunk bins per axis. Only used for large nodes.
         };
 
         struct BuildingData
         {
             std::vector<PackedNode>& nodes;                 ///< BVH nodes generated by the builder.
-            std::vector<TriangleSortData> trianglesData;    ///< Compact list of triangles to include in build.
-            std::vector<uint32_t> triangleIndices;          ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
-            std::vector<uint64_t> triangleBitmasks;         ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child; this array gets filled in during the build process. Indexed by global triangle index.
-            float currentNodeFlux = 0.f;                    ///< Used by computeSAOHSplit() as the leaf creation cost.
+            TriangleSortData trianglesData;                 ///< Compact list of triangles to include in build.
+            std::vector<uint32_t> triangleIndices;          ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices. Sized to match trianglesData, as leaf nodes store their triangles at the same offset as their range in trianglesData.
+            std::vector<float> floatScratch;                ///< Scratch memory for partitioning, sized to match trianglesData. Concurrent subtree builds use disjoint ranges of it.
+            std::vector<uint32_t> indexScratch;             ///< Scratch memory for partitioning, sized to match trianglesData. Concurrent subtree builds use disjoint ranges of it.
+            std::vector<uint32_t> destinationScratch;       ///< Scratch memory for partitioning, sized to match trianglesData. Concurrent subtree builds use disjoint ranges of it.
 
             BuildingData(std::vector<PackedNode>& bvhNodes) : nodes(bvhNodes) {}
         };
@@ -132,22 +217,64 @@ namespace Falcor
             \param[in] triangleRange Range of triangles to process.
             \param[in] nodeBounds Bounds for the node to be splitted.
             \param[in] parameters Various parameters defining how the building should occur.
+            \param[in,out] scratch Scratch memory owned by the calling thread.
         */
-        using SplitHeuristicFunction = std::function<SplitResult(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters)>;
+        using SplitHeuristicFunction = std::function<SplitResult(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters, SplitScratch& scratch)>;
 
         /** Renders the UI with builder options.
         */
         bool renderOptions(Gui::Widgets& widget, Options& options) const;
 
-        /** Recursive BVH build.
+        /** Recursive binary BVH build.
+            The node is written to a slot allocated by the caller, and the two children of an internal node are allocated next to each other at the end of the node list.
+            Subtrees over large triangle ranges are built concurrently when 'useParallelBuild' is enabled.
+            Each concurrent subtree is built into its own node list and then appended, so the node layout
+            is the same as for a single-threaded depth-first build.
             \param[in] splitHeuristic The splitting heuristic to be used.
-            \param[in] bitmask Bit pattern retracing the tree traversal to reach the node to be built: 0=left child, 1=right child.
             \param[in] depth Depth of the node to be built
             \param[in] triangleRange Range of triangles to process.
             \param[in,out] data Prepared light data.
-            \return Index of the allocated node.
+            \param[in,out] scratch Scratch memory owned by the calling thread.
+            \param[in] nodeIndex Index of the slot allocated for the node.
+            \param[in,out] nodes Node list to which the subtree is appended. Child indices are relative to the start of this list.
+        */
+        void buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint32_t depth, const Range& triangleRange, BuildingData& data, SplitScratch& scratch, uint32_t nodeIndex, std::vector<PackedNode>& nodes);
+
+        /** Collapse a binary BVH into a wide BVH.
+            Each internal node of the wide tree replaces its binary children by their children, shallowest first, until it has 'branchingFactor' children.
+            The node attributes are copied unchanged, as a wide node covers the same triangles as the binary node it is created from.
+            \param[in] binaryNodes The binary BVH nodes.
+            \param[in] branchingFactor Maximum number of children per node.
+            \param[out] nodes The wide BVH nodes.
+        */
+        static void collapseNodes(const std::vector<PackedNode>& binaryNodes, uint32_t branchingFactor, std::vector<PackedNode>& nodes);
+
+        /** Compute the per-triangle bit patterns retracing the tree traversal to reach each triangle.
+            \param[in] nodes BVH nodes.
+            \param[in] branchingFactor Maximum number of children per node.
+            \param[in] triangleIndices Triangle indices sorted by leaf node.
+            \param[in,out] triangleBitmasks Per triangle bit pattern. Must be sized to the global triangle count.
+        */
+        static void computeTriangleBitmasks(const std::vector<PackedNode>& nodes, uint32_t branchingFactor, const std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks);
+
+        /** Compute the bounds and total flux of a range of triangles.
+            Large ranges are reduced in fixed-size chunks whose results are merged in order, so the result does not depend on the number of threads.
+            \param[in] triangleRange Range of triangles to process.
+            \param[in] data Prepared light data.
+            \param[in] parallel Process the chunks of large ranges on multiple threads.
+            \param[out] bounds Bounds of all triangles in the range.
+            \param[out] flux Total flux of all triangles in the range.
         */
-        uint32_t buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data);
+        static void computeBoundsAndFlux(const Range& triangleRange, const BuildingData& data, bool parallel, AABB& bounds, float& flux);
+
+        /** Reorder a range of triangles so that the triangles before the split index have smaller centroids along the split axis than those after it.
+            The partition is stable and processes large ranges in fixed-size chunks, so the result does not depend on the number of threads.
+            \param[in] splitResult The split to apply.
+            \param[in] triangleRange Range of triangles to process.
+            \param[in,out] data Prepared light data.
+            \param[in] parallel Process the chunks of large ranges on multiple threads.
+        */
+        static void partitionTriangles(const SplitResult& splitResult, const Range& triangleRange, BuildingData& data, bool parallel);
 
         /** Recursive computation of lighting cones for all internal nodes.
             \param[in] nodeIndex Index of the current node.
@@ -165,10 +292,24 @@ namespace Falcor
         */
         static float3 computeLightingCone(const Range& triangleRange, const BuildingData& data, float& cosTheta);
 
+        /** Bin a range of triangles along one dimension.
+            The bin ids are computed for blocks of triangles in a branch-free loop over the centroid array, which the compiler vectorizes,
+            and the triangle data is then accumulated into the bins. Large ranges are binned in fixed-size chunks that are merged in order.
+            \param[in] data Prepared light data.
+            \param[in] triangleRange Range of triangles to process.
+            \param[in] nodeBounds Bounds for the node to be splitted.
+            \param[in] dimension The dimension along which to bin.
+            \param[in] parameters Build options.
+            \param[in] computeCones Accumulate flux and compute the bounding cone of each bin.
+            \param[out] bins The resulting bins.
+            \param[in,out] chunkBins Scratch memory for the per-chunk bins of large ranges.
+        */
+        static void binTriangles(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, uint32_t dimension, const Options& parameters, bool computeCones, Bins& bins, std::vector<Bins>& chunkBins);
+
         // See the documentation of SplitHeuristicFunction.
-        static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/);
-        static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters);
-        static SplitResult computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters);
+        static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const AABB& nodeBounds, const Options& /*parameters*/, SplitScratch& /*scratch*/);
+        static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters, SplitScratch& scratch);
+        static SplitResult computeSplitWithBinnedSAOH(const BuildingData& data, const Range& triangleRange, const AABB& nodeBounds, const Options& parameters, SplitScratch& scratch);
 
         static SplitHeuristicFunction getSplitFunction(SplitHeuristic heuristic);
 
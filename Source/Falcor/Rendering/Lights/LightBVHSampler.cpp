@@ -1,11 +1,166 @@
 #include "LightBVHSampler.h"
 #include "Core/Error.h"
+#include "Utils/Logger.h"
 #include "Utils/Timing/Profiler.h"
 #include <algorithm>
 #include <numeric>
+#include <stack>
 
 namespace Falcor
 {
+    namespace
+    {
+        // CPU versions of the traversal helpers in LightBVHSampler.slang and GeometryHelpers.slang.
+
+        float cosSubClamped(float sinThetaA, float cosThetaA, float sinThetaB, float cosThetaB)
+        {
+            if (cosThetaA > cosThetaB) return 1.f;
+            return cosThetaA * cosThetaB + sinThetaA * sinThetaB;
+        }
+
+        float sinSubClamped(float sinThetaA, float cosThetaA, float sinThetaB, float cosThetaB)
+        {
+            if (cosThetaA > cosThetaB) return 0.f;
+            return sinThetaA * cosThetaB - cosThetaA * sinThetaB;
+        }
+
+        void boundBoxSubtendedConeAngleCenter(const float3& origin, const float3& aabbMin, const float3& aabbMax, float& sinTheta, float& cosTheta)
+        {
+            const float3 center = (aabbMax + aabbMin) * 0.5f;
+            const float3 extent = (aabbMax - aabbMin) * 0.5f;
+            const float3 dir = center - origin;
+            const float extSqr = dot(extent, extent);
+            const float distSqr = dot(dir, dir);
+
+            const float3 e[4] = {
+                float3(extent.x, extent.y, extent.z),
+                float3(extent.x, extent.y, -extent.z),
+                float3(extent.x, -extent.y, extent.z),
+                float3(extent.x, -extent.y, -extent.z),
+            };
+
+            cosTheta = 1.f;
+            sinTheta = 0.f;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                float d = std::abs(dot(dir, e[i]));
+                float x = distSqr - d;
+                if (x < 1e-5f)
+                {
+                    cosTheta = -1.f;
+                    sinTheta = 0.f;
+                    return;
+                }
+                float y = std::sqrt(std::max(0.f, distSqr * extSqr - d * d));
+                float z = std::sqrt(x * x + y * y);
+                cosTheta = std::min(cosTheta, x / z);
+                sinTheta = std::max(sinTheta, y / z);
+            }
+        }
+
+        void boundBoxSubtendedConeAngleAverage(const float3& origin, const float3& aabbMin, const float3& aabbMax, float& sinTheta, float& cosTheta)
+        {
+            if (all(origin >= aabbMin && origin <= aabbMax))
+            {
+                sinTheta = 0.f;
+                cosTheta = -1.f;
+                return;
+            }
+
+            auto getCorner = [&](int i) { return float3((i & 1) ? aabbMin.x : aabbMax.x, (i & 2) ? aabbMin.y : aabbMax.y, (i & 4) ? aabbMin.z : aabbMax.z); };
+            float3 dirSum = float3(0.f);
+            for (int i = 0; i < 8; ++i) dirSum += normalize(getCorner(i) - origin);
+            const float3 coneDir = normalize(dirSum);
+
+            cosTheta = 1.f;
+            for (int i = 0; i < 8; ++i) cosTheta = std::min(cosTheta, dot(normalize(getCorner(i) - origin), coneDir));
+            sinTheta = std::sqrt(std::max(0.f, 1.f - cosTheta * cosTheta));
+        }
+
+        void boundSphereSubtendedConeAngle(const float3& center, float sqrRadius, float& sinTheta, float& cosTheta)
+        {
+            float centerDistance2 = dot(center, center);
+            if (centerDistance2 < sqrRadius)
+            {
+                sinTheta = 0.f;
+                cosTheta = -1.f;
+            }
+            else
+            {
+                float sin2Theta = sqrRadius / centerDistance2;
+                cosTheta = std::sqrt(1.f - sin2Theta);
+                sinTheta = std::sqrt(sin2Theta);
+            }
+        }
+
+        float boundCosineTerm(const float3& posW, const float3& normalW, const float3& center, const float3& extent, SolidAngleBoundMethod method, float& cosThetaCone)
+        {
+            float sinThetaCone = 0.f;
+            cosThetaCone = 0.f;
+
+            switch (method)
+            {
+            case SolidAngleBoundMethod::Sphere:
+                boundSphereSubtendedConeAngle(center - posW, dot(extent, extent), sinThetaCone, cosThetaCone);
+                break;
+            case SolidAngleBoundMethod::BoxToAverage:
+                boundBoxSubtendedConeAngleAverage(posW, center - extent, center + extent, sinThetaCone, cosThetaCone);
+                break;
+            case SolidAngleBoundMethod::BoxToCenter:
+                boundBoxSubtendedConeAngleCenter(posW, center - extent, center + extent, sinThetaCone, cosThetaCone);
+                break;
+            default:
+                return 0.f;
+            }
+
+            float3 L = normalize(center - posW);
+            float cosThetaL = std::clamp(dot(normalW, L), -1.f, 1.f);
+            float sinThetaL = std::sqrt(1.f - cosThetaL * cosThetaL);
+            return std::clamp(cosSubClamped(sinThetaL, cosThetaL, sinThetaCone, cosThetaCone), 0.f, 1.f);
+        }
+
+        /** Computes node importance from a given shading point. See LightBVHSampler::computeImportance() in LightBVHSampler.slang.
+        */
+        float computeImportance(const float3& posW, const float3& normalW, bool upperHemisphere, const SharedNodeAttributes& nodeAttribs, const LightBVHSampler::Options& options)
+        {
+            float flux = options.disableNodeFlux ? 1.f : nodeAttribs.flux;
+            float distance = length(nodeAttribs.origin - posW);
+
+            float NdotL = 1.f;
+            float cosThetaBoundingCone = 0.f;
+            if (options.useLightingCone || (options.useBoundingCone && upperHemisphere))
+            {
+                NdotL = boundCosineTerm(posW, normalW, nodeAttribs.origin, nodeAttribs.extent, options.solidAngleBoundMethod, cosThetaBoundingCone);
+                if (!(options.useBoundingCone && upperHemisphere)) NdotL = 1.f;
+            }
+
+            float orientationWeight = 1.f;
+            if (options.useLightingCone)
+            {
+                float cosConeAngle = nodeAttribs.cosConeAngle;
+                float3 dirToAabb = (nodeAttribs.origin - posW) / distance;
+                if (cosConeAngle != kInvalidCosConeAngle && cosConeAngle > 0.f)
+                {
+                    float sinConeAngle = std::sqrt(std::max(0.f, 1.f - cosConeAngle * cosConeAngle));
+                    float cosTheta = dot(nodeAttribs.coneDirection, -dirToAabb);
+                    float sinTheta = std::sqrt(std::max(0.f, 1.f - cosTheta * cosTheta));
+                    float sinThetaBoundingCone = std::sqrt(std::max(0.f, 1 - cosThetaBoundingCone * cosThetaBoundingCone));
+
+                    float cosTheta0 = cosSubClamped(sinTheta, cosTheta, sinConeAngle, cosConeAngle);
+                    float sinTheta0 = sinSubClamped(sinTheta, cosTheta, sinConeAngle, cosConeAngle);
+                    float cosThetaPrime = cosSubClamped(sinTheta0, cosTheta0, sinThetaBoundingCone, cosThetaBoundingCone);
+
+                    orientationWeight = std::max(0.f, cosThetaPrime);
+                }
+            }
+
+            float halfRadius = std::max(nodeAttribs.extent.x, std::max(nodeAttribs.extent.y, nodeAttribs.extent.z));
+            distance = std::max(halfRadius, distance);
+
+            return (flux * NdotL) * orientationWeight / (distance * distance);
+        }
+    }
+
     bool LightBVHSampler::update(RenderContext* pRenderContext, ref<ILightCollection> pLightCollection)
     {
         FALCOR_PROFILE(pRenderContext, "LightBVHSampler::update");
@@ -16,6 +171,7 @@ namespace Falcor
         if (mpLightCollection != pLightCollection)
         {
             setLightCollection(std::move(pLightCollection));
+            connectUpdatedLights();
             mNeedsRebuild = true;
             mpBVH = std::make_unique<LightBVH>(mpDevice, mpLightCollection);
         }
@@ -41,9 +197,29 @@ namespace Falcor
         }
         else if (needsRefit)
         {
-            mpBVH->refit(pRenderContext);
+            // Only refit the nodes holding triangles of the mesh lights that moved.
+            const auto& meshLights = mpLightCollection->getMeshLights();
+            for (uint32_t lightIdx : mUpdatedLights)
+            {
+                mpBVH->markTrianglesDirty(meshLights[lightIdx].triangleOffset, meshLights[lightIdx].triangleCount);
+            }
+
+            if (mUpdatedLights.empty()) mpBVH->refit(pRenderContext);
+            else mpBVH->refitDirty(pRenderContext, mOptions.buildOptions.refitOnCPU);
+
+            // Refitting keeps the hierarchy, which degrades as lights move apart. Rebuild once the tree cost has increased too much.
+            // The cost is only tracked when refitting on the CPU, as querying it after a GPU refit would stall on reading back the nodes.
+            const float rebuildCostThreshold = mOptions.buildOptions.rebuildCostThreshold;
+            const bool checkCost = mOptions.buildOptions.refitOnCPU && rebuildCostThreshold > 0.f;
+            const float relativeTreeCost = checkCost ? mpBVH->getRelativeTreeCost() : 1.f;
+            if (relativeTreeCost > 1.f + rebuildCostThreshold)
+            {
+                logInfo("LightBVHSampler: Rebuilding the light BVH as refitting increased its cost by {:.1f}%.", (relativeTreeCost - 1.f) * 100.f);
+                mpBVHBuilder->build(pRenderContext, *mpBVH);
+            }
             samplerChanged = true;
         }
+        mUpdatedLights.clear();
 
         return samplerChanged;
     }
@@ -59,6 +235,8 @@ namespace Falcor
         defines.add("_DISABLE_NODE_FLUX", mOptions.disableNodeFlux ? "1" : "0");
         defines.add("_USE_UNIFORM_TRIANGLE_SAMPLING", mOptions.useUniformTriangleSampling ? "1" : "0");
         defines.add("_ACTUAL_MAX_TRIANGLES_PER_NODE", std::to_string(mOptions.buildOptions.maxTriangleCountPerLeaf));
+        defines.add("_BRANCHING_FACTOR", std::to_string(mOptions.buildOptions.branchingFactor));
+        defines.add("_BITMASK_BITS_PER_LEVEL", std::to_string(LightBVHBuilder::getBitmaskBitsPerLevel(mOptions.buildOptions.branchingFactor)));
         defines.add("_SOLID_ANGLE_BOUND_METHOD", std::to_string((uint32_t)mOptions.solidAngleBoundMethod));
 
         return defines;
@@ -122,6 +300,39 @@ namespace Falcor
         }
     }
 
+    void LightBVHSampler::computeTraversalProbabilities(const std::vector<PackedNode>& nodes, const float3& posW, const float3& normalW, bool upperHemisphere, const Options& options, std::vector<float>& nodeProbabilities)
+    {
+        nodeProbabilities.assign(nodes.size(), 0.f);
+        if (nodes.empty()) return;
+
+        nodeProbabilities[0] = 1.f;
+        std::stack<uint32_t> stack({ 0 });
+        while (!stack.empty())
+        {
+            const uint32_t nodeIndex = stack.top();
+            stack.pop();
+            if (nodes[nodeIndex].isLeaf()) continue;
+
+            const InternalNode node = nodes[nodeIndex].getInternalNode();
+            float importances[kMaxLightBVHChildCount];
+            float totalImportance = 0.f;
+            for (uint32_t i = 0; i < node.childCount; ++i)
+            {
+                importances[i] = computeImportance(posW, normalW, upperHemisphere, nodes[node.firstChildIdx + i].getNodeAttributes(), options);
+                totalImportance += importances[i];
+            }
+
+            // If all children have importance being zero, the traversal stops and the subtree is never reached.
+            if (totalImportance == 0.f) continue;
+
+            for (uint32_t i = 0; i < node.childCount; ++i)
+            {
+                nodeProbabilities[node.firstChildIdx + i] = nodeProbabilities[nodeIndex] * importances[i] / totalImportance;
+                stack.push(node.firstChildIdx + i);
+            }
+        }
+    }
+
     LightBVHSampler::LightBVHSampler(RenderContext* pRenderContext, ref<ILightCollection> pLightCollection, const Options& options)
         : EmissiveLightSampler(EmissiveLightSamplerType::LightBVH, std::move(pLightCollection))
         , mOptions(options)
@@ -129,5 +340,23 @@ namespace Falcor
         // Create the BVH and builder.
         mpBVHBuilder = std::make_unique<LightBVHBuilder>(mOptions.buildOptions);
         mpBVH = std::make_unique<LightBVH>(mpDevice, mpLightCollection);
+        connectUpdatedLights();
+    }
+
+    void LightBVHSampler::connectUpdatedLights()
+    {
+        mUpdatedLightsConnection.reset();
+        mUpdatedLights.clear();
+
+        if (mpLightCollection)
+        {
+            // Accumulate the mesh lights that moved, in case the light collection is updated several times between calls to update().
+            mUpdatedLightsConnection = mpLightCollection->getUpdateFlagsSignal().connect([&](ILightCollection::UpdateFlags flags)
+            {
+                if (flags != ILightCollection::UpdateFlags::MatrixChanged) return;
+                const auto& updatedLights = mpLightCollection->getUpdatedLights();
+                mUpdatedLights.insert(mUpdatedLights.end(), updatedLights.begin(), updatedLights.end());
+            });
+        }
     }
 }
@@ -8,6 +8,7 @@
 #include "Utils/Math/AABB.h"
 #include "Scene/Lights/LightCollection.h"
 #include <memory>
+#include <vector>
 
 namespace Falcor
 {
@@ -92,7 +93,20 @@ namespace Falcor
 
         void setOptions(const Options& options);
 
+        /** Compute the probability of the stochastic traversal reaching each node of a light BVH on the CPU.
+            This mirrors the traversal in LightBVHSampler.slang and allows comparing the sampling quality of different trees without a GPU.
+            \param[in] nodes BVH nodes, as produced by LightBVHBuilder::buildNodes().
+            \param[in] posW Shading point in world space.
+            \param[in] normalW Normal at the shading point in world space.
+            \param[in] upperHemisphere True if only upper hemisphere should be considered.
+            \param[in] options Traversal options.
+            \param[out] nodeProbabilities Probability of reaching each node. The probabilities of the leaf nodes sum to one, unless all lights have zero importance.
+        */
+        static void computeTraversalProbabilities(const std::vector<PackedNode>& nodes, const float3& posW, const float3& normalW, bool upperHemisphere, const Options& options, std::vector<float>& nodeProbabilities);
+
     protected:
+        void connectUpdatedLights();
+
         /// Configuration options.
         Options mOptions;
 
@@ -102,5 +116,9 @@ namespace Falcor
 
         /// Trigger rebuild on the next call to update(). We should always build on the first call, so the initial value is true.
         bool mNeedsRebuild = true;
+
+        /// Indices of the mesh lights that moved since the last call to update(). Only their BVH nodes are refit.
+        std::vector<uint32_t> mUpdatedLights;
+        sigs::Connection mUpdatedLightsConnection;
     };
 }
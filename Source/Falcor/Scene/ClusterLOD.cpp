@@ -0,0 +1,418 @@
+#include "ClusterLOD.h"
+#include "Core/Error.h"
+#include "Utils/NumericRange.h"
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <execution>
+#include <optional>
+#include <unordered_map>
+
+namespace Falcor
+{
+    namespace
+    {
+        const float kInfinity = std::numeric_limits<float>::infinity();
+
+        /** Cluster of the current level that is not part of a simplified group yet.
+        */
+        struct PendingCluster
+        {
+            uint32_t clusterIndex;          ///< Index into MeshClusterLOD::clusters.
+            std::vector<uint32_t> indices;  ///< Triangle list of the cluster in mesh vertex indices.
+        };
+
+        /** Clusters built from a triangle list, before they are appended to the DAG.
+        */
+        struct ClusterBatch
+        {
+            std::vector<uint32_t> vertices;
+            std::vector<uint8_t> triangles;
+            std::vector<ClusterLODCluster> clusters;
+            std::vector<std::vector<uint32_t>> indices;
+        };
+
+        /** Compact a triangle list to the vertices it references.
+            Meshoptimizer functions allocate per-vertex data, so groups are processed on their own vertices.
+        */
+        void compactVertices(const std::vector<uint32_t>& indices, const std::vector<float3>& positions,
+            std::vector<uint32_t>& localIndices, std::vector<float3>& localPositions, std::vector<uint32_t>& remap)
+        {
+            remap = indices;
+            std::sort(remap.begin(), remap.end());
+            remap.erase(std::unique(remap.begin(), remap.end()), remap.end());
+
+            localIndices.resize(indices.size());
+            for (size_t i = 0; i < indices.size(); ++i)
+                localIndices[i] = (uint32_t)(std::lower_bound(remap.begin(), remap.end(), indices[i]) - remap.begin());
+
+            localPositions.resize(remap.size());
+            for (size_t i = 0; i < remap.size(); ++i)
+                localPositions[i] = positions[remap[i]];
+        }
+
+        /** Compute a sphere bounding a set of spheres.
+        */
+        ClusterLODBounds mergeBounds(const std::vector<ClusterLODBounds>& bounds)
+        {
+            FALCOR_ASSERT(!bounds.empty());
+            float3 minPoint = bounds[0].center - bounds[0].radius;
+            float3 maxPoint = bounds[0].center + bounds[0].radius;
+            for (const auto& b : bounds)
+            {
+                minPoint = min(minPoint, b.center - b.radius);
+                maxPoint = max(maxPoint, b.center + b.radius);
+            }
+
+            ClusterLODBounds result;
+            result.center = (minPoint + maxPoint) * 0.5f;
+            for (const auto& b : bounds)
+            {
+                result.radius = std::max(result.radius, length(b.center - result.center) + b.radius);
+                result.error = std::max(result.error, b.error);
+            }
+            return result;
+        }
+
+        /** Build clusters from a triangle list given in local vertex indices.
+            \param[in] remap Mapping of local to mesh vertex indices.
+            \param[in] pGroupBounds Bounds of the group that was simplified into the triangle list, or nullptr on level 0.
+        */
+        ClusterBatch buildClusters(const std::vector<uint32_t>& localIndices, const std::vector<float3>& localPositions,
+            const std::vector<uint32_t>& remap, const ClusterLODBuilder::Options& options, uint32_t level, const ClusterLODBounds* pGroupBounds)
+        {
+            size_t maxMeshlets = meshopt_buildMeshletsBound(localIndices.size(), options.maxVerticesPerCluster, options.maxTrianglesPerCluster);
+
+            std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+            std::vector<uint32_t> meshletVertices(maxMeshlets * options.maxVerticesPerCluster);
+            std::vector<uint8_t> meshletTriangles(maxMeshlets * options.maxTrianglesPerCluster * 3);
+
+            size_t meshletCount = meshopt_buildMeshlets(
+                meshlets.data(),
+                meshletVertices.data(),
+                meshletTriangles.data(),
+                localIndices.data(),
+                localIndices.size(),
+                reinterpret_cast<const float*>(localPositions.data()),
+                localPositions.size(),
+                sizeof(float3),
+                options.maxVerticesPerCluster,
+                options.maxTrianglesPerCluster,
+                options.coneWeight);
+
+            ClusterBatch batch;
+            batch.clusters.resize(meshletCount);
+            batch.indices.resize(meshletCount);
+            for (size_t i = 0; i < meshletCount; ++i)
+            {
+                const auto& m = meshlets[i];
+                meshopt_Bounds bounds = meshopt_computeMeshletBounds(
+                    &meshletVertices[m.vertex_offset],
+                    &meshletTriangles[m.triangle_offset],
+                    m.triangle_count,
+                    reinterpret_cast<const float*>(localPositions.data()),
+                    localPositions.size(),
+                    sizeof(float3));
+
+                auto& cluster = batch.clusters[i];
+                cluster.vertexOffset = (uint32_t)batch.vertices.size();
+                cluster.triangleOffset = (uint32_t)batch.triangles.size();
+                cluster.vertexCount = m.vertex_count;
+                cluster.triangleCount = m.triangle_count;
+                cluster.level = level;
+                cluster.boundCenter = float3(bounds.center[0], bounds.center[1], bounds.center[2]);
+                cluster.boundRadius = bounds.radius;
+                cluster.self = pGroupBounds ? *pGroupBounds : ClusterLODBounds{cluster.boundCenter, cluster.boundRadius, 0.f};
+                cluster.parent = ClusterLODBounds{cluster.self.center, cluster.self.radius, kInfinity};
+
+                for (uint32_t v = 0; v < m.vertex_count; ++v)
+                {
+                    const uint32_t localIndex = meshletVertices[m.vertex_offset + v];
+                    batch.vertices.push_back(remap.empty() ? localIndex : remap[localIndex]);
+                }
+                batch.triangles.insert(batch.triangles.end(), meshletTriangles.begin() + m.triangle_offset,
+                    meshletTriangles.begin() + m.triangle_offset + m.triangle_count * 3);
+
+                auto& indices = batch.indices[i];
+                indices.resize(m.triangle_count * 3);
+                for (uint32_t j = 0; j < m.triangle_count * 3; ++j)
+                    indices[j] = batch.vertices[cluster.vertexOffset + batch.triangles[cluster.triangleOffset + j]];
+            }
+            return batch;
+        }
+
+        void appendBatch(MeshClusterLOD& clusterLOD, ClusterBatch&& batch, std::vector<PendingCluster>& pending)
+        {
+            const uint32_t vertexOffset = (uint32_t)clusterLOD.vertices.size();
+            const uint32_t triangleOffset = (uint32_t)clusterLOD.triangles.size();
+            clusterLOD.vertices.insert(clusterLOD.vertices.end(), batch.vertices.begin(), batch.vertices.end());
+            clusterLOD.triangles.insert(clusterLOD.triangles.end(), batch.triangles.begin(), batch.triangles.end());
+
+            for (size_t i = 0; i < batch.clusters.size(); ++i)
+            {
+                auto& cluster = batch.clusters[i];
+                cluster.vertexOffset += vertexOffset;
+                cluster.triangleOffset += triangleOffset;
+                pending.push_back(PendingCluster{(uint32_t)clusterLOD.clusters.size(), std::move(batch.indices[i])});
+                clusterLOD.clusters.push_back(cluster);
+            }
+        }
+
+        uint32_t expandBits(uint32_t v)
+        {
+            v = (v * 0x00010001u) & 0xFF0000FFu;
+            v = (v * 0x00000101u) & 0x0F00F00Fu;
+            v = (v * 0x00000011u) & 0xC30C30C3u;
+            v = (v * 0x00000005u) & 0x49249249u;
+            return v;
+        }
+
+        /** Partition the clusters of a level into groups of adjacent clusters.
+            Groups are grown greedily from seeds in Morton order, adding the neighbor that shares the most vertices with the group.
+        */
+        std::vector<std::vector<uint32_t>> partitionClusters(const std::vector<PendingCluster>& pending,
+            const MeshClusterLOD& clusterLOD, uint32_t groupSize)
+        {
+            const uint32_t clusterCount = (uint32_t)pending.size();
+
+            // Find clusters sharing vertices.
+            std::vector<std::pair<uint32_t, uint32_t>> vertexClusters;
+            for (uint32_t i = 0; i < clusterCount; ++i)
+            {
+                std::vector<uint32_t> vertices = pending[i].indices;
+                std::sort(vertices.begin(), vertices.end());
+                vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+                for (uint32_t v : vertices)
+                    vertexClusters.emplace_back(v, i);
+            }
+            std::sort(vertexClusters.begin(), vertexClusters.end());
+
+            std::vector<std::unordered_map<uint32_t, uint32_t>> adjacency(clusterCount);
+            for (size_t begin = 0, end = 0; begin < vertexClusters.size(); begin = end)
+            {
+                while (end < vertexClusters.size() && vertexClusters[end].first == vertexClusters[begin].first)
+                    ++end;
+                for (size_t a = begin; a < end; ++a)
+                {
+                    for (size_t b = a + 1; b < end; ++b)
+                    {
+                        adjacency[vertexClusters[a].second][vertexClusters[b].second]++;
+                        adjacency[vertexClusters[b].second][vertexClusters[a].second]++;
+                    }
+                }
+            }
+
+            // Order the seeds spatially.
+            float3 minPoint(kInfinity);
+            float3 maxPoint(-kInfinity);
+            for (const auto& p : pending)
+            {
+                minPoint = min(minPoint, clusterLOD.clusters[p.clusterIndex].boundCenter);
+                maxPoint = max(maxPoint, clusterLOD.clusters[p.clusterIndex].boundCenter);
+            }
+            const float3 extent = max(maxPoint - minPoint, float3(1e-20f));
+            std::vector<std::pair<uint32_t, uint32_t>> seeds(clusterCount);
+            for (uint32_t i = 0; i < clusterCount; ++i)
+            {
+                float3 p = (clusterLOD.clusters[pending[i].clusterIndex].boundCenter - minPoint) / extent;
+                uint3 q = uint3(clamp(p * 1023.f, float3(0.f), float3(1023.f)));
+                seeds[i] = {expandBits(q.x) | (expandBits(q.y) << 1) | (expandBits(q.z) << 2), i};
+            }
+            std::sort(seeds.begin(), seeds.end());
+
+            std::vector<std::vector<uint32_t>> groups;
+            std::vector<bool> grouped(clusterCount, false);
+            for (const auto& [code, seed] : seeds)
+            {
+                if (grouped[seed])
+                    continue;
+
+                std::vector<uint32_t> group = {seed};
+                grouped[seed] = true;
+                while (group.size() < groupSize)
+                {
+                    uint32_t best = clusterCount;
+                    uint32_t bestShared = 0;
+                    for (uint32_t member : group)
+                    {
+                        for (const auto& [neighbor, shared] : adjacency[member])
+                        {
+                            if (grouped[neighbor])
+                                continue;
+                            if (shared > bestShared || (shared == bestShared && neighbor < best))
+                            {
+                                best = neighbor;
+                                bestShared = shared;
+                            }
+                        }
+                    }
+                    if (best == clusterCount)
+                        break;
+                    group.push_back(best);
+                    grouped[best] = true;
+                }
+                groups.push_back(std::move(group));
+            }
+            return groups;
+        }
+
+        /** Merge and simplify a group with locked boundary and split the result into clusters.
+            \return The new clusters, or an empty optional if the group could not be simplified enough.
+        */
+        std::optional<ClusterBatch> simplifyGroup(const std::vector<uint32_t>& group, const std::vector<PendingCluster>& pending,
+            const MeshClusterLOD& clusterLOD, const std::vector<float3>& positions, const ClusterLODBuilder::Options& options,
+            uint32_t level, ClusterLODBounds& groupBounds)
+        {
+            std::vector<uint32_t> merged;
+            std::vector<ClusterLODBounds> childBounds;
+            for (uint32_t i : group)
+            {
+                merged.insert(merged.end(), pending[i].indices.begin(), pending[i].indices.end());
+                childBounds.push_back(clusterLOD.clusters[pending[i].clusterIndex].self);
+            }
+
+            std::vector<uint32_t> localIndices;
+            std::vector<float3> localPositions;
+            std::vector<uint32_t> remap;
+            compactVertices(merged, positions, localIndices, localPositions, remap);
+
+            const size_t triangleCount = localIndices.size() / 3;
+            const size_t targetIndexCount = (size_t)((float)triangleCount * options.simplifyRatio) * 3;
+            std::vector<uint32_t> simplified(localIndices.size());
+            float error = 0.f;
+            simplified.resize(meshopt_simplify(
+                simplified.data(),
+                localIndices.data(),
+                localIndices.size(),
+                reinterpret_cast<const float*>(localPositions.data()),
+                localPositions.size(),
+                sizeof(float3),
+                targetIndexCount,
+                std::numeric_limits<float>::max(),
+                meshopt_SimplifyLockBorder,
+                &error));
+
+            if (simplified.empty() || (float)simplified.size() > (float)localIndices.size() * options.maxSimplifyRatio)
+                return std::nullopt;
+
+            // The group error has to be at least the error of its children, so that the cut selection is monotonic.
+            groupBounds = mergeBounds(childBounds);
+            const float scale = meshopt_simplifyScale(reinterpret_cast<const float*>(localPositions.data()), localPositions.size(), sizeof(float3));
+            groupBounds.error = std::max(groupBounds.error, error * scale);
+
+            return buildClusters(simplified, localPositions, remap, options, level, &groupBounds);
+        }
+    }
+
+    MeshClusterLOD ClusterLODBuilder::build(const std::vector<uint32_t>& indices, const std::vector<float3>& positions, const Options& options)
+    {
+        FALCOR_CHECK(indices.size() % 3 == 0, "Index count must be a multiple of 3.");
+        FALCOR_CHECK(options.groupSize > 0, "Group size must be larger than 0.");
+
+        MeshClusterLOD clusterLOD;
+        if (indices.empty() || positions.empty())
+            return clusterLOD;
+
+        std::vector<PendingCluster> pending;
+        appendBatch(clusterLOD, buildClusters(indices, positions, {}, options, 0, nullptr), pending);
+        clusterLOD.levelCount = 1;
+
+        for (uint32_t level = 1; level < options.maxLevelCount && pending.size() > 1; ++level)
+        {
+            const auto groups = partitionClusters(pending, clusterLOD, options.groupSize);
+
+            // Simplify all groups of the level in parallel.
+            std::vector<std::optional<ClusterBatch>> batches(groups.size());
+            std::vector<ClusterLODBounds> groupBounds(groups.size());
+            std::vector<std::exception_ptr> exceptions(groups.size());
+            auto groupRange = NumericRange<size_t>(0, groups.size());
+            std::for_each(
+                std::execution::par,
+                groupRange.begin(),
+                groupRange.end(),
+                [&](size_t i)
+                {
+                    try
+                    {
+                        batches[i] = simplifyGroup(groups[i], pending, clusterLOD, positions, options, level, groupBounds[i]);
+                    }
+                    catch (...)
+                    {
+                        exceptions[i] = std::current_exception();
+                    }
+                }
+            );
+            for (const auto& exception : exceptions)
+            {
+                if (exception)
+                    std::rethrow_exception(exception);
+            }
+
+            // Link the simplified groups to their children. Clusters of groups that could not be simplified are kept for the next level.
+            std::vector<PendingCluster> nextPending;
+            bool simplifiedAny = false;
+            for (size_t i = 0; i < groups.size(); ++i)
+            {
+                if (!batches[i])
+                {
+                    for (uint32_t j : groups[i])
+                        nextPending.push_back(std::move(pending[j]));
+                    continue;
+                }
+
+                for (uint32_t j : groups[i])
+                    clusterLOD.clusters[pending[j].clusterIndex].parent = groupBounds[i];
+                appendBatch(clusterLOD, std::move(*batches[i]), nextPending);
+                simplifiedAny = true;
+            }
+
+            if (!simplifiedAny)
+                break;
+            pending = std::move(nextPending);
+            clusterLOD.levelCount = level + 1;
+        }
+
+        return clusterLOD;
+    }
+
+    float ClusterLODBuilder::computeProjectionScale(float fovY, uint32_t viewportHeight)
+    {
+        return (float)viewportHeight / (2.f * std::tan(fovY * 0.5f));
+    }
+
+    float ClusterLODBuilder::computeProjectedError(const ClusterLODBounds& bounds, const float4x4& worldMatrix, const float3& cameraPosition, float projectionScale)
+    {
+        if (bounds.error == 0.f)
+            return 0.f;
+        if (std::isinf(bounds.error))
+            return kInfinity;
+
+        const float scale = std::max({length(worldMatrix.getCol(0).xyz()), length(worldMatrix.getCol(1).xyz()), length(worldMatrix.getCol(2).xyz())});
+        const float3 center = transformPoint(worldMatrix, bounds.center);
+        const float distance = length(center - cameraPosition) - bounds.radius * scale;
+
+        // The camera is inside the bounds.
+        if (distance <= 0.f)
+            return kInfinity;
+
+        return bounds.error * scale / distance * projectionScale;
+    }
+
+    void ClusterLODBuilder::selectClusters(const MeshClusterLOD& clusterLOD, const float4x4& worldMatrix, const float3& cameraPosition,
+        float projectionScale, float errorThreshold, std::vector<uint32_t>& selected)
+    {
+        selected.clear();
+        for (uint32_t i = 0; i < (uint32_t)clusterLOD.clusters.size(); ++i)
+        {
+            const auto& cluster = clusterLOD.clusters[i];
+            if (computeProjectedError(cluster.self, worldMatrix, cameraPosition, projectionScale) <= errorThreshold &&
+                computeProjectedError(cluster.parent, worldMatrix, cameraPosition, projectionScale) > errorThreshold)
+            {
+                selected.push_back(i);
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Core/Macros.h"
+#include "Utils/Math/Vector.h"
+#include "Utils/Math/Matrix.h"
+
+#include <limits>
+#include <vector>
+
+namespace Falcor
+{
+    /** Bounding sphere of a cluster group together with the simplification error of the group.
+        The error is an object-space distance. Infinite error marks a group that was never simplified.
+     */
+    struct ClusterLODBounds
+    {
+        float3 center = float3(0.f);
+        float radius = 0.f;
+        float error = 0.f;
+    };
+
+    /** A cluster (meshlet) in the cluster LOD DAG.
+     */
+    struct ClusterLODCluster
+    {
+        uint32_t vertexOffset = 0;      ///< Offset into MeshClusterLOD::vertices.
+        uint32_t triangleOffset = 0;    ///< Offset into MeshClusterLOD::triangles.
+        uint32_t vertexCount = 0;
+        uint32_t triangleCount = 0;
+        uint32_t level = 0;             ///< LOD level. Level 0 holds the full resolution mesh.
+        float3 boundCenter = float3(0.f); ///< Object-space bound center of the cluster (for culling).
+        float boundRadius = 0.f;        ///< Object-space bound radius of the cluster (for culling).
+        ClusterLODBounds self;          ///< Bounds and error of the simplification that produced this cluster. Zero error on level 0.
+        ClusterLODBounds parent;        ///< Bounds and error of the simplification of this cluster's group. Infinite error if the cluster is a root.
+    };
+
+    /** Cluster LOD DAG of a single mesh.
+        Clusters of all levels are stored in one list. A view-dependent cut through the DAG selects every cluster
+        whose own error is acceptable while the error of its parent group is not. Since group bounds and errors
+        are monotonic, the selected clusters cover the mesh exactly once without cracks.
+     */
+    struct MeshClusterLOD
+    {
+        std::vector<uint32_t> vertices;             ///< Mesh vertex indices per cluster.
+        std::vector<uint8_t> triangles;             ///< Cluster-local vertex indices (3 per triangle).
+        std::vector<ClusterLODCluster> clusters;    ///< Clusters of all levels.
+        uint32_t levelCount = 0;                    ///< Number of LOD levels.
+    };
+
+    /** CPU builder of cluster LOD DAGs (hierarchical meshlets).
+
+        The builder splits the mesh into meshlets and then repeatedly
+        - partitions the current clusters into groups of adjacent clusters,
+        - merges and simplifies each group while locking the group boundary,
+        - splits the simplified group into new meshlets,
+        until no group can be simplified any further.
+        Locking the group boundaries guarantees that neighboring groups can be drawn at different levels without cracks.
+     */
+    class FALCOR_API ClusterLODBuilder
+    {
+    public:
+        struct Options
+        {
+            uint32_t maxVerticesPerCluster = 64;    ///< Max vertices per cluster.
+            uint32_t maxTrianglesPerCluster = 124;  ///< Max triangles per cluster.
+            float coneWeight = 0.5f;                ///< Cone weight used when building the clusters.
+            uint32_t groupSize = 8;                 ///< Target number of clusters per group.
+            float simplifyRatio = 0.5f;             ///< Target ratio of triangles kept when simplifying a group.
+            float maxSimplifyRatio = 0.85f;         ///< Groups that keep more than this ratio of triangles are not simplified.
+            uint32_t maxLevelCount = 32;            ///< Max number of LOD levels.
+        };
+
+        /** Build the cluster LOD DAG of a mesh.
+            Groups of each level are simplified in parallel.
+            \param[in] indices Triangle list vertex indices.
+            \param[in] positions Vertex positions.
+            \param[in] options Build options.
+            \return The cluster LOD DAG.
+        */
+        static MeshClusterLOD build(const std::vector<uint32_t>& indices, const std::vector<float3>& positions, const Options& options);
+
+        /** Compute the projection scale for a perspective camera.
+            \param[in] fovY Vertical field of view in radians.
+            \param[in] viewportHeight Viewport height in pixels.
+            \return Scale converting a world-space error at unit distance into pixels.
+        */
+        static float computeProjectionScale(float fovY, uint32_t viewportHeight);
+
+        /** Compute the projected screen-space error of a cluster group.
+            The error is computed at the point of the bounding sphere closest to the camera.
+            \param[in] bounds Group bounds and error in object space.
+            \param[in] worldMatrix Object-to-world matrix of the instance.
+            \param[in] cameraPosition World-space camera position.
+            \param[in] projectionScale Projection scale (see computeProjectionScale()).
+            \return The projected error in pixels.
+        */
+        static float computeProjectedError(const ClusterLODBounds& bounds, const float4x4& worldMatrix, const float3& cameraPosition, float projectionScale);
+
+        /** Select the view-dependent cut through the DAG of an instance (CPU reference).
+            \param[in] clusterLOD Cluster LOD DAG of the mesh.
+            \param[in] worldMatrix Object-to-world matrix of the instance.
+            \param[in] cameraPosition World-space camera position.
+            \param[in] projectionScale Projection scale (see computeProjectionScale()).
+            \param[in] errorThreshold Max acceptable projected error in pixels.
+            \param[out] selected Indices of the selected clusters.
+        */
+        static void selectClusters(const MeshClusterLOD& clusterLOD, const float4x4& worldMatrix, const float3& cameraPosition,
+            float projectionScale, float errorThreshold, std::vector<uint32_t>& selected);
+    };
+}
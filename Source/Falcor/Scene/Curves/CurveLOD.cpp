@@ -0,0 +1,367 @@
+#include "CurveLOD.h"
+#include "Core/Error.h"
+#include "Scene/ClusterLOD.h"
+#include "Utils/NumericRange.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kSearchWindow = 32;      ///< Number of strands following a strand in Morton order that are considered for its cluster.
+        const float kOutlierScale = 4.f;        ///< Strands farther than this times the median nearest distance from all candidates are not clustered.
+
+        /** Strand kept as the representative of a cluster, after simplification.
+        */
+        struct ClusterStrand
+        {
+            std::vector<float3> controlPoints;
+            std::vector<float> widths;
+            std::vector<float2> UVs;
+            float error = 0.f;              ///< Max distance of the cluster members to the simplified strand.
+        };
+
+        uint32_t expandBits(uint32_t v)
+        {
+            v = (v * 0x00010001u) & 0xFF0000FFu;
+            v = (v * 0x00000101u) & 0x0F00F00Fu;
+            v = (v * 0x00000011u) & 0xC30C30C3u;
+            v = (v * 0x00000005u) & 0x49249249u;
+            return v;
+        }
+
+        float distanceToSegment(const float3& p, const float3& a, const float3& b)
+        {
+            const float3 ab = b - a;
+            const float lengthSquared = dot(ab, ab);
+            const float t = lengthSquared > 0.f ? std::clamp(dot(p - a, ab) / lengthSquared, 0.f, 1.f) : 0.f;
+            return length(p - (a + t * ab));
+        }
+
+        /** Sample a strand at evenly spaced arc lengths.
+        */
+        void sampleStrand(const float3* controlPoints, uint32_t vertexCount, uint32_t sampleCount, float3* samples)
+        {
+            if (vertexCount == 0)
+            {
+                std::fill(samples, samples + sampleCount, float3(0.f));
+                return;
+            }
+
+            float totalLength = 0.f;
+            for (uint32_t i = 1; i < vertexCount; i++)
+                totalLength += length(controlPoints[i] - controlPoints[i - 1]);
+
+            uint32_t segment = 0;
+            float segmentStart = 0.f;
+            for (uint32_t s = 0; s < sampleCount; s++)
+            {
+                const float target = totalLength * (float)s / (float)(sampleCount - 1);
+                while (segment + 1 < vertexCount)
+                {
+                    const float segmentLength = length(controlPoints[segment + 1] - controlPoints[segment]);
+                    if (segmentStart + segmentLength >= target && segmentLength > 0.f)
+                    {
+                        const float t = std::clamp((target - segmentStart) / segmentLength, 0.f, 1.f);
+                        samples[s] = lerp(controlPoints[segment], controlPoints[segment + 1], t);
+                        break;
+                    }
+                    segmentStart += segmentLength;
+                    segment++;
+                }
+                if (segment + 1 >= vertexCount)
+                    samples[s] = controlPoints[vertexCount - 1];
+            }
+        }
+
+        /** Remove control points of a strand while the deviation from the original stays below the budget.
+            The cost of removing a point is the max distance of the original points between its kept neighbors to the chord
+            connecting them (with half the width difference folded in). Points are removed cheapest first.
+            \return The max deviation of the simplified strand.
+        */
+        float simplifyStrand(ClusterStrand& strand, float budget)
+        {
+            const uint32_t vertexCount = (uint32_t)strand.controlPoints.size();
+            if (vertexCount <= 2)
+                return 0.f;
+
+            const auto& p = strand.controlPoints;
+            const auto& w = strand.widths;
+            std::vector<uint32_t> prev(vertexCount), next(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                prev[i] = i - 1;
+                next[i] = i + 1;
+            }
+
+            auto cost = [&](uint32_t i)
+            {
+                const uint32_t a = prev[i], b = next[i];
+                float deviation = 0.f;
+                for (uint32_t j = a + 1; j < b; j++)
+                {
+                    const float t = (float)(j - a) / (float)(b - a);
+                    const float widthDeviation = 0.5f * std::abs(w[j] - math::lerp(w[a], w[b], t));
+                    deviation = std::max({deviation, distanceToSegment(p[j], p[a], p[b]), widthDeviation});
+                }
+                return deviation;
+            };
+
+            const float kRemoved = std::numeric_limits<float>::infinity();
+            std::vector<float> costs(vertexCount, kRemoved);
+            for (uint32_t i = 1; i + 1 < vertexCount; i++)
+                costs[i] = cost(i);
+
+            float error = 0.f;
+            uint32_t keptCount = vertexCount;
+            while (keptCount > 2)
+            {
+                const uint32_t i = (uint32_t)std::distance(costs.begin(), std::min_element(costs.begin(), costs.end()));
+                if (costs[i] > budget)
+                    break;
+
+                error = std::max(error, costs[i]);
+                costs[i] = kRemoved;
+                next[prev[i]] = next[i];
+                prev[next[i]] = prev[i];
+                if (prev[i] > 0)
+                    costs[prev[i]] = cost(prev[i]);
+                if (next[i] + 1 < vertexCount)
+                    costs[next[i]] = cost(next[i]);
+                keptCount--;
+            }
+
+            ClusterStrand simplified;
+            simplified.error = strand.error;
+            for (uint32_t i = 0; i < vertexCount; i = next[i])
+            {
+                simplified.controlPoints.push_back(p[i]);
+                simplified.widths.push_back(w[i]);
+                if (!strand.UVs.empty())
+                    simplified.UVs.push_back(strand.UVs[i]);
+            }
+            strand = std::move(simplified);
+            return error;
+        }
+
+        /** Build the next coarser level.
+            \return False if the level cannot be reduced any further.
+        */
+        bool buildLevel(const CurveLODLevel& src, const CurveLODBuilder::Options& options, CurveLODLevel& dst)
+        {
+            const uint32_t strandCount = src.getStrandCount();
+            if (strandCount <= options.minStrandCount)
+                return false;
+
+            std::vector<uint32_t> offsets(strandCount);
+            std::exclusive_scan(src.vertexCountsPerStrand.begin(), src.vertexCountsPerStrand.end(), offsets.begin(), 0u);
+
+            // Sample all strands at the same normalized arc lengths so they can be compared point by point.
+            const uint32_t sampleCount = std::max(2u, options.sampleCount);
+            std::vector<float3> samples((size_t)strandCount * sampleCount);
+            std::vector<float> averageWidths(strandCount, 0.f);
+            std::for_each(
+                std::execution::par,
+                NumericRange<uint32_t>(0, strandCount).begin(),
+                NumericRange<uint32_t>(0, strandCount).end(),
+                [&](uint32_t strand)
+                {
+                    const uint32_t vertexCount = src.vertexCountsPerStrand[strand];
+                    sampleStrand(&src.controlPoints[offsets[strand]], vertexCount, sampleCount, &samples[(size_t)strand * sampleCount]);
+                    if (vertexCount > 0)
+                    {
+                        const float* widths = &src.widths[offsets[strand]];
+                        averageWidths[strand] = std::accumulate(widths, widths + vertexCount, 0.f) / (float)vertexCount;
+                    }
+                }
+            );
+
+            // Sort the strands by the Morton code of their roots. Clusters are runs of consecutive strands in this order.
+            AABB rootBounds;
+            for (uint32_t strand = 0; strand < strandCount; strand++)
+                rootBounds.include(samples[(size_t)strand * sampleCount]);
+            const float3 rootExtent = max(rootBounds.extent(), float3(1e-20f));
+
+            std::vector<std::pair<uint32_t, uint32_t>> order(strandCount);
+            for (uint32_t strand = 0; strand < strandCount; strand++)
+            {
+                const float3 q = clamp((samples[(size_t)strand * sampleCount] - rootBounds.minPoint) / rootExtent * 1023.f, float3(0.f), float3(1023.f));
+                const uint32_t code = expandBits((uint32_t)q.x) | (expandBits((uint32_t)q.y) << 1) | (expandBits((uint32_t)q.z) << 2);
+                order[strand] = {code, strand};
+            }
+            std::sort(order.begin(), order.end());
+
+            auto strandDistance = [&](uint32_t a, uint32_t b)
+            {
+                float distance = 0.f;
+                for (uint32_t s = 0; s < sampleCount; s++)
+                    distance = std::max(distance, length(samples[(size_t)a * sampleCount + s] - samples[(size_t)b * sampleCount + s]));
+                return distance;
+            };
+
+            // Strands are only clustered with strands close to them in Morton order. Morton order has large jumps, so strands
+            // that are much farther from their nearest candidate than typical are outliers and stay on their own.
+            std::vector<float> nearest(strandCount, std::numeric_limits<float>::infinity());
+            std::for_each(
+                std::execution::par,
+                NumericRange<uint32_t>(0, strandCount).begin(),
+                NumericRange<uint32_t>(0, strandCount).end(),
+                [&](uint32_t i)
+                {
+                    for (uint32_t j = i + 1; j < std::min(i + kSearchWindow, strandCount); j++)
+                        nearest[i] = std::min(nearest[i], strandDistance(order[i].second, order[j].second));
+                }
+            );
+            std::vector<float> sortedNearest = nearest;
+            auto median = sortedNearest.begin() + strandCount / 2;
+            std::nth_element(sortedNearest.begin(), median, sortedNearest.end());
+            const float maxDistance = kOutlierScale * *median;
+
+            // Grow clusters greedily in Morton order from the closest unassigned candidates.
+            std::vector<std::vector<uint32_t>> clusterMembers;
+            std::vector<bool> assigned(strandCount, false);
+            std::vector<std::pair<float, uint32_t>> candidates;
+            for (uint32_t i = 0; i < strandCount; i++)
+            {
+                if (assigned[i])
+                    continue;
+
+                candidates.clear();
+                for (uint32_t j = i + 1; j < std::min(i + kSearchWindow, strandCount); j++)
+                {
+                    if (assigned[j])
+                        continue;
+                    const float distance = strandDistance(order[i].second, order[j].second);
+                    if (distance <= maxDistance)
+                        candidates.push_back({distance, j});
+                }
+                const size_t candidateCount = std::min(candidates.size(), (size_t)options.clusterSize - 1);
+                std::partial_sort(candidates.begin(), candidates.begin() + candidateCount, candidates.end());
+
+                auto& members = clusterMembers.emplace_back();
+                members.push_back(order[i].second);
+                for (size_t c = 0; c < candidateCount; c++)
+                {
+                    assigned[candidates[c].second] = true;
+                    members.push_back(order[candidates[c].second].second);
+                }
+            }
+
+            const uint32_t clusterCount = (uint32_t)clusterMembers.size();
+            if (clusterCount == strandCount)
+                return false;
+
+            std::vector<ClusterStrand> clusters(clusterCount);
+            std::for_each(
+                std::execution::par,
+                NumericRange<uint32_t>(0, clusterCount).begin(),
+                NumericRange<uint32_t>(0, clusterCount).end(),
+                [&](uint32_t cluster)
+                {
+                    const auto& members = clusterMembers[cluster];
+
+                    // Keep the member with the smallest max distance to the others.
+                    uint32_t representative = members[0];
+                    float clusterError = std::numeric_limits<float>::infinity();
+                    float widthSum = 0.f;
+                    for (uint32_t i : members)
+                    {
+                        float error = 0.f;
+                        for (uint32_t j : members)
+                            error = std::max(error, strandDistance(i, j));
+                        if (error < clusterError)
+                        {
+                            clusterError = error;
+                            representative = i;
+                        }
+                        widthSum += averageWidths[i];
+                    }
+
+                    // Widen the representative to compensate for the removed strands.
+                    const float representativeWidth = averageWidths[representative];
+                    const float widthScale = representativeWidth > 0.f ? std::pow(widthSum / representativeWidth, options.widthCompensation) : 1.f;
+
+                    ClusterStrand& result = clusters[cluster];
+                    const uint32_t offset = offsets[representative];
+                    const uint32_t vertexCount = src.vertexCountsPerStrand[representative];
+                    result.controlPoints.assign(&src.controlPoints[offset], &src.controlPoints[offset] + vertexCount);
+                    result.widths.resize(vertexCount);
+                    for (uint32_t i = 0; i < vertexCount; i++)
+                        result.widths[i] = src.widths[offset + i] * widthScale;
+                    if (!src.UVs.empty())
+                        result.UVs.assign(&src.UVs[offset], &src.UVs[offset] + vertexCount);
+                    result.error = clusterError;
+
+                    // Geometric detail below the cluster error is not worth keeping.
+                    result.error += simplifyStrand(result, clusterError);
+                }
+            );
+
+            std::vector<uint32_t> clusterOffsets(clusterCount + 1, 0);
+            for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+                clusterOffsets[cluster + 1] = clusterOffsets[cluster] + (uint32_t)clusters[cluster].controlPoints.size();
+
+            dst.error = src.error;
+            dst.vertexCountsPerStrand.resize(clusterCount);
+            dst.controlPoints.resize(clusterOffsets.back());
+            dst.widths.resize(clusterOffsets.back());
+            dst.UVs.resize(src.UVs.empty() ? 0 : clusterOffsets.back());
+            for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+            {
+                const ClusterStrand& strand = clusters[cluster];
+                const uint32_t offset = clusterOffsets[cluster];
+                dst.error = std::max(dst.error, src.error + strand.error);
+                dst.vertexCountsPerStrand[cluster] = (uint32_t)strand.controlPoints.size();
+                std::copy(strand.controlPoints.begin(), strand.controlPoints.end(), dst.controlPoints.begin() + offset);
+                std::copy(strand.widths.begin(), strand.widths.end(), dst.widths.begin() + offset);
+                std::copy(strand.UVs.begin(), strand.UVs.end(), dst.UVs.begin() + offset);
+            }
+
+            return true;
+        }
+    }
+
+    std::vector<CurveLODLevel> CurveLODBuilder::build(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, const Options& options)
+    {
+        FALCOR_CHECK(options.clusterSize >= 2, "'clusterSize' ({}) must be at least 2", options.clusterSize);
+
+        std::vector<CurveLODLevel> levels(1);
+        CurveLODLevel& input = levels[0];
+        input.vertexCountsPerStrand.assign(vertexCountsPerStrand, vertexCountsPerStrand + strandCount);
+        const uint32_t vertexCount = std::accumulate(input.vertexCountsPerStrand.begin(), input.vertexCountsPerStrand.end(), 0u);
+        input.controlPoints.assign(controlPoints, controlPoints + vertexCount);
+        input.widths.assign(widths, widths + vertexCount);
+        if (UVs)
+            input.UVs.assign(UVs, UVs + vertexCount);
+
+        while (levels.size() < options.maxLevelCount)
+        {
+            CurveLODLevel level;
+            if (!buildLevel(levels.back(), options, level))
+                break;
+            levels.push_back(std::move(level));
+        }
+
+        return levels;
+    }
+
+    uint32_t CurveLODBuilder::selectLevel(const std::vector<float>& errors, const AABB& bounds, const float4x4& worldMatrix, const float3& cameraPosition,
+        float projectionScale, float errorThreshold)
+    {
+        ClusterLODBounds levelBounds;
+        levelBounds.center = bounds.center();
+        levelBounds.radius = bounds.radius();
+
+        for (uint32_t level = (uint32_t)errors.size(); level-- > 1;)
+        {
+            levelBounds.error = errors[level];
+            if (ClusterLODBuilder::computeProjectedError(levelBounds, worldMatrix, cameraPosition, projectionScale) <= errorThreshold)
+                return level;
+        }
+        return 0;
+    }
+}
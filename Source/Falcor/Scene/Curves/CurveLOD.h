@@ -0,0 +1,69 @@
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include "Utils/Math/Matrix.h"
+#include "Utils/Math/Vector.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** One level of detail of a set of curve strands.
+    */
+    struct CurveLODLevel
+    {
+        float error = 0.f;                              ///< Object-space geometric error relative to the input strands. Zero on level 0.
+        std::vector<uint32_t> vertexCountsPerStrand;    ///< Number of control points per strand.
+        std::vector<float3> controlPoints;              ///< Control points of all strands.
+        std::vector<float> widths;                      ///< Curve widths of all control points.
+        std::vector<float2> UVs;                        ///< Texture coordinates of all control points, or empty if the input has none.
+
+        uint32_t getStrandCount() const { return (uint32_t)vertexCountsPerStrand.size(); }
+    };
+
+    /** CPU builder of view-independent curve LODs (hair and fur strands).
+
+        Each level is built from the previous one by
+        - clustering similar strands with nearby roots (in Morton order) and keeping the strand closest to the rest of its cluster,
+        - widening the kept strand so the cluster keeps about the same coverage,
+        - removing control points of the kept strand while its deviation stays below the cluster error.
+        The deviation of a removed control point from the chord between its kept neighbors grows with the local curvature,
+        so curved sections keep more control points than straight ones.
+        Level 0 holds the input strands unchanged.
+    */
+    class FALCOR_API CurveLODBuilder
+    {
+    public:
+        struct Options
+        {
+            uint32_t maxLevelCount = 4;     ///< Max number of LOD levels, including level 0.
+            uint32_t clusterSize = 2;       ///< Target number of strands per cluster. Each level keeps about 1/clusterSize of the strands of the previous one.
+            uint32_t minStrandCount = 64;   ///< Levels with fewer strands than this are not simplified any further.
+            float widthCompensation = 1.f;  ///< Exponent of the width scale of kept strands. 1 preserves the coverage of non-overlapping strands, 0.5 preserves their cross-section area.
+            uint32_t sampleCount = 8;       ///< Number of arc-length samples used to compare strands.
+        };
+
+        /** Build the LOD levels of a set of strands.
+            Clusters of each level are processed in parallel.
+            \param[in] strandCount Number of curve strands.
+            \param[in] vertexCountsPerStrand Number of control points per strand.
+            \param[in] controlPoints Array of control points.
+            \param[in] widths Array of curve widths.
+            \param[in] UVs Array of texture coordinates. This field is optional.
+            \param[in] options Build options.
+            \return LOD levels ordered from finest to coarsest. The errors are non-decreasing.
+        */
+        static std::vector<CurveLODLevel> build(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, const Options& options);
+
+        /** Select the coarsest level whose projected error is acceptable.
+            \param[in] errors Object-space error of each level, non-decreasing.
+            \param[in] bounds Object-space bounds of the curve.
+            \param[in] worldMatrix Object-to-world matrix of the curve instance.
+            \param[in] cameraPosition World-space camera position.
+            \param[in] projectionScale Projection scale (see ClusterLODBuilder::computeProjectionScale()).
+            \param[in] errorThreshold Max acceptable projected error in pixels.
+            \return The selected level.
+        */
+        static uint32_t selectLevel(const std::vector<float>& errors, const AABB& bounds, const float4x4& worldMatrix, const float3& cameraPosition,
+            float projectionScale, float errorThreshold);
+    };
+}
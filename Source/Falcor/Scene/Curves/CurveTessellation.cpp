@@ -5,7 +5,11 @@
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/Math/Quaternion.h"
+#include "Utils/NumericRange.h"
+#include <algorithm>
 #include <cmath>
+#include <execution>
+#include <numeric>
 
 namespace Falcor
 {
@@ -176,7 +180,7 @@ namespace Falcor
             FALCOR_ASSERT_LT(std::abs(length(t) - 1.f), 1e-3f);
         }
 
-        void updateMeshResultBuffers(CurveTessellation::MeshResult& result, const CurveArrays& curveArrays, StrandArrays& optimizedStrandArrays, const float3& fwd, const float3& s, const float3& t, uint32_t pointCountPerCrossSection, uint32_t j)
+        void updateMeshResultBuffers(CurveTessellation::MeshResult& result, const CurveArrays& curveArrays, StrandArrays& optimizedStrandArrays, const float3& fwd, const float3& s, const float3& t, uint32_t pointCountPerCrossSection, uint32_t meshVertexOffset, uint32_t j)
         {
             // Mesh vertices, normals, tangents, and texCrds (if any).
             for (uint32_t k = 0; k < pointCountPerCrossSection; k++)
@@ -185,33 +189,137 @@ namespace Falcor
                 float3 vNormal = std::cos(phi) * s + std::sin(phi) * t;
 
                 float curveRadius = 0.5f * optimizedStrandArrays.widths[j];
-                result.vertices.push_back(optimizedStrandArrays.controlPoints[j] + curveRadius * vNormal);
-                result.normals.push_back(vNormal);
-                result.tangents.push_back(float4(fwd.x, fwd.y, fwd.z, 1));
-                result.radii.push_back(curveRadius);
+                uint32_t vertexIndex = meshVertexOffset + j * pointCountPerCrossSection + k;
+                result.vertices[vertexIndex] = optimizedStrandArrays.controlPoints[j] + curveRadius * vNormal;
+                result.normals[vertexIndex] = vNormal;
+                result.tangents[vertexIndex] = float4(fwd.x, fwd.y, fwd.z, 1);
+                result.radii[vertexIndex] = curveRadius;
 
                 if (curveArrays.UVs)
                 {
-                    result.texCrds.push_back(optimizedStrandArrays.UVs[j]);
+                    result.texCrds[vertexIndex] = optimizedStrandArrays.UVs[j];
                 }
             }
         }
 
-        void connectFaceVertices(CurveTessellation::MeshResult& result, uint32_t meshVertexOffset, uint32_t pointCountPerCrossSection, uint32_t quadCountLimit, uint32_t nextCrossSectionVertexOffset, uint32_t multiplier, uint32_t j)
+        void connectFaceVertices(CurveTessellation::MeshResult& result, uint32_t meshVertexOffset, uint32_t faceOffset, uint32_t pointCountPerCrossSection, uint32_t quadCountLimit, uint32_t nextCrossSectionVertexOffset, uint32_t multiplier, uint32_t j)
         {
+            uint32_t faceIndex = faceOffset;
             for (uint32_t k = 0; k < quadCountLimit; k++)
             {
-                result.faceVertexCounts.push_back(3);
-                result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + k);
-                result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
-                result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
-
-                result.faceVertexCounts.push_back(3);
-                result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + k);
-                result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
-                result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + k);
+                result.faceVertexCounts[faceIndex] = 3;
+                result.faceVertexIndices[3 * faceIndex + 0] = meshVertexOffset + multiplier * j * pointCountPerCrossSection + k;
+                result.faceVertexIndices[3 * faceIndex + 1] = meshVertexOffset + multiplier * j * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection;
+                result.faceVertexIndices[3 * faceIndex + 2] = meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection;
+                faceIndex++;
+
+                result.faceVertexCounts[faceIndex] = 3;
+                result.faceVertexIndices[3 * faceIndex + 0] = meshVertexOffset + multiplier * j * pointCountPerCrossSection + k;
+                result.faceVertexIndices[3 * faceIndex + 1] = meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection;
+                result.faceVertexIndices[3 * faceIndex + 2] = meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + k;
+                faceIndex++;
             }
         }
+
+        /** Layout of the kept strands in the input and output arrays.
+            The output point count of a strand depends on its number of unique control points, so the layout is computed
+            up front. This lets all strands be tessellated independently into preallocated outputs.
+        */
+        struct StrandLayout
+        {
+            std::vector<uint32_t> strands;          ///< Indices of the kept strands.
+            std::vector<uint32_t> inputOffsets;     ///< Offset of the first control point of each kept strand.
+            std::vector<uint32_t> outputOffsets;    ///< Offset of the first tessellated point of each kept strand (prefix sum, one extra entry).
+            uint32_t maxVertexCountPerStrand = 0;
+        };
+
+        StrandLayout computeStrandLayout(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand)
+        {
+            StrandLayout layout;
+            uint32_t pointOffset = 0;
+            for (uint32_t i = 0; i < strandCount; i++)
+            {
+                if (i % keepOneEveryXStrands == 0)
+                {
+                    layout.strands.push_back(i);
+                    layout.inputOffsets.push_back(pointOffset);
+                    layout.maxVertexCountPerStrand = std::max(layout.maxVertexCountPerStrand, vertexCountsPerStrand[i]);
+                }
+                pointOffset += vertexCountsPerStrand[i];
+            }
+
+            // Count the points after removing duplicated control points, as done in optimizeStrandGeometry().
+            const uint32_t keptStrandCount = (uint32_t)layout.strands.size();
+            layout.outputOffsets.resize(keptStrandCount + 1, 0);
+            auto range = NumericRange<uint32_t>(0, keptStrandCount);
+            std::for_each(
+                std::execution::par,
+                range.begin(),
+                range.end(),
+                [&](uint32_t s)
+                {
+                    const float3* strandPoints = controlPoints + layout.inputOffsets[s];
+                    const uint32_t vertexCount = vertexCountsPerStrand[layout.strands[s]];
+                    uint32_t uniqueCount = 1;
+                    for (uint32_t j = 0; j + 1 < vertexCount; j++)
+                    {
+                        if (any(strandPoints[j] != strandPoints[j + 1])) uniqueCount++;
+                    }
+                    layout.outputOffsets[s] = div_round_up(subdivPerSegment * (uniqueCount - 1), keepOneEveryXVerticesPerStrand) + 1;
+                }
+            );
+            std::exclusive_scan(layout.outputOffsets.begin(), layout.outputOffsets.end(), layout.outputOffsets.begin(), 0u);
+
+            return layout;
+        }
+
+        /** Per-task scratch data, reused for all strands processed by a task.
+        */
+        struct StrandScratch
+        {
+            StrandArrays strandArrays;
+            StrandArrays optimizedStrandArrays;
+            CubicSplineCache splineCache;
+
+            StrandScratch(uint32_t maxVertexCountPerStrand)
+            {
+                strandArrays.controlPoints.reserve(maxVertexCountPerStrand);
+                strandArrays.widths.reserve(maxVertexCountPerStrand);
+                strandArrays.UVs.reserve(maxVertexCountPerStrand);
+            }
+
+            void prepareStrand(const CurveArrays& curveArrays, uint32_t vertexCount, uint32_t pointOffset, uint32_t subdivPerSegment, uint32_t keepOneEveryXVerticesPerStrand, float widthScale)
+            {
+                optimizedStrandArrays.controlPoints.clear();
+                optimizedStrandArrays.UVs.clear();
+                optimizedStrandArrays.widths.clear();
+                optimizedStrandArrays.vertexCount = 0;
+                strandArrays.vertexCount = vertexCount;
+
+                optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+            }
+        };
+
+        /** Run a function on all kept strands in parallel.
+            Strands are processed in blocks; each block owns its scratch data.
+        */
+        template<typename Func>
+        void forEachStrand(const StrandLayout& layout, Func func)
+        {
+            const uint32_t kStrandsPerBlock = 64;
+            const uint32_t strandCount = (uint32_t)layout.strands.size();
+            auto range = NumericRange<uint32_t>(0, div_round_up(strandCount, kStrandsPerBlock));
+            std::for_each(
+                std::execution::par,
+                range.begin(),
+                range.end(),
+                [&](uint32_t block)
+                {
+                    StrandScratch scratch(layout.maxVertexCountPerStrand);
+                    for (uint32_t s = block * kStrandsPerBlock; s < std::min(strandCount, (block + 1) * kStrandsPerBlock); s++) func(scratch, s);
+                }
+            );
+        }
     }
 
     CurveTessellation::SweptSphereResult CurveTessellation::convertToLinearSweptSphere(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t degree, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand, float widthScale, const float4x4& xform)
@@ -223,44 +331,28 @@ namespace Falcor
         FALCOR_ASSERT(degree == 1);
         result.degree = degree;
 
-        uint32_t pointCounts = 0;
-        uint32_t segCounts = 0;
-        uint32_t maxVertexCountsPerStrand = 0;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
-        {
-            uint32_t tmpPointCount = div_round_up(subdivPerSegment * (vertexCountsPerStrand[i] - 1), keepOneEveryXVerticesPerStrand) + 1;
-            pointCounts += tmpPointCount;
-            segCounts += tmpPointCount - 1;
-            maxVertexCountsPerStrand = std::max(maxVertexCountsPerStrand, vertexCountsPerStrand[i]);
-        }
-        result.indices.reserve(segCounts);
-        result.points.reserve(pointCounts);
-        result.radius.reserve(pointCounts);
-        result.texCrds.reserve(pointCounts);
+        const StrandLayout layout = computeStrandLayout(strandCount, vertexCountsPerStrand, controlPoints, subdivPerSegment, keepOneEveryXStrands, keepOneEveryXVerticesPerStrand);
+        const uint32_t pointCounts = layout.outputOffsets.back();
+        const uint32_t segCounts = pointCounts - (uint32_t)layout.strands.size();
+        result.indices.resize(segCounts);
+        result.points.resize(pointCounts);
+        result.radius.resize(pointCounts);
+        if (UVs) result.texCrds.resize(pointCounts);
 
-        uint32_t pointOffset = 0;
-
-        StrandArrays strandArrays;
-        strandArrays.controlPoints.reserve(maxVertexCountsPerStrand);
-        strandArrays.widths.reserve(maxVertexCountsPerStrand);
-        strandArrays.UVs.reserve(maxVertexCountsPerStrand);
         CurveArrays curveArrays(controlPoints, widths, UVs);
 
-        StrandArrays optimizedStrandArrays;
-        CubicSplineCache splineCache;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+        // Each strand writes its own range of the outputs: points at outputOffsets[strand], and one segment per point except the last.
+        forEachStrand(layout, [&](StrandScratch& scratch, uint32_t strand)
         {
-            optimizedStrandArrays.controlPoints.clear();
-            optimizedStrandArrays.UVs.clear();
-            optimizedStrandArrays.widths.clear();
-            optimizedStrandArrays.vertexCount = 0;
-            strandArrays.vertexCount = vertexCountsPerStrand[i];
-
-            optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+            scratch.prepareStrand(curveArrays, vertexCountsPerStrand[layout.strands[strand]], layout.inputOffsets[strand], subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
 
-            const CubicSpline<float3>& splinePoints = splineCache.splinePoints.setup(strandArrays.controlPoints.data(), optimizedStrandArrays.vertexCount);
-            const CubicSpline<float>& splineWidths = splineCache.splineWidths.setup(strandArrays.widths.data(), optimizedStrandArrays.vertexCount);
+            const StrandArrays& strandArrays = scratch.strandArrays;
+            const StrandArrays& optimizedStrandArrays = scratch.optimizedStrandArrays;
+            const CubicSpline<float3>& splinePoints = scratch.splineCache.splinePoints.setup(strandArrays.controlPoints.data(), optimizedStrandArrays.vertexCount);
+            const CubicSpline<float>& splineWidths = scratch.splineCache.splineWidths.setup(strandArrays.widths.data(), optimizedStrandArrays.vertexCount);
 
+            uint32_t pointIndex = layout.outputOffsets[strand];
+            uint32_t segIndex = layout.outputOffsets[strand] - strand;
             uint32_t tmpCount = 0;
             for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
             {
@@ -269,13 +361,14 @@ namespace Falcor
                     if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
                     {
                         float t = (float)k / (float)subdivPerSegment;
-                        result.indices.push_back((uint32_t)result.points.size());
+                        result.indices[segIndex++] = pointIndex;
 
                         // Pre-transform curve points.
                         float4 sph = transformSphere(xform, float4(splinePoints.interpolate(j, t), sanitizeWidth(splineWidths.interpolate(j, t) * 0.5f * widthScale)));
 
-                        result.points.push_back(sph.xyz());
-                        result.radius.push_back(sph.w);
+                        result.points[pointIndex] = sph.xyz();
+                        result.radius[pointIndex] = sph.w;
+                        pointIndex++;
                     }
                     tmpCount++;
                 }
@@ -283,13 +376,16 @@ namespace Falcor
 
             // Always keep the last vertex.
             float4 sph = transformSphere(xform, float4(splinePoints.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f), sanitizeWidth(splineWidths.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f) * 0.5f * widthScale)));
-            result.points.push_back(sph.xyz());
-            result.radius.push_back(sph.w);
+            result.points[pointIndex] = sph.xyz();
+            result.radius[pointIndex] = sph.w;
+            pointIndex++;
+            FALCOR_ASSERT(pointIndex == layout.outputOffsets[strand + 1]);
 
             // Texture coordinates.
             if (UVs)
             {
-                const CubicSpline<float2>& splineUVs = splineCache.splineUVs.setup(strandArrays.UVs.data(), optimizedStrandArrays.vertexCount);
+                const CubicSpline<float2>& splineUVs = scratch.splineCache.splineUVs.setup(strandArrays.UVs.data(), optimizedStrandArrays.vertexCount);
+                uint32_t uvIndex = layout.outputOffsets[strand];
                 tmpCount = 0;
                 for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
                 {
@@ -298,18 +394,16 @@ namespace Falcor
                         if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
                         {
                             float t = (float)k / (float)subdivPerSegment;
-                            result.texCrds.push_back(splineUVs.interpolate(j, t));
+                            result.texCrds[uvIndex++] = splineUVs.interpolate(j, t);
                         }
                         tmpCount++;
                     }
                 }
 
                 // Always keep the last vertex.
-                result.texCrds.push_back(splineUVs.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
+                result.texCrds[uvIndex] = splineUVs.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f);
             }
-
-            for (uint32_t j = i; j < std::min(strandCount, i + keepOneEveryXStrands); j++) pointOffset += vertexCountsPerStrand[j];
-        }
+        });
 
         return result;
     }
@@ -317,47 +411,29 @@ namespace Falcor
     CurveTessellation::MeshResult CurveTessellation::convertToPolytube(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand, float widthScale, uint32_t pointCountPerCrossSection)
     {
         MeshResult result;
-        uint32_t vertexCounts = 0;
-        uint32_t faceCounts = 0;
-        uint32_t maxVertexCountsPerStrand = 0;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
-        {
-            uint32_t tmpPointCount = div_round_up(subdivPerSegment * (vertexCountsPerStrand[i] - 1), keepOneEveryXVerticesPerStrand) + 1;
-            vertexCounts += pointCountPerCrossSection * tmpPointCount;
-            faceCounts += 2 * pointCountPerCrossSection * (tmpPointCount - 1);
-            maxVertexCountsPerStrand = std::max(maxVertexCountsPerStrand, vertexCountsPerStrand[i]);
-        }
-        result.vertices.reserve(vertexCounts);
-        result.normals.reserve(vertexCounts);
-        result.tangents.reserve(vertexCounts);
-        result.texCrds.reserve(vertexCounts);
-        result.radii.reserve(vertexCounts);
-        result.faceVertexCounts.reserve(faceCounts);
-        result.faceVertexIndices.reserve(faceCounts * 3);
-
-        uint32_t pointOffset = 0;
-        uint32_t meshVertexOffset = 0;
-
-        StrandArrays strandArrays;
-        strandArrays.controlPoints.reserve(maxVertexCountsPerStrand);
-        strandArrays.widths.reserve(maxVertexCountsPerStrand);
-        strandArrays.UVs.reserve(maxVertexCountsPerStrand);
-        CurveArrays curveArrays(controlPoints, widths, UVs);
 
-        StrandArrays optimizedStrandArrays;
-        CubicSplineCache splineCache;
-        for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
-        {
-            optimizedStrandArrays.controlPoints.clear();
-            optimizedStrandArrays.UVs.clear();
-            optimizedStrandArrays.widths.clear();
-            optimizedStrandArrays.vertexCount = 0;
+        const StrandLayout layout = computeStrandLayout(strandCount, vertexCountsPerStrand, controlPoints, subdivPerSegment, keepOneEveryXStrands, keepOneEveryXVerticesPerStrand);
+        const uint32_t vertexCounts = pointCountPerCrossSection * layout.outputOffsets.back();
+        const uint32_t faceCounts = 2 * pointCountPerCrossSection * (layout.outputOffsets.back() - (uint32_t)layout.strands.size());
+        result.vertices.resize(vertexCounts);
+        result.normals.resize(vertexCounts);
+        result.tangents.resize(vertexCounts);
+        if (UVs) result.texCrds.resize(vertexCounts);
+        result.radii.resize(vertexCounts);
+        result.faceVertexCounts.resize(faceCounts);
+        result.faceVertexIndices.resize(faceCounts * 3);
 
-            strandArrays.vertexCount = vertexCountsPerStrand[i];
+        CurveArrays curveArrays(controlPoints, widths, UVs);
 
-            optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+        // Each strand writes its own range of the outputs: one cross-section per point and two faces per quad between cross-sections.
+        forEachStrand(layout, [&](StrandScratch& scratch, uint32_t strand)
+        {
+            scratch.prepareStrand(curveArrays, vertexCountsPerStrand[layout.strands[strand]], layout.inputOffsets[strand], subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
 
-            for (uint32_t j = i; j < std::min(strandCount, i + keepOneEveryXStrands); j++) pointOffset += vertexCountsPerStrand[j];
+            StrandArrays& optimizedStrandArrays = scratch.optimizedStrandArrays;
+            FALCOR_ASSERT(optimizedStrandArrays.controlPoints.size() == layout.outputOffsets[strand + 1] - layout.outputOffsets[strand]);
+            const uint32_t meshVertexOffset = pointCountPerCrossSection * layout.outputOffsets[strand];
+            const uint32_t faceOffset = 2 * pointCountPerCrossSection * (layout.outputOffsets[strand] - strand);
 
             // Build the initial frame.
             float3 fwd, s, t;
@@ -372,21 +448,18 @@ namespace Falcor
                 updateCurveFrame(optimizedStrandArrays, fwd, s, t, j);
 
                 // Mesh vertices, normals, tangents, and texCrds (if any).
-                updateMeshResultBuffers(result, curveArrays, optimizedStrandArrays, fwd, s, t, pointCountPerCrossSection, j);
+                updateMeshResultBuffers(result, curveArrays, optimizedStrandArrays, fwd, s, t, pointCountPerCrossSection, meshVertexOffset, j);
 
                 // Mesh faces.
                 if (j < optimizedStrandArrays.controlPoints.size() - 1)
                 {
                     uint32_t quadCountLimit = pointCountPerCrossSection;
-                    connectFaceVertices(result, meshVertexOffset, pointCountPerCrossSection, quadCountLimit, 1, 1, j);
+                    connectFaceVertices(result, meshVertexOffset, faceOffset + 2 * pointCountPerCrossSection * j, pointCountPerCrossSection, quadCountLimit, 1, 1, j);
                 }
             }
-
-            meshVertexOffset += pointCountPerCrossSection * (uint32_t)optimizedStrandArrays.controlPoints.size();
-        }
+        });
 
         return result;
     }
 
-
 }
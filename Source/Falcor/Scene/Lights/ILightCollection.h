@@ -124,6 +124,11 @@ namespace Falcor
         */
         virtual const std::vector<MeshLightData>& getMeshLights() const = 0;
 
+        /** Returns the indices of the mesh lights that were updated by the last call to update().
+            This is valid when the UpdateFlags signal is raised, and allows listeners to only process the lights that changed.
+        */
+        virtual const std::vector<uint32_t>& getUpdatedLights() const = 0;
+
         /** Prepare for syncing the CPU data.
             If the mesh light triangles will be accessed with getMeshLightTriangles()
             performance can be improved by calling this function ahead of time.
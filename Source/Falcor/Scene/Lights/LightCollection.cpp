@@ -60,8 +60,8 @@ namespace Falcor
 
         // Update transform matrices and check for updates.
         // TODO: Move per-mesh instance update flags into Scene. Return just a list of mesh lights that have changed.
-        std::vector<uint32_t> updatedLights;
-        updatedLights.reserve(mMeshLights.size());
+        mUpdatedLights.clear();
+        mUpdatedLights.reserve(mMeshLights.size());
 
         for (uint32_t lightIdx = 0; lightIdx < mMeshLights.size(); ++lightIdx)
         {
@@ -72,14 +72,14 @@ namespace Falcor
             if (mpScene->getAnimationController()->isMatrixChanged(NodeID{ instanceData.globalMatrixID })) updateFlags |= UpdateFlags::MatrixChanged;
 
             // Store update status.
-            if (updateFlags != UpdateFlags::None) updatedLights.push_back(lightIdx);
+            if (updateFlags != UpdateFlags::None) mUpdatedLights.push_back(lightIdx);
             if (pUpdateStatus) pUpdateStatus->lightsUpdateInfo.push_back(updateFlags);
         }
 
         // Update light data if needed.
-        if (!updatedLights.empty())
+        if (!mUpdatedLights.empty())
         {
-            updateTrianglePositions(pRenderContext, *mpScene, updatedLights);
+            updateTrianglePositions(pRenderContext, *mpScene, mUpdatedLights);
             mUpdateFlagsSignal(UpdateFlags::MatrixChanged);
             return true;
         }
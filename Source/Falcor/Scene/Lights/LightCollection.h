@@ -81,6 +81,10 @@ namespace Falcor
         */
         const std::vector<MeshLightData>& getMeshLights() const override { return mMeshLights; }
 
+        /** Returns the indices of the mesh lights that were updated by the last call to update().
+        */
+        const std::vector<uint32_t>& getUpdatedLights() const override { return mUpdatedLights; }
+
         /** Prepare for syncing the CPU data.
             If the mesh light triangles will be accessed with getMeshLightTriangles()
             performance can be improved by calling this function ahead of time.
@@ -126,6 +130,7 @@ namespace Falcor
         Scene*                                  mpScene;                ///< Unowning pointer to scene (scene owns LightCollection).
 
         std::vector<MeshLightData>              mMeshLights;            ///< List of all mesh lights.
+        std::vector<uint32_t>                   mUpdatedLights;         ///< Indices of the mesh lights updated by the last call to update().
         uint32_t                                mTriangleCount = 0;     ///< Total number of triangles in all mesh lights (= mMeshLightTriangles.size()). This may include culled triangles.
 
         mutable std::vector<MeshLightTriangle>  mMeshLightTriangles;    ///< List of all pre-processed mesh light triangles.
@@ -0,0 +1,479 @@
+// This code is based on pbrt:
+// pbrt is Copyright(c) 1998-2020 Matt Pharr, Wenzel Jakob, and Greg Humphreys.
+// The pbrt source code is licensed under the Apache License, Version 2.0.
+// SPDX: Apache-2.0
+
+#include "LoopSubdivide.h"
+#include "Core/Error.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Math/Common.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+#include <cmath>
+
+namespace Falcor
+{
+
+namespace
+{
+constexpr uint32_t kInvalidIndex = uint32_t(-1);
+constexpr size_t kChunkSize = 4096;
+
+/**
+ * Run a function on chunks of the range [0, count) in parallel.
+ */
+template<typename Func>
+void forEachChunk(size_t count, const Func& func)
+{
+    auto range = NumericRange<size_t>(0, div_round_up(count, kChunkSize));
+    std::for_each(
+        std::execution::par,
+        range.begin(),
+        range.end(),
+        [&](size_t chunkIndex)
+        {
+            const size_t begin = chunkIndex * kChunkSize;
+            func(begin, std::min(begin + kChunkSize, count));
+        }
+    );
+}
+
+inline uint32_t next(uint32_t halfEdge)
+{
+    return halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1;
+}
+
+inline uint32_t prev(uint32_t halfEdge)
+{
+    return halfEdge % 3 == 0 ? halfEdge + 2 : halfEdge - 1;
+}
+
+/**
+ * Triangle mesh with index-based half-edge connectivity.
+ * Half-edge 3 * face + i goes from the face's vertex i to vertex (i + 1) % 3.
+ * A vertex is referenced by one of its corners, which is the half-edge leaving the vertex.
+ */
+struct SubdivisionMesh
+{
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;      ///< Vertex indices, three per face.
+    std::vector<uint32_t> twins;        ///< Opposite half-edge per half-edge or kInvalidIndex on the boundary.
+    std::vector<uint32_t> startCorners; ///< Corner per vertex, from which the one-ring is traversed.
+    std::vector<uint8_t> boundary;      ///< True if the vertex is on the boundary.
+
+    uint32_t getVertexCount() const { return (uint32_t)positions.size(); }
+    uint32_t getFaceCount() const { return (uint32_t)indices.size() / 3; }
+
+    /// Corner of the same vertex in the next face around it or kInvalidIndex.
+    uint32_t nextFaceCorner(uint32_t corner) const
+    {
+        uint32_t twin = twins[corner];
+        return twin == kInvalidIndex ? kInvalidIndex : next(twin);
+    }
+
+    /// Corner of the same vertex in the previous face around it or kInvalidIndex.
+    uint32_t prevFaceCorner(uint32_t corner) const { return twins[prev(corner)]; }
+
+    /**
+     * Get the one-ring of a vertex.
+     * Boundary vertices start and end with their neighbors on the boundary.
+     */
+    void oneRing(uint32_t vertex, std::vector<float3>& ring) const
+    {
+        ring.clear();
+        uint32_t c = startCorners[vertex];
+        if (!boundary[vertex])
+        {
+            do
+            {
+                ring.push_back(positions[indices[next(c)]]);
+                c = nextFaceCorner(c);
+            } while (c != startCorners[vertex]);
+        }
+        else
+        {
+            for (uint32_t c2 = nextFaceCorner(c); c2 != kInvalidIndex; c2 = nextFaceCorner(c2))
+                c = c2;
+            ring.push_back(positions[indices[next(c)]]);
+            do
+            {
+                ring.push_back(positions[indices[prev(c)]]);
+                c = prevFaceCorner(c);
+            } while (c != kInvalidIndex);
+        }
+    }
+
+};
+
+inline float beta(uint32_t valence)
+{
+    if (valence == 3)
+        return 3.f / 16.f;
+    else
+        return 3.f / (8.f * valence);
+}
+
+inline float loopGamma(uint32_t valence)
+{
+    return 1.f / (valence + 3.f / (8.f * beta(valence)));
+}
+
+float3 weightOneRing(const float3& p, const std::vector<float3>& ring, float beta)
+{
+    const uint32_t valence = (uint32_t)ring.size();
+    float3 result = (1 - valence * beta) * p;
+    for (uint32_t i = 0; i < valence; ++i)
+    {
+        result += beta * ring[i];
+    }
+    return result;
+}
+
+float3 weightBoundary(const float3& p, const std::vector<float3>& ring, float beta)
+{
+    float3 result = (1 - 2 * beta) * p;
+    result += beta * ring.front();
+    result += beta * ring.back();
+    return result;
+}
+
+SubdivisionMesh createMesh(fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+{
+    SubdivisionMesh mesh;
+    mesh.positions.assign(positions.begin(), positions.end());
+    mesh.indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+
+    const uint32_t vertexCount = mesh.getVertexCount();
+    const uint32_t halfEdgeCount = (uint32_t)mesh.indices.size();
+
+    for (uint32_t index : mesh.indices)
+    {
+        if (index >= vertexCount)
+            FALCOR_THROW("Vertex index {} is out of range. The mesh has {} vertices.", index, vertexCount);
+    }
+
+    // Each vertex starts its one-ring traversal at its last referencing corner.
+    mesh.startCorners.assign(vertexCount, kInvalidIndex);
+    for (uint32_t h = 0; h < halfEdgeCount; ++h)
+        mesh.startCorners[mesh.indices[h]] = h;
+    if (std::find(mesh.startCorners.begin(), mesh.startCorners.end(), kInvalidIndex) != mesh.startCorners.end())
+        FALCOR_THROW("Mesh has vertices that are not referenced by any face.");
+
+    // Pair up the half-edges by sorting them by their undirected edge.
+    // Half-edges of the same edge are paired in face order, so non-manifold edges pair up the same way regardless of thread count.
+    struct EdgeKey
+    {
+        uint64_t edge;
+        uint32_t halfEdge;
+        bool operator<(const EdgeKey& other) const { return edge != other.edge ? edge < other.edge : halfEdge < other.halfEdge; }
+    };
+    std::vector<EdgeKey> edgeKeys(halfEdgeCount);
+    forEachChunk(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
+            {
+                const uint64_t v0 = mesh.indices[h], v1 = mesh.indices[next(h)];
+                edgeKeys[h] = {(std::min(v0, v1) << 32) | std::max(v0, v1), h};
+            }
+        }
+    );
+    std::sort(std::execution::par, edgeKeys.begin(), edgeKeys.end());
+
+    mesh.twins.assign(halfEdgeCount, kInvalidIndex);
+    for (size_t i = 0; i + 1 < edgeKeys.size();)
+    {
+        if (edgeKeys[i].edge == edgeKeys[i + 1].edge)
+        {
+            mesh.twins[edgeKeys[i].halfEdge] = edgeKeys[i + 1].halfEdge;
+            mesh.twins[edgeKeys[i + 1].halfEdge] = edgeKeys[i].halfEdge;
+            i += 2;
+        }
+        else
+        {
+            i += 1;
+        }
+    }
+
+    // A vertex is on the boundary if walking around it hits a boundary edge.
+    mesh.boundary.resize(vertexCount);
+    forEachChunk(
+        vertexCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
+            {
+                uint32_t c = mesh.startCorners[v];
+                do
+                {
+                    c = mesh.nextFaceCorner(c);
+                } while (c != kInvalidIndex && c != mesh.startCorners[v]);
+                mesh.boundary[v] = c == kInvalidIndex;
+            }
+        }
+    );
+
+    return mesh;
+}
+
+/**
+ * Apply one level of Loop subdivision.
+ * Each face is split into four, with the child faces ordered as (corner 0, corner 1, corner 2, center).
+ * The even vertices keep their indices and the odd (edge) vertices are appended in the order their edges are first referenced.
+ */
+SubdivisionMesh subdivide(const SubdivisionMesh& mesh)
+{
+    const uint32_t vertexCount = mesh.getVertexCount();
+    const uint32_t faceCount = mesh.getFaceCount();
+    const uint32_t halfEdgeCount = faceCount * 3;
+
+    // Each edge is owned by its first half-edge. Assign edge vertex indices in half-edge order.
+    auto isEdgeOwner = [&](uint32_t h) { return mesh.twins[h] == kInvalidIndex || mesh.twins[h] > h; };
+    std::vector<uint32_t> edgeOwners(halfEdgeCount);
+    forEachChunk(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
+                edgeOwners[h] = isEdgeOwner(h) ? 1 : 0;
+        }
+    );
+    std::vector<uint32_t> edgeVertices(halfEdgeCount);
+    std::exclusive_scan(std::execution::par, edgeOwners.begin(), edgeOwners.end(), edgeVertices.begin(), vertexCount);
+    const uint32_t newVertexCount =
+        halfEdgeCount > 0 ? edgeVertices.back() + (isEdgeOwner(halfEdgeCount - 1) ? 1 : 0) : vertexCount;
+    forEachChunk(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
+            {
+                if (!isEdgeOwner(h))
+                    edgeVertices[h] = edgeVertices[mesh.twins[h]];
+            }
+        }
+    );
+
+    SubdivisionMesh result;
+    result.positions.resize(newVertexCount);
+    result.startCorners.resize(newVertexCount);
+    result.boundary.resize(newVertexCount);
+    result.indices.resize(halfEdgeCount * 4);
+    result.twins.resize(halfEdgeCount * 4);
+
+    // Update vertex positions for even vertices.
+    forEachChunk(
+        vertexCount,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<float3> ring;
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
+            {
+                mesh.oneRing(v, ring);
+                if (!mesh.boundary[v])
+                {
+                    // Apply one-ring rule for even vertex.
+                    result.positions[v] = weightOneRing(mesh.positions[v], ring, beta((uint32_t)ring.size()));
+                }
+                else
+                {
+                    // Apply boundary rule for even vertex.
+                    result.positions[v] = weightBoundary(mesh.positions[v], ring, 1.f / 8.f);
+                }
+
+                const uint32_t corner = mesh.startCorners[v];
+                result.startCorners[v] = 3 * (4 * (corner / 3) + corner % 3) + corner % 3;
+                result.boundary[v] = mesh.boundary[v];
+            }
+        }
+    );
+
+    // Compute new odd edge vertices.
+    forEachChunk(
+        halfEdgeCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t h = (uint32_t)begin; h < (uint32_t)end; ++h)
+            {
+                if (!isEdgeOwner(h))
+                    continue;
+
+                const uint32_t twin = mesh.twins[h];
+                const uint32_t v0 = std::min(mesh.indices[h], mesh.indices[next(h)]);
+                const uint32_t v1 = std::max(mesh.indices[h], mesh.indices[next(h)]);
+                float3 p;
+                if (twin == kInvalidIndex)
+                {
+                    p = 0.5f * mesh.positions[v0];
+                    p += 0.5f * mesh.positions[v1];
+                }
+                else
+                {
+                    p = 3.f / 8.f * mesh.positions[v0];
+                    p += 3.f / 8.f * mesh.positions[v1];
+                    p += 1.f / 8.f * mesh.positions[mesh.indices[prev(h)]];
+                    p += 1.f / 8.f * mesh.positions[mesh.indices[prev(twin)]];
+                }
+
+                const uint32_t v = edgeVertices[h];
+                result.positions[v] = p;
+                result.startCorners[v] = 3 * (4 * (h / 3) + 3) + h % 3;
+                result.boundary[v] = twin == kInvalidIndex;
+            }
+        }
+    );
+
+    // Update new mesh topology.
+    forEachChunk(
+        faceCount,
+        [&](size_t begin, size_t end)
+        {
+            for (uint32_t f = (uint32_t)begin; f < (uint32_t)end; ++f)
+            {
+                const uint32_t center = 4 * f + 3;
+                for (uint32_t j = 0; j < 3; ++j)
+                {
+                    const uint32_t child = 4 * f + j;
+                    const uint32_t nextJ = (j + 1) % 3;
+                    const uint32_t prevJ = (j + 2) % 3;
+
+                    // Update child vertices.
+                    result.indices[3 * child + j] = mesh.indices[3 * f + j];
+                    result.indices[3 * child + nextJ] = edgeVertices[3 * f + j];
+                    result.indices[3 * child + prevJ] = edgeVertices[3 * f + prevJ];
+                    result.indices[3 * center + j] = edgeVertices[3 * f + j];
+
+                    // Update twins between siblings.
+                    result.twins[3 * center + j] = 3 * (4 * f + nextJ) + prevJ;
+                    result.twins[3 * child + nextJ] = 3 * center + prevJ;
+
+                    // Update twins to children of neighbors.
+                    const uint32_t twin = mesh.twins[3 * f + j];
+                    if (twin != kInvalidIndex)
+                    {
+                        const uint32_t c = (twin + 1) % 3;
+                        result.twins[3 * child + j] = 3 * (4 * (twin / 3) + c) + (c + 2) % 3;
+                    }
+                    else
+                    {
+                        result.twins[3 * child + j] = kInvalidIndex;
+                    }
+                    const uint32_t prevTwin = mesh.twins[3 * f + prevJ];
+                    if (prevTwin != kInvalidIndex)
+                    {
+                        const uint32_t c = prevTwin % 3;
+                        result.twins[3 * child + prevJ] = 3 * (4 * (prevTwin / 3) + c) + c;
+                    }
+                    else
+                    {
+                        result.twins[3 * child + prevJ] = kInvalidIndex;
+                    }
+                }
+            }
+        }
+    );
+
+    return result;
+}
+} // namespace
+
+LoopSubdivideResult loopSubdivide(uint32_t levels, fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+{
+    SubdivisionMesh mesh = createMesh(positions, indices);
+
+    // Refine LoopSubdiv into triangles.
+    for (uint32_t i = 0; i < levels; ++i)
+    {
+        mesh = subdivide(mesh);
+    }
+
+    const uint32_t vertexCount = mesh.getVertexCount();
+
+    // Push vertices to limit surface.
+    std::vector<float3> pLimit(vertexCount);
+    forEachChunk(
+        vertexCount,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<float3> ring;
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
+            {
+                mesh.oneRing(v, ring);
+                if (mesh.boundary[v])
+                    pLimit[v] = weightBoundary(mesh.positions[v], ring, 1.f / 5.f);
+                else
+                    pLimit[v] = weightOneRing(mesh.positions[v], ring, loopGamma((uint32_t)ring.size()));
+            }
+        }
+    );
+    mesh.positions.swap(pLimit);
+
+    // Compute vertex tangents on limit surface.
+    std::vector<float3> Ns(vertexCount);
+    forEachChunk(
+        vertexCount,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<float3> pRing;
+            for (uint32_t v = (uint32_t)begin; v < (uint32_t)end; ++v)
+            {
+                float3 S(0.f);
+                float3 T(0.f);
+                mesh.oneRing(v, pRing);
+                const uint32_t valence = (uint32_t)pRing.size();
+                const float3& p = mesh.positions[v];
+                if (!mesh.boundary[v])
+                {
+                    // Compute tangents of interior face
+                    for (uint32_t j = 0; j < valence; ++j)
+                    {
+                        S += std::cos(2.f * float(M_PI) * j / valence) * float3(pRing[j]);
+                        T += std::sin(2.f * float(M_PI) * j / valence) * float3(pRing[j]);
+                    }
+                }
+                else
+                {
+                    // Compute tangents of boundary face
+                    S = pRing[valence - 1] - pRing[0];
+                    if (valence == 2)
+                    {
+                        T = float3(pRing[0] + pRing[1] - 2.f * p);
+                    }
+                    else if (valence == 3)
+                    {
+                        T = pRing[1] - p;
+                    }
+                    else if (valence == 4) // regular
+                    {
+                        T = float3(-1.f * pRing[0] + 2.f * pRing[1] + 2.f * pRing[2] + -1.f * pRing[3] + -2.f * p);
+                    }
+                    else
+                    {
+                        float theta = float(M_PI) / float(valence - 1);
+                        T = float3(std::sin(theta) * (pRing[0] + pRing[valence - 1]));
+                        for (uint32_t k = 1; k < valence - 1; ++k)
+                        {
+                            float wt = (2 * std::cos(theta) - 2) * std::sin((k)*theta);
+                            T += float3(wt * pRing[k]);
+                        }
+                        T = -T;
+                    }
+                }
+                Ns[v] = cross(S, T);
+            }
+        }
+    );
+
+    // Create triangle mesh from subdivision mesh
+    LoopSubdivideResult result;
+    result.positions = std::move(mesh.positions);
+    result.normals = std::move(Ns);
+    result.indices = std::move(mesh.indices);
+    return result;
+}
+
+} // namespace Falcor
@@ -11,7 +11,15 @@ namespace Falcor
 
     MaterialTextureLoader::~MaterialTextureLoader()
     {
-        assignTextures();
+        // Errors from background loading must not escape the destructor. Call finishLoading() first to have them rethrown.
+        try
+        {
+            assignTextures();
+        }
+        catch (const std::exception& e)
+        {
+            logError("MaterialTextureLoader: Failed to load material textures: {}", e.what());
+        }
     }
 
     void MaterialTextureLoader::loadTexture(const ref<Material>& pMaterial, Material::TextureSlot slot, const std::filesystem::path& path)
@@ -25,6 +33,15 @@ namespace Falcor
 
         bool srgb = mUseSrgb && pMaterial->getTextureSlotInfo(slot).srgb;
 
+        // Queue textures using the texture manager's deferred loading, so they are loaded in parallel later.
+        // A running background load has to finish first, as it is not synchronized with new requests.
+        if (!mQueueOpen)
+        {
+            waitForLoading();
+            mTextureManager.beginDeferredLoading();
+            mQueueOpen = true;
+        }
+
         // Request texture to be loaded.
         auto handle = mTextureManager.loadTexture(
             path,
@@ -42,8 +59,25 @@ namespace Falcor
         mTextureAssignments.emplace_back(TextureAssignment{ pMaterial, slot, handle });
     }
 
+    void MaterialTextureLoader::startLoading()
+    {
+        if (!mQueueOpen)
+            return;
+
+        mQueueOpen = false;
+        mLoading = std::async(std::launch::async, [this]() { mTextureManager.endDeferredLoading(); });
+    }
+
+    void MaterialTextureLoader::waitForLoading()
+    {
+        if (mLoading.valid())
+            mLoading.get();
+    }
+
     void MaterialTextureLoader::assignTextures()
     {
+        startLoading();
+        waitForLoading();
         mTextureManager.waitForAllTexturesLoading();
 
         // Assign textures to materials.
@@ -3,6 +3,7 @@
 #include "Scene/Material/Material.h"
 #include "Utils/Image/TextureManager.h"
 #include <filesystem>
+#include <future>
 #include <vector>
 
 namespace Falcor
@@ -10,10 +11,12 @@ namespace Falcor
     /** Helper class to load material textures using the texture manager.
 
         Calling `loadTexture` does not assign the texture to the material right away.
-        Instead, an asynchronous texture load request is issued and a reference for the
-        material assignment is stored. When the client destroys the instance of the
-        `MaterialTextureLoader`, it blocks until all textures are loaded and assigns
-        them to the materials.
+        Instead, the texture is queued for loading and a reference for the material
+        assignment is stored. Queued textures are loaded in parallel, either in the
+        background after calling `startLoading`, or when the textures are assigned.
+        When the client destroys the instance of the `MaterialTextureLoader`, it blocks
+        until all textures are loaded and assigns them to the materials. Call `finishLoading`
+        before destroying it to have loading errors reported as exceptions.
     */
     class FALCOR_API MaterialTextureLoader
     {
@@ -28,12 +31,22 @@ namespace Falcor
         */
         void loadTexture(const ref<Material>& pMaterial, Material::TextureSlot slot, const std::filesystem::path& path);
 
+        /** Start loading the queued textures in the background.
+            No other GPU operations may be executed until the textures are assigned,
+            as textures are uploaded to the GPU while they are loaded.
+        */
+        void startLoading();
+
+        /** Wait for the queued textures to load and assign them to the materials.
+            Errors from loading in the background are rethrown here, whereas the destructor only logs them.
+        */
         void finishLoading()
         {
             assignTextures();
         }
     private:
         void assignTextures();
+        void waitForLoading();
 
         struct TextureAssignment
         {
@@ -45,5 +58,7 @@ namespace Falcor
         bool mUseSrgb;
         std::vector<TextureAssignment> mTextureAssignments;
         TextureManager& mTextureManager;
+        bool mQueueOpen = false;        ///< True if textures are queued with the texture manager's deferred loading.
+        std::future<void> mLoading;     ///< Background loading started by startLoading().
     };
 }
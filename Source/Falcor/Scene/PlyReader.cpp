@@ -0,0 +1,520 @@
+#include "PlyReader.h"
+#include "Core/Error.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Math/Common.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <execution>
+#include <string>
+#include <string_view>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Records are converted in chunks of this many elements.
+        const size_t kChunkSize = 1 << 16;
+
+        enum class ScalarType
+        {
+            Int8,
+            UInt8,
+            Int16,
+            UInt16,
+            Int32,
+            UInt32,
+            Float32,
+            Float64,
+        };
+
+        struct ScalarTypeDesc
+        {
+            std::string_view name;
+            std::string_view altName;
+            ScalarType type;
+            size_t size;
+        };
+
+        const ScalarTypeDesc kScalarTypes[] =
+        {
+            { "char", "int8", ScalarType::Int8, 1 },
+            { "uchar", "uint8", ScalarType::UInt8, 1 },
+            { "short", "int16", ScalarType::Int16, 2 },
+            { "ushort", "uint16", ScalarType::UInt16, 2 },
+            { "int", "int32", ScalarType::Int32, 4 },
+            { "uint", "uint32", ScalarType::UInt32, 4 },
+            { "float", "float32", ScalarType::Float32, 4 },
+            { "double", "float64", ScalarType::Float64, 8 },
+        };
+
+        struct Property
+        {
+            std::string name;
+            ScalarType type = ScalarType::Float32;  ///< Value type. For list properties, this is the type of the list items.
+            size_t size = 0;                        ///< Size of the value type in bytes.
+            bool isList = false;
+            ScalarType countType = ScalarType::UInt8;
+            size_t countSize = 0;
+        };
+
+        struct Element
+        {
+            std::string name;
+            size_t count = 0;
+            std::vector<Property> properties;
+        };
+
+        struct Header
+        {
+            bool isBigEndian = false;
+            std::vector<Element> elements;
+            size_t dataOffset = 0;
+        };
+
+        /** Calls func(begin, end) for each chunk of kChunkSize elements in [0, count) on multiple threads.
+        */
+        template<typename Func>
+        void forEachChunk(size_t count, const Func& func)
+        {
+            auto range = NumericRange<size_t>(0, div_round_up(count, kChunkSize));
+            std::for_each(std::execution::par, range.begin(), range.end(), [&](size_t chunkIndex)
+            {
+                const size_t begin = chunkIndex * kChunkSize;
+                func(begin, std::min(begin + kChunkSize, count));
+            });
+        }
+
+        bool parseScalarType(std::string_view name, ScalarType& type, size_t& size)
+        {
+            for (const auto& desc : kScalarTypes)
+            {
+                if (name == desc.name || name == desc.altName)
+                {
+                    type = desc.type;
+                    size = desc.size;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool isIntegerType(ScalarType type)
+        {
+            return type != ScalarType::Float32 && type != ScalarType::Float64;
+        }
+
+        std::vector<std::string_view> splitTokens(std::string_view line)
+        {
+            std::vector<std::string_view> tokens;
+            size_t pos = 0;
+            while (true)
+            {
+                pos = line.find_first_not_of(" \t", pos);
+                if (pos == std::string_view::npos) break;
+                size_t end = std::min(line.find_first_of(" \t", pos), line.size());
+                tokens.push_back(line.substr(pos, end - pos));
+                pos = end;
+            }
+            return tokens;
+        }
+
+        bool parseHeader(const uint8_t* pData, size_t size, Header& header)
+        {
+            std::string_view text(reinterpret_cast<const char*>(pData), size);
+            bool hasFormat = false;
+            size_t pos = 0;
+            for (size_t lineIdx = 0;; ++lineIdx)
+            {
+                size_t end = text.find('\n', pos);
+                if (end == std::string_view::npos) return false;
+                std::string_view line = text.substr(pos, end - pos);
+                pos = end + 1;
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+                auto tokens = splitTokens(line);
+                if (lineIdx == 0)
+                {
+                    if (tokens.size() != 1 || tokens[0] != "ply") return false;
+                    continue;
+                }
+                if (tokens.empty() || tokens[0] == "comment" || tokens[0] == "obj_info") continue;
+
+                if (tokens[0] == "format")
+                {
+                    // ASCII files are left to the fallback importer.
+                    if (tokens.size() < 2) return false;
+                    if (tokens[1] == "binary_little_endian") header.isBigEndian = false;
+                    else if (tokens[1] == "binary_big_endian") header.isBigEndian = true;
+                    else return false;
+                    hasFormat = true;
+                }
+                else if (tokens[0] == "element")
+                {
+                    if (tokens.size() != 3) return false;
+                    Element element;
+                    element.name = tokens[1];
+                    auto result = std::from_chars(tokens[2].data(), tokens[2].data() + tokens[2].size(), element.count);
+                    if (result.ec != std::errc() || result.ptr != tokens[2].data() + tokens[2].size()) return false;
+                    header.elements.push_back(std::move(element));
+                }
+                else if (tokens[0] == "property")
+                {
+                    if (header.elements.empty()) return false;
+                    Property property;
+                    if (tokens.size() == 5 && tokens[1] == "list")
+                    {
+                        property.isList = true;
+                        if (!parseScalarType(tokens[2], property.countType, property.countSize) || !isIntegerType(property.countType)) return false;
+                        if (!parseScalarType(tokens[3], property.type, property.size)) return false;
+                        property.name = tokens[4];
+                    }
+                    else if (tokens.size() == 3)
+                    {
+                        if (!parseScalarType(tokens[1], property.type, property.size)) return false;
+                        property.name = tokens[2];
+                    }
+                    else return false;
+                    header.elements.back().properties.push_back(std::move(property));
+                }
+                else if (tokens[0] == "end_header")
+                {
+                    header.dataOffset = pos;
+                    return hasFormat;
+                }
+                else return false;
+            }
+        }
+
+        template<typename T>
+        T byteSwap(T value)
+        {
+            uint8_t bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            std::reverse(bytes, bytes + sizeof(T));
+            std::memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+
+        template<typename T, bool kSwap>
+        T load(const uint8_t* p)
+        {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            if constexpr (kSwap) value = byteSwap(value);
+            return value;
+        }
+
+        /** Loads a scalar of the given type and converts it to T.
+            Negative integers converted to unsigned types wrap around, which makes them fail range checks.
+        */
+        template<typename T, bool kSwap>
+        T loadScalar(const uint8_t* p, ScalarType type)
+        {
+            switch (type)
+            {
+            case ScalarType::Int8: return (T)load<int8_t, kSwap>(p);
+            case ScalarType::UInt8: return (T)load<uint8_t, kSwap>(p);
+            case ScalarType::Int16: return (T)load<int16_t, kSwap>(p);
+            case ScalarType::UInt16: return (T)load<uint16_t, kSwap>(p);
+            case ScalarType::Int32: return (T)load<int32_t, kSwap>(p);
+            case ScalarType::UInt32: return (T)load<uint32_t, kSwap>(p);
+            case ScalarType::Float32: return (T)load<float, kSwap>(p);
+            case ScalarType::Float64: return (T)load<double, kSwap>(p);
+            }
+            FALCOR_UNREACHABLE();
+        }
+
+        /** Returns the record size of an element without list properties, or 0 if the element has list properties.
+        */
+        size_t getFixedStride(const Element& element)
+        {
+            size_t stride = 0;
+            for (const auto& property : element.properties)
+            {
+                if (property.isList) return 0;
+                stride += property.size;
+            }
+            return stride;
+        }
+
+        /** Location of a scalar property within a fixed-size record.
+        */
+        struct Attribute
+        {
+            size_t offset = 0;
+            ScalarType type = ScalarType::Float32;
+        };
+
+        bool findAttribute(const Element& element, std::string_view name, Attribute& attribute)
+        {
+            size_t offset = 0;
+            for (const auto& property : element.properties)
+            {
+                if (property.name == name)
+                {
+                    attribute = { offset, property.type };
+                    return true;
+                }
+                offset += property.size;
+            }
+            return false;
+        }
+
+        template<bool kSwap, typename VecT, size_t N>
+        void convertAttribute(const uint8_t* pData, size_t count, size_t stride, const Attribute (&attributes)[N], std::vector<VecT>& output)
+        {
+            output.resize(count);
+            const bool isFloat = std::all_of(attributes, attributes + N, [](const Attribute& a) { return a.type == ScalarType::Float32; });
+            forEachChunk(count, [&](size_t begin, size_t end)
+            {
+                // Most files store single-precision attributes, which get a dedicated loop.
+                if (isFloat)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const uint8_t* pRecord = pData + i * stride;
+                        for (size_t c = 0; c < N; ++c) output[i][c] = load<float, kSwap>(pRecord + attributes[c].offset);
+                    }
+                }
+                else
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const uint8_t* pRecord = pData + i * stride;
+                        for (size_t c = 0; c < N; ++c) output[i][c] = loadScalar<float, kSwap>(pRecord + attributes[c].offset, attributes[c].type);
+                    }
+                }
+            });
+        }
+
+        template<bool kSwap>
+        bool readVertices(const Element& element, const uint8_t*& p, const uint8_t* pEnd, PlyReader::Mesh& mesh)
+        {
+            const size_t stride = getFixedStride(element);
+            if (stride == 0 || element.count > (size_t)(pEnd - p) / stride) return false;
+            if (element.count > std::numeric_limits<uint32_t>::max()) return false;
+
+            Attribute position[3];
+            if (!findAttribute(element, "x", position[0]) || !findAttribute(element, "y", position[1]) || !findAttribute(element, "z", position[2])) return false;
+            convertAttribute<kSwap>(p, element.count, stride, position, mesh.positions);
+
+            Attribute normal[3];
+            if (findAttribute(element, "nx", normal[0]) && findAttribute(element, "ny", normal[1]) && findAttribute(element, "nz", normal[2]))
+            {
+                convertAttribute<kSwap>(p, element.count, stride, normal, mesh.normals);
+            }
+
+            static const std::string_view kTexCoordNames[][2] =
+            {
+                { "u", "v" },
+                { "s", "t" },
+                { "texture_u", "texture_v" },
+                { "texture_s", "texture_t" },
+            };
+            for (const auto& names : kTexCoordNames)
+            {
+                Attribute texCoord[2];
+                if (findAttribute(element, names[0], texCoord[0]) && findAttribute(element, names[1], texCoord[1]))
+                {
+                    convertAttribute<kSwap>(p, element.count, stride, texCoord, mesh.texCoords);
+                    break;
+                }
+            }
+
+            p += element.count * stride;
+            return true;
+        }
+
+        template<bool kSwap>
+        bool readFaces(const Element& element, const uint8_t*& p, const uint8_t* pEnd, PlyReader::Mesh& mesh)
+        {
+            // Faces have a single list of vertex indices. Other scalar properties (e.g. pbrt's face_indices) are skipped.
+            const Property* pList = nullptr;
+            size_t bytesBefore = 0;
+            size_t bytesAfter = 0;
+            for (const auto& property : element.properties)
+            {
+                if (property.isList)
+                {
+                    if (pList || (property.name != "vertex_indices" && property.name != "vertex_index")) return false;
+                    pList = &property;
+                }
+                else (pList ? bytesAfter : bytesBefore) += property.size;
+            }
+            if (!pList || !isIntegerType(pList->type)) return false;
+
+            const size_t faceCount = element.count;
+            const size_t countSize = pList->countSize;
+            const size_t indexSize = pList->size;
+            const ScalarType countType = pList->countType;
+            const ScalarType indexType = pList->type;
+            auto loadCount = [&](const uint8_t* pRecord) { return loadScalar<size_t, kSwap>(pRecord + bytesBefore, countType); };
+            auto loadIndex = [&](const uint8_t* pIndices, size_t i) { return loadScalar<uint32_t, kSwap>(pIndices + i * indexSize, indexType); };
+
+            mesh.indices.clear();
+            if (faceCount == 0) return true;
+
+            // Fast path: If all faces have the same number of vertices, the records are fixed-size and can be converted in parallel.
+            if ((size_t)(pEnd - p) >= bytesBefore + countSize)
+            {
+                const size_t faceVertexCount = loadCount(p);
+                const size_t maxFaceVertexCount = ((size_t)(pEnd - p) - bytesBefore - countSize) / indexSize;
+                if (faceVertexCount >= 3 && faceVertexCount <= maxFaceVertexCount)
+                {
+                    const size_t stride = bytesBefore + countSize + faceVertexCount * indexSize + bytesAfter;
+                    if (faceCount <= (size_t)(pEnd - p) / stride)
+                    {
+                        std::atomic<bool> isUniform = true;
+                        forEachChunk(faceCount, [&](size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                if (loadCount(p + i * stride) != faceVertexCount)
+                                {
+                                    isUniform = false;
+                                    break;
+                                }
+                            }
+                        });
+
+                        if (isUniform)
+                        {
+                            const size_t trianglesPerFace = faceVertexCount - 2;
+                            mesh.indices.resize(faceCount * trianglesPerFace * 3);
+                            forEachChunk(faceCount, [&](size_t begin, size_t end)
+                            {
+                                for (size_t i = begin; i < end; ++i)
+                                {
+                                    const uint8_t* pIndices = p + i * stride + bytesBefore + countSize;
+                                    uint32_t* pOutput = mesh.indices.data() + i * trianglesPerFace * 3;
+                                    const uint32_t i0 = loadIndex(pIndices, 0);
+                                    uint32_t i1 = loadIndex(pIndices, 1);
+                                    for (size_t j = 2; j < faceVertexCount; ++j)
+                                    {
+                                        const uint32_t i2 = loadIndex(pIndices, j);
+                                        *pOutput++ = i0;
+                                        *pOutput++ = i1;
+                                        *pOutput++ = i2;
+                                        i1 = i2;
+                                    }
+                                }
+                            });
+                            p += faceCount * stride;
+                            return true;
+                        }
+                    }
+                }
+            }
+
+            // Mixed polygon sizes are triangulated sequentially.
+            mesh.indices.reserve(faceCount * 3);
+            for (size_t i = 0; i < faceCount; ++i)
+            {
+                if ((size_t)(pEnd - p) < bytesBefore + countSize) return false;
+                const size_t faceVertexCount = loadCount(p);
+                const uint8_t* pIndices = p + bytesBefore + countSize;
+                if (faceVertexCount > ((size_t)(pEnd - pIndices)) / indexSize || (size_t)(pEnd - pIndices) - faceVertexCount * indexSize < bytesAfter) return false;
+
+                // Points and lines are ignored.
+                for (size_t j = 2; j < faceVertexCount; ++j)
+                {
+                    mesh.indices.push_back(loadIndex(pIndices, 0));
+                    mesh.indices.push_back(loadIndex(pIndices, j - 1));
+                    mesh.indices.push_back(loadIndex(pIndices, j));
+                }
+                p = pIndices + faceVertexCount * indexSize + bytesAfter;
+            }
+            return true;
+        }
+
+        template<bool kSwap>
+        bool skipElement(const Element& element, const uint8_t*& p, const uint8_t* pEnd)
+        {
+            if (size_t stride = getFixedStride(element); stride > 0 || element.properties.empty())
+            {
+                if (stride > 0 && element.count > (size_t)(pEnd - p) / stride) return false;
+                p += element.count * stride;
+                return true;
+            }
+
+            for (size_t i = 0; i < element.count; ++i)
+            {
+                for (const auto& property : element.properties)
+                {
+                    size_t size = property.size;
+                    if (property.isList)
+                    {
+                        if ((size_t)(pEnd - p) < property.countSize) return false;
+                        const size_t count = loadScalar<size_t, kSwap>(p, property.countType);
+                        p += property.countSize;
+                        if (count > (size_t)(pEnd - p) / property.size) return false;
+                        size = count * property.size;
+                    }
+                    if ((size_t)(pEnd - p) < size) return false;
+                    p += size;
+                }
+            }
+            return true;
+        }
+
+        template<bool kSwap>
+        bool readData(const uint8_t* pData, size_t size, const Header& header, PlyReader::Mesh& mesh)
+        {
+            const uint8_t* p = pData + header.dataOffset;
+            const uint8_t* pEnd = pData + size;
+            bool hasVertices = false;
+            bool hasFaces = false;
+
+            for (const auto& element : header.elements)
+            {
+                bool result = false;
+                if (element.name == "vertex" && !hasVertices) result = hasVertices = readVertices<kSwap>(element, p, pEnd, mesh);
+                else if (element.name == "face" && !hasFaces) result = hasFaces = readFaces<kSwap>(element, p, pEnd, mesh);
+                else result = skipElement<kSwap>(element, p, pEnd);
+                if (!result) return false;
+                if (hasVertices && hasFaces) break;
+            }
+            if (!hasVertices || !hasFaces) return false;
+
+            // Validate the indices once all vertices are known, as the face element may precede the vertex element.
+            const size_t vertexCount = mesh.positions.size();
+            std::atomic<bool> isValid = true;
+            forEachChunk(mesh.indices.size(), [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    if (mesh.indices[i] >= vertexCount)
+                    {
+                        isValid = false;
+                        break;
+                    }
+                }
+            });
+            return isValid;
+        }
+    }
+
+    bool PlyReader::read(const std::filesystem::path& path, Mesh& mesh)
+    {
+        MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!file.isOpen()) return false;
+        return read(file.getData(), file.getSize(), mesh);
+    }
+
+    bool PlyReader::read(const void* pData, size_t size, Mesh& mesh)
+    {
+        mesh = {};
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+
+        Header header;
+        if (!parseHeader(pBytes, size, header)) return false;
+
+        // Falcor only runs on little-endian hosts.
+        bool result = header.isBigEndian ? readData<true>(pBytes, size, header, mesh) : readData<false>(pBytes, size, header, mesh);
+        if (!result) mesh = {};
+        return result;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/Vector.h"
+#include <filesystem>
+#include <vector>
+
+namespace Falcor
+{
+    /** Reader for binary PLY triangle meshes.
+
+        The file is memory-mapped and the header is parsed once, after which the vertex and face
+        properties are converted in bulk. Fixed-size records are converted on multiple threads.
+        Polygons are triangulated as triangle fans.
+
+        ASCII files and layouts that cannot be converted in bulk (e.g. list properties on vertices)
+        are not supported. In that case, the read functions return false and the caller is expected
+        to fall back to a generic importer such as Assimp.
+    */
+    class FALCOR_API PlyReader
+    {
+    public:
+        struct Mesh
+        {
+            std::vector<float3> positions;  ///< Vertex positions.
+            std::vector<float3> normals;    ///< Vertex normals. Empty if the file has no normals.
+            std::vector<float2> texCoords;  ///< Vertex texture coordinates. Empty if the file has no texture coordinates.
+            std::vector<uint32_t> indices;  ///< Triangle vertex indices.
+        };
+
+        /** Read a binary PLY file.
+            \param[in] path File path.
+            \param[out] mesh Mesh data.
+            \return True if the file was read successfully, false if it is not a supported binary PLY file.
+        */
+        static bool read(const std::filesystem::path& path, Mesh& mesh);
+
+        /** Read a binary PLY file from memory.
+            \param[in] pData Pointer to the file contents.
+            \param[in] size Size of the file contents in bytes.
+            \param[out] mesh Mesh data.
+            \return True if the data was read successfully, false if it is not a supported binary PLY file.
+        */
+        static bool read(const void* pData, size_t size, Mesh& mesh);
+    };
+}
@@ -265,6 +265,12 @@ namespace Falcor
         return false;
     }
 
+    bool SDFGrid::loadSparseDataFromFile(const std::filesystem::path& path)
+    {
+        logWarning("SDFGrid::loadSparseDataFromFile() file '{}' cannot be loaded, sparse data is not supported by SDF grids of type {}!", path, getTypeName(getType()));
+        return false;
+    }
+
     void SDFGrid::generateCheeseValues(uint32_t gridWidth, uint32_t seed)
     {
         const float kHalfCheeseExtent = 0.4f;
@@ -465,6 +471,10 @@ namespace Falcor
             [](SDFGrid& self, const std::filesystem::path& path) { return self.loadValuesFromFile(getActiveAssetResolver().resolvePath(path)); },
             "path"_a
         ); // PYTHONDEPRECATED
+        sdfGrid.def("loadSparseDataFromFile",
+            [](SDFGrid& self, const std::filesystem::path& path) { return self.loadSparseDataFromFile(getActiveAssetResolver().resolvePath(path)); },
+            "path"_a
+        );
         sdfGrid.def("loadPrimitivesFromFile",
             [](SDFGrid& self, const std::filesystem::path& path, uint32_t gridWidth) { return self.loadPrimitivesFromFile(getActiveAssetResolver().resolvePath(path), gridWidth); },
             "path"_a, "gridWidth"_a
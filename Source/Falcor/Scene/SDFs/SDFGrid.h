@@ -102,6 +102,13 @@ namespace Falcor
         */
         bool loadValuesFromFile(const std::filesystem::path& path);
 
+        /** Load the sparse representation of the SDF grid from a file written by SDFSparseCache.
+            The sparse data is uploaded as is by createResources(), without a dense grid of values. Only supported by SDFSBS and SDFSVO.
+            \param[in] path The path of a sparse SDF file.
+            \return true if the sparse data could be loaded, otherwise false.
+        */
+        virtual bool loadSparseDataFromFile(const std::filesystem::path& path);
+
         /** Set the signed distance values of the SDF grid to represent a swiss cheese like shape.
             \param[in] gridWidth The grid width, note that this represents the grid width in voxels, not in values, i.e., cornerValues should have a size of (gridWidth + 1)^3.
             \param[in] seed Set the seed used to create the random holes in the swiss cheese..
@@ -0,0 +1,419 @@
+#include "SDFMeshConverter.h"
+#include "Core/Error.h"
+#include "Scene/TriangleMesh.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/MatrixMath.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kLeafSize = 4;       ///< Max number of triangles in a BVH leaf.
+        const uint32_t kStackSize = 64;     ///< Traversal stack size. The BVH is balanced, so this is enough for any 32-bit triangle count.
+        const uint32_t kTileWidth = 8;      ///< Width of the tiles of grid corners that are tested against the narrow band together.
+
+        struct Triangle
+        {
+            float3 v0;
+            float3 v1;
+            float3 v2;
+        };
+
+        struct BVHNode
+        {
+            AABB bounds;
+            float3 dipoleCenter = float3(0.f);  ///< Area-weighted centroid of the triangles.
+            float3 dipoleNormal = float3(0.f);  ///< Sum of the area-weighted normals of the triangles.
+            float dipoleRadius = 0.f;           ///< Max distance from the dipole center to the triangle vertices.
+            uint32_t offset = 0;                ///< First triangle of leaves, or second child of internal nodes. The first child directly follows its parent.
+            uint32_t count = 0;                 ///< Number of triangles of leaves, or 0 for internal nodes.
+        };
+
+        float distanceSquared(const AABB& bounds, const float3& p)
+        {
+            float3 d = max(max(bounds.minPoint - p, p - bounds.maxPoint), float3(0.f));
+            return dot(d, d);
+        }
+
+        /** Closest point on a triangle, see "Real-Time Collision Detection" by Christer Ericson, section 5.1.5.
+        */
+        float3 closestPointOnTriangle(const float3& p, const Triangle& tri)
+        {
+            const float3 ab = tri.v1 - tri.v0;
+            const float3 ac = tri.v2 - tri.v0;
+            const float3 ap = p - tri.v0;
+            const float d1 = dot(ab, ap);
+            const float d2 = dot(ac, ap);
+            if (d1 <= 0.f && d2 <= 0.f) return tri.v0;
+
+            const float3 bp = p - tri.v1;
+            const float d3 = dot(ab, bp);
+            const float d4 = dot(ac, bp);
+            if (d3 >= 0.f && d4 <= d3) return tri.v1;
+
+            const float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return tri.v0 + ab * (d1 / (d1 - d3));
+
+            const float3 cp = p - tri.v2;
+            const float d5 = dot(ab, cp);
+            const float d6 = dot(ac, cp);
+            if (d6 >= 0.f && d5 <= d6) return tri.v2;
+
+            const float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return tri.v0 + ac * (d2 / (d2 - d6));
+
+            const float va = d3 * d6 - d5 * d4;
+            if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) return tri.v1 + (tri.v2 - tri.v1) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+            const float sum = va + vb + vc;
+            if (sum <= 0.f) return tri.v0; // Degenerate triangle.
+            return tri.v0 + ab * (vb / sum) + ac * (vc / sum);
+        }
+
+        /** Signed solid angle of a triangle seen from a point [Van Oosterom and Strackee 1983].
+            It is positive if the point is behind the triangle, i.e., inside of a closed mesh with counter-clockwise triangles.
+        */
+        float computeSolidAngle(const float3& p, const Triangle& tri)
+        {
+            const float3 a = tri.v0 - p;
+            const float3 b = tri.v1 - p;
+            const float3 c = tri.v2 - p;
+            const float la = length(a);
+            const float lb = length(b);
+            const float lc = length(c);
+            const float numerator = dot(a, cross(b, c));
+            const float denominator = la * lb * lc + dot(a, b) * lc + dot(b, c) * la + dot(c, a) * lb;
+            return 2.f * std::atan2(numerator, denominator);
+        }
+
+        class TriangleBVH
+        {
+        public:
+            TriangleBVH(std::vector<Triangle> triangles)
+            {
+                const uint32_t triangleCount = (uint32_t)triangles.size();
+                std::vector<float3> centroids(triangleCount);
+                for (uint32_t i = 0; i < triangleCount; i++)
+                    centroids[i] = (triangles[i].v0 + triangles[i].v1 + triangles[i].v2) / 3.f;
+
+                std::vector<uint32_t> order(triangleCount);
+                for (uint32_t i = 0; i < triangleCount; i++)
+                    order[i] = i;
+
+                mNodes.reserve(2 * div_round_up(triangleCount, kLeafSize));
+                build(triangles, centroids, order, 0, triangleCount);
+
+                mTriangles.resize(triangleCount);
+                for (uint32_t i = 0; i < triangleCount; i++)
+                    mTriangles[i] = triangles[order[i]];
+            }
+
+            /** Find the squared distance to the closest triangle.
+                \return The squared distance, or maxDistanceSquared if no triangle is closer.
+            */
+            float findClosestDistanceSquared(const float3& p, float maxDistanceSquared) const
+            {
+                float closest = maxDistanceSquared;
+                uint32_t stack[kStackSize];
+                uint32_t stackSize = 0;
+                uint32_t nodeIndex = 0;
+
+                while (true)
+                {
+                    const BVHNode& node = mNodes[nodeIndex];
+                    if (node.count > 0)
+                    {
+                        for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                        {
+                            const float3 d = closestPointOnTriangle(p, mTriangles[i]) - p;
+                            closest = std::min(closest, dot(d, d));
+                        }
+                    }
+                    else
+                    {
+                        // Visit the closer child first.
+                        uint32_t nearIndex = nodeIndex + 1;
+                        uint32_t farIndex = node.offset;
+                        float nearDistance = distanceSquared(mNodes[nearIndex].bounds, p);
+                        float farDistance = distanceSquared(mNodes[farIndex].bounds, p);
+                        if (farDistance < nearDistance)
+                        {
+                            std::swap(nearIndex, farIndex);
+                            std::swap(nearDistance, farDistance);
+                        }
+
+                        if (farDistance < closest) stack[stackSize++] = farIndex;
+                        if (nearDistance < closest)
+                        {
+                            nodeIndex = nearIndex;
+                            continue;
+                        }
+                    }
+
+                    do
+                    {
+                        if (stackSize == 0) return closest;
+                        nodeIndex = stack[--stackSize];
+                    } while (distanceSquared(mNodes[nodeIndex].bounds, p) >= closest);
+                }
+            }
+
+            /** Compute the generalized winding number at a point. Nodes far away from the point are approximated by dipoles.
+            */
+            float computeWindingNumber(const float3& p, float accuracy) const
+            {
+                float solidAngle = 0.f;
+                uint32_t stack[kStackSize];
+                uint32_t stackSize = 0;
+                uint32_t nodeIndex = 0;
+
+                while (true)
+                {
+                    const BVHNode& node = mNodes[nodeIndex];
+                    const float3 d = node.dipoleCenter - p;
+                    const float distanceSquared = dot(d, d);
+                    const float threshold = accuracy * node.dipoleRadius;
+
+                    if (distanceSquared > threshold * threshold)
+                    {
+                        solidAngle += dot(d, node.dipoleNormal) / (distanceSquared * std::sqrt(distanceSquared));
+                    }
+                    else if (node.count > 0)
+                    {
+                        for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                            solidAngle += computeSolidAngle(p, mTriangles[i]);
+                    }
+                    else
+                    {
+                        stack[stackSize++] = node.offset;
+                        nodeIndex = nodeIndex + 1;
+                        continue;
+                    }
+
+                    if (stackSize == 0) return solidAngle / (4.f * (float)M_PI);
+                    nodeIndex = stack[--stackSize];
+                }
+            }
+
+        private:
+            uint32_t build(const std::vector<Triangle>& triangles, const std::vector<float3>& centroids, std::vector<uint32_t>& order, uint32_t first, uint32_t count)
+            {
+                const uint32_t nodeIndex = (uint32_t)mNodes.size();
+                mNodes.emplace_back();
+
+                BVHNode node;
+                AABB centroidBounds;
+                float3 weightedCentroid(0.f);
+                float3 centroidSum(0.f);
+                float areaSum = 0.f;
+                for (uint32_t i = first; i < first + count; i++)
+                {
+                    const Triangle& tri = triangles[order[i]];
+                    node.bounds.include(tri.v0).include(tri.v1).include(tri.v2);
+                    centroidBounds.include(centroids[order[i]]);
+
+                    const float3 areaVector = 0.5f * cross(tri.v1 - tri.v0, tri.v2 - tri.v0);
+                    const float area = length(areaVector);
+                    node.dipoleNormal += areaVector;
+                    weightedCentroid += area * centroids[order[i]];
+                    centroidSum += centroids[order[i]];
+                    areaSum += area;
+                }
+
+                node.dipoleCenter = areaSum > 0.f ? weightedCentroid / areaSum : centroidSum / (float)count;
+                for (uint32_t i = first; i < first + count; i++)
+                {
+                    const Triangle& tri = triangles[order[i]];
+                    for (const float3& v : {tri.v0, tri.v1, tri.v2})
+                        node.dipoleRadius = std::max(node.dipoleRadius, length(v - node.dipoleCenter));
+                }
+
+                if (count <= kLeafSize)
+                {
+                    node.offset = first;
+                    node.count = count;
+                }
+                else
+                {
+                    // Split at the median centroid along the largest axis, so the tree stays balanced.
+                    const float3 extent = centroidBounds.extent();
+                    const uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+                    const uint32_t half = count / 2;
+                    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                        [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+                    build(triangles, centroids, order, first, half);
+                    node.offset = build(triangles, centroids, order, first + half, count - half);
+                }
+
+                mNodes[nodeIndex] = node;
+                return nodeIndex;
+            }
+
+            std::vector<Triangle> mTriangles;
+            std::vector<BVHNode> mNodes;
+        };
+
+        /** Uniform scale that fits the bounds into the grid, leaving the padding empty.
+        */
+        float computeFitScale(const AABB& bounds, uint32_t gridWidth, float padding)
+        {
+            FALCOR_CHECK(bounds.valid(), "'bounds' must be valid");
+            FALCOR_CHECK(2.f * padding < (float)gridWidth, "'padding' ({}) must be less than half of the grid width ({})", padding, gridWidth);
+
+            const float3 extent = bounds.extent();
+            const float maxExtent = std::max(std::max(extent.x, extent.y), extent.z);
+            return maxExtent > 0.f ? (1.f - 2.f * padding / (float)gridWidth) / maxExtent : 1.f;
+        }
+    }
+
+    std::vector<float> SDFMeshConverter::computeCornerValues(const float3* positions, uint32_t vertexCount, const uint32_t* indices, uint32_t triangleCount,
+        uint32_t gridWidth, const Options& options)
+    {
+        FALCOR_CHECK(gridWidth > 0, "'gridWidth' must be larger than 0");
+        FALCOR_CHECK(triangleCount > 0, "Mesh has no triangles");
+        FALCOR_CHECK(positions != nullptr && indices != nullptr, "'positions' and 'indices' must not be null");
+
+        float4x4 meshToGrid = float4x4::identity();
+        if (options.fitToGrid)
+        {
+            AABB bounds;
+            for (uint32_t i = 0; i < vertexCount; i++)
+                bounds.include(positions[i]);
+            meshToGrid = computeFitTransform(bounds, gridWidth, options.padding);
+        }
+
+        std::vector<Triangle> triangles(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            const uint32_t* triangleIndices = indices + 3 * i;
+            FALCOR_CHECK(
+                triangleIndices[0] < vertexCount && triangleIndices[1] < vertexCount && triangleIndices[2] < vertexCount,
+                "Triangle {} references a vertex out of range", i
+            );
+            triangles[i] = {
+                transformPoint(meshToGrid, positions[triangleIndices[0]]),
+                transformPoint(meshToGrid, positions[triangleIndices[1]]),
+                transformPoint(meshToGrid, positions[triangleIndices[2]]),
+            };
+        }
+
+        const TriangleBVH bvh(std::move(triangles));
+
+        const uint32_t widthInValues = gridWidth + 1;
+        const uint32_t tileCountPerAxis = div_round_up(widthInValues, kTileWidth);
+        const uint32_t tileCount = tileCountPerAxis * tileCountPerAxis * tileCountPerAxis;
+        const float voxelSize = 1.f / (float)gridWidth;
+        const float band = options.narrowBandThickness > 0.f ? options.narrowBandThickness * voxelSize : std::numeric_limits<float>::infinity();
+        const float accuracy = options.windingNumberAccuracy;
+
+        std::vector<float> cornerValues((size_t)widthInValues * widthInValues * widthInValues);
+
+        auto range = NumericRange<uint32_t>(0, tileCount);
+        std::for_each(
+            std::execution::par,
+            range.begin(),
+            range.end(),
+            [&](uint32_t tileIndex)
+            {
+                const uint3 tile(tileIndex % tileCountPerAxis, (tileIndex / tileCountPerAxis) % tileCountPerAxis, tileIndex / (tileCountPerAxis * tileCountPerAxis));
+                const uint3 first = tile * kTileWidth;
+                const uint3 last = min(first + kTileWidth, uint3(widthInValues));
+
+                // No triangle is closer to the tile center than its corners in tiles that the surface does not pass through,
+                // so the winding number and thus the sign are the same everywhere in the tile.
+                // Such tiles that are also farther away from the surface than the band are filled with the clamped distance.
+                const float3 tileMin = float3(first) * voxelSize - 0.5f;
+                const float3 tileMax = float3(last - 1u) * voxelSize - 0.5f;
+                const float3 tileCenter = 0.5f * (tileMin + tileMax);
+                const float tileRadius = 0.5f * length(tileMax - tileMin);
+                const float tileRange = tileRadius + band;
+
+                const float tileDistanceSquared = bvh.findClosestDistanceSquared(tileCenter, tileRange * tileRange);
+                const bool hasSurface = tileDistanceSquared <= tileRadius * tileRadius;
+                const bool tileInside = !hasSurface && std::abs(bvh.computeWindingNumber(tileCenter, accuracy)) > 0.5f;
+
+                if (tileDistanceSquared >= tileRange * tileRange)
+                {
+                    const float value = tileInside ? -band : band;
+                    for (uint32_t z = first.z; z < last.z; z++)
+                    {
+                        for (uint32_t y = first.y; y < last.y; y++)
+                        {
+                            const size_t offset = first.x + widthInValues * (y + (size_t)widthInValues * z);
+                            std::fill_n(cornerValues.begin() + offset, last.x - first.x, value);
+                        }
+                    }
+                    return;
+                }
+
+                const float bandSquared = band * band;
+                for (uint32_t z = first.z; z < last.z; z++)
+                {
+                    for (uint32_t y = first.y; y < last.y; y++)
+                    {
+                        for (uint32_t x = first.x; x < last.x; x++)
+                        {
+                            const float3 p = float3(uint3(x, y, z)) * voxelSize - 0.5f;
+                            const float distance = std::min(std::sqrt(bvh.findClosestDistanceSquared(p, bandSquared)), band);
+                            const bool inside = hasSurface ? std::abs(bvh.computeWindingNumber(p, accuracy)) > 0.5f : tileInside;
+                            cornerValues[x + widthInValues * (y + (size_t)widthInValues * z)] = inside ? -distance : distance;
+                        }
+                    }
+                }
+            }
+        );
+
+        return cornerValues;
+    }
+
+    std::vector<float> SDFMeshConverter::computeCornerValues(const TriangleMesh& mesh, uint32_t gridWidth, const Options& options)
+    {
+        const auto& vertices = mesh.getVertices();
+        const auto& indices = mesh.getIndices();
+
+        std::vector<float3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            positions[i] = vertices[i].position;
+
+        // The sign does not depend on whether the triangles face outwards or inwards, so the winding order of the mesh is ignored.
+        return computeCornerValues(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)(indices.size() / 3), gridWidth, options);
+    }
+
+    float4x4 SDFMeshConverter::computeFitTransform(const AABB& bounds, uint32_t gridWidth, float padding)
+    {
+        const float scale = computeFitScale(bounds, gridWidth, padding);
+        return mul(math::matrixFromScaling(float3(scale)), math::matrixFromTranslation(-bounds.center()));
+    }
+
+    Transform SDFMeshConverter::computeInstanceTransform(const TriangleMesh& mesh, uint32_t gridWidth, float padding)
+    {
+        AABB bounds;
+        for (const auto& vertex : mesh.getVertices())
+            bounds.include(vertex.position);
+
+        Transform transform;
+        transform.setTranslation(bounds.center());
+        transform.setScaling(float3(1.f / computeFitScale(bounds, gridWidth, padding)));
+        return transform;
+    }
+
+    FALCOR_SCRIPT_BINDING(SDFMeshConverter)
+    {
+        using namespace pybind11::literals;
+
+        FALCOR_SCRIPT_BINDING_DEPENDENCY(AABB)
+        FALCOR_SCRIPT_BINDING_DEPENDENCY(Transform)
+        FALCOR_SCRIPT_BINDING_DEPENDENCY(TriangleMesh)
+
+        pybind11::class_<SDFMeshConverter> sdfMeshConverter(m, "SDFMeshConverter");
+        sdfMeshConverter.def_static("computeFitTransform", &SDFMeshConverter::computeFitTransform, "bounds"_a, "gridWidth"_a, "padding"_a = SDFMeshConverter::Options().padding);
+        sdfMeshConverter.def_static("computeInstanceTransform", &SDFMeshConverter::computeInstanceTransform, "triangleMesh"_a, "gridWidth"_a, "padding"_a = SDFMeshConverter::Options().padding);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "Core/Macros.h"
+#include "Scene/Transform.h"
+#include "Utils/Math/AABB.h"
+#include "Utils/Math/Matrix.h"
+#include "Utils/Math/Vector.h"
+#include <vector>
+
+namespace Falcor
+{
+    class TriangleMesh;
+
+    /** CPU converter from triangle meshes to SDF grid corner values (see SDFGrid::setValues()).
+
+        Distances are computed to the closest triangle using a BVH over the triangles of the mesh.
+        The sign is taken from the generalized winding number of the mesh [Jacobson et al. 2013], which is evaluated hierarchically
+        with the same BVH by approximating distant nodes by dipoles [Barill et al. 2018]. Points where the magnitude of the winding number is above 0.5 are inside.
+        Unlike ray parity or pseudo-normal tests, this is robust to holes and self-intersections. Only the magnitude of the winding number is used,
+        so meshes with all triangles facing inwards work too, but the triangles of a mesh must be oriented consistently.
+
+        Exact distances are only computed in a narrow band around the surface. Values further away are clamped to the band thickness,
+        which is still a conservative distance bound. The sparse SDF grid types only keep values within half a voxel diagonal of the surface,
+        so the clamped values do not affect them. The grid is processed in parallel in tiles. The sign of tiles that the surface does not pass through
+        is taken from a single winding number evaluation, and such tiles outside of the narrow band are filled without any per-corner queries.
+    */
+    class FALCOR_API SDFMeshConverter
+    {
+    public:
+        struct Options
+        {
+            float narrowBandThickness = 4.f;    ///< Thickness of the narrow band in voxels. Values outside of the band are clamped to the band thickness. Use 0 to compute exact distances everywhere.
+            bool fitToGrid = true;              ///< Scale and translate the mesh uniformly to fit the grid (see computeFitTransform()). Otherwise the mesh must be in the local space [-0.5, 0.5]^3 of the grid.
+            float padding = 2.f;                ///< Empty space between the fitted mesh and the grid boundary in voxels.
+            float windingNumberAccuracy = 2.f;  ///< BVH nodes farther away than this times their radius are approximated by a dipole when computing winding numbers.
+        };
+
+        /** Compute SDF grid corner values of a triangle mesh.
+            \param[in] positions Array of vertex positions.
+            \param[in] vertexCount Number of vertices.
+            \param[in] indices Array of triangle vertex indices, three per triangle.
+            \param[in] triangleCount Number of triangles.
+            \param[in] gridWidth Width of the grid in voxels.
+            \param[in] options Conversion options.
+            \return (gridWidth + 1)^3 signed distances in the local space of the grid, to be passed to SDFGrid::setValues().
+        */
+        static std::vector<float> computeCornerValues(const float3* positions, uint32_t vertexCount, const uint32_t* indices, uint32_t triangleCount,
+            uint32_t gridWidth, const Options& options);
+
+        /** Compute SDF grid corner values of a triangle mesh.
+            \param[in] mesh Triangle mesh.
+            \param[in] gridWidth Width of the grid in voxels.
+            \param[in] options Conversion options.
+            \return (gridWidth + 1)^3 signed distances in the local space of the grid, to be passed to SDFGrid::setValues().
+        */
+        static std::vector<float> computeCornerValues(const TriangleMesh& mesh, uint32_t gridWidth, const Options& options);
+
+        /** Compute the transform that scales and translates a mesh uniformly to fit a grid.
+            The inverse transform places an SDF grid instance at the location of the original mesh.
+            \param[in] bounds Bounds of the mesh.
+            \param[in] gridWidth Width of the grid in voxels.
+            \param[in] padding Empty space between the fitted mesh and the grid boundary in voxels.
+            \return Transform from mesh space to the local space [-0.5, 0.5]^3 of the grid.
+        */
+        static float4x4 computeFitTransform(const AABB& bounds, uint32_t gridWidth, float padding);
+
+        /** Compute the transform of an SDF grid instance that places a grid converted with Options::fitToGrid at the location of the mesh.
+            This is the inverse of computeFitTransform() for the bounds of the mesh.
+            \param[in] mesh Triangle mesh.
+            \param[in] gridWidth Width of the grid in voxels.
+            \param[in] padding Empty space between the fitted mesh and the grid boundary in voxels.
+            \return Transform from the local space of the grid to mesh space.
+        */
+        static Transform computeInstanceTransform(const TriangleMesh& mesh, uint32_t gridWidth, float padding);
+    };
+}
@@ -0,0 +1,575 @@
+#include "SDFSparseCache.h"
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Scene/Volume/BC4Encode.h"
+#include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/MathConstants.slangh"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <execution>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Specifies the current sparse file version.
+            This needs to be incremented every time the file format or the layout of the sparse structures changes!
+        */
+        const uint32_t kVersion = 2;
+
+        const uint64_t kSectionAlignment = 64;
+
+        enum class SparseType : uint32_t
+        {
+            SBS,
+            SVO,
+        };
+
+        enum Section : uint32_t
+        {
+            kIndirectionSection,
+            kBrickAABBSection,
+            kBrickSection,
+            kSVOSection,
+            kSectionCount
+        };
+
+        const char* kMagic = "FalcorD$";
+        struct Header
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+            uint32_t type{};
+            uint32_t gridWidth{};
+            uint32_t brickWidth{};
+            uint32_t compressed{};
+            uint32_t virtualBricksPerAxis{};
+            uint32_t brickCount{};
+            uint32_t bricksPerAxis[2]{};
+            uint32_t brickTextureDimensions[2]{};
+            uint32_t levelCount{};
+            uint64_t sectionOffset[kSectionCount]{};
+            uint64_t sectionSize[kSectionCount]{};
+        };
+
+        // Same as SDFVoxelCommon::kMaxLevel.
+        const uint32_t kMaxLevel = 19;
+
+        /** Quantized corner values of a grid.
+        */
+        struct QuantizedGrid
+        {
+            std::vector<int8_t> values;
+            uint32_t widthInValues;
+
+            int8_t get(const uint3& coords) const
+            {
+                return values[coords.x + widthInValues * (coords.y + (size_t)widthInValues * coords.z)];
+            }
+
+            /** Checks if a voxel conservatively contains the surface, like SDFVoxelCommon::containsSurface().
+            */
+            bool containsSurface(const uint3& voxelCoords, uint32_t voxelWidth) const
+            {
+                bool hasNegative = false;
+                bool hasPositive = false;
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    const int8_t value = get(voxelCoords + voxelWidth * uint3(i >> 2, (i >> 1) & 1, i & 1));
+                    hasNegative = hasNegative || value <= 0;
+                    hasPositive = hasPositive || value >= 0;
+                }
+                return hasNegative && hasPositive;
+            }
+
+            /** Packs the eight corner values of a voxel, like SDFVoxelCommon::packValues().
+                Corner (x, y, z) is stored in byte 4 * x + 2 * y + z.
+            */
+            uint2 packValues(const uint3& voxelCoords, uint32_t voxelWidth) const
+            {
+                uint64_t packed = 0;
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    const int8_t value = get(voxelCoords + voxelWidth * uint3(i >> 2, (i >> 1) & 1, i & 1));
+                    packed |= (uint64_t)(uint8_t)value << (8 * i);
+                }
+                return uint2((uint32_t)packed, (uint32_t)(packed >> 32));
+            }
+        };
+
+        uint3 getVirtualBrickCoords(uint32_t virtualBrickID, uint32_t virtualBricksPerAxis)
+        {
+            return uint3(
+                virtualBrickID % virtualBricksPerAxis,
+                (virtualBrickID / virtualBricksPerAxis) % virtualBricksPerAxis,
+                virtualBrickID / (virtualBricksPerAxis * virtualBricksPerAxis)
+            );
+        }
+
+        /** Same as SDFVoxelCommon::shiftCoord().
+        */
+        uint64_t shiftCoord(uint32_t x)
+        {
+            uint64_t y = x;
+            y = (y | y << 32) & 0x1f00000000ffffull;
+            y = (y | y << 16) & 0x1f0000ff0000ffull;
+            y = (y | y << 8) & 0x100f00f00f00f00full;
+            y = (y | y << 4) & 0x10c30c30c30c30c3ull;
+            y = (y | y << 2) & 0x1249249249249249ull;
+            return y;
+        }
+
+        /** Same as SDFVoxelCommon::encodeLocation().
+        */
+        uint64_t encodeLocation(const uint3& levelLocalVoxelCoords, uint32_t level)
+        {
+            const uint32_t shift = kMaxLevel - level;
+            const uint64_t coordsMask = (1ull << (3 * kMaxLevel)) - 1;
+            const uint64_t coords = (shiftCoord(levelLocalVoxelCoords.x << shift) << 2) | (shiftCoord(levelLocalVoxelCoords.y << shift) << 1) |
+                                    shiftCoord(levelLocalVoxelCoords.z << shift);
+            return ((uint64_t)level << (3 * kMaxLevel)) | (coords & coordsMask);
+        }
+
+        /** Voxel of the octree while building.
+        */
+        struct OctreeVoxel
+        {
+            uint64_t locationCode;
+            uint3 coords;
+            uint32_t validMask;     ///< Valid children, bit i is the child with the local offset (i >> 2, (i >> 1) & 1, i & 1).
+            uint32_t firstChild;    ///< Index of the first valid child in the next level.
+        };
+
+        uint64_t alignSection(uint64_t offset)
+        {
+            return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+        }
+
+        bool writeFile(const std::filesystem::path& path, Header& header, const void* const* sectionData)
+        {
+            std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+            header.version = kVersion;
+            uint64_t offset = sizeof(Header);
+            for (uint32_t i = 0; i < kSectionCount; ++i)
+            {
+                header.sectionOffset[i] = alignSection(offset);
+                offset = header.sectionOffset[i] + header.sectionSize[i];
+            }
+
+            std::ofstream fs(path, std::ios_base::binary);
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (uint32_t i = 0; i < kSectionCount; ++i)
+            {
+                const std::vector<char> padding(header.sectionOffset[i] - (uint64_t)fs.tellp(), 0);
+                fs.write(padding.data(), padding.size());
+                fs.write(reinterpret_cast<const char*>(sectionData[i]), header.sectionSize[i]);
+            }
+            if (!fs)
+            {
+                logWarning("Failed to write sparse SDF file '{}'.", path);
+                return false;
+            }
+            return true;
+        }
+
+        bool openFile(const std::filesystem::path& path, SparseType type, std::ifstream& fs, Header& header)
+        {
+            fs.open(path, std::ios::in | std::ios::binary);
+            if (!fs.is_open())
+            {
+                logWarning("Sparse SDF file '{}' could not be opened!", path);
+                return false;
+            }
+
+            // Verify the header and the section bounds.
+            fs.read(reinterpret_cast<char*>(&header), sizeof(Header));
+            std::error_code ec;
+            const uint64_t fileSize = std::filesystem::file_size(path, ec);
+            bool valid = fs && !ec && std::memcmp(header.magic, kMagic, sizeof(Header::magic)) == 0 && header.version == kVersion &&
+                         header.type == (uint32_t)type;
+            for (uint32_t i = 0; i < kSectionCount; ++i)
+            {
+                valid = valid && header.sectionOffset[i] + header.sectionSize[i] <= fileSize;
+            }
+            if (!valid)
+            {
+                logWarning("Invalid sparse SDF file '{}'.", path);
+                return false;
+            }
+            return true;
+        }
+
+        template<typename T>
+        bool readSection(std::ifstream& fs, const Header& header, Section section, size_t count, std::vector<T>& data)
+        {
+            if (header.sectionSize[section] != count * sizeof(T)) return false;
+            data.resize(count);
+            fs.seekg(header.sectionOffset[section]);
+            fs.read(reinterpret_cast<char*>(data.data()), header.sectionSize[section]);
+            return (bool)fs;
+        }
+
+        bool readValuesFile(const std::filesystem::path& path, std::vector<float>& cornerValues, uint32_t& gridWidth)
+        {
+            // Same format as SDFGrid::loadValuesFromFile(), the grid width followed by the corner values.
+            std::ifstream file(path, std::ios::in | std::ios::binary);
+            if (!file.is_open())
+            {
+                logWarning("SDF grid values file '{}' could not be opened!", path);
+                return false;
+            }
+
+            file.read(reinterpret_cast<char*>(&gridWidth), sizeof(uint32_t));
+            const size_t gridWidthInValues = gridWidth + 1;
+            cornerValues.resize(gridWidthInValues * gridWidthInValues * gridWidthInValues);
+            file.read(reinterpret_cast<char*>(cornerValues.data()), cornerValues.size() * sizeof(float));
+            if (!file)
+            {
+                logWarning("Failed to read SDF grid values file '{}'.", path);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    std::vector<int8_t> SDFSparseCache::quantizeValues(const std::vector<float>& cornerValues, uint32_t gridWidth)
+    {
+        const size_t gridWidthInValues = gridWidth + 1;
+        FALCOR_CHECK(
+            cornerValues.size() == gridWidthInValues * gridWidthInValues * gridWidthInValues,
+            "Expected {} corner values for a grid width of {}, got {}",
+            gridWidthInValues * gridWidthInValues * gridWidthInValues,
+            gridWidth,
+            cornerValues.size()
+        );
+
+        // The grid is in the size [-1, 1] thus the longest distance that can be stored is sqrt(3) (the length from corner to corner)
+        const float normalizationFactor = 2.0f * gridWidth / float(M_SQRT3);
+        std::vector<int8_t> values(cornerValues.size());
+        std::transform(std::execution::par, cornerValues.begin(), cornerValues.end(), values.begin(),
+            [normalizationFactor](float cornerValue)
+            {
+                float normalizedValue = std::clamp(cornerValue * normalizationFactor, -1.0f, 1.0f);
+                float integerScale = normalizedValue * float(INT8_MAX);
+                return integerScale >= 0.0f ? int8_t(integerScale + 0.5f) : int8_t(integerScale - 0.5f);
+            }
+        );
+        return values;
+    }
+
+    SDFSBSData SDFSparseCache::buildSBS(const std::vector<float>& cornerValues, uint32_t gridWidth, uint32_t brickWidth, bool compressed)
+    {
+        FALCOR_CHECK(brickWidth > 0, "'brickWidth' must be larger than 0");
+        FALCOR_CHECK(!compressed || (brickWidth + 1) % 4 == 0, "'brickWidth' ({}) must be a multiple of 4 minus 1 for compressed SDFSBSs", brickWidth);
+
+        const QuantizedGrid grid{quantizeValues(cornerValues, gridWidth), gridWidth + 1};
+
+        SDFSBSData data;
+        data.gridWidth = gridWidth;
+        data.brickWidth = brickWidth;
+        data.compressed = compressed;
+        data.virtualBricksPerAxis = div_round_up(gridWidth, brickWidth);
+
+        const uint32_t virtualBricksPerAxis = data.virtualBricksPerAxis;
+        const uint32_t virtualBrickCount = virtualBricksPerAxis * virtualBricksPerAxis * virtualBricksPerAxis;
+
+        // A brick is valid if any voxel in the brick contains surface.
+        data.indirection.resize(virtualBrickCount);
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, virtualBrickCount).begin(), NumericRange<uint32_t>(0, virtualBrickCount).end(),
+            [&](uint32_t virtualBrickID)
+            {
+                const uint3 minVoxel = getVirtualBrickCoords(virtualBrickID, virtualBricksPerAxis) * brickWidth;
+                const uint3 maxVoxel = min(minVoxel + brickWidth, uint3(gridWidth));
+
+                bool valid = false;
+                for (uint32_t z = minVoxel.z; z < maxVoxel.z && !valid; z++)
+                    for (uint32_t y = minVoxel.y; y < maxVoxel.y && !valid; y++)
+                        for (uint32_t x = minVoxel.x; x < maxVoxel.x && !valid; x++)
+                            valid = grid.containsSurface(uint3(x, y, z), 1);
+                data.indirection[virtualBrickID] = valid ? 1 : 0;
+            }
+        );
+
+        // Assign brick IDs in virtual brick order, like the prefix sum over the brick validity on the GPU.
+        std::vector<uint32_t> virtualBrickIDs;
+        for (uint32_t virtualBrickID = 0; virtualBrickID < virtualBrickCount; virtualBrickID++)
+        {
+            if (data.indirection[virtualBrickID])
+            {
+                data.indirection[virtualBrickID] = (uint32_t)virtualBrickIDs.size();
+                virtualBrickIDs.push_back(virtualBrickID);
+            }
+            else
+            {
+                data.indirection[virtualBrickID] = UINT32_MAX;
+            }
+        }
+
+        data.brickCount = (uint32_t)virtualBrickIDs.size();
+        if (data.brickCount == 0) return data;
+
+        // Same brick texture layout as SDFSBS::createResourcesFromSDField(), which gives a roughly square texture.
+        const uint32_t brickWidthInValues = brickWidth + 1;
+        const uint32_t bricksAlongX = (uint32_t)std::ceil(std::sqrt((float)data.brickCount / brickWidthInValues));
+        const uint32_t bricksAlongY = (uint32_t)std::ceil((float)data.brickCount / bricksAlongX);
+        data.bricksPerAxis = uint2(bricksAlongX, bricksAlongY);
+        data.brickTextureDimensions = uint2(brickWidthInValues * brickWidthInValues * bricksAlongX, brickWidthInValues * bricksAlongY);
+
+        const uint2 dimensions = data.brickTextureDimensions;
+        std::vector<int8_t> texels((size_t)dimensions.x * dimensions.y, INT8_MAX);
+        data.brickAABBs.resize(data.brickCount);
+
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, data.brickCount).begin(), NumericRange<uint32_t>(0, data.brickCount).end(),
+            [&](uint32_t brickID)
+            {
+                const uint3 brickGridCoords = getVirtualBrickCoords(virtualBrickIDs[brickID], virtualBricksPerAxis) * brickWidth;
+
+                const float oneOverGridWidth = 1.0f / float(gridWidth);
+                const float3 brickAABBMin = -0.5f + float3(brickGridCoords) * oneOverGridWidth;
+                const float3 brickAABBMax = min(brickAABBMin + float(brickWidth) * oneOverGridWidth, float3(0.5f));
+                data.brickAABBs[brickID] = AABB(brickAABBMin, brickAABBMax);
+
+                // Like SDFSBSCreateBricksFromSDField, values at or beyond the far boundary of the grid are set to the maximum distance.
+                const uint2 brickTextureCoords = uint2(brickID % bricksAlongX, brickID / bricksAlongX) * uint2(brickWidthInValues * brickWidthInValues, brickWidthInValues);
+                for (uint32_t z = 0; z < brickWidthInValues; z++)
+                {
+                    for (uint32_t y = 0; y < brickWidthInValues; y++)
+                    {
+                        int8_t* pRow = &texels[(size_t)(brickTextureCoords.y + y) * dimensions.x + brickTextureCoords.x + z * brickWidthInValues];
+                        for (uint32_t x = 0; x < brickWidthInValues; x++)
+                        {
+                            const uint3 gridCoords = brickGridCoords + uint3(x, y, z);
+                            const bool inside = gridCoords.x < gridWidth && gridCoords.y < gridWidth && gridCoords.z < gridWidth;
+                            pRow[x] = inside ? grid.get(gridCoords) : INT8_MAX;
+                        }
+                    }
+                }
+            }
+        );
+
+        if (!compressed)
+        {
+            data.brickTexture.resize(texels.size());
+            std::memcpy(data.brickTexture.data(), texels.data(), texels.size());
+            return data;
+        }
+
+        // Gather 4x4 texel blocks. The batch encoder works on unorm values, so the snorm values are offset by 128 (flipping the sign bit).
+        const uint2 blockDimensions = dimensions / 4u;
+        const size_t blockCount = (size_t)blockDimensions.x * blockDimensions.y;
+        std::vector<uint8_t> tiles(blockCount * 16);
+        std::for_each(std::execution::par, NumericRange<uint32_t>(0, blockDimensions.y).begin(), NumericRange<uint32_t>(0, blockDimensions.y).end(),
+            [&](uint32_t blockY)
+            {
+                for (uint32_t blockX = 0; blockX < blockDimensions.x; blockX++)
+                {
+                    uint8_t* pTile = &tiles[((size_t)blockY * blockDimensions.x + blockX) * 16];
+                    for (uint32_t y = 0; y < 4; y++)
+                        for (uint32_t x = 0; x < 4; x++)
+                            pTile[4 * y + x] = (uint8_t)((uint8_t)texels[(size_t)(4 * blockY + y) * dimensions.x + 4 * blockX + x] ^ 0x80);
+                }
+            }
+        );
+
+        // Offsetting the two endpoints back gives BC4Snorm blocks. The ordering of the endpoints, which selects the codebook, is preserved.
+        std::vector<uint64_t> blocks(blockCount);
+        encodeBC4BlocksParallel(tiles.data(), blocks.data(), blockCount);
+        for (uint64_t& block : blocks) block ^= 0x8080;
+
+        data.brickTexture.resize(blockCount * sizeof(uint64_t));
+        std::memcpy(data.brickTexture.data(), blocks.data(), data.brickTexture.size());
+        return data;
+    }
+
+    SDFSVOData SDFSparseCache::buildSVO(const std::vector<float>& cornerValues, uint32_t gridWidth)
+    {
+        FALCOR_CHECK(isPowerOf2(gridWidth), "'gridWidth' ({}) must be a power of 2 for SDFSVOs", gridWidth);
+
+        const QuantizedGrid grid{quantizeValues(cornerValues, gridWidth), gridWidth + 1};
+
+        SDFSVOData data;
+        data.gridWidth = gridWidth;
+        data.levelCount = bitScanReverse(gridWidth) + 1;
+
+        // Voxels of each level, sorted by location code.
+        std::vector<std::vector<OctreeVoxel>> levels(data.levelCount);
+
+        // Create voxels for the finest level, a voxel is created if it contains the surface.
+        {
+            const uint32_t finestLevel = data.levelCount - 1;
+            std::vector<std::vector<OctreeVoxel>> slices(gridWidth);
+            std::for_each(std::execution::par, NumericRange<uint32_t>(0, gridWidth).begin(), NumericRange<uint32_t>(0, gridWidth).end(),
+                [&](uint32_t z)
+                {
+                    for (uint32_t y = 0; y < gridWidth; y++)
+                    {
+                        for (uint32_t x = 0; x < gridWidth; x++)
+                        {
+                            const uint3 coords(x, y, z);
+                            if (grid.containsSurface(coords, 1)) slices[z].push_back({encodeLocation(coords, finestLevel), coords, 0, 0});
+                        }
+                    }
+                }
+            );
+
+            auto& finest = levels[finestLevel];
+            for (const auto& slice : slices) finest.insert(finest.end(), slice.begin(), slice.end());
+            std::sort(std::execution::par, finest.begin(), finest.end(), [](const OctreeVoxel& a, const OctreeVoxel& b) { return a.locationCode < b.locationCode; });
+        }
+
+        // Create voxels for all the other levels, a voxel is only created if a child voxel has been created for that voxel.
+        // The children of a voxel are consecutive in the sorted next level, and the parents are created in sorted order.
+        for (int32_t l = (int32_t)data.levelCount - 2; l >= 0; l--)
+        {
+            const auto& children = levels[l + 1];
+            auto& parents = levels[l];
+            for (uint32_t i = 0; i < (uint32_t)children.size(); i++)
+            {
+                const uint3 childCoords = children[i].coords;
+                const uint3 coords(childCoords.x >> 1, childCoords.y >> 1, childCoords.z >> 1);
+                const uint64_t locationCode = encodeLocation(coords, (uint32_t)l);
+                if (parents.empty() || parents.back().locationCode != locationCode) parents.push_back({locationCode, coords, 0, i});
+                parents.back().validMask |= 1u << (((childCoords.x & 1) << 2) | ((childCoords.y & 1) << 1) | (childCoords.z & 1));
+            }
+        }
+
+        // Write the levels in order. This is the order of the location codes, as the level is stored above the coordinates.
+        std::vector<uint32_t> levelOffsets(data.levelCount + 1, 0);
+        for (uint32_t l = 0; l < data.levelCount; l++) levelOffsets[l + 1] = levelOffsets[l] + (uint32_t)levels[l].size();
+        FALCOR_CHECK(levelOffsets.back() <= (1u << 24), "SDFSVO has too many voxels ({}), child offsets are limited to 24 bits", levelOffsets.back());
+
+        data.voxels.resize(levelOffsets.back());
+        for (uint32_t l = 0; l < data.levelCount; l++)
+        {
+            const uint32_t voxelWidth = 1 << (data.levelCount - l - 1);
+            const auto& level = levels[l];
+            std::for_each(std::execution::par, NumericRange<uint32_t>(0, (uint32_t)level.size()).begin(), NumericRange<uint32_t>(0, (uint32_t)level.size()).end(),
+                [&](uint32_t i)
+                {
+                    const OctreeVoxel& voxel = level[i];
+                    SDFSVOVoxel& svoVoxel = data.voxels[levelOffsets[l] + i];
+
+                    // Set the valid bit in the 2 unused bits of the location code.
+                    svoVoxel.locationCode = uint2((uint32_t)voxel.locationCode, (uint32_t)(voxel.locationCode >> 32) | (1u << 31));
+                    svoVoxel.relationData = voxel.validMask;
+                    if (voxel.validMask != 0) svoVoxel.relationData |= (levelOffsets[l + 1] + voxel.firstChild) << 8;
+                    svoVoxel.packedValues = grid.packValues(voxel.coords * voxelWidth, voxelWidth);
+                }
+            );
+        }
+
+        return data;
+    }
+
+    bool SDFSparseCache::writeSBS(const std::filesystem::path& path, const SDFSBSData& data)
+    {
+        Header header;
+        header.type = (uint32_t)SparseType::SBS;
+        header.gridWidth = data.gridWidth;
+        header.brickWidth = data.brickWidth;
+        header.compressed = data.compressed ? 1 : 0;
+        header.virtualBricksPerAxis = data.virtualBricksPerAxis;
+        header.brickCount = data.brickCount;
+        header.bricksPerAxis[0] = data.bricksPerAxis.x;
+        header.bricksPerAxis[1] = data.bricksPerAxis.y;
+        header.brickTextureDimensions[0] = data.brickTextureDimensions.x;
+        header.brickTextureDimensions[1] = data.brickTextureDimensions.y;
+
+        const void* sectionData[kSectionCount] = { data.indirection.data(), data.brickAABBs.data(), data.brickTexture.data(), nullptr };
+        header.sectionSize[kIndirectionSection] = data.indirection.size() * sizeof(uint32_t);
+        header.sectionSize[kBrickAABBSection] = data.brickAABBs.size() * sizeof(AABB);
+        header.sectionSize[kBrickSection] = data.brickTexture.size();
+        return writeFile(path, header, sectionData);
+    }
+
+    bool SDFSparseCache::writeSVO(const std::filesystem::path& path, const SDFSVOData& data)
+    {
+        Header header;
+        header.type = (uint32_t)SparseType::SVO;
+        header.gridWidth = data.gridWidth;
+        header.levelCount = data.levelCount;
+
+        const void* sectionData[kSectionCount] = { nullptr, nullptr, nullptr, data.voxels.data() };
+        header.sectionSize[kSVOSection] = data.voxels.size() * sizeof(SDFSVOVoxel);
+        return writeFile(path, header, sectionData);
+    }
+
+    bool SDFSparseCache::readSBS(const std::filesystem::path& path, SDFSBSData& data)
+    {
+        std::ifstream fs;
+        Header header;
+        if (!openFile(path, SparseType::SBS, fs, header)) return false;
+
+        data.gridWidth = header.gridWidth;
+        data.brickWidth = header.brickWidth;
+        data.compressed = header.compressed != 0;
+        data.virtualBricksPerAxis = header.virtualBricksPerAxis;
+        data.brickCount = header.brickCount;
+        data.bricksPerAxis = uint2(header.bricksPerAxis[0], header.bricksPerAxis[1]);
+        data.brickTextureDimensions = uint2(header.brickTextureDimensions[0], header.brickTextureDimensions[1]);
+
+        const size_t virtualBrickCount = (size_t)data.virtualBricksPerAxis * data.virtualBricksPerAxis * data.virtualBricksPerAxis;
+        const size_t texelCount = (size_t)data.brickTextureDimensions.x * data.brickTextureDimensions.y;
+        const size_t brickTextureSize = data.compressed ? texelCount / 16 * sizeof(uint64_t) : texelCount;
+
+        bool valid = data.brickWidth > 0 && data.virtualBricksPerAxis == div_round_up(data.gridWidth, data.brickWidth);
+        valid = valid && readSection(fs, header, kIndirectionSection, virtualBrickCount, data.indirection);
+        valid = valid && readSection(fs, header, kBrickAABBSection, data.brickCount, data.brickAABBs);
+        valid = valid && readSection(fs, header, kBrickSection, brickTextureSize, data.brickTexture);
+        if (!valid)
+        {
+            logWarning("Invalid sparse SDF file '{}'.", path);
+            return false;
+        }
+        return true;
+    }
+
+    bool SDFSparseCache::readSVO(const std::filesystem::path& path, SDFSVOData& data)
+    {
+        std::ifstream fs;
+        Header header;
+        if (!openFile(path, SparseType::SVO, fs, header)) return false;
+
+        data.gridWidth = header.gridWidth;
+        data.levelCount = header.levelCount;
+
+        bool valid = isPowerOf2(data.gridWidth) && data.levelCount == bitScanReverse(data.gridWidth) + 1;
+        valid = valid && readSection(fs, header, kSVOSection, header.sectionSize[kSVOSection] / sizeof(SDFSVOVoxel), data.voxels);
+        if (!valid)
+        {
+            logWarning("Invalid sparse SDF file '{}'.", path);
+            return false;
+        }
+        return true;
+    }
+
+    bool SDFSparseCache::convertValuesFileToSBS(const std::filesystem::path& valuesPath, const std::filesystem::path& path, uint32_t brickWidth, bool compressed)
+    {
+        std::vector<float> cornerValues;
+        uint32_t gridWidth = 0;
+        if (!readValuesFile(valuesPath, cornerValues, gridWidth)) return false;
+        return writeSBS(path, buildSBS(cornerValues, gridWidth, brickWidth, compressed));
+    }
+
+    bool SDFSparseCache::convertValuesFileToSVO(const std::filesystem::path& valuesPath, const std::filesystem::path& path)
+    {
+        std::vector<float> cornerValues;
+        uint32_t gridWidth = 0;
+        if (!readValuesFile(valuesPath, cornerValues, gridWidth)) return false;
+        return writeSVO(path, buildSVO(cornerValues, gridWidth));
+    }
+
+    FALCOR_SCRIPT_BINDING(SDFSparseCache)
+    {
+        using namespace pybind11::literals;
+
+        pybind11::class_<SDFSparseCache> sdfSparseCache(m, "SDFSparseCache");
+        sdfSparseCache.def_static("convertValuesFileToSBS", &SDFSparseCache::convertValuesFileToSBS, "valuesPath"_a, "path"_a, "brickWidth"_a = 7, "compressed"_a = false);
+        sdfSparseCache.def_static("convertValuesFileToSVO", &SDFSparseCache::convertValuesFileToSVO, "valuesPath"_a, "path"_a);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "Core/Macros.h"
+#include "Scene/SDFs/SDFVoxelTypes.slang"
+#include "Utils/Math/AABB.h"
+#include "Utils/Math/Vector.h"
+#include <filesystem>
+#include <vector>
+
+namespace Falcor
+{
+    /** GPU data of an SDF sparse brick set (see SDFSBS), in the layout built by SDFSBS::createResources().
+    */
+    struct SDFSBSData
+    {
+        uint32_t gridWidth = 0;
+        uint32_t brickWidth = 0;
+        bool compressed = false;
+        uint32_t virtualBricksPerAxis = 0;
+        uint32_t brickCount = 0;
+        uint2 bricksPerAxis = uint2(0);
+        uint2 brickTextureDimensions = uint2(0);
+        std::vector<uint32_t> indirection;      ///< Brick ID of each virtual brick, or UINT32_MAX if the virtual brick is empty.
+        std::vector<AABB> brickAABBs;           ///< AABB of each brick in the local space of the grid.
+        std::vector<uint8_t> brickTexture;      ///< Brick texture, R8Snorm texels or BC4Snorm blocks if compressed.
+    };
+
+    /** GPU data of an SDF sparse voxel octree (see SDFSVO), in the layout built by SDFSVO::createResources().
+    */
+    struct SDFSVOData
+    {
+        uint32_t gridWidth = 0;
+        uint32_t levelCount = 0;
+        std::vector<SDFSVOVoxel> voxels;        ///< Voxels of all levels sorted by location code.
+    };
+
+    /** CPU builder and file format for the sparse SDF grid types.
+
+        SDFSBS and SDFSVO build their sparse structures from a dense grid of values on the GPU when created.
+        This class builds the same structures on the CPU, so that they can be written to a file without a GPU device.
+        Sparse files are loaded with SDFGrid::loadSparseDataFromFile() and uploaded as is, without the dense grid texture or the build passes.
+    */
+    class FALCOR_API SDFSparseCache
+    {
+    public:
+        /** Normalize and quantize corner values to 8-bit snorms, the way SDFSBS and SDFSVO store them.
+            \param[in] cornerValues The corner values for all voxels in the grid (see SDFGrid::setValues()).
+            \param[in] gridWidth The grid width in voxels.
+            \return (gridWidth + 1)^3 quantized values, where 127 corresponds to half a voxel diagonal.
+        */
+        static std::vector<int8_t> quantizeValues(const std::vector<float>& cornerValues, uint32_t gridWidth);
+
+        /** Build a sparse brick set from corner values.
+            \param[in] cornerValues The corner values for all voxels in the grid (see SDFGrid::setValues()).
+            \param[in] gridWidth The grid width in voxels.
+            \param[in] brickWidth The width of a brick in voxels.
+            \param[in] compressed Compress bricks using BC4. brickWidth + 1 must be a multiple of 4.
+            \return The sparse brick set.
+        */
+        static SDFSBSData buildSBS(const std::vector<float>& cornerValues, uint32_t gridWidth, uint32_t brickWidth, bool compressed);
+
+        /** Build a sparse voxel octree from corner values.
+            \param[in] cornerValues The corner values for all voxels in the grid (see SDFGrid::setValues()).
+            \param[in] gridWidth The grid width in voxels, must be a power of two.
+            \return The sparse voxel octree.
+        */
+        static SDFSVOData buildSVO(const std::vector<float>& cornerValues, uint32_t gridWidth);
+
+        /** Write a sparse brick set to a file.
+            \return true if the file was written, otherwise false.
+        */
+        static bool writeSBS(const std::filesystem::path& path, const SDFSBSData& data);
+
+        /** Write a sparse voxel octree to a file.
+            \return true if the file was written, otherwise false.
+        */
+        static bool writeSVO(const std::filesystem::path& path, const SDFSVOData& data);
+
+        /** Read a sparse brick set from a file.
+            \return true if the file contains a valid sparse brick set, otherwise false.
+        */
+        static bool readSBS(const std::filesystem::path& path, SDFSBSData& data);
+
+        /** Read a sparse voxel octree from a file.
+            \return true if the file contains a valid sparse voxel octree, otherwise false.
+        */
+        static bool readSVO(const std::filesystem::path& path, SDFSVOData& data);
+
+        /** Convert a file of SDF grid values (see SDFGrid::loadValuesFromFile()) to a sparse brick set file.
+            \return true if the sparse file was written, otherwise false.
+        */
+        static bool convertValuesFileToSBS(const std::filesystem::path& valuesPath, const std::filesystem::path& path, uint32_t brickWidth, bool compressed);
+
+        /** Convert a file of SDF grid values (see SDFGrid::loadValuesFromFile()) to a sparse voxel octree file.
+            \return true if the sparse file was written, otherwise false.
+        */
+        static bool convertValuesFileToSVO(const std::filesystem::path& valuesPath, const std::filesystem::path& path);
+    };
+}
@@ -6,6 +6,7 @@
 #include "Utils/Math/MathConstants.slangh"
 #include "Utils/SharedCache.h"
 #include "Scene/SDFs/SDFVoxelTypes.slang"
+#include <cstring>
 
 namespace Falcor
 {
@@ -70,8 +71,37 @@ namespace Falcor
         return bitScanReverse(mBrickCount - 1) + 1;
     }
 
+    bool SDFSBS::loadSparseDataFromFile(const std::filesystem::path& path)
+    {
+        auto pSparseData = std::make_unique<SDFSBSData>();
+        if (!SDFSparseCache::readSBS(path, *pSparseData)) return false;
+
+        if (pSparseData->brickCount == 0)
+        {
+            logWarning("SDFSBS::loadSparseDataFromFile() file '{}' does not contain any bricks!", path);
+            return false;
+        }
+
+        // The brick layout is defined by the file.
+        mGridWidth = pSparseData->gridWidth;
+        mBrickWidth = pSparseData->brickWidth;
+        mCompressed = pSparseData->compressed;
+        mpSparseData = std::move(pSparseData);
+        mLoadedFromSparseData = true;
+        mSDField.clear();
+        mInitializedWithPrimitives = false;
+        return true;
+    }
+
     SDFGrid::UpdateFlags SDFSBS::update(RenderContext* pRenderContext)
     {
+        // Grids loaded from a sparse file are uploaded once in createResources().
+        if (mLoadedFromSparseData)
+        {
+            FALCOR_CHECK(mPrimitives.empty(), "An SDFSBS loaded from a sparse file cannot be edited with primitives!");
+            return UpdateFlags::None;
+        }
+
         // No update is performed if the SDF grid isn't dirty or isn't constructed from primitives and should not be created as an empty grid.
         bool isEmpty = mPrimitives.empty() && !mpSDFGridTexture && !mWasEmpty;
         if ((!mPrimitivesDirty || (mPrimitives.empty() && !mHasGridRepresentation)) && !isEmpty) return UpdateFlags::None;
@@ -89,6 +119,20 @@ namespace Falcor
     {
         FALCOR_ASSERT(pRenderContext);
 
+        if (mLoadedFromSparseData)
+        {
+            FALCOR_CHECK(mPrimitives.empty(), "An SDFSBS loaded from a sparse file cannot be created from primitives!");
+
+            // The sparse data is released after the upload, the GPU data stays valid.
+            if (mpSparseData)
+            {
+                createResourcesFromSparseData();
+                mpSparseData.reset();
+            }
+            allocatePrimitiveBits();
+            return;
+        }
+
         // Update grid texture, if user loads an sdf-file.
         if (!mSDField.empty())
         {
@@ -140,6 +184,27 @@ namespace Falcor
         var["normalizationFactor"] = 0.5f * float(M_SQRT3) / mGridWidth;
     }
 
+    SDFSBSData SDFSBS::readSparseData(RenderContext* pRenderContext) const
+    {
+        FALCOR_CHECK(mpIndirectionTexture && mpBrickAABBsBuffer && mpBrickTexture, "SDFSBS::readSparseData() can't be called before calling SDFSBS::createResources()!");
+
+        SDFSBSData data;
+        data.gridWidth = mGridWidth;
+        data.brickWidth = mBrickWidth;
+        data.compressed = mCompressed;
+        data.virtualBricksPerAxis = mVirtualBricksPerAxis;
+        data.brickCount = mBrickCount;
+        data.bricksPerAxis = mBricksPerAxis;
+        data.brickTextureDimensions = mBrickTextureDimensions;
+
+        const std::vector<uint8_t> indirection = pRenderContext->readTextureSubresource(mpIndirectionTexture.get(), 0);
+        data.indirection.resize(indirection.size() / sizeof(uint32_t));
+        std::memcpy(data.indirection.data(), indirection.data(), data.indirection.size() * sizeof(uint32_t));
+        data.brickAABBs = mpBrickAABBsBuffer->getElements<AABB>(0, mBrickCount);
+        data.brickTexture = pRenderContext->readTextureSubresource(mpBrickTexture.get(), 0);
+        return data;
+    }
+
     void SDFSBS::createResourcesFromSDField(RenderContext* pRenderContext, bool deleteScratchData)
     {
         FALCOR_ASSERT(mpSDFGridTexture && mpSDFGridTexture->getWidth() == mGridWidth + 1);
@@ -327,6 +392,33 @@ namespace Falcor
         mWasEmpty = false;
     }
 
+    void SDFSBS::createResourcesFromSparseData()
+    {
+        FALCOR_ASSERT(mpSparseData);
+        const SDFSBSData& data = *mpSparseData;
+
+        mVirtualBricksPerAxis = data.virtualBricksPerAxis;
+        mBrickCount = data.brickCount;
+        mBricksPerAxis = data.bricksPerAxis;
+        mBrickTextureDimensions = data.brickTextureDimensions;
+
+        mpIndirectionTexture = mpDevice->createTexture3D(mVirtualBricksPerAxis, mVirtualBricksPerAxis, mVirtualBricksPerAxis, ResourceFormat::R32Uint, 1, data.indirection.data(), ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess);
+        mpIndirectionTexture->setName("SDFSBS::IndirectionTextureValues");
+
+        mpBrickAABBsBuffer = mpDevice->createStructuredBuffer(sizeof(AABB), mBrickCount, ResourceBindFlags::UnorderedAccess | ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, data.brickAABBs.data(), false);
+
+        if (mCompressed)
+        {
+            mpBrickTexture = mpDevice->createTexture2D(mBrickTextureDimensions.x, mBrickTextureDimensions.y, ResourceFormat::BC4Snorm, 1, 1, data.brickTexture.data());
+        }
+        else
+        {
+            mpBrickTexture = mpDevice->createTexture2D(mBrickTextureDimensions.x, mBrickTextureDimensions.y, ResourceFormat::R8Snorm, 1, 1, data.brickTexture.data(), ResourceBindFlags::UnorderedAccess | ResourceBindFlags::ShaderResource);
+        }
+
+        mWasEmpty = false;
+    }
+
     SDFGrid::UpdateFlags SDFSBS::createResourcesFromPrimitivesAndSDField(RenderContext* pRenderContext, bool deleteScratchData)
     {
         // Assume AABBs will change.
@@ -947,18 +1039,9 @@ namespace Falcor
 
     void SDFSBS::setValuesInternal(const std::vector<float>& cornerValues)
     {
-        uint32_t gridWidthInValues = mGridWidth + 1;
-        uint32_t valueCount = gridWidthInValues * gridWidthInValues * gridWidthInValues;
-        mSDField.resize(valueCount);
-
-        // The grid is in the size [-1, 1] thus the longest distance that can be stored is sqrt(3) (the length from corner to corner)
-        float normalizationFactor = 2.0f * mGridWidth / float(M_SQRT3);
-        for (uint32_t v = 0; v < valueCount; v++)
-        {
-            float normalizedValue = std::clamp(cornerValues[v] * normalizationFactor, -1.0f, 1.0f);
-            float integerScale = normalizedValue * float(INT8_MAX);
-            mSDField[v] = integerScale >= 0.0f ? int8_t(integerScale + 0.5f) : int8_t(integerScale - 0.5f);
-        }
+        mSDField = SDFSparseCache::quantizeValues(cornerValues, mGridWidth);
+        mpSparseData.reset();
+        mLoadedFromSparseData = false;
     }
 
     void SDFSBS::createSDFGridTexture(RenderContext* pRenderContext, const std::vector<int8_t>& sdField)
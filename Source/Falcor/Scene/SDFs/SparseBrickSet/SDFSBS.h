@@ -2,6 +2,7 @@
 
 #include "Core/Pass/ComputePass.h"
 #include "Scene/SDFs/SDFGrid.h"
+#include "Scene/SDFs/SDFSparseCache.h"
 #include "Utils/Algorithm/PrefixSum.h"
 
 namespace Falcor
@@ -32,8 +33,15 @@ namespace Falcor
         virtual uint32_t getMaxPrimitiveIDBits() const override;
         virtual Type getType() const override { return Type::SparseBrickSet; }
 
+        virtual bool loadSparseDataFromFile(const std::filesystem::path& path) override;
+
         virtual void createResources(RenderContext* pRenderContext, bool deleteScratchData = true) override;
 
+        /** Read back the sparse brick set from the GPU, in the layout built by SDFSparseCache::buildSBS().
+            Must be called after createResources(). The result can be written to a file with SDFSparseCache::writeSBS().
+        */
+        SDFSBSData readSparseData(RenderContext* pRenderContext) const;
+
         virtual const ref<Buffer>& getAABBBuffer() const override { return mpBrickAABBsBuffer; }
         virtual uint32_t getAABBCount() const override { return mBrickCount; }
 
@@ -44,6 +52,7 @@ namespace Falcor
 
     protected:
         void createResourcesFromSDField(RenderContext* pRenderContext, bool deleteScratchData);
+        void createResourcesFromSparseData();
         SDFGrid::UpdateFlags createResourcesFromPrimitivesAndSDField(RenderContext* pRenderContext, bool deleteScratchData);
 
         void expandSDFGridTexture(RenderContext* pRenderContext, bool deleteScratchData, uint32_t oldGridWidthInSDField, uint32_t gridWidthInSDField);
@@ -62,6 +71,7 @@ namespace Falcor
     private:
         // CPU data.
         std::vector<int8_t> mSDField;
+        std::unique_ptr<SDFSBSData> mpSparseData;       ///< Sparse data loaded from a file, released once uploaded.
 
         // Specs.
         uint32_t mDefaultGridWidth = 0;                 ///< The grid width used if the grid was not loaded from a file (it is empty).
@@ -79,6 +89,7 @@ namespace Falcor
         uint32_t mCurrentBakedPrimitiveCount = 0;
         bool mWasEmpty = false;
         bool mBuildEmptyGrid = false;
+        bool mLoadedFromSparseData = false;             ///< True if the GPU data was uploaded from a sparse file, there is no SD field to rebuild from.
 
         // GPU data.
         ref<Buffer> mpBrickAABBsBuffer;                 ///< A compact buffer containing AABBs for each brick.
@@ -63,6 +63,27 @@ namespace Falcor
         return bitScanReverse(mSVOElementCount - 1) + 1;
     }
 
+    bool SDFSVO::loadSparseDataFromFile(const std::filesystem::path& path)
+    {
+        auto pSparseData = std::make_unique<SDFSVOData>();
+        if (!SDFSparseCache::readSVO(path, *pSparseData)) return false;
+
+        if (pSparseData->voxels.empty())
+        {
+            logWarning("SDFSVO::loadSparseDataFromFile() file '{}' does not contain any voxels!", path);
+            return false;
+        }
+
+        mGridWidth = pSparseData->gridWidth;
+        mLevelCount = pSparseData->levelCount;
+        mSVOElementCount = (uint32_t)pSparseData->voxels.size();
+        mpSparseData = std::move(pSparseData);
+        mLoadedFromSparseData = true;
+        mValues.clear();
+        mInitializedWithPrimitives = false;
+        return true;
+    }
+
     void SDFSVO::createResources(RenderContext* pRenderContext, bool deleteScratchData)
     {
         if (!mPrimitives.empty())
@@ -70,6 +91,17 @@ namespace Falcor
             FALCOR_THROW("An SDFSVO instance cannot be created from primitives!");
         }
 
+        // Upload the octree loaded from a sparse file as is, it is released afterwards.
+        if (mLoadedFromSparseData)
+        {
+            if (mpSparseData)
+            {
+                mpSVOBuffer = mpDevice->createBuffer(mSVOElementCount * sizeof(SDFSVOVoxel), ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess, MemoryType::DeviceLocal, mpSparseData->voxels.data());
+                mpSparseData.reset();
+            }
+            return;
+        }
+
         // Create source grid texture to read from.
         if (mpSDFGridTexture && mpSDFGridTexture->getWidth() == mGridWidth + 1)
         {
@@ -365,6 +397,17 @@ namespace Falcor
         }
     }
 
+    SDFSVOData SDFSVO::readSparseData() const
+    {
+        FALCOR_CHECK(mpSVOBuffer, "SDFSVO::readSparseData() can't be called before calling SDFSVO::createResources()!");
+
+        SDFSVOData data;
+        data.gridWidth = mGridWidth;
+        data.levelCount = mLevelCount;
+        data.voxels = mpSVOBuffer->getElements<SDFSVOVoxel>(0, mSVOElementCount);
+        return data;
+    }
+
     const ref<Buffer>& SDFSVO::getAABBBuffer() const
     {
         return mpSharedData->pUnitAABBBuffer;
@@ -381,18 +424,8 @@ namespace Falcor
     void SDFSVO::setValuesInternal(const std::vector<float>& cornerValues)
     {
         mLevelCount = bitScanReverse(mGridWidth) + 1;
-
-        uint32_t gridWidthInValues = mGridWidth + 1;
-        uint32_t valueCount = gridWidthInValues * gridWidthInValues * gridWidthInValues;
-        mValues.resize(valueCount);
-
-        float normalizationMultipler = mGridWidth / (0.5f * float(M_SQRT3));
-        for (uint32_t v = 0; v < valueCount; v++)
-        {
-            float normalizedValue = std::clamp(cornerValues[v] * normalizationMultipler, -1.0f, 1.0f);
-
-            float integerScale = normalizedValue * float(INT8_MAX);
-            mValues[v] = integerScale >= 0.0f ? int8_t(integerScale + 0.5f) : int8_t(integerScale - 0.5f);
-        }
+        mValues = SDFSparseCache::quantizeValues(cornerValues, mGridWidth);
+        mpSparseData.reset();
+        mLoadedFromSparseData = false;
     }
 }
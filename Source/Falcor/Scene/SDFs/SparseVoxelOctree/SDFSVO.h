@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Scene/SDFs/SDFGrid.h"
+#include "Scene/SDFs/SDFSparseCache.h"
 #include "Core/API/Buffer.h"
 #include "Core/API/Texture.h"
 #include "Core/Pass/ComputePass.h"
@@ -26,8 +27,15 @@ namespace Falcor
 
         virtual Type getType() const override { return Type::SparseVoxelOctree; }
 
+        virtual bool loadSparseDataFromFile(const std::filesystem::path& path) override;
+
         virtual void createResources(RenderContext* pRenderContext, bool deleteScratchData = true) override;
 
+        /** Read back the sparse voxel octree from the GPU, in the layout built by SDFSparseCache::buildSVO().
+            Must be called after createResources(). The result can be written to a file with SDFSparseCache::writeSVO().
+        */
+        SDFSVOData readSparseData() const;
+
         virtual const ref<Buffer>& getAABBBuffer() const override;
         virtual uint32_t getAABBCount() const override { return 1; }
 
@@ -39,6 +47,8 @@ namespace Falcor
     private:
         // CPU data.
         std::vector<int8_t> mValues;
+        std::unique_ptr<SDFSVOData> mpSparseData;   ///< Sparse data loaded from a file, released once uploaded.
+        bool mLoadedFromSparseData = false;         ///< True if the SVO was uploaded from a sparse file, there are no values to rebuild from.
 
         // Specs.
         uint32_t mLevelCount = 0;
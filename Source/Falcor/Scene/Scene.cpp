@@ -4,7 +4,9 @@
 #include "SceneBuilder.h"
 #include "Importer.h"
 #include "Scene/Material/SerializedMaterialParams.h"
+#include "ClusterLOD.h"
 #include "Curves/CurveConfig.h"
+#include "Curves/CurveLOD.h"
 #include "SDFs/SDFGrid.h"
 #include "SDFs/NormalizedDenseSDFGrid/NDSDFGrid.h"
 #include "SDFs/SparseBrickSet/SDFSBS.h"
@@ -16,6 +18,7 @@
 #include "Utils/StringUtils.h"
 #include "Utils/ObjectIDPython.h"
 #include "Utils/Math/Common.h"
+#include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Timing/Profiler.h"
@@ -69,6 +72,7 @@ namespace Falcor
         const std::string kLights = "lights";
         const std::string kAnimated = "animated";
         const std::string kRenderSettings = "renderSettings";
+        const std::string kCurveLODSettings = "curveLODSettings";
         const std::string kEnvMap = "envMap";
         const std::string kMaterials = "materials";
         const std::string kGridVolumes = "gridVolumes";
@@ -174,6 +178,15 @@ namespace Falcor
         mCurveIndexData = std::move(sceneData.curveIndexData);
         mCurveStaticData = std::move(sceneData.curveStaticData);
 
+        // Start with the finest level of each curve LOD chain. The levels are selected on the first update.
+        mCurveLODs = std::move(sceneData.curveLODs);
+        mCurveLODLevels.assign(mCurveLODs.size(), 0);
+        mCurveEnabled.assign(mCurveDesc.size(), 1);
+        for (const auto& curveLOD : mCurveLODs)
+        {
+            for (size_t level = 1; level < curveLOD.curveIDs.size(); level++) mCurveEnabled[curveLOD.curveIDs[level].get()] = 0;
+        }
+
         mSDFGrids = std::move(sceneData.sdfGrids);
         mSDFGridDesc = std::move(sceneData.sdfGridDesc);
         mSDFGridMaxLODCount = std::move(sceneData.sdfGridMaxLODCount);
@@ -183,6 +196,7 @@ namespace Falcor
 
         mMeshIndexData = std::move(sceneData.meshIndexData);
         mMeshStaticData = std::move(sceneData.meshStaticData);
+        mSceneCacheKey = sceneData.sceneCacheKey;
 
         mMeshIndexData.setBufferCountDefinePrefix("SCENE_INDEX");
         mMeshIndexData.createGpuBuffers(mpDevice, ResourceBindFlags::Index | ResourceBindFlags::ShaderResource);
@@ -951,13 +965,25 @@ namespace Falcor
         if (forceUpdate)
         {
             // Compute AABBs of curve segments.
-            for (const auto& curve : mCurveDesc)
+            for (size_t curveID = 0; curveID < mCurveDesc.size(); curveID++)
             {
+                const auto& curve = mCurveDesc[curveID];
+
                 // Track range of updated AABBs.
                 // TODO: Per-curve flag to indicate changes. For now assume all curves need updating.
                 firstUpdated = std::min(firstUpdated, (size_t)index);
                 lastUpdated = std::max(lastUpdated, (size_t)index + curve.indexCount);
 
+                // Curve LOD levels that are not selected get inactive AABBs (NaN min.x), which ray tracing skips.
+                if (!mCurveEnabled[curveID])
+                {
+                    const float nan = std::numeric_limits<float>::quiet_NaN();
+                    std::fill_n(mRtAABBRaw.begin() + index, curve.indexCount, RtAABB{float3(nan), float3(nan)});
+                    index += curve.indexCount;
+                    flags |= IScene::UpdateFlags::CurvesMoved;
+                    continue;
+                }
+
                 const auto* indexData = &mCurveIndexData[curve.ibOffset];
                 const auto* staticData = &mCurveStaticData[curve.vbOffset];
 
@@ -1132,6 +1158,61 @@ namespace Falcor
         return updateFlags;
     }
 
+    IScene::UpdateFlags Scene::updateCurveLODs(bool forceUpdate)
+    {
+        if (mCurveLODs.empty() || mCameras.empty()) return IScene::UpdateFlags::None;
+
+        const IScene::UpdateFlags viewChanges = IScene::UpdateFlags::CameraMoved | IScene::UpdateFlags::CameraPropertiesChanged | IScene::UpdateFlags::CameraSwitched | IScene::UpdateFlags::GeometryMoved;
+        if (!forceUpdate && !is_set(mUpdates, viewChanges) && mCurveLODSettings == mPrevCurveLODSettings) return IScene::UpdateFlags::None;
+        mPrevCurveLODSettings = mCurveLODSettings;
+
+        // A curve can be instanced several times. Collect the matrices of all its instances.
+        std::vector<std::vector<uint32_t>> curveMatrixIDs(mCurveDesc.size());
+        for (const auto& inst : mGeometryInstanceData)
+        {
+            if (inst.getType() == GeometryType::Curve) curveMatrixIDs[inst.geometryID].push_back(inst.globalMatrixID);
+        }
+
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        const auto& pCamera = getCamera();
+        const float3 cameraPosition = pCamera->getPosition();
+        const float fovY = focalLengthToFovY(pCamera->getFocalLength(), pCamera->getFrameHeight());
+        const float projectionScale = ClusterLODBuilder::computeProjectionScale(fovY, mCurveLODSettings.viewportHeight);
+
+        bool selectionChanged = false;
+        for (size_t i = 0; i < mCurveLODs.size(); i++)
+        {
+            const auto& curveLOD = mCurveLODs[i];
+            uint32_t level = 0;
+            if (mCurveLODSettings.enabled)
+            {
+                // The chain is shared by all instances, so use the finest level any of them needs.
+                const uint32_t curveID = curveLOD.curveIDs[0].get();
+                level = (uint32_t)curveLOD.curveIDs.size() - 1;
+                for (uint32_t matrixID : curveMatrixIDs[curveID])
+                {
+                    level = std::min(level, CurveLODBuilder::selectLevel(curveLOD.errors, mCurveBBs[curveID], globalMatrices[matrixID], cameraPosition,
+                        projectionScale, mCurveLODSettings.errorThreshold));
+                }
+            }
+            if (level == mCurveLODLevels[i]) continue;
+
+            mCurveEnabled[curveLOD.curveIDs[mCurveLODLevels[i]].get()] = 0;
+            mCurveEnabled[curveLOD.curveIDs[level].get()] = 1;
+            mCurveLODLevels[i] = level;
+            selectionChanged = true;
+        }
+
+        if (!selectionChanged) return IScene::UpdateFlags::None;
+
+        // Primitives cannot change between active and inactive in a BLAS update.
+        // Mark previous BLAS data as invalid. This will trigger a full BLAS/TLAS rebuild.
+        // TODO: Support partial rebuild of just the procedural primitives.
+        updateRaytracingAABBData(true);
+        mBlasDataValid = false;
+        return IScene::UpdateFlags::CurvesMoved;
+    }
+
     IScene::UpdateFlags Scene::updateProceduralPrimitives(bool forceUpdate)
     {
         // Update the AABB buffer.
@@ -1647,8 +1728,8 @@ namespace Falcor
         // Early out if no volumes have changed.
         if (!forceUpdate && combinedUpdates == GridVolume::UpdateFlags::None) return IScene::UpdateFlags::None;
 
-        // Upload grids.
-        if (forceUpdate)
+        // Upload grids. Streamed grid sequences change the data of their grids when the frame changes.
+        if (forceUpdate || is_set(combinedUpdates, GridVolume::UpdateFlags::GridsChanged))
         {
             bindGridVolumes();
         }
@@ -1864,6 +1945,7 @@ namespace Falcor
         }
 
         mUpdates |= updateSelectedCamera(false);
+        mUpdates |= updateCurveLODs(false);
         mUpdates |= updateLights(false);
         mUpdates |= updateGridVolumes(false);
         mUpdates |= updateEnvMap(false);
@@ -2057,6 +2139,28 @@ namespace Falcor
             }
         }
 
+        if (!mCurveLODs.empty())
+        {
+            if (auto curveLODGroup = widget.group("Curve LOD Settings"))
+            {
+                curveLODGroup.checkbox("Enabled", mCurveLODSettings.enabled);
+                curveLODGroup.tooltip("Select the coarsest level of each curve LOD chain whose projected error is below the threshold.", true);
+                curveLODGroup.var("Error threshold (pixels)", mCurveLODSettings.errorThreshold, 0.f, 64.f, 0.1f);
+                curveLODGroup.var("Viewport height", mCurveLODSettings.viewportHeight, 1u, 16384u);
+
+                std::vector<uint32_t> levelCounts;
+                for (uint32_t level : mCurveLODLevels)
+                {
+                    if (level >= levelCounts.size()) levelCounts.resize(level + 1, 0);
+                    levelCounts[level]++;
+                }
+                for (size_t level = 0; level < levelCounts.size(); level++)
+                {
+                    curveLODGroup.text(fmt::format("Level {}: {} curves", level, levelCounts[level]));
+                }
+            }
+        }
+
         if (auto envMapGroup = widget.group("EnvMap"))
         {
             if (envMapGroup.button("Load"))
@@ -4054,7 +4158,7 @@ namespace Falcor
         mpLoadMeshPass->execute(mpDevice->getRenderContext(), std::max(meshDesc.vertexCount, meshDesc.getTriangleCount()), 1, 1);
     }
 
-    SceneMeshletData* Scene::getMeshletData(RenderContext* pRenderContext)
+    SceneMeshletData* Scene::getMeshletData(RenderContext* pRenderContext, bool buildClusterLOD)
     {
         if (!pRenderContext || getMeshCount() == 0 || getGeometryInstanceCount() == 0)
             return nullptr;
@@ -4062,16 +4166,20 @@ namespace Falcor
         if (!mpMeshletData)
             mpMeshletData = std::make_unique<SceneMeshletData>(mpDevice, this);
 
-        // Only rebuild when scene geometry or transforms have changed
-        const auto meshletRelevantFlags = IScene::UpdateFlags::GeometryChanged | IScene::UpdateFlags::MeshesChanged |
-                                          IScene::UpdateFlags::SceneGraphChanged | IScene::UpdateFlags::DisplacementChanged;
-        const bool needsRebuild =
-            !mpMeshletData->isValid() || is_set(mUpdates, meshletRelevantFlags);
+        // Only rebuild when scene geometry or transforms have changed.
+        // Transform changes keep the per-mesh meshlets and only update the per-instance meshlets.
+        const auto geometryFlags = IScene::UpdateFlags::GeometryChanged | IScene::UpdateFlags::MeshesChanged | IScene::UpdateFlags::DisplacementChanged;
+        const bool geometryChanged = !mpMeshletData->isValid() || is_set(mUpdates, geometryFlags);
+        const bool needsRebuild = geometryChanged || is_set(mUpdates, IScene::UpdateFlags::SceneGraphChanged);
 
         if (needsRebuild)
-            mpMeshletData->build(pRenderContext);
+            mpMeshletData->build(pRenderContext, geometryChanged);
+        if (!mpMeshletData->isValid())
+            return nullptr;
 
-        return mpMeshletData->isValid() ? mpMeshletData.get() : nullptr;
+        if (buildClusterLOD)
+            mpMeshletData->buildClusterLOD();
+        return mpMeshletData.get();
     }
 
     void Scene::setMeshVertices(MeshID meshID, const std::map<std::string, ref<Buffer>>& buffers)
@@ -4095,6 +4203,7 @@ namespace Falcor
 
         // Invalidate meshlet data when mesh vertices change.
         mpMeshletData.reset();
+        mSceneCacheKey.reset();
 
         // Update BLAS/TLAS.
         updateForInverseRendering(mpDevice->getRenderContext(), false, true);
@@ -4301,6 +4410,13 @@ namespace Falcor
             );
         });
 
+        // CurveLODSettings
+        pybind11::class_<Scene::CurveLODSettings> curveLODSettings(m, "SceneCurveLODSettings");
+        curveLODSettings.def(pybind11::init<>());
+        curveLODSettings.def_readwrite("enabled", &Scene::CurveLODSettings::enabled);
+        curveLODSettings.def_readwrite("errorThreshold", &Scene::CurveLODSettings::errorThreshold);
+        curveLODSettings.def_readwrite("viewportHeight", &Scene::CurveLODSettings::viewportHeight);
+
         // Scene
         pybind11::class_<Scene, ref<Scene>> scene(m, "Scene");
 
@@ -4317,6 +4433,7 @@ namespace Falcor
         scene.def_property(kAnimated.c_str(), &Scene::isAnimated, &Scene::setIsAnimated);
         scene.def_property(kLoopAnimations.c_str(), &Scene::isLooped, &Scene::setIsLooped);
         scene.def_property(kRenderSettings.c_str(), pybind11::overload_cast<>(&Scene::getRenderSettings, pybind11::const_), &Scene::setRenderSettings);
+        scene.def_property(kCurveLODSettings.c_str(), &Scene::getCurveLODSettings, &Scene::setCurveLODSettings);
 
         scene.def(kSetEnvMap.c_str(), &Scene::loadEnvMap, "path"_a);
         scene.def(kGetLight.c_str(), &Scene::getLight, "index"_a);
@@ -4329,6 +4446,12 @@ namespace Falcor
             pScene->setCameraBounds(AABB(minPoint, maxPoint));
             }, "minPoint"_a, "maxPoint"_a);
         scene.def("getGeometryUVTiles", &Scene::getGeometryUVTiles, "geometryID"_a);
+        scene.def("selectClusters", [](Scene* pScene, const float3& cameraPosition, float projectionScale, float errorThreshold) {
+            std::vector<uint2> selected;
+            if (auto pMeshletData = pScene->getMeshletData(pScene->getDevice()->getRenderContext(), true))
+                pMeshletData->selectClusters(cameraPosition, projectionScale, errorThreshold, selected);
+            return selected;
+            }, "cameraPosition"_a, "projectionScale"_a, "errorThreshold"_a);
         scene.def_property_readonly("memory_usage", &Scene::getMemoryUsageInBytes);
 
         // Materials
@@ -26,6 +26,7 @@
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/UI/Gui.h"
+#include "Utils/CryptoUtils.h"
 #include "Utils/Settings/Settings.h"
 #include "Utils/SplitBuffer.h"
 
@@ -198,6 +199,31 @@ namespace Falcor
             bool isDisplaced = false;           ///< True if group uses displacement mapping.
         };
 
+        /** LOD chain of a curve.
+            The curves of a chain are alternative representations of the same strands, ordered from finest to coarsest.
+            Exactly one level of each chain is enabled for ray tracing at a time.
+        */
+        struct CurveLOD
+        {
+            std::vector<CurveID> curveIDs;      ///< Curve of each level, finest first.
+            std::vector<float> errors;          ///< Object-space geometric error of each level. Zero on the finest level.
+        };
+
+        /** Runtime selection of curve LOD levels.
+        */
+        struct CurveLODSettings
+        {
+            bool enabled = true;                ///< Select levels by projected error. Otherwise the finest levels are used.
+            float errorThreshold = 1.f;         ///< Max acceptable projected error in pixels.
+            uint32_t viewportHeight = 1080;     ///< Viewport height in pixels used to project the errors.
+
+            bool operator==(const CurveLODSettings& other) const
+            {
+                return enabled == other.enabled && errorThreshold == other.errorThreshold && viewportHeight == other.viewportHeight;
+            }
+            bool operator!=(const CurveLODSettings& other) const { return !(*this == other); }
+        };
+
         /** Scene graph node.
         */
         struct Node
@@ -219,6 +245,7 @@ namespace Falcor
             using ImportDict = std::map<std::string, std::string>;
             std::vector<std::filesystem::path> importPaths;         ///< Paths of the asset files the scene was loaded from.
             std::vector<ImportDict> importDicts;                    ///< Dictionaries used to load each asset in importPaths.
+            std::optional<SHA1::MD> sceneCacheKey;                  ///< Key of the scene cache the scene was loaded from or written to, if any. Not serialized.
             RenderSettings renderSettings;                          ///< Render settings.
             std::vector<ref<Camera>> cameras;                       ///< List of cameras.
             uint32_t selectedCamera = 0;                            ///< Index of selected camera.
@@ -262,6 +289,7 @@ namespace Falcor
             std::vector<uint32_t> curveIndexData;                   ///< Vertex indices for all curves in 32-bit.
             std::vector<StaticCurveVertexData> curveStaticData;     ///< Vertex attributes for all curves.
             std::vector<CachedCurve> cachedCurves;                  ///< Vertex cache for dynamic (vertex animated) curves.
+            std::vector<CurveLOD> curveLODs;                        ///< List of curve LOD chains.
 
             // SDF grid data
             std::vector<ref<SDFGrid>> sdfGrids;                     ///< List of SDF grids.
@@ -637,9 +665,16 @@ namespace Falcor
         /** Get meshlet data for mesh shader rendering. Builds lazily on first access.
             Supports multiple mesh instances. Returns nullptr if no triangle mesh geometry.
             \param[in] pRenderContext Render context for building.
+            \param[in] buildClusterLOD Also build the cluster LOD DAGs of all meshes after the meshlets (see SceneMeshletData::buildClusterLOD()).
             \return SceneMeshletData with GPU buffers, or nullptr.
         */
-        SceneMeshletData* getMeshletData(RenderContext* pRenderContext);
+        SceneMeshletData* getMeshletData(RenderContext* pRenderContext, bool buildClusterLOD = false);
+
+        /** Get the key of the scene cache the scene was loaded from or written to.
+            The key is reset when mesh vertices are modified, as the geometry no longer matches the cache.
+            \return The scene cache key, or an empty optional if the scene does not use the scene cache.
+        */
+        const std::optional<SHA1::MD>& getSceneCacheKey() const { return mSceneCacheKey; }
 
         /** Set mesh vertex data and update the acceleration structures.
             \param[in] meshID Mesh ID.
@@ -655,6 +690,22 @@ namespace Falcor
         */
         const CurveDesc& getCurve(CurveID curveID) const { return mCurveDesc[curveID.get()]; }
 
+        /** Get the curve LOD chains.
+        */
+        const std::vector<CurveLOD>& getCurveLODs() const { return mCurveLODs; }
+
+        /** Get the currently selected level of a curve LOD chain.
+        */
+        uint32_t getCurveLODLevel(uint32_t curveLODIndex) const { return mCurveLODLevels[curveLODIndex]; }
+
+        /** Set the curve LOD selection settings. Changing the selection rebuilds the acceleration structures.
+        */
+        void setCurveLODSettings(const CurveLODSettings& settings) { mCurveLODSettings = settings; }
+
+        /** Get the curve LOD selection settings.
+        */
+        const CurveLODSettings& getCurveLODSettings() const { return mCurveLODSettings; }
+
         /** Returns what SDF grid implementation is used for this scene.
         */
         SDFGrid::Type getSDFGridImplementation() const { return mSDFGridConfig.implementation; }
@@ -1186,6 +1237,7 @@ namespace Falcor
         IScene::UpdateFlags updateRaytracingAABBData(bool forceUpdate);
         IScene::UpdateFlags updateDisplacement(RenderContext* pRenderContext, bool forceUpdate);
         IScene::UpdateFlags updateSDFGrids(RenderContext* pRenderContext);
+        IScene::UpdateFlags updateCurveLODs(bool forceUpdate);
 
         void updateGeometryStats();
         void updateMaterialStats();
@@ -1238,6 +1290,7 @@ namespace Falcor
         std::vector<Node> mSceneGraph;                              ///< For each index i, the array element indicates the parent node. Indices are in relation to mLocalToWorldMatrices.
 
         std::unique_ptr<SceneMeshletData> mpMeshletData;            ///< Meshlet data for mesh shader rendering (built lazily).
+        std::optional<SHA1::MD> mSceneCacheKey;                     ///< Scene cache key, used to cache the meshlet data.
 
         /// For Python bindings of triangle meshes.
         ref<ComputePass> mpLoadMeshPass;
@@ -1259,6 +1312,11 @@ namespace Falcor
         std::vector<CurveDesc> mCurveDesc;                          ///< Copy of curve data GPU buffer (mpCurvesBuffer).
         std::vector<uint32_t> mCurveIndexData;                      ///< Vertex indices for all curves in 32-bit.
         std::vector<StaticCurveVertexData> mCurveStaticData;        ///< Vertex attributes for all curves.
+        std::vector<CurveLOD> mCurveLODs;                           ///< Curve LOD chains.
+        std::vector<uint32_t> mCurveLODLevels;                      ///< Selected level of each curve LOD chain.
+        std::vector<uint8_t> mCurveEnabled;                         ///< Per curve flag, false for curve LOD levels that are not selected. Disabled curves have inactive AABBs.
+        CurveLODSettings mCurveLODSettings;                         ///< Curve LOD selection settings.
+        CurveLODSettings mPrevCurveLODSettings;                     ///< Curve LOD selection settings used for the current selection.
 
         // SDF grids
         std::vector<ref<SDFGrid>> mSDFGrids;                        ///< List of SDF grids.
@@ -8,6 +8,7 @@
 #include "Utils/Image/TextureAnalyzer.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Scripting/ScriptBindings.h"
+#include "Utils/Scripting/ndarray.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/ObjectIDPython.h"
 #include "Utils/NumericRange.h"
@@ -164,7 +165,7 @@ namespace Falcor
             return indexData;
         }
 
-        SceneCache::Key computeSceneCacheKey(const std::filesystem::path& path, SceneBuilder::Flags buildFlags)
+        SceneCache::Key computeResolvedSceneCacheKey(const std::filesystem::path& path, SceneBuilder::Flags buildFlags)
         {
             SceneBuilder::Flags cacheFlags = buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache));
             SHA1 sha1;
@@ -174,6 +175,68 @@ namespace Falcor
             return sha1.finalize();
 
         }
+
+        using Float2Array = pybind11::ndarray<float, pybind11::shape<pybind11::any, 2>, pybind11::c_contig, pybind11::device::cpu>;
+        using Float3Array = pybind11::ndarray<float, pybind11::shape<pybind11::any, 3>, pybind11::c_contig, pybind11::device::cpu>;
+        using Float4Array = pybind11::ndarray<float, pybind11::shape<pybind11::any, 4>, pybind11::c_contig, pybind11::device::cpu>;
+        using IndexArray = pybind11::ndarray<uint32_t, pybind11::c_contig, pybind11::device::cpu>;
+
+        /** Add a mesh from numpy arrays.
+            The arrays are passed to the scene builder in place. Arrays with other element types or layouts are converted by numpy.
+        */
+        MeshID addMeshFromNumpy(
+            SceneBuilder& sceneBuilder,
+            const Float3Array& positions,
+            const IndexArray& indices,
+            const ref<Material>& pMaterial,
+            const std::optional<Float3Array>& normals,
+            const std::optional<Float2Array>& texCoords,
+            const std::optional<Float4Array>& tangents,
+            const std::string& name,
+            bool isAnimated
+        )
+        {
+            size_t indexCount = 1;
+            for (size_t i = 0; i < indices.ndim(); ++i) indexCount *= indices.shape(i);
+            const size_t vertexCount = positions.shape(0);
+
+            FALCOR_CHECK(indexCount % 3 == 0, "'indices' must contain three indices per triangle (got {}).", indexCount);
+            FALCOR_CHECK(vertexCount <= std::numeric_limits<uint32_t>::max() && indexCount <= std::numeric_limits<uint32_t>::max(), "Mesh '{}' is too large.", name);
+            auto checkCount = [&](const auto& array, const char* arrayName)
+            {
+                FALCOR_CHECK(!array || array->shape(0) == vertexCount, "'{}' must have one element per vertex (expected {}, got {}).", arrayName, vertexCount, array->shape(0));
+            };
+            checkCount(normals, "normals");
+            checkCount(texCoords, "texCoords");
+            checkCount(tangents, "tangents");
+
+            const uint32_t* pIndices = indices.data();
+            FALCOR_CHECK(std::none_of(std::execution::par_unseq, pIndices, pIndices + indexCount, [&](uint32_t index) { return index >= vertexCount; }),
+                "'indices' contains out of range vertex indices.");
+
+            SceneBuilder::Mesh mesh;
+            mesh.name = name;
+            mesh.faceCount = (uint32_t)(indexCount / 3);
+            mesh.vertexCount = (uint32_t)vertexCount;
+            mesh.indexCount = (uint32_t)indexCount;
+            mesh.pIndices = pIndices;
+            mesh.topology = Vao::Topology::TriangleList;
+            mesh.pMaterial = pMaterial;
+            mesh.isAnimated = isAnimated;
+
+            mesh.positions = { reinterpret_cast<const float3*>(positions.data()), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            if (normals) mesh.normals = { reinterpret_cast<const float3*>(normals->data()), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            if (texCoords) mesh.texCrds = { reinterpret_cast<const float2*>(texCoords->data()), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+            if (tangents)
+            {
+                mesh.tangents = { reinterpret_cast<const float4*>(tangents->data()), SceneBuilder::Mesh::AttributeFrequency::Vertex };
+                mesh.useOriginalTangentSpace = true;
+            }
+
+            // The arrays are kept alive by the caller, so the GIL can be released while the mesh is processed.
+            pybind11::gil_scoped_release release;
+            return sceneBuilder.addMesh(mesh);
+        }
     }
 
     SceneBuilder::SceneBuilder(ref<Device> pDevice, const Settings& settings, Flags flags)
@@ -195,7 +258,7 @@ namespace Falcor
         }
 
         // Compute scene cache key based on absolute scene path and build flags.
-        mSceneCacheKey = computeSceneCacheKey(resolvedPath, flags);
+        mSceneCacheKey = computeResolvedSceneCacheKey(resolvedPath, flags);
 
         // Determine if scene cache should be written after import.
         bool useCache = is_set(flags, Flags::UseCache);
@@ -207,7 +270,9 @@ namespace Falcor
         {
             try
             {
-                mpScene = Scene::create(pDevice, SceneCache::readCache(pDevice, mSceneCacheKey));
+                auto sceneData = SceneCache::readCache(pDevice, mSceneCacheKey);
+                sceneData.sceneCacheKey = mSceneCacheKey;
+                mpScene = Scene::create(pDevice, std::move(sceneData));
                 return;
             }
             catch (const std::exception& e)
@@ -227,6 +292,13 @@ namespace Falcor
 
     SceneBuilder::~SceneBuilder() {}
 
+    std::optional<SceneCache::Key> SceneBuilder::computeSceneCacheKey(const std::filesystem::path& path, Flags flags)
+    {
+        std::filesystem::path resolvedPath = AssetResolver::getDefaultResolver().resolvePath(path, AssetCategory::Scene);
+        if (resolvedPath.empty()) return {};
+        return computeResolvedSceneCacheKey(resolvedPath, flags);
+    }
+
     inline std::map<std::string, std::string> convertDictToMap(const pybind11::dict& dict_)
     {
         std::map<std::string, std::string> dict;
@@ -301,7 +373,7 @@ namespace Falcor
         if (mpScene) return mpScene;
 
         // Finish loading textures. This blocks until all textures are loaded and assigned.
-        mpMaterialTextureLoader.reset();
+        waitForMaterialTextureLoading();
 
         // If no meshes were added, we create a dummy mesh to keep the scene generation working.
         // Scenes with no meshes can be useful for example when using volumes in isolation.
@@ -368,6 +440,7 @@ namespace Falcor
         if (mWriteSceneCache)
         {
             SceneCache::writeCache(mSceneData, mSceneCacheKey);
+            mSceneData.sceneCacheKey = mSceneCacheKey;
             timeReport.measure("Writing cache");
         }
 
@@ -865,15 +938,39 @@ namespace Falcor
         return CurveID(mCurves.size() - 1);
     }
 
+    void SceneBuilder::addCurveLOD(const std::vector<CurveID>& curveIDs, const std::vector<float>& errors)
+    {
+        FALCOR_CHECK(!curveIDs.empty(), "Curve LOD chain is empty");
+        FALCOR_CHECK(curveIDs.size() == errors.size(), "Curve LOD chain has {} curves but {} errors", curveIDs.size(), errors.size());
+        for (size_t level = 0; level < curveIDs.size(); level++)
+        {
+            FALCOR_CHECK(curveIDs[level].get() < mCurves.size(), "'curveID' ({}) is out of range", curveIDs[level]);
+            FALCOR_CHECK(level == 0 || errors[level] >= errors[level - 1], "Curve LOD errors must be non-decreasing");
+            FALCOR_CHECK(!hasCurveVertexCache(curveIDs[level]), "Curve {} has a vertex cache and cannot be part of a curve LOD chain", curveIDs[level]);
+        }
+
+        mSceneData.curveLODs.push_back({curveIDs, errors});
+    }
+
     void SceneBuilder::addCachedCurves(std::vector<CachedCurve>&& cachedCurves)
     {
         mSceneData.cachedCurves.reserve(mSceneData.cachedCurves.size() + cachedCurves.size());
         for (auto&& it : cachedCurves)
-            mSceneData.cachedCurves.push_back(std::move(it));
+            addCachedCurve(std::move(it));
     }
 
     void SceneBuilder::addCachedCurve(CachedCurve&& cachedCurve)
     {
+        // Animated curve AABBs are rewritten on the GPU, which would make the hidden levels of a curve LOD chain visible.
+        if (cachedCurve.tessellationMode == CurveTessellationMode::LinearSweptSphere)
+        {
+            const CurveID curveID{ cachedCurve.geometryID };
+            for (const auto& curveLOD : mSceneData.curveLODs)
+            {
+                FALCOR_CHECK(std::find(curveLOD.curveIDs.begin(), curveLOD.curveIDs.end(), curveID) == curveLOD.curveIDs.end(),
+                    "Curve {} is part of a curve LOD chain and cannot have a vertex cache", curveID);
+            }
+        }
         mSceneData.cachedCurves.push_back(std::move(cachedCurve));
     }
 
@@ -895,6 +992,24 @@ namespace Falcor
         return SdfDescID(mSceneData.sdfGridDesc.size() - 1);
     }
 
+    SdfDescID SceneBuilder::addSDFGridFromMesh(const ref<SDFGrid>& pSDFGrid, const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, uint32_t gridWidth,
+        const SDFMeshConverter::Options& options)
+    {
+        FALCOR_CHECK(pSDFGrid != nullptr, "'pSDFGrid' is missing");
+        FALCOR_CHECK(pTriangleMesh != nullptr, "'pTriangleMesh' is missing");
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        std::vector<float> cornerValues = SDFMeshConverter::computeCornerValues(*pTriangleMesh, gridWidth, options);
+        pSDFGrid->setValues(cornerValues, gridWidth);
+        logInfo(
+            "Converted triangle mesh '{}' ({} triangles) to a SDF grid of width {} in {:.1f} ms.",
+            pTriangleMesh->getName(), pTriangleMesh->getIndices().size() / 3, gridWidth,
+            CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint())
+        );
+
+        return addSDFGrid(pSDFGrid, pMaterial);
+    }
+
     // Materials
 
     MaterialID SceneBuilder::addMaterial(const ref<Material>& pMaterial)
@@ -921,8 +1036,14 @@ namespace Falcor
         mpMaterialTextureLoader->loadTexture(pMaterial, slot, resolvedPath);
     }
 
+    void SceneBuilder::startMaterialTextureLoading()
+    {
+        if (mpMaterialTextureLoader) mpMaterialTextureLoader->startLoading();
+    }
+
     void SceneBuilder::waitForMaterialTextureLoading()
     {
+        if (mpMaterialTextureLoader) mpMaterialTextureLoader->finishLoading();
         mpMaterialTextureLoader.reset();
     }
 
@@ -1756,6 +1877,12 @@ namespace Falcor
         }
     }
 
+    bool SceneBuilder::hasCurveVertexCache(CurveID curveID) const
+    {
+        return std::any_of(mSceneData.cachedCurves.begin(), mSceneData.cachedCurves.end(), [curveID](const CachedCurve& cache)
+            { return cache.tessellationMode == CurveTessellationMode::LinearSweptSphere && CurveID{ cache.geometryID } == curveID; });
+    }
+
     void SceneBuilder::unifyTriangleWinding()
     {
         // This function makes the triangle winding for all meshes consistent in object space,
@@ -2935,6 +3062,7 @@ namespace Falcor
         flags.value("DontUseDisplacement", SceneBuilder::Flags::DontUseDisplacement);
         flags.value("UseCompressedHitInfo", SceneBuilder::Flags::UseCompressedHitInfo);
         flags.value("TessellateCurvesIntoPolyTubes", SceneBuilder::Flags::TessellateCurvesIntoPolyTubes);
+        flags.value("GenerateCurveLODs", SceneBuilder::Flags::GenerateCurveLODs);
         flags.value("UseCache", SceneBuilder::Flags::UseCache);
         flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
         ScriptBindings::addEnumBinaryOperators(flags);
@@ -2953,7 +3081,24 @@ namespace Falcor
         sceneBuilder.def_property("cameraSpeed", &SceneBuilder::getCameraSpeed, &SceneBuilder::setCameraSpeed);
         sceneBuilder.def("importScene", &SceneBuilder::import, "path"_a, "dict"_a = pybind11::dict());
         sceneBuilder.def("addTriangleMesh", &SceneBuilder::addTriangleMesh, "triangleMesh"_a, "material"_a, "isAnimated"_a = false);
+        sceneBuilder.def("addMesh", addMeshFromNumpy, "positions"_a, "indices"_a, "material"_a,
+            "normals"_a = pybind11::none(), "texCoords"_a = pybind11::none(), "tangents"_a = pybind11::none(), "name"_a = "", "isAnimated"_a = false);
         sceneBuilder.def("addSDFGrid", &SceneBuilder::addSDFGrid, "sdfGrid"_a, "material"_a);
+        sceneBuilder.def("addSDFGridFromMesh",
+            [](SceneBuilder* pSceneBuilder, const ref<SDFGrid>& pSDFGrid, const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial,
+                uint32_t gridWidth, float narrowBandThickness, bool fitToGrid, float padding, float windingNumberAccuracy)
+            {
+                SDFMeshConverter::Options options;
+                options.narrowBandThickness = narrowBandThickness;
+                options.fitToGrid = fitToGrid;
+                options.padding = padding;
+                options.windingNumberAccuracy = windingNumberAccuracy;
+                return pSceneBuilder->addSDFGridFromMesh(pSDFGrid, pTriangleMesh, pMaterial, gridWidth, options);
+            },
+            "sdfGrid"_a, "triangleMesh"_a, "material"_a, "gridWidth"_a, "narrowBandThickness"_a = SDFMeshConverter::Options().narrowBandThickness,
+            "fitToGrid"_a = SDFMeshConverter::Options().fitToGrid, "padding"_a = SDFMeshConverter::Options().padding,
+            "windingNumberAccuracy"_a = SDFMeshConverter::Options().windingNumberAccuracy
+        );
         sceneBuilder.def("addMaterial", &SceneBuilder::addMaterial, "material"_a);
         sceneBuilder.def("replaceMaterial", &SceneBuilder::replaceMaterial, "material"_a, "replacement"_a);
         sceneBuilder.def("getMaterial", &SceneBuilder::getMaterial, "name"_a);
@@ -4,6 +4,7 @@
 #include "SceneIDs.h"
 #include "Transform.h"
 #include "TriangleMesh.h"
+#include "SDFs/SDFMeshConverter.h"
 #include "VertexAttrib.slangh"
 #include "SceneTypes.slang"
 #include "Material/MaterialTextureLoader.h"
@@ -20,6 +21,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -50,6 +52,7 @@ namespace Falcor
             DontUseDisplacement             = 0x4000,   ///< Don't use displacement mapping.
             UseCompressedHitInfo            = 0x8000,   ///< Use compressed hit info (on scenes with triangle meshes only).
             TessellateCurvesIntoPolyTubes   = 0x10000,  ///< Tessellate curves into poly-tubes (the default is linear swept spheres).
+            GenerateCurveLODs               = 0x20000,  ///< Generate LOD chains for linear swept sphere curves. The level of each chain is selected at runtime by projected error.
 
             UseCache                        = 0x10000000, ///< Enable scene caching. This caches the runtime scene representation on disk to reduce load time.
             RebuildCache                    = 0x20000000, ///< Rebuild scene cache.
@@ -346,6 +349,14 @@ namespace Falcor
         */
         ref<Scene> getScene();
 
+        /** Compute the scene cache key used when loading a scene file.
+            This allows to look up caches of a scene (see SceneCache) without building it.
+            \param[in] path Scene file path. Relative paths are resolved with the default asset resolver.
+            \param[in] flags Build flags.
+            \return The scene cache key or an empty optional if the scene file can't be found.
+        */
+        static std::optional<SceneCache::Key> computeSceneCacheKey(const std::filesystem::path& path, Flags flags);
+
         const ref<Device>& getDevice() const { return mpDevice; }
 
         const Settings& getSettings() const { return mSettings; }
@@ -459,6 +470,16 @@ namespace Falcor
         void addCachedCurves(std::vector<CachedCurve>&& cachedCurves);
         void addCachedCurve(CachedCurve&& cachedCurves);
 
+        /** Add a curve LOD chain.
+            The curves are alternative representations of the same strands and should all be instanced by the same node.
+            The scene enables one level of each chain at runtime, based on the projected error.
+            Curves with vertex caches (see addCachedCurve()) cannot be part of a chain.
+            Throws an exception if something went wrong.
+            \param[in] curveIDs Curve of each level, ordered from finest to coarsest.
+            \param[in] errors Object-space geometric error of each level. The errors must be non-decreasing.
+        */
+        void addCurveLOD(const std::vector<CurveID>& curveIDs, const std::vector<float>& errors);
+
         // SDFs
 
         /** Add an SDF grid.
@@ -468,6 +489,19 @@ namespace Falcor
         */
         SdfDescID addSDFGrid(const ref<SDFGrid>& pSDFGrid, const ref<Material>& pMaterial);
 
+        /** Add an SDF grid with values converted from a triangle mesh (see SDFMeshConverter).
+            Throws an exception if something went wrong.
+            \param pSDFGrid The SDF grid. Its values are replaced by the converted ones.
+            \param pTriangleMesh The triangle mesh. With options.fitToGrid, the mesh is scaled and translated uniformly to fit the grid,
+                   and SDFMeshConverter::computeInstanceTransform() gives the transform that places the SDF grid instance at the location of the mesh.
+            \param pMaterial The material to be used by this SDF grid.
+            \param gridWidth The width of the SDF grid in voxels.
+            \param options Conversion options.
+            \return The ID of the SDF grid desc in the scene.
+        */
+        SdfDescID addSDFGridFromMesh(const ref<SDFGrid>& pSDFGrid, const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, uint32_t gridWidth,
+            const SDFMeshConverter::Options& options = {});
+
         // Materials
 
         /** Get the list of materials.
@@ -500,6 +534,12 @@ namespace Falcor
         */
         void loadMaterialTexture(const ref<Material>& pMaterial, Material::TextureSlot slot, const std::filesystem::path& path);
 
+        /** Start loading the requested material textures in the background.
+            This allows importers to convert geometry while textures are loading.
+            No other GPU operations may be executed until calling waitForMaterialTextureLoading().
+        */
+        void startMaterialTextureLoading();
+
         /** Wait until all material textures are loaded.
         */
         void waitForMaterialTextureLoading();
@@ -767,6 +807,7 @@ namespace Falcor
         bool mergeNodes(NodeID dstNodeID, NodeID srcNodeID);
         void flipTriangleWinding(MeshSpec& mesh);
         void updateSDFGridID(SdfGridID oldID, SdfGridID newID);
+        bool hasCurveVertexCache(CurveID curveID) const;
 
         /** Split a mesh by the given axis-aligned splitting plane.
             \return Pair of optional mesh IDs for the meshes on the left and right side, respectively.
@@ -7,6 +7,7 @@
 
 #include <lz4_stream/lz4_stream.h>
 
+#include <algorithm>
 #include <fstream>
 
 namespace Falcor
@@ -16,7 +17,7 @@ namespace Falcor
         /** Specfies the current cache file version.
             This needs to be incremented every time the file format changes!
         */
-        const uint32_t kVersion = 25;
+        const uint32_t kVersion = 27;
 
         /** Scene cache directory (subdirectory in the application data directory).
         */
@@ -24,6 +25,11 @@ namespace Falcor
 
         const size_t kBlockSize = 1 * 1024 * 1024;
 
+        /** Extensions of the sidecar caches written by the scene cache.
+        */
+        const std::string kMeshletCacheExtension = ".meshlets";
+        const std::string kClusterLODCacheExtension = ".clusterlod";
+
         const char* kMagic = "FalcorS$";
         struct Header
         {
@@ -35,6 +41,84 @@ namespace Falcor
                 return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
             }
         };
+
+        /** Specifies the current meshlet cache file version.
+            This needs to be incremented every time the meshlet cache format or the meshlet building changes!
+        */
+        const uint32_t kMeshletVersion = 1;
+
+        const char* kMeshletMagic = "FalcorM$";
+        struct MeshletHeader
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+            uint32_t maxVerticesPerMeshlet{};
+            uint32_t maxTrianglesPerMeshlet{};
+            float coneWeight{};
+
+            bool isValid() const
+            {
+                return std::memcmp(magic, kMeshletMagic, sizeof(MeshletHeader::magic)) == 0 && version == kMeshletVersion &&
+                    maxVerticesPerMeshlet == SceneMeshletData::kMaxVerticesPerMeshlet &&
+                    maxTrianglesPerMeshlet == SceneMeshletData::kMaxTrianglesPerMeshlet &&
+                    coneWeight == SceneMeshletData::kConeWeight;
+            }
+        };
+
+        /** Checks that the per-meshlet arrays of a mesh are consistent and that all meshlets are within the mesh's data.
+        */
+        bool isValidMeshletData(const MeshMeshletData& meshData)
+        {
+            const size_t meshletCount = meshData.meshletVertexCount.size();
+            if (meshData.meshletVertexOffset.size() != meshletCount || meshData.meshletTriangleOffset.size() != meshletCount ||
+                meshData.meshletTriangleCount.size() != meshletCount || meshData.meshletBoundCenter.size() != meshletCount ||
+                meshData.meshletBoundRadius.size() != meshletCount)
+                return false;
+
+            for (size_t i = 0; i < meshletCount; ++i)
+            {
+                const uint64_t vertexCount = meshData.meshletVertexCount[i];
+                const uint64_t triangleCount = meshData.meshletTriangleCount[i];
+                if (vertexCount > SceneMeshletData::kMaxVerticesPerMeshlet || triangleCount > SceneMeshletData::kMaxTrianglesPerMeshlet)
+                    return false;
+                if ((uint64_t)meshData.meshletVertexOffset[i] + vertexCount > meshData.meshletVertices.size() ||
+                    (uint64_t)meshData.meshletTriangleOffset[i] + triangleCount * 3 > meshData.meshletTriangles.size())
+                    return false;
+            }
+            return true;
+        }
+
+        /** Checks that all clusters of a cluster LOD DAG are within the DAG's data and levels.
+        */
+        bool isValidClusterLOD(const MeshClusterLOD& clusterLOD)
+        {
+            return std::all_of(clusterLOD.clusters.begin(), clusterLOD.clusters.end(), [&](const ClusterLODCluster& cluster)
+                {
+                    return cluster.level < clusterLOD.levelCount &&
+                        (uint64_t)cluster.vertexOffset + cluster.vertexCount <= clusterLOD.vertices.size() &&
+                        (uint64_t)cluster.triangleOffset + (uint64_t)cluster.triangleCount * 3 <= clusterLOD.triangles.size();
+                });
+        }
+
+        /** Specifies the current cluster LOD cache file version.
+            This needs to be incremented every time the cluster LOD cache format or the cluster LOD building changes!
+        */
+        const uint32_t kClusterLODVersion = 1;
+
+        const char* kClusterLODMagic = "FalcorL$";
+        struct ClusterLODHeader
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+            ClusterLODBuilder::Options options;
+
+            bool isValid() const
+            {
+                const auto expectedOptions = SceneMeshletData::getClusterLODOptions();
+                return std::memcmp(magic, kClusterLODMagic, sizeof(ClusterLODHeader::magic)) == 0 && version == kClusterLODVersion &&
+                    std::memcmp(&options, &expectedOptions, sizeof(options)) == 0;
+            }
+        };
     }
 
     /** Wrapper around std::ostream to ease serialization of basic types.
@@ -212,6 +296,18 @@ namespace Falcor
         // Create directories if not existing.
         std::filesystem::create_directories(cachePath.parent_path());
 
+        // Remove the sidecar caches of a previous scene cache with the same key.
+        const std::string sidecarPrefix = cachePath.filename().string() + ".";
+        std::vector<std::filesystem::path> sidecarPaths;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(cachePath.parent_path(), ec))
+        {
+            if (entry.path().filename().string().rfind(sidecarPrefix, 0) == 0)
+                sidecarPaths.push_back(entry.path());
+        }
+        for (const auto& path : sidecarPaths)
+            std::filesystem::remove(path, ec);
+
         // Open file.
         std::ofstream fs(cachePath.c_str(), std::ios_base::binary);
         if (fs.bad()) FALCOR_THROW("Failed to create scene cache file '{}'.", cachePath);
@@ -252,11 +348,216 @@ namespace Falcor
         return sceneData;
     }
 
+    void SceneCache::writeMeshletCache(const Key& key, const std::vector<MeshMeshletData>& meshletData)
+    {
+        auto cachePath = getSidecarCachePath(key, kMeshletCacheExtension);
+
+        logInfo("Writing meshlet cache to '{}'.", cachePath);
+
+        // Create directories if not existing.
+        std::filesystem::create_directories(cachePath.parent_path());
+
+        // Open file.
+        std::ofstream fs(cachePath.c_str(), std::ios_base::binary);
+        if (fs.bad())
+        {
+            logWarning("Failed to create meshlet cache file '{}'.", cachePath);
+            return;
+        }
+
+        // Write header (uncompressed).
+        MeshletHeader header;
+        std::memcpy(header.magic, kMeshletMagic, sizeof(MeshletHeader::magic));
+        header.version = kMeshletVersion;
+        header.maxVerticesPerMeshlet = (uint32_t)SceneMeshletData::kMaxVerticesPerMeshlet;
+        header.maxTrianglesPerMeshlet = (uint32_t)SceneMeshletData::kMaxTrianglesPerMeshlet;
+        header.coneWeight = SceneMeshletData::kConeWeight;
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Write cache (compressed).
+        {
+            lz4_stream::basic_ostream<kBlockSize> zs(fs);
+            OutputStream stream(zs);
+            stream.write((uint64_t)meshletData.size());
+            for (const auto& meshData : meshletData)
+            {
+                stream.write(meshData.meshletVertices);
+                stream.write(meshData.meshletTriangles);
+                stream.write(meshData.meshletVertexOffset);
+                stream.write(meshData.meshletTriangleOffset);
+                stream.write(meshData.meshletVertexCount);
+                stream.write(meshData.meshletTriangleCount);
+                stream.write(meshData.meshletBoundCenter);
+                stream.write(meshData.meshletBoundRadius);
+            }
+        }
+        if (fs.bad())
+        {
+            logWarning("Failed to write meshlet cache file to '{}'.", cachePath);
+            fs.close();
+            std::filesystem::remove(cachePath);
+        }
+    }
+
+    bool SceneCache::readMeshletCache(const Key& key, std::vector<MeshMeshletData>& meshletData)
+    {
+        auto cachePath = getSidecarCachePath(key, kMeshletCacheExtension);
+        if (!std::filesystem::exists(cachePath)) return false;
+
+        // Open file.
+        std::ifstream fs(cachePath.c_str(), std::ios_base::binary);
+        if (fs.bad()) return false;
+
+        // Read header (uncompressed).
+        MeshletHeader header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (fs.eof() || !header.isValid()) return false;
+
+        logInfo("Loading meshlet cache from '{}'.", cachePath);
+
+        // Read cache (compressed). A corrupt cache is removed, so that the meshlets are rebuilt and cached again.
+        bool valid = false;
+        try
+        {
+            lz4_stream::basic_istream<kBlockSize, kBlockSize> zs(fs);
+            InputStream stream(zs);
+            meshletData.resize(stream.read<uint64_t>());
+            for (auto& meshData : meshletData)
+            {
+                stream.read(meshData.meshletVertices);
+                stream.read(meshData.meshletTriangles);
+                stream.read(meshData.meshletVertexOffset);
+                stream.read(meshData.meshletTriangleOffset);
+                stream.read(meshData.meshletVertexCount);
+                stream.read(meshData.meshletTriangleCount);
+                stream.read(meshData.meshletBoundCenter);
+                stream.read(meshData.meshletBoundRadius);
+            }
+            valid = !zs.fail() && !fs.bad() && std::all_of(meshletData.begin(), meshletData.end(), isValidMeshletData);
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Failed to read meshlet cache file from '{}': {}", cachePath, e.what());
+        }
+
+        if (!valid)
+        {
+            logWarning("Removing invalid meshlet cache file '{}'.", cachePath);
+            meshletData.clear();
+            fs.close();
+            std::error_code ec;
+            std::filesystem::remove(cachePath, ec);
+            return false;
+        }
+        return true;
+    }
+
+    void SceneCache::writeClusterLODCache(const Key& key, const std::vector<MeshClusterLOD>& clusterLOD)
+    {
+        auto cachePath = getSidecarCachePath(key, kClusterLODCacheExtension);
+
+        logInfo("Writing cluster LOD cache to '{}'.", cachePath);
+
+        // Create directories if not existing.
+        std::filesystem::create_directories(cachePath.parent_path());
+
+        // Open file.
+        std::ofstream fs(cachePath.c_str(), std::ios_base::binary);
+        if (fs.bad())
+        {
+            logWarning("Failed to create cluster LOD cache file '{}'.", cachePath);
+            return;
+        }
+
+        // Write header (uncompressed).
+        ClusterLODHeader header;
+        std::memcpy(header.magic, kClusterLODMagic, sizeof(ClusterLODHeader::magic));
+        header.version = kClusterLODVersion;
+        header.options = SceneMeshletData::getClusterLODOptions();
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Write cache (compressed).
+        {
+            lz4_stream::basic_ostream<kBlockSize> zs(fs);
+            OutputStream stream(zs);
+            stream.write((uint64_t)clusterLOD.size());
+            for (const auto& meshClusterLOD : clusterLOD)
+            {
+                stream.write(meshClusterLOD.vertices);
+                stream.write(meshClusterLOD.triangles);
+                stream.write(meshClusterLOD.clusters);
+                stream.write(meshClusterLOD.levelCount);
+            }
+        }
+        if (fs.bad())
+        {
+            logWarning("Failed to write cluster LOD cache file to '{}'.", cachePath);
+            fs.close();
+            std::filesystem::remove(cachePath);
+        }
+    }
+
+    bool SceneCache::readClusterLODCache(const Key& key, std::vector<MeshClusterLOD>& clusterLOD)
+    {
+        auto cachePath = getSidecarCachePath(key, kClusterLODCacheExtension);
+        if (!std::filesystem::exists(cachePath)) return false;
+
+        // Open file.
+        std::ifstream fs(cachePath.c_str(), std::ios_base::binary);
+        if (fs.bad()) return false;
+
+        // Read header (uncompressed).
+        ClusterLODHeader header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (fs.eof() || !header.isValid()) return false;
+
+        logInfo("Loading cluster LOD cache from '{}'.", cachePath);
+
+        // Read cache (compressed). A corrupt cache is removed, so that the DAGs are rebuilt and cached again.
+        bool valid = false;
+        try
+        {
+            lz4_stream::basic_istream<kBlockSize, kBlockSize> zs(fs);
+            InputStream stream(zs);
+            clusterLOD.resize(stream.read<uint64_t>());
+            for (auto& meshClusterLOD : clusterLOD)
+            {
+                stream.read(meshClusterLOD.vertices);
+                stream.read(meshClusterLOD.triangles);
+                stream.read(meshClusterLOD.clusters);
+                stream.read(meshClusterLOD.levelCount);
+            }
+            valid = !zs.fail() && !fs.bad() && std::all_of(clusterLOD.begin(), clusterLOD.end(), isValidClusterLOD);
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Failed to read cluster LOD cache file from '{}': {}", cachePath, e.what());
+        }
+
+        if (!valid)
+        {
+            logWarning("Removing invalid cluster LOD cache file '{}'.", cachePath);
+            clusterLOD.clear();
+            fs.close();
+            std::error_code ec;
+            std::filesystem::remove(cachePath, ec);
+            return false;
+        }
+        return true;
+    }
+
     std::filesystem::path SceneCache::getCachePath(const Key& key)
     {
         return getAppDataDirectory() / kDirectory / SHA1::toString(key);
     }
 
+    std::filesystem::path SceneCache::getSidecarCachePath(const Key& key, const std::string& extension)
+    {
+        auto path = getCachePath(key);
+        path += extension;
+        return path;
+    }
+
     // SceneData
 
     void SceneCache::writeSceneData(OutputStream& stream, const Scene::SceneData& sceneData)
@@ -370,6 +671,13 @@ namespace Falcor
             for (const auto& data : cachedCurve.vertexData) stream.write(data);
         }
 
+        stream.write((uint32_t)sceneData.curveLODs.size());
+        for (const auto& curveLOD : sceneData.curveLODs)
+        {
+            stream.write(curveLOD.curveIDs);
+            stream.write(curveLOD.errors);
+        }
+
         writeMarker(stream, "CustomPrimitives");
         stream.write(sceneData.customPrimitiveDesc);
         stream.write(sceneData.customPrimitiveAABBs);
@@ -426,6 +734,7 @@ namespace Falcor
 
         readMarker(stream, "Materials");
         readMaterials(stream, *sceneData.pMaterials, *pMaterialTextureLoader, pDevice);
+        pMaterialTextureLoader->startLoading();
 
         readMarker(stream, "SceneGraph");
         sceneData.sceneGraph.resize(stream.read<uint32_t>());
@@ -496,12 +805,20 @@ namespace Falcor
             for (auto& data : cachedCurve.vertexData) stream.read(data);
         }
 
+        sceneData.curveLODs.resize(stream.read<uint32_t>());
+        for (auto& curveLOD : sceneData.curveLODs)
+        {
+            stream.read(curveLOD.curveIDs);
+            stream.read(curveLOD.errors);
+        }
+
         readMarker(stream, "CustomPrimitives");
         stream.read(sceneData.customPrimitiveDesc);
         stream.read(sceneData.customPrimitiveAABBs);
 
         readMarker(stream, "End");
 
+        pMaterialTextureLoader->finishLoading();
         pMaterialTextureLoader.reset();
 
         return sceneData;
@@ -826,6 +1143,16 @@ namespace Falcor
                 stream.write(id);
             }
         }
+        // Streaming grid sequences are recreated from their files, showing the cached grid of the current frame.
+        for (const auto& pStreamingGrids : pGridVolume->mStreamingGrids)
+        {
+            stream.write(pStreamingGrids != nullptr);
+            if (!pStreamingGrids) continue;
+            stream.write(pStreamingGrids->getPaths());
+            stream.write(pStreamingGrids->getGridname());
+            stream.write(pStreamingGrids->getWindowSize());
+            stream.write(pStreamingGrids->getFrame());
+        }
         stream.write(pGridVolume->mGridFrame);
         stream.write(pGridVolume->mGridFrameCount);
         stream.write(pGridVolume->mBounds);
@@ -850,6 +1177,17 @@ namespace Falcor
                 pGrid = id == uint32_t(-1) ? nullptr : grids[id];
             }
         }
+        for (size_t slotIndex = 0; slotIndex < pGridVolume->mStreamingGrids.size(); ++slotIndex)
+        {
+            if (!stream.read<bool>()) continue;
+            auto paths = stream.read<std::vector<std::filesystem::path>>();
+            auto gridname = stream.read<std::string>();
+            auto windowSize = stream.read<uint32_t>();
+            auto frame = stream.read<uint32_t>();
+            const auto& gridSequence = pGridVolume->mGrids[slotIndex];
+            if (gridSequence.size() != 1 || !gridSequence[0]) FALCOR_THROW("Invalid streaming grid sequence in scene cache.");
+            pGridVolume->mStreamingGrids[slotIndex] = StreamingGridSequence::create(pDevice, paths, gridname, windowSize, gridSequence[0], frame);
+        }
         stream.read(pGridVolume->mGridFrame);
         stream.read(pGridVolume->mGridFrameCount);
         stream.read(pGridVolume->mBounds);
@@ -1,5 +1,6 @@
 #pragma once
 #include "Scene.h"
+#include "SceneMeshletData.h"
 #include "Animation/Animation.h"
 #include "Camera/Camera.h"
 #include "Lights/EnvMap.h"
@@ -51,6 +52,43 @@ namespace Falcor
         */
         static Scene::SceneData readCache(ref<Device> pDevice, const Key& key);
 
+        /** Get the path of a sidecar cache file of a cached scene.
+            Sidecar caches store data derived from a cached scene next to the scene cache.
+            They are removed whenever the scene cache is rewritten, so they are valid as long as the scene cache is.
+            \param[in] key Scene cache key.
+            \param[in] extension Extension identifying the sidecar cache (e.g. ".meshlets").
+            \return Path of the sidecar cache file.
+        */
+        static std::filesystem::path getSidecarCachePath(const Key& key, const std::string& extension);
+
+        /** Write the per-mesh meshlet data of a cached scene.
+            The meshlet cache is stored next to the scene cache and is valid as long as the scene cache is.
+            \param[in] key Scene cache key.
+            \param[in] meshletData Per-mesh meshlet data.
+        */
+        static void writeMeshletCache(const Key& key, const std::vector<MeshMeshletData>& meshletData);
+
+        /** Read the per-mesh meshlet data of a cached scene.
+            \param[in] key Scene cache key.
+            \param[out] meshletData Per-mesh meshlet data.
+            \return Returns true if a valid meshlet cache was read.
+        */
+        static bool readMeshletCache(const Key& key, std::vector<MeshMeshletData>& meshletData);
+
+        /** Write the per-mesh cluster LOD DAGs of a cached scene.
+            The cluster LOD cache is stored next to the scene cache and is valid as long as the scene cache is.
+            \param[in] key Scene cache key.
+            \param[in] clusterLOD Per-mesh cluster LOD DAGs.
+        */
+        static void writeClusterLODCache(const Key& key, const std::vector<MeshClusterLOD>& clusterLOD);
+
+        /** Read the per-mesh cluster LOD DAGs of a cached scene.
+            \param[in] key Scene cache key.
+            \param[out] clusterLOD Per-mesh cluster LOD DAGs.
+            \return Returns true if a valid cluster LOD cache was read.
+        */
+        static bool readClusterLODCache(const Key& key, std::vector<MeshClusterLOD>& clusterLOD);
+
     private:
         class OutputStream;
         class InputStream;
@@ -1,12 +1,20 @@
 #include "SceneMeshletData.h"
 #include "Scene.h"
+#include "SceneCache.h"
 #include "Core/API/Buffer.h"
 #include "Core/API/Device.h"
 #include "Core/API/RenderContext.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Timing/CpuTimer.h"
 
 #include <meshoptimizer.h>
 
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <numeric>
+
 namespace Falcor
 {
     SceneMeshletData::SceneMeshletData(ref<Device> pDevice, const Scene* pScene)
@@ -17,12 +25,15 @@ namespace Falcor
 
     SceneMeshletData::~SceneMeshletData() = default;
 
-    void SceneMeshletData::build(RenderContext* pRenderContext)
+    void SceneMeshletData::build(RenderContext* pRenderContext, bool geometryChanged)
     {
         if (!mpScene || mpScene->getMeshCount() == 0 || mpScene->getGeometryInstanceCount() == 0)
         {
             mMeshMeshletData.clear();
+            mMeshClusterLOD.clear();
             mGpuMeshlets.clear();
+            mMeshBaseVertexOffset.clear();
+            mMeshBaseTriangleOffset.clear();
             mpMeshletBuffer = nullptr;
             mpMeshletVertices = nullptr;
             mpMeshletTriangles = nullptr;
@@ -31,63 +42,50 @@ namespace Falcor
             return;
         }
 
-        mMeshMeshletData.resize(mpScene->getMeshCount());
-        std::vector<uint32_t> flatIndices;
-        std::vector<float3> positions;
-
-        for (MeshID meshID{0}; meshID.get() < mpScene->getMeshCount(); ++meshID)
-        {
-            const auto& meshDesc = mpScene->getMesh(meshID);
-            if (meshDesc.getTriangleCount() == 0)
-                continue;
-            buildMeshletsForMesh(meshID, meshDesc, flatIndices, positions);
-        }
-
-        std::vector<uint32_t> meshBaseVertexOffset(mpScene->getMeshCount(), 0);
-        std::vector<uint32_t> meshBaseTriangleOffset(mpScene->getMeshCount(), 0);
-        uint32_t runningVertexOffset = 0;
-        uint32_t runningTriangleOffset = 0;
-        for (MeshID meshID{0}; meshID.get() < mpScene->getMeshCount(); ++meshID)
+        // Per-mesh meshlets only depend on the mesh geometry. Transform changes only require expanding the instances again.
+        if (geometryChanged || mMeshMeshletData.size() != mpScene->getMeshCount())
         {
-            meshBaseVertexOffset[meshID.get()] = runningVertexOffset;
-            meshBaseTriangleOffset[meshID.get()] = runningTriangleOffset;
-            if (meshID.get() < mMeshMeshletData.size() && !mMeshMeshletData[meshID.get()].meshletVertices.empty())
-            {
-                runningVertexOffset += (uint32_t)mMeshMeshletData[meshID.get()].meshletVertices.size();
-                runningTriangleOffset += (uint32_t)mMeshMeshletData[meshID.get()].meshletTriangles.size();
-            }
+            buildMeshData(true, mClusterLODEnabled);
+            createGeometryBuffers();
         }
 
-        mGpuMeshlets.clear();
-        for (uint32_t instanceID = 0; instanceID < mpScene->getGeometryInstanceCount(); ++instanceID)
+        // Compute the offset of each instance's meshlets by a prefix sum over the per-instance meshlet counts.
+        const uint32_t instanceCount = mpScene->getGeometryInstanceCount();
+        std::vector<uint32_t> instanceMeshletOffset(instanceCount + 1, 0);
+        for (uint32_t instanceID = 0; instanceID < instanceCount; ++instanceID)
         {
             const auto& instance = mpScene->getGeometryInstance(instanceID);
             if (instance.getType() != GeometryType::TriangleMesh && instance.getType() != GeometryType::DisplacedTriangleMesh)
                 continue;
-
-            MeshID meshID{instance.geometryID};
-            if (meshID.get() >= mMeshMeshletData.size())
-                continue;
-
-            const auto& meshData = mMeshMeshletData[meshID.get()];
-            if (meshData.meshletVertexCount.empty())
+            if (instance.geometryID >= mMeshMeshletData.size())
                 continue;
-
-            uint32_t baseVertexOffset = meshBaseVertexOffset[meshID.get()];
-            uint32_t baseTriangleOffset = meshBaseTriangleOffset[meshID.get()];
-            uint32_t totalPrimitiveOffset = 0;
-            expandMeshletsForInstance(
-                instanceID, instance, meshData, meshID,
-                baseVertexOffset, baseTriangleOffset, totalPrimitiveOffset);
+            instanceMeshletOffset[instanceID] = (uint32_t)mMeshMeshletData[instance.geometryID].meshletVertexCount.size();
         }
+        std::exclusive_scan(instanceMeshletOffset.begin(), instanceMeshletOffset.end(), instanceMeshletOffset.begin(), 0u);
+
+        // Expand the meshlets of all instances in parallel. Each instance writes its own range of the output.
+        mGpuMeshlets.resize(instanceMeshletOffset.back());
+        auto instanceRange = NumericRange<uint32_t>(0, instanceCount);
+        std::for_each(
+            std::execution::par,
+            instanceRange.begin(),
+            instanceRange.end(),
+            [&](uint32_t instanceID)
+            {
+                if (instanceMeshletOffset[instanceID + 1] == instanceMeshletOffset[instanceID])
+                    return;
+                const auto& instance = mpScene->getGeometryInstance(instanceID);
+                MeshID meshID{instance.geometryID};
+                expandMeshletsForInstance(
+                    instanceID, instance, mMeshMeshletData[meshID.get()], meshID, mGpuMeshlets.data() + instanceMeshletOffset[instanceID]);
+            }
+        );
 
         mMeshletCount = (uint32_t)mGpuMeshlets.size();
 
         if (mMeshletCount == 0)
         {
             mpMeshletBuffer = nullptr;
-            mpMeshletVertices = nullptr;
-            mpMeshletTriangles = nullptr;
             mBuilt = true;
             return;
         }
@@ -99,22 +97,188 @@ namespace Falcor
             MemoryType::DeviceLocal,
             mGpuMeshlets.data());
 
-        size_t totalVertices = 0;
-        size_t totalTriangles = 0;
-        for (const auto& meshData : mMeshMeshletData)
+        mBuilt = true;
+        logInfo("SceneMeshletData: Built {} meshlets for {} mesh instances", mMeshletCount, mpScene->getGeometryInstanceCount());
+    }
+
+    void SceneMeshletData::buildClusterLOD()
+    {
+        mClusterLODEnabled = true;
+        if (!mpScene || mpScene->getMeshCount() == 0 || mMeshClusterLOD.size() == mpScene->getMeshCount())
+            return;
+        buildMeshData(false, true);
+    }
+
+    void SceneMeshletData::selectClusters(const float3& cameraPosition, float projectionScale, float errorThreshold, std::vector<uint2>& selected) const
+    {
+        selected.clear();
+        if (!hasClusterLOD())
+            return;
+
+        const auto& globalMatrices = mpScene->getAnimationController()->getGlobalMatrices();
+        std::vector<uint32_t> clusters;
+        for (uint32_t instanceID = 0; instanceID < mpScene->getGeometryInstanceCount(); ++instanceID)
         {
-            totalVertices += meshData.meshletVertices.size();
-            totalTriangles += meshData.meshletTriangles.size();
+            const auto& instance = mpScene->getGeometryInstance(instanceID);
+            if (instance.getType() != GeometryType::TriangleMesh && instance.getType() != GeometryType::DisplacedTriangleMesh)
+                continue;
+            if (instance.geometryID >= mMeshClusterLOD.size())
+                continue;
+
+            ClusterLODBuilder::selectClusters(
+                mMeshClusterLOD[instance.geometryID], globalMatrices[instance.globalMatrixID], cameraPosition, projectionScale, errorThreshold, clusters);
+            for (uint32_t cluster : clusters)
+                selected.push_back(uint2(instanceID, cluster));
         }
+    }
 
-        if (totalVertices > 0)
+    ClusterLODBuilder::Options SceneMeshletData::getClusterLODOptions()
+    {
+        ClusterLODBuilder::Options options;
+        options.maxVerticesPerCluster = (uint32_t)kMaxVerticesPerMeshlet;
+        options.maxTrianglesPerCluster = (uint32_t)kMaxTrianglesPerMeshlet;
+        options.coneWeight = kConeWeight;
+        return options;
+    }
+
+    void SceneMeshletData::buildMeshData(bool buildMeshlets, bool buildClusterLOD)
+    {
+        const uint32_t meshCount = mpScene->getMeshCount();
+
+        // Meshlets of skinned or vertex-animated meshes depend on the current animation frame and are never cached.
+        const auto& sceneCacheKey = mpScene->getSceneCacheKey();
+        const auto pAnimationController = mpScene->getAnimationController();
+        const bool useCache = sceneCacheKey && !pAnimationController->hasSkinnedMeshes() && !pAnimationController->hasAnimatedMeshCaches();
+
+        if (buildMeshlets)
+        {
+            mMeshMeshletData.clear();
+            if (useCache && SceneCache::readMeshletCache(*sceneCacheKey, mMeshMeshletData) && mMeshMeshletData.size() == meshCount)
+            {
+                logInfo("SceneMeshletData: Loaded meshlets for {} meshes from the scene cache", meshCount);
+                buildMeshlets = false;
+            }
+            else
+            {
+                mMeshMeshletData.clear();
+                mMeshMeshletData.resize(meshCount);
+            }
+        }
+
+        if (buildClusterLOD)
+        {
+            mMeshClusterLOD.clear();
+            if (useCache && SceneCache::readClusterLODCache(*sceneCacheKey, mMeshClusterLOD) && mMeshClusterLOD.size() == meshCount)
+            {
+                logInfo("SceneMeshletData: Loaded cluster LOD for {} meshes from the scene cache", meshCount);
+                buildClusterLOD = false;
+            }
+            else
+            {
+                mMeshClusterLOD.clear();
+                mMeshClusterLOD.resize(meshCount);
+            }
+        }
+
+        if (!buildMeshlets && !buildClusterLOD)
+            return;
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+
+        // Read back the mesh geometry from the GPU. This needs the render context and is done on the calling thread.
+        std::vector<std::vector<uint32_t>> flatIndices(meshCount);
+        std::vector<std::vector<float3>> positions(meshCount);
+        for (MeshID meshID{0}; meshID.get() < meshCount; ++meshID)
+        {
+            const auto& meshDesc = mpScene->getMesh(meshID);
+            if (meshDesc.getTriangleCount() == 0)
+                continue;
+            readMeshGeometry(meshID, meshDesc, flatIndices[meshID.get()], positions[meshID.get()]);
+        }
+
+        // Build the meshlets and cluster LOD DAGs of all meshes in parallel.
+        const auto clusterLODOptions = getClusterLODOptions();
+        std::vector<std::exception_ptr> exceptions(meshCount);
+        auto meshRange = NumericRange<uint32_t>(0, meshCount);
+        std::for_each(
+            std::execution::par,
+            meshRange.begin(),
+            meshRange.end(),
+            [&](uint32_t meshIndex)
+            {
+                try
+                {
+                    if (flatIndices[meshIndex].empty())
+                        return;
+                    if (buildMeshlets)
+                        buildMeshletsForMesh(flatIndices[meshIndex], positions[meshIndex], mMeshMeshletData[meshIndex]);
+                    if (buildClusterLOD)
+                        mMeshClusterLOD[meshIndex] = ClusterLODBuilder::build(flatIndices[meshIndex], positions[meshIndex], clusterLODOptions);
+                    flatIndices[meshIndex] = {};
+                    positions[meshIndex] = {};
+                }
+                catch (...)
+                {
+                    exceptions[meshIndex] = std::current_exception();
+                }
+            }
+        );
+        for (const auto& exception : exceptions)
+        {
+            if (exception)
+                std::rethrow_exception(exception);
+        }
+
+        logInfo("SceneMeshletData: Built {} for {} meshes in {:.2f} ms",
+            buildMeshlets && buildClusterLOD ? "meshlets and cluster LOD" : (buildMeshlets ? "meshlets" : "cluster LOD"),
+            meshCount, CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()));
+
+        if (useCache && buildMeshlets)
+            SceneCache::writeMeshletCache(*sceneCacheKey, mMeshMeshletData);
+        if (useCache && buildClusterLOD)
+            SceneCache::writeClusterLODCache(*sceneCacheKey, mMeshClusterLOD);
+    }
+
+    void SceneMeshletData::createGeometryBuffers()
+    {
+        // Compute the per-mesh offsets into the concatenated buffers by a prefix sum over the per-mesh sizes.
+        const size_t meshCount = mMeshMeshletData.size();
+        mMeshBaseVertexOffset.resize(meshCount + 1);
+        mMeshBaseTriangleOffset.resize(meshCount + 1);
+        for (size_t i = 0; i < meshCount; ++i)
         {
-            std::vector<uint32_t> allVertices;
-            allVertices.reserve(totalVertices);
-            for (const auto& meshData : mMeshMeshletData)
+            mMeshBaseVertexOffset[i] = (uint32_t)mMeshMeshletData[i].meshletVertices.size();
+            mMeshBaseTriangleOffset[i] = (uint32_t)mMeshMeshletData[i].meshletTriangles.size();
+        }
+        mMeshBaseVertexOffset[meshCount] = 0;
+        mMeshBaseTriangleOffset[meshCount] = 0;
+        std::exclusive_scan(mMeshBaseVertexOffset.begin(), mMeshBaseVertexOffset.end(), mMeshBaseVertexOffset.begin(), 0u);
+        std::exclusive_scan(mMeshBaseTriangleOffset.begin(), mMeshBaseTriangleOffset.end(), mMeshBaseTriangleOffset.begin(), 0u);
+
+        const size_t totalVertices = mMeshBaseVertexOffset.back();
+        const size_t totalTriangles = mMeshBaseTriangleOffset.back();
+
+        // Concatenate the per-mesh data in parallel. The triangle indices are widened from uint8 to uint32.
+        std::vector<uint32_t> allVertices(totalVertices);
+        std::vector<uint32_t> trianglesUint32(totalTriangles);
+        auto meshRange = NumericRange<size_t>(0, meshCount);
+        std::for_each(
+            std::execution::par,
+            meshRange.begin(),
+            meshRange.end(),
+            [&](size_t i)
             {
-                allVertices.insert(allVertices.end(), meshData.meshletVertices.begin(), meshData.meshletVertices.end());
+                const auto& meshData = mMeshMeshletData[i];
+                std::copy(meshData.meshletVertices.begin(), meshData.meshletVertices.end(), allVertices.begin() + mMeshBaseVertexOffset[i]);
+                std::copy(meshData.meshletTriangles.begin(), meshData.meshletTriangles.end(), trianglesUint32.begin() + mMeshBaseTriangleOffset[i]);
             }
+        );
+
+        mpMeshletVertices = nullptr;
+        mpMeshletTriangles = nullptr;
+
+        if (totalVertices > 0)
+        {
             mpMeshletVertices = mpDevice->createStructuredBuffer(
                 sizeof(uint32_t),
                 (uint32_t)allVertices.size(),
@@ -125,13 +289,6 @@ namespace Falcor
 
         if (totalTriangles > 0)
         {
-            std::vector<uint32_t> trianglesUint32;
-            trianglesUint32.reserve(totalTriangles);
-            for (const auto& meshData : mMeshMeshletData)
-            {
-                for (uint8_t v : meshData.meshletTriangles)
-                    trianglesUint32.push_back(static_cast<uint32_t>(v));
-            }
             mpMeshletTriangles = mpDevice->createStructuredBuffer(
                 sizeof(uint32_t),
                 (uint32_t)trianglesUint32.size(),
@@ -139,18 +296,13 @@ namespace Falcor
                 MemoryType::DeviceLocal,
                 trianglesUint32.data());
         }
-
-        mBuilt = true;
-        logInfo("SceneMeshletData: Built {} meshlets for {} mesh instances", mMeshletCount, mpScene->getGeometryInstanceCount());
     }
 
-    void SceneMeshletData::buildMeshletsForMesh(MeshID meshID, const MeshDesc& meshDesc,
+    void SceneMeshletData::readMeshGeometry(MeshID meshID, const MeshDesc& meshDesc,
         std::vector<uint32_t>& flatIndices, std::vector<float3>& positions)
     {
         uint32_t vertexCount = meshDesc.vertexCount;
         uint32_t triangleCount = meshDesc.getTriangleCount();
-        if (triangleCount == 0)
-            return;
 
         std::map<std::string, ref<Buffer>> buffers;
         buffers["triangleIndices"] = mpDevice->createStructuredBuffer(
@@ -170,10 +322,14 @@ namespace Falcor
 
         flatIndices.resize(triangleCount * 3);
         positions.resize(vertexCount);
-
-        flatIndices.resize(triangleCount * 3);
         buffers["triangleIndices"]->getBlob(flatIndices.data(), 0, triangleCount * sizeof(uint3));
         buffers["positions"]->getBlob(positions.data(), 0, vertexCount * sizeof(float3));
+    }
+
+    void SceneMeshletData::buildMeshletsForMesh(const std::vector<uint32_t>& flatIndices, const std::vector<float3>& positions,
+        MeshMeshletData& meshData)
+    {
+        const size_t vertexCount = positions.size();
 
         size_t maxMeshlets = meshopt_buildMeshletsBound(
             flatIndices.size(), kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet);
@@ -204,7 +360,6 @@ namespace Falcor
             meshletTriangles.resize(lastMeshlet.triangle_offset + ((lastMeshlet.triangle_count * 3 + 3) & ~3));
         }
 
-        auto& meshData = mMeshMeshletData[meshID.get()];
         meshData.meshletVertices = std::move(meshletVertices);
         meshData.meshletTriangles = std::move(meshletTriangles);
         meshData.meshletVertexOffset.resize(meshletCount);
@@ -236,16 +391,19 @@ namespace Falcor
     }
 
     void SceneMeshletData::expandMeshletsForInstance(uint32_t instanceID, const GeometryInstanceData& instance,
-        const MeshMeshletData& meshData, MeshID meshID,
-        uint32_t& baseVertexOffset, uint32_t& baseTriangleOffset, uint32_t& totalPrimitiveOffset)
+        const MeshMeshletData& meshData, MeshID meshID, GpuMeshletDesc* pGpuMeshlets) const
     {
         const auto& globalMatrices = mpScene->getAnimationController()->getGlobalMatrices();
         float4x4 worldMatrix = globalMatrices[instance.globalMatrixID];
 
+        const uint32_t baseVertexOffset = mMeshBaseVertexOffset[meshID.get()];
+        const uint32_t baseTriangleOffset = mMeshBaseTriangleOffset[meshID.get()];
+        uint32_t totalPrimitiveOffset = 0;
+
         size_t meshletCount = meshData.meshletVertexCount.size();
         for (size_t i = 0; i < meshletCount; i++)
         {
-            GpuMeshletDesc gpuMeshlet;
+            GpuMeshletDesc& gpuMeshlet = pGpuMeshlets[i];
             gpuMeshlet.vertexOffset = baseVertexOffset + meshData.meshletVertexOffset[i];
             gpuMeshlet.triangleOffset = baseTriangleOffset + meshData.meshletTriangleOffset[i];
             gpuMeshlet.vertexCount = meshData.meshletVertexCount[i];
@@ -260,9 +418,7 @@ namespace Falcor
             gpuMeshlet.boundCenter = float3(worldCenter4.x, worldCenter4.y, worldCenter4.z);
             gpuMeshlet.boundRadius = meshData.meshletBoundRadius[i];
 
-            mGpuMeshlets.push_back(gpuMeshlet);
             totalPrimitiveOffset += meshData.meshletTriangleCount[i];
         }
-
     }
 }
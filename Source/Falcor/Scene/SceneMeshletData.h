@@ -2,6 +2,7 @@
 
 #include "Core/Macros.h"
 #include "Core/Object.h"
+#include "ClusterLOD.h"
 #include "SceneIDs.h"
 #include "SceneTypes.slang"
 #include "Utils/Math/Vector.h"
@@ -61,8 +62,11 @@ namespace Falcor
         ~SceneMeshletData();
 
         /** Build meshlet data for all mesh instances. Call when scene changes.
+         *  Per-mesh meshlets are built in parallel, or loaded from the scene cache if the scene uses one.
+         *  \param[in] pRenderContext Render context.
+         *  \param[in] geometryChanged True if mesh geometry changed. If false, only the per-instance meshlets are updated.
          */
-        void build(RenderContext* pRenderContext);
+        void build(RenderContext* pRenderContext, bool geometryChanged = true);
 
         /** Get meshlet count (total GpuMeshlets across all instances).
          */
@@ -84,18 +88,59 @@ namespace Falcor
          */
         bool isValid() const { return mMeshletCount > 0 && mpMeshletBuffer; }
 
+        /** Build the cluster LOD DAGs of all meshes. Call after build(). Once built, the DAGs are rebuilt together with the meshlets
+         *  when the geometry changes. The DAGs are loaded from the scene cache if the scene uses one.
+         */
+        void buildClusterLOD();
+
+        /** Check if the cluster LOD DAGs are built.
+         */
+        bool hasClusterLOD() const { return mClusterLODEnabled && !mMeshClusterLOD.empty() && mMeshClusterLOD.size() == mMeshMeshletData.size(); }
+
+        /** Get the cluster LOD DAG of a mesh. Only valid if hasClusterLOD() returns true.
+         */
+        const MeshClusterLOD& getMeshClusterLOD(MeshID meshID) const { return mMeshClusterLOD[meshID.get()]; }
+
+        /** Select the view-dependent cut through the cluster LOD DAGs of all mesh instances (CPU reference).
+         *  \param[in] cameraPosition World-space camera position.
+         *  \param[in] projectionScale Projection scale (see ClusterLODBuilder::computeProjectionScale()).
+         *  \param[in] errorThreshold Max acceptable projected error in pixels.
+         *  \param[out] selected Selected clusters as (instance ID, cluster index) pairs.
+         */
+        void selectClusters(const float3& cameraPosition, float projectionScale, float errorThreshold, std::vector<uint2>& selected) const;
+
+        /** Get the options used to build the cluster LOD DAGs.
+         */
+        static ClusterLODBuilder::Options getClusterLODOptions();
+
+        /** Get the meshlets of a mesh. Only valid after build() created meshlets.
+         */
+        const MeshMeshletData& getMeshMeshletData(MeshID meshID) const { return mMeshMeshletData[meshID.get()]; }
+
+        /** Build the meshlets of a single mesh. This is used by build() for each mesh.
+         *  \param[in] flatIndices Triangle vertex indices (3 per triangle).
+         *  \param[in] positions Vertex positions.
+         *  \param[out] meshData Meshlets of the mesh.
+         */
+        static void buildMeshletsForMesh(const std::vector<uint32_t>& flatIndices, const std::vector<float3>& positions,
+            MeshMeshletData& meshData);
+
     private:
-        void buildMeshletsForMesh(MeshID meshID, const MeshDesc& meshDesc,
+        void buildMeshData(bool buildMeshlets, bool buildClusterLOD);
+        void createGeometryBuffers();
+        void readMeshGeometry(MeshID meshID, const MeshDesc& meshDesc,
             std::vector<uint32_t>& flatIndices, std::vector<float3>& positions);
         void expandMeshletsForInstance(uint32_t instanceID, const GeometryInstanceData& instance,
-            const MeshMeshletData& meshData, MeshID meshID,
-            uint32_t& baseVertexOffset, uint32_t& baseTriangleOffset, uint32_t& totalPrimitiveOffset);
+            const MeshMeshletData& meshData, MeshID meshID, GpuMeshletDesc* pGpuMeshlets) const;
 
         ref<Device> mpDevice;
         const Scene* mpScene;
 
         std::vector<MeshMeshletData> mMeshMeshletData;  ///< Per-mesh meshlet geometry
+        std::vector<MeshClusterLOD> mMeshClusterLOD;    ///< Per-mesh cluster LOD DAG (if enabled)
         std::vector<GpuMeshletDesc> mGpuMeshlets;       ///< Expanded for all instances
+        std::vector<uint32_t> mMeshBaseVertexOffset;    ///< Per-mesh offset into the meshlet vertices buffer
+        std::vector<uint32_t> mMeshBaseTriangleOffset;  ///< Per-mesh offset into the meshlet triangles buffer
 
         ref<Buffer> mpMeshletBuffer;
         ref<Buffer> mpMeshletVertices;
@@ -103,5 +148,6 @@ namespace Falcor
 
         uint32_t mMeshletCount = 0;
         bool mBuilt = false;
+        bool mClusterLODEnabled = false;
     };
 }
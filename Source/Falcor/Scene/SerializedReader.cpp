@@ -0,0 +1,260 @@
+#include "SerializedReader.h"
+#include "Core/Error.h"
+#include "Utils/Math/Vector.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace Falcor
+{
+namespace
+{
+const uint16_t kFormatIdentifier = 0x041C;
+const size_t kShapeHeaderSize = 2 * sizeof(uint16_t);
+const size_t kChunkSize = 4096; ///< Number of vectors converted per chunk.
+
+enum ShapeFlags : uint32_t
+{
+    HasNormals = 0x0001,
+    HasTexCoords = 0x0002,
+    HasColors = 0x0008,
+    FaceNormals = 0x0010,
+    SinglePrecision = 0x1000,
+    DoublePrecision = 0x2000,
+};
+
+template<typename T>
+T load(const uint8_t* pData)
+{
+    T value;
+    std::memcpy(&value, pData, sizeof(T));
+    return value;
+}
+
+/** Decompresses a zlib stream from memory into caller provided buffers.
+ */
+class InflateStream
+{
+public:
+    InflateStream(const std::filesystem::path& path, const uint8_t* pData, size_t size) : mPath(path), mpData(pData), mSize(size)
+    {
+        if (inflateInit(&mStream) != Z_OK)
+            FALCOR_THROW("Failed to initialize zlib while reading '{}'.", mPath);
+    }
+
+    ~InflateStream() { inflateEnd(&mStream); }
+
+    void read(void* pDst, size_t size)
+    {
+        mStream.next_out = static_cast<Bytef*>(pDst);
+        while (size > 0)
+        {
+            // zlib counts in 32-bit, so large inputs and outputs are processed in multiple steps.
+            if (mStream.avail_in == 0 && mSize > 0)
+            {
+                mStream.next_in = const_cast<Bytef*>(mpData);
+                mStream.avail_in = (uInt)std::min<size_t>(mSize, std::numeric_limits<uInt>::max());
+                mpData += mStream.avail_in;
+                mSize -= mStream.avail_in;
+            }
+            mStream.avail_out = (uInt)std::min<size_t>(size, std::numeric_limits<uInt>::max());
+            const uInt avail = mStream.avail_out;
+
+            int ret = inflate(&mStream, Z_NO_FLUSH);
+            size -= avail - mStream.avail_out;
+            if (ret == Z_STREAM_END && size > 0)
+                FALCOR_THROW("Unexpected end of compressed shape data in '{}'.", mPath);
+            if (ret != Z_OK && ret != Z_STREAM_END)
+                FALCOR_THROW("Failed to decompress shape data in '{}' (error: {}).", mPath, ret);
+        }
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    /** Read an array of vectors, converting them chunk by chunk.
+        \param[in] count Number of vectors.
+        \param[in] doublePrecision True if the components are stored as doubles.
+        \param[in] func Function called with the index and value of each vector.
+     */
+    template<int N, typename Func>
+    void readVectors(size_t count, bool doublePrecision, const Func& func)
+    {
+        if (doublePrecision)
+            readVectors<N, double>(count, func);
+        else
+            readVectors<N, float>(count, func);
+    }
+
+private:
+    template<int N, typename T, typename Func>
+    void readVectors(size_t count, const Func& func)
+    {
+        std::vector<T> chunk(std::min(count, kChunkSize) * N);
+        for (size_t begin = 0; begin < count; begin += kChunkSize)
+        {
+            const size_t chunkCount = std::min(count - begin, kChunkSize);
+            read(chunk.data(), chunkCount * N * sizeof(T));
+            for (size_t i = 0; i < chunkCount; ++i)
+            {
+                math::vector<float, N> value;
+                for (int c = 0; c < N; ++c)
+                    value[c] = (float)chunk[i * N + c];
+                func(begin + i, value);
+            }
+        }
+    }
+
+    const std::filesystem::path& mPath;
+    const uint8_t* mpData;
+    size_t mSize;
+    z_stream mStream = {};
+};
+
+void computeSmoothNormals(TriangleMesh::VertexList& vertices, const TriangleMesh::IndexList& indices)
+{
+    // Vertex normals are the angle-weighted average of the face normals, the same as in Mitsuba.
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const float3 p[3] = {vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position};
+        float3 n = cross(p[1] - p[0], p[2] - p[0]);
+        if (!(length(n) > 0.f))
+            continue;
+        n = normalize(n);
+
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            const float3 d0 = p[(j + 1) % 3] - p[j];
+            const float3 d1 = p[(j + 2) % 3] - p[j];
+            const float lengths = length(d0) * length(d1);
+            if (!(lengths > 0.f))
+                continue;
+            const float angle = std::acos(std::clamp(dot(d0, d1) / lengths, -1.f, 1.f));
+            vertices[indices[i + j]].normal += angle * n;
+        }
+    }
+
+    for (auto& vertex : vertices)
+    {
+        const float len = length(vertex.normal);
+        vertex.normal = len > 0.f ? vertex.normal / len : float3(0.f, 0.f, 1.f);
+    }
+}
+
+void applyFaceNormals(TriangleMesh::VertexList& vertices, TriangleMesh::IndexList& indices)
+{
+    // Each triangle gets its own vertices with the facet normal.
+    TriangleMesh::VertexList faceVertices(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const float3 n =
+            normalize(cross(vertices[indices[i + 1]].position - vertices[indices[i]].position, vertices[indices[i + 2]].position - vertices[indices[i]].position));
+        for (size_t j = 0; j < 3; ++j)
+        {
+            faceVertices[i + j] = vertices[indices[i + j]];
+            faceVertices[i + j].normal = n;
+            indices[i + j] = (uint32_t)(i + j);
+        }
+    }
+    vertices = std::move(faceVertices);
+}
+} // namespace
+
+SerializedReader::SerializedReader(const std::filesystem::path& path)
+    : mPath(path), mFile(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::RandomAccess)
+{
+    if (!mFile.isOpen())
+        FALCOR_THROW("Failed to open serialized file '{}'.", mPath);
+
+    const uint8_t* pData = static_cast<const uint8_t*>(mFile.getData());
+    const size_t size = mFile.getSize();
+
+    // All shapes in a file share the version of the first shape.
+    if (size < kShapeHeaderSize + sizeof(uint32_t) || load<uint16_t>(pData) != kFormatIdentifier)
+        FALCOR_THROW("'{}' is not a serialized file.", mPath);
+    mVersion = load<uint16_t>(pData + sizeof(uint16_t));
+    if (mVersion != 3 && mVersion != 4)
+        FALCOR_THROW("Serialized file '{}' has unsupported version {}.", mPath, mVersion);
+
+    // The file ends with the offset of each shape, followed by the shape count.
+    const size_t shapeCount = load<uint32_t>(pData + size - sizeof(uint32_t));
+    const size_t offsetSize = mVersion == 4 ? sizeof(uint64_t) : sizeof(uint32_t);
+    if (shapeCount == 0 || shapeCount > (size - sizeof(uint32_t)) / offsetSize)
+        FALCOR_THROW("Serialized file '{}' has an invalid shape table.", mPath);
+    const size_t tableOffset = size - sizeof(uint32_t) - shapeCount * offsetSize;
+
+    mShapeOffsets.resize(shapeCount + 1);
+    for (size_t i = 0; i < shapeCount; ++i)
+    {
+        const uint8_t* pOffset = pData + tableOffset + i * offsetSize;
+        mShapeOffsets[i] = mVersion == 4 ? load<uint64_t>(pOffset) : load<uint32_t>(pOffset);
+    }
+    mShapeOffsets[shapeCount] = tableOffset;
+
+    for (size_t i = 0; i < shapeCount; ++i)
+    {
+        if (mShapeOffsets[i] + kShapeHeaderSize > mShapeOffsets[i + 1])
+            FALCOR_THROW("Serialized file '{}' has an invalid offset for shape {}.", mPath, i);
+    }
+}
+
+ref<TriangleMesh> SerializedReader::loadShape(uint32_t shapeIndex, bool faceNormals) const
+{
+    if (shapeIndex >= getShapeCount())
+        FALCOR_THROW("Shape index {} is out of range. '{}' has {} shapes.", shapeIndex, mPath, getShapeCount());
+
+    const uint8_t* pShape = static_cast<const uint8_t*>(mFile.getData()) + mShapeOffsets[shapeIndex];
+    if (load<uint16_t>(pShape) != kFormatIdentifier || load<uint16_t>(pShape + sizeof(uint16_t)) != mVersion)
+        FALCOR_THROW("Shape {} in '{}' has an invalid header.", shapeIndex, mPath);
+
+    InflateStream stream(
+        mPath, pShape + kShapeHeaderSize, mShapeOffsets[shapeIndex + 1] - mShapeOffsets[shapeIndex] - kShapeHeaderSize
+    );
+
+    const uint32_t flags = stream.read<uint32_t>();
+    if (mVersion == 4)
+    {
+        // Skip the shape name.
+        while (stream.read<char>() != '\0')
+            ;
+    }
+    const uint64_t vertexCount = stream.read<uint64_t>();
+    const uint64_t triangleCount = stream.read<uint64_t>();
+    if (vertexCount > std::numeric_limits<uint32_t>::max() || triangleCount > std::numeric_limits<uint32_t>::max() / 3)
+        FALCOR_THROW("Shape {} in '{}' is too large.", shapeIndex, mPath);
+
+    const bool doublePrecision = (flags & DoublePrecision) != 0;
+    faceNormals = faceNormals || (flags & FaceNormals) != 0;
+
+    TriangleMesh::VertexList vertices(vertexCount, TriangleMesh::Vertex{float3(0.f), float3(0.f), float2(0.f)});
+    stream.readVectors<3>(vertexCount, doublePrecision, [&](size_t i, float3 p) { vertices[i].position = p; });
+    if (flags & HasNormals)
+        stream.readVectors<3>(vertexCount, doublePrecision, [&](size_t i, float3 n) { vertices[i].normal = n; });
+    if (flags & HasTexCoords)
+        stream.readVectors<2>(vertexCount, doublePrecision, [&](size_t i, float2 uv) { vertices[i].texCoord = uv; });
+    if (flags & HasColors)
+        stream.readVectors<3>(vertexCount, doublePrecision, [](size_t, float3) {});
+
+    // Indices are stored as 32-bit integers, since the vertex count fits into 32 bits.
+    TriangleMesh::IndexList indices(triangleCount * 3);
+    stream.read(indices.data(), indices.size() * sizeof(uint32_t));
+    if (std::any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= vertexCount; }))
+        FALCOR_THROW("Shape {} in '{}' has out of range vertex indices.", shapeIndex, mPath);
+
+    if (faceNormals)
+        applyFaceNormals(vertices, indices);
+    else if (!(flags & HasNormals))
+        computeSmoothNormals(vertices, indices);
+
+    return TriangleMesh::create(std::move(vertices), std::move(indices));
+}
+
+} // namespace Falcor
@@ -0,0 +1,44 @@
+#pragma once
+#include "Core/Macros.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Scene/TriangleMesh.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace Falcor
+{
+/** Reader for Mitsuba's "serialized" mesh format.
+    A serialized file is a sequence of zlib compressed shapes, followed by a table with the offset of each shape.
+    The file is memory-mapped and only the requested shapes are decompressed, straight into the vertex and index
+    lists of the triangle mesh. Loading shapes is thread-safe.
+ */
+class FALCOR_API SerializedReader
+{
+public:
+    /** Open a serialized file and read its shape table.
+        Throws if the file cannot be opened or is not a serialized file.
+     */
+    SerializedReader(const std::filesystem::path& path);
+
+    const std::filesystem::path& getPath() const { return mPath; }
+
+    uint32_t getShapeCount() const { return (uint32_t)mShapeOffsets.size() - 1; }
+
+    /** Load a shape.
+        Shapes without vertex normals get smooth normals, unless face normals are requested.
+        \param[in] shapeIndex Index of the shape in the file.
+        \param[in] faceNormals Use face normals instead of vertex normals. This is also enabled by the shape's flags.
+        \return The triangle mesh. Throws if the shape data is invalid.
+     */
+    ref<TriangleMesh> loadShape(uint32_t shapeIndex, bool faceNormals) const;
+
+private:
+    std::filesystem::path mPath;
+    MemoryMappedFile mFile;
+    uint16_t mVersion = 0;
+    /// Offset of each shape, followed by the offset of the shape table.
+    std::vector<uint64_t> mShapeOffsets;
+};
+
+} // namespace Falcor
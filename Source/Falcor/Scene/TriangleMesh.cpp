@@ -1,16 +1,102 @@
 #include "TriangleMesh.h"
+#include "PlyReader.h"
 #include "GlobalState.h"
 #include "Core/Error.h"
 #include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <algorithm>
 #include <cmath>
+#include <execution>
 
 namespace Falcor
 {
+    namespace
+    {
+        float3 normalizeOrDefault(float3 v)
+        {
+            float len = length(v);
+            return len > 0.f ? v / len : float3(0.f, 1.f, 0.f);
+        }
+
+        /** Loads a binary PLY file with the native PLY reader.
+            Normals are generated and texture coordinates flipped to match the ASSIMP import flags used in createFromFile().
+            \return True if successful, false if the file should be loaded with ASSIMP instead.
+        */
+        bool loadPly(const std::filesystem::path& path, TriangleMesh::ImportFlags importFlags, TriangleMesh::VertexList& vertices, TriangleMesh::IndexList& indices)
+        {
+            PlyReader::Mesh mesh;
+            bool result = false;
+            if (hasExtension(path, "gz"))
+            {
+                auto decompressed = decompressFile(path);
+                result = PlyReader::read(decompressed.data(), decompressed.size(), mesh);
+            }
+            else
+            {
+                result = PlyReader::read(path, mesh);
+            }
+            if (!result || mesh.indices.empty()) return false;
+
+            auto getTexCoord = [&](uint32_t vertexIdx)
+            {
+                return mesh.texCoords.empty() ? float2(0.f) : float2(mesh.texCoords[vertexIdx].x, 1.f - mesh.texCoords[vertexIdx].y);
+            };
+            auto getFaceNormal = [&](size_t triangleIdx)
+            {
+                const float3 p0 = mesh.positions[mesh.indices[triangleIdx * 3 + 0]];
+                const float3 p1 = mesh.positions[mesh.indices[triangleIdx * 3 + 1]];
+                const float3 p2 = mesh.positions[mesh.indices[triangleIdx * 3 + 2]];
+                return cross(p1 - p0, p2 - p0);
+            };
+            const size_t triangleCount = mesh.indices.size() / 3;
+
+            if (mesh.normals.empty() && !is_set(importFlags, TriangleMesh::ImportFlags::GenSmoothNormals))
+            {
+                // Facet normals require separate vertices for each triangle.
+                vertices.resize(mesh.indices.size());
+                indices.resize(mesh.indices.size());
+                auto range = NumericRange<size_t>(0, triangleCount);
+                std::for_each(std::execution::par, range.begin(), range.end(), [&](size_t triangleIdx)
+                {
+                    const float3 normal = normalizeOrDefault(getFaceNormal(triangleIdx));
+                    for (size_t i = triangleIdx * 3; i < triangleIdx * 3 + 3; ++i)
+                    {
+                        vertices[i] = TriangleMesh::Vertex{mesh.positions[mesh.indices[i]], normal, getTexCoord(mesh.indices[i])};
+                        indices[i] = (uint32_t)i;
+                    }
+                });
+                return true;
+            }
+
+            bool generateNormals = mesh.normals.empty();
+            if (generateNormals)
+            {
+                // Smooth normals are the average of the adjacent facet normals, as with aiProcess_GenSmoothNormals.
+                mesh.normals.assign(mesh.positions.size(), float3(0.f));
+                for (size_t triangleIdx = 0; triangleIdx < triangleCount; ++triangleIdx)
+                {
+                    const float3 normal = normalizeOrDefault(getFaceNormal(triangleIdx));
+                    for (size_t i = triangleIdx * 3; i < triangleIdx * 3 + 3; ++i) mesh.normals[mesh.indices[i]] += normal;
+                }
+            }
+
+            vertices.resize(mesh.positions.size());
+            auto range = NumericRange<uint32_t>(0, (uint32_t)mesh.positions.size());
+            std::for_each(std::execution::par, range.begin(), range.end(), [&](uint32_t vertexIdx)
+            {
+                const float3 normal = generateNormals ? normalizeOrDefault(mesh.normals[vertexIdx]) : mesh.normals[vertexIdx];
+                vertices[vertexIdx] = TriangleMesh::Vertex{mesh.positions[vertexIdx], normal, getTexCoord(vertexIdx)};
+            });
+            indices = std::move(mesh.indices);
+            return true;
+        }
+    }
+
     ref<TriangleMesh> TriangleMesh::create()
     {
         return ref<TriangleMesh>(new TriangleMesh());
@@ -21,6 +107,11 @@ namespace Falcor
         return ref<TriangleMesh>(new TriangleMesh(vertices, indices, frontFaceCW));
     }
 
+    ref<TriangleMesh> TriangleMesh::create(VertexList&& vertices, IndexList&& indices, bool frontFaceCW)
+    {
+        return ref<TriangleMesh>(new TriangleMesh(std::move(vertices), std::move(indices), frontFaceCW));
+    }
+
     ref<TriangleMesh> TriangleMesh::createDummy()
     {
         VertexList vertices = {{{0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f}}};
@@ -174,6 +265,15 @@ namespace Falcor
             return nullptr;
         }
 
+        // Binary PLY files are loaded natively unless an ASSIMP-only option is requested. Unsupported layouts fall back to ASSIMP.
+        const bool isPly = hasExtension(path, "ply") || (hasExtension(path, "gz") && hasExtension(path.stem(), "ply"));
+        if (isPly && !is_set(importFlags, ImportFlags::UseAssimp) && !is_set(importFlags, ImportFlags::JoinIdenticalVertices))
+        {
+            VertexList vertices;
+            IndexList indices;
+            if (loadPly(path, importFlags, vertices, indices)) return create(std::move(vertices), std::move(indices));
+        }
+
         Assimp::Importer importer;
 
         unsigned int flags =
@@ -289,9 +389,9 @@ namespace Falcor
     TriangleMesh::TriangleMesh()
     {}
 
-    TriangleMesh::TriangleMesh(const VertexList& vertices, const IndexList& indices, bool frontFaceCW)
-        : mVertices(vertices)
-        , mIndices(indices)
+    TriangleMesh::TriangleMesh(VertexList vertices, IndexList indices, bool frontFaceCW)
+        : mVertices(std::move(vertices))
+        , mIndices(std::move(indices))
         , mFrontFaceCW(frontFaceCW)
     {}
 
@@ -303,6 +403,7 @@ namespace Falcor
         flags.value("Default", TriangleMesh::ImportFlags::Default);
         flags.value("GenSmoothNormals", TriangleMesh::ImportFlags::GenSmoothNormals);
         flags.value("JoinIdenticalVertices", TriangleMesh::ImportFlags::JoinIdenticalVertices);
+        flags.value("UseAssimp", TriangleMesh::ImportFlags::UseAssimp);
         ScriptBindings::addEnumBinaryOperators(flags);
 
         pybind11::class_<TriangleMesh, ref<TriangleMesh>> triangleMesh(m, "TriangleMesh");
@@ -24,6 +24,7 @@ namespace Falcor
             None = 0x0,
             GenSmoothNormals = 0x1,
             JoinIdenticalVertices = 0x2,
+            UseAssimp = 0x4,    ///< Load binary PLY files with ASSIMP instead of the native PLY reader.
 
             Default = None
         };
@@ -51,6 +52,14 @@ namespace Falcor
         */
         static ref<TriangleMesh> create(const VertexList& vertices, const IndexList& indices, bool frontFaceCW = false);
 
+        /** Creates a triangle mesh, taking ownership of the vertex and index lists.
+            \param[in] vertices Vertex list.
+            \param[in] indices Index list.
+            \param[in] frontFaceCW Triangle winding.
+            \return Returns the triangle mesh.
+        */
+        static ref<TriangleMesh> create(VertexList&& vertices, IndexList&& indices, bool frontFaceCW = false);
+
         /** Creates a dummy mesh (single degenerate triangle).
             \return Returns the triangle mesh.
         */
@@ -84,6 +93,7 @@ namespace Falcor
 
         /** Creates a triangle mesh from a file.
             This is using ASSIMP to support a wide variety of asset formats.
+            Binary PLY files are loaded with a native reader, unless ImportFlags::UseAssimp or ImportFlags::JoinIdenticalVertices is set.
             All geometry found in the asset is pre-transformed and merged into the same triangle mesh.
             \param[in] path File path to load mesh from (absolute or relative to working directory).
             \param[in] flags Flags controlling ASSIMP mesh import options.
@@ -161,7 +171,7 @@ namespace Falcor
 
     private:
         TriangleMesh();
-        TriangleMesh(const VertexList& vertices, const IndexList& indices, bool frontFaceCW);
+        TriangleMesh(VertexList vertices, IndexList indices, bool frontFaceCW);
 
         std::string mName;
         std::vector<Vertex> mVertices;
@@ -0,0 +1,221 @@
+#include "BC4Encode.h"
+#include "Utils/NumericRange.h"
+#include <cstring>
+#include <execution>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define FALCOR_BC4_SSE2 1
+#include <emmintrin.h>
+#else
+#define FALCOR_BC4_SSE2 0
+#endif
+
+namespace Falcor
+{
+namespace
+{
+const size_t kTileSize = 16;
+const size_t kBlocksPerTask = 1024;
+const int kMaxInset = 4; ///< Largest endpoint inset searched with BC4Quality::High.
+
+/** Fits the values of a tile to a codebook.
+    The SIMD version evaluates all 16 values of the tile at once. Both versions pick the same indices as FitCodes.
+*/
+#if FALCOR_BC4_SSE2
+class TileFitter
+{
+public:
+    TileFitter(const uint8_t* tile) : mTile(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tile))) {}
+
+    void getRange(int& min5, int& max5, int& min7, int& max7) const
+    {
+        // The 5-alpha range ignores the values 0 and 255, which are explicit codes.
+        const __m128i isZero = _mm_cmpeq_epi8(mTile, _mm_setzero_si128());
+        const __m128i isMax = _mm_cmpeq_epi8(mTile, _mm_set1_epi8(-1));
+        min5 = horizontalMin(_mm_or_si128(mTile, isZero));
+        max5 = horizontalMax(_mm_andnot_si128(isMax, mTile));
+        min7 = horizontalMin(mTile);
+        max7 = horizontalMax(mTile);
+    }
+
+    int fit(const uint8_t* codes, uint8_t* indices) const
+    {
+        __m128i best = _mm_set1_epi8(-1);
+        __m128i index = _mm_setzero_si128();
+        for (int j = 0; j < 8; ++j)
+        {
+            const __m128i code = _mm_set1_epi8((char)codes[j]);
+            const __m128i dist = _mm_or_si128(_mm_subs_epu8(mTile, code), _mm_subs_epu8(code, mTile));
+            // Keep the current index unless the distance is strictly smaller, like FitCodes.
+            const __m128i keep = _mm_cmpeq_epi8(_mm_min_epu8(dist, best), best);
+            best = _mm_min_epu8(dist, best);
+            index = _mm_or_si128(_mm_and_si128(keep, index), _mm_andnot_si128(keep, _mm_set1_epi8((char)j)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), index);
+
+        // Sum the squared distances.
+        const __m128i lo = _mm_unpacklo_epi8(best, _mm_setzero_si128());
+        const __m128i hi = _mm_unpackhi_epi8(best, _mm_setzero_si128());
+        __m128i sum = _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+private:
+    static int horizontalMin(__m128i v)
+    {
+        v = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+        v = _mm_min_epu8(v, _mm_srli_si128(v, 4));
+        v = _mm_min_epu8(v, _mm_srli_si128(v, 2));
+        v = _mm_min_epu8(v, _mm_srli_si128(v, 1));
+        return _mm_cvtsi128_si32(v) & 0xff;
+    }
+
+    static int horizontalMax(__m128i v)
+    {
+        v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+        v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+        v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+        v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+        return _mm_cvtsi128_si32(v) & 0xff;
+    }
+
+    __m128i mTile;
+};
+#else
+class TileFitter
+{
+public:
+    TileFitter(const uint8_t* tile) : mpTile(tile) {}
+
+    void getRange(int& min5, int& max5, int& min7, int& max7) const
+    {
+        min5 = 255, max5 = 0, min7 = 255, max7 = 0;
+        for (size_t i = 0; i < kTileSize; ++i)
+        {
+            int value = mpTile[i];
+            min7 = std::min(min7, value);
+            max7 = std::max(max7, value);
+            if (value != 0) min5 = std::min(min5, value);
+            if (value != 255) max5 = std::max(max5, value);
+        }
+    }
+
+    int fit(const uint8_t* codes, uint8_t* indices) const { return FitCodes(mpTile, codes, indices); }
+
+private:
+    const uint8_t* mpTile;
+};
+#endif
+
+struct BlockFit
+{
+    int error = INT_MAX;
+    int minValue = 0;
+    int maxValue = 0;
+    bool sevenAlpha = false;
+    uint8_t indices[kTileSize] = {};
+};
+
+/** Fit the tile to the codebook spanned by the given endpoints, and keep it if the error is smaller than the best so far.
+*/
+void fitCodebook(const TileFitter& fitter, bool sevenAlpha, int minValue, int maxValue, BlockFit& best)
+{
+    // Same codebooks as CompressAlphaDxt5.
+    uint8_t codes[8];
+    codes[0] = (uint8_t)minValue;
+    codes[1] = (uint8_t)maxValue;
+    if (sevenAlpha)
+    {
+        for (int i = 1; i < 7; ++i)
+            codes[1 + i] = (uint8_t)(((7 - i) * minValue + i * maxValue) / 7);
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+            codes[1 + i] = (uint8_t)(((5 - i) * minValue + i * maxValue) / 5);
+        codes[6] = 0;
+        codes[7] = 255;
+    }
+
+    uint8_t indices[kTileSize];
+    int error = fitter.fit(codes, indices);
+    if (error < best.error)
+    {
+        best.error = error;
+        best.minValue = minValue;
+        best.maxValue = maxValue;
+        best.sevenAlpha = sevenAlpha;
+        std::memcpy(best.indices, indices, kTileSize);
+    }
+}
+
+uint64_t encodeBlock(const uint8_t* tile, BC4Quality quality)
+{
+    TileFitter fitter(tile);
+    int min5, max5, min7, max7;
+    fitter.getRange(min5, max5, min7, max7);
+
+    // handle the case that no valid range was found
+    if (min5 > max5)
+        min5 = max5;
+    if (min7 > max7)
+        min7 = max7;
+
+    FixRange(min5, max5, 5);
+    FixRange(min7, max7, 7);
+
+    // Candidates are tried in the same order as CompressAlphaDxt5, which keeps the 5-alpha fit on ties.
+    BlockFit best;
+    if (quality != BC4Quality::Fast)
+        fitCodebook(fitter, false, min5, max5, best);
+    fitCodebook(fitter, true, min7, max7, best);
+
+    if (quality == BC4Quality::High)
+    {
+        // Moving the endpoints inwards trades the error of outliers against a finer spacing of the interpolated codes.
+        for (int inset0 = 0; inset0 <= kMaxInset; ++inset0)
+        {
+            for (int inset1 = 0; inset1 <= kMaxInset; ++inset1)
+            {
+                if (inset0 == 0 && inset1 == 0)
+                    continue;
+                if ((max5 - inset1) - (min5 + inset0) >= 5)
+                    fitCodebook(fitter, false, min5 + inset0, max5 - inset1, best);
+                if ((max7 - inset1) - (min7 + inset0) >= 7)
+                    fitCodebook(fitter, true, min7 + inset0, max7 - inset1, best);
+            }
+        }
+    }
+
+    uint64_t block = 0;
+    if (best.sevenAlpha)
+        WriteAlphaBlock7(best.minValue, best.maxValue, best.indices, &block);
+    else
+        WriteAlphaBlock5(best.minValue, best.maxValue, best.indices, &block);
+    return block;
+}
+} // namespace
+
+void encodeBC4Blocks(const uint8_t* pTiles, uint64_t* pBlocks, size_t count, BC4Quality quality)
+{
+    for (size_t i = 0; i < count; ++i)
+        pBlocks[i] = encodeBlock(pTiles + i * kTileSize, quality);
+}
+
+void encodeBC4BlocksParallel(const uint8_t* pTiles, uint64_t* pBlocks, size_t count, BC4Quality quality)
+{
+    auto range = NumericRange<size_t>(0, (count + kBlocksPerTask - 1) / kBlocksPerTask);
+    std::for_each(
+        std::execution::par,
+        range.begin(),
+        range.end(),
+        [&](size_t task)
+        {
+            size_t begin = task * kBlocksPerTask;
+            encodeBC4Blocks(pTiles + begin * kTileSize, pBlocks + begin, std::min(kBlocksPerTask, count - begin), quality);
+        }
+    );
+}
+} // namespace Falcor
@@ -1,11 +1,39 @@
 #pragma once
+#include "Core/Macros.h"
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <climits>
 
-// this file exposes a single function, CompressAlphaDxt5, which encodes a 4x4 set of uint8 alpha values into a single 64 bit BC4 encoded block
+// this file exposes CompressAlphaDxt5, which encodes a 4x4 set of uint8 alpha values into a single 64 bit BC4 encoded block,
+// and the batch encoder encodeBC4Blocks, which encodes many blocks at once using SIMD instructions.
 static void CompressAlphaDxt5(uint8_t* tile, void* block);
 
+namespace Falcor
+{
+    /** Quality levels of the batch BC4 encoder.
+    */
+    enum class BC4Quality
+    {
+        Fast,       ///< Fit the block to the 8-value codebook only.
+        Default,    ///< Fit the block to both codebooks and keep the best. Produces the same blocks as CompressAlphaDxt5.
+        High,       ///< Additionally search endpoints inset from the block's range. The error is never larger than with Default.
+    };
+
+    /** Encode 4x4 tiles of 8-bit values into BC4 blocks.
+        \param[in] pTiles Tiles of 16 values each, stored row by row.
+        \param[out] pBlocks Encoded blocks, one per tile.
+        \param[in] count Number of tiles.
+        \param[in] quality Encoder quality.
+    */
+    FALCOR_API void encodeBC4Blocks(const uint8_t* pTiles, uint64_t* pBlocks, size_t count, BC4Quality quality = BC4Quality::Default);
+
+    /** Encode 4x4 tiles of 8-bit values into BC4 blocks on multiple threads.
+        Produces the same blocks as encodeBC4Blocks().
+    */
+    FALCOR_API void encodeBC4BlocksParallel(const uint8_t* pTiles, uint64_t* pBlocks, size_t count, BC4Quality quality = BC4Quality::Default);
+}
+
 // derived from libsquish, alpha.cpp
 /* -----------------------------------------------------------------------------
     Copyright (c) 2006 Simon Brown                          si@sjbrown.co.uk
@@ -63,6 +63,47 @@ namespace Falcor
     }
 
     ref<Grid> Grid::createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    {
+        return loadFromFile(pDevice, path, gridname, true);
+    }
+
+    ref<Grid> Grid::decodeFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    {
+        return loadFromFile(pDevice, path, gridname, false);
+    }
+
+    Grid::~Grid() = default;
+
+    void Grid::upload()
+    {
+        if (isUploaded()) return;
+
+        // Keep both NanoVDB and brick textures resident in GPU memory for simplicity for now (~15% increased footprint).
+        mpBuffer = mpDevice->createStructuredBuffer(
+            sizeof(uint32_t),
+            uint32_t(div_round_up(mGridHandle.size(), sizeof(uint32_t))),
+            ResourceBindFlags::UnorderedAccess | ResourceBindFlags::ShaderResource,
+            MemoryType::DeviceLocal,
+            mGridHandle.data()
+        );
+        mBrickedGrid = mpPendingBricks ? mpPendingBricks->createTextures(mpDevice) : mpCachedBricks->createTextures(mpDevice);
+        mpPendingBricks.reset();
+        mpCachedBricks.reset();
+    }
+
+    void Grid::swapData(Grid& other)
+    {
+        FALCOR_CHECK(mpDevice == other.mpDevice, "Can't swap data of grids created with different devices.");
+        std::swap(mGridHandle, other.mGridHandle);
+        std::swap(mpFloatGrid, other.mpFloatGrid);
+        std::swap(mAccessor, other.mAccessor);
+        std::swap(mpBuffer, other.mpBuffer);
+        std::swap(mBrickedGrid, other.mBrickedGrid);
+        std::swap(mpPendingBricks, other.mpPendingBricks);
+        std::swap(mpCachedBricks, other.mpCachedBricks);
+    }
+
+    ref<Grid> Grid::loadFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname, bool uploadToDevice)
     {
         if (!std::filesystem::exists(path))
         {
@@ -70,19 +111,34 @@ namespace Falcor
             return nullptr;
         }
 
-        if (hasExtension(path, "nvdb"))
-        {
-            return createFromNanoVDBFile(pDevice, path, gridname);
-        }
-        else if (hasExtension(path, "vdb"))
-        {
-            return createFromOpenVDBFile(pDevice, path, gridname);
-        }
-        else
+        const bool isNanoVDB = hasExtension(path, "nvdb");
+        if (!isNanoVDB && !hasExtension(path, "vdb"))
         {
             logWarning("Error when loading grid. Unsupported grid file '{}'.", path);
             return nullptr;
         }
+
+        const bool useCache = GridCache::isEnabled();
+        GridCache::Key cacheKey{};
+        if (useCache)
+        {
+            cacheKey = GridCache::computeKey(path, gridname);
+            if (auto pCacheEntry = GridCache::readCache(cacheKey))
+            {
+                logInfo("Grid cache hit for grid '{}' in '{}'.", gridname, path);
+                ref<Grid> pGrid(new Grid(pDevice, std::move(pCacheEntry)));
+                if (uploadToDevice) pGrid->upload();
+                return pGrid;
+            }
+            logInfo("Grid cache miss for grid '{}' in '{}'.", gridname, path);
+        }
+
+        ref<Grid> pGrid = isNanoVDB ? createFromNanoVDBFile(pDevice, path, gridname) : createFromOpenVDBFile(pDevice, path, gridname);
+        if (!pGrid) return nullptr;
+
+        if (useCache) GridCache::writeCache(cacheKey, pGrid->mGridHandle, *pGrid->mpPendingBricks);
+        if (uploadToDevice) pGrid->upload();
+        return pGrid;
     }
 
     void Grid::renderUI(Gui::Widgets& widget)
@@ -99,6 +155,8 @@ namespace Falcor
 
     void Grid::bindShaderData(const ShaderVar& var)
     {
+        upload();
+
         var["buf"] = mpBuffer;
         var["rangeTex"] = mBrickedGrid.range;
         var["indirectionTex"] = mBrickedGrid.indirection;
@@ -175,7 +233,7 @@ namespace Falcor
         return math::translate(float4x4(invAffine), -translation);
     }
 
-    Grid::Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle)
+    Grid::Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle, bool uploadToDevice)
         : mpDevice(pDevice)
         , mGridHandle(std::move(gridHandle))
         , mpFloatGrid(mGridHandle.grid<float>())
@@ -186,16 +244,20 @@ namespace Falcor
             nanovdb::gridStats(*mpFloatGrid);
         }
 
-        // Keep both NanoVDB and brick textures resident in GPU memory for simplicity for now (~15% increased footprint).
-        mpBuffer = mpDevice->createStructuredBuffer(
-            sizeof(uint32_t),
-            uint32_t(div_round_up(mGridHandle.size(), sizeof(uint32_t))),
-            ResourceBindFlags::UnorderedAccess | ResourceBindFlags::ShaderResource,
-            MemoryType::DeviceLocal,
-            mGridHandle.data()
-        );
-        using NanoVDBGridConverter = NanoVDBConverterBC4;
-        mBrickedGrid = NanoVDBGridConverter(mpFloatGrid).convert(mpDevice);
+        // Convert the bricks on the CPU here, so that decoding on worker threads also covers the brick building.
+        mpPendingBricks = std::make_unique<BrickConverter>(mpFloatGrid);
+        mpPendingBricks->convertBricks();
+
+        if (uploadToDevice) upload();
+    }
+
+    Grid::Grid(ref<Device> pDevice, std::unique_ptr<GridCache::Entry> pCacheEntry)
+        : mpDevice(pDevice)
+        , mGridHandle(pCacheEntry->createGridHandle())
+        , mpFloatGrid(mGridHandle.grid<float>())
+        , mAccessor(mpFloatGrid->getAccessor())
+        , mpCachedBricks(std::move(pCacheEntry))
+    {
     }
 
     ref<Grid> Grid::createFromNanoVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
@@ -226,7 +288,7 @@ namespace Falcor
             return nullptr;
         }
 
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return ref<Grid>(new Grid(pDevice, std::move(handle), false));
     }
 
     ref<Grid> Grid::createFromOpenVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
@@ -269,7 +331,7 @@ namespace Falcor
         openvdb::FloatGrid::Ptr floatGrid = openvdb::gridPtrCast<openvdb::FloatGrid>(baseGrid);
         auto handle = nanovdb::openToNanoVDB(floatGrid);
 
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return ref<Grid>(new Grid(pDevice, std::move(handle), false));
     }
 
 
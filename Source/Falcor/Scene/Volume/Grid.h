@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BrickedGrid.h"
+#include "GridCache.h"
 #include "Core/Macros.h"
 #include "Core/Object.h"
 #include "Core/API/Buffer.h"
@@ -55,6 +56,7 @@ namespace Falcor
 
         /** Create a grid from a file.
             Currently only OpenVDB and NanoVDB grids of type float are supported.
+            If the grid cache is enabled, the converted grid is loaded from or written to the cache (see GridCache).
             \param[in] pDevice GPU device.
             \param[in] path File path of the grid (absolute or relative to working directory).
             \param[in] gridname Name of the grid to load.
@@ -62,6 +64,31 @@ namespace Falcor
         */
         static ref<Grid> createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname);
 
+        /** Decode a grid from a file on the CPU, without creating any GPU resources.
+            This is safe to call from worker threads. The GPU resources are created by upload().
+            \param[in] pDevice GPU device.
+            \param[in] path File path of the grid (absolute or relative to working directory).
+            \param[in] gridname Name of the grid to load.
+            \return A new grid, or nullptr if the grid failed to load.
+        */
+        static ref<Grid> decodeFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname);
+
+        ~Grid();
+
+        /** Create the GPU resources of a grid created with decodeFromFile().
+            Does nothing if the grid is already uploaded.
+        */
+        void upload();
+
+        /** Check if the GPU resources of the grid have been created.
+        */
+        bool isUploaded() const { return mpBuffer != nullptr; }
+
+        /** Swap the host and device data of two grids.
+            This is used to show a new frame of a streamed grid sequence through the same grid object.
+        */
+        void swapData(Grid& other);
+
         /** Render the UI.
         */
         void renderUI(Gui::Widgets& widget);
@@ -118,8 +145,12 @@ namespace Falcor
         float4x4 getInvTransform() const;
 
     private:
-        Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
+        using BrickConverter = GridCache::BrickConverter;
+
+        Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle, bool uploadToDevice = true);
+        Grid(ref<Device> pDevice, std::unique_ptr<GridCache::Entry> pCacheEntry);
 
+        static ref<Grid> loadFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname, bool uploadToDevice);
         static ref<Grid> createFromNanoVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
         static ref<Grid> createFromOpenVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
 
@@ -132,6 +163,9 @@ namespace Falcor
         // Device data.
         ref<Buffer> mpBuffer;
         BrickedGrid mBrickedGrid;
+        // Bricks converted on the CPU or loaded from the grid cache that are waiting for upload().
+        std::unique_ptr<BrickConverter> mpPendingBricks;
+        std::unique_ptr<GridCache::Entry> mpCachedBricks;
 
         friend class SceneCache;
     };
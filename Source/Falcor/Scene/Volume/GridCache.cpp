@@ -0,0 +1,293 @@
+#include "GridCache.h"
+#include "GridConverter.h"
+#include "Core/API/Device.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <fmt/format.h>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Specifies the current cache file version.
+            This needs to be incremented every time the file format or the brick conversion changes!
+        */
+        const uint32_t kVersion = 1;
+
+        /** Grid cache directory (subdirectory in the application data directory).
+        */
+        const std::string kDirectory = "NVIDIA/Falcor/GridCache";
+
+        /** Brick format hashed into the cache key.
+        */
+        const std::string kBrickFormat = "BC4/8";
+
+        const uint64_t kSectionAlignment = 64;
+        const uint32_t kRangeMipCount = 4;
+
+        enum Section : uint32_t
+        {
+            kGridSection,
+            kRangeSection,
+            kIndirectionSection,
+            kAtlasSection,
+            kSectionCount
+        };
+
+        const char* kMagic = "FalcorG$";
+        struct Header
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+            uint32_t atlasFormat{};
+            uint32_t rangeSize[3]{};
+            uint32_t atlasSize[3]{};
+            uint64_t sectionOffset[kSectionCount]{};
+            uint64_t sectionSize[kSectionCount]{};
+
+            bool isValid() const
+            {
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
+            }
+        };
+
+        std::atomic<bool> sEnabled = false;
+        std::atomic<uint64_t> sHitCount = 0;
+        std::atomic<uint64_t> sMissCount = 0;
+        std::atomic<uint64_t> sWriteCount = 0;
+
+        uint64_t alignSection(uint64_t offset)
+        {
+            return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+        }
+
+        uint64_t getTexelCount(const uint32_t size[3], uint32_t mipLevel = 0)
+        {
+            return (uint64_t)(size[0] >> mipLevel) * (size[1] >> mipLevel) * (size[2] >> mipLevel);
+        }
+
+        /** Check that the brick sections hold the texture data described by the header.
+            The range and indirection textures are a multiple of the coarsest range mip in size, and the atlas is BC4 compressed.
+        */
+        bool hasValidTextureSections(const Header& header)
+        {
+            const uint32_t kRangeAlignment = 1u << (kRangeMipCount - 1);
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                if (header.rangeSize[i] == 0 || header.rangeSize[i] % kRangeAlignment != 0) return false;
+                if (header.atlasSize[i] == 0 || header.atlasSize[i] % 4 != 0) return false;
+            }
+
+            uint64_t rangeSize = 0;
+            for (uint32_t mip = 0; mip < kRangeMipCount; ++mip) rangeSize += getTexelCount(header.rangeSize, mip) * sizeof(uint32_t);
+
+            return header.sectionSize[kRangeSection] == rangeSize &&
+                header.sectionSize[kIndirectionSection] == getTexelCount(header.rangeSize) * sizeof(uint32_t) &&
+                header.atlasFormat == (uint32_t)ResourceFormat::BC4Unorm &&
+                header.sectionSize[kAtlasSection] == getTexelCount(header.atlasSize) / 16 * sizeof(uint64_t);
+        }
+    }
+
+    nanovdb::GridHandle<nanovdb::HostBuffer> GridCache::Entry::createGridHandle() const
+    {
+        const Header& header = *reinterpret_cast<const Header*>(mFile.getData());
+        auto buffer = nanovdb::HostBuffer::create(header.sectionSize[kGridSection]);
+        std::memcpy(buffer.data(), getSection(kGridSection), buffer.size());
+        return nanovdb::GridHandle<nanovdb::HostBuffer>(std::move(buffer));
+    }
+
+    BrickedGrid GridCache::Entry::createTextures(ref<Device> pDevice) const
+    {
+        const Header& header = *reinterpret_cast<const Header*>(mFile.getData());
+        const uint32_t* rangeSize = header.rangeSize;
+        const uint32_t* atlasSize = header.atlasSize;
+
+        BrickedGrid bricks;
+        bricks.range = pDevice->createTexture3D(rangeSize[0], rangeSize[1], rangeSize[2], ResourceFormat::RG16Float, kRangeMipCount, getSection(kRangeSection), ResourceBindFlags::ShaderResource);
+        bricks.indirection = pDevice->createTexture3D(rangeSize[0], rangeSize[1], rangeSize[2], ResourceFormat::RGBA8Uint, 1, getSection(kIndirectionSection), ResourceBindFlags::ShaderResource);
+        bricks.atlas = pDevice->createTexture3D(atlasSize[0], atlasSize[1], atlasSize[2], (ResourceFormat)header.atlasFormat, 1, getSection(kAtlasSection), ResourceBindFlags::ShaderResource);
+        return bricks;
+    }
+
+    const uint8_t* GridCache::Entry::getSection(uint32_t index) const
+    {
+        const Header& header = *reinterpret_cast<const Header*>(mFile.getData());
+        return reinterpret_cast<const uint8_t*>(mFile.getData()) + header.sectionOffset[index];
+    }
+
+    void GridCache::setEnabled(bool enabled)
+    {
+        sEnabled = enabled;
+    }
+
+    bool GridCache::isEnabled()
+    {
+        return sEnabled;
+    }
+
+    GridCache::Key GridCache::computeKey(const std::filesystem::path& path, const std::string& gridname)
+    {
+        SHA1 sha1;
+        sha1.update(kBrickFormat);
+        sha1.update((uint64_t)gridname.size());
+        sha1.update(gridname);
+
+        MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (file.isOpen()) sha1.update(file.getData(), file.getSize());
+
+        return sha1.finalize();
+    }
+
+    std::unique_ptr<GridCache::Entry> GridCache::readCache(const Key& key)
+    {
+        auto cachePath = getCachePath(key);
+        std::unique_ptr<Entry> pEntry;
+        if (std::filesystem::exists(cachePath))
+        {
+            pEntry.reset(new Entry());
+            if (!pEntry->mFile.open(cachePath) || pEntry->mFile.getSize() < sizeof(Header))
+            {
+                logWarning("Failed to open grid cache file '{}'.", cachePath);
+                pEntry = nullptr;
+            }
+        }
+
+        if (pEntry)
+        {
+            // Verify the header, the section bounds and the section sizes.
+            const Header& header = *reinterpret_cast<const Header*>(pEntry->mFile.getData());
+            bool valid = header.isValid();
+            for (uint32_t i = 0; i < kSectionCount; ++i)
+            {
+                valid = valid && header.sectionOffset[i] + header.sectionSize[i] <= pEntry->mFile.getSize();
+            }
+            valid = valid && hasValidTextureSections(header);
+            if (!valid)
+            {
+                logWarning("Invalid grid cache file '{}'.", cachePath);
+                pEntry = nullptr;
+            }
+        }
+
+        if (pEntry) sHitCount++;
+        else sMissCount++;
+        return pEntry;
+    }
+
+    void GridCache::writeCache(const Key& key, const nanovdb::GridHandle<nanovdb::HostBuffer>& gridHandle, const BrickConverter& bricks)
+    {
+        auto cachePath = getCachePath(key);
+
+        logInfo("Writing grid cache to '{}'.", cachePath);
+
+        // Create directories if not existing.
+        std::filesystem::create_directories(cachePath.parent_path());
+
+        Header header;
+        std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+        header.version = kVersion;
+        header.atlasFormat = (uint32_t)bricks.getAtlasFormat();
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            header.rangeSize[i] = bricks.getRangeSize()[i];
+            header.atlasSize[i] = bricks.getAtlasSizePixels()[i];
+        }
+
+        const void* sectionData[kSectionCount] = {
+            gridHandle.data(), bricks.getRangeData().data(), bricks.getPtrData().data(), bricks.getAtlasData().data()
+        };
+        header.sectionSize[kGridSection] = gridHandle.size();
+        header.sectionSize[kRangeSection] = bricks.getRangeData().size() * sizeof(uint32_t);
+        header.sectionSize[kIndirectionSection] = bricks.getPtrData().size() * sizeof(uint32_t);
+        header.sectionSize[kAtlasSection] = bricks.getAtlasData().size() * sizeof(uint64_t);
+        uint64_t offset = sizeof(Header);
+        for (uint32_t i = 0; i < kSectionCount; ++i)
+        {
+            header.sectionOffset[i] = alignSection(offset);
+            offset = header.sectionOffset[i] + header.sectionSize[i];
+        }
+
+        // Write to a temporary file first, so that concurrent loads of the same grid never see a partial cache file.
+        auto tempPath = cachePath;
+        tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream fs(tempPath, std::ios_base::binary);
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (uint32_t i = 0; i < kSectionCount; ++i)
+            {
+                const std::vector<char> padding(header.sectionOffset[i] - (uint64_t)fs.tellp(), 0);
+                fs.write(padding.data(), padding.size());
+                fs.write(reinterpret_cast<const char*>(sectionData[i]), header.sectionSize[i]);
+            }
+            if (!fs)
+            {
+                logWarning("Failed to write grid cache file '{}'.", cachePath);
+                fs.close();
+                std::filesystem::remove(tempPath);
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, cachePath, ec);
+        if (ec)
+        {
+            // Another thread or process may have written (and mapped) the same cache file in the meantime.
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+        sWriteCount++;
+    }
+
+    void GridCache::clear()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(getAppDataDirectory() / kDirectory, ec);
+        if (ec) logWarning("Failed to clear grid cache: {}", ec.message());
+    }
+
+    GridCache::Stats GridCache::getStats()
+    {
+        Stats stats;
+        stats.hitCount = sHitCount;
+        stats.missCount = sMissCount;
+        stats.writeCount = sWriteCount;
+        return stats;
+    }
+
+    void GridCache::resetStats()
+    {
+        sHitCount = 0;
+        sMissCount = 0;
+        sWriteCount = 0;
+    }
+
+    std::filesystem::path GridCache::getCachePath(const Key& key)
+    {
+        return getAppDataDirectory() / kDirectory / SHA1::toString(key);
+    }
+
+    FALCOR_SCRIPT_BINDING(GridCache)
+    {
+        pybind11::class_<GridCache> gridCache(m, "GridCache");
+
+        pybind11::class_<GridCache::Stats> stats(gridCache, "Stats");
+        stats.def_readonly("hitCount", &GridCache::Stats::hitCount);
+        stats.def_readonly("missCount", &GridCache::Stats::missCount);
+        stats.def_readonly("writeCount", &GridCache::Stats::writeCount);
+
+        gridCache.def_property_static(
+            "enabled",
+            [](pybind11::object) { return GridCache::isEnabled(); },
+            [](pybind11::object, bool enabled) { GridCache::setEnabled(enabled); }
+        );
+        gridCache.def_property_readonly_static("stats", [](pybind11::object) { return GridCache::getStats(); });
+        gridCache.def_static("resetStats", &GridCache::resetStats);
+        gridCache.def_static("clear", &GridCache::clear);
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "BrickedGrid.h"
+#include "Core/Macros.h"
+#include "Core/API/fwd.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/CryptoUtils.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4244 4267)
+#endif
+#include <nanovdb/NanoVDB.h>
+#include <nanovdb/util/GridHandle.h>
+#include <nanovdb/util/HostBuffer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace Falcor
+{
+    template <typename TexelType, unsigned int kBitsPerTexel> struct NanoVDBToBricksConverter;
+
+    /** Helper class for reading and writing the grid cache files.
+
+        The grid cache stores the NanoVDB grid and the bricks built from a grid file, so that loading
+        the same grid again skips the OpenVDB to NanoVDB conversion and the brick building.
+        Cache files are stored uncompressed and read through memory mapping.
+        The cache is keyed by the contents of the grid file, the grid name and the brick format.
+    */
+    class FALCOR_API GridCache
+    {
+    public:
+        using Key = SHA1::MD;
+        using BrickConverter = NanoVDBToBricksConverter<uint64_t, 4>;
+
+        /** Cache statistics since the start of the application or the last call to resetStats().
+        */
+        struct Stats
+        {
+            uint64_t hitCount = 0;      ///< Number of grids loaded from the cache.
+            uint64_t missCount = 0;     ///< Number of grids not found in the cache.
+            uint64_t writeCount = 0;    ///< Number of cache files written.
+        };
+
+        /** Grid data of a cache file mapped into memory.
+        */
+        class FALCOR_API Entry
+        {
+        public:
+            /** Create a NanoVDB grid handle holding a copy of the cached grid.
+            */
+            nanovdb::GridHandle<nanovdb::HostBuffer> createGridHandle() const;
+
+            /** Create the brick textures directly from the mapped cache file.
+            */
+            BrickedGrid createTextures(ref<Device> pDevice) const;
+
+        private:
+            Entry() = default;
+            const uint8_t* getSection(uint32_t index) const;
+
+            MemoryMappedFile mFile;
+
+            friend class GridCache;
+        };
+
+        /** Enable/disable the grid cache. The cache is disabled by default.
+        */
+        static void setEnabled(bool enabled);
+
+        /** Check if the grid cache is enabled.
+        */
+        static bool isEnabled();
+
+        /** Compute the cache key of a grid in a file.
+            \param[in] path File path of the grid.
+            \param[in] gridname Name of the grid.
+            \return The cache key.
+        */
+        static Key computeKey(const std::filesystem::path& path, const std::string& gridname);
+
+        /** Read a cache file.
+            \param[in] key Cache key.
+            \return The mapped cache entry, or nullptr if the grid is not in the cache.
+        */
+        static std::unique_ptr<Entry> readCache(const Key& key);
+
+        /** Write a cache file.
+            \param[in] key Cache key.
+            \param[in] gridHandle NanoVDB grid.
+            \param[in] bricks Bricks converted from the grid.
+        */
+        static void writeCache(const Key& key, const nanovdb::GridHandle<nanovdb::HostBuffer>& gridHandle, const BrickConverter& bricks);
+
+        /** Remove all grid cache files.
+        */
+        static void clear();
+
+        /** Get the cache statistics.
+        */
+        static Stats getStats();
+
+        /** Reset the cache statistics.
+        */
+        static void resetStats();
+
+        /** Get the path of a cache file.
+        */
+        static std::filesystem::path getCachePath(const Key& key);
+    };
+}
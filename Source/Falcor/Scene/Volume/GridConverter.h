@@ -19,7 +19,6 @@
 #endif
 
 #include <algorithm>
-#include <atomic>
 #include <execution>
 #include <vector>
 
@@ -39,18 +38,27 @@ namespace Falcor
 
         BrickedGrid convert(ref<Device> pDevice);
 
-    private:
-        const static uint32_t kBrickSize = 8; // Must be 8, to match both NanoVDB leaf size.
-        const static int32_t kBC4Compress = kBitsPerTexel == 4;
+        /** Convert the grid into bricks on the CPU, without creating the textures.
+            Bricks are allocated in slice order, so the result is the same for serial and parallel conversion.
+            \param[in] parallel Convert slices and mip levels in parallel.
+        */
+        void convertBricks(bool parallel = true);
 
-        void convertSlice(int z);
-        void computeMip(int mip);
+        /** Create the brick textures from the result of convertBricks().
+            \param[in] pDevice GPU device.
+        */
+        BrickedGrid createTextures(ref<Device> pDevice) const;
 
-        inline uint3 getAtlasSizeBricks() const { return mAtlasSizeBricks; }
+        const std::vector<uint32_t>& getRangeData() const { return mRangeData; }
+        const std::vector<uint32_t>& getPtrData() const { return mPtrData; }
+        const std::vector<TexelType>& getAtlasData() const { return mAtlasData; }
+
+        /** Size of the range and indirection textures, one texel per brick at mip 0. The range texture has 4 mips.
+        */
+        inline uint3 getRangeSize() const { return uint3(mLeafDim[0]); }
         inline uint3 getAtlasSizePixels() const { return mAtlasSizeBricks * kBrickSize; }
-        inline uint32_t getAtlasMaxBrick() const { return mAtlasSizeBricks.x * mAtlasSizeBricks.y * mAtlasSizeBricks.z; }
 
-        inline ResourceFormat getAtlasFormat() {
+        inline ResourceFormat getAtlasFormat() const {
             switch (kBitsPerTexel) {
             case 4: return ResourceFormat::BC4Unorm;
             case 8: return ResourceFormat::R8Unorm;
@@ -59,6 +67,30 @@ namespace Falcor
             }
         }
 
+    private:
+        const static uint32_t kBrickSize = 8; // Must be 8, to match both NanoVDB leaf size.
+        const static int32_t kBC4Compress = kBitsPerTexel == 4;
+
+        using AccessorType = nanovdb::FloatGrid::AccessorType;
+
+        void computeSliceRanges(int z);
+        void allocateBricks();
+        void fillSliceBricks(int z);
+        void writeBrick(const float* data, uint3 atlasBrick, float minorant, float majorant);
+        void computeMipSlice(int mip, int z);
+        void expandHalo(AccessorType& a, const nanovdb::Coord& ijk, float& min_inout, float& maj_inout);
+
+        template<typename Func>
+        void forEachSlice(int sliceCount, bool parallel, const Func& func)
+        {
+            auto range = NumericRange<int>(0, sliceCount);
+            if (parallel) std::for_each(std::execution::par, range.begin(), range.end(), func);
+            else std::for_each(range.begin(), range.end(), func);
+        }
+
+        inline uint3 getAtlasSizeBricks() const { return mAtlasSizeBricks; }
+        inline uint32_t getAtlasMaxBrick() const { return mAtlasSizeBricks.x * mAtlasSizeBricks.y * mAtlasSizeBricks.z; }
+
         inline float2 combineMajMin(float2 a, float2 b)
         {
             return float2(std::max(a.x, b.x), std::min(a.y, b.y));
@@ -76,6 +108,30 @@ namespace Falcor
             if (value > maj_inout) maj_inout = value;
         }
 
+        inline void expandMinorantMajorant(const float* values, int count, float& min_inout, float& maj_inout)
+        {
+            // Reduce into independent lanes first, so the compiler can vectorize the loop.
+            const int kLanes = 8;
+            float mins[kLanes], majs[kLanes];
+            std::fill_n(mins, kLanes, min_inout);
+            std::fill_n(majs, kLanes, maj_inout);
+            int i = 0;
+            for (; i + kLanes <= count; i += kLanes)
+            {
+                for (int l = 0; l < kLanes; ++l)
+                {
+                    mins[l] = values[i + l] < mins[l] ? values[i + l] : mins[l];
+                    majs[l] = values[i + l] > majs[l] ? values[i + l] : majs[l];
+                }
+            }
+            for (; i < count; ++i) expandMinorantMajorant(values[i], min_inout, maj_inout);
+            for (int l = 0; l < kLanes; ++l)
+            {
+                expandMinorantMajorant(mins[l], min_inout, maj_inout);
+                expandMinorantMajorant(majs[l], min_inout, maj_inout);
+            }
+        }
+
         const nanovdb::FloatGrid* mpFloatGrid;
         uint3 mAtlasSizeBricks;
         int3 mLeafDim[4];
@@ -84,13 +140,12 @@ namespace Falcor
         std::vector<uint32_t> mRangeData;
         std::vector<uint32_t> mPtrData;
         std::vector<TexelType> mAtlasData;
-        std::atomic_uint32_t mNonEmptyCount;
+        uint32_t mNonEmptyCount = 0;
     };
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid)
     {
-        mNonEmptyCount.store(0);
         mpFloatGrid = grid;
         auto& voxelbox = mpFloatGrid->indexBBox();
         mBBMin = (int3(voxelbox.min().x(), voxelbox.min().y(), voxelbox.min().z())) & (~7);
@@ -114,13 +169,46 @@ namespace Falcor
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertSlice(int z)
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::expandHalo(AccessorType& a, const nanovdb::Coord& ijk, float& min_inout, float& maj_inout)
     {
-        uint3 atlasSizePixels = getAtlasSizePixels();
-        uint brickMax = getAtlasMaxBrick();
-        uint bricksPerSlice = mAtlasSizeBricks.x * mAtlasSizeBricks.y;
-        uint pixelsPerSlice = atlasSizePixels.x * atlasSizePixels.y;
+        // The 1-halo consists of a face, edge or corner of each of the 26 neighbouring bricks.
+        // Neighbours without a leaf have a constant value, otherwise the halo voxels are read straight from the leaf.
+        const int kLast = kBrickSize - 1;
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    if (dx == 0 && dy == 0 && dz == 0) continue;
+                    nanovdb::Coord neighbour = ijk + nanovdb::Coord(dx * kBrickSize, dy * kBrickSize, dz * kBrickSize);
+                    auto leaf = a.probeLeaf(neighbour);
+                    if (!leaf)
+                    {
+                        expandMinorantMajorant(a.getValue(neighbour), min_inout, maj_inout);
+                        continue;
+                    }
+
+                    const float* data = leaf->data()->mValues;
+                    int x0 = dx < 0 ? kLast : 0, x1 = dx > 0 ? 1 : kBrickSize;
+                    int y0 = dy < 0 ? kLast : 0, y1 = dy > 0 ? 1 : kBrickSize;
+                    int z0 = dz < 0 ? kLast : 0, z1 = dz > 0 ? 1 : kBrickSize;
+                    for (int x = x0; x < x1; ++x)
+                    {
+                        for (int y = y0; y < y1; ++y)
+                        {
+                            expandMinorantMajorant(data + x * kBrickSize * kBrickSize + y * kBrickSize + z0, z1 - z0, min_inout, maj_inout);
+                        }
+                    }
+                }
+            }
+        }
+    }
 
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeSliceRanges(int z)
+    {
+        // Computes the minorant/majorant of each brick in the slice, and flags the bricks that need to be stored in the atlas.
         size_t offset = z * mLeafDim[0].x * mLeafDim[0].y;
         uint32_t* rangedst = mRangeData.data() + offset;
         uint32_t* ptrdst = mPtrData.data() + offset;
@@ -133,99 +221,137 @@ namespace Falcor
                 auto val = a.getValue(ijk);
                 auto leaf = a.probeLeaf(ijk);
                 float minorant = val, majorant = val;
-                uint myleaf = 0;
                 if (leaf)
                 {
-                    // Nanovdb only stores minorant/majorant for active voxels, but we need all of them... Grab the central 8x8x8 first the quick way.
-                    const float* data = leaf->data()->mValues;
-                    for (int i = 0; i < kBrickSize * kBrickSize * kBrickSize; ++i) expandMinorantMajorant(data[i], minorant, majorant);
-                    // We also need the 1-halo from neighbouring bricks. Fetch them in an order that maximises nanovdb's internal cache reuse.
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, j, kBrickSize)), minorant, majorant);
-                    for (int j = 0; j < kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, -1, j)), minorant, majorant);
-                    for (int j = 0; j < kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, kBrickSize, j)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, i)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, i)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, kBrickSize)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, kBrickSize)), minorant, majorant);
-
-                    if (minorant != majorant) myleaf = mNonEmptyCount.fetch_add(1);
+                    // Nanovdb only stores minorant/majorant for active voxels, but we need all of them, including the 1-halo from neighbouring bricks.
+                    expandMinorantMajorant(leaf->data()->mValues, kBrickSize * kBrickSize * kBrickSize, minorant, majorant);
+                    expandHalo(a, ijk, minorant, majorant);
                 }
-                if (majorant == minorant || myleaf >= brickMax || leaf == nullptr)
+                *rangedst++ = f32tof16(majorant) + (f32tof16(minorant) << 16);
+                *ptrdst++ = (leaf && minorant != majorant) ? 1 : 0;
+            }
+        }
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::allocateBricks()
+    {
+        // Assign atlas bricks in slice order. The pointer data holds the brick index + 1 until the bricks are filled.
+        uint32_t brickMax = getAtlasMaxBrick();
+        mNonEmptyCount = 0;
+        for (size_t i = 0; i < mLeafCount[0]; ++i)
+        {
+            if (mPtrData[i] == 0) continue;
+            uint32_t brick = mNonEmptyCount++;
+            if (brick < brickMax)
+            {
+                mPtrData[i] = brick + 1;
+            }
+            else
+            {
+                uint32_t majorant = mRangeData[i] & 0xffff;
+                mRangeData[i] = majorant + (majorant << 16); // force identical major and minor
+                mPtrData[i] = 0;
+            }
+        }
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::fillSliceBricks(int z)
+    {
+        size_t offset = z * mLeafDim[0].x * mLeafDim[0].y;
+        uint32_t* rangedst = mRangeData.data() + offset;
+        uint32_t* ptrdst = mPtrData.data() + offset;
+        auto a = mpFloatGrid->getAccessor();
+        for (int y = 0; y < mLeafDim[0].y; ++y)
+        {
+            for (int x = 0; x < mLeafDim[0].x; ++x, ++rangedst, ++ptrdst)
+            {
+                if (*ptrdst == 0) continue;
+                uint32_t myleaf = *ptrdst - 1;
+                nanovdb::Coord ijk = { x * 8 + mBBMin.x, y * 8 + mBBMin.y, z * 8 + mBBMin.z };
+                auto leaf = a.probeLeaf(ijk);
+                FALCOR_ASSERT(leaf);
+
+                float majorant = f16tof32((*rangedst & 0xffff) + 1);
+                float minorant = f16tof32(*rangedst >> 16);
+                *rangedst = f32tof16(majorant) + (f32tof16(minorant) << 16);
+                uint32_t atlasx = myleaf % mAtlasSizeBricks.x;
+                uint32_t atlasy = (myleaf / mAtlasSizeBricks.x) % mAtlasSizeBricks.y;
+                uint32_t atlasz = myleaf / (mAtlasSizeBricks.x * mAtlasSizeBricks.y);
+                *ptrdst = (atlasx + (atlasy << 8) + (atlasz << 16));
+
+                writeBrick(leaf->data()->mValues, uint3(atlasx, atlasy, atlasz), minorant, majorant);
+            } // x brick loop
+        } // y brick loop
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::writeBrick(const float* data, uint3 atlasBrick, float minorant, float majorant)
+    {
+        uint3 atlasSizePixels = getAtlasSizePixels();
+        uint pixelsPerSlice = atlasSizePixels.x * atlasSizePixels.y;
+        uint32_t atlasx = atlasBrick.x, atlasy = atlasBrick.y, atlasz = atlasBrick.z;
+
+        if (!kBC4Compress) {
+            float invRange = ((1 << kBitsPerTexel) - 1.f) / (majorant - minorant);
+            TexelType* atlasdst = (TexelType*)mAtlasData.data() + atlasx * kBrickSize + atlasy * (atlasSizePixels.x * kBrickSize) + atlasz * (pixelsPerSlice * kBrickSize);
+            for (int pixz = 0; pixz < kBrickSize; ++pixz)
+            {
+                for (int pixy = 0; pixy < kBrickSize; ++pixy)
                 {
-                    *rangedst++ = f32tof16(majorant) + (f32tof16(majorant) << 16); // force identical major and minor
-                    *ptrdst++ = 0;
+                    for (int pixx = 0; pixx < kBrickSize; ++pixx)
+                    {
+                        float f = data[pixx * kBrickSize * kBrickSize + pixy * kBrickSize + pixz];
+                        *atlasdst++ = TexelType((f - minorant) * invRange);
+                    }
+                    atlasdst += (atlasSizePixels.x - kBrickSize); // next scanline
                 }
-                else
+                atlasdst += (pixelsPerSlice - (atlasSizePixels.x * kBrickSize)); // next slice
+            }
+        }
+        else {
+            // BC4 compression: gather the 4x4 tiles of the brick and encode them in one batch.
+            const int kTilesPerBrick = kBrickSize * (kBrickSize / 4) * (kBrickSize / 4);
+            uint8_t tilevals[kTilesPerBrick][4][4];
+            uint64_t blocks[kTilesPerBrick];
+            float invRange = (255.f) / (majorant - minorant);
+            int tile = 0;
+            for (int pixz = 0; pixz < kBrickSize; ++pixz)
+            {
+                for (int tiley = 0; tiley < kBrickSize; tiley += 4)
                 {
-                    const float* data = leaf->data()->mValues;
-                    majorant = f16tof32(f32tof16(majorant) + 1);
-                    minorant = f16tof32(f32tof16(minorant));
-                    *rangedst++ = f32tof16(majorant) + (f32tof16(minorant) << 16);
-                    uint32_t atlasx = myleaf % mAtlasSizeBricks.x;
-                    uint32_t atlasy = (myleaf / mAtlasSizeBricks.x) % mAtlasSizeBricks.y;
-                    uint32_t atlasz = myleaf / bricksPerSlice;
-                    *ptrdst++ = (atlasx + (atlasy << 8) + (atlasz << 16));
-
-                    if (!kBC4Compress) {
-                        float invRange = ((1 << kBitsPerTexel) - 1.f) / (majorant - minorant);
-                        TexelType* atlasdst = (TexelType*)mAtlasData.data() + atlasx * kBrickSize + atlasy * (atlasSizePixels.x * kBrickSize) + atlasz * (pixelsPerSlice * kBrickSize);
-                        for (int pixz = 0; pixz < kBrickSize; ++pixz)
+                    for (int tilex = 0; tilex < kBrickSize; tilex += 4, ++tile) {
+                        for (int pixy = 0; pixy < 4; ++pixy)
                         {
-                            for (int pixy = 0; pixy < kBrickSize; ++pixy)
+                            for (int pixx = 0; pixx < 4; ++pixx)
                             {
-                                for (int pixx = 0; pixx < kBrickSize; ++pixx)
-                                {
-                                    float f = data[pixx * kBrickSize * kBrickSize + pixy * kBrickSize + pixz];
-                                    *atlasdst++ = TexelType((f - minorant) * invRange);
-                                }
-                                atlasdst += (atlasSizePixels.x - kBrickSize); // next scanline
+                                float f = data[(pixx + tilex) * (kBrickSize * kBrickSize) + (pixy + tiley) * kBrickSize + pixz];
+                                tilevals[tile][pixy][pixx] = uint8_t((f - minorant) * invRange);
                             }
-                            atlasdst += (pixelsPerSlice - (atlasSizePixels.x * kBrickSize)); // next slice
                         }
                     }
-                    else {
-                        // BC4 compression:
-                        float invRange = (255.f) / (majorant - minorant);
-                        uint64_t* atlasdst = ((uint64_t*)mAtlasData.data() + atlasx * (kBrickSize / 4) + atlasy * ((atlasSizePixels.x / 4) * kBrickSize / 4) + atlasz * (pixelsPerSlice / 16 * kBrickSize));
-                        for (int pixz = 0; pixz < kBrickSize; ++pixz)
-                        {
-                            for (int tiley = 0; tiley < kBrickSize; tiley += 4)
-                            {
-                                for (int tilex = 0; tilex < kBrickSize; tilex += 4) {
-                                    uint8_t tilevals[4][4];
-                                    uint8_t tileminorant = 255, tilemajorant = 0;
-                                    for (int pixy = 0; pixy < 4; ++pixy)
-                                    {
-                                        for (int pixx = 0; pixx < 4; ++pixx)
-                                        {
-                                            float f = data[(pixx + tilex) * (kBrickSize * kBrickSize) + (pixy + tiley) * kBrickSize + pixz];
-                                            uint8_t voxel = uint8_t((f - minorant) * invRange);
-                                            tileminorant = std::min(tileminorant, voxel);
-                                            tilemajorant = std::max(tilemajorant, voxel);
-                                            tilevals[pixy][pixx] = voxel;
-                                        }
-                                    }
-                                    CompressAlphaDxt5((uint8_t*)&tilevals[0][0], atlasdst);
-                                    atlasdst++;
-                                }
-                                atlasdst += (atlasSizePixels.x / 4 - kBrickSize / 4); // next scanline
-                            }
-                            atlasdst += (pixelsPerSlice / 16 - (atlasSizePixels.x / 4 * kBrickSize / 4)); // next slice
-                        } // z slice loop
-                    } // bc4 compress?
-                } // non empty brick?
-            } // x brick loop
-        } // y brick loop
+                }
+            }
+            encodeBC4Blocks(&tilevals[0][0][0], blocks, kTilesPerBrick);
+
+            const uint64_t* blocksrc = blocks;
+            uint64_t* atlasdst = ((uint64_t*)mAtlasData.data() + atlasx * (kBrickSize / 4) + atlasy * ((atlasSizePixels.x / 4) * kBrickSize / 4) + atlasz * (pixelsPerSlice / 16 * kBrickSize));
+            for (int pixz = 0; pixz < kBrickSize; ++pixz)
+            {
+                for (int tiley = 0; tiley < kBrickSize; tiley += 4)
+                {
+                    for (int tilex = 0; tilex < kBrickSize; tilex += 4) *atlasdst++ = *blocksrc++;
+                    atlasdst += (atlasSizePixels.x / 4 - kBrickSize / 4); // next scanline
+                }
+                atlasdst += (pixelsPerSlice / 16 - (atlasSizePixels.x / 4 * kBrickSize / 4)); // next slice
+            } // z slice loop
+        } // bc4 compress?
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMip(int mip)
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMipSlice(int mip, int z)
     {
-        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1];
-        uint32_t* rangesrc = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0);
         int3 leafdim_src = mLeafDim[mip - 1];
         uint32_t rowstride_src = leafdim_src.x;
         uint32_t slicestride_src = leafdim_src.y * rowstride_src;
@@ -234,43 +360,60 @@ namespace Falcor
         uint32_t rowstride_tgt = leafdim_tgt.x;
         uint32_t slicestride_tgt = leafdim_tgt.y * rowstride_tgt;
 
-        for (int z = 0; z < leafdim_tgt.z; ++z, rangesrc += slicestride_src)
+        // Each target slice covers two source slices.
+        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1] + z * slicestride_tgt;
+        const uint32_t* rangesrc = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0) + 2 * z * slicestride_src;
+
+        for (int y = 0; y < leafdim_tgt.y; ++y, rangesrc += rowstride_src)
         {
-            for (int y = 0; y < leafdim_tgt.y; ++y, rangesrc += rowstride_src)
+            for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
             {
-                for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
-                {
-                    float2 majmin_dst = combineMajMin(
-                        combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
-                        ),
-                        combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
-                        )
-                    );
-                    *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
-                } // x
-            } // y
-        } // z
+                float2 majmin_dst = combineMajMin(
+                    combineMajMin(
+                        combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
+                        combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
+                    ),
+                    combineMajMin(
+                        combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
+                        combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
+                    )
+                );
+                *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
+            } // x
+        } // y
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertBricks(bool parallel)
+    {
+        forEachSlice(mLeafDim[0].z, parallel, [&](int z) { computeSliceRanges(z); });
+        allocateBricks();
+        forEachSlice(mLeafDim[0].z, parallel, [&](int z) { fillSliceBricks(z); });
+        for (int mip = 1; mip < 4; ++mip)
+        {
+            forEachSlice(mLeafDim[mip].z, parallel, [&](int z) { computeMipSlice(mip, z); });
+        }
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convert(ref<Device> pDevice)
     {
         auto t0 = CpuTimer::getCurrentTimePoint();
-        auto range = NumericRange<int>(0, mLeafDim[0].z);
-        std::for_each(std::execution::par, range.begin(), range.end(), [&](int z) { convertSlice(z); });
-        for (int mip = 1; mip < 4; ++mip) computeMip(mip);
+        convertBricks();
+        BrickedGrid bricks = createTextures(pDevice);
+
+        double dt = CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
+        logDebug("Converted '{}' in {:.4}ms: mNonEmptyCount {} vs max {}", mpFloatGrid->gridName(), dt, mNonEmptyCount, getAtlasMaxBrick());
+        return bricks;
+    }
 
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::createTextures(ref<Device> pDevice) const
+    {
         BrickedGrid bricks;
         bricks.range = pDevice->createTexture3D(mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RG16Float, 4, mRangeData.data(), ResourceBindFlags::ShaderResource);
         bricks.indirection = pDevice->createTexture3D(mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RGBA8Uint, 1, mPtrData.data(), ResourceBindFlags::ShaderResource);
         bricks.atlas = pDevice->createTexture3D(getAtlasSizePixels().x, getAtlasSizePixels().y, getAtlasSizePixels().z, getAtlasFormat(), 1, mAtlasData.data(), ResourceBindFlags::ShaderResource);
-
-        double dt = CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
-        logDebug("Converted '{}' in {:.4}ms: mNonEmptyCount {} vs max {}", mpFloatGrid->gridName(), dt, mNonEmptyCount.load(), getAtlasMaxBrick());
         return bricks;
     }
 }
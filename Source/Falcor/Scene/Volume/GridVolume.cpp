@@ -2,10 +2,14 @@
 #include "Grid.h"
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "GlobalState.h"
 #include <set>
 #include <filesystem>
+#include <execution>
+#include <exception>
+#include <thread>
 
 namespace Falcor
 {
@@ -22,6 +26,38 @@ namespace Falcor
         const float kMaxAnisotropy = 0.99f;
         const double kMinFrameRate = 1.0;
         const double kMaxFrameRate = 1000.0;
+
+        /** Enumerate the grid files in a directory, sorted by length first, then alpha-numerically.
+            \return True if the path is a directory.
+        */
+        bool findGridFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& paths)
+        {
+            if (!std::filesystem::exists(path))
+            {
+                logWarning("'{}' does not exist.", path);
+                return false;
+            }
+            if (!std::filesystem::is_directory(path))
+            {
+                logWarning("'{}' is not a directory.", path);
+                return false;
+            }
+
+            // Enumerate grid files.
+            for (auto it : std::filesystem::directory_iterator(path))
+            {
+                if (hasExtension(it.path(), "nvdb") || hasExtension(it.path(), "vdb")) paths.push_back(it.path());
+            }
+
+            // Sort by length first, then alpha-numerically.
+            auto cmp = [](const std::filesystem::path& a, const std::filesystem::path& b) {
+                auto sa = a.string();
+                auto sb = b.string();
+                return sa.length() != sb.length() ? sa.length() < sb.length() : sa < sb;
+            };
+            std::sort(paths.begin(), paths.end(), cmp);
+            return true;
+        }
     }
 
     static_assert(sizeof(GridVolumeData) % 16 == 0, "GridVolumeData size should be a multiple of 16");
@@ -56,6 +92,10 @@ namespace Falcor
         if (const auto& densityGrid = getDensityGrid())
         {
             if (auto group = widget.group("Density Grid")) densityGrid->renderUI(group);
+            if (const auto& pStreamingGrids = getStreamingGridSequence(GridSlot::Density))
+            {
+                if (auto group = widget.group("Density Grid Streaming")) pStreamingGrids->renderUI(group);
+            }
 
             float densityScale = getDensityScale();
             if (widget.var("Density scale", densityScale, 0.f, std::numeric_limits<float>::max(), 0.01f)) setDensityScale(densityScale);
@@ -64,6 +104,10 @@ namespace Falcor
         if (const auto& emissionGrid = getEmissionGrid())
         {
             if (auto group = widget.group("Emission Grid")) emissionGrid->renderUI(group);
+            if (const auto& pStreamingGrids = getStreamingGridSequence(GridSlot::Emission))
+            {
+                if (auto group = widget.group("Emission Grid Streaming")) pStreamingGrids->renderUI(group);
+            }
 
             float emissionScale = getEmissionScale();
             if (widget.var("Emission scale", emissionScale, 0.f, std::numeric_limits<float>::max(), 0.01f)) setEmissionScale(emissionScale);
@@ -100,13 +144,40 @@ namespace Falcor
 
     GridVolume::GridSequence GridVolume::createGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty)
     {
-        GridSequence grids;
-        for (const auto& path : paths)
+        GridSequence grids(paths.size());
+        std::vector<std::exception_ptr> exceptions(paths.size());
+
+        // Decode the files in batches on worker threads and create the GPU resources on the calling thread.
+        // Batching bounds the memory held by decoded grids that are waiting for upload.
+        const size_t batchSize = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t batchStart = 0; batchStart < paths.size(); batchStart += batchSize)
         {
-            auto grid = Grid::createFromFile(pDevice, path, gridname);
-            if (keepEmpty || grid) grids.push_back(grid);
+            auto range = NumericRange<size_t>(batchStart, std::min(batchStart + batchSize, paths.size()));
+            std::for_each(
+                std::execution::par,
+                range.begin(),
+                range.end(),
+                [&](size_t i)
+                {
+                    try
+                    {
+                        grids[i] = Grid::decodeFromFile(pDevice, paths[i], gridname);
+                    }
+                    catch (...)
+                    {
+                        exceptions[i] = std::current_exception();
+                    }
+                }
+            );
+
+            for (size_t i : range)
+            {
+                if (exceptions[i]) std::rethrow_exception(exceptions[i]);
+                if (grids[i]) grids[i]->upload();
+            }
         }
 
+        if (!keepEmpty) grids.erase(std::remove(grids.begin(), grids.end(), nullptr), grids.end());
         return grids;
     }
 
@@ -119,33 +190,42 @@ namespace Falcor
 
     uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty)
     {
-        if (!std::filesystem::exists(path))
-        {
-            logWarning("'{}' does not exist.", path);
-            return 0;
-        }
-        if (!std::filesystem::is_directory(path))
-        {
-            logWarning("'{}' is not a directory.", path);
-            return 0;
-        }
+        std::vector<std::filesystem::path> paths;
+        if (!findGridFiles(path, paths)) return 0;
+
+        return loadGridSequence(slot, paths, gridname, keepEmpty);
+    }
+
+    uint32_t GridVolume::streamGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize)
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
+
+        auto pStreamingGrids = StreamingGridSequence::create(mpDevice, paths, gridname, windowSize);
+        setGrid(slot, pStreamingGrids ? pStreamingGrids->getGrid() : nullptr);
+        if (!pStreamingGrids) return 0;
+
+        mStreamingGrids[slotIndex] = pStreamingGrids;
+        updateSequence();
+        pStreamingGrids->setFrame(mGridFrame);
+        updateBounds();
+        return pStreamingGrids->getFrameCount();
+    }
 
-        // Enumerate grid files.
+    uint32_t GridVolume::streamGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t windowSize)
+    {
         std::vector<std::filesystem::path> paths;
-        for (auto it : std::filesystem::directory_iterator(path))
-        {
-            if (hasExtension(it.path(), "nvdb") || hasExtension(it.path(), "vdb")) paths.push_back(it.path());
-        }
+        if (!findGridFiles(path, paths)) return 0;
 
-        // Sort by length first, then alpha-numerically.
-        auto cmp = [](const std::filesystem::path& a, const std::filesystem::path& b) {
-            auto sa = a.string();
-            auto sb = b.string();
-            return sa.length() != sb.length() ? sa.length() < sb.length() : sa < sb;
-        };
-        std::sort(paths.begin(), paths.end(), cmp);
+        return streamGridSequence(slot, paths, gridname, windowSize);
+    }
 
-        return loadGridSequence(slot, paths, gridname, keepEmpty);
+    const ref<StreamingGridSequence>& GridVolume::getStreamingGridSequence(GridSlot slot) const
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
+
+        return mStreamingGrids[slotIndex];
     }
 
     void GridVolume::setGridSequence(GridSlot slot, const GridSequence& grids)
@@ -153,9 +233,10 @@ namespace Falcor
         uint32_t slotIndex = (uint32_t)slot;
         FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
 
-        if (mGrids[slotIndex] != grids)
+        if (mGrids[slotIndex] != grids || mStreamingGrids[slotIndex])
         {
             mGrids[slotIndex] = grids;
+            mStreamingGrids[slotIndex] = nullptr;
             updateSequence();
             updateBounds();
             markUpdates(UpdateFlags::GridsChanged);
@@ -202,6 +283,10 @@ namespace Falcor
         if (mGridFrame != gridFrame)
         {
             mGridFrame = gridFrame;
+            for (const auto& pStreamingGrids : mStreamingGrids)
+            {
+                if (pStreamingGrids) pStreamingGrids->setFrame(gridFrame);
+            }
             markUpdates(UpdateFlags::GridsChanged);
             updateBounds();
         }
@@ -302,6 +387,10 @@ namespace Falcor
     {
         mGridFrameCount = 1;
         for (const auto& grids : mGrids) mGridFrameCount = std::max(mGridFrameCount, (uint32_t)grids.size());
+        for (const auto& pStreamingGrids : mStreamingGrids)
+        {
+            if (pStreamingGrids) mGridFrameCount = std::max(mGridFrameCount, pStreamingGrids->getFrameCount());
+        }
         setGridFrame(std::min(mGridFrame, mGridFrameCount - 1));
     }
 
@@ -344,6 +433,7 @@ namespace Falcor
 
         FALCOR_SCRIPT_BINDING_DEPENDENCY(Animatable)
         FALCOR_SCRIPT_BINDING_DEPENDENCY(Grid)
+        FALCOR_SCRIPT_BINDING_DEPENDENCY(StreamingGridSequence)
 
         pybind11::class_<GridVolume, Animatable, ref<GridVolume>> volume(m, "GridVolume");
 
@@ -394,6 +484,22 @@ namespace Falcor
             { return self.loadGridSequence(slot, getActiveAssetResolver().resolvePath(path), gridname, keepEmpty); },
             "slot"_a, "path"_a, "gridnames"_a, "keepEmpty"_a = true
         ); // PYTHONDEPRECATED
+        volume.def("streamGridSequence",
+            [](GridVolume& self, GridVolume::GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize)
+            {
+                std::vector<std::filesystem::path> resolvedPaths;
+                for (const auto& path : paths)
+                    resolvedPaths.push_back(getActiveAssetResolver().resolvePath(path));
+                return self.streamGridSequence(slot, resolvedPaths, gridname, windowSize);
+            },
+            "slot"_a, "paths"_a, "gridname"_a, "windowSize"_a = StreamingGridSequence::kDefaultWindowSize
+        );
+        volume.def("streamGridSequence",
+            [](GridVolume& self, GridVolume::GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t windowSize)
+            { return self.streamGridSequence(slot, getActiveAssetResolver().resolvePath(path), gridname, windowSize); },
+            "slot"_a, "path"_a, "gridname"_a, "windowSize"_a = StreamingGridSequence::kDefaultWindowSize
+        );
+        volume.def("getStreamingGridSequence", &GridVolume::getStreamingGridSequence, "slot"_a);
 
         m.attr("Volume") = m.attr("GridVolume"); // PYTHONDEPRECATED
     }
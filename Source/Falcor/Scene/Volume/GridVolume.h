@@ -1,5 +1,6 @@
 #pragma once
 #include "Grid.h"
+#include "StreamingGridSequence.h"
 #include "GridVolumeData.slang"
 #include "Core/Macros.h"
 #include "Utils/Math/AABB.h"
@@ -91,6 +92,7 @@ namespace Falcor
         bool loadGrid(GridSlot slot, const std::filesystem::path& path, const std::string& gridname);
 
         /** Create a GridSequence from a list of files.
+            The files are decoded in parallel.
             \param[in] pDevice GPU device
             \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
             \param[in] gridname Name of the grid to load.
@@ -119,6 +121,33 @@ namespace Falcor
         */
         uint32_t loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty = true);
 
+        /** Stream a sequence of grids from files to a grid slot.
+            Only the current frame and a window of frames ahead of it are kept in memory, see StreamingGridSequence.
+            The grid sequence of the slot holds a single grid showing the current frame.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to decode ahead of the current frame.
+            \return Returns the length of the streamed sequence.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize = StreamingGridSequence::kDefaultWindowSize);
+
+        /** Stream a sequence of grids from a directory to a grid slot.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] path Directory containing grid files. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to decode ahead of the current frame.
+            \return Returns the length of the streamed sequence.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t windowSize = StreamingGridSequence::kDefaultWindowSize);
+
+        /** Get the streaming grid sequence for the specified slot.
+            \return The streaming grid sequence, or nullptr if the slot is not streamed.
+        */
+        const ref<StreamingGridSequence>& getStreamingGridSequence(GridSlot slot) const;
+
         /** Set the grid sequence for the specified slot.
         */
         void setGridSequence(GridSlot slot, const GridSequence& grids);
@@ -265,6 +294,7 @@ namespace Falcor
         ref<Device> mpDevice;
         std::string mName;
         std::array<GridSequence, (size_t)GridSlot::Count> mGrids;
+        std::array<ref<StreamingGridSequence>, (size_t)GridSlot::Count> mStreamingGrids;
         uint32_t mGridFrame = 0;
         uint32_t mGridFrameCount = 1;
         double mFrameRate = 30.f;
@@ -0,0 +1,259 @@
+#include "StreamingGridSequence.h"
+#include "Core/Error.h"
+#include "Utils/Logger.h"
+#include "Utils/StringUtils.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <algorithm>
+#include <sstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMaxWindowSize = 256;
+        const uint32_t kMaxDecodeThreadCount = 4;
+
+        BS::concurrency_t getDecodeThreadCount()
+        {
+            return std::clamp(std::thread::hardware_concurrency(), 1u, kMaxDecodeThreadCount);
+        }
+    }
+
+    ref<StreamingGridSequence> StreamingGridSequence::create(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize)
+    {
+        if (paths.empty()) return nullptr;
+
+        auto pGrid = Grid::createFromFile(pDevice, paths[0], gridname);
+        if (!pGrid) return nullptr;
+
+        return make_ref<StreamingGridSequence>(pDevice, paths, gridname, windowSize, pGrid, 0);
+    }
+
+    ref<StreamingGridSequence> StreamingGridSequence::create(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, ref<Grid> pGrid, uint32_t frame)
+    {
+        FALCOR_CHECK(!paths.empty(), "'paths' is empty");
+        FALCOR_CHECK(pGrid, "'pGrid' is missing");
+        FALCOR_CHECK(frame < paths.size(), "'frame' ({}) is out of range", frame);
+
+        return make_ref<StreamingGridSequence>(pDevice, paths, gridname, windowSize, pGrid, frame);
+    }
+
+    StreamingGridSequence::StreamingGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, ref<Grid> pGrid, uint32_t frame)
+        : mpDevice(pDevice)
+        , mPaths(paths)
+        , mGridname(gridname)
+        , mWindowSize(std::min(windowSize, kMaxWindowSize))
+        , mFrame(frame)
+        , mpGrid(pGrid)
+        , mDecodePool(getDecodeThreadCount())
+    {
+        updateWindow();
+    }
+
+    StreamingGridSequence::~StreamingGridSequence()
+    {
+        // Drop the frames that are not being decoded yet. The pool waits for the others when it is destroyed.
+        mDecodePool.purge();
+    }
+
+    void StreamingGridSequence::renderUI(Gui::Widgets& widget)
+    {
+        uint32_t windowSize = getWindowSize();
+        if (widget.var("Window size", windowSize, 0u, kMaxWindowSize)) setWindowSize(windowSize);
+
+        std::ostringstream oss;
+        oss << "Resident frames: " << mStats.residentFrames << std::endl
+            << "Pending frames: " << mStats.pendingFrames << std::endl
+            << "Memory: " << formatByteSize(mStats.residentBytes) << std::endl
+            << "Hits: " << mStats.hitCount << std::endl
+            << "Misses: " << mStats.missCount << std::endl
+            << "Evictions: " << mStats.evictionCount << std::endl
+            << "Stall time: " << mStats.stallTime << " ms" << std::endl;
+        widget.text(oss.str());
+    }
+
+    bool StreamingGridSequence::setFrame(uint32_t frame)
+    {
+        frame = std::min(frame, getFrameCount() - 1);
+        if (frame == mFrame || mFailedFrames.count(frame) > 0)
+        {
+            updateWindow();
+            return false;
+        }
+
+        collectPendingFrames();
+
+        ref<Grid> pGrid;
+        if (auto it = mResidentFrames.find(frame); it != mResidentFrames.end())
+        {
+            pGrid = it->second;
+            mResidentFrames.erase(it);
+            mStats.hitCount++;
+        }
+        else
+        {
+            // The frame is not decoded yet. Wait for it, decoding it on this thread if it is not in flight.
+            auto startTime = CpuTimer::getCurrentTimePoint();
+            auto pendingIt = mPendingFrames.find(frame);
+            if (pendingIt != mPendingFrames.end())
+            {
+                pGrid = getDecodedFrame(frame, pendingIt->second);
+                mPendingFrames.erase(pendingIt);
+            }
+            else
+            {
+                auto future = decodeFrame(frame, std::launch::deferred);
+                pGrid = getDecodedFrame(frame, future);
+            }
+            mStats.stallTime += CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+            mStats.missCount++;
+        }
+
+        bool changed = false;
+        if (pGrid)
+        {
+            // Show the new frame through the current grid object. The previous frame's data is released.
+            pGrid->upload();
+            mpGrid->swapData(*pGrid);
+            mFrame = frame;
+            changed = true;
+        }
+        else
+        {
+            logWarning("Failed to load frame {} of grid sequence from '{}'. Keeping frame {}.", frame, mPaths[frame], mFrame);
+            mFailedFrames.insert(frame);
+        }
+
+        updateWindow();
+        return changed;
+    }
+
+    void StreamingGridSequence::setWindowSize(uint32_t windowSize)
+    {
+        mWindowSize = std::min(windowSize, kMaxWindowSize);
+        updateWindow();
+    }
+
+    void StreamingGridSequence::waitForPendingFrames()
+    {
+        for (auto& [frame, future] : mPendingFrames) future.wait();
+        collectPendingFrames();
+        updateStats();
+    }
+
+    bool StreamingGridSequence::isInWindow(uint32_t frame) const
+    {
+        // Playback loops, so the window wraps around the end of the sequence.
+        const uint32_t frameCount = getFrameCount();
+        const uint32_t ahead = (frame + frameCount - mFrame) % frameCount;
+        return ahead <= mWindowSize;
+    }
+
+    std::future<ref<Grid>> StreamingGridSequence::decodeFrame(uint32_t frame, std::launch policy)
+    {
+        // Background decoding runs on the worker pool, so the number of threads stays bounded for large windows.
+        auto decode = [pDevice = mpDevice, path = mPaths[frame], gridname = mGridname]() { return Grid::decodeFromFile(pDevice, path, gridname); };
+        if (policy == std::launch::async) return mDecodePool.submit(decode);
+        return std::async(policy, decode);
+    }
+
+    ref<Grid> StreamingGridSequence::getDecodedFrame(uint32_t frame, std::future<ref<Grid>>& future) const
+    {
+        // Errors while decoding are handled like files without the grid, the frame is marked as failed.
+        try
+        {
+            return future.get();
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Error while decoding frame {} of grid sequence from '{}': {}", frame, mPaths[frame], e.what());
+            return nullptr;
+        }
+    }
+
+    void StreamingGridSequence::collectPendingFrames()
+    {
+        for (auto it = mPendingFrames.begin(); it != mPendingFrames.end();)
+        {
+            if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++it;
+                continue;
+            }
+
+            if (auto pGrid = getDecodedFrame(it->first, it->second))
+            {
+                mResidentFrames[it->first] = pGrid;
+            }
+            else
+            {
+                logWarning("Failed to load frame {} of grid sequence from '{}'.", it->first, mPaths[it->first]);
+                mFailedFrames.insert(it->first);
+            }
+            it = mPendingFrames.erase(it);
+        }
+    }
+
+    void StreamingGridSequence::updateWindow()
+    {
+        collectPendingFrames();
+
+        // Evict decoded frames that left the window. Frames still being decoded are evicted once they are collected.
+        for (auto it = mResidentFrames.begin(); it != mResidentFrames.end();)
+        {
+            if (isInWindow(it->first))
+            {
+                ++it;
+                continue;
+            }
+            it = mResidentFrames.erase(it);
+            mStats.evictionCount++;
+        }
+
+        // Start decoding the frames ahead of the current frame, nearest first.
+        const uint32_t frameCount = getFrameCount();
+        for (uint32_t i = 1; i <= std::min(mWindowSize, frameCount - 1); ++i)
+        {
+            const uint32_t frame = (mFrame + i) % frameCount;
+            if (mResidentFrames.count(frame) > 0 || mPendingFrames.count(frame) > 0 || mFailedFrames.count(frame) > 0) continue;
+
+            mPendingFrames[frame] = decodeFrame(frame, std::launch::async);
+        }
+
+        updateStats();
+    }
+
+    void StreamingGridSequence::updateStats()
+    {
+        mStats.residentFrames = (uint32_t)mResidentFrames.size() + 1;
+        mStats.pendingFrames = (uint32_t)mPendingFrames.size();
+        mStats.residentBytes = mpGrid->getGridHandle().size();
+        for (const auto& [frame, pGrid] : mResidentFrames) mStats.residentBytes += pGrid->getGridHandle().size();
+    }
+
+    FALCOR_SCRIPT_BINDING(StreamingGridSequence)
+    {
+        using namespace pybind11::literals;
+
+        FALCOR_SCRIPT_BINDING_DEPENDENCY(Grid)
+
+        pybind11::class_<StreamingGridSequence, ref<StreamingGridSequence>> sequence(m, "StreamingGridSequence");
+
+        pybind11::class_<StreamingGridSequence::Stats> stats(sequence, "Stats");
+        stats.def_readonly("residentFrames", &StreamingGridSequence::Stats::residentFrames);
+        stats.def_readonly("pendingFrames", &StreamingGridSequence::Stats::pendingFrames);
+        stats.def_readonly("residentBytes", &StreamingGridSequence::Stats::residentBytes);
+        stats.def_readonly("hitCount", &StreamingGridSequence::Stats::hitCount);
+        stats.def_readonly("missCount", &StreamingGridSequence::Stats::missCount);
+        stats.def_readonly("evictionCount", &StreamingGridSequence::Stats::evictionCount);
+        stats.def_readonly("stallTime", &StreamingGridSequence::Stats::stallTime);
+
+        sequence.def_property_readonly("grid", &StreamingGridSequence::getGrid);
+        sequence.def_property_readonly("frameCount", &StreamingGridSequence::getFrameCount);
+        sequence.def_property_readonly("frame", &StreamingGridSequence::getFrame);
+        sequence.def_property("windowSize", &StreamingGridSequence::getWindowSize, &StreamingGridSequence::setWindowSize);
+        sequence.def_property_readonly("stats", &StreamingGridSequence::getStats);
+        sequence.def("waitForPendingFrames", &StreamingGridSequence::waitForPendingFrames);
+    }
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "Grid.h"
+#include "Core/Macros.h"
+#include "Core/Object.h"
+#include "Utils/UI/Gui.h"
+#include <BS_thread_pool/BS_thread_pool.hpp>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Grid sequence that streams its frames from files during playback.
+
+        Only a window of frames ahead of the current frame is held in memory. These frames are decoded
+        on background threads (file loading, OpenVDB to NanoVDB conversion and brick building), while the
+        GPU resources are created when a frame is shown. Frames are released once they have been shown.
+        The current frame is always shown through the same grid object (see getGrid()), so that
+        the grid can stay bound in the scene while its data changes.
+    */
+    class FALCOR_API StreamingGridSequence : public Object
+    {
+        FALCOR_OBJECT(StreamingGridSequence)
+    public:
+        static constexpr uint32_t kDefaultWindowSize = 8;
+
+        /** Streaming statistics.
+        */
+        struct Stats
+        {
+            uint32_t residentFrames = 0;    ///< Number of decoded frames in memory, including the current frame.
+            uint32_t pendingFrames = 0;     ///< Number of frames being decoded in the background.
+            uint64_t residentBytes = 0;     ///< Host memory used by the decoded frames in bytes.
+            uint64_t hitCount = 0;          ///< Number of frame changes served by an already decoded frame.
+            uint64_t missCount = 0;         ///< Number of frame changes that had to wait for decoding.
+            uint64_t evictionCount = 0;     ///< Number of decoded frames released because they left the window.
+            double stallTime = 0.0;         ///< Total time spent waiting for frames to decode in ms.
+        };
+
+        /** Create a streaming grid sequence. The first frame is loaded before returning.
+            \param[in] pDevice GPU device.
+            \param[in] paths File paths of the grids, one per frame.
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to decode ahead of the current frame.
+            \return A new grid sequence, or nullptr if the first frame failed to load.
+        */
+        static ref<StreamingGridSequence> create(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize = kDefaultWindowSize);
+
+        /** Create a streaming grid sequence from a grid that already holds the data of a frame (e.g. loaded from the scene cache).
+            \param[in] pDevice GPU device.
+            \param[in] paths File paths of the grids, one per frame.
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to decode ahead of the current frame.
+            \param[in] pGrid Grid used to show the current frame.
+            \param[in] frame Frame held by pGrid.
+            
+eturn A new grid sequence.
+        */
+        static ref<StreamingGridSequence> create(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, ref<Grid> pGrid, uint32_t frame);
+
+        /** Destructor. Blocks until the frames being decoded are finished.
+        */
+        ~StreamingGridSequence();
+
+        /** Render the UI.
+        */
+        void renderUI(Gui::Widgets& widget);
+
+        /** Get the grid showing the current frame.
+        */
+        const ref<Grid>& getGrid() const { return mpGrid; }
+
+        /** Get the number of frames in the sequence.
+        */
+        uint32_t getFrameCount() const { return (uint32_t)mPaths.size(); }
+
+        /** Get the file paths of the grids, one per frame.
+        */
+        const std::vector<std::filesystem::path>& getPaths() const { return mPaths; }
+
+        /** Get the name of the grid loaded from each file.
+        */
+        const std::string& getGridname() const { return mGridname; }
+
+        /** Get the current frame.
+        */
+        uint32_t getFrame() const { return mFrame; }
+
+        /** Show a new frame. Blocks if the frame is not decoded yet.
+            Frames that fail to load are skipped, keeping the previous frame.
+            \param[in] frame Frame index, clamped to the sequence length.
+            \return True if the data of the grid changed.
+        */
+        bool setFrame(uint32_t frame);
+
+        /** Set the number of frames to decode ahead of the current frame.
+        */
+        void setWindowSize(uint32_t windowSize);
+
+        /** Get the number of frames to decode ahead of the current frame.
+        */
+        uint32_t getWindowSize() const { return mWindowSize; }
+
+        /** Block until all frames that are currently being decoded are finished.
+        */
+        void waitForPendingFrames();
+
+        /** Get the streaming statistics.
+        */
+        const Stats& getStats() const { return mStats; }
+
+        StreamingGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, ref<Grid> pGrid, uint32_t frame);
+
+    private:
+        bool isInWindow(uint32_t frame) const;
+        std::future<ref<Grid>> decodeFrame(uint32_t frame, std::launch policy);
+        ref<Grid> getDecodedFrame(uint32_t frame, std::future<ref<Grid>>& future) const;
+        void collectPendingFrames();
+        void updateWindow();
+        void updateStats();
+
+        ref<Device> mpDevice;
+        std::vector<std::filesystem::path> mPaths;
+        std::string mGridname;
+        uint32_t mWindowSize;
+
+        uint32_t mFrame = 0;                                    ///< Frame shown by mpGrid.
+        ref<Grid> mpGrid;                                       ///< Grid showing the current frame.
+        std::map<uint32_t, ref<Grid>> mResidentFrames;          ///< Decoded frames ahead of the current frame.
+        std::map<uint32_t, std::future<ref<Grid>>> mPendingFrames; ///< Frames being decoded in the background.
+        std::set<uint32_t> mFailedFrames;                       ///< Frames that failed to load.
+        Stats mStats;
+        BS::thread_pool mDecodePool;                            ///< Workers decoding the frames ahead of the current frame.
+    };
+}
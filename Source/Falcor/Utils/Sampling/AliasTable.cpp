@@ -1,109 +1,207 @@
 #include "AliasTable.h"
 #include "Core/Error.h"
 #include "Core/API/Device.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Math/Common.h"
+#include <algorithm>
+#include <execution>
 
 namespace Falcor
 {
-// This builds an alias table via the O(N) algorithm from Vose 1991, "A linear algorithm for generating random
-// numbers with a given distribution," IEEE Transactions on Software Engineering 17(9), 972-975.
-//
-// Basic idea:  creating each alias table entry combines one overweighted sample and one underweighted sample
-// into one alias table entry plus a residual sample (the overweighted sample minus some of its weight).
-//
-// By first separating all inputs into 2 temporary buffer (one overweighted set, with weights above the
-// average; one underweighted set, with weights below average), we can simply walk through the lists once,
-// merging the first elements in each temporary buffer.  The residual sample is interted into either the
-// overweighted or underweighted set, depending on its residual weight.
-//
-// The main complexity is dealing with corner cases, thanks to numerical precision issues, where you don't
-// have 2 valid entries to combine.  By definition, in these corner cases, all remaining unhandled samples
-// actually have the average weight (within numerical precision limits)
-AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng) : mCount((uint32_t)weights.size())
+namespace
 {
-    // Use >= since we reserve 0xFFFFFFFFu as an invalid flag marker during construction.
-    if (weights.size() >= std::numeric_limits<uint32_t>::max())
-        FALCOR_THROW("Too many entries for alias table.");
+// The weights are processed in chunks of this many elements. The chunks do not depend on the number of threads,
+// so the table is the same whether it is built in parallel or not.
+const size_t kChunkSize = 1 << 16;
 
-    std::uniform_int_distribution<uint32_t> rngDist;
+/**
+ * Calls func(chunkIndex, chunkBegin, chunkEnd) for each chunk of kChunkSize elements in [0, count).
+ * @param[in] parallel Process the chunks on multiple threads.
+ */
+template<typename Func>
+void forEachChunk(bool parallel, size_t count, const Func& func)
+{
+    auto processChunk = [&](size_t chunkIndex)
+    {
+        const size_t chunkBegin = chunkIndex * kChunkSize;
+        func(chunkIndex, chunkBegin, std::min(chunkBegin + kChunkSize, count));
+    };
+    auto range = NumericRange<size_t>(0, div_round_up(count, kChunkSize));
+    if (parallel)
+        std::for_each(std::execution::par, range.begin(), range.end(), processChunk);
+    else
+        std::for_each(range.begin(), range.end(), processChunk);
+}
 
-    mpWeights =
-        pDevice->createStructuredBuffer(sizeof(float), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, weights.data());
+/**
+ * Computes the exclusive prefix sums of non-negative values.
+ * Each sum is computed as the offset of its chunk plus the sum within the chunk, which keeps the sums monotonic.
+ * @param[in] parallel Process the chunks on multiple threads.
+ * @param[in] count Number of values.
+ * @param[in] getValue Function returning the value at a given index.
+ * @param[out] sums The prefix sums (count + 1 elements). The last element is the total sum.
+ */
+template<typename T, typename Func>
+void computePrefixSums(bool parallel, size_t count, const Func& getValue, std::vector<T>& sums)
+{
+    std::vector<T> chunkOffsets(div_round_up(count, kChunkSize) + 1, T(0));
+    forEachChunk(
+        parallel,
+        count,
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
+        {
+            T sum = T(0);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                sum += getValue(i);
+            chunkOffsets[chunkIndex + 1] = sum;
+        }
+    );
+    for (size_t i = 1; i < chunkOffsets.size(); ++i)
+        chunkOffsets[i] = chunkOffsets[i - 1] + chunkOffsets[i];
 
-    // Our working set / intermediate buffers (underweight & overweight); initialize to "invalid"
-    std::vector<uint32_t> lowIdx(mCount, 0xFFFFFFFFu);
-    std::vector<uint32_t> highIdx(mCount, 0xFFFFFFFFu);
+    sums.resize(count + 1);
+    forEachChunk(
+        parallel,
+        count,
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
+        {
+            T sum = T(0);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                sums[i] = chunkOffsets[chunkIndex] + sum;
+                sum += getValue(i);
+            }
+        }
+    );
+    sums[count] = chunkOffsets.back();
+}
 
-    // Sum element weights, use double to minimize precision issues
-    mWeightSum = 0.0;
-    for (float f : weights)
-        mWeightSum += f;
+// This builds an alias table with a parallel variant of the sweeping alias method, as described in
+// Hübschle-Schneider and Sanders 2019, "Parallel Weighted Random Sampling", ESA 2019.
+//
+// The weights are normalized to an average of 1 and split into light (below average) and heavy items.
+// The sequential sweep packs the lights in order with the current heavy, which gives away part of its weight
+// to each of them. Once the heavy item is itself light, it is packed with the next heavy item.
+//
+// Let deficit(i) be the sum of (1 - w) over the lights before light i and excess(j) the sum of (w - 1)
+// over the heavies before heavy j. In the sweep, light i is packed with heavy j such that
+// excess(j) < deficit(i) <= excess(j + 1), and heavy j is left with the weight 1 + excess(j + 1) - deficit(k),
+// where k is the first light not packed with heavies up to j. Both can be found with a binary search,
+// so each chunk of items is processed independently after computing the prefix sums.
+//
+// As in the sequential algorithm, numerical errors are handled by giving the remaining items
+// (which all have the average weight within precision limits) a threshold of 1.
+template<typename T>
+void buildItemsWithPrecision(const std::vector<float>& weights, double weightSum, bool parallel, std::vector<AliasTable::Item>& items)
+{
+    const size_t count = weights.size();
 
-    // Find the average weight
-    float avgWeight = float(mWeightSum / double(mCount));
+    // Normalize the weights to an average of 1. If all weights are zero, sample uniformly.
+    const T scale = T(weightSum > 0.0 ? double(count) / weightSum : 0.0);
+    auto getWeight = [&](size_t i) { return weightSum > 0.0 ? T(weights[i]) * scale : T(1); };
 
-    // Initialize working set. Inset inputs into our lists of above-average or below-average weight elements.
-    int lowCount = 0;
-    int highCount = 0;
-    for (uint32_t i = 0; i < mCount; ++i)
-    {
-        if (weights[i] < avgWeight)
-            lowIdx[lowCount++] = i;
-        else
-            highIdx[highCount++] = i;
-    }
-
-    // Create alias table entries by merging above- and below-average samples
-    std::vector<AliasTable::Item> items(mCount);
-    for (uint32_t i = 0; i < mCount; ++i)
-    {
-        // Usual case:  We have an above-average and below-average sample we can combine into one alias table entry
-        if ((lowIdx[i] != 0xFFFFFFFFu) && (highIdx[i] != 0xFFFFFFFFu))
+    // Split the items into lights and heavies, keeping their order.
+    std::vector<uint32_t> chunkLightOffsets(div_round_up(count, kChunkSize) + 1, 0);
+    forEachChunk(
+        parallel,
+        count,
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
         {
-            // Create an alias table tuple:
-            items[i] = {weights[lowIdx[i]] / avgWeight, highIdx[i], lowIdx[i], 0};
-
-            // We've removed some weight from element highIdx[i]; update it's weight, then re-enter it
-            // on the end of either the above-average or below-average lists.
-            float updatedWeight = (weights[lowIdx[i]] + weights[highIdx[i]]) - avgWeight;
-            weights[highIdx[i]] = updatedWeight;
-            if (updatedWeight < avgWeight)
-                lowIdx[lowCount++] = highIdx[i];
-            else
-                highIdx[highCount++] = highIdx[i];
+            uint32_t lightCount = 0;
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                lightCount += getWeight(i) < T(1) ? 1 : 0;
+            chunkLightOffsets[chunkIndex + 1] = lightCount;
         }
+    );
+    for (size_t i = 1; i < chunkLightOffsets.size(); ++i)
+        chunkLightOffsets[i] += chunkLightOffsets[i - 1];
 
-        // The next two cases can only occur towards the end of table creation, because either:
-        //    (a) all the remaining possible alias table entries have weight *exactly* equal to avgWeight,
-        //        which means these alias table entries only have one input item that is selected
-        //        with 100% probability
-        //    (b) all the remaining alias table entires have *almost* avgWeight, but due to (compounding)
-        //        precision issues throughout the process, they don't have *quite* that value.  In this case
-        //        treating these entries as having exactly avgWeight (as in case (a)) is the only right
-        //        thing to do mathematically (other than re-generating the alias table using higher precision
-        //        or trying to reduce catasrophic numerical cancellation in the "updatedWeight" computation above).
-        else if (highIdx[i] != 0xFFFFFFFFu)
+    const size_t lightCount = chunkLightOffsets.back();
+    const size_t heavyCount = count - lightCount;
+    std::vector<uint32_t> lights(lightCount);
+    std::vector<uint32_t> heavies(heavyCount);
+    forEachChunk(
+        parallel,
+        count,
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
         {
-            items[i] = {1.0f, highIdx[i], highIdx[i], 0};
+            size_t lightIdx = chunkLightOffsets[chunkIndex];
+            size_t heavyIdx = chunkBegin - chunkLightOffsets[chunkIndex];
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                if (getWeight(i) < T(1))
+                    lights[lightIdx++] = (uint32_t)i;
+                else
+                    heavies[heavyIdx++] = (uint32_t)i;
+            }
         }
-        else if (lowIdx[i] != 0xFFFFFFFFu)
+    );
+
+    // Compute the weight missing from the lights and in excess in the heavies.
+    std::vector<T> deficits;
+    std::vector<T> excesses;
+    computePrefixSums(parallel, lightCount, [&](size_t i) { return T(1) - getWeight(lights[i]); }, deficits);
+    computePrefixSums(parallel, heavyCount, [&](size_t i) { return getWeight(heavies[i]) - T(1); }, excesses);
+
+    items.resize(count);
+
+    // Pack each light with the heavy that is current when the sweep reaches it.
+    forEachChunk(
+        parallel,
+        lightCount,
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
         {
-            items[i] = {1.0f, lowIdx[i], lowIdx[i], 0};
+            size_t heavyIdx = std::lower_bound(excesses.begin() + 1, excesses.end(), deficits[chunkBegin]) - (excesses.begin() + 1);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                while (heavyIdx < heavyCount && excesses[heavyIdx + 1] < deficits[i])
+                    heavyIdx++;
+
+                const uint32_t itemIdx = lights[i];
+                if (heavyIdx < heavyCount)
+                    items[itemIdx] = {(float)getWeight(itemIdx), heavies[heavyIdx], itemIdx, 0};
+                else
+                    items[itemIdx] = {1.0f, itemIdx, itemIdx, 0};
+            }
         }
+    );
 
-        // If there is neither a highIdx[i] or lowIdx[i] for some array element(s).  By construction,
-        // this cannot occur (without some logic bug above).
-        else
+    // Pack each heavy with the next one, using the weight it has left after the lights packed with it.
+    forEachChunk(
+        parallel,
+        heavyCount,
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
         {
-            FALCOR_ASSERT(false); // Should not occur
+            size_t lightIdx = std::upper_bound(deficits.begin(), deficits.begin() + lightCount, excesses[chunkBegin + 1]) - deficits.begin();
+            for (size_t j = chunkBegin; j < chunkEnd; ++j)
+            {
+                while (lightIdx < lightCount && deficits[lightIdx] <= excesses[j + 1])
+                    lightIdx++;
+
+                const uint32_t itemIdx = heavies[j];
+                if (j + 1 < heavyCount)
+                {
+                    const T residual = T(1) + excesses[j + 1] - deficits[lightIdx];
+                    items[itemIdx] = {(float)std::clamp(residual, T(0), T(1)), heavies[j + 1], itemIdx, 0};
+                }
+                else
+                {
+                    items[itemIdx] = {1.0f, itemIdx, itemIdx, 0};
+                }
+            }
         }
-    }
+    );
+}
+} // namespace
+
+AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng, const Options& options)
+    : mCount((uint32_t)weights.size())
+{
+    std::vector<AliasTable::Item> items;
+    mWeightSum = buildItems(weights, options, items);
 
-    // TODO: We can simplify the alias table to implicitly store indexB (aka lowIdx[i]), so the AliasTable::Item
-    // structure would be 1 float + 1 uint32_t, rather than 128 bits.  This, of course, would change usage in shaders
-    // and elsewhere.  To do this, here you'd need to sort elements by indexB so that when looking up mpItems[j],
-    // indexB==j.  This works since, by construction, only one element in the table has indexB==j (for any j
-    // in [0...mCount-1]).  Alternatively, during the loop above, you could directly enter elements into the
-    // correct location in the alias table.
+    mpWeights =
+        pDevice->createStructuredBuffer(sizeof(float), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, weights.data());
 
     // Stash the alias table in our GPU buffer
     mpItems = pDevice->createStructuredBuffer(
@@ -111,6 +209,37 @@ AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt1
     );
 }
 
+double AliasTable::buildItems(const std::vector<float>& weights, const Options& options, std::vector<Item>& items)
+{
+    // Item indices are stored as 32-bit integers.
+    if (weights.size() >= std::numeric_limits<uint32_t>::max())
+        FALCOR_THROW("Too many entries for alias table.");
+
+    // Sum element weights, use double to minimize precision issues
+    std::vector<double> chunkSums(div_round_up(weights.size(), kChunkSize), 0.0);
+    forEachChunk(
+        options.useParallelBuild,
+        weights.size(),
+        [&](size_t chunkIndex, size_t chunkBegin, size_t chunkEnd)
+        {
+            double sum = 0.0;
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                sum += weights[i];
+            chunkSums[chunkIndex] = sum;
+        }
+    );
+    double weightSum = 0.0;
+    for (double sum : chunkSums)
+        weightSum += sum;
+
+    if (options.useDoublePrecision)
+        buildItemsWithPrecision<double>(weights, weightSum, options.useParallelBuild, items);
+    else
+        buildItemsWithPrecision<float>(weights, weightSum, options.useParallelBuild, items);
+
+    return weightSum;
+}
+
 void AliasTable::bindShaderData(const ShaderVar& var) const
 {
     var["items"] = mpItems;
@@ -4,6 +4,7 @@
 #include "Core/Program/ShaderVar.h"
 #include <memory>
 #include <random>
+#include <vector>
 
 namespace Falcor
 {
@@ -13,14 +14,49 @@ namespace Falcor
 class FALCOR_API AliasTable
 {
 public:
+    /**
+     * Alias table construction options.
+     */
+    struct Options
+    {
+        /// Build the table on multiple threads. The resulting table does not depend on this setting or on the number of threads.
+        bool useParallelBuild = true;
+        /// Normalize the weights and accumulate the redistributed weight in double precision.
+        /// Single precision uses less memory, but its error grows with the number of weights.
+        bool useDoublePrecision = true;
+
+        // Note: Empty constructor needed for clang due to the use of the nested struct constructor in the parent constructor.
+        Options() {}
+    };
+
+    // Item structure for the mpItems buffer.
+    struct Item
+    {
+        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
+        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
+        uint32_t indexB; ///< The original / permutation index, sampled uniformly in [0...mCount-1]
+        uint32_t _pad;
+    };
+
     /**
      * Create an alias table.
      * The weights don't need to be normalized to sum up to 1.
      * @param[in] pDevice GPU device.
      * @param[in] weights The weights we'd like to sample each entry proportional to.
      * @param[in] rng The random number generator to use when creating the table.
+     * @param[in] options The options to use when creating the table.
      */
-    AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng);
+    AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng, const Options& options = Options());
+
+    /**
+     * Build the alias table items on the CPU, without creating any GPU resources.
+     * Item i is sampled with probability threshold and redirects to its alias otherwise (indexB == i).
+     * @param[in] weights The weights we'd like to sample each entry proportional to.
+     * @param[in] options The options to use when creating the table.
+     * @param[out] items The alias table items.
+     * @return The total sum of all weights.
+     */
+    static double buildItems(const std::vector<float>& weights, const Options& options, std::vector<Item>& items);
 
     /**
      * Bind the alias table data to a given shader var.
@@ -39,15 +75,6 @@ public:
     double getWeightSum() const { return mWeightSum; }
 
 private:
-    // Item structure for the mpItems buffer.
-    struct Item
-    {
-        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
-        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
-        uint32_t indexB; ///< The original / permutation index, sampled uniformly in [0...mCount-1]
-        uint32_t _pad;
-    };
-
     uint32_t mCount;       ///< Number of items in the alias table.
     double mWeightSum;     ///< Total weight of all elements used to create the alias table.
     ref<Buffer> mpItems;   ///< Buffer containing table items.
@@ -1,16 +1,22 @@
 #include "Niagara.h"
 #include "NiagaraConfig.h"
+#include "NiagaraSceneCache.h"
 #include "Utils/CrashHandler.h"
 #include "Scene/SceneBuilder.h"
+#include "Scene/SceneCache.h"
 #include "Core/API/Buffer.h"
 #include "Core/API/Device.h"
 #include "Core/API/Texture.h"
 #include "Utils/Math/Matrix.h"
+#include "Utils/Timing/CpuTimer.h"
 
 FALCOR_EXPORT_D3D12_AGILITY_SDK
 
 static const char kMeshShaderFile[] = "Niagara/shaders/NiagaraMeshlet.ms.slang";
 static const uint32_t kMaxTextures = 64;
+static const bool kFastMeshlets = false;
+static const bool kClrtMeshlets = false;
+static const std::string kSceneCacheExtension = ".niagara";
 
 static const std::vector<std::string> kScenePaths = {
     "test_scenes/bunny.pyscene",
@@ -37,10 +43,29 @@ Niagara::~Niagara() = default;
 
 void Niagara::loadScene(RenderContext* pRenderContext, const std::filesystem::path& path, SceneBuilder::Flags buildFlags)
 {
+    // The converted scene is cached next to the Falcor scene cache and shares its key and lifetime.
+    // On a hit, neither the Falcor scene nor the conversion is needed.
+    const bool useCache = is_set(buildFlags, SceneBuilder::Flags::UseCache) && !is_set(buildFlags, SceneBuilder::Flags::RebuildCache);
+    if (useCache)
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        auto cacheKey = SceneBuilder::computeSceneCacheKey(path, buildFlags);
+        if (cacheKey && SceneCache::hasValidCache(*cacheKey) &&
+            loadNiagaraSceneCache(SceneCache::getSidecarCachePath(*cacheKey, kSceneCacheExtension), mpNiagaraScene, kFastMeshlets, kClrtMeshlets))
+        {
+            logInfo("Niagara: Loaded scene cache in {:.2f} ms.", CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()));
+            uploadSceneBuffers(pRenderContext);
+            return;
+        }
+    }
+
     ref<Scene> pScene = SceneBuilder(getDevice(), path, getSettings(), buildFlags).getScene();
     if (pScene)
     {
-        convertFalcorSceneToNiagaraScene(pScene.get(), mpNiagaraScene, true, false, false);
+        mpNiagaraScene = {};
+        convertFalcorSceneToNiagaraScene(pScene.get(), mpNiagaraScene, true, kFastMeshlets, kClrtMeshlets);
+        if (const auto& cacheKey = pScene->getSceneCacheKey())
+            saveNiagaraSceneCache(SceneCache::getSidecarCachePath(*cacheKey, kSceneCacheExtension), mpNiagaraScene, kFastMeshlets, kClrtMeshlets);
         uploadSceneBuffers(pRenderContext);
     }
 }
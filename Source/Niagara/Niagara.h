@@ -22,7 +22,7 @@ public:
     void onHotReload(HotReloadFlags reloaded) override;
 
 private:
-    void loadScene(RenderContext* pRenderContext, const std::filesystem::path& path, SceneBuilder::Flags buildFlags = SceneBuilder::Flags::Default);
+    void loadScene(RenderContext* pRenderContext, const std::filesystem::path& path, SceneBuilder::Flags buildFlags = SceneBuilder::Flags::UseCache);
     void uploadSceneBuffers(RenderContext* pRenderContext);
 
     Falcor::NiagaraScene mpNiagaraScene;
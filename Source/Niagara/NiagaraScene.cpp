@@ -8,12 +8,17 @@
 #include "Core/API/Buffer.h"
 #include "Core/API/Device.h"
 #include "Utils/Math/Matrix.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Timing/CpuTimer.h"
 
 #include <meshoptimizer.h>
 
 #include <algorithm>
 #include <cstring>
+#include <execution>
+#include <limits>
 #include <map>
+#include <numeric>
 
 namespace Falcor
 {
@@ -174,6 +179,156 @@ size_t buildMeshlets(NiagaraGeometry& geometry,
     return appendMeshlets(geometry, positions, indices, baseVertex, lod0, fast, clrt);
 }
 
+/** Mesh data read back from the Falcor scene.
+ */
+struct NiagaraMeshInput
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3> positions;
+};
+
+/** Quantize and deduplicate the vertices of a mesh and append the mesh to the geometry.
+ *  All offsets stored in the mesh and its meshlets are relative to the given geometry.
+ */
+static void appendMesh(NiagaraGeometry& result, NiagaraMeshInput& input, bool doBuildMeshlets, bool fast, bool clrt)
+{
+    auto& indices = input.indices;
+    auto& positions = input.positions;
+    const size_t vertexCount = positions.size();
+
+    std::vector<NiagaraVertex> vertices(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        vertices[i].vx = meshopt_quantizeHalf(positions[i].x);
+        vertices[i].vy = meshopt_quantizeHalf(positions[i].y);
+        vertices[i].vz = meshopt_quantizeHalf(positions[i].z);
+        vertices[i].tp = 0;
+        vertices[i].np = (511) | (511) << 10 | (511) << 20;
+        vertices[i].tu = 0;
+        vertices[i].tv = 0;
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    size_t uniqueVertices = meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(),
+        vertices.data(), vertexCount, sizeof(NiagaraVertex));
+
+    meshopt_remapVertexBuffer(vertices.data(), vertices.data(), vertexCount, sizeof(NiagaraVertex), remap.data());
+    meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+    vertices.resize(uniqueVertices);
+
+    std::vector<float3> remappedPositions(uniqueVertices);
+    for (size_t i = 0; i < vertexCount; ++i)
+        remappedPositions[remap[i]] = positions[i];
+    positions = std::move(remappedPositions);
+
+    uint32_t vertexOffset = (uint32_t)result.vertices.size();
+    result.vertices.insert(result.vertices.end(), vertices.begin(), vertices.end());
+
+    NiagaraMesh mesh = {};
+    mesh.vertexOffset = vertexOffset;
+    mesh.vertexCount = (uint32_t)vertices.size();
+    mesh.center = float3(0.f);
+    for (const auto& p : positions)
+        mesh.center += p;
+    mesh.center /= (float)positions.size();
+    mesh.radius = 0.f;
+    for (const auto& p : positions)
+        mesh.radius = std::max(mesh.radius, Falcor::math::length(p - mesh.center));
+
+    NiagaraMeshLod& lod = mesh.lods[mesh.lodCount++];
+    lod.indexOffset = (uint32_t)result.indices.size();
+    lod.indexCount = (uint32_t)indices.size();
+    result.indices.insert(result.indices.end(), indices.begin(), indices.end());
+
+    lod.meshletOffset = (uint32_t)result.meshlets.size();
+    if (doBuildMeshlets)
+    {
+        lod.meshletCount = (uint32_t)buildMeshlets(result, positions, indices, vertexOffset, true, fast, clrt);
+    }
+    else
+    {
+        lod.meshletCount = 0;
+    }
+    lod.error = 0.f;
+
+    result.meshes.push_back(mesh);
+}
+
+/** Append a list of geometries to the result.
+ *  The output offsets of each part are computed up front, so the parts are copied and rebased in parallel.
+ */
+static void appendGeometry(NiagaraGeometry& result, const std::vector<NiagaraGeometry>& parts)
+{
+    const size_t partCount = parts.size();
+    std::vector<size_t> vertexOffset(partCount + 1, 0);
+    std::vector<size_t> indexOffset(partCount + 1, 0);
+    std::vector<size_t> meshletOffset(partCount + 1, 0);
+    std::vector<size_t> meshletdataOffset(partCount + 1, 0);
+    std::vector<size_t> meshletvtx0Offset(partCount + 1, 0);
+    std::vector<size_t> meshOffset(partCount + 1, 0);
+    for (size_t i = 0; i < partCount; ++i)
+    {
+        vertexOffset[i] = parts[i].vertices.size();
+        indexOffset[i] = parts[i].indices.size();
+        meshletOffset[i] = parts[i].meshlets.size();
+        meshletdataOffset[i] = parts[i].meshletdata.size();
+        meshletvtx0Offset[i] = parts[i].meshletvtx0.size();
+        meshOffset[i] = parts[i].meshes.size();
+    }
+    auto scan = [&](std::vector<size_t>& offsets, size_t base)
+    { std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), base); };
+    scan(vertexOffset, result.vertices.size());
+    scan(indexOffset, result.indices.size());
+    scan(meshletOffset, result.meshlets.size());
+    scan(meshletdataOffset, result.meshletdata.size());
+    scan(meshletvtx0Offset, result.meshletvtx0.size());
+    scan(meshOffset, result.meshes.size());
+
+    FALCOR_CHECK(meshletdataOffset.back() <= std::numeric_limits<uint32_t>::max(), "Niagara meshlet data exceeds 4G entries.");
+
+    result.vertices.resize(vertexOffset.back());
+    result.indices.resize(indexOffset.back());
+    result.meshlets.resize(meshletOffset.back());
+    result.meshletdata.resize(meshletdataOffset.back());
+    result.meshletvtx0.resize(meshletvtx0Offset.back());
+    result.meshes.resize(meshOffset.back());
+
+    auto partRange = NumericRange<size_t>(0, partCount);
+    std::for_each(
+        std::execution::par,
+        partRange.begin(),
+        partRange.end(),
+        [&](size_t i)
+        {
+            const NiagaraGeometry& part = parts[i];
+            std::copy(part.vertices.begin(), part.vertices.end(), result.vertices.begin() + vertexOffset[i]);
+            std::copy(part.indices.begin(), part.indices.end(), result.indices.begin() + indexOffset[i]);
+            std::copy(part.meshletdata.begin(), part.meshletdata.end(), result.meshletdata.begin() + meshletdataOffset[i]);
+            std::copy(part.meshletvtx0.begin(), part.meshletvtx0.end(), result.meshletvtx0.begin() + meshletvtx0Offset[i]);
+
+            for (size_t j = 0; j < part.meshlets.size(); ++j)
+            {
+                NiagaraMeshlet m = part.meshlets[j];
+                m.dataOffset += (uint32_t)meshletdataOffset[i];
+                m.baseVertex += (uint32_t)vertexOffset[i];
+                result.meshlets[meshletOffset[i] + j] = m;
+            }
+
+            for (size_t j = 0; j < part.meshes.size(); ++j)
+            {
+                NiagaraMesh mesh = part.meshes[j];
+                mesh.vertexOffset += (uint32_t)vertexOffset[i];
+                for (uint32_t l = 0; l < mesh.lodCount; ++l)
+                {
+                    mesh.lods[l].indexOffset += (uint32_t)indexOffset[i];
+                    mesh.lods[l].meshletOffset += (uint32_t)meshletOffset[i];
+                }
+                result.meshes[meshOffset[i] + j] = mesh;
+            }
+        }
+    );
+}
+
 bool convertFalcorSceneToNiagaraScene(Scene* pScene,
     NiagaraScene& outScene,
     bool doBuildMeshletsParam,
@@ -243,6 +398,9 @@ bool convertFalcorSceneToNiagaraScene(Scene* pScene,
         materials.push_back(mat);
     }
 
+    // Read back the mesh data serially, the GPU readback can't be issued from worker threads.
+    auto startTime = CpuTimer::getCurrentTimePoint();
+    std::vector<NiagaraMeshInput> meshInputs;
     for (MeshID meshID{0}; meshID.get() < pScene->getMeshCount(); ++meshID)
     {
         const auto& meshDesc = pScene->getMesh(meshID);
@@ -267,77 +425,48 @@ bool convertFalcorSceneToNiagaraScene(Scene* pScene,
 
         pScene->getMeshVerticesAndIndices(meshID, buffers);
 
-        std::vector<uint3> triIndices(triangleCount);
-        std::vector<float3> positions(vertexCount);
-        buffers["triangleIndices"]->getBlob(triIndices.data(), 0, triangleCount * sizeof(uint3));
-        buffers["positions"]->getBlob(positions.data(), 0, vertexCount * sizeof(float3));
-
-        std::vector<uint32_t> indices(triangleCount * 3);
-        for (uint32_t i = 0; i < triangleCount; ++i)
-        {
-            indices[i * 3 + 0] = triIndices[i].x;
-            indices[i * 3 + 1] = triIndices[i].y;
-            indices[i * 3 + 2] = triIndices[i].z;
-        }
-
-        std::vector<NiagaraVertex> vertices(vertexCount);
-        for (uint32_t i = 0; i < vertexCount; ++i)
-        {
-            vertices[i].vx = meshopt_quantizeHalf(positions[i].x);
-            vertices[i].vy = meshopt_quantizeHalf(positions[i].y);
-            vertices[i].vz = meshopt_quantizeHalf(positions[i].z);
-            vertices[i].tp = 0;
-            vertices[i].np = (511) | (511) << 10 | (511) << 20;
-            vertices[i].tu = 0;
-            vertices[i].tv = 0;
-        }
-
-        std::vector<uint32_t> remap(vertexCount);
-        size_t uniqueVertices = meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(),
-            vertices.data(), vertexCount, sizeof(NiagaraVertex));
-
-        meshopt_remapVertexBuffer(vertices.data(), vertices.data(), vertexCount, sizeof(NiagaraVertex), remap.data());
-        meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
-        vertices.resize(uniqueVertices);
-
-        std::vector<float3> remappedPositions(uniqueVertices);
-        for (size_t i = 0; i < vertexCount; ++i)
-            remappedPositions[remap[i]] = positions[i];
-        positions = std::move(remappedPositions);
-
-        uint32_t vertexOffset = (uint32_t)geometry.vertices.size();
-        geometry.vertices.insert(geometry.vertices.end(), vertices.begin(), vertices.end());
-
-        NiagaraMesh mesh = {};
-        mesh.vertexOffset = vertexOffset;
-        mesh.vertexCount = (uint32_t)vertices.size();
-        mesh.center = float3(0.f);
-        for (const auto& p : positions)
-            mesh.center += p;
-        mesh.center /= (float)positions.size();
-        mesh.radius = 0.f;
-        for (const auto& p : positions)
-            mesh.radius = std::max(mesh.radius, Falcor::math::length(p - mesh.center));
-
-        NiagaraMeshLod& lod = mesh.lods[mesh.lodCount++];
-        lod.indexOffset = (uint32_t)geometry.indices.size();
-        lod.indexCount = (uint32_t)indices.size();
-        geometry.indices.insert(geometry.indices.end(), indices.begin(), indices.end());
-
-        lod.meshletOffset = (uint32_t)geometry.meshlets.size();
-        if (doBuildMeshletsParam)
-        {
-            lod.meshletCount = (uint32_t)buildMeshlets(geometry, positions, indices, vertexOffset, true, fast, clrt);
-        }
-        else
+        NiagaraMeshInput& input = meshInputs.emplace_back();
+        input.indices.resize(triangleCount * 3);
+        input.positions.resize(vertexCount);
+        buffers["triangleIndices"]->getBlob(input.indices.data(), 0, triangleCount * sizeof(uint3));
+        buffers["positions"]->getBlob(input.positions.data(), 0, vertexCount * sizeof(float3));
+    }
+    double readbackTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+    // Build the meshes in parallel. Each mesh is built into its own geometry with local offsets.
+    startTime = CpuTimer::getCurrentTimePoint();
+    const uint32_t meshCount = (uint32_t)meshInputs.size();
+    std::vector<NiagaraGeometry> meshGeometry(meshCount);
+    std::vector<std::exception_ptr> exceptions(meshCount);
+    auto meshRange = NumericRange<uint32_t>(0, meshCount);
+    std::for_each(
+        std::execution::par,
+        meshRange.begin(),
+        meshRange.end(),
+        [&](uint32_t i)
         {
-            lod.meshletCount = 0;
+            try
+            {
+                appendMesh(meshGeometry[i], meshInputs[i], doBuildMeshletsParam, fast, clrt);
+                meshInputs[i] = {};
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
         }
-        lod.error = 0.f;
-
-        geometry.meshes.push_back(mesh);
+    );
+    for (const auto& e : exceptions)
+    {
+        if (e)
+            std::rethrow_exception(e);
     }
 
+    // Concatenate the meshes in mesh order, so the output doesn't depend on scheduling.
+    appendGeometry(geometry, meshGeometry);
+    logInfo("Niagara: Converted {} meshes ({} meshlets) in {:.2f} ms (readback {:.2f} ms).",
+        meshCount, geometry.meshlets.size(), CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()), readbackTime);
+
     // Convert draws from geometry instances
     const auto& globalMatrices = pScene->getAnimationController()->getGlobalMatrices();
     for (uint32_t instanceID = 0; instanceID < pScene->getGeometryInstanceCount(); ++instanceID)
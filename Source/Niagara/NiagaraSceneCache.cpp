@@ -0,0 +1,416 @@
+#include "NiagaraSceneCache.h"
+#include "NiagaraConfig.h"
+
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
+
+#include <meshoptimizer.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <execution>
+#include <fstream>
+#include <thread>
+
+namespace Falcor
+{
+
+namespace
+{
+/** The cache uses the chunk layout of the vendored niagara/scenecache.cpp, but stores the Falcor-side scene types
+ *  (NiagaraVertex, NiagaraMeshlet, ...) and a different header. It has its own magic, so that neither loader accepts
+ *  the other's files.
+ */
+const uint32_t kSceneCacheMagic = 0x43534E46; // 'FNSC'
+
+/** Specifies the current cache file version.
+ *  This needs to be incremented every time the file format or the scene conversion changes!
+ */
+const uint32_t kSceneCacheVersion = 1;
+
+// Geometry streams are split into chunks that are encoded and decoded independently.
+const uint32_t kChunkVertices = 1 << 16;
+const uint32_t kChunkIndices = 3 << 16;
+const uint32_t kChunkMeshlets = 1 << 12;
+
+enum SceneStream : uint32_t
+{
+    SceneStream_Vertices,
+    SceneStream_Indices,
+    SceneStream_MeshletData,
+    SceneStream_MeshletVtx0,
+
+    SceneStream_Count
+};
+
+struct SceneHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t meshletMaxVertices;
+    uint32_t meshletMaxTriangles;
+
+    uint32_t fastMode;
+    uint32_t clrtMode;
+
+    uint32_t compressedBytes[SceneStream_Count];
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t meshletCount;
+    uint32_t meshletdataCount;
+    uint32_t meshletvtx0Count;
+    uint32_t meshCount;
+
+    uint32_t materialCount;
+    uint32_t drawCount;
+    uint32_t texturePathCount;
+
+    uint32_t chunkCount;
+
+    NiagaraCamera camera;
+    float3 sunDirection;
+};
+
+struct SceneChunk
+{
+    uint32_t stream;
+    uint32_t first; ///< First vertex, index or meshlet of the chunk.
+    uint32_t count;
+    uint32_t size;   ///< Size of the chunk data in the file.
+    uint64_t offset; ///< Offset of the chunk data in the file.
+};
+
+void splitChunks(std::vector<SceneChunk>& chunks, uint32_t stream, size_t count, size_t chunkSize)
+{
+    for (size_t first = 0; first < count; first += chunkSize)
+    {
+        SceneChunk chunk = {};
+        chunk.stream = stream;
+        chunk.first = (uint32_t)first;
+        chunk.count = (uint32_t)std::min(count - first, chunkSize);
+        chunks.push_back(chunk);
+    }
+}
+
+size_t getMeshletDataWords(const NiagaraMeshlet& meshlet)
+{
+    size_t vertexWords = meshlet.shortRefs ? (meshlet.vertexCount + 1) / 2 : meshlet.vertexCount;
+    return vertexWords + (meshlet.triangleCount * 3 + 3) / 4;
+}
+
+void encodeVertices(std::vector<uint8_t>& buf, const void* vertices, size_t stride, size_t count)
+{
+    buf.resize(meshopt_encodeVertexBufferBound(count, stride));
+    buf.resize(meshopt_encodeVertexBufferLevel(buf.data(), buf.size(), vertices, count, stride, 2));
+}
+
+void encodeIndices(std::vector<uint8_t>& buf, const uint32_t* indices, size_t count)
+{
+    buf.resize(meshopt_encodeIndexBufferBound(count, ~0u));
+    buf.resize(meshopt_encodeIndexBuffer(buf.data(), buf.size(), indices, count));
+}
+
+void encodeMeshletData(std::vector<uint8_t>& buf, const NiagaraMeshlet* meshlets, size_t count, const std::vector<uint32_t>& meshletdata)
+{
+    std::vector<uint8_t> encoded(meshopt_encodeMeshletBound(MESH_MAXVTX, MESH_MAXTRI));
+    std::vector<uint32_t> refs(MESH_MAXVTX);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const NiagaraMeshlet& meshlet = meshlets[i];
+        const uint32_t* data = meshletdata.data() + meshlet.dataOffset;
+        size_t vertexWords = meshlet.shortRefs ? (meshlet.vertexCount + 1) / 2 : meshlet.vertexCount;
+
+        const uint32_t* vertices = data;
+        if (meshlet.shortRefs)
+        {
+            const uint16_t* refs16 = reinterpret_cast<const uint16_t*>(data);
+            for (uint32_t j = 0; j < meshlet.vertexCount; ++j)
+                refs[j] = refs16[j];
+            vertices = refs.data();
+        }
+
+        const uint8_t* triangles = reinterpret_cast<const uint8_t*>(data + vertexWords);
+        size_t encodedSize = meshopt_encodeMeshlet(encoded.data(), encoded.size(), vertices, meshlet.vertexCount, triangles, meshlet.triangleCount);
+        uint16_t encodedSize16 = (uint16_t)encodedSize;
+
+        buf.insert(buf.end(), reinterpret_cast<const uint8_t*>(&encodedSize16), reinterpret_cast<const uint8_t*>(&encodedSize16 + 1));
+        buf.insert(buf.end(), encoded.begin(), encoded.begin() + encodedSize);
+    }
+}
+
+void encodeChunk(std::vector<uint8_t>& buf, const SceneChunk& chunk, const NiagaraGeometry& geometry)
+{
+    switch (chunk.stream)
+    {
+    case SceneStream_Vertices:
+        encodeVertices(buf, &geometry.vertices[chunk.first], sizeof(NiagaraVertex), chunk.count);
+        break;
+    case SceneStream_Indices:
+        encodeIndices(buf, &geometry.indices[chunk.first], chunk.count);
+        break;
+    case SceneStream_MeshletData:
+        encodeMeshletData(buf, &geometry.meshlets[chunk.first], chunk.count, geometry.meshletdata);
+        break;
+    case SceneStream_MeshletVtx0:
+        encodeVertices(buf, &geometry.meshletvtx0[chunk.first * 4], sizeof(uint16_t) * 4, chunk.count);
+        break;
+    }
+}
+
+bool decodeMeshletData(const NiagaraMeshlet* meshlets, size_t count, std::vector<uint32_t>& meshletdata, const uint8_t* data, size_t size)
+{
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const NiagaraMeshlet& meshlet = meshlets[i];
+        if (meshlet.vertexCount > MESH_MAXVTX || meshlet.triangleCount > MESH_MAXTRI ||
+            meshlet.dataOffset + getMeshletDataWords(meshlet) > meshletdata.size())
+            return false;
+
+        uint16_t encodedSize = 0;
+        if (offset + sizeof(encodedSize) > size)
+            return false;
+        std::memcpy(&encodedSize, data + offset, sizeof(encodedSize));
+        offset += sizeof(encodedSize);
+        if (offset + encodedSize > size)
+            return false;
+
+        uint32_t* meshletData = meshletdata.data() + meshlet.dataOffset;
+        size_t vertexWords = meshlet.shortRefs ? (meshlet.vertexCount + 1) / 2 : meshlet.vertexCount;
+        size_t vertexSize = meshlet.shortRefs ? 2 : 4;
+
+        if (meshopt_decodeMeshlet(meshletData, meshlet.vertexCount, vertexSize, meshletData + vertexWords, meshlet.triangleCount, 3, data + offset, encodedSize) != 0)
+            return false;
+        offset += encodedSize;
+    }
+    return offset == size;
+}
+
+bool decodeChunk(const SceneChunk& chunk, const uint8_t* data, NiagaraGeometry& geometry)
+{
+    const size_t end = (size_t)chunk.first + chunk.count;
+    switch (chunk.stream)
+    {
+    case SceneStream_Vertices:
+        return end <= geometry.vertices.size() &&
+            meshopt_decodeVertexBuffer(&geometry.vertices[chunk.first], chunk.count, sizeof(NiagaraVertex), data, chunk.size) == 0;
+    case SceneStream_Indices:
+        return end <= geometry.indices.size() && meshopt_decodeIndexBuffer(&geometry.indices[chunk.first], chunk.count, data, chunk.size) == 0;
+    case SceneStream_MeshletData:
+        return end <= geometry.meshlets.size() &&
+            decodeMeshletData(&geometry.meshlets[chunk.first], chunk.count, geometry.meshletdata, data, chunk.size);
+    case SceneStream_MeshletVtx0:
+        return end * 4 <= geometry.meshletvtx0.size() &&
+            meshopt_decodeVertexBuffer(&geometry.meshletvtx0[chunk.first * 4], chunk.count, sizeof(uint16_t) * 4, data, chunk.size) == 0;
+    }
+    return false;
+}
+
+template<typename T>
+void writeVector(std::ofstream& fs, const std::vector<T>& v)
+{
+    fs.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+template<typename T>
+bool readVector(std::vector<T>& v, const uint8_t* fileData, size_t fileSize, size_t& offset)
+{
+    size_t size = v.size() * sizeof(T);
+    if (offset + size > fileSize)
+        return false;
+    std::memcpy(v.data(), fileData + offset, size);
+    offset += size;
+    return true;
+}
+} // namespace
+
+bool saveNiagaraSceneCache(const std::filesystem::path& path, const NiagaraScene& scene, bool fast, bool clrt)
+{
+    const NiagaraGeometry& geometry = scene.geometry;
+
+    SceneHeader header = {};
+    header.magic = kSceneCacheMagic;
+    header.version = kSceneCacheVersion;
+    header.meshletMaxVertices = MESH_MAXVTX;
+    header.meshletMaxTriangles = MESH_MAXTRI;
+    header.fastMode = fast ? 1 : 0;
+    header.clrtMode = clrt ? 1 : 0;
+    header.vertexCount = (uint32_t)geometry.vertices.size();
+    header.indexCount = (uint32_t)geometry.indices.size();
+    header.meshletCount = (uint32_t)geometry.meshlets.size();
+    header.meshletdataCount = (uint32_t)geometry.meshletdata.size();
+    header.meshletvtx0Count = (uint32_t)geometry.meshletvtx0.size();
+    header.meshCount = (uint32_t)geometry.meshes.size();
+    header.materialCount = (uint32_t)scene.materials.size();
+    header.drawCount = (uint32_t)scene.draws.size();
+    header.texturePathCount = (uint32_t)scene.texturePaths.size();
+    header.camera = scene.camera;
+    header.sunDirection = scene.sunDirection;
+
+    std::vector<SceneChunk> chunks;
+    splitChunks(chunks, SceneStream_Vertices, geometry.vertices.size(), kChunkVertices);
+    splitChunks(chunks, SceneStream_Indices, geometry.indices.size(), kChunkIndices);
+    splitChunks(chunks, SceneStream_MeshletData, geometry.meshlets.size(), kChunkMeshlets);
+    splitChunks(chunks, SceneStream_MeshletVtx0, geometry.meshletvtx0.size() / 4, kChunkVertices);
+    header.chunkCount = (uint32_t)chunks.size();
+
+    // Encode the chunks in parallel.
+    std::vector<std::vector<uint8_t>> chunkData(chunks.size());
+    auto chunkRange = NumericRange<size_t>(0, chunks.size());
+    std::for_each(
+        std::execution::par,
+        chunkRange.begin(),
+        chunkRange.end(),
+        [&](size_t i) { encodeChunk(chunkData[i], chunks[i], geometry); }
+    );
+
+    // Everything needed to decode the chunks (notably the meshlet headers) is stored before the chunk data.
+    std::vector<uint8_t> texturePathData;
+    for (const std::string& texturePath : scene.texturePaths)
+    {
+        uint32_t length = (uint32_t)texturePath.size();
+        texturePathData.insert(texturePathData.end(), reinterpret_cast<const uint8_t*>(&length), reinterpret_cast<const uint8_t*>(&length + 1));
+        texturePathData.insert(texturePathData.end(), texturePath.begin(), texturePath.end());
+    }
+
+    uint64_t offset = sizeof(SceneHeader) + chunks.size() * sizeof(SceneChunk) + geometry.meshlets.size() * sizeof(NiagaraMeshlet) +
+                      geometry.meshes.size() * sizeof(NiagaraMesh) + scene.materials.size() * sizeof(NiagaraMaterial) +
+                      scene.draws.size() * sizeof(NiagaraMeshDraw) + texturePathData.size();
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].offset = offset;
+        chunks[i].size = (uint32_t)chunkData[i].size();
+        header.compressedBytes[chunks[i].stream] += chunks[i].size;
+        offset += chunks[i].size;
+    }
+
+    // Write to a temporary file first, so that concurrent loads never see a partial cache file.
+    std::filesystem::create_directories(path.parent_path());
+    auto tempPath = path;
+    tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream fs(tempPath, std::ios_base::binary);
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeVector(fs, chunks);
+        writeVector(fs, geometry.meshlets);
+        writeVector(fs, geometry.meshes);
+        writeVector(fs, scene.materials);
+        writeVector(fs, scene.draws);
+        writeVector(fs, texturePathData);
+        for (const auto& data : chunkData)
+            writeVector(fs, data);
+        if (!fs)
+        {
+            logWarning("Failed to write Niagara scene cache file '{}'.", path);
+            fs.close();
+            std::filesystem::remove(tempPath);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    logInfo("Niagara: Wrote scene cache '{}' ({} chunks, {:.2f} MB).", path, chunks.size(), (double)offset / 1e6);
+    return true;
+}
+
+bool loadNiagaraSceneCache(const std::filesystem::path& path, NiagaraScene& scene, bool fast, bool clrt)
+{
+    if (!std::filesystem::exists(path))
+        return false;
+
+    MemoryMappedFile file(path);
+    if (!file.isOpen() || file.getSize() < sizeof(SceneHeader))
+        return false;
+
+    const uint8_t* fileData = reinterpret_cast<const uint8_t*>(file.getData());
+    const size_t fileSize = file.getSize();
+
+    SceneHeader header;
+    std::memcpy(&header, fileData, sizeof(header));
+    if (header.magic != kSceneCacheMagic || header.version != kSceneCacheVersion || header.meshletMaxVertices != MESH_MAXVTX ||
+        header.meshletMaxTriangles != MESH_MAXTRI || header.fastMode != (fast ? 1u : 0u) || header.clrtMode != (clrt ? 1u : 0u))
+        return false;
+
+    NiagaraScene result;
+    NiagaraGeometry& geometry = result.geometry;
+    std::vector<SceneChunk> chunks(header.chunkCount);
+    geometry.vertices.resize(header.vertexCount);
+    geometry.indices.resize(header.indexCount);
+    geometry.meshlets.resize(header.meshletCount);
+    geometry.meshletdata.resize(header.meshletdataCount);
+    geometry.meshletvtx0.resize(header.meshletvtx0Count);
+    geometry.meshes.resize(header.meshCount);
+    result.materials.resize(header.materialCount);
+    result.draws.resize(header.drawCount);
+    result.texturePaths.resize(header.texturePathCount);
+
+    size_t offset = sizeof(SceneHeader);
+    bool valid = readVector(chunks, fileData, fileSize, offset) && readVector(geometry.meshlets, fileData, fileSize, offset) &&
+                 readVector(geometry.meshes, fileData, fileSize, offset) && readVector(result.materials, fileData, fileSize, offset) &&
+                 readVector(result.draws, fileData, fileSize, offset);
+
+    for (std::string& texturePath : result.texturePaths)
+    {
+        uint32_t length = 0;
+        valid = valid && offset + sizeof(length) <= fileSize;
+        if (!valid)
+            break;
+        std::memcpy(&length, fileData + offset, sizeof(length));
+        offset += sizeof(length);
+        valid = offset + length <= fileSize;
+        if (!valid)
+            break;
+        texturePath.assign(reinterpret_cast<const char*>(fileData + offset), length);
+        offset += length;
+    }
+
+    for (const SceneChunk& chunk : chunks)
+        valid = valid && chunk.stream < SceneStream_Count && chunk.offset + chunk.size <= fileSize;
+
+    if (!valid)
+    {
+        logWarning("Invalid Niagara scene cache file '{}'.", path);
+        return false;
+    }
+
+    // The chunks write disjoint ranges of the geometry and are decoded in parallel.
+    std::atomic<bool> chunksValid = true;
+    auto chunkRange = NumericRange<size_t>(0, chunks.size());
+    std::for_each(
+        std::execution::par,
+        chunkRange.begin(),
+        chunkRange.end(),
+        [&](size_t i)
+        {
+            if (!decodeChunk(chunks[i], fileData + chunks[i].offset, geometry))
+                chunksValid = false;
+        }
+    );
+
+    if (!chunksValid)
+    {
+        logWarning("Failed to decode Niagara scene cache file '{}'.", path);
+        return false;
+    }
+
+    result.camera = header.camera;
+    result.sunDirection = header.sunDirection;
+    scene = std::move(result);
+    return true;
+}
+
+} // namespace Falcor
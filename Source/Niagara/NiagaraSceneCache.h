@@ -0,0 +1,30 @@
+#pragma once
+
+#include "NiagaraScene.h"
+
+#include <filesystem>
+
+namespace Falcor
+{
+
+/** Save a converted Niagara scene to a cache file.
+ *  The file uses the chunked Niagara scene cache layout: geometry streams are split into chunks that are
+ *  compressed independently, so they are encoded and decoded in parallel.
+ *  \param path Cache file path
+ *  \param scene Converted scene
+ *  \param fast Meshlets were built in fast mode
+ *  \param clrt Meshlets were built in cluster RT mode
+ *  \return true if the cache was written
+ */
+bool saveNiagaraSceneCache(const std::filesystem::path& path, const NiagaraScene& scene, bool fast, bool clrt);
+
+/** Load a converted Niagara scene from a cache file.
+ *  \param path Cache file path
+ *  \param scene Output scene
+ *  \param fast Expected fast meshlet build mode
+ *  \param clrt Expected cluster RT meshlet build mode
+ *  \return true if a valid cache matching the meshlet configuration was loaded
+ */
+bool loadNiagaraSceneCache(const std::filesystem::path& path, NiagaraScene& scene, bool fast, bool clrt);
+
+} // namespace Falcor
@@ -7,11 +7,12 @@
 #include <cgltf.h>
 #include <meshoptimizer.h>
 
-#include <time.h>
-
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <cstring>
+#include <thread>
 
 static void appendMeshlet(Geometry& result, const meshopt_Meshlet& meshlet, const std::vector<vec3>& vertices, const std::vector<unsigned int>& meshlet_vertices, const std::vector<unsigned char>& meshlet_triangles, uint32_t baseVertex, bool lod0)
 {
@@ -161,7 +162,17 @@ static bool loadObj(std::vector<Vertex>& vertices, const char* path)
 	return true;
 }
 
-static void appendMesh(Geometry& result, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool buildMeshlets, bool fast, bool clrt)
+// mesh with all LOD index buffers generated; meshlets are built per LOD into a separate geometry with offsets relative to the mesh
+struct MeshBuild
+{
+	Mesh mesh;
+	std::vector<Vertex> vertices;
+	std::vector<vec3> positions;
+	std::vector<uint32_t> lodIndices[COUNTOF(Mesh::lods)];
+	Geometry lodMeshlets[COUNTOF(Mesh::lods)];
+};
+
+static void prepareMesh(MeshBuild& build, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool fast)
 {
 	std::vector<uint32_t> remap(vertices.size());
 	size_t uniqueVertices = meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(Vertex));
@@ -178,14 +189,12 @@ static void appendMesh(Geometry& result, std::vector<Vertex>& vertices, std::vec
 
 	meshopt_optimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(Vertex));
 
-	Mesh mesh = {};
-
-	mesh.vertexOffset = uint32_t(result.vertices.size());
+	Mesh& mesh = build.mesh;
+	mesh = {};
 	mesh.vertexCount = uint32_t(vertices.size());
 
-	result.vertices.insert(result.vertices.end(), vertices.begin(), vertices.end());
-
-	std::vector<vec3> positions(vertices.size());
+	std::vector<vec3>& positions = build.positions;
+	positions.resize(vertices.size());
 	for (size_t i = 0; i < vertices.size(); ++i)
 	{
 		Vertex& v = vertices[i];
@@ -221,20 +230,16 @@ static void appendMesh(Geometry& result, std::vector<Vertex>& vertices, std::vec
 
 	float normalWeights[3] = { 1.f, 1.f, 1.f };
 
+	// the LOD chain is sequential since every LOD is simplified from the previous one; meshlets are built later, in parallel
 	while (mesh.lodCount < COUNTOF(mesh.lods))
 	{
-		MeshLod& lod = mesh.lods[mesh.lodCount++];
+		MeshLod& lod = mesh.lods[mesh.lodCount];
 
-		lod.indexOffset = uint32_t(result.indices.size());
 		lod.indexCount = uint32_t(lodIndices.size());
-
-		result.indices.insert(result.indices.end(), lodIndices.begin(), lodIndices.end());
-
-		lod.meshletOffset = uint32_t(result.meshlets.size());
-		lod.meshletCount = buildMeshlets ? uint32_t(appendMeshlets(result, positions, lodIndices, mesh.vertexOffset, &lod == mesh.lods, fast, clrt)) : 0;
-
 		lod.error = lodError * lodScale;
 
+		build.lodIndices[mesh.lodCount++] = lodIndices;
+
 		if (mesh.lodCount < COUNTOF(mesh.lods))
 		{
 			// note: we're using the same value for all LODs; if this changes, we need to remove/change 85% exit criteria below
@@ -264,9 +269,80 @@ static void appendMesh(Geometry& result, std::vector<Vertex>& vertices, std::vec
 		}
 	}
 
+	build.vertices = std::move(vertices);
+}
+
+static void buildMeshLod(MeshBuild& build, unsigned int lodIndex, bool fast, bool clrt)
+{
+	MeshLod& lod = build.mesh.lods[lodIndex];
+
+	lod.meshletCount = uint32_t(appendMeshlets(build.lodMeshlets[lodIndex], build.positions, build.lodIndices[lodIndex], 0, lodIndex == 0, fast, clrt));
+}
+
+static void appendMeshBuild(Geometry& result, MeshBuild& build)
+{
+	Mesh mesh = build.mesh;
+
+	mesh.vertexOffset = uint32_t(result.vertices.size());
+
+	result.vertices.insert(result.vertices.end(), build.vertices.begin(), build.vertices.end());
+
+	for (unsigned int i = 0; i < mesh.lodCount; ++i)
+	{
+		MeshLod& lod = mesh.lods[i];
+		const Geometry& lodMeshlets = build.lodMeshlets[i];
+
+		lod.indexOffset = uint32_t(result.indices.size());
+		result.indices.insert(result.indices.end(), build.lodIndices[i].begin(), build.lodIndices[i].end());
+
+		lod.meshletOffset = uint32_t(result.meshlets.size());
+
+		uint32_t dataOffset = uint32_t(result.meshletdata.size());
+
+		for (Meshlet m : lodMeshlets.meshlets)
+		{
+			m.dataOffset += dataOffset;
+			m.baseVertex += mesh.vertexOffset;
+			result.meshlets.push_back(m);
+		}
+
+		result.meshletdata.insert(result.meshletdata.end(), lodMeshlets.meshletdata.begin(), lodMeshlets.meshletdata.end());
+		result.meshletvtx0.insert(result.meshletvtx0.end(), lodMeshlets.meshletvtx0.begin(), lodMeshlets.meshletvtx0.end());
+	}
+
 	result.meshes.push_back(mesh);
 }
 
+// builds meshlets for all meshes and LODs in parallel and appends the meshes in order, so the result doesn't depend on scheduling
+static void appendMeshes(Geometry& result, std::vector<MeshBuild>& builds, bool buildMeshlets, bool fast, bool clrt)
+{
+	if (buildMeshlets)
+	{
+		std::vector<std::pair<unsigned int, unsigned int>> jobs;
+		for (size_t i = 0; i < builds.size(); ++i)
+			for (unsigned int j = 0; j < builds[i].mesh.lodCount; ++j)
+				jobs.push_back(std::make_pair(unsigned(i), j));
+
+		// larger LODs first for better load balancing
+		std::stable_sort(jobs.begin(), jobs.end(), [&](const std::pair<unsigned int, unsigned int>& l, const std::pair<unsigned int, unsigned int>& r)
+		    { return builds[l.first].lodIndices[l.second].size() > builds[r.first].lodIndices[r.second].size(); });
+
+		parallelFor(jobs.size(), [&](size_t i)
+		    { buildMeshLod(builds[jobs[i].first], jobs[i].second, fast, clrt); });
+	}
+
+	for (MeshBuild& build : builds)
+		appendMeshBuild(result, build);
+}
+
+static void appendMesh(Geometry& result, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool buildMeshlets, bool fast, bool clrt)
+{
+	std::vector<MeshBuild> builds(1);
+	prepareMesh(builds[0], vertices, indices, fast);
+
+	appendMeshes(result, builds, buildMeshlets, fast, clrt);
+}
+
 bool loadMesh(Geometry& geometry, const char* path, bool buildMeshlets, bool fast, bool clrt)
 {
 	std::vector<Vertex> vertices;
@@ -393,7 +469,7 @@ static void loadVertices(std::vector<Vertex>& vertices, const cgltf_primitive& p
 
 bool loadScene(Geometry& geometry, std::vector<Material>& materials, std::vector<MeshDraw>& draws, std::vector<std::string>& texturePaths, std::vector<Animation>& animations, Camera& camera, vec3& sunDirection, const char* path, bool buildMeshlets, bool fast, bool clrt)
 {
-	clock_t timer = clock();
+	auto timer = std::chrono::steady_clock::now();
 
 	cgltf_options options = {};
 	cgltf_data* data = NULL;
@@ -413,6 +489,7 @@ bool loadScene(Geometry& geometry, std::vector<Material>& materials, std::vector
 
 	std::vector<std::pair<unsigned int, unsigned int>> primitives;
 	std::vector<cgltf_material*> primitiveMaterials;
+	std::vector<const cgltf_primitive*> meshPrimitives;
 
 	size_t firstMeshOffset = geometry.meshes.size();
 
@@ -420,7 +497,7 @@ bool loadScene(Geometry& geometry, std::vector<Material>& materials, std::vector
 	{
 		const cgltf_mesh& mesh = data->meshes[i];
 
-		size_t meshOffset = geometry.meshes.size();
+		size_t meshOffset = firstMeshOffset + meshPrimitives.size();
 
 		for (size_t pi = 0; pi < mesh.primitives_count; ++pi)
 		{
@@ -428,19 +505,30 @@ bool loadScene(Geometry& geometry, std::vector<Material>& materials, std::vector
 			if (prim.type != cgltf_primitive_type_triangles || !prim.indices)
 				continue;
 
-			std::vector<Vertex> vertices(prim.attributes[0].data->count);
-			loadVertices(vertices, prim);
-
-			std::vector<uint32_t> indices(prim.indices->count);
-			cgltf_accessor_unpack_indices(prim.indices, indices.data(), 4, indices.size());
-
-			appendMesh(geometry, vertices, indices, buildMeshlets, fast, clrt);
+			meshPrimitives.push_back(&prim);
 			primitiveMaterials.push_back(prim.material);
 		}
 
-		primitives.push_back(std::make_pair(unsigned(meshOffset), unsigned(geometry.meshes.size() - meshOffset)));
+		primitives.push_back(std::make_pair(unsigned(meshOffset), unsigned(firstMeshOffset + meshPrimitives.size() - meshOffset)));
 	}
 
+	std::vector<MeshBuild> builds(meshPrimitives.size());
+
+	parallelFor(meshPrimitives.size(), [&](size_t i)
+	{
+		const cgltf_primitive& prim = *meshPrimitives[i];
+
+		std::vector<Vertex> vertices(prim.attributes[0].data->count);
+		loadVertices(vertices, prim);
+
+		std::vector<uint32_t> indices(prim.indices->count);
+		cgltf_accessor_unpack_indices(prim.indices, indices.data(), 4, indices.size());
+
+		prepareMesh(builds[i], vertices, indices, fast);
+	});
+
+	appendMeshes(geometry, builds, buildMeshlets, fast, clrt);
+
 	assert(primitiveMaterials.size() + firstMeshOffset == geometry.meshes.size());
 
 	std::vector<int> nodeDraws(data->nodes_count, -1); // for animations
@@ -714,7 +802,7 @@ bool loadScene(Geometry& geometry, std::vector<Material>& materials, std::vector
 
 	printf("Loaded %s: %d meshes, %d draws, %d animations, %d vertices in %.2f sec\n",
 	    path, int(geometry.meshes.size()), int(draws.size()), int(animations.size()), int(geometry.vertices.size()),
-	    double(clock() - timer) / CLOCKS_PER_SEC);
+	    std::chrono::duration<double>(std::chrono::steady_clock::now() - timer).count());
 
 	if (buildMeshlets)
 	{
@@ -4,7 +4,11 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <string>
+#include <thread>
 #include <vector>
 
 struct alignas(8) Meshlet
@@ -113,5 +117,27 @@ struct Animation
 bool loadMesh(Geometry& geometry, const char* path, bool buildMeshlets, bool fast = false, bool clrt = false);
 bool loadScene(Geometry& geometry, std::vector<Material>& materials, std::vector<MeshDraw>& draws, std::vector<std::string>& texturePaths, std::vector<Animation>& animations, Camera& camera, vec3& sunDirection, const char* path, bool buildMeshlets, bool fast = false, bool clrt = false);
 
+// runs job(0..count-1) on all hardware threads; job order is unspecified
+inline void parallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+	size_t threadCount = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), count);
+
+	std::atomic<size_t> next{ 0 };
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+			job(i);
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
 bool saveSceneCache(const char* path, const Geometry& geometry, const std::vector<Material>& materials, const std::vector<MeshDraw>& draws, const std::vector<std::string>& texturePaths, const Camera& camera, const vec3& sunDirection, bool clrtMode, bool compressed, bool verbose);
 bool loadSceneCache(const char* path, Geometry& geometry, std::vector<Material>& materials, std::vector<MeshDraw>& draws, std::vector<std::string>& texturePaths, Camera& camera, vec3& sunDirection, bool clrtMode);
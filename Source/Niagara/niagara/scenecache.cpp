@@ -9,8 +9,26 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+
 const uint32_t kSceneCacheMagic = 0x434E4353; // 'SCNC'
-const uint32_t kSceneCacheVersion = 3;
+const uint32_t kSceneCacheVersion = 4;
+
+// geometry streams are split into chunks that are encoded and decoded independently, so that they can be processed in parallel
+const uint32_t kChunkVertices = 1 << 16;
+const uint32_t kChunkIndices = 3 << 16;
+const uint32_t kChunkMeshlets = 1 << 12;
+
+enum SceneStream
+{
+	SceneStream_Vertices,
+	SceneStream_Indices,
+	SceneStream_MeshletData,
+	SceneStream_MeshletVtx0,
+
+	SceneStream_Count
+};
 
 struct SceneHeader
 {
@@ -39,39 +57,70 @@ struct SceneHeader
 	uint32_t drawCount;
 	uint32_t texturePathCount;
 
+	uint32_t chunkCount;
+
 	Camera camera;
 	vec3 sunDirection;
 };
 
-static size_t writeVertexCompressed(const void* vertices, size_t stride, size_t count, FILE* file, int level = 2)
+struct SceneChunk
+{
+	uint32_t stream;
+	uint32_t first; // first vertex, index or meshlet of the chunk
+	uint32_t count;
+	uint32_t size; // size of the chunk data in the file
+
+	uint64_t offset; // offset of the chunk data in the file
+};
+
+static std::vector<SceneChunk> splitChunks(uint32_t stream, size_t count, size_t chunkSize)
+{
+	std::vector<SceneChunk> chunks;
+
+	for (size_t first = 0; first < count; first += chunkSize)
+	{
+		SceneChunk chunk = {};
+		chunk.stream = stream;
+		chunk.first = uint32_t(first);
+		chunk.count = uint32_t(std::min(count - first, chunkSize));
+
+		chunks.push_back(chunk);
+	}
+
+	return chunks;
+}
+
+// range of meshletdata words referenced by meshlets first..first+count-1; meshlet data is stored in meshlet order
+static std::pair<size_t, size_t> getMeshletDataRange(const std::vector<Meshlet>& meshlets, size_t meshletdataCount, const SceneChunk& chunk)
+{
+	size_t begin = meshlets[chunk.first].dataOffset;
+	size_t end = chunk.first + chunk.count < meshlets.size() ? meshlets[chunk.first + chunk.count].dataOffset : meshletdataCount;
+
+	return std::make_pair(begin, end);
+}
+
+static void writeVertexCompressed(std::vector<unsigned char>& buf, const void* vertices, size_t stride, size_t count, int level = 2)
 {
 	size_t bound = meshopt_encodeVertexBufferBound(count, stride);
-	std::vector<unsigned char> buf(bound);
+	buf.resize(bound);
 	buf.resize(meshopt_encodeVertexBufferLevel(buf.data(), buf.size(), vertices, count, stride, level));
-
-	fwrite(buf.data(), 1, buf.size(), file);
-	return buf.size();
 }
 
-static size_t writeIndexCompressed(const uint32_t* indices, size_t count, FILE* file)
+static void writeIndexCompressed(std::vector<unsigned char>& buf, const uint32_t* indices, size_t count)
 {
 	size_t bound = meshopt_encodeIndexBufferBound(count, ~0u); // TODO: vertex_count could be optional somehow
-	std::vector<unsigned char> buf(bound);
+	buf.resize(bound);
 	buf.resize(meshopt_encodeIndexBuffer(buf.data(), buf.size(), indices, count));
-
-	fwrite(buf.data(), 1, buf.size(), file);
-	return buf.size();
 }
 
-static size_t writeMeshletDataCompressed(const std::vector<Meshlet>& meshlets, const std::vector<uint32_t>& meshletdata, FILE* file)
+static void writeMeshletDataCompressed(std::vector<unsigned char>& buf, const Meshlet* meshlets, size_t count, const std::vector<uint32_t>& meshletdata)
 {
 	std::vector<unsigned char> encoded(meshopt_encodeMeshletBound(MESH_MAXVTX, MESH_MAXTRI));
 	std::vector<unsigned int> refs(MESH_MAXVTX);
 
-	size_t total = 0;
-
-	for (const Meshlet& meshlet : meshlets)
+	for (size_t mi = 0; mi < count; ++mi)
 	{
+		const Meshlet& meshlet = meshlets[mi];
 		const uint32_t* data = meshletdata.data() + meshlet.dataOffset;
 		size_t vertexWords = meshlet.shortRefs ? (meshlet.vertexCount + 1) / 2 : meshlet.vertexCount;
 
@@ -89,13 +138,51 @@ static size_t writeMeshletDataCompressed(const std::vector<Meshlet>& meshlets, c
 		size_t encodedSize = meshopt_encodeMeshlet(encoded.data(), encoded.size(), vertices, meshlet.vertexCount, triangles, meshlet.triangleCount);
 		uint16_t encodedSize16 = uint16_t(encodedSize);
 
-		fwrite(&encodedSize16, sizeof(encodedSize16), 1, file);
-		fwrite(encoded.data(), 1, encodedSize, file);
-
-		total += sizeof(encodedSize16) + encodedSize;
+		buf.insert(buf.end(), reinterpret_cast<unsigned char*>(&encodedSize16), reinterpret_cast<unsigned char*>(&encodedSize16 + 1));
+		buf.insert(buf.end(), encoded.begin(), encoded.begin() + encodedSize);
 	}
+}
 
-	return total;
+static void writeRaw(std::vector<unsigned char>& buf, const void* data, size_t size)
+{
+	buf.assign(static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+}
+
+static void writeChunk(std::vector<unsigned char>& buf, const SceneChunk& chunk, const Geometry& geometry, bool compressed)
+{
+	switch (chunk.stream)
+	{
+	case SceneStream_Vertices:
+		if (compressed)
+			writeVertexCompressed(buf, &geometry.vertices[chunk.first], sizeof(Vertex), chunk.count);
+		else
+			writeRaw(buf, &geometry.vertices[chunk.first], chunk.count * sizeof(Vertex));
+		break;
+
+	case SceneStream_Indices:
+		if (compressed)
+			writeIndexCompressed(buf, &geometry.indices[chunk.first], chunk.count);
+		else
+			writeRaw(buf, &geometry.indices[chunk.first], chunk.count * sizeof(uint32_t));
+		break;
+
+	case SceneStream_MeshletData:
+		if (compressed)
+			writeMeshletDataCompressed(buf, &geometry.meshlets[chunk.first], chunk.count, geometry.meshletdata);
+		else
+		{
+			std::pair<size_t, size_t> range = getMeshletDataRange(geometry.meshlets, geometry.meshletdata.size(), chunk);
+			writeRaw(buf, geometry.meshletdata.data() + range.first, (range.second - range.first) * sizeof(uint32_t));
+		}
+		break;
+
+	case SceneStream_MeshletVtx0:
+		if (compressed)
+			writeVertexCompressed(buf, &geometry.meshletvtx0[chunk.first * 4], sizeof(uint16_t) * 4, chunk.count);
+		else
+			writeRaw(buf, &geometry.meshletvtx0[chunk.first * 4], chunk.count * sizeof(uint16_t) * 4);
+		break;
+	}
 }
 
 bool saveSceneCache(const char* path, const Geometry& geometry, const std::vector<Material>& materials, const std::vector<MeshDraw>& draws, const std::vector<std::string>& texturePaths, const Camera& camera, const vec3& sunDirection, bool clrtMode, bool compressed, bool verbose)
@@ -128,29 +215,29 @@ bool saveSceneCache(const char* path, const Geometry& geometry, const std::vecto
 	header.camera = camera;
 	header.sunDirection = sunDirection;
 
-	fwrite(&header, sizeof(header), 1, file);
+	std::vector<SceneChunk> chunks;
+	std::vector<SceneChunk> streamChunks[SceneStream_Count] = {
+		splitChunks(SceneStream_Vertices, geometry.vertices.size(), kChunkVertices),
+		splitChunks(SceneStream_Indices, geometry.indices.size(), kChunkIndices),
+		splitChunks(SceneStream_MeshletData, geometry.meshlets.size(), kChunkMeshlets),
+		splitChunks(SceneStream_MeshletVtx0, geometry.meshletvtx0.size() / 4, kChunkVertices),
+	};
 
-	if (compressed)
-		header.compressedVertexBytes = writeVertexCompressed(geometry.vertices.data(), sizeof(Vertex), geometry.vertices.size(), file);
-	else
-		fwrite(geometry.vertices.data(), sizeof(Vertex), geometry.vertices.size(), file);
+	for (const std::vector<SceneChunk>& sc : streamChunks)
+		chunks.insert(chunks.end(), sc.begin(), sc.end());
 
-	if (compressed)
-		header.compressedIndexBytes = writeIndexCompressed(geometry.indices.data(), geometry.indices.size(), file);
-	else
-		fwrite(geometry.indices.data(), sizeof(uint32_t), geometry.indices.size(), file);
+	header.chunkCount = chunks.size();
 
-	fwrite(geometry.meshlets.data(), sizeof(Meshlet), geometry.meshlets.size(), file);
-	if (compressed)
-		header.compressedMeshletDataBytes = writeMeshletDataCompressed(geometry.meshlets, geometry.meshletdata, file);
-	else
-		fwrite(geometry.meshletdata.data(), sizeof(uint32_t), geometry.meshletdata.size(), file);
+	std::vector<std::vector<unsigned char>> chunkData(chunks.size());
 
-	if (compressed)
-		header.compressedMeshletVtx0Bytes = writeVertexCompressed(geometry.meshletvtx0.data(), sizeof(uint16_t) * 4, geometry.meshletvtx0.size() / 4, file);
-	else
-		fwrite(geometry.meshletvtx0.data(), sizeof(uint16_t), geometry.meshletvtx0.size(), file);
+	parallelFor(chunks.size(), [&](size_t i)
+	    { writeChunk(chunkData[i], chunks[i], geometry, compressed); });
 
+	// everything that is needed to decode the chunks (notably meshlet headers) goes before the chunk data
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(chunks.data(), sizeof(SceneChunk), chunks.size(), file);
+
+	fwrite(geometry.meshlets.data(), sizeof(Meshlet), geometry.meshlets.size(), file);
 	fwrite(geometry.meshes.data(), sizeof(Mesh), geometry.meshes.size(), file);
 	fwrite(materials.data(), sizeof(Material), materials.size(), file);
 	fwrite(draws.data(), sizeof(MeshDraw), draws.size(), file);
@@ -162,15 +249,31 @@ bool saveSceneCache(const char* path, const Geometry& geometry, const std::vecto
 		fwrite(buf, sizeof(buf), 1, file);
 	}
 
-	// fixup final header
+	uint32_t* streamBytes[SceneStream_Count] = { &header.compressedVertexBytes, &header.compressedIndexBytes, &header.compressedMeshletDataBytes, &header.compressedMeshletVtx0Bytes };
+
+	uint64_t offset = uint64_t(ftell(file));
+
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		chunks[i].offset = offset;
+		chunks[i].size = uint32_t(chunkData[i].size());
+
+		fwrite(chunkData[i].data(), 1, chunkData[i].size(), file);
+
+		offset += chunks[i].size;
+		*streamBytes[chunks[i].stream] += chunks[i].size;
+	}
+
+	// fixup final header and chunk table
 	fseek(file, 0, SEEK_SET);
 	fwrite(&header, sizeof(header), 1, file);
+	fwrite(chunks.data(), sizeof(SceneChunk), chunks.size(), file);
 
 	fclose(file);
 
 	if (verbose)
 	{
-		printf("Scene cache saved to %s\n", path);
+		printf("Scene cache saved to %s (%d chunks)\n", path, int(chunks.size()));
 
 		if (compressed)
 			printf("Vertex data: %.2f MB (%.2f MB compressed)\n", double(geometry.vertices.size() * sizeof(Vertex)) / 1e6, double(header.compressedVertexBytes) / 1e6);
@@ -198,39 +301,120 @@ bool saveSceneCache(const char* path, const Geometry& geometry, const std::vecto
 	return true;
 }
 
-static void read(void* data, size_t size, size_t count, void* fileMemory, size_t& fileOffset)
+static bool read(void* data, size_t size, size_t count, void* fileMemory, size_t fileSize, size_t& fileOffset)
 {
+	if (fileOffset + size * count > fileSize)
+		return false;
+
 	memcpy(data, (char*)fileMemory + fileOffset, size * count);
 	fileOffset += size * count;
+	return true;
 }
 
-static void readVertexCompressed(void* data, size_t size, size_t count, size_t compressedBytes, void* fileMemory, size_t& fileOffset)
+static bool readVertexCompressed(void* data, size_t size, size_t count, const unsigned char* chunkData, size_t chunkSize)
 {
-	meshopt_decodeVertexBuffer(data, count, size, (unsigned char*)fileMemory + fileOffset, compressedBytes);
-	fileOffset += compressedBytes;
+	return meshopt_decodeVertexBuffer(data, count, size, chunkData, chunkSize) == 0;
 }
 
-static void readIndexCompressed(unsigned int* data, size_t count, size_t compressedBytes, void* fileMemory, size_t& fileOffset)
+static bool readIndexCompressed(unsigned int* data, size_t count, const unsigned char* chunkData, size_t chunkSize)
 {
-	meshopt_decodeIndexBuffer(data, count, (unsigned char*)fileMemory + fileOffset, compressedBytes);
-	fileOffset += compressedBytes;
+	return meshopt_decodeIndexBuffer(data, count, chunkData, chunkSize) == 0;
 }
 
-static void readMeshletDataCompressed(const std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletdata, void* fileMemory, size_t& fileOffset)
+// meshlets are decoded into meshletdata[dataBegin..dataEnd-1]; chunks are decoded in parallel, so meshlets outside of the chunk range are rejected
+static bool readMeshletDataCompressed(const Meshlet* meshlets, size_t count, std::vector<uint32_t>& meshletdata, size_t dataBegin, size_t dataEnd, const unsigned char* chunkData, size_t chunkSize)
 {
-	for (const Meshlet& meshlet : meshlets)
+	size_t offset = 0;
+
+	for (size_t mi = 0; mi < count; ++mi)
 	{
+		const Meshlet& meshlet = meshlets[mi];
+
 		uint16_t encodedSize = 0;
-		read(&encodedSize, sizeof(encodedSize), 1, fileMemory, fileOffset);
+		if (offset + sizeof(encodedSize) > chunkSize)
+			return false;
 
-		uint32_t* data = meshletdata.data() + meshlet.dataOffset;
+		memcpy(&encodedSize, chunkData + offset, sizeof(encodedSize));
+		offset += sizeof(encodedSize);
+
+		if (offset + encodedSize > chunkSize)
+			return false;
 
 		size_t vertexWords = meshlet.shortRefs ? (meshlet.vertexCount + 1) / 2 : meshlet.vertexCount;
 		size_t vertexSize = meshlet.shortRefs ? 2 : 4;
+		size_t triangleWords = (size_t(meshlet.triangleCount) * 3 + 3) / 4;
+
+		if (meshlet.dataOffset < dataBegin || size_t(meshlet.dataOffset) + vertexWords + triangleWords > dataEnd)
+			return false;
+
+		uint32_t* data = meshletdata.data() + meshlet.dataOffset;
 
-		meshopt_decodeMeshlet(data, meshlet.vertexCount, vertexSize, data + vertexWords, meshlet.triangleCount, 3, (unsigned char*)fileMemory + fileOffset, encodedSize);
-		fileOffset += encodedSize;
+		if (meshopt_decodeMeshlet(data, meshlet.vertexCount, vertexSize, data + vertexWords, meshlet.triangleCount, 3, chunkData + offset, encodedSize) != 0)
+			return false;
+
+		offset += encodedSize;
 	}
+
+	return true;
+}
+
+static bool readRaw(void* data, size_t size, const unsigned char* chunkData, size_t chunkSize)
+{
+	if (size != chunkSize)
+		return false;
+
+	memcpy(data, chunkData, size);
+	return true;
+}
+
+static bool readChunk(const SceneChunk& chunk, const unsigned char* chunkData, Geometry& geometry, bool compressed)
+{
+	switch (chunk.stream)
+	{
+	case SceneStream_Vertices:
+		if (size_t(chunk.first) + chunk.count > geometry.vertices.size())
+			return false;
+
+		if (compressed)
+			return readVertexCompressed(&geometry.vertices[chunk.first], sizeof(Vertex), chunk.count, chunkData, chunk.size);
+		else
+			return readRaw(&geometry.vertices[chunk.first], chunk.count * sizeof(Vertex), chunkData, chunk.size);
+
+	case SceneStream_Indices:
+		if (size_t(chunk.first) + chunk.count > geometry.indices.size())
+			return false;
+
+		if (compressed)
+			return readIndexCompressed(&geometry.indices[chunk.first], chunk.count, chunkData, chunk.size);
+		else
+			return readRaw(&geometry.indices[chunk.first], chunk.count * sizeof(uint32_t), chunkData, chunk.size);
+
+	case SceneStream_MeshletData:
+		if (size_t(chunk.first) + chunk.count > geometry.meshlets.size())
+			return false;
+
+		{
+			std::pair<size_t, size_t> range = getMeshletDataRange(geometry.meshlets, geometry.meshletdata.size(), chunk);
+			if (range.first > range.second || range.second > geometry.meshletdata.size())
+				return false;
+
+			if (compressed)
+				return readMeshletDataCompressed(&geometry.meshlets[chunk.first], chunk.count, geometry.meshletdata, range.first, range.second, chunkData, chunk.size);
+			else
+				return readRaw(geometry.meshletdata.data() + range.first, (range.second - range.first) * sizeof(uint32_t), chunkData, chunk.size);
+		}
+
+	case SceneStream_MeshletVtx0:
+		if ((size_t(chunk.first) + chunk.count) * 4 > geometry.meshletvtx0.size())
+			return false;
+
+		if (compressed)
+			return readVertexCompressed(&geometry.meshletvtx0[chunk.first * 4], sizeof(uint16_t) * 4, chunk.count, chunkData, chunk.size);
+		else
+			return readRaw(&geometry.meshletvtx0[chunk.first * 4], chunk.count * sizeof(uint16_t) * 4, chunkData, chunk.size);
+	}
+
+	return false;
 }
 
 bool loadSceneCache(const char* path, Geometry& geometry, std::vector<Material>& materials, std::vector<MeshDraw>& draws, std::vector<std::string>& texturePaths, Camera& camera, vec3& sunDirection, bool clrtMode)
@@ -253,6 +437,8 @@ bool loadSceneCache(const char* path, Geometry& geometry, std::vector<Material>&
 
 	size_t fileOffset = sizeof(header);
 
+	std::vector<SceneChunk> chunks(header.chunkCount);
+
 	geometry.vertices.resize(header.vertexCount);
 	geometry.indices.resize(header.indexCount);
 	geometry.meshlets.resize(header.meshletCount);
@@ -263,42 +449,40 @@ bool loadSceneCache(const char* path, Geometry& geometry, std::vector<Material>&
 	draws.resize(header.drawCount);
 	texturePaths.resize(header.texturePathCount);
 
-	if (header.compressed)
-		readVertexCompressed(geometry.vertices.data(), sizeof(Vertex), geometry.vertices.size(), header.compressedVertexBytes, file, fileOffset);
-	else
-		read(geometry.vertices.data(), sizeof(Vertex), geometry.vertices.size(), file, fileOffset);
-
-	if (header.compressed)
-		readIndexCompressed(geometry.indices.data(), geometry.indices.size(), header.compressedIndexBytes, file, fileOffset);
-	else
-		read(geometry.indices.data(), sizeof(uint32_t), geometry.indices.size(), file, fileOffset);
-
-	read(geometry.meshlets.data(), sizeof(Meshlet), geometry.meshlets.size(), file, fileOffset);
-	if (header.compressed)
-		readMeshletDataCompressed(geometry.meshlets, geometry.meshletdata, file, fileOffset);
-	else
-		read(geometry.meshletdata.data(), sizeof(uint32_t), geometry.meshletdata.size(), file, fileOffset);
-
-	if (header.compressed)
-		readVertexCompressed(geometry.meshletvtx0.data(), sizeof(uint16_t) * 4, geometry.meshletvtx0.size() / 4, header.compressedMeshletVtx0Bytes, file, fileOffset);
-	else
-		read(geometry.meshletvtx0.data(), sizeof(uint16_t), geometry.meshletvtx0.size(), file, fileOffset);
-
-	read(geometry.meshes.data(), sizeof(Mesh), geometry.meshes.size(), file, fileOffset);
-	read(materials.data(), sizeof(Material), materials.size(), file, fileOffset);
-	read(draws.data(), sizeof(MeshDraw), draws.size(), file, fileOffset);
+	bool valid =
+	    read(chunks.data(), sizeof(SceneChunk), chunks.size(), file, fileSize, fileOffset) &&
+	    read(geometry.meshlets.data(), sizeof(Meshlet), geometry.meshlets.size(), file, fileSize, fileOffset) &&
+	    read(geometry.meshes.data(), sizeof(Mesh), geometry.meshes.size(), file, fileSize, fileOffset) &&
+	    read(materials.data(), sizeof(Material), materials.size(), file, fileSize, fileOffset) &&
+	    read(draws.data(), sizeof(MeshDraw), draws.size(), file, fileSize, fileOffset);
 
 	for (std::string& path : texturePaths)
 	{
 		char buf[128] = {};
-		read(buf, sizeof(buf), 1, file, fileOffset);
+		valid = valid && read(buf, sizeof(buf), 1, file, fileSize, fileOffset);
 		buf[sizeof(buf) - 1] = 0;
 
 		path = buf;
 	}
 
+	for (const SceneChunk& chunk : chunks)
+		valid = valid && chunk.offset + chunk.size <= fileSize;
+
+	// chunks write disjoint ranges of the geometry and can be decoded concurrently
+	std::atomic<bool> chunksValid{ valid };
+
+	if (valid)
+		parallelFor(chunks.size(), [&](size_t i)
+		{
+			if (!readChunk(chunks[i], (const unsigned char*)file + chunks[i].offset, geometry, header.compressed))
+				chunksValid = false;
+		});
+
 	unmapFile(file, fileSize);
 
+	if (!chunksValid)
+		return false;
+
 	camera = header.camera;
 	sunDirection = header.sunDirection;
 
@@ -0,0 +1,238 @@
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "NiagaraConfig.h"
+#include "NiagaraSceneCache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+// Element counts larger than the cache chunk sizes, so that every stream is split into several chunks.
+const uint32_t kVertexCount = 150000;
+const uint32_t kTriangleCount = 70000;
+const uint32_t kMeshletCount = 9000;
+
+template<typename T>
+bool isBitwiseEqual(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+template<typename T>
+T randomBytes(std::mt19937& rng)
+{
+    std::array<uint8_t, sizeof(T)> bytes;
+    for (uint8_t& byte : bytes)
+        byte = (uint8_t)rng();
+    T value;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    return value;
+}
+
+/** Rotates a triangle so that its smallest index comes first. The codecs may rotate triangles but preserve their winding.
+*/
+std::array<uint32_t, 3> normalizeTriangle(uint32_t a, uint32_t b, uint32_t c)
+{
+    if (b < a && b < c)
+        return {b, c, a};
+    if (c < a && c < b)
+        return {c, a, b};
+    return {a, b, c};
+}
+
+std::vector<std::array<uint32_t, 3>> getTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        triangles.push_back(normalizeTriangle(indices[i], indices[i + 1], indices[i + 2]));
+    return triangles;
+}
+
+std::vector<uint32_t> getMeshletVertices(const NiagaraMeshlet& meshlet, const std::vector<uint32_t>& meshletdata)
+{
+    std::vector<uint32_t> vertices(meshlet.vertexCount);
+    const uint32_t* data = meshletdata.data() + meshlet.dataOffset;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+        vertices[i] = meshlet.shortRefs ? reinterpret_cast<const uint16_t*>(data)[i] : data[i];
+    return vertices;
+}
+
+/** Returns the triangles of a meshlet as sorted triangles of vertex references.
+    This is independent of the order in which the meshlet codec stores vertices and triangles.
+*/
+std::vector<std::array<uint32_t, 3>> getMeshletTriangles(const NiagaraMeshlet& meshlet, const std::vector<uint32_t>& meshletdata)
+{
+    const std::vector<uint32_t> vertices = getMeshletVertices(meshlet, meshletdata);
+    const size_t vertexWords = meshlet.shortRefs ? (meshlet.vertexCount + 1) / 2 : meshlet.vertexCount;
+    const uint8_t* triangles = reinterpret_cast<const uint8_t*>(meshletdata.data() + meshlet.dataOffset + vertexWords);
+
+    std::vector<uint32_t> indices;
+    for (uint32_t i = 0; i < meshlet.triangleCount * 3u; ++i)
+        indices.push_back(vertices[triangles[i]]);
+    auto result = getTriangles(indices);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/** Adds a meshlet with distinct vertex references and non-degenerate triangles that reference every vertex.
+*/
+void addMeshlet(NiagaraGeometry& geometry, std::mt19937& rng)
+{
+    NiagaraMeshlet meshlet = {};
+    meshlet.dataOffset = (uint32_t)geometry.meshletdata.size();
+    meshlet.baseVertex = rng() % kVertexCount;
+    meshlet.vertexCount = (uint16_t)(3 + rng() % (MESH_MAXVTX - 2));
+    meshlet.triangleCount = (uint16_t)(meshlet.vertexCount - 2 + rng() % (MESH_MAXTRI - meshlet.vertexCount + 3));
+    meshlet.shortRefs = (uint16_t)(rng() % 2);
+
+    std::vector<uint32_t> refs(meshlet.vertexCount);
+    std::iota(refs.begin(), refs.end(), 0u);
+    std::shuffle(refs.begin(), refs.end(), rng);
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+    {
+        const uint32_t ref = refs[i] * 7 + (meshlet.shortRefs ? 0 : 70000);
+        if (meshlet.shortRefs && i % 2)
+            geometry.meshletdata.back() |= ref << 16;
+        else
+            geometry.meshletdata.push_back(ref);
+    }
+
+    std::vector<uint8_t> triangles((meshlet.triangleCount * 3 + 3) & ~3, 0);
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+    {
+        uint32_t a = t, b = t + 1, c = t + 2;
+        if (t + 2 >= meshlet.vertexCount)
+        {
+            a = rng() % meshlet.vertexCount;
+            b = (a + 1 + rng() % (meshlet.vertexCount - 1)) % meshlet.vertexCount;
+            do
+                c = rng() % meshlet.vertexCount;
+            while (c == a || c == b);
+        }
+        triangles[t * 3 + 0] = (uint8_t)a;
+        triangles[t * 3 + 1] = (uint8_t)b;
+        triangles[t * 3 + 2] = (uint8_t)c;
+    }
+    const size_t wordOffset = geometry.meshletdata.size();
+    geometry.meshletdata.resize(wordOffset + triangles.size() / 4);
+    std::memcpy(geometry.meshletdata.data() + wordOffset, triangles.data(), triangles.size());
+
+    meshlet.center[0] = (uint16_t)rng();
+    meshlet.radius = (uint16_t)rng();
+    meshlet.cone_axis[1] = (int16_t)rng();
+    geometry.meshlets.push_back(meshlet);
+
+    for (uint32_t i = 0; i < meshlet.vertexCount * 4u; ++i)
+        geometry.meshletvtx0.push_back(i % 4 == 3 ? 0 : (uint16_t)rng());
+}
+
+NiagaraScene createScene()
+{
+    std::mt19937 rng(1234);
+    NiagaraScene scene;
+    NiagaraGeometry& geometry = scene.geometry;
+
+    for (uint32_t i = 0; i < kVertexCount; ++i)
+        geometry.vertices.push_back(randomBytes<NiagaraVertex>(rng));
+    for (uint32_t i = 0; i < kTriangleCount; ++i)
+    {
+        const uint32_t a = rng() % kVertexCount;
+        geometry.indices.insert(geometry.indices.end(), {a, (a + 1) % kVertexCount, (uint32_t)((a + 2 + rng() % 16) % kVertexCount)});
+    }
+    for (uint32_t i = 0; i < kMeshletCount; ++i)
+        addMeshlet(geometry, rng);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        geometry.meshes.push_back(randomBytes<NiagaraMesh>(rng));
+        scene.materials.push_back(randomBytes<NiagaraMaterial>(rng));
+        scene.draws.push_back(randomBytes<NiagaraMeshDraw>(rng));
+    }
+    scene.texturePaths = {"albedo.png", "", "textures/normal map.dds"};
+    scene.camera.position = float3(1.f, 2.f, 3.f);
+    scene.camera.orientation = quatf(0.f, 0.6f, 0.f, 0.8f);
+    scene.camera.fovY = 0.7f;
+    scene.camera.znear = 0.05f;
+    scene.sunDirection = float3(0.f, 0.8f, 0.6f);
+    return scene;
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& data)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size());
+}
+} // namespace
+
+CPU_TEST(NiagaraSceneCache_RoundTrip)
+{
+    const NiagaraScene expected = createScene();
+    const std::filesystem::path path = getTempFilePath();
+
+    ASSERT(saveNiagaraSceneCache(path, expected, false, true));
+    NiagaraScene scene;
+    ASSERT(loadNiagaraSceneCache(path, scene, false, true));
+
+    const NiagaraGeometry& geometry = scene.geometry;
+    EXPECT(isBitwiseEqual(geometry.vertices, expected.geometry.vertices));
+    EXPECT(getTriangles(geometry.indices) == getTriangles(expected.geometry.indices));
+    EXPECT(isBitwiseEqual(geometry.meshlets, expected.geometry.meshlets));
+    EXPECT_EQ(geometry.meshletdata.size(), expected.geometry.meshletdata.size());
+    if (geometry.meshlets.size() == expected.geometry.meshlets.size() && geometry.meshletdata.size() == expected.geometry.meshletdata.size())
+    {
+        for (size_t i = 0; i < geometry.meshlets.size(); ++i)
+        {
+            const NiagaraMeshlet& meshlet = expected.geometry.meshlets[i];
+            auto vertices = getMeshletVertices(meshlet, geometry.meshletdata);
+            auto expectedVertices = getMeshletVertices(meshlet, expected.geometry.meshletdata);
+            std::sort(vertices.begin(), vertices.end());
+            std::sort(expectedVertices.begin(), expectedVertices.end());
+            EXPECT(vertices == expectedVertices) << "meshlet=" << i;
+            EXPECT(getMeshletTriangles(meshlet, geometry.meshletdata) == getMeshletTriangles(meshlet, expected.geometry.meshletdata))
+                << "meshlet=" << i;
+        }
+    }
+    EXPECT(isBitwiseEqual(geometry.meshletvtx0, expected.geometry.meshletvtx0));
+    EXPECT(isBitwiseEqual(geometry.meshes, expected.geometry.meshes));
+    EXPECT(isBitwiseEqual(scene.materials, expected.materials));
+    EXPECT(isBitwiseEqual(scene.draws, expected.draws));
+    EXPECT(scene.texturePaths == expected.texturePaths);
+    EXPECT(std::memcmp(&scene.camera, &expected.camera, sizeof(NiagaraCamera)) == 0);
+    EXPECT(all(scene.sunDirection == expected.sunDirection));
+
+    // Caches built with a different meshlet configuration are not loaded.
+    EXPECT(!loadNiagaraSceneCache(path, scene, true, true));
+    EXPECT(!loadNiagaraSceneCache(path, scene, false, false));
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(NiagaraSceneCache_Invalid)
+{
+    const NiagaraScene expected = createScene();
+    const std::filesystem::path path = getTempFilePath();
+    ASSERT(saveNiagaraSceneCache(path, expected, false, false));
+    const std::string cache = readFile(path);
+
+    // Truncated chunk data.
+    writeFile(path, cache.substr(0, cache.size() - 100));
+    NiagaraScene scene;
+    EXPECT(!loadNiagaraSceneCache(path, scene, false, false));
+    EXPECT(scene.geometry.vertices.empty());
+
+    // Cache of another format.
+    std::string damaged = cache;
+    damaged[0] ^= 0xff;
+    writeFile(path, damaged);
+    EXPECT(!loadNiagaraSceneCache(path, scene, false, false));
+    EXPECT(scene.geometry.vertices.empty());
+
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
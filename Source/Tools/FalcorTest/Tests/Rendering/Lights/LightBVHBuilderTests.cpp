@@ -0,0 +1,271 @@
+#include "Testing/UnitTest.h"
+#include "Rendering/Lights/LightBVHBuilder.h"
+#include "Rendering/Lights/LightBVHSampler.h"
+#include "Scene/Lights/LightCollectionShared.slang"
+#include "Utils/Math/PackedFormats.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/** Generates a synthetic set of emissive triangles.
+    The triangles are scattered over a number of randomly placed and oriented patches, each with its own flux.
+*/
+std::vector<ILightCollection::MeshLightTriangle> generateTriangles(uint32_t triangleCount, uint32_t seed)
+{
+    const uint32_t kTrianglesPerPatch = 256;
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> u(0.f, 1.f);
+    auto randomDirection = [&]()
+    {
+        float z = 1.f - 2.f * u(rng);
+        float r = std::sqrt(std::max(0.f, 1.f - z * z));
+        float phi = 2.f * (float)M_PI * u(rng);
+        return float3(r * std::cos(phi), r * std::sin(phi), z);
+    };
+
+    std::vector<ILightCollection::MeshLightTriangle> triangles(triangleCount);
+    float3 patchCenter, patchNormal, tangent, bitangent;
+    float patchFlux = 0.f;
+    for (uint32_t i = 0; i < triangleCount; ++i)
+    {
+        if (i % kTrianglesPerPatch == 0)
+        {
+            patchCenter = float3(u(rng), u(rng), u(rng)) * 100.f;
+            patchNormal = randomDirection();
+            tangent = normalize(cross(patchNormal, std::abs(patchNormal.x) < 0.9f ? float3(1.f, 0.f, 0.f) : float3(0.f, 1.f, 0.f)));
+            bitangent = cross(patchNormal, tangent);
+            patchFlux = u(rng) < 0.1f ? 0.f : u(rng) * 10.f;
+        }
+
+        auto& triangle = triangles[i];
+        const float3 p = patchCenter + (u(rng) * tangent + u(rng) * bitangent) * 4.f;
+        triangle.vtx[0].pos = p;
+        triangle.vtx[1].pos = p + tangent * 0.1f;
+        triangle.vtx[2].pos = p + bitangent * 0.1f;
+        triangle.normal = patchNormal;
+        triangle.area = 0.005f;
+        triangle.flux = patchFlux * u(rng);
+    }
+    return triangles;
+}
+
+struct BuildResult
+{
+    std::vector<PackedNode> nodes;
+    std::vector<uint32_t> triangleIndices;
+    std::vector<uint64_t> triangleBitmasks;
+};
+
+BuildResult build(const std::vector<ILightCollection::MeshLightTriangle>& triangles, const LightBVHBuilder::Options& options)
+{
+    BuildResult result;
+    LightBVHBuilder builder(options);
+    builder.buildNodes(triangles, result.nodes, result.triangleIndices, result.triangleBitmasks);
+    return result;
+}
+
+/** Light collection holding a fixed set of emissive triangles, with only the data used to build and refit the BVH.
+*/
+class TestLightCollection : public ILightCollection
+{
+public:
+    TestLightCollection(ref<Device> pDevice, std::vector<MeshLightTriangle> triangles)
+        : mpDevice(pDevice)
+        , mTriangles(std::move(triangles))
+    {
+        mpTriangleData = mpDevice->createStructuredBuffer(sizeof(PackedEmissiveTriangle), (uint32_t)mTriangles.size(), ResourceBindFlags::ShaderResource);
+        uploadTriangles();
+        mStats.triangleCount = mStats.trianglesActive = (uint32_t)mTriangles.size();
+    }
+
+    /** Translates a range of triangles and updates their GPU data.
+    */
+    void moveTriangles(uint32_t triangleOffset, uint32_t triangleCount, float3 translation)
+    {
+        for (uint32_t i = triangleOffset; i < triangleOffset + triangleCount; ++i)
+        {
+            for (auto& vertex : mTriangles[i].vtx) vertex.pos += translation;
+        }
+        uploadTriangles();
+    }
+
+    const ref<Device>& getDevice() const override { return mpDevice; }
+    bool update(RenderContext* /*pRenderContext*/, UpdateStatus* /*pUpdateStatus*/) override { return false; }
+    void bindShaderData(const ShaderVar& var) const override
+    {
+        var["triangleCount"] = (uint32_t)mTriangles.size();
+        var["activeTriangleCount"] = (uint32_t)mTriangles.size();
+        var["meshCount"] = 0u;
+        var["triangleData"] = mpTriangleData;
+    }
+    uint32_t getTotalLightCount() const override { return (uint32_t)mTriangles.size(); }
+    const MeshLightStats& getStats(RenderContext* /*pRenderContext*/) const override { return mStats; }
+    const std::vector<MeshLightTriangle>& getMeshLightTriangles(RenderContext* /*pRenderContext*/) const override { return mTriangles; }
+    const std::vector<MeshLightData>& getMeshLights() const override { return mMeshLights; }
+    const std::vector<uint32_t>& getUpdatedLights() const override { return mUpdatedLights; }
+    void prepareSyncCPUData(RenderContext* /*pRenderContext*/) const override {}
+    uint64_t getMemoryUsageInBytes() const override { return mpTriangleData->getSize(); }
+    UpdateFlagsSignal::Interface getUpdateFlagsSignal() override { return mUpdateFlagsSignal.getInterface(); }
+
+private:
+    void uploadTriangles()
+    {
+        std::vector<PackedEmissiveTriangle> packedTriangles(mTriangles.size());
+        for (size_t i = 0; i < mTriangles.size(); ++i)
+        {
+            const MeshLightTriangle& triangle = mTriangles[i];
+            PackedEmissiveTriangle& packed = packedTriangles[i];
+            for (uint32_t j = 0; j < 3; ++j) packed.posAndTexCoords[j] = float4(triangle.vtx[j].pos, 0.f);
+            packed.normal = encodeNormal2x16(triangle.normal);
+            packed.area = asuint(triangle.area);
+            packed.materialID = 0;
+            packed.lightIdx = 0;
+        }
+        mpTriangleData->setBlob(packedTriangles.data(), 0, packedTriangles.size() * sizeof(PackedEmissiveTriangle));
+    }
+
+    ref<Device> mpDevice;
+    std::vector<MeshLightTriangle> mTriangles;
+    std::vector<MeshLightData> mMeshLights;
+    std::vector<uint32_t> mUpdatedLights;
+    MeshLightStats mStats;
+    ref<Buffer> mpTriangleData;
+    UpdateFlagsSignal mUpdateFlagsSignal;
+};
+} // namespace
+
+CPU_TEST(LightBVHBuilder_ParallelMatchesSerial)
+{
+    // Use enough triangles for the parallel paths (subtree tasks, chunked binning and partitioning) to be taken.
+    const auto triangles = generateTriangles(200000, 1);
+
+    for (auto heuristic : {LightBVHBuilder::SplitHeuristic::Equal, LightBVHBuilder::SplitHeuristic::BinnedSAH, LightBVHBuilder::SplitHeuristic::BinnedSAOH})
+    {
+        LightBVHBuilder::Options options;
+        options.splitHeuristicSelection = heuristic;
+
+        options.useParallelBuild = false;
+        const BuildResult serial = build(triangles, options);
+        options.useParallelBuild = true;
+        const BuildResult parallel = build(triangles, options);
+
+        EXPECT(!serial.nodes.empty());
+        EXPECT_EQ(serial.nodes.size(), parallel.nodes.size());
+        EXPECT(serial.triangleIndices == parallel.triangleIndices);
+        EXPECT(serial.triangleBitmasks == parallel.triangleBitmasks);
+        if (serial.nodes.size() == parallel.nodes.size())
+        {
+            EXPECT(std::memcmp(serial.nodes.data(), parallel.nodes.data(), serial.nodes.size() * sizeof(PackedNode)) == 0);
+        }
+
+        // Each included triangle is referenced by exactly one leaf.
+        std::vector<uint32_t> sortedIndices = serial.triangleIndices;
+        std::sort(sortedIndices.begin(), sortedIndices.end());
+        EXPECT(std::adjacent_find(sortedIndices.begin(), sortedIndices.end()) == sortedIndices.end());
+        for (uint32_t triangleIdx : sortedIndices)
+            EXPECT_GT(triangles[triangleIdx].flux, 0.f);
+    }
+}
+
+CPU_TEST(LightBVHBuilder_WideTree)
+{
+    const auto triangles = generateTriangles(20000, 4);
+
+    for (uint32_t branchingFactor : {2u, 4u, 8u})
+    {
+        LightBVHBuilder::Options options;
+        options.branchingFactor = branchingFactor;
+        const BuildResult result = build(triangles, options);
+        EXPECT(!result.nodes.empty());
+
+        // Each node has at most 'branchingFactor' children, which are stored after their parent, and each node has a single parent.
+        std::vector<uint32_t> parentCount(result.nodes.size(), 0);
+        for (uint32_t nodeIdx = 0; nodeIdx < result.nodes.size(); ++nodeIdx)
+        {
+            if (result.nodes[nodeIdx].isLeaf()) continue;
+            const InternalNode node = result.nodes[nodeIdx].getInternalNode();
+            EXPECT_GE(node.childCount, 2u);
+            EXPECT_LE(node.childCount, branchingFactor);
+            EXPECT_GT(node.firstChildIdx, nodeIdx);
+            EXPECT_LE(node.firstChildIdx + node.childCount, result.nodes.size());
+            for (uint32_t i = 0; i < node.childCount; ++i) parentCount[node.firstChildIdx + i]++;
+        }
+        EXPECT_EQ(parentCount[0], 0u);
+        for (uint32_t nodeIdx = 1; nodeIdx < result.nodes.size(); ++nodeIdx) EXPECT_EQ(parentCount[nodeIdx], 1u) << "nodeIdx=" << nodeIdx;
+
+        // The bitmask of each triangle leads to the leaf containing it.
+        const uint32_t bitsPerLevel = LightBVHBuilder::getBitmaskBitsPerLevel(branchingFactor);
+        for (uint32_t i = 0; i < result.triangleIndices.size(); i += 97)
+        {
+            const uint32_t triangleIdx = result.triangleIndices[i];
+            uint64_t bitmask = result.triangleBitmasks[triangleIdx];
+            uint32_t nodeIdx = 0;
+            while (!result.nodes[nodeIdx].isLeaf())
+            {
+                nodeIdx = result.nodes[nodeIdx].getInternalNode().firstChildIdx + (uint32_t)(bitmask & ((1ull << bitsPerLevel) - 1));
+                bitmask >>= bitsPerLevel;
+            }
+            const LeafNode leaf = result.nodes[nodeIdx].getLeafNode();
+            EXPECT(leaf.triangleOffset <= i && i < leaf.triangleOffset + leaf.triangleCount) << "triangleIdx=" << triangleIdx;
+        }
+
+        // The traversal probabilities of the leaves sum to one.
+        std::vector<float> nodeProbabilities;
+        LightBVHSampler::computeTraversalProbabilities(result.nodes, float3(50.f), float3(0.f, 1.f, 0.f), false, LightBVHSampler::Options(), nodeProbabilities);
+        double leafProbabilitySum = 0.0;
+        for (uint32_t nodeIdx = 0; nodeIdx < result.nodes.size(); ++nodeIdx)
+        {
+            if (result.nodes[nodeIdx].isLeaf()) leafProbabilitySum += nodeProbabilities[nodeIdx];
+        }
+        EXPECT_LE(std::abs(leafProbabilitySum - 1.0), 1e-3);
+    }
+}
+
+GPU_TEST(LightBVH_RefitDirtyAndRebuild)
+{
+    const uint32_t kTrianglesPerPatch = 256;
+    const auto triangles = generateTriangles(4 * 1024, 6);
+    const LightBVHBuilder::Options options;
+    const float builtTreeCost = LightBVHBuilder::evalTreeCost(build(triangles, options).nodes, options);
+
+    // Move the first patch that is not culled far away from the others, which degrades the refit tree.
+    uint32_t movedOffset = 0;
+    while (triangles[movedOffset].flux == 0.f) movedOffset += kTrianglesPerPatch;
+    const float3 translation = float3(500.f, 0.f, 0.f);
+
+    float relativeTreeCosts[2] = {};
+    for (bool refitOnCPU : {false, true})
+    {
+        auto pLightCollection = make_ref<TestLightCollection>(ctx.getDevice(), triangles);
+        LightBVHBuilder builder(options);
+        LightBVH bvh(ctx.getDevice(), pLightCollection);
+        builder.build(ctx.getRenderContext(), bvh);
+        EXPECT(bvh.isValid());
+        EXPECT_EQ(bvh.getRelativeTreeCost(), 1.f);
+
+        pLightCollection->moveTriangles(movedOffset, kTrianglesPerPatch, translation);
+        bvh.markTrianglesDirty(movedOffset, kTrianglesPerPatch);
+        EXPECT(bvh.hasDirtyNodes());
+        bvh.refitDirty(ctx.getRenderContext(), refitOnCPU);
+        EXPECT(!bvh.hasDirtyNodes());
+
+        // The cost of the refit nodes is tracked on both refit paths.
+        const float relativeTreeCost = bvh.getRelativeTreeCost();
+        EXPECT_NE(relativeTreeCost, 1.f) << "refitOnCPU=" << refitOnCPU;
+        relativeTreeCosts[refitOnCPU ? 1 : 0] = relativeTreeCost;
+
+        // Rebuilding resets the relative cost and finds a better tree than the refit one.
+        const auto& movedTriangles = pLightCollection->getMeshLightTriangles(ctx.getRenderContext());
+        EXPECT_LT(LightBVHBuilder::evalTreeCost(build(movedTriangles, options).nodes, options), relativeTreeCost * builtTreeCost);
+        builder.build(ctx.getRenderContext(), bvh);
+        EXPECT(bvh.isValid());
+        EXPECT_EQ(bvh.getRelativeTreeCost(), 1.f);
+    }
+
+    // Both refit paths produce the same nodes.
+    EXPECT_LE(std::abs(relativeTreeCosts[0] - relativeTreeCosts[1]), 1e-3f * relativeTreeCosts[1]);
+}
+} // namespace Falcor
@@ -110,8 +110,118 @@ void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> spec
         }
     }
 }
+
+std::vector<float> generateWeights(uint32_t N, std::mt19937& rng)
+{
+    // Mostly uniform weights, with a few zeros and a few large outliers.
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float> weights(N);
+    for (auto& weight : weights)
+    {
+        const float u = uniform(rng);
+        weight = u < 0.01f ? 0.f : (u < 0.011f ? 1000.f * uniform(rng) : uniform(rng));
+    }
+    return weights;
+}
+
+// Returns the probability of sampling each item, as implied by the alias table items.
+std::vector<double> computeProbabilities(const std::vector<AliasTable::Item>& items)
+{
+    const size_t N = items.size();
+    std::vector<double> probabilities(N, 0.0);
+    for (const auto& item : items)
+    {
+        probabilities[item.indexB] += item.threshold / (double)N;
+        probabilities[item.indexA] += (1.0 - item.threshold) / (double)N;
+    }
+    return probabilities;
+}
 } // namespace
 
+CPU_TEST(AliasTable_BuildItems)
+{
+    std::mt19937 rng;
+
+    // Use enough weights for the parallel build to use multiple chunks.
+    for (uint32_t N : {1u, 2u, 1000u, 200000u})
+    {
+        const std::vector<float> weights = generateWeights(N, rng);
+        double weightSum = 0.0;
+        for (float weight : weights)
+            weightSum += weight;
+
+        for (bool useDoublePrecision : {false, true})
+        {
+            AliasTable::Options options;
+            options.useDoublePrecision = useDoublePrecision;
+
+            std::vector<AliasTable::Item> serialItems, parallelItems;
+            options.useParallelBuild = false;
+            const double serialWeightSum = AliasTable::buildItems(weights, options, serialItems);
+            options.useParallelBuild = true;
+            const double parallelWeightSum = AliasTable::buildItems(weights, options, parallelItems);
+
+            EXPECT_EQ(serialWeightSum, parallelWeightSum);
+            EXPECT_LE(std::abs(serialWeightSum - weightSum), 1e-9 * weightSum);
+            ASSERT_EQ(serialItems.size(), N);
+            ASSERT_EQ(parallelItems.size(), N);
+            EXPECT(std::memcmp(serialItems.data(), parallelItems.data(), N * sizeof(AliasTable::Item)) == 0);
+
+            for (uint32_t i = 0; i < N; ++i)
+            {
+                EXPECT_EQ(serialItems[i].indexB, i);
+                EXPECT_LT(serialItems[i].indexA, N);
+                EXPECT(serialItems[i].threshold >= 0.f && serialItems[i].threshold <= 1.f);
+            }
+
+            // The table samples each item proportionally to its weight. The error is relative to the average probability.
+            // Single precision accumulates a larger error, so only check the largest table with double precision.
+            const std::vector<double> probabilities = computeProbabilities(serialItems);
+            double maxError = 0.0;
+            for (uint32_t i = 0; i < N; ++i)
+                maxError = std::max(maxError, std::abs(probabilities[i] - weights[i] / weightSum) * N);
+            if (useDoublePrecision)
+                EXPECT_LE(maxError, 1e-5) << "N=" << N;
+            else if (N <= 1000)
+                EXPECT_LE(maxError, 1e-3) << "N=" << N;
+        }
+    }
+}
+
+CPU_TEST(AliasTable_Sampling)
+{
+    const uint32_t N = 1000;
+    const uint32_t samplesPerWeight = 10000;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+    const std::vector<float> weights = generateWeights(N, rng);
+
+    std::vector<AliasTable::Item> items;
+    const double weightSum = AliasTable::buildItems(weights, AliasTable::Options(), items);
+
+    // Sample the table the same way as AliasTable.slang.
+    std::vector<uint32_t> histogram(N, 0);
+    for (uint32_t i = 0; i < N * samplesPerWeight; ++i)
+    {
+        const AliasTable::Item& item = items[std::min(N - 1, (uint32_t)(uniform(rng) * N))];
+        histogram[uniform(rng) >= item.threshold ? item.indexA : item.indexB]++;
+    }
+
+    // Verify histogram using a chi-square test.
+    std::vector<double> expFrequencies(N);
+    std::vector<double> obsFrequencies(N);
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        expFrequencies[i] = (weights[i] / weightSum) * N * samplesPerWeight;
+        obsFrequencies[i] = (double)histogram[i];
+    }
+    const auto& [success, report] = hypothesis::chi2_test(N, obsFrequencies.data(), expFrequencies.data(), N * samplesPerWeight, 5, 0.1);
+    if (!success)
+        std::cout << report << std::endl;
+    EXPECT(success);
+}
+
 GPU_TEST(AliasTable)
 {
     testAliasTable(ctx, 1, {1.f});
@@ -0,0 +1,118 @@
+#include "Testing/UnitTest.h"
+#include "Scene/Volume/BC4Encode.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+/** Generates tiles with random, constant, narrow range, gradient and 0/255 outlier content.
+*/
+std::vector<uint8_t> generateTiles(size_t count)
+{
+    std::mt19937 rng(1234);
+    std::vector<uint8_t> tiles(count * 16);
+    for (size_t t = 0; t < count; ++t)
+    {
+        const int base = rng() % 256;
+        const int span = rng() % 64 + 1;
+        for (int i = 0; i < 16; ++i)
+        {
+            int value = 0;
+            switch (t % 5)
+            {
+            case 0: value = rng() % 256; break;
+            case 1: value = base; break;
+            case 2: value = std::min(255, base + int(rng() % span)); break;
+            case 3: value = (rng() % 4 == 0) ? (rng() % 2 ? 0 : 255) : base; break;
+            case 4: value = base * i / 15; break;
+            }
+            tiles[t * 16 + i] = (uint8_t)value;
+        }
+    }
+    return tiles;
+}
+
+/** Decodes a BC4 block and returns the squared error and the max absolute error with respect to the tile.
+*/
+void computeError(const uint8_t* tile, uint64_t block, int& squaredError, int& maxError)
+{
+    int alpha0 = block & 0xff;
+    int alpha1 = (block >> 8) & 0xff;
+    int codes[8] = {alpha0, alpha1};
+    if (alpha0 > alpha1)
+    {
+        for (int i = 2; i < 8; ++i)
+            codes[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+            codes[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+        codes[6] = 0;
+        codes[7] = 255;
+    }
+
+    squaredError = 0;
+    maxError = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int error = std::abs(int(tile[i]) - codes[(block >> (16 + 3 * i)) & 7]);
+        squaredError += error * error;
+        maxError = std::max(maxError, error);
+    }
+}
+
+std::vector<uint64_t> encodeReference(std::vector<uint8_t> tiles)
+{
+    std::vector<uint64_t> blocks(tiles.size() / 16);
+    for (size_t i = 0; i < blocks.size(); ++i)
+        CompressAlphaDxt5(&tiles[i * 16], &blocks[i]);
+    return blocks;
+}
+} // namespace
+
+CPU_TEST(BC4Encode_MatchesReference)
+{
+    const std::vector<uint8_t> tiles = generateTiles(10000);
+    const std::vector<uint64_t> expected = encodeReference(tiles);
+
+    std::vector<uint64_t> blocks(expected.size());
+    encodeBC4Blocks(tiles.data(), blocks.data(), blocks.size());
+    EXPECT(blocks == expected);
+
+    std::vector<uint64_t> parallelBlocks(expected.size());
+    encodeBC4BlocksParallel(tiles.data(), parallelBlocks.data(), parallelBlocks.size());
+    EXPECT(parallelBlocks == expected);
+}
+
+CPU_TEST(BC4Encode_Quality)
+{
+    const std::vector<uint8_t> tiles = generateTiles(10000);
+    const std::vector<uint64_t> expected = encodeReference(tiles);
+
+    std::vector<uint64_t> highBlocks(expected.size());
+    std::vector<uint64_t> fastBlocks(expected.size());
+    encodeBC4Blocks(tiles.data(), highBlocks.data(), highBlocks.size(), BC4Quality::High);
+    encodeBC4Blocks(tiles.data(), fastBlocks.data(), fastBlocks.size(), BC4Quality::Fast);
+
+    int fastMax = 0;
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        int referenceError, highError, fastError, maxError, fastMaxError;
+        computeError(&tiles[i * 16], expected[i], referenceError, maxError);
+        computeError(&tiles[i * 16], highBlocks[i], highError, maxError);
+        computeError(&tiles[i * 16], fastBlocks[i], fastError, fastMaxError);
+
+        // The high quality encoder only accepts endpoints that reduce the error.
+        EXPECT_LE(highError, referenceError) << "tile " << i;
+        fastMax = std::max(fastMax, fastMaxError);
+    }
+
+    // The 8-value codebook spans the tile's range with at most 37 between codes.
+    EXPECT_LE(fastMax, 19);
+}
+} // namespace Falcor
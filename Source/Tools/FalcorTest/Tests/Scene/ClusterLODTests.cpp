@@ -0,0 +1,140 @@
+#include "Testing/UnitTest.h"
+#include "Scene/ClusterLOD.h"
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+/** Generates a unit square grid with noisy heights, so that every simplification introduces an error.
+*/
+void generateGrid(uint32_t n, std::vector<uint32_t>& indices, std::vector<float3>& positions)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> noise(0.f, 0.02f);
+    positions.clear();
+    for (uint32_t y = 0; y <= n; ++y)
+        for (uint32_t x = 0; x <= n; ++x)
+            positions.push_back(float3((float)x / n, noise(rng), (float)y / n));
+
+    indices.clear();
+    for (uint32_t y = 0; y < n; ++y)
+    {
+        for (uint32_t x = 0; x < n; ++x)
+        {
+            const uint32_t i = y * (n + 1) + x;
+            indices.insert(indices.end(), {i, i + n + 1, i + 1, i + 1, i + n + 1, i + n + 2});
+        }
+    }
+}
+
+std::vector<uint32_t> getClusterIndices(const MeshClusterLOD& clusterLOD, const std::vector<uint32_t>& selected)
+{
+    std::vector<uint32_t> indices;
+    for (uint32_t i : selected)
+    {
+        const auto& cluster = clusterLOD.clusters[i];
+        for (uint32_t j = 0; j < cluster.triangleCount * 3; ++j)
+            indices.push_back(clusterLOD.vertices[cluster.vertexOffset + clusterLOD.triangles[cluster.triangleOffset + j]]);
+    }
+    return indices;
+}
+
+/** Returns the edges used by a single triangle. A crack in a cut shows up as an additional boundary edge.
+*/
+std::set<std::pair<uint32_t, uint32_t>> getBoundaryEdges(const std::vector<uint32_t>& indices)
+{
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeCount;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (size_t e = 0; e < 3; ++e)
+        {
+            uint32_t a = indices[i + e];
+            uint32_t b = indices[i + (e + 1) % 3];
+            edgeCount[{std::min(a, b), std::max(a, b)}]++;
+        }
+    }
+
+    std::set<std::pair<uint32_t, uint32_t>> boundary;
+    for (const auto& [edge, count] : edgeCount)
+        if (count == 1)
+            boundary.insert(edge);
+    return boundary;
+}
+} // namespace
+
+CPU_TEST(ClusterLOD_Build)
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3> positions;
+    generateGrid(64, indices, positions);
+
+    const ClusterLODBuilder::Options options;
+    const MeshClusterLOD clusterLOD = ClusterLODBuilder::build(indices, positions, options);
+    EXPECT_GT(clusterLOD.levelCount, 1u);
+
+    size_t levelZeroTriangleCount = 0;
+    uint32_t rootCount = 0;
+    for (const auto& cluster : clusterLOD.clusters)
+    {
+        EXPECT_LE(cluster.vertexCount, options.maxVerticesPerCluster);
+        EXPECT_LE(cluster.triangleCount, options.maxTrianglesPerCluster);
+        EXPECT_LE(cluster.self.error, cluster.parent.error);
+        if (cluster.level == 0)
+        {
+            EXPECT_EQ(cluster.self.error, 0.f);
+            levelZeroTriangleCount += cluster.triangleCount;
+        }
+        if (std::isinf(cluster.parent.error))
+        {
+            rootCount++;
+            continue;
+        }
+
+        // The parent bounds contain the cluster's bounds, so that the projected error is monotonic.
+        EXPECT_LE(length(cluster.self.center - cluster.parent.center) + cluster.self.radius, cluster.parent.radius * 1.0001f + 1e-6f);
+        EXPECT_GT(cluster.parent.error, 0.f);
+    }
+    EXPECT_EQ(levelZeroTriangleCount, indices.size() / 3);
+    EXPECT_GT(rootCount, 0u);
+}
+
+CPU_TEST(ClusterLOD_SelectClusters)
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3> positions;
+    generateGrid(64, indices, positions);
+
+    const MeshClusterLOD clusterLOD = ClusterLODBuilder::build(indices, positions, ClusterLODBuilder::Options());
+    const float projectionScale = ClusterLODBuilder::computeProjectionScale(static_cast<float>(M_PI) / 3.f, 1080);
+    const auto boundaryEdges = getBoundaryEdges(indices);
+    const float4x4 worldMatrix = float4x4::identity();
+    std::vector<uint32_t> selected;
+
+    // A zero threshold selects the full resolution mesh.
+    ClusterLODBuilder::selectClusters(clusterLOD, worldMatrix, float3(0.5f, 2.f, 0.5f), projectionScale, 0.f, selected);
+    for (uint32_t i : selected)
+        EXPECT_EQ(clusterLOD.clusters[i].level, 0u);
+    EXPECT_EQ(getClusterIndices(clusterLOD, selected).size(), indices.size());
+
+    // An infinite threshold selects the roots of the DAG.
+    ClusterLODBuilder::selectClusters(clusterLOD, worldMatrix, float3(0.5f, 2.f, 0.5f), projectionScale, std::numeric_limits<float>::max(), selected);
+    for (uint32_t i : selected)
+        EXPECT(std::isinf(clusterLOD.clusters[i].parent.error));
+    auto rootIndices = getClusterIndices(clusterLOD, selected);
+    EXPECT_LT(rootIndices.size(), indices.size());
+    EXPECT(getBoundaryEdges(rootIndices) == boundaryEdges);
+
+    // A camera close to a corner selects a mix of levels without cracks.
+    ClusterLODBuilder::selectClusters(clusterLOD, worldMatrix, float3(0.f, 0.05f, 0.f), projectionScale, 1.f, selected);
+    std::set<uint32_t> levels;
+    for (uint32_t i : selected)
+        levels.insert(clusterLOD.clusters[i].level);
+    EXPECT_GT(levels.size(), (size_t)1);
+    EXPECT(getBoundaryEdges(getClusterIndices(clusterLOD, selected)) == boundaryEdges);
+}
+} // namespace Falcor
@@ -0,0 +1,224 @@
+#include "Testing/UnitTest.h"
+#include "Scene/Curves/CurveLOD.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Material/StandardMaterial.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+struct Strands
+{
+    std::vector<uint32_t> vertexCounts;
+    std::vector<float3> controlPoints;
+    std::vector<float> widths;
+};
+
+/** Generates a grid of parallel strands. Curved strands follow a circular arc, straight strands a line.
+*/
+Strands generateStrands(uint32_t gridSize, uint32_t vertexCount, bool curved)
+{
+    Strands strands;
+    for (uint32_t y = 0; y < gridSize; y++)
+    {
+        for (uint32_t x = 0; x < gridSize; x++)
+        {
+            const float3 root(0.01f * x, 0.f, 0.01f * y);
+            strands.vertexCounts.push_back(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                const float t = (float)i / (float)(vertexCount - 1);
+                const float3 offset = curved ? float3(0.5f * (1.f - std::cos(3.f * t)), 0.5f * std::sin(3.f * t), 0.f) : float3(0.f, t, 0.f);
+                strands.controlPoints.push_back(root + offset);
+                strands.widths.push_back(0.002f);
+            }
+        }
+    }
+    return strands;
+}
+
+std::vector<CurveLODLevel> buildLevels(const Strands& strands)
+{
+    return CurveLODBuilder::build(
+        (uint32_t)strands.vertexCounts.size(), strands.vertexCounts.data(), strands.controlPoints.data(), strands.widths.data(), nullptr,
+        CurveLODBuilder::Options()
+    );
+}
+
+float getWidthSum(const CurveLODLevel& level)
+{
+    // Sum of the average width of each strand, i.e., the coverage of non-overlapping strands per unit length.
+    float sum = 0.f;
+    uint32_t offset = 0;
+    for (uint32_t vertexCount : level.vertexCountsPerStrand)
+    {
+        float strandSum = 0.f;
+        for (uint32_t i = 0; i < vertexCount; i++)
+            strandSum += level.widths[offset + i];
+        sum += strandSum / (float)vertexCount;
+        offset += vertexCount;
+    }
+    return sum;
+}
+
+CurveID addSegmentCurve(SceneBuilder& builder, ref<Material> pMaterial)
+{
+    const uint32_t indices[] = {0};
+    const float3 positions[] = {float3(0.f), float3(0.f, 1.f, 0.f)};
+    const float radius[] = {0.01f, 0.01f};
+
+    SceneBuilder::Curve curve;
+    curve.vertexCount = 2;
+    curve.indexCount = 1;
+    curve.pIndices = indices;
+    curve.pMaterial = pMaterial;
+    curve.positions.pData = positions;
+    curve.radius.pData = radius;
+    return builder.addCurve(curve);
+}
+
+/** Adds a curve LOD chain of two single-segment curves.
+*/
+std::vector<CurveID> addCurveChain(SceneBuilder& builder, ref<Material> pMaterial)
+{
+    const std::vector<CurveID> curveIDs = {addSegmentCurve(builder, pMaterial), addSegmentCurve(builder, pMaterial)};
+    builder.addCurveLOD(curveIDs, {0.f, 0.01f});
+    return curveIDs;
+}
+
+/** Creates a scene with one instance of a curve LOD chain per distance from the camera.
+*/
+ref<Scene> createCurveLODScene(ref<Device> pDevice, const std::vector<float>& distances)
+{
+    SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::None);
+    const std::vector<CurveID> curveIDs = addCurveChain(builder, StandardMaterial::create(pDevice, "curve"));
+    for (float distance : distances)
+    {
+        SceneBuilder::Node node;
+        node.name = "curves";
+        node.transform = math::matrixFromTranslation(float3(0.f, 0.f, -distance));
+        const NodeID nodeID = builder.addNode(node);
+        for (CurveID curveID : curveIDs)
+            builder.addCurveInstance(nodeID, curveID);
+    }
+
+    ref<Camera> pCamera = Camera::create("camera");
+    pCamera->setPosition(float3(0.f));
+    pCamera->setTarget(float3(0.f, 0.f, -1.f));
+    builder.addCamera(pCamera);
+    return builder.getScene();
+}
+} // namespace
+
+CPU_TEST(CurveLOD_Levels)
+{
+    const Strands strands = generateStrands(32, 16, true);
+    const auto levels = buildLevels(strands);
+
+    EXPECT_EQ(levels.size(), CurveLODBuilder::Options().maxLevelCount);
+    EXPECT(levels[0].vertexCountsPerStrand == strands.vertexCounts);
+    EXPECT(std::memcmp(levels[0].controlPoints.data(), strands.controlPoints.data(), strands.controlPoints.size() * sizeof(float3)) == 0);
+    EXPECT(levels[0].widths == strands.widths);
+    EXPECT_EQ(levels[0].error, 0.f);
+
+    const float widthSum = getWidthSum(levels[0]);
+    for (size_t i = 1; i < levels.size(); i++)
+    {
+        EXPECT_LT(levels[i].getStrandCount(), levels[i - 1].getStrandCount());
+        EXPECT_LT(levels[i].controlPoints.size(), levels[i - 1].controlPoints.size());
+        EXPECT_GE(levels[i].error, levels[i - 1].error);
+        EXPECT_EQ(levels[i].controlPoints.size(), levels[i].widths.size());
+        EXPECT(levels[i].UVs.empty());
+
+        // Kept strands are widened to preserve the coverage of their clusters.
+        EXPECT_LE(std::abs(getWidthSum(levels[i]) - widthSum), 1e-3f * widthSum);
+    }
+}
+
+CPU_TEST(CurveLOD_CurvatureAwareSimplification)
+{
+    const auto straight = buildLevels(generateStrands(16, 16, false));
+    const auto curved = buildLevels(generateStrands(16, 16, true));
+
+    // Straight strands collapse to a single segment while curved strands keep control points along the arc.
+    for (uint32_t vertexCount : straight[1].vertexCountsPerStrand)
+        EXPECT_EQ(vertexCount, 2u);
+    for (uint32_t vertexCount : curved[1].vertexCountsPerStrand)
+        EXPECT_GT(vertexCount, 2u);
+}
+
+CPU_TEST(CurveLOD_SelectLevel)
+{
+    const std::vector<float> errors = {0.f, 0.01f, 0.02f, 0.04f};
+    const AABB bounds(float3(-1.f), float3(1.f));
+    const float projectionScale = 1000.f;
+
+    auto select = [&](float distance)
+    {
+        return CurveLODBuilder::selectLevel(errors, bounds, float4x4::identity(), float3(0.f, 0.f, distance), projectionScale, 1.f);
+    };
+
+    // The camera is inside the bounds.
+    EXPECT_EQ(select(0.f), 0u);
+    EXPECT_EQ(select(5.f), 0u);
+    EXPECT_EQ(select(100.f), 3u);
+
+    uint32_t prevLevel = 0;
+    for (float distance = 2.f; distance < 100.f; distance *= 1.5f)
+    {
+        const uint32_t level = select(distance);
+        EXPECT_GE(level, prevLevel);
+        prevLevel = level;
+    }
+}
+
+GPU_TEST(CurveLOD_SceneInstances)
+{
+    auto selectLevel = [&](const std::vector<float>& distances)
+    {
+        ref<Scene> pScene = createCurveLODScene(ctx.getDevice(), distances);
+        if (pScene == nullptr || pScene->getCurveLODs().size() != 1)
+            return ~0u;
+
+        // Changing the settings selects the levels on the next update.
+        auto settings = pScene->getCurveLODSettings();
+        settings.errorThreshold = 2.f;
+        pScene->setCurveLODSettings(settings);
+        pScene->update(ctx.getRenderContext(), 0.0);
+        return pScene->getCurveLODLevel(0);
+    };
+
+    EXPECT_EQ(selectLevel({1.f}), 0u);
+    EXPECT_EQ(selectLevel({1e5f}), 1u);
+
+    // The chain is shared by its instances, which all get the finest level any of them needs.
+    EXPECT_EQ(selectLevel({1e5f, 1.f}), 0u);
+    EXPECT_EQ(selectLevel({1.f, 1e5f}), 0u);
+}
+
+GPU_TEST(CurveLOD_VertexCache)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    ref<Material> pMaterial = StandardMaterial::create(pDevice, "curve");
+
+    // Vertex caches rewrite the AABBs of all curve segments on the GPU, which would show the hidden levels of a chain.
+    {
+        SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::None);
+        const std::vector<CurveID> curveIDs = addCurveChain(builder, pMaterial);
+        CachedCurve cache;
+        cache.geometryID = CurveOrMeshID{curveIDs[1]};
+        EXPECT_THROW(builder.addCachedCurve(std::move(cache)));
+    }
+    {
+        SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::None);
+        const CurveID curveID = addSegmentCurve(builder, pMaterial);
+        CachedCurve cache;
+        cache.geometryID = CurveOrMeshID{curveID};
+        builder.addCachedCurve(std::move(cache));
+        EXPECT_THROW(builder.addCurveLOD({curveID, addSegmentCurve(builder, pMaterial)}, {0.f, 0.01f}));
+    }
+}
+} // namespace Falcor
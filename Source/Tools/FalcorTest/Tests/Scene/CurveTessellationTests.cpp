@@ -0,0 +1,496 @@
+#include "Testing/UnitTest.h"
+#include "Scene/Curves/CurveTessellation.h"
+#include "Core/Error.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Math/CubicSpline.h"
+#include "Utils/Math/MathHelpers.h"
+#include "Utils/Math/Quaternion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+struct Strands
+{
+    std::vector<uint32_t> vertexCounts;
+    std::vector<uint32_t> offsets;
+    std::vector<float3> controlPoints;
+    std::vector<float> widths;
+    std::vector<float2> UVs;
+};
+
+/** Generates random strands. Some control points are duplicated, so the strands shrink by different amounts when tessellated.
+*/
+Strands generateStrands(uint32_t strandCount)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    Strands strands;
+    for (uint32_t i = 0; i < strandCount; i++)
+    {
+        const uint32_t vertexCount = 2 + rng() % 12;
+        strands.vertexCounts.push_back(vertexCount);
+        strands.offsets.push_back((uint32_t)strands.controlPoints.size());
+        float3 p(u(rng), u(rng), u(rng));
+        for (uint32_t j = 0; j < vertexCount; j++)
+        {
+            if (j <= 1 || rng() % 4 != 0)
+                p += float3(0.1f + 0.05f * u(rng), 0.05f * u(rng), 0.05f * u(rng));
+            strands.controlPoints.push_back(p);
+            strands.widths.push_back(0.01f + 0.005f * u(rng));
+            strands.UVs.push_back(float2(u(rng), u(rng)));
+        }
+    }
+    return strands;
+}
+
+/** Serial tessellation as implemented before the strands were tessellated in parallel.
+    The parallel implementation must produce bitwise identical results.
+*/
+namespace reference
+{
+struct StrandArrays {
+    fast_vector<float3> controlPoints;
+    fast_vector<float>  widths;
+    fast_vector<float2> UVs;
+    uint32_t vertexCount { 0 };
+};
+
+struct CurveArrays {
+    const float3* controlPoints;
+    const float* widths;
+    const float2* UVs;
+
+    // Initializer
+    CurveArrays(const float3* paramControlPoints, const float* paramWidths, const float2* paramUVs)
+    {
+        controlPoints = paramControlPoints;
+        widths = paramWidths;
+        UVs = paramUVs;
+    }
+};
+
+struct CubicSplineCache
+{
+    CubicSpline<float3> optSplinePoints;
+    CubicSpline<float>  optSplineWidths;
+    CubicSpline<float2> optSplineUVs;
+
+    CubicSpline<float3> splinePoints;
+    CubicSpline<float>  splineWidths;
+    CubicSpline<float2> splineUVs;
+};
+
+// Curves tessellated to quad-tubes have the width somewhere between curveWidth and (curveWidth / sqrt(2)), depending on the viewing angle.
+// To achieve curveWidth on average, however, we need to scale the initial curveWidth by 1.11 (the number was deducted numerically).
+const float kMeshCompensationScale = 1.11f;
+
+float4 transformSphere(const float4x4& xform, const float4& sphere)
+{
+    // Spheres are represented as (center.x, center.y, center.z, radius).
+    // Assume the scaling is isotropic, i.e., the end points are still spheres after transformation.
+    float  scale = std::sqrt(xform[0][0] * xform[0][0] + xform[0][1] * xform[0][1] + xform[0][2] * xform[0][2]);
+    float3 xyz = transformPoint(xform, sphere.xyz());
+    return float4(xyz, sphere.w * scale);
+}
+
+/// Sanitize radius so it is never 0, as non-zero radius is used to distinguish
+/// between mesh-from-curves and native mesh, which is used intersection and epsilon calculations.
+inline float sanitizeWidth(float w)
+{
+    return std::max(w, (float)std::numeric_limits<float16_t>::min());
+}
+
+void optimizeStrandGeometry(CubicSplineCache& splineCache, const CurveArrays& curveArrays, StrandArrays& strandArrays, StrandArrays& optimizedStrandArrays, uint32_t pointOffset, uint32_t subdivPerSegment, uint32_t keepOneEveryXVerticesPerStrand, float widthScale)
+{
+    strandArrays.controlPoints.clear();
+    strandArrays.UVs.clear();
+    strandArrays.widths.clear();
+
+    // Optimize geometry by removing duplicates.
+    for (uint32_t j = 0; j < strandArrays.vertexCount - 1; j++)
+    {
+        if (any(curveArrays.controlPoints[pointOffset + j] != curveArrays.controlPoints[pointOffset + j + 1]))
+        {
+            strandArrays.controlPoints.push_back(curveArrays.controlPoints[pointOffset + j]);
+            strandArrays.widths.push_back(curveArrays.widths[pointOffset + j]);
+            if (curveArrays.UVs) strandArrays.UVs.push_back(curveArrays.UVs[pointOffset + j]);
+        }
+    }
+
+    // Add the last control point.
+    strandArrays.controlPoints.push_back(curveArrays.controlPoints[pointOffset + strandArrays.vertexCount - 1]);
+    strandArrays.widths.push_back(curveArrays.widths[pointOffset + strandArrays.vertexCount - 1]);
+    if (curveArrays.UVs) strandArrays.UVs.push_back(curveArrays.UVs[pointOffset + strandArrays.vertexCount - 1]);
+
+    optimizedStrandArrays.vertexCount = static_cast<uint32_t>(strandArrays.controlPoints.size());
+
+    const CubicSpline<float3>& splinePoints = splineCache.optSplinePoints.setup(strandArrays.controlPoints.data(), optimizedStrandArrays.vertexCount);
+    const CubicSpline<float>& splineWidths = splineCache.optSplineWidths.setup(strandArrays.widths.data(), optimizedStrandArrays.vertexCount);
+
+    uint32_t tmpCount = 0;
+    for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+    {
+        for (uint32_t k = 0; k < subdivPerSegment; k++)
+        {
+            if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
+            {
+                float t = (float)k / (float)subdivPerSegment;
+                optimizedStrandArrays.controlPoints.push_back(splinePoints.interpolate(j, t));
+                optimizedStrandArrays.widths.push_back(sanitizeWidth(kMeshCompensationScale * widthScale * splineWidths.interpolate(j, t)));
+            }
+            tmpCount++;
+        }
+    }
+
+    // Always keep the last vertex.
+    optimizedStrandArrays.controlPoints.push_back(splinePoints.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
+    optimizedStrandArrays.widths.push_back(sanitizeWidth(kMeshCompensationScale * widthScale * splineWidths.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f)));
+
+    // Texture coordinates.
+    if (curveArrays.UVs)
+    {
+        const CubicSpline<float2>& splineUVs = splineCache.optSplineUVs.setup(strandArrays.UVs.data(), optimizedStrandArrays.vertexCount);
+        tmpCount = 0;
+        for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+        {
+            for (uint32_t k = 0; k < subdivPerSegment; k++)
+            {
+                if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
+                {
+                    float t = (float)k / (float)subdivPerSegment;
+                    optimizedStrandArrays.UVs.push_back(splineUVs.interpolate(j, t));
+                }
+                tmpCount++;
+            }
+        }
+
+        // Always keep the last vertex.
+        optimizedStrandArrays.UVs.push_back(splineUVs.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
+    }
+}
+
+void updateCurveFrame(const StrandArrays& strandArrays, float3& fwd, float3& s, float3& t, uint32_t j)
+{
+    float3 prevFwd;
+
+    if (j <= 0 || j >= strandArrays.controlPoints.size() || strandArrays.controlPoints.size() == 2)
+    {
+        // The forward tangents should be the same, meaning s & t are also the same
+        prevFwd = fwd;
+    }
+    else if (j == 1)
+    {
+        prevFwd = normalize(strandArrays.controlPoints[j] - strandArrays.controlPoints[j - 1]);
+        fwd = normalize(strandArrays.controlPoints[j + 1] - strandArrays.controlPoints[j - 1]);
+    }
+    else if (j < strandArrays.controlPoints.size() - 2)
+    {
+        prevFwd = normalize(strandArrays.controlPoints[j] - strandArrays.controlPoints[j - 2]);
+        fwd = normalize(strandArrays.controlPoints[j + 1] - strandArrays.controlPoints[j - 1]);
+    }
+    else if (j == strandArrays.controlPoints.size() - 1)
+    {
+        prevFwd = normalize(strandArrays.controlPoints[j] - strandArrays.controlPoints[j - 2]);
+        fwd = normalize(strandArrays.controlPoints[j] - strandArrays.controlPoints[j - 1]);
+    }
+
+    // Use quaternions to smoothly rotate the other vectors and update s & t vectors.
+    quatf rotQuat = math::quatFromRotationBetweenVectors(prevFwd, fwd);
+    s = mul(rotQuat, s);
+    t = normalize(cross(fwd, s));
+    s = normalize(cross(t, fwd));
+
+    FALCOR_ASSERT_LT(std::abs(length(fwd) - 1.f), 1e-3f);
+    FALCOR_ASSERT_LT(std::abs(length(s) - 1.f), 1e-3f);
+    FALCOR_ASSERT_LT(std::abs(length(t) - 1.f), 1e-3f);
+}
+
+void updateMeshResultBuffers(CurveTessellation::MeshResult& result, const CurveArrays& curveArrays, StrandArrays& optimizedStrandArrays, const float3& fwd, const float3& s, const float3& t, uint32_t pointCountPerCrossSection, uint32_t j)
+{
+    // Mesh vertices, normals, tangents, and texCrds (if any).
+    for (uint32_t k = 0; k < pointCountPerCrossSection; k++)
+    {
+        float phi = (float)k / (float)pointCountPerCrossSection * (float)M_PI * 2.f;
+        float3 vNormal = std::cos(phi) * s + std::sin(phi) * t;
+
+        float curveRadius = 0.5f * optimizedStrandArrays.widths[j];
+        result.vertices.push_back(optimizedStrandArrays.controlPoints[j] + curveRadius * vNormal);
+        result.normals.push_back(vNormal);
+        result.tangents.push_back(float4(fwd.x, fwd.y, fwd.z, 1));
+        result.radii.push_back(curveRadius);
+
+        if (curveArrays.UVs)
+        {
+            result.texCrds.push_back(optimizedStrandArrays.UVs[j]);
+        }
+    }
+}
+
+void connectFaceVertices(CurveTessellation::MeshResult& result, uint32_t meshVertexOffset, uint32_t pointCountPerCrossSection, uint32_t quadCountLimit, uint32_t nextCrossSectionVertexOffset, uint32_t multiplier, uint32_t j)
+{
+    for (uint32_t k = 0; k < quadCountLimit; k++)
+    {
+        result.faceVertexCounts.push_back(3);
+        result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + k);
+        result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
+        result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
+
+        result.faceVertexCounts.push_back(3);
+        result.faceVertexIndices.push_back(meshVertexOffset + multiplier * j * pointCountPerCrossSection + k);
+        result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + (k + nextCrossSectionVertexOffset) % pointCountPerCrossSection);
+        result.faceVertexIndices.push_back(meshVertexOffset + (multiplier * j + 1) * pointCountPerCrossSection + k);
+    }
+}
+
+CurveTessellation::SweptSphereResult convertToLinearSweptSphere(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t degree, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand, float widthScale, const float4x4& xform)
+{
+    CurveTessellation::SweptSphereResult result;
+
+    // Only support linear tube segments now.
+    // TODO: Add quadratic or cubic tube segments if necessary.
+    FALCOR_ASSERT(degree == 1);
+    result.degree = degree;
+
+    uint32_t pointCounts = 0;
+    uint32_t segCounts = 0;
+    uint32_t maxVertexCountsPerStrand = 0;
+    for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+    {
+        uint32_t tmpPointCount = div_round_up(subdivPerSegment * (vertexCountsPerStrand[i] - 1), keepOneEveryXVerticesPerStrand) + 1;
+        pointCounts += tmpPointCount;
+        segCounts += tmpPointCount - 1;
+        maxVertexCountsPerStrand = std::max(maxVertexCountsPerStrand, vertexCountsPerStrand[i]);
+    }
+    result.indices.reserve(segCounts);
+    result.points.reserve(pointCounts);
+    result.radius.reserve(pointCounts);
+    result.texCrds.reserve(pointCounts);
+
+    uint32_t pointOffset = 0;
+
+    StrandArrays strandArrays;
+    strandArrays.controlPoints.reserve(maxVertexCountsPerStrand);
+    strandArrays.widths.reserve(maxVertexCountsPerStrand);
+    strandArrays.UVs.reserve(maxVertexCountsPerStrand);
+    CurveArrays curveArrays(controlPoints, widths, UVs);
+
+    StrandArrays optimizedStrandArrays;
+    CubicSplineCache splineCache;
+    for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+    {
+        optimizedStrandArrays.controlPoints.clear();
+        optimizedStrandArrays.UVs.clear();
+        optimizedStrandArrays.widths.clear();
+        optimizedStrandArrays.vertexCount = 0;
+        strandArrays.vertexCount = vertexCountsPerStrand[i];
+
+        optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+
+        const CubicSpline<float3>& splinePoints = splineCache.splinePoints.setup(strandArrays.controlPoints.data(), optimizedStrandArrays.vertexCount);
+        const CubicSpline<float>& splineWidths = splineCache.splineWidths.setup(strandArrays.widths.data(), optimizedStrandArrays.vertexCount);
+
+        uint32_t tmpCount = 0;
+        for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+        {
+            for (uint32_t k = 0; k < subdivPerSegment; k++)
+            {
+                if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
+                {
+                    float t = (float)k / (float)subdivPerSegment;
+                    result.indices.push_back((uint32_t)result.points.size());
+
+                    // Pre-transform curve points.
+                    float4 sph = transformSphere(xform, float4(splinePoints.interpolate(j, t), sanitizeWidth(splineWidths.interpolate(j, t) * 0.5f * widthScale)));
+
+                    result.points.push_back(sph.xyz());
+                    result.radius.push_back(sph.w);
+                }
+                tmpCount++;
+            }
+        }
+
+        // Always keep the last vertex.
+        float4 sph = transformSphere(xform, float4(splinePoints.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f), sanitizeWidth(splineWidths.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f) * 0.5f * widthScale)));
+        result.points.push_back(sph.xyz());
+        result.radius.push_back(sph.w);
+
+        // Texture coordinates.
+        if (UVs)
+        {
+            const CubicSpline<float2>& splineUVs = splineCache.splineUVs.setup(strandArrays.UVs.data(), optimizedStrandArrays.vertexCount);
+            tmpCount = 0;
+            for (uint32_t j = 0; j < optimizedStrandArrays.vertexCount - 1; j++)
+            {
+                for (uint32_t k = 0; k < subdivPerSegment; k++)
+                {
+                    if (tmpCount % keepOneEveryXVerticesPerStrand == 0)
+                    {
+                        float t = (float)k / (float)subdivPerSegment;
+                        result.texCrds.push_back(splineUVs.interpolate(j, t));
+                    }
+                    tmpCount++;
+                }
+            }
+
+            // Always keep the last vertex.
+            result.texCrds.push_back(splineUVs.interpolate(optimizedStrandArrays.vertexCount - 2, 1.f));
+        }
+
+        for (uint32_t j = i; j < std::min(strandCount, i + keepOneEveryXStrands); j++) pointOffset += vertexCountsPerStrand[j];
+    }
+
+    return result;
+}
+
+CurveTessellation::MeshResult convertToPolytube(uint32_t strandCount, const uint32_t* vertexCountsPerStrand, const float3* controlPoints, const float* widths, const float2* UVs, uint32_t subdivPerSegment, uint32_t keepOneEveryXStrands, uint32_t keepOneEveryXVerticesPerStrand, float widthScale, uint32_t pointCountPerCrossSection)
+{
+    CurveTessellation::MeshResult result;
+    uint32_t vertexCounts = 0;
+    uint32_t faceCounts = 0;
+    uint32_t maxVertexCountsPerStrand = 0;
+    for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+    {
+        uint32_t tmpPointCount = div_round_up(subdivPerSegment * (vertexCountsPerStrand[i] - 1), keepOneEveryXVerticesPerStrand) + 1;
+        vertexCounts += pointCountPerCrossSection * tmpPointCount;
+        faceCounts += 2 * pointCountPerCrossSection * (tmpPointCount - 1);
+        maxVertexCountsPerStrand = std::max(maxVertexCountsPerStrand, vertexCountsPerStrand[i]);
+    }
+    result.vertices.reserve(vertexCounts);
+    result.normals.reserve(vertexCounts);
+    result.tangents.reserve(vertexCounts);
+    result.texCrds.reserve(vertexCounts);
+    result.radii.reserve(vertexCounts);
+    result.faceVertexCounts.reserve(faceCounts);
+    result.faceVertexIndices.reserve(faceCounts * 3);
+
+    uint32_t pointOffset = 0;
+    uint32_t meshVertexOffset = 0;
+
+    StrandArrays strandArrays;
+    strandArrays.controlPoints.reserve(maxVertexCountsPerStrand);
+    strandArrays.widths.reserve(maxVertexCountsPerStrand);
+    strandArrays.UVs.reserve(maxVertexCountsPerStrand);
+    CurveArrays curveArrays(controlPoints, widths, UVs);
+
+    StrandArrays optimizedStrandArrays;
+    CubicSplineCache splineCache;
+    for (uint32_t i = 0; i < strandCount; i += keepOneEveryXStrands)
+    {
+        optimizedStrandArrays.controlPoints.clear();
+        optimizedStrandArrays.UVs.clear();
+        optimizedStrandArrays.widths.clear();
+        optimizedStrandArrays.vertexCount = 0;
+
+        strandArrays.vertexCount = vertexCountsPerStrand[i];
+
+        optimizeStrandGeometry(splineCache, curveArrays, strandArrays, optimizedStrandArrays, pointOffset, subdivPerSegment, keepOneEveryXVerticesPerStrand, widthScale);
+
+        for (uint32_t j = i; j < std::min(strandCount, i + keepOneEveryXStrands); j++) pointOffset += vertexCountsPerStrand[j];
+
+        // Build the initial frame.
+        float3 fwd, s, t;
+        fwd = normalize(optimizedStrandArrays.controlPoints[1] - optimizedStrandArrays.controlPoints[0]);
+        FALCOR_ASSERT_LT(std::abs(length(fwd) - 1.f), 1e-3f);
+        buildFrame(fwd, s, t);
+
+        // Create mesh.
+        for (uint32_t j = 0; j < optimizedStrandArrays.controlPoints.size(); j++)
+        {
+            // Update the curve's frame vectors: [fwd, s, t]
+            updateCurveFrame(optimizedStrandArrays, fwd, s, t, j);
+
+            // Mesh vertices, normals, tangents, and texCrds (if any).
+            updateMeshResultBuffers(result, curveArrays, optimizedStrandArrays, fwd, s, t, pointCountPerCrossSection, j);
+
+            // Mesh faces.
+            if (j < optimizedStrandArrays.controlPoints.size() - 1)
+            {
+                uint32_t quadCountLimit = pointCountPerCrossSection;
+                connectFaceVertices(result, meshVertexOffset, pointCountPerCrossSection, quadCountLimit, 1, 1, j);
+            }
+        }
+
+        meshVertexOffset += pointCountPerCrossSection * (uint32_t)optimizedStrandArrays.controlPoints.size();
+    }
+
+    return result;
+}
+} // namespace reference
+
+template<typename T>
+bool equal(const fast_vector<T>& a, const fast_vector<T>& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+} // namespace
+
+CPU_TEST(CurveTessellation_SweptSphereMatchesReference)
+{
+    const Strands strands = generateStrands(1000);
+    const float4x4 xform = math::mul(math::matrixFromTranslation(float3(1.f, 2.f, 3.f)), math::matrixFromScaling(float3(2.f)));
+
+    for (const float2* UVs : {strands.UVs.data(), (const float2*)nullptr})
+    {
+        for (uint32_t keepOneEveryXStrands : {1u, 3u})
+        {
+            for (uint32_t keepOneEveryXVerticesPerStrand : {1u, 2u})
+            {
+                const uint32_t strandCount = (uint32_t)strands.vertexCounts.size();
+                auto result = CurveTessellation::convertToLinearSweptSphere(
+                    strandCount, strands.vertexCounts.data(), strands.controlPoints.data(), strands.widths.data(), UVs, 1, 4,
+                    keepOneEveryXStrands, keepOneEveryXVerticesPerStrand, 1.f, xform
+                );
+                auto expected = reference::convertToLinearSweptSphere(
+                    strandCount, strands.vertexCounts.data(), strands.controlPoints.data(), strands.widths.data(), UVs, 1, 4,
+                    keepOneEveryXStrands, keepOneEveryXVerticesPerStrand, 1.f, xform
+                );
+
+                EXPECT_EQ(result.degree, expected.degree);
+                EXPECT(equal(result.indices, expected.indices));
+                EXPECT(equal(result.points, expected.points));
+                EXPECT(equal(result.radius, expected.radius));
+                EXPECT(equal(result.texCrds, expected.texCrds));
+            }
+        }
+    }
+}
+
+CPU_TEST(CurveTessellation_PolytubeMatchesReference)
+{
+    const Strands strands = generateStrands(1000);
+    const uint32_t pointCountPerCrossSection = 4;
+
+    for (const float2* UVs : {strands.UVs.data(), (const float2*)nullptr})
+    {
+        for (uint32_t keepOneEveryXStrands : {1u, 3u})
+        {
+            for (uint32_t keepOneEveryXVerticesPerStrand : {1u, 2u})
+            {
+                const uint32_t strandCount = (uint32_t)strands.vertexCounts.size();
+                auto result = CurveTessellation::convertToPolytube(
+                    strandCount, strands.vertexCounts.data(), strands.controlPoints.data(), strands.widths.data(), UVs, 3,
+                    keepOneEveryXStrands, keepOneEveryXVerticesPerStrand, 1.f, pointCountPerCrossSection
+                );
+                auto expected = reference::convertToPolytube(
+                    strandCount, strands.vertexCounts.data(), strands.controlPoints.data(), strands.widths.data(), UVs, 3,
+                    keepOneEveryXStrands, keepOneEveryXVerticesPerStrand, 1.f, pointCountPerCrossSection
+                );
+
+                EXPECT(equal(result.vertices, expected.vertices));
+                EXPECT(equal(result.normals, expected.normals));
+                EXPECT(equal(result.tangents, expected.tangents));
+                EXPECT(equal(result.texCrds, expected.texCrds));
+                EXPECT(equal(result.radii, expected.radii));
+                EXPECT(equal(result.faceVertexCounts, expected.faceVertexCounts));
+                EXPECT(equal(result.faceVertexIndices, expected.faceVertexIndices));
+            }
+        }
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,121 @@
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "Scene/Volume/Grid.h"
+#include "Scene/Volume/GridCache.h"
+#include "Scene/Volume/GridConverter.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146 4244 4267 4275 4996 4456)
+#endif
+#include <nanovdb/util/IO.h>
+// See Grid.cpp for the std::result_of workaround.
+#define result_of invoke_result
+#include <nanovdb/util/GridBuilder.h>
+#undef result_of
+#include <nanovdb/util/Primitives.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+template<typename T>
+bool isEqual(const std::vector<uint8_t>& data, const T* pExpected, size_t count)
+{
+    return data.size() == count * sizeof(T) && std::memcmp(data.data(), pExpected, data.size()) == 0;
+}
+} // namespace
+
+GPU_TEST(GridCache_LoadFromCache)
+{
+    const std::string gridname = "sphere_fog";
+    std::filesystem::path path = getTempFilePath();
+    path += ".nvdb";
+    nanovdb::io::writeGrid(path.string(), nanovdb::createFogVolumeSphere<float>(1.5f, nanovdb::Vec3f(0.f), 0.05f, 3.f));
+
+    const bool wasEnabled = GridCache::isEnabled();
+    const auto cachePath = GridCache::getCachePath(GridCache::computeKey(path, gridname));
+    std::filesystem::remove(cachePath);
+
+    GridCache::setEnabled(true);
+    GridCache::resetStats();
+
+    // The first load converts the grid and writes the cache.
+    ref<Grid> pConverted = Grid::createFromFile(ctx.getDevice(), path, gridname);
+    ASSERT(pConverted != nullptr);
+    EXPECT_EQ(GridCache::getStats().missCount, 1ull);
+    EXPECT_EQ(GridCache::getStats().writeCount, 1ull);
+    EXPECT(std::filesystem::exists(cachePath));
+
+    // The second load reads the cache.
+    ref<Grid> pCached = Grid::createFromFile(ctx.getDevice(), path, gridname);
+    ASSERT(pCached != nullptr);
+    EXPECT_EQ(GridCache::getStats().hitCount, 1ull);
+    EXPECT(pCached->isUploaded());
+    EXPECT_EQ(pCached->getVoxelCount(), pConverted->getVoxelCount());
+    EXPECT_EQ(pCached->getGridSizeInBytes(), pConverted->getGridSizeInBytes());
+    EXPECT(all(pCached->getMinIndex() == pConverted->getMinIndex()));
+    EXPECT(all(pCached->getMaxIndex() == pConverted->getMaxIndex()));
+    EXPECT_EQ(pCached->getValue(int3(0)), pConverted->getValue(int3(0)));
+
+    // A different grid name is a different cache entry.
+    EXPECT(GridCache::computeKey(path, gridname) != GridCache::computeKey(path, "density"));
+
+    // The cached grid and bricks match a fresh conversion of the grid file.
+    {
+        auto handle = nanovdb::io::readGrid(path.string(), gridname);
+        ASSERT(handle.grid<float>() != nullptr);
+        GridCache::BrickConverter converter(handle.grid<float>());
+        converter.convertBricks();
+
+        auto pEntry = GridCache::readCache(GridCache::computeKey(path, gridname));
+        ASSERT(pEntry != nullptr);
+        auto cachedHandle = pEntry->createGridHandle();
+        EXPECT(cachedHandle.size() == handle.size() && std::memcmp(cachedHandle.data(), handle.data(), handle.size()) == 0);
+
+        RenderContext* pRenderContext = ctx.getRenderContext();
+        BrickedGrid bricks = pEntry->createTextures(ctx.getDevice());
+        ASSERT_EQ(bricks.range->getMipCount(), 4u);
+        const uint3 rangeSize = converter.getRangeSize();
+        size_t rangeOffset = 0;
+        for (uint32_t mip = 0; mip < bricks.range->getMipCount(); ++mip)
+        {
+            const size_t count = (rangeSize.x >> mip) * (rangeSize.y >> mip) * (rangeSize.z >> mip);
+            const auto range = pRenderContext->readTextureSubresource(bricks.range.get(), bricks.range->getSubresourceIndex(0, mip));
+            EXPECT(isEqual(range, converter.getRangeData().data() + rangeOffset, count)) << "mip=" << mip;
+            rangeOffset += count;
+        }
+        EXPECT_EQ(rangeOffset, converter.getRangeData().size());
+
+        const auto indirection = pRenderContext->readTextureSubresource(bricks.indirection.get(), 0);
+        EXPECT(isEqual(indirection, converter.getPtrData().data(), converter.getPtrData().size()));
+        const auto atlas = pRenderContext->readTextureSubresource(bricks.atlas.get(), 0);
+        EXPECT(isEqual(atlas, converter.getAtlasData().data(), converter.getAtlasData().size()));
+    }
+
+    // Cache files whose brick sections don't match the texture dimensions in the header are rejected.
+    // The header starts with the magic, the version, the atlas format, the range size and the atlas size.
+    {
+        std::fstream fs(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+        const std::streamoff atlasDepthOffset = 8 + 4 + 4 + 3 * 4 + 2 * 4;
+        uint32_t atlasDepth = 0;
+        fs.seekg(atlasDepthOffset);
+        fs.read(reinterpret_cast<char*>(&atlasDepth), sizeof(atlasDepth));
+        atlasDepth += 8;
+        fs.seekp(atlasDepthOffset);
+        fs.write(reinterpret_cast<const char*>(&atlasDepth), sizeof(atlasDepth));
+    }
+    EXPECT(GridCache::readCache(GridCache::computeKey(path, gridname)) == nullptr);
+
+    GridCache::setEnabled(wasEnabled);
+    pCached = nullptr;
+    std::filesystem::remove(cachePath);
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
@@ -0,0 +1,68 @@
+#include "Testing/UnitTest.h"
+#include "Scene/Volume/GridConverter.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146 4244 4267 4275 4996 4456)
+#endif
+// See Grid.cpp for the std::result_of workaround.
+#define result_of invoke_result
+#include <nanovdb/util/GridBuilder.h>
+#undef result_of
+#include <nanovdb/util/Primitives.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <algorithm>
+
+namespace Falcor
+{
+namespace
+{
+nanovdb::GridHandle<nanovdb::HostBuffer> createSphere(float radius, float voxelSize)
+{
+    return nanovdb::createFogVolumeSphere<float>(radius, nanovdb::Vec3f(0.f), voxelSize, 3.f);
+}
+
+nanovdb::GridHandle<nanovdb::HostBuffer> createBox(float width, float height, float depth, float voxelSize)
+{
+    return nanovdb::createFogVolumeBox<float>(width, height, depth, nanovdb::Vec3f(0.f), voxelSize, 3.f);
+}
+
+template<typename Converter>
+void testConverter(CPUUnitTestContext& ctx, const nanovdb::FloatGrid* pGrid, const char* name)
+{
+    Converter serial(pGrid);
+    serial.convertBricks(false);
+
+    // The parallel conversion must produce the same bytes as the serial one, on every run.
+    for (int run = 0; run < 2; ++run)
+    {
+        Converter parallel(pGrid);
+        parallel.convertBricks(true);
+        EXPECT(parallel.getRangeData() == serial.getRangeData()) << name << " run=" << run;
+        EXPECT(parallel.getPtrData() == serial.getPtrData()) << name << " run=" << run;
+        EXPECT(parallel.getAtlasData() == serial.getAtlasData()) << name << " run=" << run;
+    }
+
+    const auto& ptrData = serial.getPtrData();
+    EXPECT(std::any_of(ptrData.begin(), ptrData.end(), [](uint32_t ptr) { return ptr != 0; })) << name;
+}
+
+void testGrid(CPUUnitTestContext& ctx, const nanovdb::GridHandle<nanovdb::HostBuffer>& handle, const char* name)
+{
+    const nanovdb::FloatGrid* pGrid = handle.grid<float>();
+    ASSERT(pGrid != nullptr);
+    testConverter<NanoVDBConverterBC4>(ctx, pGrid, name);
+    testConverter<NanoVDBConverterUNORM8>(ctx, pGrid, name);
+    testConverter<NanoVDBConverterUNORM16>(ctx, pGrid, name);
+}
+} // namespace
+
+CPU_TEST(GridConverter_Deterministic)
+{
+    testGrid(ctx, createSphere(4.f, 0.1f), "sphere");
+    testGrid(ctx, createBox(6.f, 3.f, 2.f, 0.1f), "box");
+}
+} // namespace Falcor
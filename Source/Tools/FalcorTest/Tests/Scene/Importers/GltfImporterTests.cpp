@@ -0,0 +1,292 @@
+#include "Testing/UnitTest.h"
+#include "Core/Plugin.h"
+#include "Core/Platform/OS.h"
+#include "Scene/Importer.h"
+#include "Scene/SceneBuilder.h"
+#include <meshoptimizer.h>
+#include <nlohmann/json.hpp>
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+using json = nlohmann::json;
+
+enum class Encoding
+{
+    Float,     ///< Float vertex attributes.
+    Quantized, ///< Normalized integer vertex attributes (KHR_mesh_quantization).
+    Meshopt,   ///< Quantized vertex attributes and indices compressed with EXT_meshopt_compression.
+};
+
+const uint32_t kComponentInt8 = 5120;
+const uint32_t kComponentInt16 = 5122;
+const uint32_t kComponentUint16 = 5123;
+const uint32_t kComponentUint32 = 5125;
+const uint32_t kComponentFloat = 5126;
+
+/** Writes a GLB file with a set of grid meshes, instanced by a grid of nodes.
+*/
+class GlbWriter
+{
+public:
+    GlbWriter(Encoding encoding) : mEncoding(encoding)
+    {
+        mJson["asset"] = {{"version", "2.0"}};
+        mJson["buffers"] = json::array({json::object()});
+        if (encoding != Encoding::Float)
+        {
+            mJson["extensionsUsed"] = {"KHR_mesh_quantization"};
+            mJson["extensionsRequired"] = {"KHR_mesh_quantization"};
+        }
+        if (encoding == Encoding::Meshopt)
+        {
+            mJson["extensionsUsed"].push_back("EXT_meshopt_compression");
+            mJson["extensionsRequired"].push_back("EXT_meshopt_compression");
+            mJson["buffers"].push_back({{"extensions", {{"EXT_meshopt_compression", {{"fallback", true}}}}}});
+        }
+    }
+
+    /** Add a grid mesh in [-1,1]^3. The mesh index varies the height field.
+    */
+    void addGridMesh(uint32_t size, uint32_t meshIndex)
+    {
+        const uint32_t vertexCount = (size + 1) * (size + 1);
+        std::vector<float3> positions;
+        std::vector<float3> normals;
+        std::vector<float2> texCrds;
+        std::vector<uint32_t> indices;
+        const float frequency = 2.f + (float)meshIndex;
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                const float2 uv = float2(x / (float)size, y / (float)size);
+                const float u = uv.x * 2.f - 1.f;
+                positions.push_back(float3(u, 0.5f * std::sin(u * frequency), uv.y * 2.f - 1.f));
+                normals.push_back(normalize(float3(-std::cos(u * frequency) * frequency, 1.f, 0.f)));
+                texCrds.push_back(uv);
+            }
+        }
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const uint32_t i0 = y * (size + 1) + x;
+                indices.insert(indices.end(), {i0, i0 + size + 1, i0 + 1, i0 + 1, i0 + size + 1, i0 + size + 2});
+            }
+        }
+
+        json attributes;
+        if (mEncoding == Encoding::Float)
+        {
+            attributes["POSITION"] = addAccessor(addVertexView(positions), kComponentFloat, vertexCount, "VEC3", false);
+            attributes["NORMAL"] = addAccessor(addVertexView(normals), kComponentFloat, vertexCount, "VEC3", false);
+            attributes["TEXCOORD_0"] = addAccessor(addVertexView(texCrds), kComponentFloat, vertexCount, "VEC2", false);
+        }
+        else
+        {
+            // Vertex attributes are padded to a multiple of 4 bytes.
+            std::vector<int16_t> qPositions(vertexCount * 4, 0);
+            std::vector<int8_t> qNormals(vertexCount * 4, 0);
+            std::vector<uint16_t> qTexCrds(vertexCount * 2);
+            for (uint32_t i = 0; i < vertexCount; ++i)
+            {
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    qPositions[i * 4 + c] = (int16_t)std::round(positions[i][c] * 32767.f);
+                    qNormals[i * 4 + c] = (int8_t)std::round(normals[i][c] * 127.f);
+                }
+                for (uint32_t c = 0; c < 2; ++c)
+                    qTexCrds[i * 2 + c] = (uint16_t)std::round(texCrds[i][c] * 65535.f);
+            }
+            attributes["POSITION"] = addAccessor(addVertexView(qPositions, 8), kComponentInt16, vertexCount, "VEC3", true);
+            attributes["NORMAL"] = addAccessor(addVertexView(qNormals, 4), kComponentInt8, vertexCount, "VEC3", true);
+            attributes["TEXCOORD_0"] = addAccessor(addVertexView(qTexCrds, 4), kComponentUint16, vertexCount, "VEC2", true);
+        }
+        mJson["accessors"][attributes["POSITION"].get<size_t>()]["min"] = {-1.f, -0.5f, -1.f};
+        mJson["accessors"][attributes["POSITION"].get<size_t>()]["max"] = {1.f, 0.5f, 1.f};
+
+        const size_t indexAccessor = addAccessor(addIndexView(indices), kComponentUint32, (uint32_t)indices.size(), "SCALAR", false);
+        mJson["meshes"].push_back({{"primitives", {{{"attributes", attributes}, {"indices", indexAccessor}}}}});
+    }
+
+    /** Add a grid of nodes instancing the meshes.
+    */
+    void addInstances(uint32_t instanceCount)
+    {
+        const size_t meshCount = mJson["meshes"].size();
+        for (uint32_t i = 0; i < instanceCount; ++i)
+        {
+            mJson["nodes"].push_back({{"mesh", i % meshCount}, {"translation", {(i % 16) * 3.f, 0.f, (i / 16) * 3.f}}});
+            mJson["scenes"][0]["nodes"].push_back(i);
+        }
+        mJson["scene"] = 0;
+    }
+
+    std::filesystem::path write() const
+    {
+        json gltf = mJson;
+        gltf["buffers"][0]["byteLength"] = mBin.size();
+        if (mEncoding == Encoding::Meshopt)
+            gltf["buffers"][1]["byteLength"] = mFallbackSize;
+
+        std::string jsonChunk = gltf.dump();
+        jsonChunk.resize(align(jsonChunk.size()), ' ');
+        const uint32_t length = (uint32_t)(12 + 8 + jsonChunk.size() + 8 + mBin.size());
+
+        std::filesystem::path path = getTempFilePath();
+        path += ".glb";
+        std::ofstream file(path, std::ios::binary);
+        const uint32_t header[] = {0x46546C67, 2, length, (uint32_t)jsonChunk.size(), 0x4E4F534A};
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(jsonChunk.data(), jsonChunk.size());
+        const uint32_t binHeader[] = {(uint32_t)mBin.size(), 0x004E4942};
+        file.write(reinterpret_cast<const char*>(binHeader), sizeof(binHeader));
+        file.write(reinterpret_cast<const char*>(mBin.data()), mBin.size());
+        return path;
+    }
+
+private:
+    static size_t align(size_t size) { return (size + 3) & ~size_t(3); }
+
+    size_t append(const void* pData, size_t size)
+    {
+        const size_t offset = mBin.size();
+        mBin.resize(align(offset + size), 0);
+        std::memcpy(mBin.data() + offset, pData, size);
+        return offset;
+    }
+
+    size_t addView(json view, const void* pData, size_t size, size_t stride, bool isIndex)
+    {
+        if (mEncoding != Encoding::Meshopt)
+        {
+            view["buffer"] = 0;
+            view["byteOffset"] = append(pData, size);
+        }
+        else
+        {
+            // The compressed data is stored in the binary chunk, the view itself refers to the fallback buffer.
+            const size_t count = size / stride;
+            std::vector<uint8_t> encoded;
+            if (isIndex)
+            {
+                encoded.resize(meshopt_encodeIndexBufferBound(count, count));
+                encoded.resize(meshopt_encodeIndexBuffer(encoded.data(), encoded.size(), static_cast<const unsigned int*>(pData), count));
+            }
+            else
+            {
+                encoded.resize(meshopt_encodeVertexBufferBound(count, stride));
+                encoded.resize(meshopt_encodeVertexBuffer(encoded.data(), encoded.size(), pData, count, stride));
+            }
+            view["buffer"] = 1;
+            view["byteOffset"] = mFallbackSize;
+            view["extensions"]["EXT_meshopt_compression"] = {
+                {"buffer", 0},
+                {"byteOffset", append(encoded.data(), encoded.size())},
+                {"byteLength", encoded.size()},
+                {"byteStride", stride},
+                {"count", count},
+                {"mode", isIndex ? "TRIANGLES" : "ATTRIBUTES"},
+            };
+            mFallbackSize += align(size);
+        }
+        view["byteLength"] = size;
+        mJson["bufferViews"].push_back(view);
+        return mJson["bufferViews"].size() - 1;
+    }
+
+    template<typename T>
+    size_t addVertexView(const std::vector<T>& data, size_t stride = sizeof(T))
+    {
+        const size_t size = data.size() * sizeof(T);
+        return addView({{"byteStride", stride}, {"target", 34962}}, data.data(), size, stride, false);
+    }
+
+    size_t addIndexView(const std::vector<uint32_t>& indices)
+    {
+        return addView({{"target", 34963}}, indices.data(), indices.size() * sizeof(uint32_t), sizeof(uint32_t), true);
+    }
+
+    size_t addAccessor(size_t view, uint32_t componentType, uint32_t count, const char* type, bool normalized)
+    {
+        json accessor = {{"bufferView", view}, {"componentType", componentType}, {"count", count}, {"type", type}};
+        if (normalized)
+            accessor["normalized"] = true;
+        mJson["accessors"].push_back(accessor);
+        return mJson["accessors"].size() - 1;
+    }
+
+    Encoding mEncoding;
+    json mJson;
+    std::vector<uint8_t> mBin;
+    size_t mFallbackSize = 0;
+};
+
+std::filesystem::path writeGridScene(Encoding encoding, uint32_t meshCount, uint32_t gridSize, uint32_t instanceCount)
+{
+    GlbWriter writer(encoding);
+    for (uint32_t i = 0; i < meshCount; ++i)
+        writer.addGridMesh(gridSize, i);
+    writer.addInstances(instanceCount);
+    return writer.write();
+}
+
+std::unique_ptr<Importer> createImporter(const std::string& type)
+{
+    PluginManager::instance().loadPluginByName(type);
+    return PluginManager::instance().createClass<Importer>(type);
+}
+
+ref<Scene> importScene(const ref<Device>& pDevice, Importer& importer, const std::filesystem::path& path)
+{
+    SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::DontMergeMeshes);
+    importer.importScene(path, builder, {});
+    return builder.getScene();
+}
+} // namespace
+
+GPU_TEST(GltfImporter_Encodings)
+{
+    auto pImporter = createImporter("GltfImporter");
+    ASSERT(pImporter != nullptr);
+
+    const std::filesystem::path floatPath = writeGridScene(Encoding::Float, 3, 32, 8);
+    ref<Scene> pReference = importScene(ctx.getDevice(), *pImporter, floatPath);
+    ASSERT(pReference != nullptr);
+    EXPECT_EQ(pReference->getMeshCount(), 3u);
+    EXPECT_EQ(pReference->getGeometryInstanceCount(), 8u);
+
+    // Quantized and compressed data decodes to the same geometry, up to the quantization error.
+    for (Encoding encoding : {Encoding::Quantized, Encoding::Meshopt})
+    {
+        const std::filesystem::path path = writeGridScene(encoding, 3, 32, 8);
+        ref<Scene> pScene = importScene(ctx.getDevice(), *pImporter, path);
+        ASSERT(pScene != nullptr);
+        EXPECT_EQ(pScene->getMeshCount(), pReference->getMeshCount());
+        EXPECT_EQ(pScene->getGeometryInstanceCount(), pReference->getGeometryInstanceCount());
+        const AABB& bounds = pScene->getSceneBounds();
+        const AABB& referenceBounds = pReference->getSceneBounds();
+        EXPECT_LE(length(bounds.minPoint - referenceBounds.minPoint), 1e-3f);
+        EXPECT_LE(length(bounds.maxPoint - referenceBounds.maxPoint), 1e-3f);
+        std::filesystem::remove(path);
+    }
+
+    // The AssimpImporter produces the same scene.
+    if (auto pAssimpImporter = createImporter("AssimpImporter"))
+    {
+        ref<Scene> pScene = importScene(ctx.getDevice(), *pAssimpImporter, floatPath);
+        ASSERT(pScene != nullptr);
+        EXPECT_EQ(pScene->getGeometryInstanceCount(), pReference->getGeometryInstanceCount());
+        const AABB& bounds = pScene->getSceneBounds();
+        const AABB& referenceBounds = pReference->getSceneBounds();
+        EXPECT_LE(length(bounds.minPoint - referenceBounds.minPoint), 1e-5f);
+        EXPECT_LE(length(bounds.maxPoint - referenceBounds.maxPoint), 1e-5f);
+    }
+
+    std::filesystem::remove(floatPath);
+}
+} // namespace Falcor
@@ -1,22 +1,21 @@
-// This code is based on pbrt:
-// pbrt is Copyright(c) 1998-2020 Matt Pharr, Wenzel Jakob, and Greg Humphreys.
-// The pbrt source code is licensed under the Apache License, Version 2.0.
-// SPDX: Apache-2.0
-
-#include "LoopSubdivide.h"
-#include "Core/Error.h"
-
+#include "Testing/UnitTest.h"
+#include "Scene/LoopSubdivide.h"
+#include "../MeshTestUtils.h"
 #include <algorithm>
 #include <map>
 #include <memory>
 #include <memory_resource>
 #include <set>
-
 #include <cmath>
 
-namespace Falcor::pbrt
+namespace Falcor
+{
+namespace
+{
+/** Reference implementation using the pointer-based subdivision data structures from pbrt.
+*/
+namespace reference
 {
-
 struct SDFace;
 struct SDVertex;
 
@@ -511,4 +510,73 @@ static float3 weightBoundary(SDVertex* vert, float beta)
     return p;
 }
 
-} // namespace Falcor::pbrt
+#undef NEXT
+#undef PREV
+} // namespace reference
+
+struct TestMesh
+{
+    std::string name;
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+};
+
+TestMesh createIcosahedron()
+{
+    const float t = (1.f + std::sqrt(5.f)) / 2.f;
+    TestMesh mesh;
+    mesh.name = "icosahedron";
+    mesh.positions = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+        {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    mesh.indices = {
+        0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+        3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+    };
+    return mesh;
+}
+
+/** Cube with vertices of valence 4, 5 and 6. If open is set, the top face is removed.
+*/
+TestMesh createCube(bool open)
+{
+    TestMesh mesh;
+    mesh.name = open ? "open cube" : "cube";
+    for (uint32_t i = 0; i < 8; ++i)
+        mesh.positions.push_back(float3(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f));
+    const uint32_t quads[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+    for (const auto& quad : quads)
+    {
+        // Skip the top face (y = 1) for the open cube.
+        if (open && quad[0] == 2)
+            continue;
+        for (uint32_t i : {0, 1, 2, 0, 2, 3})
+            mesh.indices.push_back(quad[i]);
+    }
+    return mesh;
+}
+
+TestMesh createGrid(uint32_t width, uint32_t height)
+{
+    GridMesh grid = generateGrid(width, height);
+    return {"grid", std::move(grid.positions), std::move(grid.indices)};
+}
+} // namespace
+
+CPU_TEST(LoopSubdivide_MatchesReference)
+{
+    for (const TestMesh& mesh : {createIcosahedron(), createCube(false), createCube(true), createGrid(5, 3)})
+    {
+        for (uint32_t levels = 0; levels <= 4; ++levels)
+        {
+            LoopSubdivideResult expected = reference::loopSubdivide(levels, mesh.positions, mesh.indices);
+            LoopSubdivideResult result = Falcor::loopSubdivide(levels, mesh.positions, mesh.indices);
+
+            EXPECT(result.indices == expected.indices) << mesh.name << " levels=" << levels;
+            EXPECT(isEqual(result.positions, expected.positions)) << mesh.name << " levels=" << levels;
+            EXPECT(isEqual(result.normals, expected.normals)) << mesh.name << " levels=" << levels;
+        }
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,142 @@
+#include "Testing/UnitTest.h"
+#include "Core/Plugin.h"
+#include "Core/Platform/OS.h"
+#include "Scene/Importer.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Lights/Light.h"
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+std::unique_ptr<Importer> createImporter()
+{
+    PluginManager::instance().loadPluginByName("PBRTImporter");
+    return PluginManager::instance().createClass<Importer>("PBRTImporter");
+}
+
+/** Writes a PBRT file to the temp directory. Files written this way can import each other by filename.
+*/
+std::filesystem::path writeFile(const std::string& contents)
+{
+    std::filesystem::path path = getTempFilePath();
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+std::string getImportName(const std::filesystem::path& path)
+{
+    return "\"" + path.filename().string() + "\"";
+}
+} // namespace
+
+GPU_TEST(PBRTImporter_Import)
+{
+    auto pImporter = createImporter();
+    ASSERT(pImporter != nullptr);
+
+    // Lights are scaled by their declaration order. The nested import is applied within the import,
+    // and the rotation of the imported file doesn't affect the light after the import.
+    const std::filesystem::path nestedPath = writeFile(
+        "LightSource \"distant\" \"rgb L\" [1 1 1] \"float scale\" 3\n"
+    );
+    const std::filesystem::path importPath = writeFile(
+        "Rotate 90 0 1 0\n"
+        "LightSource \"distant\" \"rgb L\" [1 1 1] \"float scale\" 2\n"
+        "Import " + getImportName(nestedPath) + "\n"
+    );
+    const std::filesystem::path mainPath = writeFile(
+        "WorldBegin\n"
+        "LightSource \"distant\" \"rgb L\" [1 1 1] \"float scale\" 1\n"
+        "AttributeBegin\n"
+        "Import " + getImportName(importPath) + "\n"
+        "LightSource \"distant\" \"rgb L\" [1 1 1] \"float scale\" 4\n"
+        "AttributeEnd\n"
+    );
+
+    SceneBuilder builder(ctx.getDevice(), Settings(), SceneBuilder::Flags::None);
+    pImporter->importScene(mainPath, builder, {});
+
+    const auto& lights = builder.getLights();
+    ASSERT_EQ(lights.size(), 4u);
+    const float3 expectedDirections[4] = {float3(0.f, 0.f, 1.f), float3(1.f, 0.f, 0.f), float3(1.f, 0.f, 0.f), float3(0.f, 0.f, 1.f)};
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        EXPECT_LE(std::abs(lights[i]->getIntensity().x - (float)(i + 1) * lights[0]->getIntensity().x), 1e-5f) << "light=" << i;
+        auto pLight = dynamic_ref_cast<DirectionalLight>(lights[i]);
+        ASSERT(pLight != nullptr);
+        EXPECT_LE(length(pLight->getWorldDirection() - expectedDirections[i]), 1e-5f) << "light=" << i;
+    }
+
+    std::filesystem::remove(mainPath);
+    std::filesystem::remove(importPath);
+    std::filesystem::remove(nestedPath);
+}
+
+GPU_TEST(PBRTImporter_ImportErrors)
+{
+    auto pImporter = createImporter();
+    ASSERT(pImporter != nullptr);
+
+    // An imported file only sees the names defined before it, so the redefinition is reported in the importing file.
+    const std::filesystem::path importPath = writeFile("MakeNamedMaterial \"a\" \"string type\" \"diffuse\"\n");
+    const std::filesystem::path mainPath = writeFile(
+        "WorldBegin\n"
+        "Import " + getImportName(importPath) + "\n"
+        "MakeNamedMaterial \"a\" \"string type\" \"conductor\"\n"
+    );
+    {
+        SceneBuilder builder(ctx.getDevice(), Settings(), SceneBuilder::Flags::None);
+        std::string error;
+        try
+        {
+            pImporter->importScene(mainPath, builder, {});
+        }
+        catch (const ImporterError& e)
+        {
+            error = e.what();
+        }
+        EXPECT(error.find("Redefining named material 'a'") != std::string::npos) << error;
+        EXPECT(error.find(importPath.filename().string()) == std::string::npos) << error;
+    }
+
+    // Imported files can't leave attribute blocks open.
+    const std::filesystem::path unbalancedPath = writeFile("AttributeBegin\n");
+    const std::filesystem::path unbalancedMainPath = writeFile("WorldBegin\nImport " + getImportName(unbalancedPath) + "\n");
+    {
+        SceneBuilder builder(ctx.getDevice(), Settings(), SceneBuilder::Flags::None);
+        EXPECT_THROW_AS(pImporter->importScene(unbalancedMainPath, builder, {}), ImporterError);
+    }
+
+    for (const auto& path : {importPath, mainPath, unbalancedPath, unbalancedMainPath})
+        std::filesystem::remove(path);
+}
+
+GPU_TEST(PBRTImporter_NumericArrays)
+{
+    auto pImporter = createImporter();
+    ASSERT(pImporter != nullptr);
+
+    // Numeric arrays are parsed in bulk from the file. Cover signs, exponents, missing leading digits,
+    // brackets next to values, line breaks and values followed by the next parameter.
+    const std::filesystem::path path = writeFile(
+        "WorldBegin\n"
+        "Shape \"trianglemesh\" \"integer indices\" [0 +1\n2]\n"
+        "    \"point3 P\" [-1 +0 .5  1.0e0 0 5E-1\n0 2 0.5]\n"
+        "Shape \"trianglemesh\" \"point3 P\" [ -2 -1 -0.25 -2 0 -0.25 -1.5 -1 -0.25 ] \"normal N\" [0 0 1 0 0 1 0 0 1]\n"
+    );
+
+    SceneBuilder builder(ctx.getDevice(), Settings(), SceneBuilder::Flags::DontMergeMeshes);
+    pImporter->importScene(path, builder, {});
+    ref<Scene> pScene = builder.getScene();
+    ASSERT(pScene != nullptr);
+    EXPECT_EQ(pScene->getMeshCount(), 2u);
+
+    const AABB& bounds = pScene->getSceneBounds();
+    EXPECT_LE(length(bounds.minPoint - float3(-2.f, -1.f, -0.25f)), 1e-6f);
+    EXPECT_LE(length(bounds.maxPoint - float3(1.f, 2.f, 0.5f)), 1e-6f);
+
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
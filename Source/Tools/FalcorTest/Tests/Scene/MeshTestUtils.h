@@ -0,0 +1,56 @@
+#pragma once
+#include "Utils/Math/Vector.h"
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+namespace Falcor
+{
+/** Grid of quads split into triangles, shared by the mesh importer tests.
+*/
+struct GridMesh
+{
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> texCoords;
+    std::vector<uint32_t> indices;
+};
+
+/** Generates a height field grid of width x height quads in the unit square.
+    Each quad is split into the two triangles of its fan triangulation.
+    Boundary vertices have valence 2, 3 or 4.
+*/
+inline GridMesh generateGrid(uint32_t width, uint32_t height)
+{
+    GridMesh mesh;
+    for (uint32_t y = 0; y <= height; ++y)
+    {
+        for (uint32_t x = 0; x <= width; ++x)
+        {
+            const float2 uv = float2(x / (float)width, y / (float)height);
+            mesh.positions.push_back(float3(uv.x, std::sin(uv.x * 3.f) * 0.1f, uv.y));
+            mesh.normals.push_back(normalize(float3(-std::cos(uv.x * 3.f) * 0.3f, 1.f, 0.f)));
+            mesh.texCoords.push_back(uv);
+        }
+    }
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t i0 = y * (width + 1) + x;
+            const uint32_t quad[4] = {i0, i0 + 1, i0 + width + 2, i0 + width + 1};
+            for (uint32_t i : {0, 1, 2, 0, 2, 3})
+                mesh.indices.push_back(quad[i]);
+        }
+    }
+    return mesh;
+}
+
+/** Compares two arrays of vectors for bitwise equal components.
+*/
+template<typename VecT>
+bool isEqual(const std::vector<VecT>& a, const std::vector<VecT>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const VecT& x, const VecT& y) { return all(x == y); });
+}
+} // namespace Falcor
@@ -0,0 +1,204 @@
+#include "Testing/UnitTest.h"
+#include "Scene/PlyReader.h"
+#include "Scene/TriangleMesh.h"
+#include "MeshTestUtils.h"
+#include "Core/Platform/OS.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+struct PlyLayout
+{
+    bool bigEndian = false;
+    bool quads = true;
+    bool normals = true;
+    bool texCoords = true;
+    bool doublePositions = false;
+};
+
+template<typename T>
+void append(std::string& data, T value, bool bigEndian)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (bigEndian)
+        std::reverse(bytes, bytes + sizeof(T));
+    data.append(bytes, sizeof(T));
+}
+
+/** Writes a mesh generated by generateGrid() to a binary PLY file in memory.
+    Unused vertex and face properties are added to check that they are skipped.
+*/
+std::string writePly(const GridMesh& mesh, const PlyLayout& layout)
+{
+    const size_t faceSize = layout.quads ? 6 : 3;
+    std::string data = "ply\n";
+    data += layout.bigEndian ? "format binary_big_endian 1.0\n" : "format binary_little_endian 1.0\n";
+    data += "comment Generated by PlyReaderTests\n";
+    data += fmt::format("element vertex {}\n", mesh.positions.size());
+    for (const char* name : {"x", "y", "z"})
+        data += fmt::format("property {} {}\n", layout.doublePositions ? "double" : "float", name);
+    data += "property uchar red\n";
+    if (layout.normals)
+        data += "property float nx\nproperty float ny\nproperty float nz\n";
+    if (layout.texCoords)
+        data += "property float u\nproperty float v\n";
+    data += fmt::format("element face {}\n", mesh.indices.size() / faceSize);
+    data += "property list uchar int vertex_indices\nproperty int face_indices\n";
+    data += "end_header\n";
+
+    for (size_t i = 0; i < mesh.positions.size(); ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (layout.doublePositions)
+                append<double>(data, mesh.positions[i][c], layout.bigEndian);
+            else
+                append<float>(data, mesh.positions[i][c], layout.bigEndian);
+        }
+        append<uint8_t>(data, 255, layout.bigEndian);
+        if (layout.normals)
+            for (uint32_t c = 0; c < 3; ++c)
+                append<float>(data, mesh.normals[i][c], layout.bigEndian);
+        if (layout.texCoords)
+            for (uint32_t c = 0; c < 2; ++c)
+                append<float>(data, mesh.texCoords[i][c], layout.bigEndian);
+    }
+
+    for (size_t i = 0; i < mesh.indices.size(); i += faceSize)
+    {
+        // Quads (i0, i1, i2, i3) were stored as the triangles (i0, i1, i2), (i0, i2, i3).
+        if (layout.quads)
+        {
+            append<uint8_t>(data, 4, layout.bigEndian);
+            for (size_t j : {0, 1, 2, 5})
+                append<int32_t>(data, mesh.indices[i + j], layout.bigEndian);
+        }
+        else
+        {
+            append<uint8_t>(data, 3, layout.bigEndian);
+            for (size_t j = 0; j < 3; ++j)
+                append<int32_t>(data, mesh.indices[i + j], layout.bigEndian);
+        }
+        append<int32_t>(data, (int32_t)(i / faceSize), layout.bigEndian);
+    }
+    return data;
+}
+
+std::filesystem::path writePlyFile(const std::string& data)
+{
+    std::filesystem::path path = getTempFilePath();
+    path += ".ply";
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+    return path;
+}
+} // namespace
+
+CPU_TEST(PlyReader_Layouts)
+{
+    const GridMesh expected = generateGrid(37, 19);
+
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        PlyLayout layout;
+        layout.bigEndian = (i & 1) != 0;
+        layout.quads = (i & 2) != 0;
+        layout.normals = (i & 4) != 0;
+        layout.texCoords = (i & 8) != 0;
+        layout.doublePositions = (i & 16) != 0;
+        const std::string data = writePly(expected, layout);
+
+        PlyReader::Mesh mesh;
+        ASSERT(PlyReader::read(data.data(), data.size(), mesh)) << "layout=" << i;
+        EXPECT(isEqual(mesh.positions, expected.positions)) << "layout=" << i;
+        EXPECT(mesh.indices == expected.indices) << "layout=" << i;
+        EXPECT(layout.normals ? isEqual(mesh.normals, expected.normals) : mesh.normals.empty()) << "layout=" << i;
+        EXPECT(layout.texCoords ? isEqual(mesh.texCoords, expected.texCoords) : mesh.texCoords.empty()) << "layout=" << i;
+    }
+}
+
+CPU_TEST(PlyReader_MixedPolygons)
+{
+    std::string data =
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "element vertex 5\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "element face 3\n"
+        "property list uchar uint vertex_index\n"
+        "end_header\n";
+    for (uint32_t i = 0; i < 15; ++i)
+        append<float>(data, (float)i, false);
+    const std::vector<std::vector<uint32_t>> faces = {{0, 1, 2}, {0, 1, 2, 3, 4}, {3, 4}};
+    for (const auto& face : faces)
+    {
+        append<uint8_t>(data, (uint8_t)face.size(), false);
+        for (uint32_t index : face)
+            append<uint32_t>(data, index, false);
+    }
+
+    // Polygons are fan triangulated and lines are ignored.
+    PlyReader::Mesh mesh;
+    ASSERT(PlyReader::read(data.data(), data.size(), mesh));
+    EXPECT_EQ(mesh.positions.size(), 5u);
+    EXPECT(mesh.indices == std::vector<uint32_t>({0, 1, 2, 0, 1, 2, 0, 2, 3, 0, 3, 4}));
+}
+
+CPU_TEST(PlyReader_Unsupported)
+{
+    const GridMesh grid = generateGrid(4, 4);
+    const std::string data = writePly(grid, PlyLayout());
+    PlyReader::Mesh mesh;
+
+    // Truncated face data.
+    EXPECT(!PlyReader::read(data.data(), data.size() - 3, mesh));
+    EXPECT(mesh.positions.empty());
+
+    // Out of range vertex index.
+    std::string invalid = data;
+    invalid[invalid.size() - 8] = 100;
+    EXPECT(!PlyReader::read(invalid.data(), invalid.size(), mesh));
+
+    // ASCII files are left to ASSIMP.
+    const std::string ascii = "ply\nformat ascii 1.0\nelement vertex 0\nproperty float x\nend_header\n";
+    EXPECT(!PlyReader::read(ascii.data(), ascii.size(), mesh));
+}
+
+CPU_TEST(PlyReader_MatchesAssimp)
+{
+    const GridMesh grid = generateGrid(16, 8);
+
+    for (bool normals : {false, true})
+    {
+        PlyLayout layout;
+        layout.normals = normals;
+        const std::filesystem::path path = writePlyFile(writePly(grid, layout));
+
+        for (auto flags : {TriangleMesh::ImportFlags::None, TriangleMesh::ImportFlags::GenSmoothNormals})
+        {
+            ref<TriangleMesh> pNative = TriangleMesh::createFromFile(path, flags);
+            ref<TriangleMesh> pAssimp = TriangleMesh::createFromFile(path, flags | TriangleMesh::ImportFlags::UseAssimp);
+            ASSERT(pNative && pAssimp);
+
+            // The vertices may be shared differently, so compare the triangle corners.
+            const auto& nativeIndices = pNative->getIndices();
+            const auto& assimpIndices = pAssimp->getIndices();
+            ASSERT_EQ(nativeIndices.size(), assimpIndices.size());
+            for (size_t i = 0; i < nativeIndices.size(); ++i)
+            {
+                const auto& a = pNative->getVertices()[nativeIndices[i]];
+                const auto& b = pAssimp->getVertices()[assimpIndices[i]];
+                EXPECT_LE(length(a.position - b.position), 1e-6f) << "i=" << i;
+                EXPECT_LE(length(a.texCoord - b.texCoord), 1e-6f) << "i=" << i;
+                EXPECT_LE(length(a.normal - b.normal), 1e-3f) << "i=" << i;
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+}
+} // namespace Falcor
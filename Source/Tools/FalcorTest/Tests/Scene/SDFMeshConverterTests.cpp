@@ -0,0 +1,175 @@
+#include "Testing/UnitTest.h"
+#include "Scene/SDFs/SDFMeshConverter.h"
+#include "Scene/TriangleMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+const float kSphereRadius = 0.3f;
+
+struct Mesh
+{
+    std::vector<float3> positions;
+    std::vector<uint32_t> indices;
+
+    uint32_t getTriangleCount() const { return (uint32_t)(indices.size() / 3); }
+};
+
+/** Generates a closed UV sphere centered at the origin.
+*/
+Mesh generateSphere(float radius, uint32_t segmentsU, uint32_t segmentsV)
+{
+    Mesh mesh;
+    for (uint32_t v = 0; v <= segmentsV; v++)
+    {
+        const float theta = (float)M_PI * (float)v / (float)segmentsV;
+        for (uint32_t u = 0; u < segmentsU; u++)
+        {
+            const float phi = 2.f * (float)M_PI * (float)u / (float)segmentsU;
+            mesh.positions.push_back(radius * float3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+
+    for (uint32_t v = 0; v < segmentsV; v++)
+    {
+        for (uint32_t u = 0; u < segmentsU; u++)
+        {
+            const uint32_t i0 = v * segmentsU + u;
+            const uint32_t i1 = v * segmentsU + (u + 1) % segmentsU;
+            const uint32_t i2 = i0 + segmentsU;
+            const uint32_t i3 = i1 + segmentsU;
+            mesh.indices.insert(mesh.indices.end(), {i0, i1, i2, i1, i3, i2});
+        }
+    }
+    return mesh;
+}
+
+std::vector<float> convert(const Mesh& mesh, uint32_t gridWidth, float narrowBandThickness)
+{
+    SDFMeshConverter::Options options;
+    options.narrowBandThickness = narrowBandThickness;
+    options.fitToGrid = false;
+    return SDFMeshConverter::computeCornerValues(
+        mesh.positions.data(), (uint32_t)mesh.positions.size(), mesh.indices.data(), mesh.getTriangleCount(), gridWidth, options
+    );
+}
+
+float3 getCornerPosition(size_t index, uint32_t gridWidth)
+{
+    const size_t widthInValues = gridWidth + 1;
+    const uint3 corner((uint32_t)(index % widthInValues), (uint32_t)((index / widthInValues) % widthInValues), (uint32_t)(index / (widthInValues * widthInValues)));
+    return float3(corner) / (float)gridWidth - 0.5f;
+}
+} // namespace
+
+CPU_TEST(SDFMeshConverter_Sphere)
+{
+    const uint32_t gridWidth = 32;
+    const Mesh sphere = generateSphere(kSphereRadius, 64, 32);
+    const std::vector<float> values = convert(sphere, gridWidth, 0.f);
+    EXPECT_EQ(values.size(), 33u * 33u * 33u);
+
+    // The tessellated sphere is at most 0.002 inside of the analytic one.
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        const float expected = length(getCornerPosition(i, gridWidth)) - kSphereRadius;
+        EXPECT_LE(std::abs(values[i] - expected), 3e-3f);
+        if (std::abs(expected) > 3e-3f)
+            EXPECT_EQ(values[i] < 0.f, expected < 0.f);
+    }
+}
+
+CPU_TEST(SDFMeshConverter_NarrowBand)
+{
+    const uint32_t gridWidth = 64;
+    const float narrowBandThickness = 3.f;
+    const float band = narrowBandThickness / (float)gridWidth;
+    const Mesh sphere = generateSphere(kSphereRadius, 32, 16);
+    const std::vector<float> exact = convert(sphere, gridWidth, 0.f);
+    const std::vector<float> values = convert(sphere, gridWidth, narrowBandThickness);
+    EXPECT_EQ(values.size(), exact.size());
+
+    // Values within the band are exact, others are clamped to the band with the correct sign.
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        const float expected = std::clamp(exact[i], -band, band);
+        EXPECT_EQ(values[i], expected);
+    }
+}
+
+CPU_TEST(SDFMeshConverter_Robustness)
+{
+    const uint32_t gridWidth = 32;
+    const Mesh sphere = generateSphere(kSphereRadius, 32, 16);
+    const std::vector<float> reference = convert(sphere, gridWidth, 0.f);
+
+    // Meshes with all triangles facing inwards have the same sign.
+    Mesh flipped = sphere;
+    for (size_t i = 0; i < flipped.indices.size(); i += 3)
+        std::swap(flipped.indices[i + 1], flipped.indices[i + 2]);
+    const std::vector<float> flippedValues = convert(flipped, gridWidth, 0.f);
+    EXPECT_EQ(flippedValues.size(), reference.size());
+    for (size_t i = 0; i < reference.size(); i++)
+        EXPECT_LE(std::abs(flippedValues[i] - reference[i]), 1e-6f);
+
+    // Corners away from a hole keep their sign.
+    Mesh holed = sphere;
+    holed.indices.erase(holed.indices.begin(), holed.indices.begin() + 3 * 16);
+    const std::vector<float> holedValues = convert(holed, gridWidth, 0.f);
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        if (getCornerPosition(i, gridWidth).y < 0.f)
+            EXPECT_EQ(holedValues[i] < 0.f, reference[i] < 0.f);
+    }
+}
+
+CPU_TEST(SDFMeshConverter_FitToGrid)
+{
+    const uint32_t gridWidth = 32;
+    const float padding = 2.f;
+    const AABB bounds(float3(1.f, 2.f, 3.f), float3(5.f, 4.f, 3.5f));
+    const float4x4 meshToGrid = SDFMeshConverter::computeFitTransform(bounds, gridWidth, padding);
+
+    // The largest extent fills the grid except for the padding, and the mesh is centered.
+    const float3 minPoint = transformPoint(meshToGrid, bounds.minPoint);
+    const float3 maxPoint = transformPoint(meshToGrid, bounds.maxPoint);
+    EXPECT_LE(std::abs(minPoint.x + 0.5f - padding / gridWidth), 1e-6f);
+    EXPECT_LE(std::abs(maxPoint.x - 0.5f + padding / gridWidth), 1e-6f);
+    EXPECT_LE(std::abs(minPoint.y + maxPoint.y), 1e-6f);
+    EXPECT_LE(std::abs(minPoint.z + maxPoint.z), 1e-6f);
+    EXPECT_LE(std::abs((maxPoint.y - minPoint.y) - 0.5f * (maxPoint.x - minPoint.x)), 1e-6f);
+
+    // A fitted sphere matches a sphere placed in the grid directly.
+    const Mesh sphere = generateSphere(kSphereRadius, 32, 16);
+    Mesh scaled = sphere;
+    for (float3& p : scaled.positions)
+        p = p * 10.f + float3(1.f, 2.f, 3.f);
+
+    SDFMeshConverter::Options options;
+    options.padding = 0.5f * (1.f - 2.f * kSphereRadius) * gridWidth;
+    const std::vector<float> fitted = SDFMeshConverter::computeCornerValues(
+        scaled.positions.data(), (uint32_t)scaled.positions.size(), scaled.indices.data(), scaled.getTriangleCount(), gridWidth, options
+    );
+    const std::vector<float> reference = convert(sphere, gridWidth, options.narrowBandThickness);
+    for (size_t i = 0; i < reference.size(); i++)
+        EXPECT_LE(std::abs(fitted[i] - reference[i]), 1e-5f);
+
+    // The instance transform places the fitted grid at the location of the mesh.
+    TriangleMesh::VertexList vertices;
+    for (const float3& p : scaled.positions)
+        vertices.push_back({p, normalize(p - float3(1.f, 2.f, 3.f)), float2(0.f)});
+    ref<TriangleMesh> pMesh = TriangleMesh::create(vertices, scaled.indices);
+    const float4x4 gridToMesh = SDFMeshConverter::computeInstanceTransform(*pMesh, gridWidth, options.padding).getMatrix();
+
+    AABB scaledBounds;
+    for (const float3& p : scaled.positions)
+        scaledBounds.include(p);
+    const float4x4 meshToFittedGrid = SDFMeshConverter::computeFitTransform(scaledBounds, gridWidth, options.padding);
+    for (const float3& p : scaled.positions)
+        EXPECT_LE(length(transformPoint(gridToMesh, transformPoint(meshToFittedGrid, p)) - p), 1e-4f);
+}
+} // namespace Falcor
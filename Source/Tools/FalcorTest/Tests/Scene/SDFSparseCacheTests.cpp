@@ -0,0 +1,424 @@
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Material/StandardMaterial.h"
+#include "Scene/SDFs/SDFSparseCache.h"
+#include "Scene/SDFs/SparseBrickSet/SDFSBS.h"
+#include "Scene/SDFs/SparseVoxelOctree/SDFSVO.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+const float kSphereRadius = 0.3f;
+
+std::vector<float> generateSphereValues(uint32_t gridWidth)
+{
+    const uint32_t widthInValues = gridWidth + 1;
+    std::vector<float> values;
+    values.reserve((size_t)widthInValues * widthInValues * widthInValues);
+    for (uint32_t z = 0; z < widthInValues; z++)
+        for (uint32_t y = 0; y < widthInValues; y++)
+            for (uint32_t x = 0; x < widthInValues; x++)
+                values.push_back(length(float3(uint3(x, y, z)) / (float)gridWidth - 0.5f) - kSphereRadius);
+    return values;
+}
+
+struct QuantizedGrid
+{
+    std::vector<int8_t> values;
+    uint32_t gridWidth;
+
+    int8_t get(uint32_t x, uint32_t y, uint32_t z) const
+    {
+        const uint32_t widthInValues = gridWidth + 1;
+        return values[x + widthInValues * (y + (size_t)widthInValues * z)];
+    }
+
+    bool containsSurface(uint32_t x, uint32_t y, uint32_t z, uint32_t voxelWidth) const
+    {
+        int8_t minValue = INT8_MAX;
+        int8_t maxValue = INT8_MIN;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            const int8_t value = get(x + voxelWidth * (i >> 2), y + voxelWidth * ((i >> 1) & 1), z + voxelWidth * (i & 1));
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+        return minValue <= 0 && maxValue >= 0;
+    }
+};
+
+/** Decodes a BC4Snorm block.
+*/
+void decodeBC4Snorm(uint64_t block, int* values)
+{
+    const int red0 = (int8_t)(block & 0xff);
+    const int red1 = (int8_t)((block >> 8) & 0xff);
+    float palette[8] = {(float)red0, (float)red1};
+    if (red0 > red1)
+    {
+        for (int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * red0 + i * red1) / 7.f;
+    }
+    else
+    {
+        for (int i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * red0 + i * red1) / 5.f;
+        palette[6] = -127.f;
+        palette[7] = 127.f;
+    }
+    for (int i = 0; i < 16; i++) values[i] = (int)std::round(palette[(block >> (16 + 3 * i)) & 0x7]);
+}
+
+uint64_t getLocationCode(const SDFSVOVoxel& voxel)
+{
+    return voxel.locationCode.x | ((uint64_t)voxel.locationCode.y << 32);
+}
+
+uint32_t getLevel(uint64_t locationCode)
+{
+    return (uint32_t)(locationCode >> 57) & 0x1f;
+}
+
+template<typename T>
+bool equal(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+bool isNearlyEqual(const std::vector<AABB>& a, const std::vector<AABB>& b)
+{
+    auto isNearlyEqualAABB = [](const AABB& x, const AABB& y)
+    { return all(abs(x.minPoint - y.minPoint) <= 1e-6f) && all(abs(x.maxPoint - y.maxPoint) <= 1e-6f); };
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), isNearlyEqualAABB);
+}
+
+/** Adds an SDF grid to a scene and returns the grid of the created scene.
+*/
+ref<SDFGrid> createSceneGrid(ref<Device> pDevice, const ref<SDFGrid>& pSDFGrid, ref<Scene>& pScene)
+{
+    SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::None);
+    const SdfDescID sdfDescID = builder.addSDFGrid(pSDFGrid, StandardMaterial::create(pDevice, "sdf"));
+    SceneBuilder::Node node;
+    node.name = "sdf";
+    builder.addSDFGridInstance(builder.addNode(node), sdfDescID);
+    pScene = builder.getScene();
+    return pScene && pScene->getSDFGridCount() == 1 ? pScene->getSDFGrid(SdfGridID{0}) : nullptr;
+}
+} // namespace
+
+CPU_TEST(SDFSparseCache_SBS)
+{
+    // The grid width is not a multiple of the brick width, so the last bricks along each axis are partial.
+    const uint32_t gridWidth = 40;
+    const uint32_t brickWidth = 7;
+    const std::vector<float> cornerValues = generateSphereValues(gridWidth);
+    const QuantizedGrid grid{SDFSparseCache::quantizeValues(cornerValues, gridWidth), gridWidth};
+    const SDFSBSData data = SDFSparseCache::buildSBS(cornerValues, gridWidth, brickWidth, false);
+
+    const uint32_t virtualBricksPerAxis = 6;
+    EXPECT_EQ(data.virtualBricksPerAxis, virtualBricksPerAxis);
+    EXPECT_EQ(data.indirection.size(), (size_t)virtualBricksPerAxis * virtualBricksPerAxis * virtualBricksPerAxis);
+    EXPECT_EQ(data.brickAABBs.size(), (size_t)data.brickCount);
+    EXPECT_EQ(data.brickTexture.size(), (size_t)data.brickTextureDimensions.x * data.brickTextureDimensions.y);
+    EXPECT_GE(data.bricksPerAxis.x * data.bricksPerAxis.y, data.brickCount);
+
+    // Bricks are valid if a voxel contains the surface and are numbered in virtual brick order.
+    std::vector<bool> valid(data.indirection.size(), false);
+    for (uint32_t z = 0; z < gridWidth; z++)
+        for (uint32_t y = 0; y < gridWidth; y++)
+            for (uint32_t x = 0; x < gridWidth; x++)
+                if (grid.containsSurface(x, y, z, 1))
+                    valid[x / brickWidth + virtualBricksPerAxis * (y / brickWidth + virtualBricksPerAxis * (z / brickWidth))] = true;
+
+    uint32_t brickCount = 0;
+    for (size_t i = 0; i < data.indirection.size(); i++)
+        EXPECT_EQ(data.indirection[i], valid[i] ? brickCount++ : UINT32_MAX);
+    EXPECT_EQ(data.brickCount, brickCount);
+    EXPECT_GT(brickCount, 0u);
+
+    // Brick values are stored in z-slices next to each other, values outside of the grid are set to the maximum distance.
+    const uint32_t brickWidthInValues = brickWidth + 1;
+    for (uint32_t virtualBrickID = 0; virtualBrickID < data.indirection.size(); virtualBrickID++)
+    {
+        const uint32_t brickID = data.indirection[virtualBrickID];
+        if (brickID == UINT32_MAX) continue;
+
+        const uint3 brickGridCoords = brickWidth * uint3(virtualBrickID % virtualBricksPerAxis, (virtualBrickID / virtualBricksPerAxis) % virtualBricksPerAxis, virtualBrickID / (virtualBricksPerAxis * virtualBricksPerAxis));
+        const float3 aabbMin = float3(brickGridCoords) / (float)gridWidth - 0.5f;
+        EXPECT_LE(std::abs(data.brickAABBs[brickID].minPoint.x - aabbMin.x), 1e-6f);
+        EXPECT_LE(std::abs(data.brickAABBs[brickID].minPoint.y - aabbMin.y), 1e-6f);
+        EXPECT_LE(std::abs(data.brickAABBs[brickID].minPoint.z - aabbMin.z), 1e-6f);
+        EXPECT_LE(data.brickAABBs[brickID].maxPoint.x, 0.5f);
+
+        const uint32_t textureX = (brickID % data.bricksPerAxis.x) * brickWidthInValues * brickWidthInValues;
+        const uint32_t textureY = (brickID / data.bricksPerAxis.x) * brickWidthInValues;
+        for (uint32_t z = 0; z < brickWidthInValues; z++)
+        {
+            for (uint32_t y = 0; y < brickWidthInValues; y++)
+            {
+                for (uint32_t x = 0; x < brickWidthInValues; x++)
+                {
+                    const uint3 gridCoords = brickGridCoords + uint3(x, y, z);
+                    const bool inside = gridCoords.x < gridWidth && gridCoords.y < gridWidth && gridCoords.z < gridWidth;
+                    const int8_t expected = inside ? grid.get(gridCoords.x, gridCoords.y, gridCoords.z) : INT8_MAX;
+                    const size_t texel = (size_t)(textureY + y) * data.brickTextureDimensions.x + textureX + x + z * brickWidthInValues;
+                    EXPECT_EQ((int8_t)data.brickTexture[texel], expected);
+                }
+            }
+        }
+    }
+}
+
+CPU_TEST(SDFSparseCache_SBSCompressed)
+{
+    const uint32_t gridWidth = 40;
+    const uint32_t brickWidth = 7;
+    const std::vector<float> cornerValues = generateSphereValues(gridWidth);
+    const SDFSBSData reference = SDFSparseCache::buildSBS(cornerValues, gridWidth, brickWidth, false);
+    const SDFSBSData data = SDFSparseCache::buildSBS(cornerValues, gridWidth, brickWidth, true);
+
+    // Compression only changes the brick texture.
+    EXPECT(data.indirection == reference.indirection);
+    EXPECT_EQ(data.brickCount, reference.brickCount);
+    EXPECT(all(data.bricksPerAxis == reference.bricksPerAxis));
+    EXPECT(all(data.brickTextureDimensions == reference.brickTextureDimensions));
+
+    const uint2 blockDimensions = data.brickTextureDimensions / 4u;
+    EXPECT_EQ(data.brickTexture.size(), (size_t)blockDimensions.x * blockDimensions.y * sizeof(uint64_t));
+
+    // Decoded blocks match the uncompressed texels within the quantization error of the block.
+    double errorSum = 0.0;
+    for (uint32_t blockY = 0; blockY < blockDimensions.y; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < blockDimensions.x; blockX++)
+        {
+            uint64_t block;
+            std::memcpy(&block, &data.brickTexture[((size_t)blockY * blockDimensions.x + blockX) * sizeof(uint64_t)], sizeof(uint64_t));
+            int decoded[16];
+            decodeBC4Snorm(block, decoded);
+
+            int expected[16];
+            for (uint32_t i = 0; i < 16; i++)
+                expected[i] = (int8_t)reference.brickTexture[(size_t)(4 * blockY + i / 4) * data.brickTextureDimensions.x + 4 * blockX + i % 4];
+            const int range = *std::max_element(expected, expected + 16) - *std::min_element(expected, expected + 16);
+
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                EXPECT_LE(std::abs(decoded[i] - expected[i]), range / 8 + 2);
+                errorSum += std::abs(decoded[i] - expected[i]);
+            }
+        }
+    }
+    EXPECT_LE(errorSum / (16.0 * blockDimensions.x * blockDimensions.y), 1.0);
+}
+
+CPU_TEST(SDFSparseCache_SVO)
+{
+    const uint32_t gridWidth = 32;
+    const std::vector<float> cornerValues = generateSphereValues(gridWidth);
+    const QuantizedGrid grid{SDFSparseCache::quantizeValues(cornerValues, gridWidth), gridWidth};
+    const SDFSVOData data = SDFSparseCache::buildSVO(cornerValues, gridWidth);
+    EXPECT_EQ(data.levelCount, 6u);
+
+    // Voxels are sorted by location code, starting with the root.
+    EXPECT(!data.voxels.empty());
+    EXPECT_EQ(getLevel(getLocationCode(data.voxels[0])), 0u);
+    for (size_t i = 1; i < data.voxels.size(); i++)
+        EXPECT_LT(getLocationCode(data.voxels[i - 1]), getLocationCode(data.voxels[i]));
+
+    uint32_t finestVoxelCount = 0;
+    for (uint32_t z = 0; z < gridWidth; z++)
+        for (uint32_t y = 0; y < gridWidth; y++)
+            for (uint32_t x = 0; x < gridWidth; x++)
+                if (grid.containsSurface(x, y, z, 1)) finestVoxelCount++;
+
+    // Children are consecutive and follow the order of the valid mask, leaves are the surface voxels of the finest level.
+    uint32_t leafCount = 0;
+    for (const SDFSVOVoxel& voxel : data.voxels)
+    {
+        const uint64_t locationCode = getLocationCode(voxel);
+        EXPECT_EQ(locationCode >> 63, 1ull);
+
+        const uint32_t level = getLevel(locationCode);
+        const uint32_t validMask = voxel.relationData & 0xff;
+        if (level == data.levelCount - 1)
+        {
+            EXPECT_EQ(voxel.relationData, 0u);
+            leafCount++;
+            continue;
+        }
+
+        EXPECT_NE(validMask, 0u);
+        uint32_t childIndex = voxel.relationData >> 8;
+        for (uint32_t childID = 0; childID < 8; childID++)
+        {
+            if ((validMask & (1u << childID)) == 0) continue;
+
+            // The child location code has the level incremented and the child ID added below the coordinates of the parent.
+            const uint32_t childLevel = level + 1;
+            uint64_t expected = locationCode & ((1ull << 57) - 1);
+            expected |= (uint64_t)childID << (57 - 3 * childLevel);
+            expected |= ((uint64_t)childLevel << 57) | (1ull << 63);
+            EXPECT_LT(childIndex, (uint32_t)data.voxels.size());
+            EXPECT_EQ(getLocationCode(data.voxels[childIndex]), expected);
+            childIndex++;
+        }
+    }
+    EXPECT_EQ(leafCount, finestVoxelCount);
+
+    // The root stores the corners of the whole grid.
+    const uint2 rootValues = data.voxels[0].packedValues;
+    EXPECT_EQ((int8_t)(rootValues.x & 0xff), grid.get(0, 0, 0));
+    EXPECT_EQ((int8_t)((rootValues.x >> 8) & 0xff), grid.get(0, 0, gridWidth));
+    EXPECT_EQ((int8_t)((rootValues.x >> 16) & 0xff), grid.get(0, gridWidth, 0));
+    EXPECT_EQ((int8_t)(rootValues.y >> 24), grid.get(gridWidth, gridWidth, gridWidth));
+}
+
+CPU_TEST(SDFSparseCache_RoundTrip)
+{
+    const uint32_t gridWidth = 32;
+    const std::vector<float> cornerValues = generateSphereValues(gridWidth);
+    const std::filesystem::path path = getTempFilePath();
+
+    for (bool compressed : {false, true})
+    {
+        const SDFSBSData data = SDFSparseCache::buildSBS(cornerValues, gridWidth, 7, compressed);
+        EXPECT(SDFSparseCache::writeSBS(path, data));
+
+        SDFSBSData loaded;
+        EXPECT(SDFSparseCache::readSBS(path, loaded));
+        EXPECT_EQ(loaded.gridWidth, data.gridWidth);
+        EXPECT_EQ(loaded.brickWidth, data.brickWidth);
+        EXPECT_EQ(loaded.compressed, compressed);
+        EXPECT_EQ(loaded.virtualBricksPerAxis, data.virtualBricksPerAxis);
+        EXPECT_EQ(loaded.brickCount, data.brickCount);
+        EXPECT(all(loaded.bricksPerAxis == data.bricksPerAxis));
+        EXPECT(all(loaded.brickTextureDimensions == data.brickTextureDimensions));
+        EXPECT(equal(loaded.indirection, data.indirection));
+        EXPECT(equal(loaded.brickAABBs, data.brickAABBs));
+        EXPECT(equal(loaded.brickTexture, data.brickTexture));
+
+        // A sparse brick set file is not a valid sparse voxel octree file.
+        SDFSVOData svo;
+        EXPECT(!SDFSparseCache::readSVO(path, svo));
+    }
+
+    const SDFSVOData data = SDFSparseCache::buildSVO(cornerValues, gridWidth);
+    EXPECT(SDFSparseCache::writeSVO(path, data));
+
+    SDFSVOData loaded;
+    EXPECT(SDFSparseCache::readSVO(path, loaded));
+    EXPECT_EQ(loaded.gridWidth, data.gridWidth);
+    EXPECT_EQ(loaded.levelCount, data.levelCount);
+    EXPECT(equal(loaded.voxels, data.voxels));
+
+    // Truncated files are rejected.
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    EXPECT(!SDFSparseCache::readSVO(path, loaded));
+
+    std::filesystem::remove(path);
+}
+
+GPU_TEST(SDFSparseCache_MatchesGPU)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    const uint32_t gridWidth = 32;
+    const std::vector<float> cornerValues = generateSphereValues(gridWidth);
+
+    for (bool compressed : {false, true})
+    {
+        ref<SDFSBS> pSBS = SDFSBS::create(pDevice, 7, compressed);
+        pSBS->setValues(cornerValues, gridWidth);
+        pSBS->createResources(pRenderContext);
+        const SDFSBSData gpu = pSBS->readSparseData(pRenderContext);
+        const SDFSBSData cpu = SDFSparseCache::buildSBS(cornerValues, gridWidth, 7, compressed);
+
+        EXPECT_EQ(cpu.virtualBricksPerAxis, gpu.virtualBricksPerAxis) << "compressed=" << compressed;
+        EXPECT_EQ(cpu.brickCount, gpu.brickCount) << "compressed=" << compressed;
+        EXPECT(all(cpu.bricksPerAxis == gpu.bricksPerAxis)) << "compressed=" << compressed;
+        EXPECT(all(cpu.brickTextureDimensions == gpu.brickTextureDimensions)) << "compressed=" << compressed;
+        EXPECT(equal(cpu.indirection, gpu.indirection)) << "compressed=" << compressed;
+        EXPECT(isNearlyEqual(cpu.brickAABBs, gpu.brickAABBs)) << "compressed=" << compressed;
+        EXPECT_EQ(cpu.brickTexture.size(), gpu.brickTexture.size()) << "compressed=" << compressed;
+
+        // The GPU compresses bricks with its own BC4 encoder, so only uncompressed bricks are identical.
+        if (!compressed)
+            EXPECT(equal(cpu.brickTexture, gpu.brickTexture));
+    }
+
+    ref<SDFSVO> pSVO = SDFSVO::create(pDevice);
+    pSVO->setValues(cornerValues, gridWidth);
+    pSVO->createResources(pRenderContext);
+    const SDFSVOData gpu = pSVO->readSparseData();
+    const SDFSVOData cpu = SDFSparseCache::buildSVO(cornerValues, gridWidth);
+    EXPECT_EQ(cpu.levelCount, gpu.levelCount);
+    EXPECT(equal(cpu.voxels, gpu.voxels));
+}
+
+GPU_TEST(SDFSparseCache_LoadSparseData)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    const uint32_t gridWidth = 32;
+    const std::vector<float> cornerValues = generateSphereValues(gridWidth);
+    const std::filesystem::path path = getTempFilePath();
+
+    // Grids loaded from sparse files are uploaded by the scene and configure the scene shaders like grids built from values.
+    {
+        const SDFSBSData data = SDFSparseCache::buildSBS(cornerValues, gridWidth, 7, false);
+        ASSERT(SDFSparseCache::writeSBS(path, data));
+
+        ref<SDFSBS> pLoaded = SDFSBS::create(pDevice);
+        ASSERT(pLoaded->loadSparseDataFromFile(path));
+        ref<Scene> pScene;
+        auto pSBS = dynamic_ref_cast<SDFSBS>(createSceneGrid(pDevice, pLoaded, pScene));
+        ASSERT(pSBS != nullptr);
+        pScene->update(pRenderContext, 0.0);
+
+        const SDFSBSData loaded = pSBS->readSparseData(pRenderContext);
+        EXPECT_EQ(loaded.gridWidth, gridWidth);
+        EXPECT(equal(loaded.indirection, data.indirection));
+        EXPECT(equal(loaded.brickAABBs, data.brickAABBs));
+        EXPECT(equal(loaded.brickTexture, data.brickTexture));
+        EXPECT_EQ(pSBS->getAABBCount(), data.brickCount);
+        EXPECT(equal(pSBS->getAABBBuffer()->getElements<AABB>(0, data.brickCount), data.brickAABBs));
+
+        ref<SDFSBS> pBuilt = SDFSBS::create(pDevice);
+        pBuilt->setValues(cornerValues, gridWidth);
+        pBuilt->createResources(pRenderContext);
+        EXPECT_EQ(pSBS->getVirtualBrickCoordsBitCount(), pBuilt->getVirtualBrickCoordsBitCount());
+        EXPECT_EQ(pSBS->getBrickLocalVoxelCoordsBrickCount(), pBuilt->getBrickLocalVoxelCoordsBrickCount());
+        EXPECT_EQ(pSBS->getMaxPrimitiveIDBits(), pBuilt->getMaxPrimitiveIDBits());
+    }
+
+    {
+        const SDFSVOData data = SDFSparseCache::buildSVO(cornerValues, gridWidth);
+        ASSERT(SDFSparseCache::writeSVO(path, data));
+
+        ref<SDFSVO> pLoaded = SDFSVO::create(pDevice);
+        ASSERT(pLoaded->loadSparseDataFromFile(path));
+        ref<Scene> pScene;
+        auto pSVO = dynamic_ref_cast<SDFSVO>(createSceneGrid(pDevice, pLoaded, pScene));
+        ASSERT(pSVO != nullptr);
+        pScene->update(pRenderContext, 0.0);
+
+        const SDFSVOData loaded = pSVO->readSparseData();
+        EXPECT_EQ(loaded.gridWidth, gridWidth);
+        EXPECT_EQ(loaded.levelCount, data.levelCount);
+        EXPECT(equal(loaded.voxels, data.voxels));
+
+        ref<SDFSVO> pBuilt = SDFSVO::create(pDevice);
+        pBuilt->setValues(cornerValues, gridWidth);
+        pBuilt->createResources(pRenderContext);
+        EXPECT_EQ(pSVO->getMaxPrimitiveIDBits(), pBuilt->getMaxPrimitiveIDBits());
+    }
+
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
@@ -0,0 +1,218 @@
+#include "Testing/UnitTest.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/SceneCache.h"
+#include "Scene/SceneMeshletData.h"
+#include "Scene/Material/StandardMaterial.h"
+#include "Core/Platform/OS.h"
+#include "MeshTestUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+// Grid sizes of the test meshes. The meshes differ in size, so that the parallel build finishes them out of order.
+const uint2 kGridSizes[] = {{1, 1}, {16, 8}, {64, 64}, {100, 37}};
+
+ref<TriangleMesh> createGridMesh(uint2 size)
+{
+    const GridMesh grid = generateGrid(size.x, size.y);
+    TriangleMesh::VertexList vertices;
+    for (size_t i = 0; i < grid.positions.size(); ++i)
+        vertices.push_back({grid.positions[i], grid.normals[i], grid.texCoords[i]});
+    return TriangleMesh::create(vertices, grid.indices);
+}
+
+/** Creates a scene with one instance of each test mesh.
+*/
+ref<Scene> createGridScene(ref<Device> pDevice)
+{
+    SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::DontMergeMeshes);
+    ref<StandardMaterial> pMaterial = StandardMaterial::create(pDevice, "grid");
+    for (size_t i = 0; i < std::size(kGridSizes); ++i)
+    {
+        const MeshID meshID = builder.addTriangleMesh(createGridMesh(kGridSizes[i]), pMaterial);
+        SceneBuilder::Node node;
+        node.name = "grid" + std::to_string(i);
+        node.transform = math::matrixFromTranslation(float3((float)i, 0.f, 0.f));
+        builder.addMeshInstance(builder.addNode(node), meshID);
+    }
+    return builder.getScene();
+}
+
+/** Builds the meshlets of all test meshes one after another.
+*/
+std::vector<MeshMeshletData> buildGridMeshlets()
+{
+    std::vector<MeshMeshletData> meshletData(std::size(kGridSizes));
+    for (size_t i = 0; i < meshletData.size(); ++i)
+    {
+        const GridMesh grid = generateGrid(kGridSizes[i].x, kGridSizes[i].y);
+        SceneMeshletData::buildMeshletsForMesh(grid.indices, grid.positions, meshletData[i]);
+    }
+    return meshletData;
+}
+
+/** Reads back the triangle indices and vertex positions of a scene mesh.
+*/
+void readMeshGeometry(ref<Device> pDevice, Scene& scene, MeshID meshID, std::vector<uint32_t>& flatIndices, std::vector<float3>& positions)
+{
+    const auto& meshDesc = scene.getMesh(meshID);
+    const uint32_t vertexCount = meshDesc.vertexCount;
+    const uint32_t triangleCount = meshDesc.getTriangleCount();
+    const auto bindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess;
+
+    std::map<std::string, ref<Buffer>> buffers;
+    buffers["triangleIndices"] = pDevice->createStructuredBuffer(sizeof(uint3), triangleCount, bindFlags, MemoryType::DeviceLocal);
+    buffers["positions"] = pDevice->createStructuredBuffer(sizeof(float3), vertexCount, bindFlags, MemoryType::DeviceLocal);
+    buffers["texcrds"] = pDevice->createStructuredBuffer(sizeof(float2), vertexCount, bindFlags, MemoryType::DeviceLocal);
+    scene.getMeshVerticesAndIndices(meshID, buffers);
+
+    flatIndices = buffers["triangleIndices"]->getElements<uint32_t>(0, triangleCount * 3);
+    positions = buffers["positions"]->getElements<float3>(0, vertexCount);
+}
+
+bool isEqualMeshlets(const MeshMeshletData& a, const MeshMeshletData& b)
+{
+    return a.meshletVertices == b.meshletVertices && a.meshletTriangles == b.meshletTriangles &&
+           a.meshletVertexOffset == b.meshletVertexOffset && a.meshletTriangleOffset == b.meshletTriangleOffset &&
+           a.meshletVertexCount == b.meshletVertexCount && a.meshletTriangleCount == b.meshletTriangleCount &&
+           isEqual(a.meshletBoundCenter, b.meshletBoundCenter) && a.meshletBoundRadius == b.meshletBoundRadius;
+}
+
+bool isEqualMeshlets(const std::vector<MeshMeshletData>& a, const std::vector<MeshMeshletData>& b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](const MeshMeshletData& x, const MeshMeshletData& y) { return isEqualMeshlets(x, y); });
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& data)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size());
+}
+} // namespace
+
+GPU_TEST(SceneMeshletData_Build)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    ref<Scene> pScene = createGridScene(pDevice);
+    ASSERT(pScene != nullptr);
+    ASSERT_EQ(pScene->getMeshCount(), (uint32_t)std::size(kGridSizes));
+
+    SceneMeshletData* pMeshletData = pScene->getMeshletData(ctx.getRenderContext());
+    ASSERT(pMeshletData != nullptr);
+
+    // The meshes are built in parallel. Compare each mesh with building its meshlets on its own.
+    uint32_t meshletCount = 0;
+    for (MeshID meshID{0}; meshID.get() < pScene->getMeshCount(); ++meshID)
+    {
+        std::vector<uint32_t> flatIndices;
+        std::vector<float3> positions;
+        readMeshGeometry(pDevice, *pScene, meshID, flatIndices, positions);
+
+        MeshMeshletData expected;
+        SceneMeshletData::buildMeshletsForMesh(flatIndices, positions, expected);
+        EXPECT_GT(expected.meshletVertexCount.size(), 0u) << "mesh=" << meshID.get();
+        EXPECT(isEqualMeshlets(pMeshletData->getMeshMeshletData(meshID), expected)) << "mesh=" << meshID.get();
+        meshletCount += (uint32_t)expected.meshletVertexCount.size();
+    }
+    EXPECT_EQ(pMeshletData->getMeshletCount(), meshletCount);
+}
+
+GPU_TEST(SceneMeshletData_ClusterLOD)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    ref<Scene> pScene = createGridScene(pDevice);
+    ASSERT(pScene != nullptr);
+
+    SceneMeshletData* pMeshletData = pScene->getMeshletData(ctx.getRenderContext());
+    ASSERT(pMeshletData != nullptr);
+    EXPECT(!pMeshletData->hasClusterLOD());
+
+    // The DAGs are built on request, after the meshlets.
+    pMeshletData = pScene->getMeshletData(ctx.getRenderContext(), true);
+    ASSERT(pMeshletData != nullptr);
+    ASSERT(pMeshletData->hasClusterLOD());
+
+    // The meshes are built in parallel. Compare each mesh with building its DAG on its own.
+    size_t rootCount = 0;
+    for (MeshID meshID{0}; meshID.get() < pScene->getMeshCount(); ++meshID)
+    {
+        std::vector<uint32_t> flatIndices;
+        std::vector<float3> positions;
+        readMeshGeometry(pDevice, *pScene, meshID, flatIndices, positions);
+
+        const MeshClusterLOD expected = ClusterLODBuilder::build(flatIndices, positions, SceneMeshletData::getClusterLODOptions());
+        const MeshClusterLOD& clusterLOD = pMeshletData->getMeshClusterLOD(meshID);
+        EXPECT_EQ(clusterLOD.levelCount, expected.levelCount) << "mesh=" << meshID.get();
+        EXPECT_EQ(clusterLOD.clusters.size(), expected.clusters.size()) << "mesh=" << meshID.get();
+        EXPECT(clusterLOD.vertices == expected.vertices) << "mesh=" << meshID.get();
+        EXPECT(clusterLOD.triangles == expected.triangles) << "mesh=" << meshID.get();
+        rootCount += std::count_if(
+            clusterLOD.clusters.begin(), clusterLOD.clusters.end(), [](const ClusterLODCluster& cluster) { return std::isinf(cluster.parent.error); }
+        );
+    }
+
+    // From far away, any error is acceptable and the cut holds the roots of all instances.
+    std::vector<uint2> selected;
+    pMeshletData->selectClusters(float3(0.f, 1e4f, 0.f), 1.f, 1e30f, selected);
+    EXPECT_EQ(selected.size(), rootCount);
+    for (const uint2& cluster : selected)
+    {
+        const MeshID meshID{pScene->getGeometryInstance(cluster.x).geometryID};
+        EXPECT(std::isinf(pMeshletData->getMeshClusterLOD(meshID).clusters[cluster.y].parent.error)) << "instance=" << cluster.x;
+    }
+}
+
+CPU_TEST(SceneMeshletData_Cache)
+{
+    const std::string keyName = getTempFilePath().string();
+    const SceneCache::Key key = SHA1::compute(keyName.data(), keyName.size());
+    const std::filesystem::path cachePath = SceneCache::getSidecarCachePath(key, ".meshlets");
+    const std::vector<MeshMeshletData> expected = buildGridMeshlets();
+
+    // Round trip.
+    SceneCache::writeMeshletCache(key, expected);
+    ASSERT(std::filesystem::exists(cachePath));
+    std::vector<MeshMeshletData> meshletData;
+    EXPECT(SceneCache::readMeshletCache(key, meshletData));
+    EXPECT(isEqualMeshlets(meshletData, expected));
+
+    // Corrupt caches are rejected and removed, so that the meshlets are rebuilt.
+    auto expectRemoved = [&](const std::string& name)
+    {
+        std::vector<MeshMeshletData> data(1);
+        EXPECT(!SceneCache::readMeshletCache(key, data)) << name;
+        EXPECT(data.empty()) << name;
+        EXPECT(!std::filesystem::exists(cachePath)) << name;
+    };
+
+    const std::string cache = readFile(cachePath);
+
+    // Truncated compressed data.
+    writeFile(cachePath, cache.substr(0, cache.size() / 2));
+    expectRemoved("truncated");
+
+    // Damaged LZ4 frame.
+    const size_t frameOffset = cache.find("\x04\x22\x4d\x18", 0, 4);
+    ASSERT(frameOffset != std::string::npos);
+    std::string damaged = cache;
+    damaged[frameOffset] ^= 0xff;
+    writeFile(cachePath, damaged);
+    expectRemoved("damaged frame");
+
+    // Well-formed cache with a meshlet outside the mesh's data.
+    std::vector<MeshMeshletData> outOfBounds = expected;
+    outOfBounds.back().meshletVertexOffset.back() = (uint32_t)outOfBounds.back().meshletVertices.size();
+    SceneCache::writeMeshletCache(key, outOfBounds);
+    expectRemoved("out of bounds");
+
+    // Per-meshlet arrays of different sizes.
+    std::vector<MeshMeshletData> mismatched = expected;
+    mismatched.front().meshletBoundRadius.pop_back();
+    SceneCache::writeMeshletCache(key, mismatched);
+    expectRemoved("mismatched");
+}
+} // namespace Falcor
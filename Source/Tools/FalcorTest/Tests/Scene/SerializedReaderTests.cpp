@@ -0,0 +1,236 @@
+#include "Testing/UnitTest.h"
+#include "Scene/SerializedReader.h"
+#include "MeshTestUtils.h"
+#include "Core/Platform/OS.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+const uint16_t kFormatIdentifier = 0x041C;
+
+enum ShapeFlags : uint32_t
+{
+    HasNormals = 0x0001,
+    HasTexCoords = 0x0002,
+    FaceNormals = 0x0010,
+    SinglePrecision = 0x1000,
+    DoublePrecision = 0x2000,
+};
+
+template<typename T>
+void append(std::string& data, T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    data.append(bytes, sizeof(T));
+}
+
+/** Wraps data into a zlib stream of uncompressed (stored) blocks.
+*/
+std::string zlibStore(const std::string& data)
+{
+    std::string stream = {0x78, 0x01};
+    size_t pos = 0;
+    do
+    {
+        const uint16_t length = (uint16_t)std::min<size_t>(data.size() - pos, 0xffff);
+        stream.push_back(pos + length == data.size() ? 1 : 0);
+        append<uint16_t>(stream, length);
+        append<uint16_t>(stream, (uint16_t)~length);
+        stream.append(data, pos, length);
+        pos += length;
+    } while (pos < data.size());
+
+    // The stream ends with the big-endian Adler-32 checksum of the data.
+    uint32_t a = 1, b = 0;
+    for (char c : data)
+    {
+        a = (a + (uint8_t)c) % 65521;
+        b = (b + a) % 65521;
+    }
+    const uint32_t checksum = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8)
+        stream.push_back((char)(checksum >> shift));
+    return stream;
+}
+
+/** Writes a mesh generated by generateGrid() as a shape of a serialized file.
+*/
+std::string writeShape(const GridMesh& mesh, uint16_t version, uint32_t flags)
+{
+    const bool doublePrecision = (flags & DoublePrecision) != 0;
+    auto appendVectors = [&](std::string& data, const auto& vectors)
+    {
+        for (const auto& v : vectors)
+        {
+            for (int c = 0; c < (int)v.length(); ++c)
+            {
+                if (doublePrecision)
+                    append<double>(data, v[c]);
+                else
+                    append<float>(data, v[c]);
+            }
+        }
+    };
+
+    std::string data;
+    append<uint32_t>(data, flags);
+    if (version == 4)
+        data.append("grid", 5);
+    append<uint64_t>(data, mesh.positions.size());
+    append<uint64_t>(data, mesh.indices.size() / 3);
+    appendVectors(data, mesh.positions);
+    if (flags & HasNormals)
+        appendVectors(data, mesh.normals);
+    if (flags & HasTexCoords)
+        appendVectors(data, mesh.texCoords);
+    data.append(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+
+    std::string shape;
+    append<uint16_t>(shape, kFormatIdentifier);
+    append<uint16_t>(shape, version);
+    return shape + zlibStore(data);
+}
+
+/** Writes a serialized file with one shape per flags value.
+*/
+std::filesystem::path writeSerializedFile(const GridMesh& mesh, uint16_t version, const std::vector<uint32_t>& shapeFlags)
+{
+    std::string data;
+    std::vector<uint64_t> offsets;
+    for (uint32_t flags : shapeFlags)
+    {
+        offsets.push_back(data.size());
+        data += writeShape(mesh, version, flags);
+    }
+    for (uint64_t offset : offsets)
+    {
+        if (version == 4)
+            append<uint64_t>(data, offset);
+        else
+            append<uint32_t>(data, (uint32_t)offset);
+    }
+    append<uint32_t>(data, (uint32_t)offsets.size());
+
+    std::filesystem::path path = getTempFilePath();
+    path += ".serialized";
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+    return path;
+}
+
+std::vector<float3> getPositions(const TriangleMesh& mesh)
+{
+    std::vector<float3> positions;
+    for (const auto& vertex : mesh.getVertices())
+        positions.push_back(vertex.position);
+    return positions;
+}
+} // namespace
+
+CPU_TEST(SerializedReader_Versions)
+{
+    // The grid has more vertices than the reader converts per chunk.
+    const GridMesh expected = generateGrid(80, 60);
+    const std::vector<uint32_t> shapeFlags = {
+        HasNormals | HasTexCoords | SinglePrecision,
+        HasNormals | HasTexCoords | DoublePrecision,
+        HasNormals | SinglePrecision,
+    };
+
+    for (uint16_t version : {3, 4})
+    {
+        const std::filesystem::path path = writeSerializedFile(expected, version, shapeFlags);
+        SerializedReader reader(path);
+        ASSERT_EQ(reader.getShapeCount(), (uint32_t)shapeFlags.size());
+
+        for (uint32_t i = 0; i < reader.getShapeCount(); ++i)
+        {
+            ref<TriangleMesh> pMesh = reader.loadShape(i, false);
+            ASSERT(pMesh != nullptr);
+            std::vector<float3> normals;
+            std::vector<float2> texCoords;
+            for (const auto& vertex : pMesh->getVertices())
+            {
+                normals.push_back(vertex.normal);
+                texCoords.push_back(vertex.texCoord);
+            }
+
+            EXPECT(isEqual(getPositions(*pMesh), expected.positions)) << "version=" << version << " shape=" << i;
+            EXPECT(pMesh->getIndices() == expected.indices) << "version=" << version << " shape=" << i;
+            EXPECT(isEqual(normals, expected.normals)) << "version=" << version << " shape=" << i;
+            if (shapeFlags[i] & HasTexCoords)
+                EXPECT(isEqual(texCoords, expected.texCoords)) << "version=" << version << " shape=" << i;
+            else
+                EXPECT(std::all_of(texCoords.begin(), texCoords.end(), [](float2 uv) { return all(uv == float2(0.f)); }));
+        }
+
+        EXPECT_THROW(reader.loadShape(reader.getShapeCount(), false));
+        std::filesystem::remove(path);
+    }
+}
+
+CPU_TEST(SerializedReader_Normals)
+{
+    const GridMesh grid = generateGrid(16, 8);
+    const std::filesystem::path path = writeSerializedFile(grid, 4, {DoublePrecision, SinglePrecision | FaceNormals});
+    SerializedReader reader(path);
+
+    // The grid triangles are wound clockwise when seen from above, so the generated normals face down.
+    // Smooth normals are close to the normals of the height field.
+    {
+        ref<TriangleMesh> pMesh = reader.loadShape(0, false);
+        const auto& vertices = pMesh->getVertices();
+        ASSERT_EQ(vertices.size(), grid.positions.size());
+        EXPECT(isEqual(getPositions(*pMesh), grid.positions));
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            EXPECT_LE(std::abs(length(vertices[i].normal) - 1.f), 1e-5f) << "vertex=" << i;
+            EXPECT_GT(dot(vertices[i].normal, -grid.normals[i]), 0.99f) << "vertex=" << i;
+        }
+    }
+
+    // Face normals, requested either by the shape flags or by the caller, give each triangle its own vertices.
+    for (uint32_t shapeIndex : {0u, 1u})
+    {
+        ref<TriangleMesh> pMesh = reader.loadShape(shapeIndex, shapeIndex == 0);
+        const auto& vertices = pMesh->getVertices();
+        const auto& indices = pMesh->getIndices();
+        ASSERT_EQ(vertices.size(), grid.indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            EXPECT_EQ(indices[i], (uint32_t)i);
+            EXPECT(all(vertices[i].position == grid.positions[grid.indices[i]])) << "index=" << i;
+            EXPECT(all(vertices[i].normal == vertices[i - i % 3].normal)) << "index=" << i;
+            EXPECT_GT(dot(vertices[i].normal, -grid.normals[grid.indices[i]]), 0.9f) << "index=" << i;
+        }
+    }
+
+    std::filesystem::remove(path);
+}
+
+CPU_TEST(SerializedReader_Invalid)
+{
+    const GridMesh grid = generateGrid(4, 4);
+
+    // Unsupported version.
+    std::filesystem::path path = writeSerializedFile(grid, 5, {SinglePrecision});
+    EXPECT_THROW(SerializedReader reader(path));
+    std::filesystem::remove(path);
+
+    // Truncated shape data.
+    path = writeSerializedFile(grid, 4, {SinglePrecision});
+    std::string data = readFile(path);
+    const uint64_t tableSize = sizeof(uint64_t) + sizeof(uint32_t);
+    std::string truncated = data.substr(0, data.size() - tableSize - 16) + data.substr(data.size() - tableSize);
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(truncated.data(), truncated.size());
+    {
+        SerializedReader reader(path);
+        EXPECT_THROW(reader.loadShape(0, false));
+    }
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
@@ -0,0 +1,111 @@
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "Scene/Volume/GridVolume.h"
+#include "Scene/Volume/StreamingGridSequence.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146 4244 4267 4275 4996 4456)
+#endif
+#include <nanovdb/util/IO.h>
+// See Grid.cpp for the std::result_of workaround.
+#define result_of invoke_result
+#include <nanovdb/util/GridBuilder.h>
+#undef result_of
+#include <nanovdb/util/Primitives.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace Falcor
+{
+namespace
+{
+const std::string kGridName = "sphere_fog";
+
+/** Writes a sequence of NanoVDB files with a growing sphere.
+*/
+std::vector<std::filesystem::path> writeFrames(uint32_t frameCount)
+{
+    std::vector<std::filesystem::path> paths;
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        auto handle = nanovdb::createFogVolumeSphere<float>(1.f + 0.25f * frame, nanovdb::Vec3f(0.f), 0.05f, 3.f);
+        std::filesystem::path path = getTempFilePath();
+        path += ".nvdb";
+        nanovdb::io::writeGrid(path.string(), handle);
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+void removeFrames(const std::vector<std::filesystem::path>& paths)
+{
+    for (const auto& path : paths)
+        std::filesystem::remove(path);
+}
+} // namespace
+
+GPU_TEST(StreamingGridSequence_Playback)
+{
+    const uint32_t frameCount = 6;
+    const auto paths = writeFrames(frameCount);
+
+    // Reference grids loaded up front.
+    const auto grids = GridVolume::createGridSequence(ctx.getDevice(), paths, kGridName);
+    ASSERT_EQ(grids.size(), (size_t)frameCount);
+
+    auto pSequence = StreamingGridSequence::create(ctx.getDevice(), paths, kGridName, 2);
+    ASSERT(pSequence != nullptr);
+    EXPECT_EQ(pSequence->getFrameCount(), frameCount);
+
+    const ref<Grid> pGrid = pSequence->getGrid();
+    EXPECT_EQ(pGrid->getVoxelCount(), grids[0]->getVoxelCount());
+
+    // The two frames ahead of the current frame are decoded in the background.
+    pSequence->waitForPendingFrames();
+    EXPECT_EQ(pSequence->getStats().residentFrames, 3u);
+
+    for (uint32_t frame = 1; frame < frameCount; ++frame)
+    {
+        // Only the current frame and the frames ahead of it are kept.
+        pSequence->waitForPendingFrames();
+        EXPECT_EQ(pSequence->getStats().residentFrames, 3u) << "frame " << frame;
+        EXPECT(pSequence->setFrame(frame)) << "frame " << frame;
+        EXPECT(pSequence->getGrid() == pGrid);
+        EXPECT(pGrid->isUploaded());
+        EXPECT_EQ(pGrid->getVoxelCount(), grids[frame]->getVoxelCount()) << "frame " << frame;
+    }
+
+    auto stats = pSequence->getStats();
+    EXPECT_EQ(stats.hitCount, (uint64_t)frameCount - 1);
+    EXPECT_EQ(stats.missCount, 0ull);
+    // Playing forward keeps all decoded frames in the window.
+    EXPECT_EQ(stats.evictionCount, 0ull);
+
+    // Jumping outside of the window has to wait for the frame.
+    // The frames wrapped around to the start of the sequence leave the window.
+    pSequence->waitForPendingFrames();
+    EXPECT(pSequence->setFrame(2));
+    EXPECT_EQ(pGrid->getVoxelCount(), grids[2]->getVoxelCount());
+    EXPECT_EQ(pSequence->getStats().missCount, 1ull);
+    EXPECT_EQ(pSequence->getStats().evictionCount, 2ull);
+
+    // Streaming through a grid volume keeps a single grid per slot.
+    auto pVolume = GridVolume::create(ctx.getDevice(), "volume");
+    EXPECT_EQ(pVolume->streamGridSequence(GridVolume::GridSlot::Density, paths, kGridName, 2), frameCount);
+    EXPECT_EQ(pVolume->getGridFrameCount(), frameCount);
+    EXPECT_EQ(pVolume->getAllGrids().size(), (size_t)1);
+    pVolume->setGridFrame(3);
+    EXPECT_EQ(pVolume->getDensityGrid()->getVoxelCount(), grids[3]->getVoxelCount());
+    EXPECT(pVolume->getStreamingGridSequence(GridVolume::GridSlot::Density) != nullptr);
+
+    pVolume->setDensityGrid(grids[0]);
+    EXPECT(pVolume->getStreamingGridSequence(GridVolume::GridSlot::Density) == nullptr);
+    EXPECT_EQ(pVolume->getGridFrameCount(), 1u);
+
+    pSequence = nullptr;
+    pVolume = nullptr;
+    removeFrames(paths);
+}
+} // namespace Falcor
@@ -1144,6 +1144,10 @@ void importInternal(const void* buffer, size_t byteSize, const std::filesystem::
     createAllMaterials(data, searchPath, importMode);
     timeReport.measure("Creating materials");
 
+    // Load textures in the background while converting the geometry.
+    // The following steps only run on the CPU, as no other GPU operations may be executed while loading textures.
+    builder.startMaterialTextureLoading();
+
     createSceneGraph(data);
     timeReport.measure("Creating scene graph");
 
@@ -1160,6 +1164,9 @@ void importInternal(const void* buffer, size_t byteSize, const std::filesystem::
     createLights(data);
     timeReport.measure("Creating lights");
 
+    builder.waitForMaterialTextureLoading();
+    timeReport.measure("Waiting for textures");
+
     timeReport.printToLog();
 }
 
@@ -0,0 +1,1345 @@
+#include "GltfImporter.h"
+#include "Core/Error.h"
+#include "Core/Plugin.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
+#include "Utils/StringUtils.h"
+#include "Utils/Timing/TimeReport.h"
+#include "Utils/Math/FalcorMath.h"
+#include "Scene/Importer.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Material/StandardMaterial.h"
+
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <execution>
+#include <fstream>
+
+namespace Falcor
+{
+
+namespace
+{
+// Global camera animation interpolation and warping configuration, the same as in the AssimpImporter.
+const Animation::InterpolationMode kCameraInterpolationMode = Animation::InterpolationMode::Linear;
+const bool kCameraEnableWarping = true;
+
+/**
+ * Extensions that may be listed as required by an asset.
+ * Extensions that are only used (not required) are ignored if they are not supported.
+ */
+const char* kSupportedRequiredExtensions[] = {
+    "KHR_mesh_quantization",
+    "EXT_meshopt_compression",
+    "KHR_lights_punctual",
+    "KHR_materials_emissive_strength",
+    "KHR_materials_ior",
+    "KHR_materials_pbrSpecularGlossiness",
+    "KHR_materials_transmission",
+};
+
+const char* getResultString(cgltf_result result)
+{
+    switch (result)
+    {
+    case cgltf_result_success:
+        return "success";
+    case cgltf_result_data_too_short:
+        return "data too short";
+    case cgltf_result_unknown_format:
+        return "unknown format";
+    case cgltf_result_invalid_json:
+        return "invalid JSON";
+    case cgltf_result_invalid_gltf:
+        return "invalid glTF";
+    case cgltf_result_invalid_options:
+        return "invalid options";
+    case cgltf_result_file_not_found:
+        return "file not found";
+    case cgltf_result_io_error:
+        return "I/O error";
+    case cgltf_result_out_of_memory:
+        return "out of memory";
+    case cgltf_result_legacy_gltf:
+        return "legacy glTF";
+    default:
+        return "unknown error";
+    }
+}
+
+float4x4 toFloat4x4(const cgltf_float m[16])
+{
+    // glTF matrices are stored in column-major order.
+    return float4x4{
+        m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15],
+    };
+}
+
+/**
+ * Primitive to convert into a Falcor mesh.
+ */
+struct PrimitiveData
+{
+    std::string name;
+    const cgltf_primitive* pPrimitive;
+    const cgltf_accessor* pPositions = nullptr;
+    const cgltf_accessor* pNormals = nullptr;
+    const cgltf_accessor* pTangents = nullptr;
+    const cgltf_accessor* pTexCrds = nullptr;
+};
+
+class ImporterData
+{
+public:
+    ImporterData(const std::filesystem::path& path, SceneBuilder& sceneBuilder) : path(path), builder(sceneBuilder) {}
+
+    ~ImporterData()
+    {
+        if (pData)
+            cgltf_free(pData);
+
+        // Textures are loaded from the extracted images in the background.
+        // Wait for them before removing the images, also when the import failed.
+        if (!tempFiles.empty())
+        {
+            try
+            {
+                builder.waitForMaterialTextureLoading();
+            }
+            catch (const std::exception& e)
+            {
+                logWarning("GltfImporter: Failed to load textures for '{}': {}", path, e.what());
+            }
+        }
+
+        // Remove extracted images. Errors are ignored, the files are in the temp directory.
+        std::error_code ec;
+        for (const auto& tempFile : tempFiles)
+            std::filesystem::remove(tempFile, ec);
+    }
+
+    std::filesystem::path path; ///< Asset path, empty when importing from memory.
+    SceneBuilder& builder;
+    cgltf_data* pData = nullptr;
+    std::vector<std::unique_ptr<MemoryMappedFile>> mappedFiles; ///< Memory-mapped external buffers.
+    std::vector<std::filesystem::path> imagePaths;              ///< File path of each glTF image, or empty if not used.
+    std::vector<std::filesystem::path> tempFiles;               ///< Embedded images extracted to files for the texture loader.
+    std::vector<ref<Material>> materials;                       ///< Falcor material of each glTF material.
+    ref<Material> pDefaultMaterial;                             ///< Material for primitives without material.
+    std::vector<NodeID> nodeIDs;                                ///< Falcor node of each glTF node, or invalid if not in the scene.
+    std::vector<std::vector<MeshID>> meshIDs;                   ///< Falcor meshes of each glTF mesh, one per primitive.
+
+    template<typename T>
+    size_t getIndex(const T* pElement, const T* pArray) const
+    {
+        return pElement - pArray;
+    }
+
+    std::string getNodeName(const cgltf_node* pNode) const
+    {
+        return pNode->name ? pNode->name : fmt::format("node{}", getIndex(pNode, pData->nodes));
+    }
+};
+
+/**
+ * Returns a pointer to the first element of an accessor, or nullptr if the accessor has no data.
+ */
+const uint8_t* getAccessorData(const cgltf_accessor* pAccessor)
+{
+    const cgltf_buffer_view* pView = pAccessor->buffer_view;
+    if (!pView)
+        return nullptr;
+
+    // Buffer views decoded from EXT_meshopt_compression hold their own data.
+    if (pView->data)
+        return static_cast<const uint8_t*>(pView->data) + pAccessor->offset;
+    if (!pView->buffer->data)
+        return nullptr;
+    return static_cast<const uint8_t*>(pView->buffer->data) + pView->offset + pAccessor->offset;
+}
+
+template<typename T>
+float toFloat(T value, bool normalized)
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        if (normalized)
+        {
+            // Signed normalized values use the symmetric range [-max, max] as in the glTF specification.
+            const float scaled = (float)value / (float)std::numeric_limits<T>::max();
+            return std::is_signed_v<T> ? std::max(scaled, -1.f) : scaled;
+        }
+    }
+    return (float)value;
+}
+
+template<typename T, int N>
+void convertComponents(const uint8_t* pSrc, size_t stride, bool normalized, std::vector<math::vector<float, N>>& values)
+{
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        const uint8_t* pElement = pSrc + i * stride;
+        for (int c = 0; c < N; ++c)
+        {
+            T value;
+            std::memcpy(&value, pElement + c * sizeof(T), sizeof(T));
+            values[i][c] = toFloat(value, normalized);
+        }
+    }
+}
+
+/**
+ * Read an accessor into a list of float vectors.
+ * Tightly packed float data is copied in bulk. Quantized data (KHR_mesh_quantization) is converted per component type.
+ * \return False if the accessor doesn't have N components.
+ */
+template<int N>
+bool readAccessor(const cgltf_accessor* pAccessor, std::vector<math::vector<float, N>>& values)
+{
+    if (cgltf_num_components(pAccessor->type) != N)
+        return false;
+
+    values.resize(pAccessor->count);
+    const uint8_t* pSrc = getAccessorData(pAccessor);
+    if (!pSrc || pAccessor->is_sparse)
+    {
+        // Sparse accessors and accessors without data are rare, let cgltf handle them element by element.
+        return cgltf_accessor_unpack_floats(pAccessor, &values[0][0], values.size() * N) == values.size() * N;
+    }
+
+    const size_t stride = pAccessor->stride;
+    const bool normalized = pAccessor->normalized;
+    switch (pAccessor->component_type)
+    {
+    case cgltf_component_type_r_32f:
+        if (stride == sizeof(float) * N)
+            std::memcpy(values.data(), pSrc, values.size() * stride);
+        else
+            convertComponents<float>(pSrc, stride, false, values);
+        return true;
+    case cgltf_component_type_r_8:
+        convertComponents<int8_t>(pSrc, stride, normalized, values);
+        return true;
+    case cgltf_component_type_r_8u:
+        convertComponents<uint8_t>(pSrc, stride, normalized, values);
+        return true;
+    case cgltf_component_type_r_16:
+        convertComponents<int16_t>(pSrc, stride, normalized, values);
+        return true;
+    case cgltf_component_type_r_16u:
+        convertComponents<uint16_t>(pSrc, stride, normalized, values);
+        return true;
+    case cgltf_component_type_r_32u:
+        convertComponents<uint32_t>(pSrc, stride, normalized, values);
+        return true;
+    default:
+        return false;
+    }
+}
+
+template<typename T>
+void convertIndices(const uint8_t* pSrc, size_t stride, std::vector<uint32_t>& indices)
+{
+    if (stride == sizeof(T))
+    {
+        const T* pIndices = reinterpret_cast<const T*>(pSrc);
+        if constexpr (sizeof(T) == sizeof(uint32_t))
+            std::memcpy(indices.data(), pIndices, indices.size() * sizeof(uint32_t));
+        else
+            std::copy(pIndices, pIndices + indices.size(), indices.begin());
+        return;
+    }
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        T index;
+        std::memcpy(&index, pSrc + i * stride, sizeof(T));
+        indices[i] = index;
+    }
+}
+
+/**
+ * Read the indices of a primitive. Non-indexed primitives get sequential indices.
+ */
+void readIndices(const cgltf_primitive* pPrimitive, size_t vertexCount, std::vector<uint32_t>& indices)
+{
+    const cgltf_accessor* pAccessor = pPrimitive->indices;
+    if (!pAccessor)
+    {
+        indices.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+            indices[i] = (uint32_t)i;
+        return;
+    }
+
+    indices.resize(pAccessor->count);
+    const uint8_t* pSrc = getAccessorData(pAccessor);
+    if (!pSrc || pAccessor->is_sparse)
+    {
+        for (size_t i = 0; i < indices.size(); ++i)
+            indices[i] = (uint32_t)cgltf_accessor_read_index(pAccessor, i);
+        return;
+    }
+
+    switch (pAccessor->component_type)
+    {
+    case cgltf_component_type_r_8u:
+        convertIndices<uint8_t>(pSrc, pAccessor->stride, indices);
+        break;
+    case cgltf_component_type_r_16u:
+        convertIndices<uint16_t>(pSrc, pAccessor->stride, indices);
+        break;
+    default:
+        convertIndices<uint32_t>(pSrc, pAccessor->stride, indices);
+        break;
+    }
+}
+
+/**
+ * Convert triangle strips and fans to triangle lists.
+ */
+void triangulate(cgltf_primitive_type type, std::vector<uint32_t>& indices)
+{
+    if (type == cgltf_primitive_type_triangles || indices.size() < 3)
+        return;
+
+    std::vector<uint32_t> triangles;
+    triangles.reserve((indices.size() - 2) * 3);
+    for (size_t i = 2; i < indices.size(); ++i)
+    {
+        if (type == cgltf_primitive_type_triangle_fan)
+            triangles.insert(triangles.end(), {indices[0], indices[i - 1], indices[i]});
+        else if (i % 2 == 0)
+            triangles.insert(triangles.end(), {indices[i - 2], indices[i - 1], indices[i]});
+        else
+            triangles.insert(triangles.end(), {indices[i - 1], indices[i - 2], indices[i]});
+    }
+    indices = std::move(triangles);
+}
+
+/**
+ * Generate smooth vertex normals by averaging the area weighted face normals.
+ */
+void generateNormals(const std::vector<float3>& positions, const std::vector<uint32_t>& indices, std::vector<float3>& normals)
+{
+    normals.assign(positions.size(), float3(0.f));
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const float3 n = cross(positions[indices[i + 1]] - positions[indices[i]], positions[indices[i + 2]] - positions[indices[i]]);
+        for (size_t j = 0; j < 3; ++j)
+            normals[indices[i + j]] += n;
+    }
+    for (auto& n : normals)
+    {
+        const float len = length(n);
+        n = len > 0.f ? n / len : float3(0.f, 0.f, 1.f);
+    }
+}
+
+void validateAsset(ImporterData& data)
+{
+    const cgltf_data* pData = data.pData;
+
+    for (cgltf_size i = 0; i < pData->extensions_required_count; ++i)
+    {
+        const std::string_view extension = pData->extensions_required[i];
+        if (std::find(std::begin(kSupportedRequiredExtensions), std::end(kSupportedRequiredExtensions), extension) ==
+            std::end(kSupportedRequiredExtensions))
+            throw ImporterError(data.path, "Asset requires unsupported extension '{}'.", extension);
+    }
+
+    cgltf_result result = cgltf_validate(data.pData);
+    if (result != cgltf_result_success)
+        throw ImporterError(data.path, "Invalid glTF asset ({}).", getResultString(result));
+}
+
+/**
+ * Skinning and morph targets are left to the AssimpImporter.
+ */
+bool requiresAssimp(const cgltf_data* pData)
+{
+    if (pData->skins_count > 0)
+        return true;
+    for (cgltf_size i = 0; i < pData->meshes_count; ++i)
+        for (cgltf_size j = 0; j < pData->meshes[i].primitives_count; ++j)
+            if (pData->meshes[i].primitives[j].targets_count > 0)
+                return true;
+    return false;
+}
+
+std::unique_ptr<Importer> createAssimpImporter(const std::filesystem::path& path)
+{
+    auto& pm = PluginManager::instance();
+    auto pImporter = pm.createClass<Importer>("AssimpImporter");
+    if (!pImporter && pm.loadPluginByName("AssimpImporter"))
+        pImporter = pm.createClass<Importer>("AssimpImporter");
+    if (!pImporter)
+        throw ImporterError(path, "Skins and morph targets require the AssimpImporter plugin.");
+    return pImporter;
+}
+
+void loadBuffers(ImporterData& data)
+{
+    cgltf_data* pData = data.pData;
+
+    // Map external buffer files instead of reading them into memory.
+    for (cgltf_size i = 0; i < pData->buffers_count; ++i)
+    {
+        cgltf_buffer& buffer = pData->buffers[i];
+        if (buffer.data || !buffer.uri || hasPrefix(buffer.uri, "data:"))
+            continue;
+        if (data.path.empty())
+            throw ImporterError(data.path, "Buffer '{}' is an external file, which is not supported when importing from memory.", buffer.uri);
+
+        const std::filesystem::path bufferPath = data.path.parent_path() / decodeURI(buffer.uri);
+        auto pFile = std::make_unique<MemoryMappedFile>(bufferPath, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+        if (!pFile->isOpen())
+            throw ImporterError(data.path, "Failed to open buffer file '{}'.", bufferPath);
+        if (pFile->getSize() < buffer.size)
+            throw ImporterError(data.path, "Buffer file '{}' is smaller than the buffer size.", bufferPath);
+
+        buffer.data = const_cast<void*>(pFile->getData());
+        buffer.data_free_method = cgltf_data_free_method_none;
+        data.mappedFiles.push_back(std::move(pFile));
+    }
+
+    // Let cgltf decode data URIs. The GLB binary chunk is used in place.
+    cgltf_options options = {};
+    cgltf_result result = cgltf_load_buffers(&options, pData, data.path.string().c_str());
+    if (result != cgltf_result_success)
+        throw ImporterError(data.path, "Failed to load buffers ({}).", getResultString(result));
+}
+
+/**
+ * Decode all buffer views compressed with EXT_meshopt_compression in parallel.
+ * The decoded data is owned by the buffer view and freed by cgltf_free().
+ */
+void decodeMeshoptCompression(ImporterData& data)
+{
+    std::vector<cgltf_buffer_view*> views;
+    for (cgltf_size i = 0; i < data.pData->buffer_views_count; ++i)
+        if (data.pData->buffer_views[i].has_meshopt_compression)
+            views.push_back(&data.pData->buffer_views[i]);
+    if (views.empty())
+        return;
+
+    std::vector<int> results(views.size(), -1);
+    auto range = NumericRange<size_t>(0, views.size());
+    std::for_each(
+        std::execution::par,
+        range.begin(),
+        range.end(),
+        [&](size_t i)
+        {
+            cgltf_buffer_view* pView = views[i];
+            const cgltf_meshopt_compression& compression = pView->meshopt_compression;
+            const uint8_t* pSrc = static_cast<const uint8_t*>(compression.buffer->data);
+            void* pDst = std::malloc(compression.count * compression.stride);
+            if (!pSrc || !pDst)
+            {
+                std::free(pDst);
+                return;
+            }
+            pSrc += compression.offset;
+
+            int result = -1;
+            switch (compression.mode)
+            {
+            case cgltf_meshopt_compression_mode_attributes:
+                result = meshopt_decodeVertexBuffer(pDst, compression.count, compression.stride, pSrc, compression.size);
+                break;
+            case cgltf_meshopt_compression_mode_triangles:
+                result = meshopt_decodeIndexBuffer(pDst, compression.count, compression.stride, pSrc, compression.size);
+                break;
+            case cgltf_meshopt_compression_mode_indices:
+                result = meshopt_decodeIndexSequence(pDst, compression.count, compression.stride, pSrc, compression.size);
+                break;
+            default:
+                break;
+            }
+
+            if (result == 0)
+            {
+                switch (compression.filter)
+                {
+                case cgltf_meshopt_compression_filter_octahedral:
+                    meshopt_decodeFilterOct(pDst, compression.count, compression.stride);
+                    break;
+                case cgltf_meshopt_compression_filter_quaternion:
+                    meshopt_decodeFilterQuat(pDst, compression.count, compression.stride);
+                    break;
+                case cgltf_meshopt_compression_filter_exponential:
+                    meshopt_decodeFilterExp(pDst, compression.count, compression.stride);
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            pView->data = pDst;
+            results[i] = result;
+        }
+    );
+
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        if (results[i] != 0)
+            throw ImporterError(
+                data.path, "Failed to decode compressed buffer view {}.", data.getIndex(views[i], data.pData->buffer_views)
+            );
+    }
+}
+
+const cgltf_image* getImage(const cgltf_texture_view& view)
+{
+    return view.texture ? view.texture->image : nullptr;
+}
+
+template<typename Func>
+void forEachTextureView(const cgltf_material& material, const Func& func)
+{
+    func(material.pbr_metallic_roughness.base_color_texture);
+    func(material.pbr_metallic_roughness.metallic_roughness_texture);
+    func(material.pbr_specular_glossiness.diffuse_texture);
+    func(material.pbr_specular_glossiness.specular_glossiness_texture);
+    func(material.normal_texture);
+    func(material.emissive_texture);
+}
+
+std::string getImageExtension(const cgltf_image& image)
+{
+    if (image.mime_type)
+    {
+        if (std::strcmp(image.mime_type, "image/png") == 0)
+            return ".png";
+        if (std::strcmp(image.mime_type, "image/jpeg") == 0)
+            return ".jpg";
+    }
+    if (image.uri && hasPrefix(image.uri, "data:image/png"))
+        return ".png";
+    if (image.uri && hasPrefix(image.uri, "data:image/jpeg"))
+        return ".jpg";
+    return {};
+}
+
+/**
+ * Resolve the file path of all images used by materials.
+ * The texture loader only loads files, so embedded images are extracted to temporary files in parallel.
+ */
+void resolveImages(ImporterData& data)
+{
+    const cgltf_data* pData = data.pData;
+    data.imagePaths.resize(pData->images_count);
+
+    std::vector<const cgltf_image*> embeddedImages;
+    std::vector<bool> used(pData->images_count, false);
+    for (cgltf_size i = 0; i < pData->materials_count; ++i)
+    {
+        forEachTextureView(
+            pData->materials[i],
+            [&](const cgltf_texture_view& view)
+            {
+                if (const cgltf_image* pImage = getImage(view))
+                    used[data.getIndex(pImage, pData->images)] = true;
+            }
+        );
+    }
+
+    for (cgltf_size i = 0; i < pData->images_count; ++i)
+    {
+        const cgltf_image& image = pData->images[i];
+        if (!used[i])
+            continue;
+
+        if (image.uri && !hasPrefix(image.uri, "data:"))
+        {
+            std::string uri = decodeURI(image.uri);
+            // Assets may contain windows native paths, replace '\' with '/' to make compatible on Linux.
+            std::replace(uri.begin(), uri.end(), '\\', '/');
+            data.imagePaths[i] = data.path.empty() ? std::filesystem::path(uri) : data.path.parent_path() / uri;
+            continue;
+        }
+
+        const std::string extension = getImageExtension(image);
+        if (extension.empty())
+        {
+            logWarning("GltfImporter: Image {} has unsupported type '{}', ignoring.", i, image.mime_type ? image.mime_type : "");
+            continue;
+        }
+        data.imagePaths[i] = getTempFilePath();
+        data.imagePaths[i] += extension;
+        data.tempFiles.push_back(data.imagePaths[i]);
+        embeddedImages.push_back(&image);
+    }
+
+    std::vector<uint8_t> extracted(embeddedImages.size(), 0);
+    auto range = NumericRange<size_t>(0, embeddedImages.size());
+    std::for_each(
+        std::execution::par,
+        range.begin(),
+        range.end(),
+        [&](size_t i)
+        {
+            const cgltf_image* pImage = embeddedImages[i];
+            const size_t imageIndex = data.getIndex(pImage, pData->images);
+            const void* pImageData = nullptr;
+            size_t size = 0;
+            void* pDecoded = nullptr;
+
+            if (pImage->buffer_view)
+            {
+                const cgltf_buffer_view* pView = pImage->buffer_view;
+                pImageData = pView->data ? pView->data : static_cast<const uint8_t*>(pView->buffer->data) + pView->offset;
+                size = pView->size;
+            }
+            else if (const char* pComma = pImage->uri ? std::strchr(pImage->uri, ',') : nullptr)
+            {
+                // Base64 encoded data URI.
+                const char* pBase64 = pComma + 1;
+                const size_t length = std::strlen(pBase64);
+                size = length / 4 * 3;
+                for (size_t j = length; j > 0 && pBase64[j - 1] == '='; --j)
+                    --size;
+                cgltf_options options = {};
+                if (cgltf_load_buffer_base64(&options, size, pBase64, &pDecoded) == cgltf_result_success)
+                    pImageData = pDecoded;
+            }
+
+            if (pImageData)
+            {
+                std::ofstream file(data.imagePaths[imageIndex], std::ios::binary);
+                file.write(static_cast<const char*>(pImageData), size);
+                extracted[i] = file.good();
+            }
+            std::free(pDecoded);
+        }
+    );
+
+    for (size_t i = 0; i < embeddedImages.size(); ++i)
+    {
+        if (!extracted[i])
+        {
+            const size_t imageIndex = data.getIndex(embeddedImages[i], pData->images);
+            logWarning("GltfImporter: Failed to extract embedded image {}, ignoring.", imageIndex);
+            data.imagePaths[imageIndex].clear();
+        }
+    }
+}
+
+void loadTexture(ImporterData& data, const ref<Material>& pMaterial, Material::TextureSlot slot, const cgltf_texture_view& view)
+{
+    const cgltf_image* pImage = getImage(view);
+    if (!pImage)
+    {
+        if (view.texture)
+            logWarning("GltfImporter: Material '{}' uses a texture without a supported image, ignoring.", pMaterial->getName());
+        return;
+    }
+
+    if (view.texcoord != 0)
+        logWarning("GltfImporter: Material '{}' uses texture coordinate set {}, using set 0 instead.", pMaterial->getName(), view.texcoord);
+    if (view.has_transform)
+        logWarning("GltfImporter: Material '{}' uses KHR_texture_transform, which is ignored.", pMaterial->getName());
+
+    const auto& path = data.imagePaths[data.getIndex(pImage, data.pData->images)];
+    if (!path.empty())
+        data.builder.loadMaterialTexture(pMaterial, slot, path);
+}
+
+ref<Material> createMaterial(ImporterData& data, const cgltf_material& gltfMaterial)
+{
+    std::string name = gltfMaterial.name ? gltfMaterial.name : "";
+    if (name.empty())
+    {
+        logWarning("GltfImporter: Material with no name found -> renaming to 'unnamed'.");
+        name = "unnamed";
+    }
+
+    // Determine shading model. Specular-glossiness materials use SpecGloss unless MetalRough is forced.
+    const SceneBuilder::Flags builderFlags = data.builder.getFlags();
+    ShadingModel shadingModel = ShadingModel::MetalRough;
+    if (is_set(builderFlags, SceneBuilder::Flags::UseSpecGlossMaterials) ||
+        (gltfMaterial.has_pbr_specular_glossiness && !is_set(builderFlags, SceneBuilder::Flags::UseMetalRoughMaterials)))
+    {
+        shadingModel = ShadingModel::SpecGloss;
+    }
+
+    ref<StandardMaterial> pMaterial = StandardMaterial::create(data.builder.getDevice(), name, shadingModel);
+
+    if (gltfMaterial.has_pbr_specular_glossiness && shadingModel == ShadingModel::SpecGloss)
+    {
+        const auto& pbr = gltfMaterial.pbr_specular_glossiness;
+        pMaterial->setBaseColor(float4(pbr.diffuse_factor[0], pbr.diffuse_factor[1], pbr.diffuse_factor[2], pbr.diffuse_factor[3]));
+        pMaterial->setSpecularParams(float4(pbr.specular_factor[0], pbr.specular_factor[1], pbr.specular_factor[2], pbr.glossiness_factor));
+        loadTexture(data, pMaterial, Material::TextureSlot::BaseColor, pbr.diffuse_texture);
+        loadTexture(data, pMaterial, Material::TextureSlot::Specular, pbr.specular_glossiness_texture);
+    }
+    else
+    {
+        // Metallic-roughness is the default in glTF, its parameters are defined even if the material doesn't list them.
+        const auto& pbr = gltfMaterial.pbr_metallic_roughness;
+        pMaterial->setBaseColor(float4(pbr.base_color_factor[0], pbr.base_color_factor[1], pbr.base_color_factor[2], pbr.base_color_factor[3]));
+        float4 specularParams = pMaterial->getSpecularParams();
+        specularParams.g = pbr.roughness_factor;
+        specularParams.b = pbr.metallic_factor;
+        pMaterial->setSpecularParams(specularParams);
+        loadTexture(data, pMaterial, Material::TextureSlot::BaseColor, pbr.base_color_texture);
+        loadTexture(data, pMaterial, Material::TextureSlot::Specular, pbr.metallic_roughness_texture);
+    }
+
+    loadTexture(data, pMaterial, Material::TextureSlot::Normal, gltfMaterial.normal_texture);
+    loadTexture(data, pMaterial, Material::TextureSlot::Emissive, gltfMaterial.emissive_texture);
+
+    pMaterial->setEmissiveColor(float3(gltfMaterial.emissive_factor[0], gltfMaterial.emissive_factor[1], gltfMaterial.emissive_factor[2]));
+    if (gltfMaterial.has_emissive_strength)
+        pMaterial->setEmissiveFactor(gltfMaterial.emissive_strength.emissive_strength);
+
+    if (gltfMaterial.has_ior)
+        pMaterial->setIndexOfRefraction(gltfMaterial.ior.ior);
+    if (gltfMaterial.has_transmission)
+        pMaterial->setSpecularTransmission(gltfMaterial.transmission.transmission_factor);
+
+    pMaterial->setDoubleSided(gltfMaterial.double_sided);
+
+    // Blended materials are alpha tested, as Falcor has no alpha blending.
+    if (gltfMaterial.alpha_mode == cgltf_alpha_mode_opaque)
+    {
+        pMaterial->setAlphaMode(AlphaMode::Opaque);
+    }
+    else if (gltfMaterial.alpha_mode == cgltf_alpha_mode_mask)
+    {
+        pMaterial->setAlphaMode(AlphaMode::Mask);
+        pMaterial->setAlphaThreshold(gltfMaterial.alpha_cutoff);
+    }
+
+    return pMaterial;
+}
+
+void createAllMaterials(ImporterData& data)
+{
+    resolveImages(data);
+
+    data.materials.resize(data.pData->materials_count);
+    for (cgltf_size i = 0; i < data.pData->materials_count; ++i)
+        data.materials[i] = createMaterial(data, data.pData->materials[i]);
+}
+
+const ref<Material>& getMaterial(ImporterData& data, const cgltf_material* pMaterial)
+{
+    if (pMaterial)
+        return data.materials[data.getIndex(pMaterial, data.pData->materials)];
+
+    // The default material of glTF is a white, fully rough metal.
+    if (!data.pDefaultMaterial)
+    {
+        ref<StandardMaterial> pDefault = StandardMaterial::create(data.builder.getDevice(), "default", ShadingModel::MetalRough);
+        pDefault->setSpecularParams(float4(0.f, 1.f, 1.f, 0.f));
+        data.pDefaultMaterial = pDefault;
+    }
+    return data.pDefaultMaterial;
+}
+
+const cgltf_scene* getScene(const cgltf_data* pData)
+{
+    if (pData->scene)
+        return pData->scene;
+    return pData->scenes_count > 0 ? &pData->scenes[0] : nullptr;
+}
+
+/**
+ * Call a function for all nodes of the scene in depth-first order, parents before children.
+ * Assets without scenes are imported with all root nodes.
+ */
+template<typename Func>
+void forEachNode(const cgltf_data* pData, const Func& func)
+{
+    std::function<void(const cgltf_node*)> visit = [&](const cgltf_node* pNode)
+    {
+        func(pNode);
+        for (cgltf_size i = 0; i < pNode->children_count; ++i)
+            visit(pNode->children[i]);
+    };
+
+    if (const cgltf_scene* pScene = getScene(pData))
+    {
+        for (cgltf_size i = 0; i < pScene->nodes_count; ++i)
+            visit(pScene->nodes[i]);
+    }
+    else
+    {
+        for (cgltf_size i = 0; i < pData->nodes_count; ++i)
+            if (!pData->nodes[i].parent)
+                visit(&pData->nodes[i]);
+    }
+}
+
+void createSceneGraph(ImporterData& data)
+{
+    data.nodeIDs.assign(data.pData->nodes_count, NodeID::Invalid());
+
+    forEachNode(
+        data.pData,
+        [&](const cgltf_node* pNode)
+        {
+            cgltf_float transform[16];
+            cgltf_node_transform_local(pNode, transform);
+
+            SceneBuilder::Node node;
+            node.name = data.getNodeName(pNode);
+            node.transform = toFloat4x4(transform);
+            node.parent = pNode->parent ? data.nodeIDs[data.getIndex(pNode->parent, data.pData->nodes)] : NodeID::Invalid();
+            data.nodeIDs[data.getIndex(pNode, data.pData->nodes)] = data.builder.addNode(node);
+        }
+    );
+}
+
+void createMeshes(ImporterData& data)
+{
+    const cgltf_data* pData = data.pData;
+    const bool loadTangents = is_set(data.builder.getFlags(), SceneBuilder::Flags::UseOriginalTangentSpace);
+
+    // Collect the triangle primitives of all meshes.
+    std::vector<PrimitiveData> primitives;
+    std::vector<std::pair<size_t, size_t>> primitiveMeshes; // Mesh and primitive index of each entry in 'primitives'.
+    data.meshIDs.resize(pData->meshes_count);
+    for (cgltf_size i = 0; i < pData->meshes_count; ++i)
+    {
+        const cgltf_mesh& gltfMesh = pData->meshes[i];
+        const std::string meshName = gltfMesh.name ? gltfMesh.name : fmt::format("mesh{}", i);
+        data.meshIDs[i].resize(gltfMesh.primitives_count, MeshID::Invalid());
+
+        for (cgltf_size j = 0; j < gltfMesh.primitives_count; ++j)
+        {
+            PrimitiveData primitive;
+            primitive.name = gltfMesh.primitives_count > 1 ? fmt::format("{}.{}", meshName, j) : meshName;
+            primitive.pPrimitive = &gltfMesh.primitives[j];
+
+            const cgltf_primitive_type type = primitive.pPrimitive->type;
+            if (type != cgltf_primitive_type_triangles && type != cgltf_primitive_type_triangle_strip &&
+                type != cgltf_primitive_type_triangle_fan)
+            {
+                logWarning("GltfImporter: Mesh '{}' is not a triangle mesh, ignoring.", primitive.name);
+                continue;
+            }
+
+            for (cgltf_size k = 0; k < primitive.pPrimitive->attributes_count; ++k)
+            {
+                const cgltf_attribute& attribute = primitive.pPrimitive->attributes[k];
+                switch (attribute.type)
+                {
+                case cgltf_attribute_type_position:
+                    primitive.pPositions = attribute.data;
+                    break;
+                case cgltf_attribute_type_normal:
+                    primitive.pNormals = attribute.data;
+                    break;
+                case cgltf_attribute_type_tangent:
+                    primitive.pTangents = loadTangents ? attribute.data : nullptr;
+                    break;
+                case cgltf_attribute_type_texcoord:
+                    if (attribute.index == 0)
+                        primitive.pTexCrds = attribute.data;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            if (!primitive.pPositions || primitive.pPositions->count == 0)
+            {
+                logWarning("GltfImporter: Mesh '{}' has no vertices, ignoring.", primitive.name);
+                continue;
+            }
+
+            // Create the default material up front, it is shared by the parallel conversion.
+            getMaterial(data, primitive.pPrimitive->material);
+
+            primitives.push_back(std::move(primitive));
+            primitiveMeshes.emplace_back(i, j);
+        }
+    }
+
+    // Convert and pre-process meshes in parallel.
+    std::vector<SceneBuilder::ProcessedMesh> processedMeshes(primitives.size());
+    std::vector<std::exception_ptr> exceptions(primitives.size());
+    auto range = NumericRange<size_t>(0, primitives.size());
+    std::for_each(
+        std::execution::par,
+        range.begin(),
+        range.end(),
+        [&](size_t index)
+        {
+            const PrimitiveData& primitive = primitives[index];
+            try
+            {
+                // Temporary memory for the vertex and index data.
+                std::vector<uint32_t> indices;
+                std::vector<float3> positions;
+                std::vector<float3> normals;
+                std::vector<float4> tangents;
+                std::vector<float2> texCrds;
+
+                if (!readAccessor(primitive.pPositions, positions))
+                    FALCOR_THROW("Mesh '{}' has invalid positions.", primitive.name);
+                readIndices(primitive.pPrimitive, positions.size(), indices);
+                triangulate(primitive.pPrimitive->type, indices);
+                if (indices.empty())
+                    FALCOR_THROW("Mesh '{}' has no triangles.", primitive.name);
+
+                // Missing normals are generated, as with the AssimpImporter.
+                if (primitive.pNormals && primitive.pNormals->count == positions.size() && readAccessor(primitive.pNormals, normals))
+                {
+                    // Quantized normals are only approximately unit length.
+                    if (primitive.pNormals->component_type != cgltf_component_type_r_32f)
+                        for (auto& n : normals)
+                            n = normalize(n);
+                }
+                else
+                {
+                    generateNormals(positions, indices, normals);
+                }
+
+                SceneBuilder::Mesh mesh;
+                mesh.name = primitive.name;
+                mesh.faceCount = (uint32_t)(indices.size() / 3);
+                mesh.vertexCount = (uint32_t)positions.size();
+                mesh.indexCount = (uint32_t)indices.size();
+                mesh.pIndices = indices.data();
+                mesh.topology = Vao::Topology::TriangleList;
+                mesh.positions.pData = positions.data();
+                mesh.positions.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                mesh.normals.pData = normals.data();
+                mesh.normals.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+
+                if (primitive.pTexCrds && primitive.pTexCrds->count == positions.size() && readAccessor(primitive.pTexCrds, texCrds))
+                {
+                    mesh.texCrds.pData = texCrds.data();
+                    mesh.texCrds.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                }
+
+                // glTF tangents store the bitangent sign in w, the same convention as MikkTSpace.
+                if (primitive.pTangents && primitive.pTangents->count == positions.size() && readAccessor(primitive.pTangents, tangents))
+                {
+                    mesh.tangents.pData = tangents.data();
+                    mesh.tangents.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
+                    mesh.useOriginalTangentSpace = true;
+                }
+
+                mesh.pMaterial = getMaterial(data, primitive.pPrimitive->material);
+
+                processedMeshes[index] = data.builder.processMesh(mesh);
+            }
+            catch (...)
+            {
+                exceptions[index] = std::current_exception();
+            }
+        }
+    );
+
+    // Add meshes to the scene.
+    // We retain a deterministic order of the meshes in the global scene buffer by adding
+    // them sequentially after being processed in parallel.
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+        if (exceptions[i])
+        {
+            try
+            {
+                std::rethrow_exception(exceptions[i]);
+            }
+            catch (const std::exception& e)
+            {
+                throw ImporterError(data.path, "{}", e.what());
+            }
+        }
+        const auto [meshIndex, primitiveIndex] = primitiveMeshes[i];
+        data.meshIDs[meshIndex][primitiveIndex] = data.builder.addProcessedMesh(processedMeshes[i]);
+    }
+}
+
+void addMeshInstances(ImporterData& data)
+{
+    forEachNode(
+        data.pData,
+        [&](const cgltf_node* pNode)
+        {
+            if (!pNode->mesh)
+                return;
+            const NodeID nodeID = data.nodeIDs[data.getIndex(pNode, data.pData->nodes)];
+            for (MeshID meshID : data.meshIDs[data.getIndex(pNode->mesh, data.pData->meshes)])
+            {
+                if (meshID.isValid())
+                    data.builder.addMeshInstance(nodeID, meshID);
+            }
+        }
+    );
+}
+
+/**
+ * Animation sampler of a single channel.
+ */
+struct AnimationTrack
+{
+    cgltf_animation_path_type path;
+    cgltf_interpolation_type interpolation;
+    std::vector<float> times;
+    std::vector<float4> values;
+
+    /**
+     * Evaluate the track at a given time.
+     * Cubic spline tracks are evaluated linearly between their keyframe values.
+     */
+    float4 evaluate(float time) const
+    {
+        auto it = std::upper_bound(times.begin(), times.end(), time);
+        if (it == times.begin())
+            return values.front();
+        if (it == times.end())
+            return values.back();
+
+        const size_t i = it - times.begin() - 1;
+        if (interpolation == cgltf_interpolation_type_step)
+            return values[i];
+
+        const float t = (time - times[i]) / (times[i + 1] - times[i]);
+        if (path == cgltf_animation_path_type_rotation)
+        {
+            const quatf q = slerp(quatf(values[i].x, values[i].y, values[i].z, values[i].w), quatf(values[i + 1].x, values[i + 1].y, values[i + 1].z, values[i + 1].w), t);
+            return float4(q.x, q.y, q.z, q.w);
+        }
+        return lerp(values[i], values[i + 1], t);
+    }
+};
+
+bool readAnimationTrack(const cgltf_animation_channel& channel, AnimationTrack& track)
+{
+    const cgltf_animation_sampler* pSampler = channel.sampler;
+    track.path = channel.target_path;
+    track.interpolation = pSampler->interpolation;
+
+    track.times.resize(pSampler->input->count);
+    if (track.times.empty() || cgltf_accessor_unpack_floats(pSampler->input, track.times.data(), track.times.size()) != track.times.size())
+        return false;
+
+    // Translation and scale tracks are read as float3, rotation tracks as float4 (quaternions).
+    const cgltf_accessor* pOutput = pSampler->output;
+    if (track.path == cgltf_animation_path_type_rotation)
+    {
+        if (!readAccessor(pOutput, track.values))
+            return false;
+    }
+    else
+    {
+        std::vector<float3> values;
+        if (!readAccessor(pOutput, values))
+            return false;
+        track.values.resize(values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+            track.values[i] = float4(values[i], 0.f);
+    }
+
+    // Cubic spline samplers store an in-tangent, the value and an out-tangent per keyframe. Only the values are used.
+    if (track.interpolation == cgltf_interpolation_type_cubic_spline)
+    {
+        if (track.values.size() != track.times.size() * 3)
+            return false;
+        for (size_t i = 0; i < track.times.size(); ++i)
+            track.values[i] = track.values[i * 3 + 1];
+        track.values.resize(track.times.size());
+    }
+
+    return track.values.size() == track.times.size();
+}
+
+void createAnimations(ImporterData& data)
+{
+    const cgltf_data* pData = data.pData;
+
+    for (cgltf_size i = 0; i < pData->animations_count; ++i)
+    {
+        const cgltf_animation& animation = pData->animations[i];
+        const std::string animationName = animation.name ? animation.name : fmt::format("animation{}", i);
+
+        // Falcor animations hold translation, rotation and scale keyframes of a node, so the glTF channels are grouped by node.
+        std::map<size_t, std::vector<AnimationTrack>> nodeTracks;
+        for (cgltf_size j = 0; j < animation.channels_count; ++j)
+        {
+            const cgltf_animation_channel& channel = animation.channels[j];
+            if (!channel.target_node || !data.nodeIDs[data.getIndex(channel.target_node, pData->nodes)].isValid())
+                continue;
+            if (channel.target_path != cgltf_animation_path_type_translation && channel.target_path != cgltf_animation_path_type_rotation &&
+                channel.target_path != cgltf_animation_path_type_scale)
+                continue;
+
+            AnimationTrack track;
+            if (!readAnimationTrack(channel, track))
+                throw ImporterError(data.path, "Animation '{}' has an invalid channel {}.", animationName, j);
+            nodeTracks[data.getIndex(channel.target_node, pData->nodes)].push_back(std::move(track));
+        }
+
+        for (const auto& [nodeIndex, tracks] : nodeTracks)
+        {
+            const cgltf_node& node = pData->nodes[nodeIndex];
+
+            // Keyframes are created at the union of all track times. Falcor interpolates linearly between them.
+            std::vector<float> times;
+            for (const auto& track : tracks)
+                times.insert(times.end(), track.times.begin(), track.times.end());
+            std::sort(times.begin(), times.end());
+            times.erase(std::unique(times.begin(), times.end()), times.end());
+
+            ref<Animation> pAnimation =
+                Animation::create(fmt::format("{}.{}", animationName, data.getNodeName(&node)), data.nodeIDs[nodeIndex], std::max(times.back(), 0.f));
+
+            // Channels that are not animated keep the node's rest pose.
+            Animation::Keyframe keyframe;
+            if (node.has_translation)
+                keyframe.translation = float3(node.translation[0], node.translation[1], node.translation[2]);
+            if (node.has_rotation)
+                keyframe.rotation = quatf(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]);
+            if (node.has_scale)
+                keyframe.scaling = float3(node.scale[0], node.scale[1], node.scale[2]);
+
+            for (float time : times)
+            {
+                keyframe.time = std::max(time, 0.f);
+                for (const auto& track : tracks)
+                {
+                    const float4 value = track.evaluate(time);
+                    if (track.path == cgltf_animation_path_type_translation)
+                        keyframe.translation = value.xyz();
+                    else if (track.path == cgltf_animation_path_type_rotation)
+                        keyframe.rotation = normalize(quatf(value.x, value.y, value.z, value.w));
+                    else
+                        keyframe.scaling = value.xyz();
+                }
+                pAnimation->addKeyframe(keyframe);
+            }
+
+            data.builder.addAnimation(pAnimation);
+        }
+    }
+}
+
+float4x4 getWorldTransform(const cgltf_node* pNode)
+{
+    cgltf_float transform[16];
+    cgltf_node_transform_world(pNode, transform);
+    return toFloat4x4(transform);
+}
+
+void createCameras(ImporterData& data)
+{
+    forEachNode(
+        data.pData,
+        [&](const cgltf_node* pNode)
+        {
+            const cgltf_camera* pGltfCamera = pNode->camera;
+            if (!pGltfCamera)
+                return;
+
+            ref<Camera> pCamera = Camera::create(pGltfCamera->name ? pGltfCamera->name : data.getNodeName(pNode));
+
+            if (pGltfCamera->type == cgltf_camera_type_perspective)
+            {
+                const auto& perspective = pGltfCamera->data.perspective;
+                const float aspectRatio = perspective.has_aspect_ratio && perspective.aspect_ratio > 0.f ? perspective.aspect_ratio : pCamera->getAspectRatio();
+                pCamera->setFocalLength(fovYToFocalLength(perspective.yfov, pCamera->getFrameHeight()));
+                pCamera->setAspectRatio(aspectRatio);
+                pCamera->setDepthRange(perspective.znear, perspective.has_zfar ? perspective.zfar : pCamera->getFarPlane());
+            }
+            else
+            {
+                logWarning("GltfImporter: Camera '{}' is orthographic, which is not supported. Using a perspective camera.", pCamera->getName());
+            }
+
+            // glTF cameras look down the negative z-axis of their node.
+            const float4x4 transform = getWorldTransform(pNode);
+            const float3 position = transform.getCol(3).xyz();
+            pCamera->setPosition(position);
+            pCamera->setUpVector(transform.getCol(1).xyz());
+            pCamera->setTarget(position - transform.getCol(2).xyz());
+
+            const NodeID nodeID = data.nodeIDs[data.getIndex(pNode, data.pData->nodes)];
+            pCamera->setNodeID(nodeID);
+            if (data.builder.isNodeAnimated(nodeID))
+            {
+                pCamera->setHasAnimation(true);
+                data.builder.setNodeInterpolationMode(nodeID, kCameraInterpolationMode, kCameraEnableWarping);
+            }
+
+            data.builder.addCamera(pCamera);
+        }
+    );
+}
+
+void createLights(ImporterData& data)
+{
+    forEachNode(
+        data.pData,
+        [&](const cgltf_node* pNode)
+        {
+            const cgltf_light* pGltfLight = pNode->light;
+            if (!pGltfLight)
+                return;
+
+            const std::string name = pGltfLight->name ? pGltfLight->name : data.getNodeName(pNode);
+            const float4x4 transform = getWorldTransform(pNode);
+            ref<Light> pLight;
+
+            // glTF lights point down the negative z-axis of their node.
+            switch (pGltfLight->type)
+            {
+            case cgltf_light_type_directional:
+            {
+                ref<DirectionalLight> pDirLight = DirectionalLight::create(name);
+                pDirLight->setWorldDirection(-transform.getCol(2).xyz());
+                pLight = pDirLight;
+                break;
+            }
+            case cgltf_light_type_point:
+            case cgltf_light_type_spot:
+            {
+                ref<PointLight> pPointLight = PointLight::create(name);
+                pPointLight->setWorldPosition(transform.getCol(3).xyz());
+                pPointLight->setWorldDirection(-transform.getCol(2).xyz());
+                if (pGltfLight->type == cgltf_light_type_spot)
+                {
+                    pPointLight->setOpeningAngle(pGltfLight->spot_outer_cone_angle);
+                    pPointLight->setPenumbraAngle(pGltfLight->spot_outer_cone_angle - pGltfLight->spot_inner_cone_angle);
+                }
+                pLight = pPointLight;
+                break;
+            }
+            default:
+                logWarning("GltfImporter: Light '{}' has unsupported type {}, ignoring.", name, static_cast<int>(pGltfLight->type));
+                return;
+            }
+
+            pLight->setIntensity(float3(pGltfLight->color[0], pGltfLight->color[1], pGltfLight->color[2]) * pGltfLight->intensity);
+
+            const NodeID nodeID = data.nodeIDs[data.getIndex(pNode, data.pData->nodes)];
+            pLight->setNodeID(nodeID);
+            pLight->setHasAnimation(data.builder.isNodeAnimated(nodeID));
+            data.builder.addLight(pLight);
+        }
+    );
+}
+
+void importInternal(
+    const void* buffer,
+    size_t byteSize,
+    const std::filesystem::path& path,
+    SceneBuilder& builder,
+    const std::map<std::string, std::string>& materialToShortName
+)
+{
+    TimeReport timeReport;
+
+    // Files are memory-mapped. The GLB binary chunk is used in place.
+    MemoryMappedFile file;
+    if (!path.empty())
+    {
+        FALCOR_ASSERT(buffer == nullptr && byteSize == 0);
+        if (!path.is_absolute())
+            throw ImporterError(path, "Expected absolute path.");
+        if (!file.open(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan))
+            throw ImporterError(path, "Failed to open file.");
+        buffer = file.getData();
+        byteSize = file.getSize();
+    }
+
+    ImporterData data(path, builder);
+    cgltf_options options = {};
+    cgltf_result result = cgltf_parse(&options, buffer, byteSize, &data.pData);
+    if (result != cgltf_result_success)
+        throw ImporterError(path, "Failed to parse glTF asset ({}).", getResultString(result));
+
+    if (requiresAssimp(data.pData))
+    {
+        logInfo("GltfImporter: Asset uses skins or morph targets, importing with AssimpImporter.");
+        auto pImporter = createAssimpImporter(path);
+        if (path.empty())
+            pImporter->importSceneFromMemory(buffer, byteSize, "glb", builder, materialToShortName);
+        else
+            pImporter->importScene(path, builder, materialToShortName);
+        return;
+    }
+
+    validateAsset(data);
+    loadBuffers(data);
+    timeReport.measure("Loading asset file");
+
+    decodeMeshoptCompression(data);
+    timeReport.measure("Decoding compressed buffers");
+
+    createAllMaterials(data);
+    timeReport.measure("Creating materials");
+
+    // Load textures in the background while converting the geometry.
+    // The following steps only run on the CPU, as no other GPU operations may be executed while loading textures.
+    builder.startMaterialTextureLoading();
+
+    createSceneGraph(data);
+    timeReport.measure("Creating scene graph");
+
+    createMeshes(data);
+    addMeshInstances(data);
+    timeReport.measure("Creating meshes");
+
+    createAnimations(data);
+    timeReport.measure("Creating animations");
+
+    createCameras(data);
+    timeReport.measure("Creating cameras");
+
+    createLights(data);
+    timeReport.measure("Creating lights");
+
+    // Wait before the extracted images are removed.
+    builder.waitForMaterialTextureLoading();
+    timeReport.measure("Waiting for textures");
+
+    timeReport.printToLog();
+}
+
+} // namespace
+
+std::unique_ptr<Importer> GltfImporter::create()
+{
+    return std::make_unique<GltfImporter>();
+}
+
+void GltfImporter::importScene(
+    const std::filesystem::path& path,
+    SceneBuilder& builder,
+    const std::map<std::string, std::string>& materialToShortName
+)
+{
+    importInternal(nullptr, 0, path, builder, materialToShortName);
+}
+
+void GltfImporter::importSceneFromMemory(
+    const void* buffer,
+    size_t byteSize,
+    std::string_view extension,
+    SceneBuilder& builder,
+    const std::map<std::string, std::string>& materialToShortName
+)
+{
+    importInternal(buffer, byteSize, {}, builder, materialToShortName);
+}
+
+extern "C" FALCOR_API_EXPORT void registerPlugin(Falcor::PluginRegistry& registry)
+{
+    registry.registerClass<Importer, GltfImporter>();
+}
+
+} // namespace Falcor
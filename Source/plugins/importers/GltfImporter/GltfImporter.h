@@ -0,0 +1,40 @@
+#pragma once
+#include "Scene/Importer.h"
+#include <filesystem>
+#include <memory>
+
+namespace Falcor
+{
+
+/**
+ * Importer for glTF 2.0 assets, built on cgltf.
+ *
+ * Buffers are memory-mapped and accessed in place. Vertex data is converted with bulk typed copies,
+ * including quantized data (KHR_mesh_quantization). Buffer views using EXT_meshopt_compression are
+ * decoded in parallel, meshes are converted in parallel and textures are loaded in the background.
+ *
+ * Assets using skins or morph targets are imported with the AssimpImporter.
+ */
+class GltfImporter : public Importer
+{
+public:
+    FALCOR_PLUGIN_CLASS(GltfImporter, "GltfImporter", PluginInfo({"Importer for glTF 2.0 assets", {"gltf", "glb"}}));
+
+    static std::unique_ptr<Importer> create();
+
+    void importScene(
+        const std::filesystem::path& path,
+        SceneBuilder& builder,
+        const std::map<std::string, std::string>& materialToShortName
+    ) override;
+
+    void importSceneFromMemory(
+        const void* buffer,
+        size_t byteSize,
+        std::string_view extension,
+        SceneBuilder& builder,
+        const std::map<std::string, std::string>& materialToShortName
+    ) override;
+};
+
+} // namespace Falcor
@@ -7,9 +7,11 @@
 #include "Scene/Material/PBRT/PBRTDiffuseMaterial.h"
 #include "Scene/Material/PBRT/PBRTDielectricMaterial.h"
 #include "Scene/Material/PBRT/PBRTConductorMaterial.h"
+#include "Scene/SerializedReader.h"
 
 #include <pybind11/pybind11.h>
 
+#include <execution>
 #include <unordered_map>
 
 namespace Falcor
@@ -56,6 +58,8 @@ struct BuilderContext
     SceneBuilder& builder;
     std::unordered_map<std::string, XMLObject>& instances;
     std::unordered_set<std::string> warnings;
+    /// Meshes of 'serialized' shapes loaded ahead of time, keyed by shape ID.
+    std::unordered_map<std::string, ref<TriangleMesh>> serializedMeshes;
 
     void forEachReference(const XMLObject& inst, Class cls, std::function<void(const XMLObject&)> func)
     {
@@ -463,6 +467,24 @@ ShapeInfo buildShape(BuilderContext& ctx, const XMLObject& inst)
             shape.pMesh->setName(inst.id);
         shape.transform = toWorld;
     }
+    else if (inst.type == "serialized")
+    {
+        auto it = ctx.serializedMeshes.find(inst.id);
+        if (it != ctx.serializedMeshes.end())
+        {
+            shape.pMesh = std::move(it->second);
+            ctx.serializedMeshes.erase(it);
+        }
+        else
+        {
+            auto filename = props.getString("filename");
+            auto shapeIndex = props.getInt("shape_index", 0);
+            auto faceNormals = props.getBool("face_normals", false);
+            shape.pMesh = SerializedReader(filename).loadShape((uint32_t)shapeIndex, faceNormals);
+        }
+        shape.pMesh->setName(inst.id);
+        shape.transform = toWorld;
+    }
     else if (inst.type == "sphere")
     {
         auto center = props.getFloat3("center", float3(0.f));
@@ -696,12 +718,72 @@ EmitterInfo buildEmitter(BuilderContext& ctx, const XMLObject& inst)
     return emitter;
 }
 
+/** Load the meshes of all 'serialized' shapes in the scene in parallel.
+ */
+void loadSerializedShapes(BuilderContext& ctx, const XMLObject& inst)
+{
+    struct Task
+    {
+        std::string id;
+        const SerializedReader* pReader;
+        uint32_t shapeIndex;
+        bool faceNormals;
+        ref<TriangleMesh> pMesh;
+        std::exception_ptr pException;
+    };
+
+    // Each file is opened once. Only the shapes that are referenced get decompressed.
+    std::unordered_map<std::string, std::unique_ptr<SerializedReader>> readers;
+    std::vector<Task> tasks;
+    for (const auto& [name, id] : inst.props.getNamedReferences())
+    {
+        const auto& child = ctx.instances[id];
+        if (child.cls != Class::Shape || child.type != "serialized")
+            continue;
+
+        auto filename = child.props.getString("filename");
+        auto& pReader = readers[filename];
+        if (!pReader)
+            pReader = std::make_unique<SerializedReader>(filename);
+
+        auto shapeIndex = child.props.getInt("shape_index", 0);
+        auto faceNormals = child.props.getBool("face_normals", false);
+        tasks.push_back({id, pReader.get(), (uint32_t)shapeIndex, faceNormals});
+    }
+
+    std::for_each(
+        std::execution::par,
+        tasks.begin(),
+        tasks.end(),
+        [](Task& task)
+        {
+            try
+            {
+                task.pMesh = task.pReader->loadShape(task.shapeIndex, task.faceNormals);
+            }
+            catch (...)
+            {
+                task.pException = std::current_exception();
+            }
+        }
+    );
+
+    for (auto& task : tasks)
+    {
+        if (task.pException)
+            std::rethrow_exception(task.pException);
+        ctx.serializedMeshes[task.id] = std::move(task.pMesh);
+    }
+}
+
 void buildScene(BuilderContext& ctx, const XMLObject& inst)
 {
     FALCOR_ASSERT(inst.cls == Class::Scene);
 
     const auto& props = inst.props;
 
+    loadSerializedShapes(ctx, inst);
+
     for (const auto& [name, id] : props.getNamedReferences())
     {
         const auto& child = ctx.instances[id];
@@ -434,6 +434,33 @@ void BasicSceneBuilder::onObjectInstance(const std::string& name, FileLoc loc)
     mInstances.push_back(std::move(instance));
 }
 
+void BasicSceneBuilder::onImport(ImportedFile importedFile, FileLoc loc)
+{
+    VERIFY_WORLD("Import");
+
+    if (mpActiveInstanceDefinition)
+    {
+        throwError(loc, "Import can't be called inside instance definition");
+    }
+
+    // The imported file starts with the current graphics state, and changes to it don't affect the importing file.
+    GraphicsState graphicsState = mGraphicsState;
+    std::map<std::string, TransformSet> namedCoordinateSystems = mNamedCoordinateSystems;
+    const size_t stackSize = mStack.size();
+
+    // Apply the file at the point of the import, so that it only sees what was defined before it.
+    // This waits for the file to be parsed and rethrows any parsing errors.
+    importedFile.get()->replay(*this);
+
+    if (mStack.size() != stackSize || mpActiveInstanceDefinition)
+    {
+        throwError(loc, "Missing end to AttributeBegin or ObjectBegin in imported file.");
+    }
+
+    mGraphicsState = std::move(graphicsState);
+    mNamedCoordinateSystems = std::move(namedCoordinateSystems);
+}
+
 void BasicSceneBuilder::onEndOfFiles()
 {
     if (mCurrentBlock != BlockState::WorldBlock)
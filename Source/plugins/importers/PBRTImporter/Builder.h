@@ -356,6 +356,7 @@ public:
     void onObjectBegin(const std::string& name, FileLoc loc) override;
     void onObjectEnd(FileLoc loc) override;
     void onObjectInstance(const std::string& name, FileLoc loc) override;
+    void onImport(ImportedFile importedFile, FileLoc loc) override;
 
     void onEndOfFiles() override;
 
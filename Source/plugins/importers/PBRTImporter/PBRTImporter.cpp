@@ -34,12 +34,12 @@
 #include "Parser.h"
 #include "Builder.h"
 #include "Helpers.h"
-#include "LoopSubdivide.h"
 #include "EnvMapConverter.h"
 #include "Core/Error.h"
 #include "Core/API/Device.h"
 #include "Utils/Settings/Settings.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/FNVHash.h"
@@ -54,10 +54,16 @@
 #include "Scene/Material/PBRT/PBRTCoatedConductorMaterial.h"
 #include "Scene/Material/PBRT/PBRTDielectricMaterial.h"
 #include "Scene/Material/PBRT/PBRTDiffuseTransmissionMaterial.h"
+#include "Scene/Curves/CurveLOD.h"
 #include "Scene/Curves/CurveTessellation.h"
+#include "Scene/LoopSubdivide.h"
 
 #include <pybind11/pybind11.h>
 
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <map>
 #include <unordered_map>
 
 namespace Falcor
@@ -150,6 +156,22 @@ struct Shape
     Falcor::ref<Falcor::Material> pMaterial;
 };
 
+/**
+ * Holds the geometry of a shape loaded ahead of creating the shape.
+ * Errors are stored so that they can be reported in the original order of the shapes.
+ */
+struct LoadedShape
+{
+    Shape shape;
+    size_t geometryIndex = 0; ///< Index of the geometry within the loaded shapes. Shapes with shared geometry have the same index.
+    std::exception_ptr pException;
+};
+
+/**
+ * Maps shape geometry and material to the mesh added to the scene builder.
+ */
+using MeshIDMap = std::map<std::pair<size_t, Falcor::ref<Falcor::Material>>, MeshID>;
+
 /**
  * Holds a list of aggregated curve shapes (strands).
  * PBRT's curve shape only contains a single strand.
@@ -1387,7 +1409,12 @@ void createAreaLight(BuilderContext& ctx, const SceneEntity& entity, const Falco
     }
 }
 
-Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
+/**
+ * Create the geometry of a shape.
+ * This does not modify the builder context and is safe to call concurrently for different shapes.
+ * Curves are aggregated in createShape() and have no geometry at this point.
+ */
+Shape createShapeGeometry(const BuilderContext& ctx, const ShapeSceneEntity& entity)
 {
     auto warnUnsupported = [&]() { warnUnsupportedType(entity.loc, "Shape", entity.name); };
 
@@ -1438,52 +1465,7 @@ Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
     }
     else if (type == "curve")
     {
-        // Parameters:
-        // Float width, Float width0, Float width1, Int degree, String basis,
-        // Point3[] P, String type, Normal3[] N, Int splitdepth
-        warnUnsupportedParameters(params, {"degree", "N"});
-
-        auto splitdepth = params.getInt("splitdepth", 1);
-
-        auto width = params.getFloat("width", 1.f);
-        auto width0 = params.getFloat("width0", width);
-        auto width1 = params.getFloat("width1", width);
-
-        auto basis = params.getString("basis", "bezier");
-        if (basis != "bspline")
-            logWarning(entity.loc, "Basis '{}' is not supported. Using 'bspline' basis instead.", basis);
-
-        auto curveType = params.getString("type", "flat");
-        if (curveType != "cylinder")
-            logWarning(entity.loc, "Curve type '{}' is not supported. Using 'cylinder' type instead.", curveType);
-
-        auto P = params.getPoint3Array("P");
-
-        // Create or get existing curve aggregate.
-        auto pMaterial = ctx.getMaterial(entity.materialRef);
-        CurveAggregate::Key key{entity.transform, pMaterial.get()};
-        auto it = ctx.curveAggregates.find(key);
-        if (it == ctx.curveAggregates.end())
-        {
-            it = ctx.curveAggregates.emplace(key, CurveAggregate{}).first;
-            it->second.transform = entity.transform;
-            it->second.pMaterial = pMaterial;
-            it->second.splitDepth = splitdepth;
-        }
-        CurveAggregate& aggregate = it->second;
-
-        // Append curve to aggregate.
-        size_t pointCount = P.size();
-        size_t offset = aggregate.points.size();
-        aggregate.strands.push_back(pointCount);
-        aggregate.points.resize(aggregate.points.size() + pointCount);
-        aggregate.widths.resize(aggregate.widths.size() + pointCount);
-        for (size_t i = 0; i < pointCount; ++i)
-        {
-            float t = float(i) / pointCount;
-            aggregate.points[offset + i] = P[i];
-            aggregate.widths[offset + i] = math::lerp(width0, width1, t);
-        }
+        // Curves are appended to a curve aggregate in createShape().
     }
     else if (type == "trianglemesh")
     {
@@ -1611,6 +1593,144 @@ Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
     if (entity.reverseOrientation && shape.pTriangleMesh)
         shape.pTriangleMesh->setFrontFaceCW(!shape.pTriangleMesh->getFrontFaceCW());
 
+    return shape;
+}
+
+/**
+ * Load the geometry of a list of shapes.
+ * Shapes are independent until they are added to the scene builder, so their geometry is created in parallel.
+ * Shapes referencing the same PLY file with the same orientation share a single triangle mesh, which is only loaded once.
+ */
+std::vector<LoadedShape> loadShapes(const BuilderContext& ctx, const std::vector<ShapeSceneEntity>& entities)
+{
+    // Assign a load task to each shape.
+    std::vector<size_t> taskIndices(entities.size());
+    std::vector<size_t> taskEntityIndices;
+    std::map<std::pair<std::filesystem::path, bool>, size_t> plyTaskIndices;
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        const auto& entity = entities[i];
+        if (entity.name == "plymesh")
+        {
+            auto key = std::make_pair(ctx.resolver(entity.params.getString("filename", "")), entity.reverseOrientation);
+            auto [it, inserted] = plyTaskIndices.try_emplace(key, taskEntityIndices.size());
+            if (inserted)
+                taskEntityIndices.push_back(i);
+            taskIndices[i] = it->second;
+        }
+        else
+        {
+            taskIndices[i] = taskEntityIndices.size();
+            taskEntityIndices.push_back(i);
+        }
+    }
+
+    std::vector<LoadedShape> tasks(taskEntityIndices.size());
+    auto range = NumericRange<size_t>(0, tasks.size());
+    std::for_each(
+        std::execution::par,
+        range.begin(),
+        range.end(),
+        [&](size_t taskIndex)
+        {
+            try
+            {
+                tasks[taskIndex].shape = createShapeGeometry(ctx, entities[taskEntityIndices[taskIndex]]);
+            }
+            catch (...)
+            {
+                tasks[taskIndex].pException = std::current_exception();
+            }
+        }
+    );
+
+    std::vector<LoadedShape> loadedShapes(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        loadedShapes[i] = tasks[taskIndices[i]];
+        loadedShapes[i].geometryIndex = taskIndices[i];
+        // Shared PLY meshes are placed with the transform of each referencing shape.
+        if (entities[i].name == "plymesh")
+        {
+            loadedShapes[i].shape.transform = entities[i].transform;
+            // The parameters of shapes reusing the mesh of an earlier shape are not checked by createShapeGeometry().
+            if (taskEntityIndices[taskIndices[i]] != i)
+                warnUnsupportedParameters(entities[i].params, {"alpha", "displacement", "displacement.edgelength"});
+        }
+    }
+    return loadedShapes;
+}
+
+/**
+ * Append a curve shape to the curve aggregate with the same transform and material.
+ */
+void appendCurve(BuilderContext& ctx, const ShapeSceneEntity& entity)
+{
+    const auto& params = entity.params;
+
+    // Parameters:
+    // Float width, Float width0, Float width1, Int degree, String basis,
+    // Point3[] P, String type, Normal3[] N, Int splitdepth
+    warnUnsupportedParameters(params, {"degree", "N"});
+
+    auto splitdepth = params.getInt("splitdepth", 1);
+
+    auto width = params.getFloat("width", 1.f);
+    auto width0 = params.getFloat("width0", width);
+    auto width1 = params.getFloat("width1", width);
+
+    auto basis = params.getString("basis", "bezier");
+    if (basis != "bspline")
+        logWarning(entity.loc, "Basis '{}' is not supported. Using 'bspline' basis instead.", basis);
+
+    auto curveType = params.getString("type", "flat");
+    if (curveType != "cylinder")
+        logWarning(entity.loc, "Curve type '{}' is not supported. Using 'cylinder' type instead.", curveType);
+
+    auto P = params.getPoint3Array("P");
+
+    // Create or get existing curve aggregate.
+    auto pMaterial = ctx.getMaterial(entity.materialRef);
+    CurveAggregate::Key key{entity.transform, pMaterial.get()};
+    auto it = ctx.curveAggregates.find(key);
+    if (it == ctx.curveAggregates.end())
+    {
+        it = ctx.curveAggregates.emplace(key, CurveAggregate{}).first;
+        it->second.transform = entity.transform;
+        it->second.pMaterial = pMaterial;
+        it->second.splitDepth = splitdepth;
+    }
+    CurveAggregate& aggregate = it->second;
+
+    // Append curve to aggregate.
+    size_t pointCount = P.size();
+    size_t offset = aggregate.points.size();
+    aggregate.strands.push_back(pointCount);
+    aggregate.points.resize(aggregate.points.size() + pointCount);
+    aggregate.widths.resize(aggregate.widths.size() + pointCount);
+    for (size_t i = 0; i < pointCount; ++i)
+    {
+        float t = float(i) / pointCount;
+        aggregate.points[offset + i] = P[i];
+        aggregate.widths[offset + i] = math::lerp(width0, width1, t);
+    }
+}
+
+/**
+ * Create a shape from its loaded geometry.
+ * This creates the material and area light of the shape, and must be called in the original order of the shapes.
+ */
+Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity, const LoadedShape& loadedShape)
+{
+    if (loadedShape.pException)
+        std::rethrow_exception(loadedShape.pException);
+
+    Shape shape = loadedShape.shape;
+    if (entity.name == "curve")
+        appendCurve(ctx, entity);
+    else if (!shape.pTriangleMesh)
+        return {};
+
     // Get the material.
     shape.pMaterial = ctx.getMaterial(entity.materialRef);
 
@@ -1639,11 +1759,25 @@ Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
     return shape;
 }
 
+/**
+ * Add the triangle mesh of a shape to the scene builder.
+ * Shapes sharing the same geometry and material are instances of a single mesh.
+ */
+MeshID addTriangleMesh(BuilderContext& ctx, MeshIDMap& meshIDs, const LoadedShape& loadedShape, const Shape& shape)
+{
+    auto key = std::make_pair(loadedShape.geometryIndex, shape.pMaterial);
+    auto it = meshIDs.find(key);
+    if (it == meshIDs.end())
+        it = meshIDs.emplace(key, ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial)).first;
+    return it->second;
+}
+
 /**
  * Create curve geometry from a curve aggregate.
  * This can either result in mesh or curve geometry depending on the tesselation mode.
+ * Curve geometry has one curve per LOD level if curve LODs are generated.
  */
-std::variant<Falcor::MeshID, Falcor::CurveID> createCurveGeometry(BuilderContext& ctx, const CurveAggregate& curveAggregate)
+std::variant<Falcor::MeshID, std::vector<Falcor::CurveID>> createCurveGeometry(BuilderContext& ctx, const CurveAggregate& curveAggregate)
 {
     CurveTessellationMode mode = CurveTessellationMode::LinearSweptSphere;
 
@@ -1656,30 +1790,59 @@ std::variant<Falcor::MeshID, Falcor::CurveID> createCurveGeometry(BuilderContext
 
     if (mode == CurveTessellationMode::LinearSweptSphere)
     {
-        auto result = CurveTessellation::convertToLinearSweptSphere(
+        auto addCurve = [&](const std::vector<uint32_t>& strands, const std::vector<float3>& points, const std::vector<float>& widths)
+        {
+            auto result = CurveTessellation::convertToLinearSweptSphere(
+                strands.size(),
+                strands.data(),
+                points.data(),
+                widths.data(),
+                nullptr,
+                1,
+                subdivPerSegment,
+                1,
+                1,
+                1.f,
+                float4x4::identity()
+            );
+
+            Falcor::SceneBuilder::Curve curve;
+            curve.degree = result.degree;
+            curve.vertexCount = result.points.size();
+            curve.indexCount = result.indices.size();
+            curve.pIndices = result.indices.data();
+            curve.pMaterial = curveAggregate.pMaterial;
+            curve.positions.pData = result.points.data();
+            curve.radius.pData = result.radius.data();
+
+            return ctx.builder.addCurve(curve);
+        };
+
+        if (!is_set(ctx.builder.getFlags(), SceneBuilder::Flags::GenerateCurveLODs))
+        {
+            return std::vector<Falcor::CurveID>{addCurve(curveAggregate.strands, curveAggregate.points, curveAggregate.widths)};
+        }
+
+        auto levels = CurveLODBuilder::build(
             curveAggregate.strands.size(),
             curveAggregate.strands.data(),
             curveAggregate.points.data(),
             curveAggregate.widths.data(),
             nullptr,
-            1,
-            subdivPerSegment,
-            1,
-            1,
-            1.f,
-            float4x4::identity()
+            CurveLODBuilder::Options()
         );
 
-        Falcor::SceneBuilder::Curve curve;
-        curve.degree = result.degree;
-        curve.vertexCount = result.points.size();
-        curve.indexCount = result.indices.size();
-        curve.pIndices = result.indices.data();
-        curve.pMaterial = curveAggregate.pMaterial;
-        curve.positions.pData = result.points.data();
-        curve.radius.pData = result.radius.data();
+        std::vector<Falcor::CurveID> curveIDs;
+        std::vector<float> errors;
+        for (const auto& level : levels)
+        {
+            curveIDs.push_back(addCurve(level.vertexCountsPerStrand, level.controlPoints, level.widths));
+            errors.push_back(level.error);
+        }
+        if (curveIDs.size() > 1)
+            ctx.builder.addCurveLOD(curveIDs, errors);
 
-        return ctx.builder.addCurve(curve);
+        return curveIDs;
     }
     else
     {
@@ -1730,13 +1893,15 @@ InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceD
 {
     InstanceDefinition instanceDefinition;
 
-    for (const auto& shapeEntity : entity.shapes)
+    auto loadedShapes = loadShapes(ctx, entity.shapes);
+    MeshIDMap meshIDs;
+    for (size_t i = 0; i < entity.shapes.size(); ++i)
     {
         // Process shapes and create meshes.
-        auto shape = createShape(ctx, shapeEntity);
+        auto shape = createShape(ctx, entity.shapes[i], loadedShapes[i]);
         if (shape.pTriangleMesh)
         {
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
+            auto meshID = addTriangleMesh(ctx, meshIDs, loadedShapes[i], shape);
             instanceDefinition.meshes.emplace_back(meshID, shape.transform);
         }
 
@@ -1748,9 +1913,10 @@ InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceD
             {
                 instanceDefinition.meshes.emplace_back(*meshID, curveAggregate.transform);
             }
-            else if (auto curveID = std::get_if<Falcor::CurveID>(&meshOrCurveID))
+            else if (auto curveIDs = std::get_if<std::vector<Falcor::CurveID>>(&meshOrCurveID))
             {
-                instanceDefinition.curves.emplace_back(*curveID, curveAggregate.transform);
+                for (auto curveID : *curveIDs)
+                    instanceDefinition.curves.emplace_back(curveID, curveAggregate.transform);
             }
             else
             {
@@ -1815,15 +1981,22 @@ void buildScene(BuilderContext& ctx)
     }
 
     // Process shapes and create meshes.
-    for (const auto& entity : ctx.scene.getShapes())
-    {
-        auto shape = createShape(ctx, entity);
+    // The shape geometry is loaded in parallel, and the shapes are then added in their original order to get deterministic mesh IDs.
+    const auto& shapeEntities = ctx.scene.getShapes();
+    auto loadedShapes = loadShapes(ctx, shapeEntities);
+    MeshIDMap meshIDs;
+    for (size_t i = 0; i < shapeEntities.size(); ++i)
+    {
+        const auto& entity = shapeEntities[i];
+        auto shape = createShape(ctx, entity, loadedShapes[i]);
         if (shape.pTriangleMesh)
         {
             auto nodeID = ctx.builder.addNode({entity.name, shape.transform});
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
+            auto meshID = addTriangleMesh(ctx, meshIDs, loadedShapes[i], shape);
             ctx.builder.addMeshInstance(nodeID, meshID);
         }
+        // Release the geometry once it has been added to the scene builder.
+        loadedShapes[i].shape = {};
     }
 
     // Create curves from curve aggregates assembled during the processing step above.
@@ -1835,9 +2008,10 @@ void buildScene(BuilderContext& ctx)
         {
             ctx.builder.addMeshInstance(nodeID, *meshID);
         }
-        else if (auto curveID = std::get_if<Falcor::CurveID>(&meshOrCurveID))
+        else if (auto curveIDs = std::get_if<std::vector<Falcor::CurveID>>(&meshOrCurveID))
         {
-            ctx.builder.addCurveInstance(nodeID, *curveID);
+            for (auto curveID : *curveIDs)
+                ctx.builder.addCurveInstance(nodeID, curveID);
         }
         else
         {
@@ -10,10 +10,14 @@
 #include "Utils/Logger.h"
 
 #include <fast_float/fast_float.h>
+#include <BS_thread_pool/BS_thread_pool.hpp>
 
+#include <array>
 #include <atomic>
 #include <utility>
 #include <charconv>
+#include <cstring>
+#include <type_traits>
 
 namespace Falcor::pbrt
 {
@@ -65,11 +69,15 @@ std::unique_ptr<Tokenizer> Tokenizer::createFromFile(const std::filesystem::path
         std::string str = decompressFile(path);
         return std::make_unique<Tokenizer>(std::move(str), path);
     }
-    else
-    {
-        std::string str = readFile(path);
-        return std::make_unique<Tokenizer>(std::move(str), path);
-    }
+
+    // Map the file instead of reading it into memory, as scene files can be several gigabytes.
+    auto pMappedFile = std::make_unique<MemoryMappedFile>(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+    if (pMappedFile->isOpen())
+        return std::make_unique<Tokenizer>(std::move(pMappedFile), path);
+
+    // Fall back to reading the file (e.g. empty files cannot be mapped).
+    std::string str = readFile(path);
+    return std::make_unique<Tokenizer>(std::move(str), path);
 }
 
 std::unique_ptr<Tokenizer> Tokenizer::createFromString(std::string str)
@@ -79,13 +87,27 @@ std::unique_ptr<Tokenizer> Tokenizer::createFromString(std::string str)
 
 Tokenizer::Tokenizer(std::string str, const std::filesystem::path& path) : mPath(path), mContents(std::move(str))
 {
-    auto pFilename = std::make_unique<std::string>(path.string());
+    initialize(mContents.data(), mContents.size());
+}
+
+Tokenizer::Tokenizer(std::unique_ptr<MemoryMappedFile> pMappedFile, const std::filesystem::path& path)
+    : mPath(path), mpMappedFile(std::move(pMappedFile))
+{
+    initialize(static_cast<const char*>(mpMappedFile->getData()), mpMappedFile->getSize());
+}
+
+void Tokenizer::initialize(const char* pData, size_t size)
+{
+    auto pFilename = std::make_unique<std::string>(mPath.string());
     mLoc = FileLoc(*pFilename);
-    getFilenames().push_back(std::move(pFilename));
+    {
+        std::lock_guard<std::mutex> lock(getFilenamesMutex());
+        getFilenames().push_back(std::move(pFilename));
+    }
 
-    mPos = mContents.data();
-    mEnd = mPos + mContents.size();
-    if (isUTF16(mContents.data(), mContents.size()))
+    mPos = pData;
+    mEnd = pData + size;
+    if (isUTF16(pData, size))
         throwError("File is encoded with UTF-16, which is not currently supported.");
 }
 
@@ -194,6 +216,58 @@ std::optional<Token> Tokenizer::next()
     }
 }
 
+template<typename T>
+bool Tokenizer::parseNumbers(std::vector<T>& values)
+{
+    auto isSpace = [](char ch) { return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r'; };
+    auto isDelimiter = [&](char ch) { return isSpace(ch) || ch == '"' || ch == '[' || ch == ']'; };
+
+    // Reserve space for the values up to the closing bracket.
+    if (const char* pClose = static_cast<const char*>(std::memchr(mPos, ']', mEnd - mPos)))
+    {
+        size_t count = 0;
+        for (const char* p = mPos; p < pClose; ++p)
+            count += !isSpace(p[0]) && (p == mPos || isSpace(p[-1]));
+        values.reserve(values.size() + count);
+    }
+
+    const size_t startSize = values.size();
+    while (true)
+    {
+        while (mPos != mEnd && isSpace(*mPos))
+            getChar();
+        if (mPos == mEnd)
+            break;
+
+        // Skip '+' character, std::from_chars (and fast_float::from_chars) doesn't handle '+'.
+        const char* begin = *mPos == '+' ? mPos + 1 : mPos;
+        T value;
+        const char* end = nullptr;
+        std::errc ec;
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            auto result = fast_float::from_chars(begin, mEnd, value);
+            end = result.ptr;
+            ec = result.ec;
+        }
+        else
+        {
+            auto result = std::from_chars(begin, mEnd, value);
+            end = result.ptr;
+            ec = result.ec;
+        }
+
+        // Anything but a complete number (e.g. out of range values) is left to the regular token parsing.
+        if (ec != std::errc() || (end != mEnd && !isDelimiter(*end)))
+            break;
+
+        values.push_back(value);
+        mLoc.column += uint32_t(end - mPos);
+        mPos = end;
+    }
+    return values.size() > startSize;
+}
+
 static int32_t parseInt(const Token& t)
 {
     auto begin = t.token.data();
@@ -251,8 +325,8 @@ static std::string_view dequoteString(const Token& t)
 constexpr uint32_t TokenOptional = 0;
 constexpr uint32_t TokenRequired = 1;
 
-template<typename Next, typename Unget>
-static ParsedParameterVector parseParameters(Next nextToken, Unget ungetToken)
+template<typename Next, typename Unget, typename ParseNumbers>
+static ParsedParameterVector parseParameters(Next nextToken, Unget ungetToken, ParseNumbers parseNumbers)
 {
     ParsedParameterVector parameterVector;
 
@@ -403,6 +477,12 @@ static ParsedParameterVector parseParameters(Next nextToken, Unget ungetToken)
         {
             while (true)
             {
+                // Numeric values are parsed in bulk, falling back to tokens for anything else.
+                if (valType == Int)
+                    parseNumbers(param.ints);
+                else if ((valType == Unknown || valType == Float) && parseNumbers(param.floats))
+                    valType = Float;
+
                 val = *nextToken(TokenRequired);
                 if (val.token == "]")
                     break;
@@ -414,20 +494,37 @@ static ParsedParameterVector parseParameters(Next nextToken, Unget ungetToken)
             addVal(val);
         }
 
-        parameterVector.push_back(param);
+        parameterVector.push_back(std::move(param));
     }
 
     return parameterVector;
 }
 
-void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
+void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer, const std::filesystem::path& searchPath, BS::thread_pool& threadPool);
+
+/**
+ * Start parsing an imported file on the thread pool.
+ */
+ImportedFile importFile(const std::filesystem::path& path, const std::filesystem::path& searchPath, BS::thread_pool& threadPool)
+{
+    return threadPool
+        .submit(
+            [path, searchPath, &threadPool]()
+            {
+                auto pRecording = std::make_shared<RecordingTarget>();
+                parse(*pRecording, Tokenizer::createFromFile(path), searchPath, threadPool);
+                return pRecording;
+            }
+        )
+        .share();
+}
+
+void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer, const std::filesystem::path& searchPath, BS::thread_pool& threadPool)
 {
     static std::atomic<bool> warnedTransformBeginEndDeprecated{false};
 
     logInfo("PBRTImporter: Started parsing '{}'.", tokenizer->getPath().string());
 
-    auto searchPath = tokenizer->getPath().parent_path();
-
     std::vector<std::unique_ptr<Tokenizer>> fileStack;
     fileStack.push_back(std::move(tokenizer));
 
@@ -477,6 +574,13 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         ungetToken = t;
     };
 
+    auto parseNumbers = [&](auto& values)
+    {
+        if (ungetToken.has_value() || fileStack.empty())
+            return false;
+        return fileStack.back()->parseNumbers(values);
+    };
+
     /**
      * Helper function for pbrt API entrypoints that take a single string
      * parameter and a ParameterVector (e.g. onShape()).
@@ -486,7 +590,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
         Token t = *nextToken(TokenRequired);
         std::string_view dequoted = dequoteString(t);
         std::string n = toString(dequoted);
-        ParsedParameterVector parameterVector = parseParameters(nextToken, unget);
+        ParsedParameterVector parameterVector = parseParameters(nextToken, unget, parseNumbers);
         (target.*apiFunc)(n, std::move(parameterVector), loc);
     };
 
@@ -611,7 +715,11 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
             }
             else if (tok->token == "Import")
             {
-                throwError(tok->loc, "'Import' directive not supported yet.");
+                // Unlike included files, imported files don't change the graphics state of the importing file.
+                // They are parsed in parallel and the target applies the result at the point of the import.
+                Token filenameToken = *nextToken(TokenRequired);
+                std::string filename = toString(dequoteString(filenameToken));
+                target.onImport(importFile(searchPath / filename, searchPath, threadPool), tok->loc);
             }
             else if (tok->token == "Identity")
             {
@@ -822,7 +930,7 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
                 Token t = *nextToken(TokenRequired);
                 std::string_view dequoted = dequoteString(t);
                 std::string texName = toString(dequoted);
-                ParsedParameterVector params = parseParameters(nextToken, unget);
+                ParsedParameterVector params = parseParameters(nextToken, unget, parseNumbers);
                 target.onTexture(name, type, texName, std::move(params), tok->loc);
             }
             else
@@ -848,18 +956,247 @@ void parse(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer)
     }
 }
 
+/**
+ * Parse the top-level file and apply it to the target.
+ * The file is recorded first and replayed once it has been parsed, so that the target only waits for imported files
+ * when it reaches them, while they are parsed in parallel with the rest of the file.
+ */
+static void parseTopLevel(ParserTarget& target, std::unique_ptr<Tokenizer> tokenizer, const std::filesystem::path& searchPath)
+{
+    BS::thread_pool threadPool;
+    RecordingTarget recording;
+    parse(recording, std::move(tokenizer), searchPath, threadPool);
+    recording.replay(target);
+    target.onEndOfFiles();
+}
+
 void parseFile(ParserTarget& target, const std::filesystem::path& path)
 {
     auto tokenizer = Tokenizer::createFromFile(path);
-    parse(target, std::move(tokenizer));
-    target.onEndOfFiles();
+    parseTopLevel(target, std::move(tokenizer), path.parent_path());
 }
 
 void parseString(ParserTarget& target, std::string str)
 {
     auto tokenizer = Tokenizer::createFromString(std::move(str));
-    parse(target, std::move(tokenizer));
-    target.onEndOfFiles();
+    auto searchPath = tokenizer->getPath().parent_path();
+    parseTopLevel(target, std::move(tokenizer), searchPath);
+}
+
+void RecordingTarget::replay(ParserTarget& target)
+{
+    for (auto& command : mCommands)
+        command(target);
+    mCommands.clear();
+}
+
+void RecordingTarget::onScale(Float sx, Float sy, Float sz, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onScale(sx, sy, sz, loc); });
+}
+
+void RecordingTarget::onShape(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onShape(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onOption(const std::string& name, const std::string& value, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onOption(name, value, loc); });
+}
+
+void RecordingTarget::onIdentity(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onIdentity(loc); });
+}
+
+void RecordingTarget::onTranslate(Float dx, Float dy, Float dz, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onTranslate(dx, dy, dz, loc); });
+}
+
+void RecordingTarget::onRotate(Float angle, Float ax, Float ay, Float az, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onRotate(angle, ax, ay, az, loc); });
+}
+
+void RecordingTarget::onLookAt(Float ex, Float ey, Float ez, Float lx, Float ly, Float lz, Float ux, Float uy, Float uz, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onLookAt(ex, ey, ez, lx, ly, lz, ux, uy, uz, loc); });
+}
+
+void RecordingTarget::onConcatTransform(Float transform[16], FileLoc loc)
+{
+    std::array<Float, 16> m;
+    std::copy(transform, transform + 16, m.begin());
+    mCommands.push_back([=](ParserTarget& target) mutable { target.onConcatTransform(m.data(), loc); });
+}
+
+void RecordingTarget::onTransform(Float transform[16], FileLoc loc)
+{
+    std::array<Float, 16> m;
+    std::copy(transform, transform + 16, m.begin());
+    mCommands.push_back([=](ParserTarget& target) mutable { target.onTransform(m.data(), loc); });
+}
+
+void RecordingTarget::onCoordinateSystem(const std::string& name, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onCoordinateSystem(name, loc); });
+}
+
+void RecordingTarget::onCoordSysTransform(const std::string& name, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onCoordSysTransform(name, loc); });
+}
+
+void RecordingTarget::onActiveTransformAll(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onActiveTransformAll(loc); });
+}
+
+void RecordingTarget::onActiveTransformEndTime(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onActiveTransformEndTime(loc); });
+}
+
+void RecordingTarget::onActiveTransformStartTime(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onActiveTransformStartTime(loc); });
+}
+
+void RecordingTarget::onTransformTimes(Float start, Float end, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onTransformTimes(start, end, loc); });
+}
+
+void RecordingTarget::onColorSpace(const std::string& n, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onColorSpace(n, loc); });
+}
+
+void RecordingTarget::onPixelFilter(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onPixelFilter(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onFilm(const std::string& type, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onFilm(type, std::move(params), loc); });
+}
+
+void RecordingTarget::onAccelerator(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onAccelerator(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onIntegrator(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onIntegrator(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onCamera(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onCamera(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onMakeNamedMedium(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable
+                        { target.onMakeNamedMedium(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onMediumInterface(const std::string& insideName, const std::string& outsideName, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onMediumInterface(insideName, outsideName, loc); });
+}
+
+void RecordingTarget::onSampler(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onSampler(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onWorldBegin(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onWorldBegin(loc); });
+}
+
+void RecordingTarget::onAttributeBegin(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onAttributeBegin(loc); });
+}
+
+void RecordingTarget::onAttributeEnd(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onAttributeEnd(loc); });
+}
+
+void RecordingTarget::onAttribute(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onAttribute(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onTexture(
+    const std::string& name,
+    const std::string& type,
+    const std::string& texname,
+    ParsedParameterVector params,
+    FileLoc loc
+)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable
+                        { target.onTexture(name, type, texname, std::move(params), loc); });
+}
+
+void RecordingTarget::onMaterial(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onMaterial(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onMakeNamedMaterial(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable
+                        { target.onMakeNamedMaterial(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onNamedMaterial(const std::string& name, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onNamedMaterial(name, loc); });
+}
+
+void RecordingTarget::onLightSource(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable { target.onLightSource(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onAreaLightSource(const std::string& name, ParsedParameterVector params, FileLoc loc)
+{
+    mCommands.push_back([=, params = std::move(params)](ParserTarget& target) mutable
+                        { target.onAreaLightSource(name, std::move(params), loc); });
+}
+
+void RecordingTarget::onReverseOrientation(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onReverseOrientation(loc); });
+}
+
+void RecordingTarget::onObjectBegin(const std::string& name, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onObjectBegin(name, loc); });
+}
+
+void RecordingTarget::onObjectEnd(FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onObjectEnd(loc); });
+}
+
+void RecordingTarget::onObjectInstance(const std::string& name, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onObjectInstance(name, loc); });
+}
+
+void RecordingTarget::onImport(ImportedFile importedFile, FileLoc loc)
+{
+    mCommands.push_back([=](ParserTarget& target) { target.onImport(importedFile, loc); });
 }
 
 } // namespace Falcor::pbrt
@@ -7,15 +7,27 @@
 
 #include "Types.h"
 #include "Parameters.h"
+#include "Core/Platform/MemoryMappedFile.h"
 #include <functional>
 #include <filesystem>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace Falcor::pbrt
 {
 
+class RecordingTarget;
+
+/**
+ * An imported file that is parsed in the background.
+ * The parser callbacks of the file are recorded and can be replayed once parsing has finished.
+ */
+using ImportedFile = std::shared_future<std::shared_ptr<RecordingTarget>>;
+
 class ParserTarget
 {
 public:
@@ -69,10 +81,70 @@ public:
     virtual void onObjectBegin(const std::string& name, FileLoc loc) = 0;
     virtual void onObjectEnd(FileLoc loc) = 0;
     virtual void onObjectInstance(const std::string& name, FileLoc loc) = 0;
+    virtual void onImport(ImportedFile importedFile, FileLoc loc) = 0;
 
     virtual void onEndOfFiles() = 0;
 };
 
+/**
+ * Parser target recording all callbacks.
+ * This is used to parse imported files on a worker thread and apply them to the actual target later.
+ */
+class RecordingTarget : public ParserTarget
+{
+public:
+    /**
+     * Replay the recorded callbacks in order.
+     * The recorded parameters are moved to the target, so this can only be called once.
+     */
+    void replay(ParserTarget& target);
+
+    void onScale(Float sx, Float sy, Float sz, FileLoc loc) override;
+    void onShape(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onOption(const std::string& name, const std::string& value, FileLoc loc) override;
+    void onIdentity(FileLoc loc) override;
+    void onTranslate(Float dx, Float dy, Float dz, FileLoc loc) override;
+    void onRotate(Float angle, Float ax, Float ay, Float az, FileLoc loc) override;
+    void onLookAt(Float ex, Float ey, Float ez, Float lx, Float ly, Float lz, Float ux, Float uy, Float uz, FileLoc loc) override;
+    void onConcatTransform(Float transform[16], FileLoc loc) override;
+    void onTransform(Float transform[16], FileLoc loc) override;
+    void onCoordinateSystem(const std::string& name, FileLoc loc) override;
+    void onCoordSysTransform(const std::string& name, FileLoc loc) override;
+    void onActiveTransformAll(FileLoc loc) override;
+    void onActiveTransformEndTime(FileLoc loc) override;
+    void onActiveTransformStartTime(FileLoc loc) override;
+    void onTransformTimes(Float start, Float end, FileLoc loc) override;
+    void onColorSpace(const std::string& n, FileLoc loc) override;
+    void onPixelFilter(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onFilm(const std::string& type, ParsedParameterVector params, FileLoc loc) override;
+    void onAccelerator(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onIntegrator(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onCamera(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onMakeNamedMedium(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onMediumInterface(const std::string& insideName, const std::string& outsideName, FileLoc loc) override;
+    void onSampler(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onWorldBegin(FileLoc loc) override;
+    void onAttributeBegin(FileLoc loc) override;
+    void onAttributeEnd(FileLoc loc) override;
+    void onAttribute(const std::string& target, ParsedParameterVector params, FileLoc loc) override;
+    void onTexture(const std::string& name, const std::string& type, const std::string& texname, ParsedParameterVector params, FileLoc loc)
+        override;
+    void onMaterial(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onMakeNamedMaterial(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onNamedMaterial(const std::string& name, FileLoc loc) override;
+    void onLightSource(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onAreaLightSource(const std::string& name, ParsedParameterVector params, FileLoc loc) override;
+    void onReverseOrientation(FileLoc loc) override;
+    void onObjectBegin(const std::string& name, FileLoc loc) override;
+    void onObjectEnd(FileLoc loc) override;
+    void onObjectInstance(const std::string& name, FileLoc loc) override;
+    void onImport(ImportedFile importedFile, FileLoc loc) override;
+    void onEndOfFiles() override {}
+
+private:
+    std::vector<std::function<void(ParserTarget&)>> mCommands;
+};
+
 void parseFile(ParserTarget& target, const std::filesystem::path& path);
 void parseString(ParserTarget& target, std::string str);
 
@@ -89,6 +161,7 @@ class Tokenizer
 {
 public:
     Tokenizer(std::string str, const std::filesystem::path& path);
+    Tokenizer(std::unique_ptr<MemoryMappedFile> pMappedFile, const std::filesystem::path& path);
 
     static std::unique_ptr<Tokenizer> createFromFile(const std::filesystem::path& path);
     static std::unique_ptr<Tokenizer> createFromString(std::string str);
@@ -99,12 +172,25 @@ public:
      */
     std::optional<Token> next();
 
+    /**
+     * Parse a sequence of numbers directly from the file contents.
+     * This is a fast path for large numeric arrays that avoids creating a token for each value.
+     * Parsing stops before the first token that is not a number, which is left for next().
+     * @param[out] values Parsed values are appended to this vector.
+     * @return True if at least one value was parsed.
+     */
+    template<typename T>
+    bool parseNumbers(std::vector<T>& values);
+
     const std::filesystem::path& getPath() const { return mPath; }
 
 private:
+    void initialize(const char* pData, size_t size);
+
     /**
      * Static list of filenames to allow file locations (FileLoc::filename) to be valid
-     * even after the tokenizer is destroyed.
+     * even after the tokenizer is destroyed. Imported files are tokenized on worker threads,
+     * so the list is guarded by a mutex.
      */
     static std::vector<std::unique_ptr<std::string>>& getFilenames()
     {
@@ -112,6 +198,12 @@ private:
         return filenames;
     }
 
+    static std::mutex& getFilenamesMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
     bool isUTF16(const void* ptr, size_t len) const;
 
     int getChar()
@@ -144,7 +236,8 @@ private:
 
     std::filesystem::path mPath; ///< File path we're reading from.
     FileLoc mLoc;                ///< File location.
-    std::string mContents;       ///< File contents we're parsing.
+    std::string mContents;       ///< File contents we're parsing, if not memory-mapped.
+    std::unique_ptr<MemoryMappedFile> mpMappedFile; ///< Memory-mapped file we're parsing.
 
     const char* mPos; ///< Current position in the file.
     const char* mEnd; ///< End of the file (one past).
@@ -0,0 +1,45 @@
+import sys
+import os
+import unittest
+import falcor
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.relpath(__file__))))
+from helpers import for_each_device_type
+
+# Scene script adding a grid mesh from numpy arrays. The grid spans [-1,1] in x and z.
+GRID_SCENE = """
+import numpy as np
+from falcor import *
+
+size = {size}
+u, v = np.meshgrid(np.linspace(0, 1, size + 1, dtype=np.float32), np.linspace(0, 1, size + 1, dtype=np.float32))
+positions = np.stack([u * 2 - 1, np.zeros_like(u), v * 2 - 1], axis=-1).reshape(-1, 3)
+normals = np.tile(np.array([0, 1, 0], dtype=np.float32), (positions.shape[0], 1))
+texCoords = np.stack([u, v], axis=-1).reshape(-1, 2)
+
+i0 = (np.arange(size, dtype=np.uint32)[None, :] + np.arange(size, dtype=np.uint32)[:, None] * (size + 1)).reshape(-1)
+indices = np.stack([i0, i0 + size + 1, i0 + 1, i0 + 1, i0 + size + 1, i0 + size + 2], axis=-1)
+
+meshID = sceneBuilder.addMesh(positions, indices, StandardMaterial("Grid"), normals=normals, texCoords=texCoords, name="Grid")
+
+sceneBuilder.addMeshInstance(sceneBuilder.addNode("Grid"), meshID)
+"""
+
+
+class TestSceneBuilder(unittest.TestCase):
+    def load_grid(self, device: falcor.Device, size: int):
+        testbed = falcor.Testbed(create_window=False, device=device)
+        testbed.load_scene_from_string(GRID_SCENE.format(size=size))
+        return testbed.scene
+
+    @for_each_device_type
+    def test_add_mesh_from_numpy(self, device: falcor.Device):
+        scene = self.load_grid(device, 64)
+        self.assertEqual(scene.get_mesh(0).triangle_count, 2 * 64 * 64)
+        self.assertEqual(scene.get_mesh(0).vertex_count, 65 * 65)
+        self.assertAlmostEqual(scene.bounds.min_point.x, -1.0)
+        self.assertAlmostEqual(scene.bounds.max_point.z, 1.0)
+
+
+if __name__ == "__main__":
+    unittest.main()